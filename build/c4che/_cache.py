@@ -0,0 +1,105 @@
+AR = ['/usr/bin/ar']
+ARFLAGS = ['rcs']
+BINDIR = '/usr/local/bin'
+CC = ['/usr/bin/gcc']
+CCLNK_SRC_F = []
+CCLNK_TGT_F = ['-o']
+CC_NAME = 'gcc'
+CC_SRC_F = []
+CC_TGT_F = ['-c', '-o']
+CC_VERSION = ('12', '2', '0')
+CFLAGS_MACBUNDLE = ['-fPIC']
+CFLAGS_cshlib = ['-fPIC']
+COMPILER_CC = 'gcc'
+COMPILER_CXX = 'g++'
+CPPFLAGS = ['-I/usr/lib/llvm-14/include', '-D_GNU_SOURCE', '-D__STDC_CONSTANT_MACROS', '-D__STDC_FORMAT_MACROS', '-D__STDC_LIMIT_MACROS']
+CPPPATH_ST = '-I%s'
+CXX = ['/usr/bin/g++']
+CXXFLAGS_MACBUNDLE = ['-fPIC']
+CXXFLAGS_cxxshlib = ['-fPIC']
+CXXLNK_SRC_F = []
+CXXLNK_TGT_F = ['-o']
+CXX_NAME = 'gcc'
+CXX_SRC_F = []
+CXX_TGT_F = ['-c', '-o']
+C_OPTS = ['-O2']
+DEFINES = []
+DEFINES_ST = '-D%s'
+DEFINE_COMMENTS = {'PYTHONDIR': '', 'PYTHONARCHDIR': '', 'HAVE_ALLOCA_H': '', 'HAVE_FCNTL_H': '', 'HAVE_PROCESS_H': '', 'HAVE_STDLIB_H': '', 'HAVE_STRING_H': '', 'HAVE_STRINGS_H': '', 'HAVE_SYS_FILE_H': '', 'HAVE_SYS_STAT_H': '', 'HAVE_SYS_TIME_H': '', 'HAVE_SYS_TYPES_H': '', 'HAVE_SYS_WAIT_H': '', 'HAVE_UNISTD_H': '', 'HAVE_VFORK_H': '', 'HAVE_GETRUSAGE': '', 'HAVE_WAITPID': '', 'HAVE_KILL': '', 'HAVE_COPY_FILE_RANGE': '', 'HAVE_SENDFILE': '', 'HAVE_POSIX_SPAWN': '', 'HAVE_PIPE2': '', 'HAVE_MADVISE': '', 'HAVE_MEMFD_CREATE': '', 'HAVE_MALLOC_USABLE_SIZE': '', 'HAVE_STRNLEN': '', 'HAVE_OPEN64': '', 'HAVE_STAT64': '', 'HAVE_MMAP': '', 'HAVE_ZLIB_H': '', 'HAVE_ZSTD_H': '', 'HAVE_SYS_UN_H': '', 'HAVE_NETDB_H': '', 'HAVE_SYS_RESOURCE_H': '', 'HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H': '', 'HAVE_STD_CXX14': ''}
+DEST_BINFMT = 'elf'
+DEST_CPU = 'x86_64'
+DEST_OS = 'linux'
+HAVE_ALLOCA_H = 1
+HAVE_COPY_FILE_RANGE = 1
+HAVE_FCNTL_H = 1
+HAVE_GETRUSAGE = 1
+HAVE_KILL = 1
+HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H = 1
+HAVE_MADVISE = 1
+HAVE_MALLOC_USABLE_SIZE = 1
+HAVE_MEMFD_CREATE = 1
+HAVE_MMAP = 1
+HAVE_NETDB_H = 1
+HAVE_PIPE2 = 1
+HAVE_POSIX_SPAWN = 1
+HAVE_SENDFILE = 1
+HAVE_STDLIB_H = 1
+HAVE_STD_CXX14 = 1
+HAVE_STRINGS_H = 1
+HAVE_STRING_H = 1
+HAVE_STRNLEN = 1
+HAVE_SYS_FILE_H = 1
+HAVE_SYS_RESOURCE_H = 1
+HAVE_SYS_STAT_H = 1
+HAVE_SYS_TIME_H = 1
+HAVE_SYS_TYPES_H = 1
+HAVE_SYS_UN_H = 1
+HAVE_SYS_WAIT_H = 1
+HAVE_UNISTD_H = 1
+HAVE_WAITPID = 1
+HAVE_ZLIB_H = 1
+LDFLAGS = ['-L/usr/lib/llvm-14/lib']
+LIBDIR = '/usr/local/lib64'
+LIBPATH_ST = '-L%s'
+LIB_LLVM = ['LLVM']
+LIB_PTHREAD = ['pthread', 'pthread', 'pthread']
+LIB_ST = '-l%s'
+LIB_Z = ['z', 'z']
+LINKFLAGS_MACBUNDLE = ['-bundle', '-undefined', 'dynamic_lookup']
+LINKFLAGS_cshlib = ['-shared']
+LINKFLAGS_cstlib = ['-Wl,-Bstatic']
+LINKFLAGS_cxxshlib = ['-shared']
+LINKFLAGS_cxxstlib = ['-Wl,-Bstatic']
+LINK_CC = ['/usr/bin/gcc']
+LINK_CXX = ['/usr/bin/g++']
+M4 = ['/usr/bin/m4']
+PKGCONFIG = ['/usr/bin/pkg-config']
+PREFIX = '/usr/local'
+PYC = 0
+PYFLAGS = ''
+PYFLAGS_OPT = '-O'
+PYO = 0
+PYTAG = 'cpython-311'
+PYTHON = ['/root/.pyenv/versions/3.11.7/bin/python']
+PYTHON2 = ['/root/.pyenv/shims/python2']
+PYTHON3 = ['/root/.pyenv/versions/3.11.7/bin/python3']
+PYTHONARCHDIR = '/usr/local/lib/python3.11/site-packages'
+PYTHONDIR = '/usr/local/lib/python3.11/site-packages'
+PYTHON_VERSION = '3.11'
+RPATH_ST = '-Wl,-rpath,%s'
+RTEMS_RELEASE = '6.81d9cade8f9e-modified'
+RTEMS_VERSION = 6
+SHLIB_MARKER = '-Wl,-Bdynamic'
+SONAME_ST = '-Wl,-h,%s'
+STLIBPATH_ST = '-L%s'
+STLIB_MARKER = '-Wl,-Bstatic'
+STLIB_ST = '-l%s'
+cfg_files = ['/root/repo/build/rtemstoolkit/libiberty/config.h', '/root/repo/build/rtemstoolkit/config.h', '/root/repo/build/linkers/config.h', '/root/repo/build/misc/config.h', '/root/repo/build/tester/covoar/covoar-config.h', '/root/repo/build/trace/config.h']
+cprogram_PATTERN = '%s'
+cshlib_PATTERN = 'lib%s.so'
+cstlib_PATTERN = 'lib%s.a'
+cxxprogram_PATTERN = '%s'
+cxxshlib_PATTERN = 'lib%s.so'
+cxxstlib_PATTERN = 'lib%s.a'
+define_key = []
+macbundle_PATTERN = '%s.bundle'
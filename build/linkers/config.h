@@ -0,0 +1,8 @@
+/* WARNING! All changes made to this file will be lost! */
+
+#ifndef W_CONFIG_H_WAF
+#define W_CONFIG_H_WAF
+
+
+
+#endif /* W_CONFIG_H_WAF */
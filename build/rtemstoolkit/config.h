@@ -0,0 +1,16 @@
+/* WARNING! All changes made to this file will be lost! */
+
+#ifndef W_CONFIG_H_WAF
+#define W_CONFIG_H_WAF
+
+#define HAVE_SYS_WAIT_H 1
+#define HAVE_KILL 1
+#define HAVE_COPY_FILE_RANGE 1
+#define HAVE_SENDFILE 1
+#define HAVE_POSIX_SPAWN 1
+#define HAVE_PIPE2 1
+#define HAVE_MADVISE 1
+#define HAVE_MEMFD_CREATE 1
+#define HAVE_MALLOC_USABLE_SIZE 1
+
+#endif /* W_CONFIG_H_WAF */
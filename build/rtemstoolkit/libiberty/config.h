@@ -0,0 +1,24 @@
+/* WARNING! All changes made to this file will be lost! */
+
+#ifndef W_LIBIBERTY_CONFIG_H_WAF
+#define W_LIBIBERTY_CONFIG_H_WAF
+
+#define PYTHONDIR "/usr/local/lib/python3.11/site-packages"
+#define PYTHONARCHDIR "/usr/local/lib/python3.11/site-packages"
+#define HAVE_ALLOCA_H 1
+#define HAVE_FCNTL_H 1
+/* #undef HAVE_PROCESS_H */
+#define HAVE_STDLIB_H 1
+#define HAVE_STRING_H 1
+#define HAVE_STRINGS_H 1
+#define HAVE_SYS_FILE_H 1
+#define HAVE_SYS_STAT_H 1
+#define HAVE_SYS_TIME_H 1
+#define HAVE_SYS_TYPES_H 1
+#define HAVE_SYS_WAIT_H 1
+#define HAVE_UNISTD_H 1
+/* #undef HAVE_VFORK_H */
+#define HAVE_GETRUSAGE 1
+#define HAVE_WAITPID 1
+
+#endif /* W_LIBIBERTY_CONFIG_H_WAF */
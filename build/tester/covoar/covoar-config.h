@@ -0,0 +1,15 @@
+/* WARNING! All changes made to this file will be lost! */
+
+#ifndef W_COVOAR_CONFIG_H_WAF
+#define W_COVOAR_CONFIG_H_WAF
+
+/* #undef HAVE_OPEN64 */
+/* #undef HAVE_STAT64 */
+#define HAVE_MMAP 1
+#define HAVE_ZLIB_H 1
+/* #undef HAVE_ZSTD_H */
+#define HAVE_SYS_UN_H 1
+#define HAVE_NETDB_H 1
+#define HAVE_SYS_RESOURCE_H 1
+
+#endif /* W_COVOAR_CONFIG_H_WAF */
@@ -0,0 +1,10 @@
+/* WARNING! All changes made to this file will be lost! */
+
+#ifndef W_CONFIG_H_WAF
+#define W_CONFIG_H_WAF
+
+#define HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H 1
+#define HAVE_ZLIB_H 1
+#define HAVE_STD_CXX14 1
+
+#endif /* W_CONFIG_H_WAF */
@@ -27,12 +27,19 @@
 #include "config.h"
 #endif
 
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
 
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <getopt.h>
@@ -58,13 +65,18 @@ static struct option rld_opts[] = {
   { "addresses",    no_argument,            NULL,           'a' },
   { "pretty-print", no_argument,            NULL,           'p' },
   { "basenames",    no_argument,            NULL,           's' },
+  { "inlines",      no_argument,            NULL,           'i' },
+  { "batch",        required_argument,      NULL,           'b' },
+  { "server",       no_argument,            NULL,           'S' },
+  { "cache-size",   required_argument,      NULL,           'C' },
+  { "debug-dir",    required_argument,      NULL,           'D' },
   { NULL,           0,                      NULL,            0 }
 };
 
 void
 usage (int exit_code)
 {
-  std::cout << "rtems-addr2line [options] addresses" << std::endl
+  std::cout << "rtems-addr2line [options] [addresses]" << std::endl
             << "Options and arguments:" << std::endl
             << " -h        : help (also --help)" << std::endl
             << " -V        : print version number and exit (also --version)" << std::endl
@@ -74,7 +86,18 @@ usage (int exit_code)
             << " -f        : show function names (also --functions)" << std::endl
             << " -a        : show addresses (also --addresses)" << std::endl
             << " -p        : human readable format (also --pretty-print)" << std::endl
-            << " -s        : Strip directory paths (also --basenames)" << std::endl;
+            << " -s        : Strip directory paths (also --basenames)" << std::endl
+            << " -i        : show the functions an inlined function is inlined into" << std::endl
+            << "             (also --inlines)" << std::endl
+            << " -b file   : read the addresses from the file, '-' is stdin, and" << std::endl
+            << "             resolve them as a batch (also --batch)" << std::endl
+            << " -S        : serve requests read from stdin, a request is a line with" << std::endl
+            << "             an executable and addresses, each response ends with an" << std::endl
+            << "             empty line (also --server)" << std::endl
+            << " -C size   : number of executables the server keeps loaded, the" << std::endl
+            << "             default is 4 (also --cache-size)" << std::endl
+            << " -D dir    : directory of separate debug files, can supply multiple" << std::endl
+            << "             times, the default is " RLD_DWARF_DEBUG_DIR " (also --debug-dir)" << std::endl;
   ::exit (exit_code);
 }
 
@@ -110,6 +133,375 @@ setup_signals (void)
 #endif
 }
 
+/**
+ * A list of addresses to resolve in the order they are output.
+ */
+typedef std::vector < rld::dwarf::dwarf_address > locations;
+
+/**
+ * The output of the addresses resolved. Fault logs repeat the same addresses
+ * so each address is resolved and its frames formatted once.
+ */
+typedef std::unordered_map < rld::dwarf::dwarf_address, std::string > frame_memo;
+
+static void
+output_location (std::ostream&             out,
+                 rld::dwarf::dwarf_address location,
+                 const std::string&        path,
+                 int                       line,
+                 const std::string&        function,
+                 bool                      show_functions,
+                 bool                      show_addresses,
+                 bool                      pretty_print,
+                 bool                      show_basenames)
+{
+  if (show_addresses)
+  {
+    out << std::hex << std::setfill ('0')
+        << "0x" << location
+        << std::dec << std::setfill (' ');
+
+    if (pretty_print)
+      out << ": ";
+    else
+      out << std::endl;
+  }
+
+  if (show_functions)
+    out << function << " at ";
+
+  if (show_basenames)
+    out << rld::path::basename (path);
+  else
+    out << path;
+
+  out << ':' << line << std::endl;
+}
+
+/**
+ * Output the location of an address. If inlined frames are shown the
+ * function is the innermost function at the address followed by the
+ * functions it is inlined into and the locations of the calls.
+ */
+static void
+output_frames (std::ostream&             out,
+               rld::dwarf::file&         debug,
+               rld::dwarf::dwarf_address location,
+               const std::string&        path,
+               int                       line,
+               const std::string&        function,
+               bool                      show_functions,
+               bool                      show_addresses,
+               bool                      pretty_print,
+               bool                      show_basenames,
+               bool                      show_inlines)
+{
+  if (!show_inlines)
+  {
+    output_location (out, location, path, line, function,
+                     show_functions, show_addresses,
+                     pretty_print, show_basenames);
+    return;
+  }
+
+  rld::dwarf::function_pointers frames;
+
+  debug.find_functions (location, frames);
+
+  output_location (out, location, path, line,
+                   frames.empty () ? function : frames.back ()->name (),
+                   show_functions, show_addresses,
+                   pretty_print, show_basenames);
+
+  for (size_t f = frames.size () - (frames.empty () ? 0 : 1); f > 0; --f)
+  {
+    const rld::dwarf::function& inlined = *frames[f];
+    const rld::dwarf::function& caller = *frames[f - 1];
+
+    if (inlined.call_line () == 0)
+      break;
+
+    if (pretty_print)
+      out << " (inlined by) ";
+
+    /*
+     * The call file is an index into the CU's files and may not have been
+     * resolved.
+     */
+    const std::string& call_file = inlined.call_file ();
+
+    output_location (out, location,
+                     call_file.empty () ? "??" : call_file,
+                     inlined.call_line (),
+                     caller.name (),
+                     show_functions, false,
+                     pretty_print, show_basenames);
+  }
+}
+
+static void
+read_addresses (std::istream& in, locations& locs)
+{
+  std::string token;
+
+  while (in >> token)
+  {
+    /*
+     * Use the C routine as C++ does not have a way to automatically handle
+     * different bases on the input.
+     */
+    locs.push_back (::strtoul (token.c_str (), 0, 0));
+  }
+}
+
+/**
+ * Resolve the addresses and append their output to the buffer in the order
+ * of the addresses. The addresses not in the memo are resolved as a batch
+ * and their output is added to the memo.
+ */
+static void
+symbolize (rld::dwarf::file& debug,
+           const locations&  locs,
+           frame_memo&       memo,
+           std::string&      buffer,
+           bool              show_functions,
+           bool              show_addresses,
+           bool              pretty_print,
+           bool              show_basenames,
+           bool              show_inlines)
+{
+  rld::dwarf::source_lookups lookups;
+
+  for (auto loc : locs)
+  {
+    if (memo.emplace (loc, std::string ()).second)
+      lookups.push_back (rld::dwarf::source_lookup (loc));
+  }
+
+  if (rld::verbose ())
+    std::cerr << "symbolize: " << locs.size () << " addresses, "
+              << lookups.size () << " resolved" << std::endl;
+
+  if (!lookups.empty ())
+  {
+    debug.get_sources (lookups);
+    if (show_functions)
+      debug.get_functions (lookups);
+
+    for (auto& l : lookups)
+    {
+      std::ostringstream oss;
+      output_frames (oss, debug,
+                     l.location, l.source_file, l.source_line,
+                     l.function,
+                     show_functions, show_addresses,
+                     pretty_print, show_basenames, show_inlines);
+      memo[l.location] = oss.str ();
+    }
+  }
+
+  for (auto loc : locs)
+    buffer += memo[loc];
+}
+
+/**
+ * An executable's debug info. A stripped executable's debug info is loaded
+ * from its separate debug file if it has one.
+ */
+struct debug_image
+{
+  rld::files::object                     exe;       ///< The executable.
+  std::unique_ptr < rld::files::object > debug_exe; ///< The separate debug
+                                                    ///  file.
+  rld::dwarf::file                       debug;     ///< The debug info.
+
+  debug_image (const std::string& name);
+  ~debug_image ();
+
+  /**
+   * Open the executable and load the debug info.
+   */
+  void begin (const rld::path::paths& debug_dirs);
+
+  /**
+   * Release the debug info and close the files.
+   */
+  void end ();
+};
+
+debug_image::debug_image (const std::string& name)
+  : exe (name)
+{
+}
+
+debug_image::~debug_image ()
+{
+  end ();
+}
+
+void
+debug_image::begin (const rld::path::paths& debug_dirs)
+{
+  exe.open ();
+  exe.begin ();
+
+  rld::elf::file* elf = &exe.elf ();
+  std::string     path;
+
+  if (!rld::dwarf::has_debug_info (*elf)
+      && rld::dwarf::find_debug_file (*elf, path, debug_dirs))
+  {
+    if (rld::verbose ())
+      std::cerr << "debug: " << path << std::endl;
+    debug_exe.reset (new rld::files::object (path));
+    debug_exe->open ();
+    debug_exe->begin ();
+    elf = &debug_exe->elf ();
+  }
+
+  debug.begin (*elf);
+  debug.load_debug (true);
+  debug.load_types ();
+  debug.load_functions ();
+}
+
+void
+debug_image::end ()
+{
+  debug.end ();
+  if (debug_exe)
+  {
+    debug_exe->end ();
+    debug_exe->close ();
+    debug_exe.reset ();
+  }
+  exe.end ();
+  exe.close ();
+}
+
+/**
+ * An executable with its debug info loaded.
+ */
+struct loaded_image
+{
+  const std::string name;   ///< The executable's path.
+  const time_t      mtime;  ///< The modification time when loaded.
+  debug_image       image;  ///< The executable and its debug info.
+  rld::dwarf::file& debug;  ///< The executable's debug info.
+  frame_memo        memo;   ///< The output of the addresses resolved.
+
+  loaded_image (const std::string&      name,
+                time_t                  mtime,
+                const rld::path::paths& debug_dirs);
+};
+
+typedef std::unique_ptr < loaded_image > loaded_image_ptr;
+typedef std::list < loaded_image_ptr > loaded_images;
+
+loaded_image::loaded_image (const std::string&      name,
+                            time_t                  mtime,
+                            const rld::path::paths& debug_dirs)
+  : name (name),
+    mtime (mtime),
+    image (name),
+    debug (image.debug)
+{
+  image.begin (debug_dirs);
+}
+
+/**
+ * Find the executable in the cache loading it if it is not present or has
+ * been modified since it was loaded. The cache is held with the most recently
+ * used executable at the front.
+ */
+static loaded_image&
+get_image (loaded_images&          images,
+           const std::string&      name,
+           size_t                  cache_size,
+           const rld::path::paths& debug_dirs)
+{
+  struct stat sb;
+
+  if (::stat (name.c_str (), &sb) != 0)
+    throw rld::error ("cannot stat: " + name, "server");
+
+  for (auto i = images.begin (); i != images.end (); ++i)
+  {
+    if ((*i)->name == name)
+    {
+      if ((*i)->mtime == sb.st_mtime)
+      {
+        images.splice (images.begin (), images, i);
+        return *images.front ();
+      }
+      images.erase (i);
+      break;
+    }
+  }
+
+  if (rld::verbose ())
+    std::cerr << "server: loading: " << name << std::endl;
+
+  images.push_front (loaded_image_ptr (new loaded_image (name,
+                                                        sb.st_mtime,
+                                                        debug_dirs)));
+
+  while (images.size () > cache_size)
+    images.pop_back ();
+
+  return *images.front ();
+}
+
+static void
+serve (std::istream&           in,
+       size_t                  cache_size,
+       const rld::path::paths& debug_dirs,
+       bool                    show_functions,
+       bool                    show_addresses,
+       bool                    pretty_print,
+       bool                    show_basenames,
+       bool                    show_inlines)
+{
+  loaded_images images;
+  std::string   request;
+
+  while (std::getline (in, request))
+  {
+    std::istringstream iss (request);
+    std::string        exe_name;
+    locations          locs;
+    std::string        buffer;
+
+    if (!(iss >> exe_name))
+      continue;
+
+    read_addresses (iss, locs);
+
+    try
+    {
+      loaded_image& image = get_image (images, exe_name, cache_size,
+                                       debug_dirs);
+
+      symbolize (image.debug, locs, image.memo, buffer,
+                 show_functions, show_addresses,
+                 pretty_print, show_basenames, show_inlines);
+    }
+    catch (rld::error re)
+    {
+      std::ostringstream oss;
+      oss << "error: "
+          << re.where << ": " << re.what
+          << std::endl;
+      buffer += oss.str ();
+    }
+
+    buffer += '\n';
+
+    std::cout.write (buffer.data (), buffer.size ());
+    std::cout << std::flush;
+  }
+}
+
 void
 unhandled_exception (void)
 {
@@ -133,12 +525,17 @@ main (int argc, char* argv[])
     bool        show_addresses = false;
     bool        pretty_print = false;
     bool        show_basenames = false;
+    bool        show_inlines = false;
+    std::string batch_name;
+    bool        server = false;
+    size_t      cache_size = 4;
+    rld::path::paths debug_dirs;
 
     rld::set_cmdline (argc, argv);
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hvVe:faps", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hvVe:fapsib:SC:D:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -175,6 +572,29 @@ main (int argc, char* argv[])
           show_basenames = true;
           break;
 
+        case 'i':
+          show_inlines = true;
+          break;
+
+        case 'b':
+          batch_name = optarg;
+          break;
+
+        case 'S':
+          server = true;
+          break;
+
+        case 'C':
+          cache_size = ::strtoul (optarg, 0, 0);
+          if (cache_size == 0)
+            throw rld::error ("invalid cache size: " + std::string (optarg),
+                              "options");
+          break;
+
+        case 'D':
+          debug_dirs.push_back (optarg);
+          break;
+
         case '?':
           usage (3);
           break;
@@ -196,10 +616,21 @@ main (int argc, char* argv[])
     if (rld::verbose ())
       std::cout << "RTEMS Address To Line " << rld::version () << std::endl;
 
+    if (server)
+    {
+      if (argc != 0 || !batch_name.empty ())
+        throw rld::error ("addresses cannot be provided to the server",
+                          "options");
+      serve (std::cin, cache_size, debug_dirs,
+             show_functions, show_addresses, pretty_print, show_basenames,
+             show_inlines);
+      return 0;
+    }
+
     /*
      * If there are no object files there is nothing to link.
      */
-    if (argc == 0)
+    if (argc == 0 && batch_name.empty ())
       throw rld::error ("no addresses provided", "options");
 
     if (rld::verbose ())
@@ -208,75 +639,86 @@ main (int argc, char* argv[])
     /*
      * Load the executable's debug info.
      */
-    rld::files::object exe (exe_name);
-    rld::dwarf::file   debug;
+    debug_image       image (exe_name);
+    rld::dwarf::file& debug = image.debug;
 
     try
     {
       /*
        * Load the executable's ELF file debug info.
        */
-      exe.open ();
-      exe.begin ();
-      debug.begin (exe.elf ());
-      debug.load_debug ();
-      debug.load_types ();
-      debug.load_functions ();
-
-      for (int arg = 0; arg < argc; ++arg)
-      {
-        rld::dwarf::dwarf_address location;
-
-        if (rld::verbose ())
-          std::cout << "address: " << argv[arg] << std::endl;
+      image.begin (debug_dirs);
 
+      if (!batch_name.empty ())
+      {
         /*
-         * Use the C routine as C++ does not have a way to automatically handle
-         * different bases on the input.
+         * Resolve the addresses on the command line and in the batch file
+         * together. The results are output in the order of the input.
          */
-        location = ::strtoul (argv[arg], 0, 0);
-
-        std::string path;
-        int         line;
+        locations   locs;
+        frame_memo  memo;
+        std::string buffer;
 
-        debug.get_source (location, path, line);
+        for (int arg = 0; arg < argc; ++arg)
+          locs.push_back (::strtoul (argv[arg], 0, 0));
 
-        if (show_addresses)
+        if (batch_name == "-")
         {
-          std::cout << std::hex << std::setfill ('0')
-                    << "0x" << location
-                    << std::dec << std::setfill (' ');
-
-          if (pretty_print)
-            std::cout << ": ";
-          else
-            std::cout << std::endl;
+          read_addresses (std::cin, locs);
         }
+        else
+        {
+          std::ifstream in (batch_name);
+          if (!in.is_open ())
+            throw rld::error ("cannot open batch file: " + batch_name,
+                              "options");
+          read_addresses (in, locs);
+        }
+
+        if (rld::verbose ())
+          std::cout << "batch: " << locs.size () << " addresses" << std::endl;
 
-        if (show_functions)
+        symbolize (debug, locs, memo, buffer,
+                   show_functions, show_addresses,
+                   pretty_print, show_basenames, show_inlines);
+
+        std::cout.write (buffer.data (), buffer.size ());
+      }
+      else
+      {
+        for (int arg = 0; arg < argc; ++arg)
         {
+          rld::dwarf::dwarf_address location;
+
+          if (rld::verbose ())
+            std::cout << "address: " << argv[arg] << std::endl;
+
+          /*
+           * Use the C routine as C++ does not have a way to automatically
+           * handle different bases on the input.
+           */
+          location = ::strtoul (argv[arg], 0, 0);
+
+          std::string path;
+          int         line;
           std::string function;
-          debug.get_function (location, function);
-          std::cout << function << " at ";
-        }
 
-        if (show_basenames)
-          std::cout << rld::path::basename (path);
-        else
-          std::cout << path;
+          debug.get_source (location, path, line);
 
-        std::cout << ':' << line << std::endl;
+          if (show_functions)
+            debug.get_function (location, function);
+
+          output_frames (std::cout, debug, location, path, line, function,
+                         show_functions, show_addresses,
+                         pretty_print, show_basenames, show_inlines);
+        }
       }
 
-      debug.end ();
-      exe.end ();
-      exe.close ();
+      image.end ();
     }
     catch (...)
     {
-      debug.end ();
-      exe.end ();
-      exe.close ();
+      image.end ();
       throw;
     }
   }
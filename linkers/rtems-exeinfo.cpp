@@ -32,6 +32,9 @@
 
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <mutex>
+#include <vector>
 
 #include <cxxabi.h>
 #include <signal.h>
@@ -45,8 +48,10 @@
 #include <rld-buffer.h>
 #include <rld-dwarf.h>
 #include <rld-files.h>
+#include <rld-hash.h>
 #include <rld-process.h>
 #include <rld-rtems.h>
+#include <rld-tasks.h>
 #include <rtems-utils.h>
 
 #ifndef HAVE_KILL
@@ -127,11 +132,97 @@ namespace rld
      */
     typedef std::list < section > sections;
 
+    /**
+     * The compiler flags not checked for being common to all sources.
+     */
+    const rld::strings flag_exceptions = { "-O",
+                                           "-g",
+                                           "-mtune=",
+                                           "-fno-builtin",
+                                           "-fno-inline",
+                                           "-fexceptions",
+                                           "-fnon-call-exceptions",
+                                           "-fvisibility=",
+                                           "-fno-stack-protector",
+                                           "-fbuilding-libgcc",
+                                           "-fno-implicit-templates",
+                                           "-fimplicit-templates",
+                                           "-ffunction-sections",
+                                           "-fdata-sections",
+                                           "-frandom-seed=",
+                                           "-fno-common",
+                                           "-fno-keep-inline-functions" };
+
+    /**
+     * The number of times an inlined function is inlined and the size.
+     */
+    struct func_count
+    {
+      std::string name;
+      int         count;
+      size_t      size;
+
+      func_count (std::string name, size_t size)
+        : name (name),
+          count (1),
+          size (size) {
+      }
+    };
+    typedef std::vector < func_count > func_counts;
+
+    /**
+     * The output selected for each executable.
+     */
+    struct report_options
+    {
+      bool map;
+      bool sections;
+      bool init;
+      bool fini;
+      bool objects;
+      bool full_flags;
+      bool config;
+      bool tls;
+      bool inlined;
+      bool dwarf_data;
+      bool json;
+    };
+
+    /**
+     * The statistics of a compilation unit.
+     */
+    struct cu_stats
+    {
+      std::string    name;
+      std::string    producer;
+      dwarf::dwarf_unsigned offset;
+      unsigned int   pc_low;
+      unsigned int   pc_high;
+      size_t         functions;       //< The functions with machine code.
+      size_t         size;            //< The size of the functions.
+      size_t         inlined;         //< The inlined functions.
+      size_t         inlined_size;    //< The size of the inlined functions.
+      size_t         not_inlined;     //< The inline functions not inlined.
+
+      cu_stats ()
+        : offset (0),
+          pc_low (0),
+          pc_high (0),
+          functions (0),
+          size (0),
+          inlined (0),
+          inlined_size (0),
+          not_inlined (0) {
+      }
+    };
+    typedef std::vector < cu_stats > cus_stats;
+
     /**
      * The kernel image.
      */
     struct image
     {
+      elf::object_type types;       //< The executable's ELF type.
       files::object    exe;         //< The object file that is the executable.
       dwarf::file      debug;       //< The executable's DWARF details.
       symbols::table   symbols;     //< The synbols for a map.
@@ -139,12 +230,20 @@ namespace rld
       files::sections  secs;        //< The sections in the executable.
       const char**     init;        //< The init section's list for the machinetype.
       const char**     fini;        //< The fini section's list for the machinetype.
-
+      std::ostream&    out;         //< The output stream.
+      unsigned int     jobs;        //< The jobs to generate the output.
 
       /**
-       * Load the executable file.
+       * Load the executable file. Only the DWARF data needed for the output
+       * is loaded, the functions for the inlined report and everything for
+       * the DWARF dump.
        */
-      image (const std::string exe_name, bool load_functions);
+      image (const std::string exe_name,
+             std::ostream&     out,
+             bool              load_functions,
+             bool              load_all_dwarf,
+             unsigned int      jobs = 1,
+             bool              json = false);
 
       /**
        * Clean up.
@@ -196,9 +295,62 @@ namespace rld
        */
       void output_dwarf ();
 
+      /*
+       * Output the executable as a JSON object. The DWARF data is not
+       * supported.
+       */
+      void output_json (const report_options& opts);
+
     private:
 
       void config (const std::string name);
+
+      /*
+       * Get the producers and the flags common to all sources.
+       */
+      void compilation_flags (dwarf::producer_sources& producers,
+                              rld::strings&            common_flags,
+                              size_t&                  source_max);
+
+      /*
+       * Get the sources' flags not common to all sources.
+       */
+      void source_flags (const dwarf::source_flags& source,
+                         const rld::strings&        filter_flags,
+                         bool                       full_flags,
+                         rld::strings&              flags);
+
+      /*
+       * Load the init or fini sections.
+       */
+      void load_init_fini (const char** names, sections& ifsecs);
+
+      /*
+       * Get the inlined and not inlined functions and the totals.
+       */
+      void inlined_functions (dwarf::functions& funcs_inlined,
+                              dwarf::functions& funcs_not_inlined,
+                              func_counts&      counts,
+                              size_t&           total,
+                              size_t&           total_size,
+                              size_t&           inlined_size);
+
+      /*
+       * Get the statistics of the compilation units. The units are
+       * processed in parallel and the statistics are in the units' order.
+       */
+      void cu_statistics (cus_stats& stats);
+
+      bool has_config (const std::string name);
+
+      void json_compilation_unit (bool objects, bool full_flags);
+      void json_compilation_units ();
+      void json_sections ();
+      void json_init_fini (const char* label, const char** names);
+      void json_config ();
+      void json_tls ();
+      void json_inlined ();
+      void json_symbols ();
     };
 
     section::section (const files::section& sec, files::byteorder byteorder)
@@ -283,14 +435,22 @@ namespace rld
       }
     }
 
-    image::image (const std::string exe_name, bool load_functions)
+    image::image (const std::string exe_name,
+                  std::ostream&     out,
+                  bool              load_functions,
+                  bool              load_all_dwarf,
+                  unsigned int      jobs,
+                  bool              json)
       : exe (exe_name),
         init (0),
-        fini (0)
+        fini (0),
+        out (out),
+        jobs (jobs)
     {
       /*
        * Open the executable file and begin the session on it.
        */
+      exe.set_object_type (types);
       exe.open ();
       exe.begin ();
       debug.begin (exe.elf ());
@@ -318,12 +478,16 @@ namespace rld
        * Load the symbols and sections.
        */
       exe.load_symbols (symbols, true);
-      debug.load_debug ();
-      debug.load_types ();
-      debug.load_variables ();
-      if (load_functions)
+      debug.load_debug (false, jobs);
+      if (load_all_dwarf)
+      {
+        debug.load_types ();
+        debug.load_variables ();
+      }
+      if (load_functions || load_all_dwarf)
       {
-        std::cout << "May take a while ..." << std::endl;
+        if (!json)
+          out << "May take a while ..." << std::endl;
         debug.load_functions ();
       }
       symbols.globals (addresses);
@@ -337,32 +501,10 @@ namespace rld
     }
 
     void
-    image::output_compilation_unit (bool objects, bool full_flags)
+    image::compilation_flags (dwarf::producer_sources& producers,
+                              rld::strings&            common_flags,
+                              size_t&                  source_max)
     {
-      dwarf::compilation_units& cus = debug.get_cus ();
-
-      std::cout << "Compilation: " << std::endl;
-
-      rld::strings flag_exceptions = { "-O",
-                                       "-g",
-                                       "-mtune=",
-                                       "-fno-builtin",
-                                       "-fno-inline",
-                                       "-fexceptions",
-                                       "-fnon-call-exceptions",
-                                       "-fvisibility=",
-                                       "-fno-stack-protector",
-                                       "-fbuilding-libgcc",
-                                       "-fno-implicit-templates",
-                                       "-fimplicit-templates",
-                                       "-ffunction-sections",
-                                       "-fdata-sections",
-                                       "-frandom-seed=",
-                                       "-fno-common",
-                                       "-fno-keep-inline-functions" };
-
-      dwarf::producer_sources producers;
-
       debug.get_producer_sources (producers);
 
       /*
@@ -372,9 +514,8 @@ namespace rld
        */
 
       rld::strings all_flags;
-      ::rtems::utils::ostream_guard old_state( std::cout );
 
-      size_t source_max = 0;
+      source_max = 0;
 
       for (auto& p : producers)
       {
@@ -418,8 +559,6 @@ namespace rld
         }
       }
 
-      rld::strings common_flags;
-
       for (auto& flag : all_flags)
       {
         bool found_in_all = true;
@@ -451,25 +590,66 @@ namespace rld
         if (found_in_all)
           common_flags.push_back (flag);
       }
+    }
+
+    void
+    image::source_flags (const dwarf::source_flags& source,
+                         const rld::strings&        filter_flags,
+                         bool                       full_flags,
+                         rld::strings&              flags)
+    {
+      for (auto& f : source.flags)
+      {
+        bool present = false;
+        if (!full_flags)
+        {
+          for (auto& ff : filter_flags)
+          {
+            if (rld::starts_with(f, ff))
+            {
+              present = true;
+              break;
+            }
+          }
+        }
+        if (!present)
+          flags.push_back (f);
+      }
+    }
+
+    void
+    image::output_compilation_unit (bool objects, bool full_flags)
+    {
+      dwarf::compilation_units& cus = debug.get_cus ();
 
-      std::cout << " Producers: " << producers.size () << std::endl;
+      out << "Compilation: " << std::endl;
+
+      dwarf::producer_sources producers;
+      rld::strings            common_flags;
+      size_t                  source_max;
+
+      compilation_flags (producers, common_flags, source_max);
+
+      ::rtems::utils::ostream_guard old_state( out );
+
+      out << " Producers: " << producers.size () << std::endl;
 
       for (auto& p : producers)
       {
-        std::cout << "  | " << p.producer
-                  << ": " << p.sources.size () << " objects" << std::endl;
+        out << "  | " << p.producer
+            << ": " << p.sources.size () << " objects" << std::endl;
       }
 
-      std::cout << " Common flags: " << common_flags.size () << std::endl
-                << "  |";
+      out << " Common flags: " << common_flags.size () << std::endl
+          << "  |";
 
       for (auto& f : common_flags)
-        std::cout << ' ' << f;
-      std::cout << std::endl;
+        out << ' ' << f;
+      out << std::endl;
 
       if (objects)
       {
-        std::cout << " Object files: " << cus.size () << std::endl;
+        out << " Object files: " << cus.size () << std::endl;
 
         rld::strings filter_flags = common_flags;
         filter_flags.insert (filter_flags.end (),
@@ -478,53 +658,63 @@ namespace rld
 
         for (auto& p : producers)
         {
-          std::cout << ' ' << p.producer
-                    << ": " << p.sources.size () << " objects" << std::endl;
+          out << ' ' << p.producer
+              << ": " << p.sources.size () << " objects" << std::endl;
           for (auto& s : p.sources)
           {
-            std::cout << "   | "
-                      << std::setw (source_max + 1) << std::left
-                      << rld::path::basename (s.source);
-            if (!s.flags.empty ())
+            out << "   | "
+                << std::setw (source_max + 1) << std::left
+                << rld::path::basename (s.source);
+            rld::strings flags;
+            source_flags (s, filter_flags, full_flags, flags);
+            if (!flags.empty ())
             {
-              bool first = true;
-              for (auto& f : s.flags)
-              {
-                bool present = false;
-                if (!full_flags)
-                {
-                  for (auto& ff : filter_flags)
-                  {
-                    if (rld::starts_with(f, ff))
-                    {
-                      present = true;
-                      break;
-                    }
-                  }
-                }
-                if (!present)
-                {
-                  if (first)
-                  {
-                    std::cout << ':';
-                    first = false;
-                  }
-                  std::cout << ' ' << f;
-                }
-              }
+              out << ':';
+              for (auto& f : flags)
+                out << ' ' << f;
             }
-            std::cout << std::endl;
+            out << std::endl;
           }
         }
       }
 
-      std::cout << std::endl;
+      out << std::endl;
+    }
+
+    /**
+     * The section's flags as a character per flag.
+     */
+    static std::string
+    section_flags (const files::section& sec)
+    {
+      #define SF(f, i, c) if (sec.flags & (f)) flags[i] = c
+
+      std::string flags ("--------------");
+
+      SF (SHF_WRITE,            0, 'W');
+      SF (SHF_ALLOC,            1, 'A');
+      SF (SHF_EXECINSTR,        2, 'E');
+      SF (SHF_MERGE,            3, 'M');
+      SF (SHF_STRINGS,          4, 'S');
+      SF (SHF_INFO_LINK,        5, 'I');
+      SF (SHF_LINK_ORDER,       6, 'L');
+      SF (SHF_OS_NONCONFORMING, 7, 'N');
+      SF (SHF_GROUP,            8, 'G');
+      SF (SHF_TLS,              9, 'T');
+      SF (SHF_AMD64_LARGE,     10, 'a');
+      SF (SHF_ENTRYSECT,       11, 'e');
+      SF (SHF_COMDEF,          12, 'c');
+      SF (SHF_ORDERED,         13, 'O');
+
+      #undef SF
+
+      return flags;
     }
 
     void
     image::output_sections ()
     {
-      std::cout << "Sections: " << secs.size () << std::endl;
+      out << "Sections: " << secs.size () << std::endl;
 
       size_t max_section_name = 0;
 
@@ -542,40 +732,22 @@ namespace rld
            ++si)
       {
         const files::section& sec = *si;
-
-        #define SF(f, i, c) if (sec.flags & (f)) flags[i] = c
-
-        std::string flags ("--------------");
-
-        SF (SHF_WRITE,            0, 'W');
-        SF (SHF_ALLOC,            1, 'A');
-        SF (SHF_EXECINSTR,        2, 'E');
-        SF (SHF_MERGE,            3, 'M');
-        SF (SHF_STRINGS,          4, 'S');
-        SF (SHF_INFO_LINK,        5, 'I');
-        SF (SHF_LINK_ORDER,       6, 'L');
-        SF (SHF_OS_NONCONFORMING, 7, 'N');
-        SF (SHF_GROUP,            8, 'G');
-        SF (SHF_TLS,              9, 'T');
-        SF (SHF_AMD64_LARGE,     10, 'a');
-        SF (SHF_ENTRYSECT,       11, 'e');
-        SF (SHF_COMDEF,          12, 'c');
-        SF (SHF_ORDERED,         13, 'O');
-
-        std::cout << "  " << std::left
-                  << std::setw (max_section_name) << sec.name
-                  << " " << flags
-                  << std::right << std::hex << std::setfill ('0')
-                  << " addr: 0x" << std::setw (8) << sec.address
-                  << " 0x" << std::setw (8) << sec.address + sec.size
-                  << std::dec << std::setfill (' ')
-                  << " size: " << std::setw (10) << sec.size
-                  << " align: " << std::setw (3) << sec.alignment
-                  << " relocs: " << std::setw (6) << sec.relocs.size ()
-                  << std::endl;
+        const std::string     flags = section_flags (sec);
+
+        out << "  " << std::left
+            << std::setw (max_section_name) << sec.name
+            << " " << flags
+            << std::right << std::hex << std::setfill ('0')
+            << " addr: 0x" << std::setw (8) << sec.address
+            << " 0x" << std::setw (8) << sec.address + sec.size
+            << std::dec << std::setfill (' ')
+            << " size: " << std::setw (10) << sec.size
+            << " align: " << std::setw (3) << sec.alignment
+            << " relocs: " << std::setw (6) << sec.relocs.size ()
+            << std::endl;
       }
 
-      std::cout << std::endl;
+      out << std::endl;
     }
 
     void
@@ -590,6 +762,13 @@ namespace rld
       output_init_fini ("Fini", fini);
     }
 
+    void
+    image::load_init_fini (const char** names, sections& ifsecs)
+    {
+      std::for_each (secs.begin (), secs.end (),
+                     section_loader (*this, ifsecs, names));
+    }
+
     void
     image::output_init_fini (const char* label, const char** names)
     {
@@ -597,17 +776,16 @@ namespace rld
        * Load the sections.
        */
       sections ifsecs;
-      std::for_each (secs.begin (), secs.end (),
-                     section_loader (*this, ifsecs, names));
+      load_init_fini (names, ifsecs);
 
-      std::cout << label << " sections: " << ifsecs.size () << std::endl;
+      out << label << " sections: " << ifsecs.size () << std::endl;
 
       for (auto& sec : ifsecs)
       {
         const size_t machine_size = exe.elf ().machine_size ();
         const int    count = sec.data.level () / machine_size;
 
-        std::cout << " " << sec.sec.name << std::endl;
+        out << " " << sec.sec.name << std::endl;
 
         for (int i = 0; i < count; ++i)
         {
@@ -617,32 +795,30 @@ namespace rld
           if (address != 0)
           {
             sym = addresses[address];
-            std::cout << "  "
-                      << std::hex << std::setfill ('0')
-                      << "0x" << std::setw (8) << address
-                      << std::dec << std::setfill ('0');
+            out << "  "
+                << std::hex << std::setfill ('0')
+                << "0x" << std::setw (8) << address
+                << std::dec << std::setfill ('0');
             if (sym)
             {
-              std::string label = sym->name ();
-              if (rld::symbols::is_cplusplus (label))
-                rld::symbols::demangle_name (label, label);
-              std::cout << " " << label;
+              const std::string* demangled = rld::symbols::demangle (sym->name ());
+              out << " " << (demangled ? *demangled : sym->name ());
             }
             else
             {
-              std::cout << " no symbol (maybe static to a module)";
+              out << " no symbol (maybe static to a module)";
             }
-            std::cout << std::endl;
+            out << std::endl;
           }
         }
       }
 
-      std::cout << std::endl;
+      out << std::endl;
     }
 
     void image::output_tls ()
     {
-      ::rtems::utils::ostream_guard old_state( std::cout );
+      ::rtems::utils::ostream_guard old_state( out );
 
       symbols::symbol* tls_data_begin = symbols.find_global("_TLS_Data_begin");
       symbols::symbol* tls_data_end = symbols.find_global("_TLS_Data_end");
@@ -672,106 +848,106 @@ namespace rld
             tls_size == nullptr &&
             tls_alignment == nullptr)
         {
-            std::cout << "No TLS data found" << std::endl;
+            out << "No TLS data found" << std::endl;
             return;
         }
-        std::cout << "TLS environment is INVALID (please report):" << std::endl
-                  << " _TLS_Data_begin          : "
-                  << (char*) (tls_data_begin == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_Data_end            : "
-                  << (char*) (tls_data_end == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_Data_size           : "
-                  << (char*) (tls_data_size == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_BSS_begin           : "
-                  << (char*) (tls_bss_begin == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_BSS_end             : "
-                  << (char*) (tls_bss_end == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_BSS_Size            : "
-                  << (char*) (tls_bss_size == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_Size                : "
-                  << (char*) (tls_size == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _TLS_Alignment           : "
-                  << (char*) (tls_alignment == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << " _Thread_Maximum_TLS_size : "
-                  << (char*) (tls_max_size == nullptr ? "not-found" : "found")
-                  << std::endl
-                  << std::endl;
+        out << "TLS environment is INVALID (please report):" << std::endl
+            << " _TLS_Data_begin          : "
+            << (char*) (tls_data_begin == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_Data_end            : "
+            << (char*) (tls_data_end == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_Data_size           : "
+            << (char*) (tls_data_size == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_BSS_begin           : "
+            << (char*) (tls_bss_begin == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_BSS_end             : "
+            << (char*) (tls_bss_end == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_BSS_Size            : "
+            << (char*) (tls_bss_size == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_Size                : "
+            << (char*) (tls_size == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _TLS_Alignment           : "
+            << (char*) (tls_alignment == nullptr ? "not-found" : "found")
+            << std::endl
+            << " _Thread_Maximum_TLS_size : "
+            << (char*) (tls_max_size == nullptr ? "not-found" : "found")
+            << std::endl
+            << std::endl;
         return;
       }
 
-      std::cout << "TLS size      : " << tls_size->value () << std::endl
-                << "     max size : ";
+      out << "TLS size      : " << tls_size->value () << std::endl
+          << "     max size : ";
       if (tls_max_size == nullptr)
-          std::cout << "not found" << std::endl;
+          out << "not found" << std::endl;
       else
-          std::cout << tls_max_size->value () << std::endl;
-      std::cout << "    data size : " << tls_data_size->value () << std::endl
-                << "     bss size : " << tls_bss_size->value () << std::endl
-                << "    alignment : " << tls_alignment->value () << std::endl
-                << std::right << std::hex << std::setfill ('0')
-                << "    data addr : 0x" << std::setw (8) << tls_data_begin->value ()
-                << std::endl
-                << std::dec << std::setfill (' ')
-                << std::endl;
+          out << tls_max_size->value () << std::endl;
+      out << "    data size : " << tls_data_size->value () << std::endl
+          << "     bss size : " << tls_bss_size->value () << std::endl
+          << "    alignment : " << tls_alignment->value () << std::endl
+          << std::right << std::hex << std::setfill ('0')
+          << "    data addr : 0x" << std::setw (8) << tls_data_begin->value ()
+          << std::endl
+          << std::dec << std::setfill (' ')
+          << std::endl;
     }
 
-    void image::config(const std::string name)
+    /**
+     * The configurations reported in the order reported.
+     */
+    const char* config_names[] =
     {
-      std::string table_name = "_" + name + "_Information";
-      symbols::symbol* table = symbols.find_global(table_name);
+      "Thread",
+      "Barrier",
+      "Extension",
+      "Message_queue",
+      "Partition",
+      "Rate_monotonic",
+      "Dual_ported_memory",
+      "Region",
+      "Semaphore",
+      "Timer",
+      "RTEMS_tasks",
+      0
+    };
 
-      if (table != nullptr)
-        std::cout << " " << name << std::endl;
+    bool image::has_config(const std::string name)
+    {
+      std::string table_name = "_" + name + "_Information";
+      return symbols.find_global(table_name) != nullptr;
     }
 
-    void image::output_config()
+    void image::config(const std::string name)
     {
-      std::cout << "Configurations:" << std::endl;
-      config("Thread");
-      config("Barrier");
-      config("Extension");
-      config("Message_queue");
-      config("Partition");
-      config("Rate_monotonic");
-      config("Dual_ported_memory");
-      config("Region");
-      config("Semaphore");
-      config("Timer");
-      config("RTEMS_tasks");
+      if (has_config(name))
+        out << " " << name << std::endl;
     }
 
-    struct func_count
+    void image::output_config()
     {
-      std::string name;
-      int         count;
-      size_t      size;
-
-      func_count (std::string name, size_t size)
-        : name (name),
-          count (1),
-          size (size) {
-      }
-    };
-    typedef std::vector < func_count > func_counts;
+      out << "Configurations:" << std::endl;
+      for (int n = 0; config_names[n] != 0; ++n)
+        config(config_names[n]);
+    }
 
-    void image::output_inlined ()
+    void
+    image::inlined_functions (dwarf::functions& funcs_inlined,
+                              dwarf::functions& funcs_not_inlined,
+                              func_counts&      counts,
+                              size_t&           total,
+                              size_t&           total_size,
+                              size_t&           inlined_size)
     {
-      size_t           total = 0;
-      size_t           total_size = 0;
-      size_t           inlined_size = 0;
-      double           percentage;
-      double           percentage_size;
-      dwarf::functions funcs_inlined;
-      dwarf::functions funcs_not_inlined;
-      func_counts      counts;
+      total = 0;
+      total_size = 0;
+      inlined_size = 0;
 
       for (auto& cu : debug.get_cus ())
       {
@@ -811,6 +987,21 @@ namespace rld
           }
         }
       }
+    }
+
+    void image::output_inlined ()
+    {
+      size_t           total;
+      size_t           total_size;
+      size_t           inlined_size;
+      double           percentage;
+      double           percentage_size;
+      dwarf::functions funcs_inlined;
+      dwarf::functions funcs_not_inlined;
+      func_counts      counts;
+
+      inlined_functions (funcs_inlined, funcs_not_inlined, counts,
+                         total, total_size, inlined_size);
 
       if ( total == 0 ) {
         percentage = 0;
@@ -824,12 +1015,12 @@ namespace rld
         percentage_size = (double) ( inlined_size * 100 ) / total_size;
       }
 
-      std::cout << "inlined funcs   : " << funcs_inlined.size () << std::endl
-                << "    total funcs : " << total << std::endl
-                << " % inline funcs : " << percentage << '%' << std::endl
-                << "     total size : " << total_size << std::endl
-                << "    inline size : " << inlined_size << std::endl
-                << "  % inline size : " << percentage_size << '%' << std::endl;
+      out << "inlined funcs   : " << funcs_inlined.size () << std::endl
+          << "    total funcs : " << total << std::endl
+          << " % inline funcs : " << percentage << '%' << std::endl
+          << "     total size : " << total_size << std::endl
+          << "    inline size : " << inlined_size << std::endl
+          << "  % inline size : " << percentage_size << '%' << std::endl;
 
       auto count_compare = [](func_count const & a, func_count const & b) {
         return a.size != b.size?  a.size < b.size : a.count > b.count;
@@ -837,31 +1028,31 @@ namespace rld
       std::sort (counts.begin (), counts.end (), count_compare);
       std::reverse (counts.begin (), counts.end ());
 
-      std::cout  << std::endl << "inlined repeats : " << std::endl;
+      out  << std::endl << "inlined repeats : " << std::endl;
       for (auto& c : counts)
         if (c.count > 1)
-          std::cout << std::setw (6) << c.size << ' '
-                    << std::setw (4) << c.count << ' '
-                    << c.name << std::endl;
+          out << std::setw (6) << c.size << ' '
+              << std::setw (4) << c.count << ' '
+              << c.name << std::endl;
 
       dwarf::function_compare compare (dwarf::function_compare::fc_by_size);
 
       std::sort (funcs_inlined.begin (), funcs_inlined.end (), compare);
       std::reverse (funcs_inlined.begin (), funcs_inlined.end ());
 
-      std::cout << std::endl << "inline funcs : " << std::endl;
+      out << std::endl << "inline funcs : " << std::endl;
       for (auto& f : funcs_inlined)
       {
         std::string flags;
 
-        std::cout << std::setw (6) << f.size () << ' '
-                  << (char) (f.is_external () ? 'E' : ' ')
-                  << (char) (f.get_inlined () == dwarf::function::inl_inline ? 'C' : ' ')
-                  << std::hex << std::setfill ('0')
-                  << " 0x" << std::setw (8) << f.pc_low ()
-                  << std::dec << std::setfill (' ')
-                  << ' ' << f.name ()
-                  << std::endl;
+        out << std::setw (6) << f.size () << ' '
+            << (char) (f.is_external () ? 'E' : ' ')
+            << (char) (f.get_inlined () == dwarf::function::inl_inline ? 'C' : ' ')
+            << std::hex << std::setfill ('0')
+            << " 0x" << std::setw (8) << f.pc_low ()
+            << std::dec << std::setfill (' ')
+            << ' ' << f.name ()
+            << std::endl;
       }
 
       if (funcs_not_inlined.size () > 0)
@@ -869,25 +1060,892 @@ namespace rld
         std::sort (funcs_not_inlined.begin (), funcs_not_inlined.end (), compare);
         std::reverse (funcs_not_inlined.begin (), funcs_not_inlined.end ());
 
-        std::cout << std::endl << "inline funcs not inlined: " << std::endl;
+        out << std::endl << "inline funcs not inlined: " << std::endl;
         for (auto& f : funcs_not_inlined)
         {
-          std::cout << std::setw (6) << f.size () << ' '
-                    << (char) (f.is_external () ? 'E' : ' ')
-                    << (char) (f.get_inlined () == dwarf::function::inl_inline ? 'C' : ' ')
-                    << std::hex << std::setfill ('0')
-                    << " 0x" << std::setw (8) << f.pc_low ()
-                    << std::dec << std::setfill (' ')
-                    << ' ' << f.name ()
-                    << std::endl;
+          out << std::setw (6) << f.size () << ' '
+              << (char) (f.is_external () ? 'E' : ' ')
+              << (char) (f.get_inlined () == dwarf::function::inl_inline ? 'C' : ' ')
+              << std::hex << std::setfill ('0')
+              << " 0x" << std::setw (8) << f.pc_low ()
+              << std::dec << std::setfill (' ')
+              << ' ' << f.name ()
+              << std::endl;
         }
       }
     }
 
     void image::output_dwarf ()
     {
-      std::cout << "DWARF Data:" << std::endl;
-      debug.dump (std::cout);
+      out << "DWARF Data:" << std::endl;
+      debug.dump (out);
+    }
+
+    /**
+     * Quote a string for JSON.
+     */
+    static std::string
+    json_string (const std::string& s)
+    {
+      std::string js = "\"";
+      for (auto c : s)
+      {
+        switch (c)
+        {
+          case '"':
+            js += "\\\"";
+            break;
+          case '\\':
+            js += "\\\\";
+            break;
+          case '\n':
+            js += "\\n";
+            break;
+          default:
+            if ((unsigned char) c < 0x20)
+            {
+              char hex[8];
+              ::snprintf (hex, sizeof (hex), "\\u%04x", c);
+              js += hex;
+            }
+            else
+              js += c;
+            break;
+        }
+      }
+      return js + '"';
+    }
+
+    static const char*
+    json_bool (bool b)
+    {
+      return b ? "true" : "false";
+    }
+
+    void
+    image::cu_statistics (cus_stats& stats)
+    {
+      std::vector < dwarf::compilation_unit* > units;
+
+      for (auto& cu : debug.get_cus ())
+        units.push_back (&cu);
+
+      stats.resize (units.size ());
+
+      rld::tasks::parallel_for (units.size (), jobs, [&] (size_t u) {
+        dwarf::compilation_unit& cu = *units[u];
+        cu_stats&                st = stats[u];
+
+        st.name = cu.name ();
+        st.producer = cu.producer ();
+        st.offset = cu.offset ();
+        st.pc_low = cu.pc_low ();
+        st.pc_high = cu.pc_high ();
+
+        for (auto& f : cu.get_functions ())
+        {
+          if (f.size () > 0 && f.has_machine_code ())
+          {
+            ++st.functions;
+            st.size += f.size ();
+            switch (f.get_inlined ())
+            {
+              case dwarf::function::inl_inline:
+              case dwarf::function::inl_declared_inlined:
+                ++st.inlined;
+                st.inlined_size += f.size ();
+                break;
+              case dwarf::function::inl_declared_not_inlined:
+                ++st.not_inlined;
+                break;
+              default:
+                break;
+            }
+          }
+        }
+      });
+    }
+
+    void
+    image::json_compilation_unit (bool objects, bool full_flags)
+    {
+      dwarf::producer_sources producers;
+      rld::strings            common_flags;
+      size_t                  source_max;
+
+      compilation_flags (producers, common_flags, source_max);
+
+      rld::strings filter_flags = common_flags;
+      filter_flags.insert (filter_flags.end (),
+                           flag_exceptions.begin (),
+                           flag_exceptions.end());
+
+      out << ",\"compilation\":{\"producers\":[";
+
+      bool first = true;
+      for (auto& p : producers)
+      {
+        if (!first)
+          out << ',';
+        first = false;
+        out << "{\"producer\":" << json_string (p.producer)
+            << ",\"objects\":" << p.sources.size ();
+        if (objects)
+        {
+          out << ",\"sources\":[";
+          bool first_source = true;
+          for (auto& s : p.sources)
+          {
+            rld::strings flags;
+            source_flags (s, filter_flags, full_flags, flags);
+            if (!first_source)
+              out << ',';
+            first_source = false;
+            out << "{\"source\":" << json_string (s.source) << ",\"flags\":[";
+            for (size_t f = 0; f < flags.size (); ++f)
+              out << (f ? "," : "") << json_string (flags[f]);
+            out << "]}";
+          }
+          out << ']';
+        }
+        out << '}';
+      }
+
+      out << "],\"common-flags\":[";
+      for (size_t f = 0; f < common_flags.size (); ++f)
+        out << (f ? "," : "") << json_string (common_flags[f]);
+      out << "]}" << std::endl;
+    }
+
+    void
+    image::json_compilation_units ()
+    {
+      cus_stats stats;
+
+      cu_statistics (stats);
+
+      out << ",\"compilation-units\":[" << std::endl;
+      for (size_t u = 0; u < stats.size (); ++u)
+      {
+        const cu_stats& st = stats[u];
+        out << (u ? "," : "")
+            << "{\"name\":" << json_string (st.name)
+            << ",\"producer\":" << json_string (st.producer)
+            << ",\"offset\":" << st.offset
+            << ",\"pc-low\":" << st.pc_low
+            << ",\"pc-high\":" << st.pc_high
+            << ",\"functions\":" << st.functions
+            << ",\"size\":" << st.size
+            << ",\"inlined\":" << st.inlined
+            << ",\"inlined-size\":" << st.inlined_size
+            << ",\"not-inlined\":" << st.not_inlined
+            << '}' << std::endl;
+      }
+      out << ']' << std::endl;
+    }
+
+    void
+    image::json_sections ()
+    {
+      out << ",\"sections\":[" << std::endl;
+
+      bool first = true;
+      for (auto& sec : secs)
+      {
+        out << (first ? "" : ",")
+            << "{\"name\":" << json_string (sec.name)
+            << ",\"flags\":" << json_string (section_flags (sec))
+            << ",\"address\":" << sec.address
+            << ",\"size\":" << sec.size
+            << ",\"alignment\":" << sec.alignment
+            << ",\"relocs\":" << sec.relocs.size ()
+            << '}' << std::endl;
+        first = false;
+      }
+
+      out << ']' << std::endl;
+    }
+
+    void
+    image::json_init_fini (const char* label, const char** names)
+    {
+      sections ifsecs;
+
+      load_init_fini (names, ifsecs);
+
+      out << ",\"" << label << "\":[";
+
+      bool first = true;
+      for (auto& sec : ifsecs)
+      {
+        const size_t machine_size = exe.elf ().machine_size ();
+        const int    count = sec.data.level () / machine_size;
+
+        out << (first ? "" : ",")
+            << "{\"section\":" << json_string (sec.sec.name)
+            << ",\"entries\":[";
+        first = false;
+
+        bool first_entry = true;
+        for (int i = 0; i < count; ++i)
+        {
+          uint32_t address;
+          sec.data >> address;
+          if (address != 0)
+          {
+            symbols::symbol* sym = addresses[address];
+            out << (first_entry ? "" : ",")
+                << "{\"address\":" << address << ",\"symbol\":";
+            if (sym)
+            {
+              const std::string* demangled = rld::symbols::demangle (sym->name ());
+              out << json_string (demangled ? *demangled : sym->name ());
+            }
+            else
+              out << "null";
+            out << '}';
+            first_entry = false;
+          }
+        }
+        out << "]}";
+      }
+
+      out << ']' << std::endl;
+    }
+
+    void
+    image::json_config ()
+    {
+      out << ",\"configurations\":[";
+
+      bool first = true;
+      for (int n = 0; config_names[n] != 0; ++n)
+      {
+        if (has_config (config_names[n]))
+        {
+          out << (first ? "" : ",") << json_string (config_names[n]);
+          first = false;
+        }
+      }
+
+      out << ']' << std::endl;
+    }
+
+    void
+    image::json_tls ()
+    {
+      const char* tls_names[] =
+      {
+        "_TLS_Data_begin",
+        "_TLS_Data_end",
+        "_TLS_Data_size",
+        "_TLS_BSS_begin",
+        "_TLS_BSS_end",
+        "_TLS_BSS_size",
+        "_TLS_Size",
+        "_TLS_Alignment",
+        0
+      };
+
+      std::vector < symbols::symbol* > tls;
+      size_t                           found = 0;
+
+      for (int n = 0; tls_names[n] != 0; ++n)
+      {
+        tls.push_back (symbols.find_global (tls_names[n]));
+        if (tls.back () != nullptr)
+          ++found;
+      }
+
+      symbols::symbol* tls_max_size = symbols.find_global ("_Thread_Maximum_TLS_size");
+
+      out << ",\"tls\":";
+
+      if (found == 0)
+      {
+        out << "null" << std::endl;
+        return;
+      }
+
+      if (found != tls.size ())
+      {
+        out << "{\"valid\":false,\"symbols\":{";
+        for (size_t n = 0; n < tls.size (); ++n)
+          out << (n ? "," : "") << json_string (tls_names[n]) << ':'
+              << json_bool (tls[n] != nullptr);
+        out << ",\"_Thread_Maximum_TLS_size\":"
+            << json_bool (tls_max_size != nullptr) << "}}" << std::endl;
+        return;
+      }
+
+      out << "{\"valid\":true"
+          << ",\"size\":" << tls[6]->value ()
+          << ",\"max-size\":";
+      if (tls_max_size == nullptr)
+        out << "null";
+      else
+        out << tls_max_size->value ();
+      out << ",\"data-size\":" << tls[2]->value ()
+          << ",\"bss-size\":" << tls[5]->value ()
+          << ",\"alignment\":" << tls[7]->value ()
+          << ",\"data-address\":" << tls[0]->value ()
+          << '}' << std::endl;
+    }
+
+    void
+    image::json_inlined ()
+    {
+      size_t           total;
+      size_t           total_size;
+      size_t           inlined_size;
+      dwarf::functions funcs_inlined;
+      dwarf::functions funcs_not_inlined;
+      func_counts      counts;
+
+      inlined_functions (funcs_inlined, funcs_not_inlined, counts,
+                         total, total_size, inlined_size);
+
+      auto count_compare = [](func_count const & a, func_count const & b) {
+        return a.size != b.size?  a.size < b.size : a.count > b.count;
+      };
+      std::sort (counts.begin (), counts.end (), count_compare);
+      std::reverse (counts.begin (), counts.end ());
+
+      dwarf::function_compare compare (dwarf::function_compare::fc_by_size);
+
+      std::sort (funcs_inlined.begin (), funcs_inlined.end (), compare);
+      std::reverse (funcs_inlined.begin (), funcs_inlined.end ());
+      std::sort (funcs_not_inlined.begin (), funcs_not_inlined.end (), compare);
+      std::reverse (funcs_not_inlined.begin (), funcs_not_inlined.end ());
+
+      auto json_funcs = [this] (const dwarf::functions& funcs) {
+        bool first = true;
+        for (auto& f : funcs)
+        {
+          out << (first ? "" : ",")
+              << "{\"name\":" << json_string (f.name ())
+              << ",\"size\":" << f.size ()
+              << ",\"external\":" << json_bool (f.is_external ())
+              << ",\"inline\":"
+              << json_bool (f.get_inlined () == dwarf::function::inl_inline)
+              << ",\"pc-low\":" << f.pc_low ()
+              << '}' << std::endl;
+          first = false;
+        }
+      };
+
+      out << ",\"inlined\":{\"functions\":" << funcs_inlined.size ()
+          << ",\"total-functions\":" << total
+          << ",\"total-size\":" << total_size
+          << ",\"inlined-size\":" << inlined_size
+          << ",\"repeats\":[";
+
+      bool first = true;
+      for (auto& c : counts)
+      {
+        if (c.count > 1)
+        {
+          out << (first ? "" : ",")
+              << "{\"name\":" << json_string (c.name)
+              << ",\"count\":" << c.count
+              << ",\"size\":" << c.size << '}';
+          first = false;
+        }
+      }
+
+      out << "]," << std::endl << "\"inline-functions\":[" << std::endl;
+      json_funcs (funcs_inlined);
+      out << "]," << std::endl << "\"not-inlined\":[" << std::endl;
+      json_funcs (funcs_not_inlined);
+      out << "]}" << std::endl;
+    }
+
+    void
+    image::json_symbols ()
+    {
+      const symbols::symtab* tabs[] = { &symbols.globals (),
+                                        &symbols.weaks (),
+                                        &symbols.locals () };
+
+      out << ",\"symbols\":[" << std::endl;
+
+      bool first = true;
+      for (auto tab : tabs)
+      {
+        for (auto& s : *tab)
+        {
+          const symbols::symbol& sym = *s.second;
+          out << (first ? "" : ",")
+              << "{\"name\":" << json_string (sym.name ());
+          if (sym.is_cplusplus ())
+            out << ",\"demangled\":" << json_string (sym.demangled ());
+          out << ",\"binding\":"
+              << (sym.is_global () ? "\"global\"" :
+                  sym.is_weak () ? "\"weak\"" : "\"local\"")
+              << ",\"type\":" << sym.type ()
+              << ",\"section\":" << sym.section_index ()
+              << ",\"value\":" << sym.value ()
+              << ",\"size\":" << sym.esym ().st_size
+              << '}' << std::endl;
+          first = false;
+        }
+      }
+
+      out << ']' << std::endl;
+    }
+
+    void
+    image::output_json (const report_options& opts)
+    {
+      out << "{\"exe\":" << json_string (exe.name ().full ()) << std::endl;
+
+      json_compilation_unit (opts.objects, opts.full_flags);
+      json_compilation_units ();
+      if (opts.sections)
+        json_sections ();
+      if (opts.init)
+        json_init_fini ("init", init);
+      if (opts.fini)
+        json_init_fini ("fini", fini);
+      if (opts.config)
+        json_config ();
+      if (opts.tls)
+        json_tls ();
+      if (opts.inlined)
+        json_inlined ();
+      if (opts.map)
+        json_symbols ();
+
+      out << '}';
+    }
+
+    /**
+     * The report of an executable. An error is reported in the order of the
+     * executables and does not stop the other executables.
+     */
+    struct report
+    {
+      std::string output;
+      std::string error;
+      bool        done;
+
+      report ()
+        : done (false) {
+      }
+    };
+
+    static void
+    report_image (const std::string&    exe_name,
+                  const report_options& opts,
+                  unsigned int          jobs,
+                  report&               rep)
+    {
+      std::ostringstream out;
+
+      try
+      {
+        if (rld::verbose ())
+          std::cout << "exe-image: " << exe_name << std::endl;
+
+        /*
+         * Open the executable and read the symbols.
+         */
+        image exe (exe_name, out,
+                   opts.inlined || opts.json, opts.dwarf_data, jobs, opts.json);
+
+        if (opts.json)
+        {
+          exe.output_json (opts);
+          rep.output = out.str ();
+          return;
+        }
+
+        out << "exe: " << exe.exe.name ().full () << std::endl
+            << std::endl;
+
+        /*
+         * Generate the output.
+         */
+        exe.output_compilation_unit (opts.objects, opts.full_flags);
+        if (opts.sections)
+          exe.output_sections ();
+        if (opts.init)
+          exe.output_init ();
+        if (opts.fini)
+          exe.output_fini ();
+        if (opts.config)
+          exe.output_config ();
+        if (opts.tls)
+          exe.output_tls ();
+        if (opts.inlined)
+          exe.output_inlined ();
+        if (opts.dwarf_data)
+          exe.output_dwarf ();
+
+        /*
+         * Map ?
+         */
+        if (opts.map)
+          rld::symbols::output (out, exe.symbols);
+      }
+      catch (rld::error re)
+      {
+        rep.error = re.where + ": " + re.what;
+        if (opts.json)
+        {
+          rep.output = "{\"exe\":" + json_string (exe_name) +
+            ",\"error\":" + json_string (rep.error) + '}';
+          return;
+        }
+      }
+
+      rep.output = out.str ();
+    }
+
+    /**
+     * Report the executables on a pool of workers. The output is written in
+     * the order of the executables as each one completes. The jobs not
+     * needed for the pool load the DWARF data of an executable and compute
+     * the statistics of its compilation units. The JSON output is an object
+     * with an array of the executables' objects.
+     */
+    static bool
+    report_images (const rld::strings&   exe_names,
+                   const report_options& opts,
+                   unsigned int          jobs)
+    {
+      std::vector < report > reports (exe_names.size ());
+      unsigned int           workers = std::min (jobs, (unsigned int) exe_names.size ());
+      unsigned int           image_jobs = std::max (jobs / workers, 1U);
+      size_t                 written = 0;
+      bool                   ok = true;
+      std::mutex             lock;
+
+      auto write_reports = [&] () {
+        while (written < reports.size () && reports[written].done)
+        {
+          report& rep = reports[written];
+          if (opts.json && written > 0)
+            std::cout << ',' << std::endl;
+          std::cout << rep.output << std::flush;
+          if (!rep.error.empty ())
+          {
+            std::cerr << "error: " << rep.error << std::endl;
+            ok = false;
+          }
+          rep = report ();
+          ++written;
+        }
+      };
+
+      if (opts.json)
+        std::cout << "{\"version\":" << json_string (rld::version ())
+                  << ",\"executables\":[" << std::endl;
+
+      rld::tasks::parallel_for (exe_names.size (), workers, [&] (size_t e) {
+        report rep;
+        report_image (exe_names[e], opts, image_jobs, rep);
+        std::lock_guard < std::mutex > guard (lock);
+        reports[e] = rep;
+        reports[e].done = true;
+        write_reports ();
+      });
+
+      if (opts.json)
+        std::cout << "]}" << std::endl;
+
+      return ok;
+    }
+
+    /**
+     * The digests of an executable's loadable sections and functions by
+     * their names.
+     */
+    struct image_digests
+    {
+      std::map < std::string, uint64_t > sections;
+      std::map < std::string, uint64_t > functions;
+    };
+
+    /**
+     * A range of the executable's file to hash.
+     */
+    struct digest_range
+    {
+      std::string name;
+      bool        function;
+      bool        nobits;
+      off_t       offset;
+      size_t      size;
+    };
+
+    static uint64_t
+    hash_range (const files::view& view, off_t offset, size_t size)
+    {
+      if ((size_t) offset > view.size () || size > view.size () - offset)
+        throw rld::error ("range outside the file", "compare");
+
+      if (view.mapped ())
+        return rld::hash::hash (view.data () + offset, size);
+
+      std::vector < uint8_t > data (size);
+      if (view.read (offset, data.data (), size) != size)
+        throw rld::error ("short read", "compare");
+      return rld::hash::hash (data.data (), size);
+    }
+
+    /**
+     * Hash the loadable sections and the function bodies of an executable.
+     * The functions are the sized function symbols located in the sections
+     * by their addresses. The ranges are hashed in parallel from the
+     * mapped file. A section with no data is its size.
+     */
+    static void
+    digest_image (const std::string& exe_name,
+                  unsigned int       jobs,
+                  image_digests&     digests)
+    {
+      elf::object_type types;
+      files::object    exe (exe_name);
+      files::sections  secs;
+      symbols::table   syms;
+
+      exe.set_object_type (types);
+      exe.open ();
+
+      std::vector < digest_range > ranges;
+
+      try
+      {
+        exe.begin ();
+
+        if (!exe.valid ())
+          throw rld::error ("Not valid: " + exe.name ().full (), "compare");
+
+        exe.get_sections (secs);
+        exe.load_symbols (syms, true);
+
+        std::vector < const files::section* > loaded;
+
+        for (auto& sec : secs)
+        {
+          if ((sec.flags & SHF_ALLOC) == 0)
+            continue;
+          digest_range r = { sec.name, false, sec.type == SHT_NOBITS,
+                             sec.offset, sec.size };
+          ranges.push_back (r);
+          if (sec.type != SHT_NOBITS && sec.size > 0)
+            loaded.push_back (&sec);
+        }
+
+        const bool thumb = exe.elf ().machinetype () == EM_ARM;
+
+        const symbols::symtab* tabs[] = { &syms.globals (),
+                                          &syms.weaks (),
+                                          &syms.locals () };
+
+        for (auto tab : tabs)
+        {
+          for (auto& s : *tab)
+          {
+            const symbols::symbol& sym = *s.second;
+            if (sym.type () != STT_FUNC || sym.esym ().st_size == 0)
+              continue;
+            uint64_t address = sym.value ();
+            if (thumb)
+              address &= ~((uint64_t) 1);
+            for (auto sec : loaded)
+            {
+              if (address >= sec->address &&
+                  address + sym.esym ().st_size <= sec->address + sec->size)
+              {
+                digest_range r = { sym.name (), true, false,
+                                   (off_t) (sec->offset + (address - sec->address)),
+                                   (size_t) sym.esym ().st_size };
+                ranges.push_back (r);
+                break;
+              }
+            }
+          }
+        }
+
+        exe.end ();
+      }
+      catch (...)
+      {
+        exe.close ();
+        throw;
+      }
+
+      exe.close ();
+
+      files::view            view (exe_name, files::view::random);
+      std::vector < uint64_t > hashes (ranges.size ());
+
+      rld::tasks::parallel_for (ranges.size (), jobs, [&] (size_t r) {
+        const digest_range& range = ranges[r];
+        if (range.nobits)
+        {
+          uint64_t size = range.size;
+          hashes[r] = rld::hash::hash (&size, sizeof (size));
+        }
+        else
+          hashes[r] = hash_range (view, range.offset, range.size);
+      });
+
+      for (size_t r = 0; r < ranges.size (); ++r)
+      {
+        if (ranges[r].function)
+          digests.functions.insert (std::make_pair (ranges[r].name, hashes[r]));
+        else
+          digests.sections.insert (std::make_pair (ranges[r].name, hashes[r]));
+      }
+    }
+
+    /**
+     * A difference between two images.
+     */
+    struct difference
+    {
+      std::string name;
+      const char* kind;   //< "differs", "only-first" or "only-second".
+    };
+    typedef std::vector < difference > differences;
+
+    static void
+    compare_digests (const std::map < std::string, uint64_t >& first,
+                     const std::map < std::string, uint64_t >& second,
+                     differences&                             diffs)
+    {
+      auto fi = first.begin ();
+      auto si = second.begin ();
+
+      while (fi != first.end () || si != second.end ())
+      {
+        if (si == second.end () || (fi != first.end () && fi->first < si->first))
+        {
+          diffs.push_back ({ fi->first, "only-first" });
+          ++fi;
+        }
+        else if (fi == first.end () || si->first < fi->first)
+        {
+          diffs.push_back ({ si->first, "only-second" });
+          ++si;
+        }
+        else
+        {
+          if (fi->second != si->second)
+            diffs.push_back ({ fi->first, "differs" });
+          ++fi;
+          ++si;
+        }
+      }
+    }
+
+    /**
+     * Compare the executables in pairs. Only the sections and functions that
+     * differ are reported. The images are hashed with all jobs one after the
+     * other.
+     *
+     * @retval 0 The pairs are the same.
+     * @retval 1 A pair differs.
+     * @retval 10 An executable could not be compared.
+     */
+    static int
+    compare_images (const rld::strings& exe_names,
+                    bool                json,
+                    unsigned int        jobs)
+    {
+      int ec = 0;
+
+      if (json)
+        std::cout << "{\"version\":" << json_string (rld::version ())
+                  << ",\"compare\":[" << std::endl;
+
+      for (size_t p = 0; p < exe_names.size (); p += 2)
+      {
+        const std::string& first = exe_names[p];
+        const std::string& second = exe_names[p + 1];
+        differences        sec_diffs;
+        differences        func_diffs;
+        std::string        error;
+
+        try
+        {
+          image_digests first_digests;
+          image_digests second_digests;
+
+          digest_image (first, jobs, first_digests);
+          digest_image (second, jobs, second_digests);
+
+          compare_digests (first_digests.sections, second_digests.sections,
+                           sec_diffs);
+          compare_digests (first_digests.functions, second_digests.functions,
+                           func_diffs);
+        }
+        catch (rld::error re)
+        {
+          error = re.where + ": " + re.what;
+        }
+
+        const bool same = error.empty () && sec_diffs.empty () && func_diffs.empty ();
+
+        if (!error.empty ())
+          ec = 10;
+        else if (!same && ec == 0)
+          ec = 1;
+
+        if (json)
+        {
+          auto json_diffs = [] (const differences& diffs) {
+            std::string js = "[";
+            for (size_t d = 0; d < diffs.size (); ++d)
+            {
+              if (d)
+                js += ',';
+              js += "{\"name\":" + json_string (diffs[d].name) +
+                ",\"diff\":\"" + diffs[d].kind + "\"}";
+            }
+            return js + ']';
+          };
+
+          std::cout << (p ? "," : "")
+                    << "{\"first\":" << json_string (first)
+                    << ",\"second\":" << json_string (second);
+          if (!error.empty ())
+            std::cout << ",\"error\":" << json_string (error);
+          else
+            std::cout << ",\"same\":" << json_bool (same)
+                      << ",\"sections\":" << json_diffs (sec_diffs)
+                      << ",\"functions\":" << json_diffs (func_diffs);
+          std::cout << '}' << std::endl;
+        }
+        else
+        {
+          std::cout << "compare: " << first << ' ' << second;
+          if (!error.empty ())
+            std::cout << ": error" << std::endl;
+          else if (same)
+            std::cout << ": same" << std::endl;
+          else
+          {
+            std::cout << ": differ: sections: " << sec_diffs.size ()
+                      << " functions: " << func_diffs.size () << std::endl;
+            for (auto& d : sec_diffs)
+              std::cout << " section: " << d.name << ": " << d.kind << std::endl;
+            for (auto& d : func_diffs)
+              std::cout << " function: " << d.name << ": " << d.kind << std::endl;
+          }
+        }
+
+        if (!error.empty ())
+          std::cerr << "error: " << error << std::endl;
+      }
+
+      if (json)
+        std::cout << "]}" << std::endl;
+
+      return ec;
     }
   }
 }
@@ -911,13 +1969,16 @@ static struct option rld_opts[] = {
   { "tls",         no_argument,            NULL,           'T' },
   { "inlined",     no_argument,            NULL,           'i' },
   { "dwarf",       no_argument,            NULL,           'D' },
+  { "json",        no_argument,            NULL,           'J' },
+  { "compare",     no_argument,            NULL,           'c' },
+  { "jobs",        required_argument,      NULL,           'j' },
   { NULL,          0,                      NULL,            0 }
 };
 
 void
 usage (int exit_code)
 {
-  std::cout << "rtems-exeinfo [options] objects" << std::endl
+  std::cout << "rtems-exeinfo [options] executables" << std::endl
             << "Options and arguments:" << std::endl
             << " -h        : help (also --help)" << std::endl
             << " -V        : print linker version number and exit (also --version)" << std::endl
@@ -933,7 +1994,15 @@ usage (int exit_code)
             << " -C        : show configuration (also --config)" << std::endl
             << " -T        : show thread local storage data (also --tls)" << std::endl
             << " -i        : show inlined code (also --inlined)" << std::endl
-            << " -D        : dump the DWARF data (also --dwarf)" << std::endl;
+            << " -D        : dump the DWARF data (also --dwarf)" << std::endl
+            << " -J        : output JSON, the DWARF data cannot be dumped and" << std::endl
+            << "             the compilation units' statistics are added (also --json)" << std::endl
+            << " -c        : compare the executables in pairs reporting the loadable" << std::endl
+            << "             sections and functions that differ, the exit code is 1" << std::endl
+            << "             if a pair differs (also --compare)" << std::endl
+            << " -j jobs   : threads used to report the executables and load the" << std::endl
+            << "             DWARF data, 0 for all cores, the default is" << std::endl
+            << "             $" RLD_TASKS_JOBS_ENV " or 1 (also --jobs)" << std::endl;
   ::exit (exit_code);
 }
 
@@ -989,24 +2058,27 @@ main (int argc, char* argv[])
 
   try
   {
-    std::string exe_name;
-    bool        map = false;
-    bool        all = false;
-    bool        sections = false;
-    bool        init = false;
-    bool        fini = false;
-    bool        objects = false;
-    bool        full_flags = false;
-    bool        config = false;
-    bool        tls = false;
-    bool        inlined = false;
-    bool        dwarf_data = false;
+    rld::strings exe_names;
+    bool         map = false;
+    bool         all = false;
+    bool         sections = false;
+    bool         init = false;
+    bool         fini = false;
+    bool         objects = false;
+    bool         full_flags = false;
+    bool         config = false;
+    bool         tls = false;
+    bool         inlined = false;
+    bool         dwarf_data = false;
+    bool         json = false;
+    bool         compare = false;
+    int          jobs = rld::tasks::default_jobs ();
 
     rld::set_cmdline (argc, argv);
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hvVMaSIFOCTiD", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hvVMaSIFOCTiDJcj:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -1067,6 +2139,18 @@ main (int argc, char* argv[])
           dwarf_data = true;
           break;
 
+        case 'J':
+          json = true;
+          break;
+
+        case 'c':
+          compare = true;
+          break;
+
+        case 'j':
+          jobs = rld::tasks::parse_jobs (optarg);
+          break;
+
         case '?':
           usage (3);
           break;
@@ -1085,8 +2169,11 @@ main (int argc, char* argv[])
     argc -= optind;
     argv += optind;
 
-    std::cout << "RTEMS Executable Info " << rld::version () << std::endl;
-    std::cout << " " << rld::get_cmdline () << std::endl;
+    if (!json && !compare)
+    {
+      std::cout << "RTEMS Executable Info " << rld::version () << std::endl;
+      std::cout << " " << rld::get_cmdline () << std::endl;
+    }
 
     /*
      * All means all types of output.
@@ -1107,49 +2194,30 @@ main (int argc, char* argv[])
      */
     if (argc == 0)
       throw rld::error ("no executable", "options");
-    if (argc > 1)
-      throw rld::error ("only a single executable", "options");
-
-    /*
-     * The name of the executable.
-     */
-    exe_name = *argv;
 
-    if (rld::verbose ())
-      std::cout << "exe-image: " << exe_name << std::endl;
+    if (json && dwarf_data && !compare)
+      throw rld::error ("the DWARF data cannot be output as JSON", "options");
 
     /*
-     * Open the executable and read the symbols.
+     * The names of the executables.
      */
-    rld::exeinfo::image exe (exe_name, inlined | dwarf_data);
+    while (argc--)
+      exe_names.push_back (*argv++);
 
-    std::cout << "exe: " << exe.exe.name ().full () << std::endl
-              << std::endl;
+    rld::exeinfo::report_options opts = { map, sections, init, fini,
+                                          objects, full_flags, config,
+                                          tls, inlined, dwarf_data, json };
 
-    /*
-     * Generate the output.
-     */
-    exe.output_compilation_unit (objects, full_flags);
-    if (sections)
-      exe.output_sections ();
-    if (init)
-      exe.output_init ();
-    if (fini)
-      exe.output_fini ();
-    if (config)
-      exe.output_config ();
-    if (tls)
-      exe.output_tls ();
-    if (inlined)
-      exe.output_inlined ();
-    if (dwarf_data)
-      exe.output_dwarf ();
+    rld::tasks::set_jobs (jobs);
 
-    /*
-     * Map ?
-     */
-    if (map)
-      rld::symbols::output (std::cout, exe.symbols);
+    if (compare)
+    {
+      if ((exe_names.size () % 2) != 0)
+        throw rld::error ("compare needs pairs of executables", "options");
+      ec = rld::exeinfo::compare_images (exe_names, json, jobs);
+    }
+    else if (!rld::exeinfo::report_images (exe_names, opts, jobs))
+      ec = 10;
   }
   catch (rld::error re)
   {
@@ -26,12 +26,15 @@
 #include "config.h"
 #endif
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include <cxxabi.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <getopt.h>
@@ -43,6 +46,9 @@
 #include <rld-process.h>
 #include <rld-resolver.h>
 #include <rld-rtems.h>
+#include <rld-tasks.h>
+
+#include <pkgconfig.h>
 
 #ifndef HAVE_KILL
 #define kill(p,s) raise(s)
@@ -71,11 +77,24 @@ static struct option rld_opts[] = {
   { "exec-prefix", required_argument,      NULL,           'E' },
   { "cflags",      required_argument,      NULL,           'c' },
   { "rap-strip",   no_argument,            NULL,           'S' },
+  { "rap-merge-strings", no_argument,      NULL,           'm' },
+  { "gc-sections", no_argument,            NULL,           'g' },
+  { "rap-compact-relocs", no_argument,     NULL,           'x' },
+  { "symbol-order", required_argument,     NULL,           'Y' },
+  { "load-address", required_argument,     NULL,           'F' },
+  { "rap-page-size", required_argument,    NULL,           'p' },
   { "rpath",       required_argument,      NULL,           'R' },
   { "runtime-lib", required_argument,      NULL,           'P' },
   { "one-file",    no_argument,            NULL,           's' },
   { "rtems",       required_argument,      NULL,           'r' },
   { "rtems-bsp",   required_argument,      NULL,           'B' },
+  { "symbol-index", required_argument,     NULL,           'I' },
+  { "open-archives", required_argument,    NULL,           'A' },
+  { "jobs",        required_argument,      NULL,           'j' },
+  { "rap-codec",   required_argument,      NULL,           'z' },
+  { "incremental", no_argument,            NULL,           'i' },
+  { "output-cache", required_argument,     NULL,           'k' },
+  { "trace-events", required_argument,     NULL,           'T' },
   { NULL,          0,                      NULL,            0 }
 };
 
@@ -116,12 +135,34 @@ usage (int exit_code)
             << " -E prefix : the RTEMS tool prefix (also --exec-prefix)" << std::endl
             << " -c cflags : C compiler flags (also --cflags)" << std::endl
             << " -S        : do not include file details (also --rap-strip)" << std::endl
+            << " -m        : merge the tails of RAP strings (also --rap-merge-strings)" << std::endl
+            << " -g        : remove the unreferenced split sections (also --gc-sections)" << std::endl
+            << " -x        : write compact RAP relocation records, needs a loader" << std::endl
+            << "             that reads RAP version 3 (also --rap-compact-relocs)" << std::endl
+            << " -Y file   : place the code in the order of the symbols in the file," << std::endl
+            << "             hottest first (also --symbol-order)" << std::endl
+            << " -F file   : apply the relocations between the RAP sections at" << std::endl
+            << "             the load addresses in the file (also --load-address)" << std::endl
+            << " -p size   : write the text and const sections uncompressed on" << std::endl
+            << "             pages of size bytes to be mapped (also --rap-page-size)" << std::endl
             << " -R        : include file paths (also --rpath)" << std::endl
             << " -P        : place objects from archives (also --runtime-lib)" << std::endl
             << " -s        : Include archive elf object files (also --one-file)" << std::endl
             << " -Wl,opts  : link compatible flags, ignored" << std::endl
             << " -r path   : RTEMS path (also --rtems)" << std::endl
             << " -B bsp    : RTEMS arch/bsp (also --rtems-bsp)" << std::endl
+            << " -I path   : archive symbol index directory (also --symbol-index)" << std::endl
+            << " -A count  : most archives held open, default is half the open" << std::endl
+            << "             file limit (also --open-archives)" << std::endl
+            << " -j jobs   : threads used to load symbols, encode relocations" << std::endl
+            << "             and compress, 0 for all cores, the default is" << std::endl
+            << "             $" RLD_TASKS_JOBS_ENV " or 1 (also --jobs)" << std::endl
+            << " -z codec  : RAP codec, none, lz77 or lz77-l2 (also --rap-codec)" << std::endl
+            << " -i        : do not relink an up to date output (also --incremental)" << std::endl
+            << " -k path   : output, compiler query and package cache directory" << std::endl
+            << "             (also --output-cache)" << std::endl
+            << " -T file   : write the time of each stage as Chrome trace" << std::endl
+            << "             events (also --trace-events)" << std::endl
             << "Output Formats:" << std::endl
             << " rap     - RTEMS application (LZ77, single image)" << std::endl
             << " elf     - ELF application (script, ELF files)" << std::endl
@@ -164,6 +205,70 @@ setup_signals (void)
 #endif
 }
 
+/*
+ * The incremental link state is held in a file next to the output. It is the
+ * command line, the working directory and the size and modification time of
+ * each input and the output. The output is up to date if the state has not
+ * changed.
+ */
+static const char* link_state_version = "rtems-ld-state 1";
+
+static std::string
+link_state_path (const std::string& output)
+{
+  return output + ".ldstate";
+}
+
+static std::string
+link_state (const std::string& output, const rld::path::paths& inputs)
+{
+  std::ostringstream state;
+  char               cwd[1024];
+
+  state << link_state_version << std::endl
+        << rld::get_cmdline () << std::endl
+        << (::getcwd (cwd, sizeof (cwd)) ? cwd : "") << std::endl;
+
+  rld::path::paths files (inputs);
+  files.push_back (output);
+
+  for (auto& f : files)
+  {
+    struct stat sb;
+    if (::stat (f.c_str (), &sb) == 0)
+      state << sb.st_size << ' ' << sb.st_mtime << ' ' << f << std::endl;
+    else
+      state << "- - " << f << std::endl;
+  }
+
+  return state.str ();
+}
+
+static bool
+link_state_current (const std::string& output, const std::string& state)
+{
+  std::ifstream in (link_state_path (output));
+  if (!in.is_open ())
+    return false;
+  std::ostringstream saved;
+  saved << in.rdbuf ();
+  return saved.str () == state;
+}
+
+static void
+link_state_save (const std::string& output, const std::string& state)
+{
+  std::string   path = link_state_path (output);
+  std::ofstream out (path, std::ios::out | std::ios::trunc);
+  out << state;
+  out.close ();
+  if (!out)
+  {
+    std::cerr << "warning: cannot write link state: " << path << std::endl;
+    ::unlink (path.c_str ());
+  }
+}
+
 int
 main (int argc, char* argv[])
 {
@@ -194,9 +299,12 @@ main (int argc, char* argv[])
     std::string          base_name;
     std::string          output_type = "rap";
     bool                 standard_libs = true;
+    int                  jobs = rld::tasks::default_jobs ();
+    rld::compress::codec codec = rld::compress::codec_lz77;
     bool                 map = false;
     bool                 warnings = false;
     bool                 one_file = false;
+    bool                 incremental = false;
 
     rld::set_cmdline (argc, argv);
 
@@ -204,7 +312,7 @@ main (int argc, char* argv[])
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hvwVMnsSb:E:o:O:L:l:c:e:d:u:C:W:R:P:r:B:", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hvwVMnsSimgxb:E:F:p:o:O:L:l:c:e:d:u:C:W:R:P:r:B:I:A:Y:j:z:k:T:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -305,6 +413,36 @@ main (int argc, char* argv[])
           rld::rap::add_obj_details = false;
           break;
 
+        case 'm':
+          rld::rap::merge_strings = true;
+          break;
+
+        case 'g':
+          rld::rap::gc_sections = true;
+          break;
+
+        case 'x':
+          rld::rap::compact_relocs = true;
+          break;
+
+        case 'Y':
+          rld::rap::load_symbol_order (optarg);
+          break;
+
+        case 'F':
+          rld::rap::load_address_map (optarg);
+          break;
+
+        case 'p':
+          {
+            long size = ::strtol (optarg, 0, 0);
+            if ((size < 16) || ((size & (size - 1)) != 0))
+              throw rld::error ("invalid page size: " + std::string (optarg),
+                                "options");
+            rld::rap::direct_page_size = size;
+          }
+          break;
+
         case 'R':
           rld::rap::rpath += optarg;
           rld::rap::rpath += '\0';
@@ -322,6 +460,42 @@ main (int argc, char* argv[])
           rtems_arch_bsp = optarg;
           break;
 
+        case 'I':
+          cache.set_index (optarg);
+          break;
+
+        case 'A':
+          {
+            long count = ::strtol (optarg, 0, 0);
+            if (count < 1)
+              throw rld::error ("invalid open archives: " + std::string (optarg),
+                                "options");
+            rld::files::set_open_archives (count);
+          }
+          break;
+
+        case 'j':
+          jobs = rld::tasks::parse_jobs (optarg);
+          break;
+
+        case 'z':
+          codec = rld::compress::find_codec (optarg);
+          break;
+
+        case 'i':
+          incremental = true;
+          break;
+
+        case 'k':
+          rld::outputter::set_output_cache (optarg);
+          rld::cc::set_query_cache (optarg);
+          pkgconfig::set_cache (optarg);
+          break;
+
+        case 'T':
+          rld::trace_events_enable (optarg);
+          break;
+
         case '?':
           usage (3);
           break;
@@ -340,6 +514,8 @@ main (int argc, char* argv[])
     argc -= optind;
     argv += optind;
 
+    rld::tasks::set_jobs (jobs);
+
     if (rld::verbose () || map)
     {
       std::cout << "RTEMS Linker " << rld::version () << std::endl;
@@ -403,12 +579,17 @@ main (int argc, char* argv[])
     /*
      * Add the object files to the cache.
      */
-    cache.add (objects);
+    {
+      rld::span span ("cache open");
+      cache.add (objects);
+      cache.open ();
+    }
 
     /*
-     * Open the cache.
+     * Only load the symbols of the archive members the link needs. A map
+     * lists all the symbols so it needs all of them loaded.
      */
-    cache.open ();
+    cache.set_armap (!map);
 
     /*
      * If the full path to CC is not provided and the exec-prefix is not set by
@@ -426,51 +607,77 @@ main (int argc, char* argv[])
     {
       if (rld::verbose ())
         std::cout << "base-image: " << base_name << std::endl;
+      rld::span span ("base image load");
       base.open ();
       base.add (base_name);
       base.load_symbols (base_symbols, true);
     }
 
-    /*
-     * Get the standard library paths
-     */
-    if (standard_libs)
-      rld::cc::get_standard_libpaths (libpaths);
+    {
+      rld::span span ("libraries");
 
-    /*
-     * Get the command line libraries.
-     */
-    rld::files::find_libraries (libraries, libpaths, libs);
+      /*
+       * Get the standard library paths
+       */
+      if (standard_libs)
+        rld::cc::get_standard_libpaths (libpaths);
 
-    /*
-     * Are we to load standard libraries ?
-     */
-    if (standard_libs)
-      rld::cc::get_standard_libs (libraries, libpaths);
+      /*
+       * Get the command line libraries.
+       */
+      rld::files::find_libraries (libraries, libpaths, libs);
+
+      /*
+       * Are we to load standard libraries ?
+       */
+      if (standard_libs)
+        rld::cc::get_standard_libs (libraries, libpaths);
+
+      /*
+       * Load the library to the cache.
+       */
+      cache.add_libraries (libraries);
+    }
 
     /*
-     * Load the library to the cache.
+     * If incremental and the inputs and output have not changed since the
+     * last link there is nothing to do.
      */
-    cache.add_libraries (libraries);
+    rld::path::paths link_inputs;
+    if (incremental)
+    {
+      link_inputs = objects;
+      link_inputs.insert (link_inputs.end (),
+                          libraries.begin (), libraries.end ());
+      if (!base_name.empty ())
+        link_inputs.push_back (base_name);
+      if (!outra.empty ())
+        link_inputs.push_back (outra);
+      if (link_state_current (output, link_state (output, link_inputs)))
+      {
+        if (rld::verbose ())
+          std::cout << "output up to date: " << output << std::endl;
+        return 0;
+      }
+      ::unlink (link_state_path (output).c_str ());
+    }
 
     /*
-     * Begin the archive session. This opens the archives and leaves them open
-     * while we the symbol table is being used. The symbols reference object
-     * files and the object files may reference archives and it is assumed they
-     * are open and available. It is also assumed the number of library
-     * archives being managed is less than the maximum file handles this
-     * process can have open at any one time. If this is not the case this
-     * approach would need to be reconsidered and the overhead of opening and
-     * closing archives added.
+     * The archive session. An archive is opened when one of its members is
+     * first used and left open while the symbol table is being used. The
+     * symbols reference object files and the object files may reference
+     * archives. An archive with a symbol table that provides nothing does
+     * not hold a file handle.
      */
     try
     {
-      cache.archives_begin ();
-
       /*
        * Load the symbol table.
        */
-      cache.load_symbols (symbols);
+      {
+        rld::span span ("symbol load");
+        cache.load_symbols (symbols, false, jobs);
+      }
 
       /*
        * Map ?
@@ -489,8 +696,13 @@ main (int argc, char* argv[])
          * structure.
          */
         rld::files::object_list dependents;
-        rld::resolver::resolve (dependents, cache,
-                                base_symbols, symbols, undefined);
+        {
+          rld::span span ("resolve");
+          rld::resolver::resolve (dependents, cache,
+                                  base_symbols, symbols, undefined);
+        }
+
+        rld::span output_span ("write " + output_type);
 
         /**
          * Output the file.
@@ -506,7 +718,7 @@ main (int argc, char* argv[])
         {
           rld::outputter::rap_application (output, entry, exit,
                                            dependents, cache, symbols,
-                                           one_file);
+                                           one_file, jobs, codec);
           if (!outra.empty ())
           {
             rld::path::paths ra_libs;
@@ -523,6 +735,7 @@ main (int argc, char* argv[])
               cachera.archives_begin ();
             }
 
+            rld::span ra_span ("write ra");
             rld::outputter::archivera (outra, dependents, cachera,
                                        !ra_exist, false);
           }
@@ -537,6 +750,9 @@ main (int argc, char* argv[])
         {
           rld::warn_unused_externals (dependents);
         }
+
+        if (incremental)
+          link_state_save (output, link_state (output, link_inputs));
       }
     }
     catch (...)
@@ -546,6 +762,8 @@ main (int argc, char* argv[])
     }
 
     cache.archives_end ();
+
+    rld::trace_events_write ();
   }
   catch (rld::error re)
   {
@@ -44,6 +44,8 @@
 #include <rld-resolver.h>
 #include <rld-rtems.h>
 
+#include <pkgconfig.h>
+
 #ifndef HAVE_KILL
 #define kill(p,s) raise(s)
 #endif
@@ -66,10 +68,17 @@ static struct option rld_opts[] = {
   { "march",       required_argument,      NULL,           'a' },
   { "mcpu",        required_argument,      NULL,           'c' },
   { "rap-strip",   no_argument,            NULL,           'S' },
+  { "rap-merge-strings", no_argument,      NULL,           'm' },
+  { "gc-sections", no_argument,            NULL,           'g' },
+  { "rap-compact-relocs", no_argument,     NULL,           'x' },
   { "rpath",       required_argument,      NULL,           'R' },
   { "add-rap",     required_argument,      NULL,           'A' },
   { "replace-rap", required_argument,      NULL,           'r' },
   { "delete-rap",  required_argument,      NULL,           'd' },
+  { "update",      no_argument,            NULL,           'u' },
+  { "symbol-index", required_argument,     NULL,           'I' },
+  { "output-cache", required_argument,     NULL,           'k' },
+  { "trace-events", required_argument,     NULL,           'T' },
   { NULL,          0,                      NULL,            0 }
 };
 
@@ -102,10 +111,20 @@ usage (int exit_code)
             << " -E prefix : the RTEMS tool prefix (also --exec-prefix)" << std::endl
             << " -c cflags : C compiler flags (also --cflags)" << std::endl
             << " -S        : do not include file details (also --rap-strip)" << std::endl
+            << " -m        : merge the tails of RAP strings (also --rap-merge-strings)" << std::endl
+            << " -g        : remove the unreferenced split sections (also --gc-sections)" << std::endl
+            << " -x        : write compact RAP relocation records, needs a loader" << std::endl
+            << "             that reads RAP version 3 (also --rap-compact-relocs)" << std::endl
             << " -R        : include file paths (also --rpath)" << std::endl
             << " -A        : Add rap files (also --Add-rap)" << std::endl
             << " -r        : replace rap files (also --replace-rap)" << std::endl
             << " -d        : delete rap files (also --delete-rap)" << std::endl
+            << " -u        : update the ra file in place (also --update)" << std::endl
+            << " -I path   : archive symbol index directory (also --symbol-index)" << std::endl
+            << " -k path   : output, compiler query and package cache directory" << std::endl
+            << "             (also --output-cache)" << std::endl
+            << " -T file   : write the time of each stage as Chrome trace" << std::endl
+            << "             events (also --trace-events)" << std::endl
             << " -Wl,opts  : link compatible flags, ignored" << std::endl
             << "Output Formats:" << std::endl
             << " ra      - RTEMS archive container of rap files" << std::endl;
@@ -167,8 +186,10 @@ main (int argc, char* argv[])
     std::string             exit;
     std::string             output_path = "./";
     std::string             output = "a.ra";
+    std::string             symbol_index;
     bool                    standard_libs = true;
     bool                    convert = true;
+    bool                    update = false;
     rld::files::object_list dependents;
 
     libpaths.push_back (".");
@@ -176,7 +197,7 @@ main (int argc, char* argv[])
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hVvnSa:p:L:l:o:C:E:c:R:W:A:r:d:", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hVvnSmgxua:p:L:l:o:C:E:c:R:W:A:r:d:I:k:T:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -221,6 +242,13 @@ main (int argc, char* argv[])
           convert = false;
           break;
 
+        case 'u':
+          /*
+           * Update the ra file in place.
+           */
+          update = true;
+          break;
+
         case 'L':
           if ((optarg[::strlen (optarg) - 1] == '/') ||
               (optarg[::strlen (optarg) - 1] == '\\'))
@@ -261,6 +289,18 @@ main (int argc, char* argv[])
           rld::rap::add_obj_details = false;
           break;
 
+        case 'm':
+          rld::rap::merge_strings = true;
+          break;
+
+        case 'g':
+          rld::rap::gc_sections = true;
+          break;
+
+        case 'x':
+          rld::rap::compact_relocs = true;
+          break;
+
         case 'R':
           rld::rap::rpath += optarg;
           rld::rap::rpath += '\0';
@@ -270,6 +310,20 @@ main (int argc, char* argv[])
           /* ignore linker compatiable flags */
           break;
 
+        case 'I':
+          symbol_index = optarg;
+          break;
+
+        case 'k':
+          rld::outputter::set_output_cache (optarg);
+          rld::cc::set_query_cache (optarg);
+          pkgconfig::set_cache (optarg);
+          break;
+
+        case 'T':
+          rld::trace_events_enable (optarg);
+          break;
+
         case '?':
           usage (3);
           break;
@@ -303,21 +357,25 @@ main (int argc, char* argv[])
 
     if (convert)
     {
-      /*
-       * Get the standard library paths
-       */
-      if (standard_libs)
-        rld::cc::get_standard_libpaths (libpaths);
-      /*
-       * Get the command line libraries.
-       */
-      rld::files::find_libraries (libraries, libpaths, libs);
-
-      /*
-       * Are we to load standard libraries ?
-       */
-      if (standard_libs)
-        rld::cc::get_standard_libs (libraries, libpaths);
+      {
+        rld::span span ("libraries");
+
+        /*
+         * Get the standard library paths
+         */
+        if (standard_libs)
+          rld::cc::get_standard_libpaths (libpaths);
+        /*
+         * Get the command line libraries.
+         */
+        rld::files::find_libraries (libraries, libpaths, libs);
+
+        /*
+         * Are we to load standard libraries ?
+         */
+        if (standard_libs)
+          rld::cc::get_standard_libs (libraries, libpaths);
+      }
 
      /*
       * Convert ar file to ra file
@@ -328,20 +386,28 @@ main (int argc, char* argv[])
         rld::symbols::table symbols;
         rld::files::cache*  cache = new rld::files::cache ();
 
+        cache->set_index (symbol_index);
+
         library.clear ();
         library.push_back (*p);
 
-        /*
-        * Open the cache.
-        */
-        cache->open ();
+        rld::span library_span ("convert " + rld::path::basename (*p));
 
-        /*
-         * Load the library to the cache.
-         */
-        cache->add_libraries (library);
+        {
+          rld::span span ("symbol load");
+
+          /*
+          * Open the cache.
+          */
+          cache->open ();
+
+          /*
+           * Load the library to the cache.
+           */
+          cache->add_libraries (library);
 
-        cache->load_symbols (symbols);
+          cache->load_symbols (symbols);
+        }
 
         try
         {
@@ -375,6 +441,7 @@ main (int argc, char* argv[])
 
             /* Todo: include absolute name for rap_name */
 
+            rld::span span ("write " + rap_name);
             rld::outputter::rap_application (rap_name, entry, exit,
                                              dependents, *cache, symbols,
                                              true);
@@ -409,8 +476,11 @@ main (int argc, char* argv[])
 
           raname = output_path + raname;
 
-          rld::outputter::archivera (raname, dependents, cachera,
-                                     ra_exist, ra_rap);
+          {
+            rld::span span ("write ra");
+            rld::outputter::archivera (raname, dependents, cachera,
+                                       ra_exist, ra_rap);
+          }
           std::cout << "Generated: " << raname << std::endl;
 
 
@@ -577,14 +647,19 @@ main (int argc, char* argv[])
           else dependents.push_back (obj);
         }
 
-        rld::outputter::archivera (*pl, dependents, cachera,
-                                   true, true);
+        {
+          rld::span span ("write ra");
+          rld::outputter::archivera (*pl, dependents, cachera,
+                                     true, true, update);
+        }
         std::cout << "End" << std::endl;
 
         cache->archives_end ();
         delete cache;
       }
     }
+
+    rld::trace_events_write ();
   }
   catch (rld::error re)
   {
@@ -27,8 +27,12 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <vector>
 
 #include <cxxabi.h>
@@ -45,6 +49,7 @@
 #include <rld-process.h>
 #include <rld-rap.h>
 #include <rld-rtems.h>
+#include <rld-tasks.h>
 
 #include <rtems-utils.h>
 
@@ -71,19 +76,21 @@ namespace rap
   };
 
   /**
-   * A relocation record.
+   * A relocation record. The symbol name of a relocation with a string is
+   * held in the section's symbol names.
    */
   struct relocation
   {
     uint32_t    info;
     uint32_t    offset;
     uint32_t    addend;
-    std::string symname;
+    uint32_t    symname;
+    uint32_t    symname_size;
     off_t       rap_off;
 
     relocation ();
 
-    void output ();
+    void output (const std::string& symnames) const;
   };
 
   typedef std::vector < relocation > relocations;
@@ -108,17 +115,48 @@ namespace rap
     std::string name;
     uint32_t    size;
     uint32_t    alignment;
+    uint32_t    address;
+    uint32_t    file_off;
     uint8_t*    data;
     uint32_t    relocs_size;
     relocations relocs;
+    std::string symnames;
     bool        rela;
     off_t       rap_off;
 
     section ();
     ~section ();
 
-    void load_data (rld::compress::compressor& comp);
-    void load_relocs (rld::compress::compressor& comp);
+    /**
+     * Load the section's data. If not kept the data is skipped.
+     */
+    void load_data (rld::compress::compressor& comp, bool keep);
+
+    /**
+     * Load the data of a section mapped directly from the file. The RAP
+     * offset is the file offset.
+     */
+    void load_direct (rld::files::image& image, off_t offset, bool keep);
+
+    /**
+     * Load the section's relocation records. If not kept the records are
+     * decoded to find their end and only the number of records read is
+     * held. The compact records are in RAP version 3 files.
+     */
+    void load_relocs (rld::compress::compressor& comp, bool keep,
+                      bool compact);
+
+  private:
+    /**
+     * Load the appended symbol name of a relocation record.
+     */
+    void load_symname (rld::compress::compressor& comp, relocation& reloc,
+                       bool keep);
+
+    /**
+     * Add a loaded relocation record.
+     */
+    void add_reloc (const relocation& reloc, bool keep);
   };
 
   /**
@@ -169,11 +207,28 @@ namespace rap
       rap_comp_buffer = 2 * 1024
     };
 
+    /**
+     * The parts of the file to load. The header, machine, layout sizes and
+     * details are always loaded. The RAP image is a stream so loading a part
+     * decompresses the parts before it; they are skipped and not held.
+     */
+    enum {
+      load_sections = 1 << 0, /**< The section data. */
+      load_strtab   = 1 << 1, /**< The string table. */
+      load_symtab   = 1 << 2, /**< The symbol table. */
+      load_relocs   = 1 << 3, /**< The relocation records. */
+      load_layout   = 1 << 4, /**< The offsets of the parts and the number
+                               *   of relocation records. */
+      load_all      = (load_sections | load_strtab | load_symtab |
+                       load_relocs | load_layout)
+    };
+
     std::string header;
     size_t      rhdr_len;
     uint32_t    rhdr_length;
     uint32_t    rhdr_version;
     std::string rhdr_compression;
+    uint32_t    page_size;
     uint32_t    rhdr_checksum;
 
     off_t       machine_rap_off;
@@ -198,6 +253,10 @@ namespace rap
     off_t       relocs_rap_off;
     uint32_t    relocs_size; /* not used */
 
+    size_t      image_compressed; /* The compressed image read by a load
+                                   * of the relocations. */
+    size_t      image_trailing;   /* Any data after the relocations. */
+
     off_t       detail_rap_off;
     uint32_t    obj_num;
     uint8_t**   obj_name;
@@ -205,6 +264,7 @@ namespace rap
     uint8_t*    rpath;
     uint32_t    rpathlen;
     uint8_t*    str_detail;
+    uint32_t    str_detail_size;
     section_details sec_details;
 
     section     secs[rld::rap::rap_secs];
@@ -226,8 +286,10 @@ namespace rap
 
     /**
      * Load the file.
+     *
+     * @param parts The parts of the file to load.
      */
-    void load ();
+    void load (int parts = load_all);
 
     /**
      * Expand the image.
@@ -239,6 +301,11 @@ namespace rap
      */
     void load_details(rld::compress::compressor& comp);
 
+    /**
+     * The codec named in the header.
+     */
+    rld::compress::codec codec () const;
+
     /**
      * The name.
      */
@@ -284,24 +351,29 @@ namespace rap
     : info (0),
       offset (0),
       addend (0),
+      symname (0),
+      symname_size (0),
       rap_off (0)
   {
   }
 
   void
-  relocation::output ()
+  relocation::output (const std::string& symnames) const
   {
     std::cout << std::hex << std::setfill ('0')
               << "0x" << std::setw (8) << info
               << " 0x" << std::setw (8) << offset
               << " 0x" << std::setw(8) << addend
               << std::dec << std::setfill (' ')
-              << " " << symname;
+              << " ";
+    std::cout.write (symnames.data () + symname, symname_size);
   }
 
   section::section ()
     : size (0),
       alignment (0),
+      address (RAP_ADDRESS_NONE),
+      file_off (RAP_OFFSET_NONE),
       data (0),
       relocs_size (0),
       relocs (0),
@@ -317,11 +389,17 @@ namespace rap
   }
 
   void
-  section::load_data (rld::compress::compressor& comp)
+  section::load_data (rld::compress::compressor& comp, bool keep)
   {
     rap_off = comp.offset ();
     if (size)
     {
+      if (!keep)
+      {
+        if (comp.skip (size) != size)
+          throw rld::error ("Reading section data failed", "rapper");
+        return;
+      }
       data = new uint8_t[size];
       if (comp.read (data, size) != size)
         throw rld::error ("Reading section data failed", "rapper");
@@ -329,41 +407,156 @@ namespace rap
   }
 
   void
-  section::load_relocs (rld::compress::compressor& comp)
+  section::load_direct (rld::files::image& image, off_t offset, bool keep)
+  {
+    rap_off = offset;
+    if (size && keep)
+    {
+      data = new uint8_t[size];
+      if (!image.seek_read (offset, data, size))
+        throw rld::error ("Reading direct section data failed", "rapper");
+    }
+  }
+
+  void
+  section::load_symname (rld::compress::compressor& comp,
+                         relocation&                reloc,
+                         bool                       keep)
+  {
+    if (((reloc.info & RAP_RELOC_STRING) != 0) &&
+        ((reloc.info & RAP_RELOC_STRING_EMBED) == 0))
+    {
+      size_t symname_size = (reloc.info & ~(3 << 30)) >> 8;
+      size_t symname_read;
+      if (keep)
+      {
+        reloc.symname = symnames.size ();
+        reloc.symname_size = symname_size;
+        symnames.resize (symnames.size () + symname_size);
+        symname_read = comp.read (&symnames[reloc.symname], symname_size);
+      }
+      else
+      {
+        symname_read = comp.skip (symname_size);
+      }
+      if (symname_read != symname_size)
+        throw rld::error ("Reading reloc symbol name failed", "rapper");
+    }
+  }
+
+  void
+  section::add_reloc (const relocation& reloc, bool keep)
+  {
+    if (keep)
+      relocs.push_back (reloc);
+
+    ++relocs_size;
+  }
+
+  void
+  section::load_relocs (rld::compress::compressor& comp,
+                        bool                       keep,
+                        bool                       compact)
   {
     uint32_t header;
     comp >> header;
 
     rela = header & RAP_RELOC_RELA ? true : false;
-    relocs_size = header & ~RAP_RELOC_RELA;
 
-    if (relocs_size)
+    uint32_t count = header & ~RAP_RELOC_RELA;
+
+    if (count)
     {
-      for (uint32_t r = 0; r < relocs_size; ++r)
+      if (keep)
+        relocs.reserve (count);
+
+      if (compact)
       {
-        relocation reloc;
+        uint32_t r = 0;
+
+        while (r < count)
+        {
+          relocation reloc;
+          uint32_t   group;
 
-        reloc.rap_off = comp.offset ();
+          reloc.rap_off = comp.offset ();
 
-        comp >> reloc.info
-             >> reloc.offset;
+          comp >> reloc.info
+               >> group;
 
-        if (((reloc.info & RAP_RELOC_STRING) == 0) || rela)
-          comp >> reloc.addend;
+          uint32_t records = group & RAP_RELOC_GROUP_COUNT;
 
-        if ((reloc.info & RAP_RELOC_STRING) != 0)
-        {
-          if ((reloc.info & RAP_RELOC_STRING_EMBED) == 0)
+          if ((records == 0) || (records > (count - r)))
+            throw rld::error ("Invalid relocation group", "rapper");
+
+          load_symname (comp, reloc, keep);
+
+          if ((group & RAP_RELOC_GROUP_BITMAP) != 0)
           {
-            size_t symname_size = (reloc.info & ~(3 << 30)) >> 8;
-            reloc.symname.resize (symname_size);
-            size_t symname_read = comp.read ((void*) reloc.symname.c_str (), symname_size);
-            if (symname_read != symname_size)
-              throw rld::error ("Reading reloc symbol name failed", "rapper");
+            uint32_t base = 0;
+            uint32_t loaded = 0;
+            while (loaded < records)
+            {
+              uint32_t word;
+              comp >> word;
+              if ((word & 1) == 0)
+              {
+                reloc.offset = word;
+                add_reloc (reloc, keep);
+                ++loaded;
+                base = word + sizeof (uint32_t);
+              }
+              else
+              {
+                for (uint32_t b = 1; (b < 32) && (loaded < records); ++b)
+                {
+                  if ((word & (1UL << b)) != 0)
+                  {
+                    reloc.offset = base + ((b - 1) * sizeof (uint32_t));
+                    add_reloc (reloc, keep);
+                    ++loaded;
+                  }
+                }
+                base += 31 * sizeof (uint32_t);
+              }
+            }
           }
+          else
+          {
+            uint32_t offset = 0;
+            for (uint32_t g = 0; g < records; ++g)
+            {
+              uint32_t delta;
+              comp >> delta;
+              offset += delta;
+              reloc.offset = offset;
+              if ((group & RAP_RELOC_GROUP_ADDEND) != 0)
+                comp >> reloc.addend;
+              add_reloc (reloc, keep);
+            }
+          }
+
+          r += records;
         }
+      }
+      else
+      {
+        for (uint32_t r = 0; r < count; ++r)
+        {
+          relocation reloc;
+
+          reloc.rap_off = comp.offset ();
+
+          comp >> reloc.info
+               >> reloc.offset;
 
-        relocs.push_back (reloc);
+          if (((reloc.info & RAP_RELOC_STRING) == 0) || rela)
+            comp >> reloc.addend;
+
+          load_symname (comp, reloc, keep);
+
+          add_reloc (reloc, keep);
+        }
       }
 
       std::stable_sort (relocs.begin (), relocs.end (), reloc_offset_compare ());
@@ -373,6 +566,7 @@ namespace rap
   file::file (const std::string& name, bool warnings)
     : rhdr_len (0),
       rhdr_length (0),
+      page_size (0),
       rhdr_version (0),
       rhdr_checksum (0),
       machine_rap_off (0),
@@ -390,6 +584,8 @@ namespace rap
       symtab (0),
       relocs_rap_off (0),
       relocs_size (0),
+      image_compressed (0),
+      image_trailing (0),
       detail_rap_off (0),
       obj_num (0),
       obj_name (0),
@@ -397,6 +593,7 @@ namespace rap
       rpath (0),
       rpathlen (0),
       str_detail (0),
+      str_detail_size (0),
       warnings (warnings),
       image (name)
   {
@@ -483,7 +680,12 @@ namespace rap
 
     rhdr_len = eptr - rhdr + 1;
 
-    if (warnings && (rhdr_length != image.size ()))
+    /*
+     * The directly mapped sections of version 5 follow the length.
+     */
+    if (warnings &&
+        (rhdr_version < 5 ? rhdr_length != image.size () :
+         rhdr_length > image.size ()))
       std::cout << " warning: header length does not match file size: header="
                 << rhdr_length
                 << " file-size=" << image.size ()
@@ -514,6 +716,7 @@ namespace rap
 
     /* strtable size */
     comp >> tmp;
+    str_detail_size = tmp;
     str_detail = new uint8_t[tmp];
     if (comp.read (str_detail, tmp) != tmp)
       throw rld::error ("Reading file str details error", "rapper");
@@ -539,12 +742,32 @@ namespace rap
       }
     }
   }
+  rld::compress::codec
+  file::codec () const
+  {
+    if (rhdr_compression == "NONE")
+      return rld::compress::codec_none;
+    return rld::compress::codec_lz77;
+  }
+
   void
-  file::load ()
+  file::load (int parts)
   {
+    /*
+     * The parts that have to be decompressed to reach the parts to load.
+     */
+    const int walk_relocs = load_relocs | load_layout;
+    const int walk_symtab = load_symtab | walk_relocs;
+    const int walk_strtab = load_strtab | walk_symtab;
+    const int walk_sections = load_sections | walk_strtab;
+
     image.seek (rhdr_len);
 
-    rld::compress::compressor comp (image, rap_comp_buffer, false);
+    rld::compress::compressor comp (image, rap_comp_buffer, false,
+                                    codec ());
+
+    if (rhdr_version >= 5)
+      comp.set_limit (rhdr_length - rhdr_len);
 
     /*
      * uint32_t: machinetype
@@ -598,12 +821,66 @@ namespace rap
       comp >> secs[s].size
            >> secs[s].alignment;
 
+    /*
+     * Version 4 has the fixed load addresses.
+     *
+     * uint32_t: text_address
+     * uint32_t: const_address
+     * uint32_t: ctor_address
+     * uint32_t: dtor_address
+     * uint32_t: data_address
+     * uint32_t: bss_address
+     */
+    if (rhdr_version >= 4)
+      for (int s = 0; s < rld::rap::rap_secs; ++s)
+        comp >> secs[s].address;
+
+    /*
+     * Version 5 has the page size and the offsets of the directly mapped
+     * sections from the first page after the compressed image.
+     *
+     * uint32_t: page_size
+     * uint32_t: text_offset
+     * uint32_t: const_offset
+     * uint32_t: ctor_offset
+     * uint32_t: dtor_offset
+     * uint32_t: data_offset
+     * uint32_t: bss_offset
+     */
+    if (rhdr_version >= 5)
+    {
+      comp >> page_size;
+      if ((page_size == 0) || ((page_size & (page_size - 1)) != 0))
+        throw rld::error ("Invalid page size", "rapper");
+      for (int s = 0; s < rld::rap::rap_secs; ++s)
+        comp >> secs[s].file_off;
+    }
+
+    if ((parts & walk_sections) == 0)
+      return;
+
     /*
      * Load sections.
      */
     for (int s = 0; s < rld::rap::rap_secs; ++s)
-      if (s != rld::rap::rap_bss)
-        secs[s].load_data (comp);
+    {
+      if (s == rld::rap::rap_bss)
+        continue;
+      if (secs[s].file_off != RAP_OFFSET_NONE)
+      {
+        off_t base = (rhdr_length + page_size - 1) & ~(page_size - 1);
+        secs[s].load_direct (image, base + secs[s].file_off,
+                             (parts & load_sections) != 0);
+        image.seek (rhdr_len + comp.compressed ());
+      }
+      else
+      {
+        secs[s].load_data (comp, (parts & load_sections) != 0);
+      }
+    }
+
+    if ((parts & walk_strtab) == 0)
+      return;
 
     /*
      * Load the string table.
@@ -611,28 +888,57 @@ namespace rap
     strtab_rap_off = comp.offset ();
     if (strtab_size)
     {
-      strtab = new uint8_t[strtab_size];
-      if (comp.read (strtab, strtab_size) != strtab_size)
-        throw rld::error ("Reading string table failed", "rapper");
+      if ((parts & load_strtab) == 0)
+      {
+        if (comp.skip (strtab_size) != strtab_size)
+          throw rld::error ("Reading string table failed", "rapper");
+      }
+      else
+      {
+        strtab = new uint8_t[strtab_size];
+        if (comp.read (strtab, strtab_size) != strtab_size)
+          throw rld::error ("Reading string table failed", "rapper");
+      }
     }
 
+    if ((parts & walk_symtab) == 0)
+      return;
+
     /*
      * Load the symbol table.
      */
     symtab_rap_off = comp.offset ();
     if (symtab_size)
     {
-      symtab = new uint8_t[symtab_size];
-      if (comp.read (symtab, symtab_size) != symtab_size)
-        throw rld::error ("Reading symbol table failed", "rapper");
+      if ((parts & load_symtab) == 0)
+      {
+        if (comp.skip (symtab_size) != symtab_size)
+          throw rld::error ("Reading symbol table failed", "rapper");
+      }
+      else
+      {
+        symtab = new uint8_t[symtab_size];
+        if (comp.read (symtab, symtab_size) != symtab_size)
+          throw rld::error ("Reading symbol table failed", "rapper");
+      }
     }
 
+    if ((parts & walk_relocs) == 0)
+      return;
+
     /*
      * Load the relocation tables.
      */
     relocs_rap_off = comp.offset ();
     for (int s = 0; s < rld::rap::rap_secs; ++s)
-      secs[s].load_relocs (comp);
+      secs[s].load_relocs (comp, (parts & load_relocs) != 0,
+                           rhdr_version >= 3);
+
+    /*
+     * The relocations are the last part of the image.
+     */
+    image_trailing = comp.skip (1);
+    image_compressed = comp.compressed ();
   }
 
   void
@@ -645,11 +951,16 @@ namespace rap
 
     image.seek (rhdr_len);
 
-    rld::compress::compressor comp (image, rap_comp_buffer, false);
+    rld::compress::compressor comp (image, rap_comp_buffer, false,
+                                    codec ());
+
+    if (rhdr_version >= 5)
+      comp.set_limit (rhdr_length - rhdr_len);
     rld::files::image         out (name);
 
     out.open (true);
     out.seek (0);
+
     while (true)
     {
       if (comp.read (out, rap_comp_buffer) != rap_comp_buffer)
@@ -701,6 +1012,271 @@ namespace rap
 
     throw rld::error ("Invalid string index", "string: " + name);
   }
+
+  /**
+   * The symbol name of a relocation record, empty if it has none. The name is
+   * in the string table or appended to the record.
+   */
+  static std::string
+  reloc_symbol (const file& r, const section& sec, const relocation& reloc)
+  {
+    if ((reloc.info & RAP_RELOC_STRING) == 0)
+      return "";
+    if ((reloc.info & RAP_RELOC_STRING_EMBED) == 0)
+      return sec.symnames.substr (reloc.symname, reloc.symname_size);
+    uint32_t offset = (reloc.info & ~(3 << 30)) >> 8;
+    if (offset >= r.strtab_size)
+      return "";
+    return (const char*) &r.strtab[offset];
+  }
+
+  /**
+   * The parts of a relocation record's info that do not depend on the layout
+   * of the string table.
+   */
+  static uint32_t
+  reloc_info (const relocation& reloc)
+  {
+    if ((reloc.info & RAP_RELOC_STRING) == 0)
+      return reloc.info;
+    return reloc.info & (RAP_RELOC_STRING | 0xff);
+  }
+
+  /**
+   * Verify a loaded RAP file. The image has to decompress to the length in
+   * the header and the relocation records, symbols and section details have
+   * to be inside their sections.
+   *
+   * @param r The RAP file loaded with all parts.
+   * @param out The errors and warnings.
+   * @return int The number of errors.
+   */
+  static int
+  verify (file& r, std::ostream& out)
+  {
+    int errors = 0;
+
+    auto error = [&] (const std::string& what) {
+      out << " error: " << what << std::endl;
+      ++errors;
+    };
+
+    if (r.image_trailing != 0)
+      error ("data after the relocation records");
+
+    if (r.rhdr_len + r.image_compressed != r.rhdr_length)
+    {
+      std::ostringstream what;
+      what << "header length does not match the image: header="
+           << r.rhdr_length
+           << " image=" << r.rhdr_len + r.image_compressed;
+      error (what.str ());
+    }
+
+    /*
+     * No RAP writer sets the checksum so it cannot be checked.
+     */
+    if (r.rhdr_checksum != 0)
+      out << " warning: checksum set and not checked: "
+          << std::hex << std::setfill ('0') << std::setw (8)
+          << r.rhdr_checksum << std::dec << std::setfill (' ')
+          << std::endl;
+
+    if (r.strtab_size != 0 && r.strtab[r.strtab_size - 1] != '\0')
+      error ("string table not terminated");
+
+    if ((r.symtab_size % (3 * sizeof (uint32_t))) != 0)
+      error ("symbol table size not a multiple of the symbol size");
+
+    for (int sym = 0; sym < r.symbols (); ++sym)
+    {
+      const uint8_t* entry = r.symtab + (sym * 3 * sizeof (uint32_t));
+      uint32_t       data = get_value < uint32_t > (entry);
+      uint32_t       name = get_value < uint32_t > (entry + sizeof (uint32_t));
+      uint32_t       value = get_value < uint32_t > (entry + (2 * sizeof (uint32_t)));
+      uint32_t       sec = data >> 16;
+      std::ostringstream what;
+      what << "symbol " << sym << ": ";
+      if (name >= r.strtab_size)
+        error (what.str () + "name outside the string table");
+      else if (sec >= (uint32_t) rld::rap::rap_secs)
+        error (what.str () + "invalid section");
+      else if (value > r.secs[sec].size)
+        error (what.str () + "value outside section " + r.secs[sec].name);
+    }
+
+    for (int s = 0; s < rld::rap::rap_secs; ++s)
+    {
+      const section& sec = r.secs[s];
+      for (size_t rc = 0; rc < sec.relocs.size (); ++rc)
+      {
+        const relocation&  reloc = sec.relocs[rc];
+        std::ostringstream what;
+        what << sec.name << ": reloc " << rc << ": ";
+        if (reloc.offset >= sec.size)
+          error (what.str () + "offset outside the section");
+        if (((reloc.info & RAP_RELOC_STRING) != 0) &&
+            ((reloc.info & RAP_RELOC_STRING_EMBED) != 0) &&
+            (((reloc.info & ~(3 << 30)) >> 8) >= r.strtab_size))
+          error (what.str () + "symbol name outside the string table");
+        else if (((reloc.info & RAP_RELOC_STRING) == 0) &&
+                 ((reloc.info >> 8) >= (uint32_t) rld::rap::rap_secs))
+          error (what.str () + "invalid section");
+      }
+    }
+
+    size_t details_size = 0;
+    for (uint32_t o = 0; o < r.obj_num; ++o)
+      details_size += r.sec_num[o];
+
+    if (details_size != r.sec_details.size ())
+      error ("section details do not match the object files");
+
+    if (r.str_detail_size != 0 &&
+        r.str_detail[r.str_detail_size - 1] != '\0')
+      error ("details string table not terminated");
+
+    for (auto& sd : r.sec_details)
+    {
+      std::ostringstream what;
+      what << "section detail: object " << sd.obj << ": ";
+      if (sd.name >= r.str_detail_size)
+        error (what.str () + "name outside the details string table");
+      else if (sd.id >= (uint32_t) rld::rap::rap_secs)
+        error (what.str () + "invalid section");
+      else if (sd.offset + (uint64_t) sd.size > r.secs[sd.id].size)
+        error (what.str () + "outside section " + r.secs[sd.id].name);
+    }
+
+    return errors;
+  }
+
+  /**
+   * Compare two loaded RAP files. The sections, tables and relocation records
+   * are compared by their contents so the compression and the layout of the
+   * string table can differ.
+   *
+   * @param a The first RAP file.
+   * @param b The second RAP file.
+   * @param out The differences.
+   * @return int The number of differences.
+   */
+  static int
+  compare (const file& a, const file& b, std::ostream& out)
+  {
+    int diffs = 0;
+
+    auto differ = [&] (const std::string& what) {
+      out << " differ: " << what << std::endl;
+      ++diffs;
+    };
+
+    if (a.rhdr_version != b.rhdr_version)
+      differ ("version");
+    if (a.machinetype != b.machinetype ||
+        a.datatype != b.datatype ||
+        a.class_ != b.class_)
+      differ ("machine");
+    if (a.init_off != b.init_off || a.fini_off != b.fini_off)
+      differ ("init or fini");
+
+    for (int s = 0; s < rld::rap::rap_secs; ++s)
+    {
+      const section& sa = a.secs[s];
+      const section& sb = b.secs[s];
+
+      if (sa.size != sb.size ||
+          sa.alignment != sb.alignment ||
+          sa.address != sb.address)
+      {
+        differ (sa.name + ": layout");
+        continue;
+      }
+
+      if (sa.data != 0 && sb.data != 0 &&
+          ::memcmp (sa.data, sb.data, sa.size) != 0)
+      {
+        uint32_t offset = std::mismatch (sa.data, sa.data + sa.size,
+                                         sb.data).first - sa.data;
+        std::ostringstream what;
+        what << sa.name << ": data at 0x" << std::hex << offset;
+        differ (what.str ());
+      }
+
+      if (sa.relocs.size () != sb.relocs.size () || sa.rela != sb.rela)
+      {
+        differ (sa.name + ": relocation count");
+        continue;
+      }
+
+      for (size_t rc = 0; rc < sa.relocs.size (); ++rc)
+      {
+        const relocation& ra = sa.relocs[rc];
+        const relocation& rb = sb.relocs[rc];
+        if (reloc_info (ra) != reloc_info (rb) ||
+            ra.offset != rb.offset ||
+            ra.addend != rb.addend ||
+            reloc_symbol (a, sa, ra) != reloc_symbol (b, sb, rb))
+        {
+          std::ostringstream what;
+          what << sa.name << ": reloc " << rc << " at 0x"
+               << std::hex << ra.offset;
+          differ (what.str ());
+          break;
+        }
+      }
+    }
+
+    if (a.symbols () != b.symbols ())
+      differ ("symbol count");
+    else
+    {
+      for (int sym = 0; sym < a.symbols (); ++sym)
+      {
+        const size_t   offset = sym * 3 * sizeof (uint32_t);
+        const uint8_t* ea = a.symtab + offset;
+        const uint8_t* eb = b.symtab + offset;
+        uint32_t       na = get_value < uint32_t > (ea + sizeof (uint32_t));
+        uint32_t       nb = get_value < uint32_t > (eb + sizeof (uint32_t));
+        if (get_value < uint32_t > (ea) != get_value < uint32_t > (eb) ||
+            get_value < uint32_t > (ea + (2 * sizeof (uint32_t))) !=
+            get_value < uint32_t > (eb + (2 * sizeof (uint32_t))) ||
+            na >= a.strtab_size || nb >= b.strtab_size ||
+            ::strcmp ((const char*) &a.strtab[na],
+                      (const char*) &b.strtab[nb]) != 0)
+        {
+          std::ostringstream what;
+          what << "symbol " << sym;
+          differ (what.str ());
+          break;
+        }
+      }
+    }
+
+    if (a.obj_num != b.obj_num ||
+        a.sec_details.size () != b.sec_details.size () ||
+        a.str_detail_size != b.str_detail_size ||
+        (a.str_detail_size != 0 &&
+         ::memcmp (a.str_detail, b.str_detail, a.str_detail_size) != 0))
+      differ ("details");
+    else
+    {
+      auto sda = a.sec_details.begin ();
+      auto sdb = b.sec_details.begin ();
+      for (; sda != a.sec_details.end (); ++sda, ++sdb)
+      {
+        if (sda->name != sdb->name || sda->offset != sdb->offset ||
+            sda->id != sdb->id || sda->size != sdb->size ||
+            sda->obj != sdb->obj)
+        {
+          differ ("section details");
+          break;
+        }
+      }
+    }
+
+    return diffs;
+  }
 }
 
 void
@@ -722,9 +1298,19 @@ rap_show (rld::path::paths& raps,
 
     rap::file r (*pi, warnings);
 
+    int parts = 0;
+    if (show_layout)
+      parts |= rap::file::load_layout;
+    if (show_strings)
+      parts |= rap::file::load_strtab;
+    if (show_symbols)
+      parts |= rap::file::load_strtab | rap::file::load_symtab;
+    if (show_relocs)
+      parts |= rap::file::load_relocs;
+
     try
     {
-      r.load ();
+      r.load (parts);
     }
     catch (rld::error re)
     {
@@ -767,11 +1353,11 @@ rap_show (rld::path::paths& raps,
                 << std::setfill (' ') << std::dec
                 << " (" << r.layout_rap_off << ')' << std::endl
                 << std::setw (18) << "  "
-                << "  size  align offset    " << std::endl;
+                << "  size  align offset                address" << std::endl;
       uint32_t relocs_size = 0;
       for (int s = 0; s < rld::rap::rap_secs; ++s)
       {
-        relocs_size += r.secs[s].relocs.size ();
+        relocs_size += r.secs[s].relocs_size;
         std::cout << std::setw (16) << rld::rap::section_name (s)
                   << ": " << std::setw (6) << r.secs[s].size
                   << std::setw (7)  << r.secs[s].alignment;
@@ -782,6 +1368,10 @@ rap_show (rld::path::paths& raps,
                     << " (" << r.secs[s].rap_off << ')';
         else
           std::cout << " -";
+        if (r.secs[s].address != RAP_ADDRESS_NONE)
+          std::cout << std::hex << std::setfill ('0')
+                    << " 0x" << std::setw (8) << r.secs[s].address
+                    << std::setfill (' ') << std::dec;
         std::cout << std::endl;
       }
       std::cout << std::setw (16) << "strtab" << ": "
@@ -951,7 +1541,7 @@ rap_show (rld::path::paths& raps,
           {
             rap::relocation& reloc = r.secs[s].relocs[f];
             std::cout << std::setw (16) << count++ << ": ";
-            reloc.output ();
+            reloc.output (r.secs[s].symnames);
             std::cout << std::endl;
           }
         }
@@ -971,7 +1561,7 @@ rap_overlay (rld::path::paths& raps, bool warnings)
     rap::file r (*pi, warnings);
     std::cout << r.name () << std::endl;
 
-    r.load ();
+    r.load (rap::file::load_sections | rap::file::load_relocs);
 
     for (int s = 0; s < rld::rap::rap_secs; ++s)
     {
@@ -1040,7 +1630,7 @@ rap_overlay (rld::path::paths& raps, bool warnings)
           {
             rap::relocation& reloc = r.secs[s].relocs[f];
             std::cout << std::setw (4) << count++ << ' ';
-            reloc.output ();
+            reloc.output (r.secs[s].symnames);
             std::cout << std::endl;
           }
         }
@@ -1064,6 +1654,156 @@ rap_expander (rld::path::paths& raps, bool warnings)
   }
 }
 
+/**
+ * Run the checks of the RAP files on a pool of workers. The output of a file
+ * is written in the order of the files as each one completes.
+ *
+ * @param count The number of checks.
+ * @param jobs The number of checks run at once.
+ * @param check The check writing its output and returning true if it passed.
+ * @return bool True if all the checks passed.
+ */
+static bool
+rap_run_checks (size_t                                         count,
+                unsigned int                                   jobs,
+                const std::function < bool (size_t,
+                                            std::ostream&) >& check)
+{
+  std::vector < std::string > outputs (count);
+  std::vector < bool >        done (count, false);
+  size_t                      written = 0;
+  bool                        ok = true;
+  std::mutex                  lock;
+
+  rld::tasks::parallel_for (count, jobs, [&] (size_t c) {
+    std::ostringstream out;
+    bool               passed = check (c, out);
+    std::lock_guard < std::mutex > guard (lock);
+    outputs[c] = out.str ();
+    done[c] = true;
+    if (!passed)
+      ok = false;
+    while (written < count && done[written])
+    {
+      std::cout << outputs[written] << std::flush;
+      outputs[written].clear ();
+      ++written;
+    }
+  });
+
+  return ok;
+}
+
+/**
+ * Load a RAP file for a check. An error is written to the output.
+ */
+static bool
+rap_check_load (rap::file& r, std::ostream& out)
+{
+  try
+  {
+    r.load ();
+  }
+  catch (rld::error re)
+  {
+    out << " error: " << re.where << ": " << re.what << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Verify the RAP files.
+ *
+ * @retval true All the files are valid.
+ */
+static bool
+rap_verify (rld::path::paths& raps, bool warnings, unsigned int jobs)
+{
+  return rap_run_checks (raps.size (), jobs, [&] (size_t p, std::ostream& out) {
+    std::ostringstream errors;
+    int                count = 1;
+    try
+    {
+      rap::file r (raps[p], warnings);
+      if (rap_check_load (r, errors))
+        count = rap::verify (r, errors);
+    }
+    catch (rld::error re)
+    {
+      errors << " error: " << re.where << ": " << re.what << std::endl;
+    }
+    out << "verify: " << raps[p] << ": "
+        << (count == 0 ? "ok" : "failed") << std::endl
+        << errors.str ();
+    return count == 0;
+  });
+}
+
+/**
+ * Compare the RAP files in pairs. The two files of a pair are loaded in
+ * parallel.
+ *
+ * @retval 0 The pairs are the same.
+ * @retval 1 A pair differs.
+ * @retval 10 A file could not be compared.
+ */
+static int
+rap_compare (rld::path::paths& raps, bool warnings, unsigned int jobs)
+{
+  if ((raps.size () % 2) != 0)
+    throw rld::error ("compare needs pairs of RAP files", "options");
+
+  std::atomic < bool > failed (false);
+
+  bool same = rap_run_checks (raps.size () / 2, std::max (jobs / 2, 1U),
+                              [&] (size_t p, std::ostream& out) {
+    const std::string& first = raps[p * 2];
+    const std::string& second = raps[(p * 2) + 1];
+    std::ostringstream diffs;
+    std::ostringstream errors[2];
+    bool               loaded[2] = { false, false };
+    int                count = 0;
+
+    try
+    {
+      rap::file ra (first, warnings);
+      rap::file rb (second, warnings);
+      rap::file* files[2] = { &ra, &rb };
+
+      rld::tasks::parallel_for (2, std::min (jobs, 2U), [&] (size_t f) {
+        loaded[f] = rap_check_load (*files[f], errors[f]);
+      });
+
+      if (loaded[0] && loaded[1])
+        count = rap::compare (ra, rb, diffs);
+    }
+    catch (rld::error re)
+    {
+      errors[0] << " error: " << re.where << ": " << re.what << std::endl;
+    }
+
+    const std::string error = errors[0].str () + errors[1].str ();
+
+    out << "compare: " << first << ' ' << second << ": ";
+    if (!error.empty ())
+      out << "error" << std::endl << error;
+    else if (count == 0)
+      out << "same" << std::endl;
+    else
+      out << "differ" << std::endl << diffs.str ();
+
+    if (!error.empty ())
+      failed = true;
+
+    return error.empty () && count == 0;
+  });
+
+  if (failed)
+    return 10;
+  return same ? 0 : 1;
+}
+
 /**
  * RTEMS RAP options.
  */
@@ -1081,6 +1821,9 @@ static struct option rld_opts[] = {
   { "relocs",      no_argument,            NULL,           'r' },
   { "overlay",     no_argument,            NULL,           'o' },
   { "expand",      no_argument,            NULL,           'x' },
+  { "verify",      no_argument,            NULL,           'k' },
+  { "compare",     no_argument,            NULL,           'd' },
+  { "jobs",        required_argument,      NULL,           'j' },
   { NULL,          0,                      NULL,            0 }
 };
 
@@ -1103,7 +1846,11 @@ usage (int exit_code)
             << " -r        : show relocations (also --relocs)" << std::endl
             << " -o        : linkage overlay (also --overlay)" << std::endl
             << " -x        : expand (also --expand)" << std::endl
-            << " -f        : show file details" << std::endl;
+            << " -f        : show file details" << std::endl
+            << " -k        : verify the files (also --verify)" << std::endl
+            << " -d        : compare the files in pairs (also --compare)" << std::endl
+            << " -j jobs   : files checked in parallel, 0 is the hardware threads," << std::endl
+            << "             default $" RLD_TASKS_JOBS_ENV " or 1 (also --jobs)" << std::endl;
   ::exit (exit_code);
 }
 
@@ -1162,10 +1909,13 @@ main (int argc, char* argv[])
     bool             show_details = false;
     bool             overlay = false;
     bool             expand = false;
+    bool             verify = false;
+    bool             compare = false;
+    unsigned int     jobs = rld::tasks::default_jobs ();
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hvVnaHmlsSroxf", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hvVnaHmlsSroxfkdj:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -1239,6 +1989,18 @@ main (int argc, char* argv[])
           show_details = true;
           break;
 
+        case 'k':
+          verify = true;
+          break;
+
+        case 'd':
+          compare = true;
+          break;
+
+        case 'j':
+          jobs = rld::tasks::parse_jobs (optarg);
+          break;
+
         case '?':
         case 'h':
           usage (0);
@@ -1249,6 +2011,8 @@ main (int argc, char* argv[])
     argc -= optind;
     argv += optind;
 
+    rld::tasks::set_jobs (jobs);
+
     std::cout << "RTEMS RAP " << rld::version () << std::endl << std::endl;
 
     /*
@@ -1279,6 +2043,16 @@ main (int argc, char* argv[])
 
     if (expand)
       rap_expander (raps, warnings);
+
+    if (verify && !rap_verify (raps, warnings, jobs))
+      ec = 1;
+
+    if (compare)
+    {
+      int cec = rap_compare (raps, warnings, jobs);
+      if (cec > ec)
+        ec = cec;
+    }
   }
   catch (rld::error re)
   {
@@ -0,0 +1,823 @@
+/*
+ * Copyright (c) 2011-2012, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems_rld
+ *
+ * @brief RTEMS Linker Benchmarks time the toolkit's hot paths.
+ *
+ * The compressor and the symbol table are timed with synthetic data made
+ * from a fixed seed so the runs are repeatable. Loading the symbols, resolving
+ * and writing a RAP file are timed with the objects and libraries on the
+ * command line and the DWARF loads and lookups with the executable provided.
+ * A benchmark without its inputs is reported as skipped. The results are
+ * written as JSON.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <cxxabi.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <getopt.h>
+
+#include <rld.h>
+#include <rld-compression.h>
+#include <rld-dwarf.h>
+#include <rld-files.h>
+#include <rld-process.h>
+#include <rld-rap.h>
+#include <rld-resolver.h>
+#include <rld-rtems.h>
+#include <rld-symbols.h>
+#include <rld-tasks.h>
+
+#ifndef HAVE_KILL
+#define kill(p,s) raise(s)
+#endif
+
+/**
+ * RTEMS Linker Benchmark options.
+ */
+static struct option rld_opts[] = {
+  { "help",        no_argument,            NULL,           'h' },
+  { "version",     no_argument,            NULL,           'V' },
+  { "verbose",     no_argument,            NULL,           'v' },
+  { "output",      required_argument,      NULL,           'o' },
+  { "iterations",  required_argument,      NULL,           'n' },
+  { "jobs",        required_argument,      NULL,           'j' },
+  { "entry",       required_argument,      NULL,           'e' },
+  { "exe",         required_argument,      NULL,           'x' },
+  { "rap-codec",   required_argument,      NULL,           'z' },
+  { "symbols",     required_argument,      NULL,           's' },
+  { "size",        required_argument,      NULL,           'S' },
+  { "lookups",     required_argument,      NULL,           'a' },
+  { NULL,          0,                      NULL,            0 }
+};
+
+void
+usage (int exit_code)
+{
+  std::cout << "rtems-rld-bench [options] [objects] [libraries]" << std::endl
+            << "Options and arguments:" << std::endl
+            << " -h        : help (also --help)" << std::endl
+            << " -V        : print version number and exit (also --version)" << std::endl
+            << " -v        : verbose (trace import parts), can supply multiple times" << std::endl
+            << "             to increase verbosity (also --verbose)" << std::endl
+            << " -o file   : write the JSON results to file, default stdout (also --output)" << std::endl
+            << " -n count  : iterations of each benchmark, default 5 (also --iterations)" << std::endl
+            << " -j jobs   : threads used to load symbols and compress, 0 for all" << std::endl
+            << "             cores, the default is $" RLD_TASKS_JOBS_ENV " or 1 (also --jobs)" << std::endl
+            << " -e entry  : entry point symbol to resolve, default 'rtems' (also --entry)" << std::endl
+            << " -x exe    : executable with DWARF debug information (also --exe)" << std::endl
+            << " -z codec  : codec, none, lz77 or lz77-l2 (also --rap-codec)" << std::endl
+            << " -s count  : synthetic symbols, default 100000 (also --symbols)" << std::endl
+            << " -S size   : synthetic bytes compressed, default 16M (also --size)" << std::endl
+            << " -a count  : addresses looked up in the DWARF information, default 10000" << std::endl
+            << "             (also --lookups)" << std::endl
+            << "Arguments ending in '.a' are libraries, other arguments are objects." << std::endl;
+  ::exit (exit_code);
+}
+
+static void
+fatal_signal (int signum)
+{
+  signal (signum, SIG_DFL);
+
+  rld::process::temporaries_clean_up ();
+
+  /*
+   * Get the same signal again, this time not handled, so its normal effect
+   * occurs.
+   */
+  kill (getpid (), signum);
+}
+
+static void
+setup_signals (void)
+{
+  if (signal (SIGINT, SIG_IGN) != SIG_IGN)
+    signal (SIGINT, fatal_signal);
+#ifdef SIGHUP
+  if (signal (SIGHUP, SIG_IGN) != SIG_IGN)
+    signal (SIGHUP, fatal_signal);
+#endif
+  if (signal (SIGTERM, SIG_IGN) != SIG_IGN)
+    signal (SIGTERM, fatal_signal);
+#ifdef SIGPIPE
+  if (signal (SIGPIPE, SIG_IGN) != SIG_IGN)
+    signal (SIGPIPE, fatal_signal);
+#endif
+#ifdef SIGCHLD
+  signal (SIGCHLD, SIG_DFL);
+#endif
+}
+
+/**
+ * The seed of the synthetic data.
+ */
+static const uint32_t bench_seed = 0x52544d53;
+
+/**
+ * A small fixed seed random number generator. The same sequence is generated
+ * on every host.
+ */
+class prng
+{
+public:
+  prng (uint32_t seed = bench_seed)
+    : state (seed) {
+  }
+
+  uint32_t next () {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+private:
+  uint32_t state;
+};
+
+/**
+ * The result of a benchmark.
+ */
+struct result
+{
+  std::string name;       //< The benchmark's name.
+  std::string skipped;    //< Why the benchmark was skipped, empty if run.
+  int         iterations; //< The iterations run.
+  double      total;      //< The total seconds of the timed iterations.
+  double      best;       //< The fastest iteration in seconds.
+  uint64_t    items;      //< The items processed per iteration.
+  uint64_t    bytes;      //< The bytes processed per iteration.
+  uint64_t    output;     //< The bytes output per iteration.
+
+  result (const std::string& name)
+    : name (name),
+      iterations (0),
+      total (0),
+      best (0),
+      items (0),
+      bytes (0),
+      output (0) {
+  }
+};
+
+typedef std::vector < result > results;
+
+/**
+ * Time the benchmark's body for the iterations. The setup is run before each
+ * iteration and is not timed.
+ */
+static void
+run (result&                      r,
+     int                          iterations,
+     const std::function<void ()>& setup,
+     const std::function<void ()>& body)
+{
+  typedef std::chrono::steady_clock clock;
+
+  if (rld::verbose ())
+    std::cerr << "bench: " << r.name << std::endl;
+
+  for (int i = 0; i < iterations; ++i)
+  {
+    if (setup)
+      setup ();
+    clock::time_point start = clock::now ();
+    body ();
+    std::chrono::duration<double> elapsed = clock::now () - start;
+    double seconds = elapsed.count ();
+    r.total += seconds;
+    if (i == 0 || seconds < r.best)
+      r.best = seconds;
+    ++r.iterations;
+  }
+}
+
+static std::string
+json_string (const std::string& s)
+{
+  std::string out = "\"";
+  for (auto c : s)
+  {
+    switch (c)
+    {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        if ((unsigned char) c < 0x20)
+        {
+          char hex[8];
+          ::snprintf (hex, sizeof (hex), "\\u%04x", c);
+          out += hex;
+        }
+        else
+          out += c;
+        break;
+    }
+  }
+  return out + '"';
+}
+
+static void
+output_json (std::ostream& out, const results& rs)
+{
+  out << std::setprecision (9)
+      << "{" << std::endl
+      << "  \"version\": " << json_string (rld::version ()) << ',' << std::endl
+      << "  \"benchmarks\": [";
+  for (results::const_iterator ri = rs.begin (); ri != rs.end (); ++ri)
+  {
+    const result& r = *ri;
+    out << (ri == rs.begin () ? "" : ",") << std::endl
+        << "    { \"name\": " << json_string (r.name);
+    if (!r.skipped.empty ())
+    {
+      out << ", \"skipped\": " << json_string (r.skipped) << " }";
+      continue;
+    }
+    double mean = r.iterations ? r.total / r.iterations : 0;
+    out << ", \"iterations\": " << r.iterations
+        << ", \"seconds\": " << r.total
+        << ", \"mean\": " << mean
+        << ", \"best\": " << r.best
+        << ", \"items\": " << r.items
+        << ", \"bytes\": " << r.bytes
+        << ", \"output\": " << r.output;
+    if (r.best > 0)
+    {
+      if (r.items)
+        out << ", \"items_per_second\": " << (r.items / r.best);
+      if (r.bytes)
+        out << ", \"bytes_per_second\": " << (r.bytes / r.best);
+    }
+    out << " }";
+  }
+  out << std::endl
+      << "  ]" << std::endl
+      << "}" << std::endl;
+}
+
+/*
+ * Synthetic data that compresses like an image. It is runs of random words
+ * taken from a small dictionary with random bytes mixed in.
+ */
+static void
+synthetic_data (std::vector < uint8_t >& data, size_t size)
+{
+  prng                   rand;
+  std::vector < uint32_t > words (256);
+  for (auto& w : words)
+    w = rand.next ();
+  data.resize (size);
+  size_t d = 0;
+  while (d < size)
+  {
+    uint32_t r = rand.next ();
+    uint32_t value = (r & 0x30) == 0 ? rand.next () : words[r >> 24];
+    for (int b = 0; b < 4 && d < size; ++b, ++d)
+      data[d] = value >> (b * 8);
+  }
+}
+
+static void
+bench_compressor (results&             rs,
+                  int                  iterations,
+                  size_t               size,
+                  rld::compress::codec codec,
+                  unsigned int         jobs)
+{
+  std::vector < uint8_t > data;
+  std::vector < uint8_t > check (size);
+  rld::process::tempfile  tmp (".rldbench");
+  rld::files::image       image (tmp.name ());
+  size_t                  compressed = 0;
+
+  synthetic_data (data, size);
+
+  result compress ("compress::compressor::write");
+  compress.bytes = size;
+  run (compress, iterations,
+       [&] () {
+         image.open (true);
+       },
+       [&] () {
+         rld::compress::compressor comp (image, 2 * 1024, true, codec, jobs);
+         comp.write (data.data (), data.size ());
+         comp.flush ();
+         compressed = comp.compressed ();
+         image.close ();
+       });
+  compress.output = compressed;
+  rs.push_back (compress);
+
+  result decompress ("compress::compressor::read");
+  decompress.bytes = size;
+  run (decompress, iterations,
+       [&] () {
+         image.open ();
+       },
+       [&] () {
+         rld::compress::compressor comp (image, 2 * 1024, false, codec);
+         size_t in = comp.read (check.data (), check.size ());
+         image.close ();
+         if (in != size || check != data)
+           throw rld::error ("decompressed data does not match", "bench:compressor");
+       });
+  rs.push_back (decompress);
+}
+
+static void
+bench_symbols (results& rs, int iterations, size_t count)
+{
+  rld::symbols::bucket     syms;
+  std::vector < std::string > names;
+  prng                     rand;
+
+  names.reserve (count);
+  for (size_t s = 0; s < count; ++s)
+  {
+    std::ostringstream name;
+    name << "rtems_bench_" << std::hex << rand.next () << '_' << s;
+    names.push_back (name.str ());
+    syms.push_back (rld::symbols::symbol (names.back (), s * 16));
+  }
+
+  /*
+   * Look the names up in a random order with a miss every eighth lookup.
+   */
+  std::vector < std::string > lookups;
+  lookups.reserve (count);
+  for (size_t s = 0; s < count; ++s)
+  {
+    uint32_t r = rand.next ();
+    if ((r & 7) == 0)
+      lookups.push_back (names[r % count] + "_miss");
+    else
+      lookups.push_back (names[r % count]);
+  }
+
+  rld::symbols::table* table = nullptr;
+
+  result add ("symbols::table::add_global");
+  add.items = count;
+  run (add, iterations,
+       [&] () {
+         delete table;
+         table = new rld::symbols::table;
+       },
+       [&] () {
+         for (auto& sym : syms)
+           table->add_global (sym);
+       });
+  rs.push_back (add);
+
+  size_t found = 0;
+  result find ("symbols::table::find_global");
+  find.items = count;
+  run (find, iterations,
+       nullptr,
+       [&] () {
+         found = 0;
+         for (auto& name : lookups)
+           if (table->find_global (name) != nullptr)
+             ++found;
+       });
+  rs.push_back (find);
+
+  delete table;
+
+  if (rld::verbose ())
+    std::cerr << "bench: symbols found: " << found << std::endl;
+}
+
+/*
+ * The inputs of a link, the cache is opened and the archives begun.
+ */
+struct link_inputs
+{
+  rld::files::cache    cache;
+  rld::symbols::table  base_symbols;
+  rld::symbols::table  symbols;
+  rld::symbols::symtab undefined;
+  rld::symbols::bucket undefines;
+
+  link_inputs (rld::path::paths&  objects,
+               rld::path::paths&  libraries,
+               const std::string& entry)
+  {
+    cache.add (objects);
+    cache.open ();
+    cache.add_libraries (libraries);
+    cache.archives_begin ();
+    undefines.push_back (rld::symbols::symbol (entry));
+    rld::symbols::load (undefines, undefined);
+  }
+
+  ~link_inputs ()
+  {
+    cache.archives_end ();
+  }
+};
+
+static void
+bench_link (results&             rs,
+            int                  iterations,
+            rld::path::paths&    objects,
+            rld::path::paths&    libraries,
+            const std::string&   entry,
+            rld::compress::codec codec,
+            unsigned int         jobs)
+{
+  result load ("files::cache::load_symbols");
+  result resolve ("resolver::resolve");
+  result rap ("rap::write");
+
+  if (objects.empty () && libraries.empty ())
+  {
+    load.skipped = resolve.skipped = rap.skipped = "no objects or libraries";
+    rs.push_back (load);
+    rs.push_back (resolve);
+    rs.push_back (rap);
+    return;
+  }
+
+  link_inputs* inputs = nullptr;
+
+  run (load, iterations,
+       [&] () {
+         delete inputs;
+         inputs = new link_inputs (objects, libraries, entry);
+       },
+       [&] () {
+         inputs->cache.load_symbols (inputs->symbols, false, jobs);
+       });
+  load.items = inputs->symbols.size ();
+  rs.push_back (load);
+
+  rld::files::object_list dependents;
+
+  if (objects.empty ())
+    resolve.skipped = rap.skipped = "no objects";
+  else
+  {
+    run (resolve, iterations,
+         [&] () {
+           delete inputs;
+           inputs = new link_inputs (objects, libraries, entry);
+           inputs->cache.load_symbols (inputs->symbols, false, jobs);
+           dependents.clear ();
+         },
+         [&] () {
+           rld::resolver::resolve (dependents, inputs->cache,
+                                   inputs->base_symbols, inputs->symbols,
+                                   inputs->undefined);
+         });
+    resolve.items = dependents.size ();
+
+    rld::files::object_list linked;
+    inputs->cache.get_objects (linked);
+    linked.merge (dependents);
+    linked.sort ();
+    linked.unique ();
+
+    rld::process::tempfile tmp (".rap");
+    rld::files::image      app (tmp.name ());
+
+    run (rap, iterations,
+         [&] () {
+           app.open (true);
+         },
+         [&] () {
+           rld::rap::write (app, entry, "", linked, inputs->symbols,
+                            jobs, codec);
+           app.close ();
+         });
+    rap.items = linked.size ();
+    struct stat sb;
+    if (::stat (tmp.name ().c_str (), &sb) == 0)
+      rap.output = sb.st_size;
+  }
+
+  rs.push_back (resolve);
+  rs.push_back (rap);
+
+  delete inputs;
+}
+
+static void
+bench_dwarf (results&           rs,
+             int                iterations,
+             const std::string& exe_name,
+             size_t             count,
+             unsigned int       jobs)
+{
+  result load ("dwarf::file::load_debug");
+  result lazy ("dwarf::file::load_debug (lazy)");
+  result source ("dwarf::file::get_source");
+  result sources ("dwarf::file::get_sources");
+
+  if (exe_name.empty ())
+  {
+    load.skipped = lazy.skipped = source.skipped = sources.skipped =
+      "no executable";
+    rs.push_back (load);
+    rs.push_back (lazy);
+    rs.push_back (source);
+    rs.push_back (sources);
+    return;
+  }
+
+  rld::files::object exe (exe_name);
+
+  exe.open ();
+  exe.begin ();
+
+  try
+  {
+    /*
+     * Sample the addresses across the executable sections.
+     */
+    rld::elf::sections secs;
+    exe.elf ().get_sections (secs, SHT_PROGBITS);
+    std::vector < rld::dwarf::dwarf_address > text;
+    for (auto sec : secs)
+      if ((sec->flags () & SHF_EXECINSTR) != 0 && sec->size () != 0)
+        for (size_t a = 0; a < sec->size (); a += 4)
+          text.push_back (sec->address () + a);
+    if (text.empty ())
+      throw rld::error ("no executable sections", "bench:dwarf: " + exe_name);
+
+    prng rand;
+    std::vector < rld::dwarf::dwarf_address > addresses;
+    addresses.reserve (count);
+    for (size_t a = 0; a < count; ++a)
+      addresses.push_back (text[rand.next () % text.size ()]);
+
+    rld::dwarf::file* debug = nullptr;
+
+    run (load, iterations,
+         [&] () {
+           delete debug;
+           debug = new rld::dwarf::file;
+           debug->begin (exe.elf ());
+         },
+         [&] () {
+           debug->load_debug (false, jobs);
+         });
+    rs.push_back (load);
+
+    run (lazy, iterations,
+         [&] () {
+           delete debug;
+           debug = new rld::dwarf::file;
+           debug->begin (exe.elf ());
+         },
+         [&] () {
+           debug->load_debug (true);
+         });
+    rs.push_back (lazy);
+
+    delete debug;
+    debug = new rld::dwarf::file;
+    debug->begin (exe.elf ());
+    debug->load_debug (false, jobs);
+
+    size_t found = 0;
+    source.items = count;
+    run (source, iterations,
+         nullptr,
+         [&] () {
+           std::string file;
+           int         line;
+           found = 0;
+           for (auto address : addresses)
+             if (debug->get_source (address, file, line))
+               ++found;
+         });
+    rs.push_back (source);
+
+    rld::dwarf::source_lookups lookups;
+    sources.items = count;
+    run (sources, iterations,
+         [&] () {
+           lookups.clear ();
+           for (auto address : addresses)
+             lookups.push_back (rld::dwarf::source_lookup (address));
+         },
+         [&] () {
+           debug->get_sources (lookups);
+         });
+    rs.push_back (sources);
+
+    debug->end ();
+    delete debug;
+
+    if (rld::verbose ())
+      std::cerr << "bench: sources found: " << found << std::endl;
+  }
+  catch (...)
+  {
+    exe.end ();
+    throw;
+  }
+
+  exe.end ();
+}
+
+int
+main (int argc, char* argv[])
+{
+  int ec = 0;
+
+  setup_signals ();
+
+  try
+  {
+    rld::path::paths     objects;
+    rld::path::paths     libraries;
+    results              rs;
+    std::string          output;
+    std::string          entry = "rtems";
+    std::string          exe_name;
+    int                  iterations = 5;
+    int                  jobs = rld::tasks::default_jobs ();
+    size_t               symbol_count = 100000;
+    size_t               size = 16 * 1024 * 1024;
+    size_t               lookups = 10000;
+    rld::compress::codec codec = rld::compress::codec_lz77;
+
+    rld::set_cmdline (argc, argv);
+
+    while (true)
+    {
+      int opt = ::getopt_long (argc, argv, "hvVo:n:j:e:x:z:s:S:a:", rld_opts, NULL);
+      if (opt < 0)
+        break;
+
+      switch (opt)
+      {
+        case 'V':
+          std::cout << "rtems-rld-bench (RTEMS Linker Benchmarks) " << rld::version ()
+                    << ", RTEMS revision " << rld::rtems::version ()
+                    << std::endl;
+          ::exit (0);
+          break;
+
+        case 'v':
+          rld::verbose_inc ();
+          break;
+
+        case 'o':
+          output = optarg;
+          break;
+
+        case 'n':
+          iterations = ::strtoul (optarg, 0, 0);
+          break;
+
+        case 'j':
+          jobs = rld::tasks::parse_jobs (optarg);
+          break;
+
+        case 'e':
+          entry = optarg;
+          break;
+
+        case 'x':
+          exe_name = optarg;
+          break;
+
+        case 'z':
+          codec = rld::compress::find_codec (optarg);
+          break;
+
+        case 's':
+          symbol_count = ::strtoul (optarg, 0, 0);
+          break;
+
+        case 'S':
+          size = ::strtoul (optarg, 0, 0);
+          break;
+
+        case 'a':
+          lookups = ::strtoul (optarg, 0, 0);
+          break;
+
+        case '?':
+          usage (3);
+          break;
+
+        case 'h':
+          usage (0);
+          break;
+      }
+    }
+
+    if (iterations < 1)
+      throw rld::error ("invalid iterations", "options");
+    if (jobs < 1)
+      throw rld::error ("invalid jobs", "options");
+    if (symbol_count == 0 || size == 0 || lookups == 0)
+      throw rld::error ("invalid synthetic data size", "options");
+
+    argc -= optind;
+    argv += optind;
+
+    rld::tasks::set_jobs (jobs);
+
+    while (argc--)
+    {
+      std::string arg = *argv++;
+      if (arg.size () > 2 && arg.compare (arg.size () - 2, 2, ".a") == 0)
+        libraries.push_back (arg);
+      else
+        objects.push_back (arg);
+    }
+
+    bench_compressor (rs, iterations, size, codec, jobs);
+    bench_symbols (rs, iterations, symbol_count);
+    bench_link (rs, iterations, objects, libraries, entry, codec, jobs);
+    bench_dwarf (rs, iterations, exe_name, lookups, jobs);
+
+    if (output.empty ())
+      output_json (std::cout, rs);
+    else
+    {
+      std::ofstream out (output, std::ios::out | std::ios::trunc);
+      output_json (out, rs);
+      out.close ();
+      if (!out)
+        throw rld::error ("cannot write results", "output: " + output);
+    }
+  }
+  catch (rld::error re)
+  {
+    std::cerr << "error: "
+              << re.where << ": " << re.what
+              << std::endl;
+    ec = 10;
+  }
+  catch (std::exception& e)
+  {
+    int   status;
+    char* realname;
+    realname = abi::__cxa_demangle (e.what(), 0, 0, &status);
+    std::cerr << "error: exception: " << realname << " [";
+    ::free (realname);
+    const std::type_info &ti = typeid (e);
+    realname = abi::__cxa_demangle (ti.name(), 0, 0, &status);
+    std::cerr << realname << "] " << e.what () << std::endl << std::flush;
+    ::free (realname);
+    ec = 11;
+  }
+  catch (...)
+  {
+    /*
+     * Helps to know if this happens.
+     */
+    std::cerr << "error: unhandled exception" << std::endl;
+    ec = 12;
+  }
+
+  return ec;
+}
@@ -30,6 +30,7 @@
 #include <iomanip>
 #include <iostream>
 #include <regex>
+#include <set>
 
 #include <cxxabi.h>
 #include <signal.h>
@@ -78,7 +79,7 @@ static const char* c_header[] =
   0
 };
 
-static const char* c_trailer[] =
+static const char* c_table_end[] =
 {
   "asm(\"  .byte    0\");",
   "asm(\"  .ascii   \\\"\\xde\\xad\\xbe\\xef\\\"\");",
@@ -86,6 +87,11 @@ static const char* c_trailer[] =
   "asm(\"  .type    rtems__rtl_base_globals, #object\");",
   "asm(\"  .size    rtems__rtl_base_globals, . - rtems__rtl_base_globals\");",
 #endif
+  0
+};
+
+static const char* c_trailer[] =
+{
   "",
   "/*",
   " * Symbol table size.",
@@ -207,6 +213,69 @@ symbol_filter::filter (const rld::symbols::symtab& symbols,
   }
 }
 
+/**
+ * The symbols dynamic modules import. An import is a symbol a module's object
+ * file references that none of the modules' object files define.
+ */
+typedef std::set < std::string > module_imports;
+
+static void
+load_module_imports (const std::vector < std::string >& modules,
+                     module_imports&                    imports)
+{
+  rld::files::cache   cache;
+  rld::symbols::table symbols;
+
+  cache.open ();
+
+  try
+  {
+    for (auto& module : modules)
+      cache.add (module);
+
+    cache.load_symbols (symbols);
+
+    for (auto& o : cache.get_objects ())
+    {
+      for (auto& u : o.second->unresolved_symbols ())
+      {
+        if (symbols.find_global (u.first) == nullptr)
+          imports.insert (u.first);
+      }
+    }
+  }
+  catch (...)
+  {
+    cache.close ();
+    throw;
+  }
+
+  cache.close ();
+}
+
+/**
+ * Prune the symbols to the imports of the modules.
+ */
+static void
+prune_symbols (rld::symbols::symtab&  symbols,
+               const module_imports& imports,
+               bool                  warnings)
+{
+  rld::symbols::symtab pruned;
+
+  for (auto& name : imports)
+  {
+    auto si = symbols.find (name);
+    if (si != symbols.end ())
+      pruned[si->first] = si->second;
+    else if (warnings)
+      std::cerr << "warning: module import not in the kernel symbols: "
+                << name << std::endl;
+  }
+
+  symbols.swap (pruned);
+}
+
 /**
  * Generate the symbol map object file for loading or linking into
  * a running RTEMS machine.
@@ -226,13 +295,13 @@ struct output_sym
       weak (weak) {
   }
 
-  void operator ()(const rld::symbols::symtab::value_type& value);
+  void operator ()(const rld::symbols::symbol* symbol);
 };
 
 void
-output_sym::operator ()(const rld::symbols::symtab::value_type& value)
+output_sym::operator ()(const rld::symbols::symbol* symbol)
 {
-  const rld::symbols::symbol& sym = *(value.second);
+  const rld::symbols::symbol& sym = *symbol;
 
   /*
    * Weak symbols without a value are probably unresolved externs. Ignore them.
@@ -268,9 +337,190 @@ output_sym::operator ()(const rld::symbols::symtab::value_type& value)
 }
 
 
+/**
+ * Append a word to the symbol table in the target's byte order.
+ */
+static void
+symmap_word (std::string& table,
+             uint64_t     value,
+             size_t       size,
+             bool         little_endian)
+{
+  for (size_t b = 0; b < size; ++b)
+  {
+    size_t shift = little_endian ? b : size - b - 1;
+    table += (char) ((value >> (shift * 8)) & 0xff);
+  }
+}
+
+/**
+ * The symbol table can be followed by an index the target can search without
+ * building its own table. The index is after the end marker aligned to 4
+ * bytes and is 32bit words in the target's byte order:
+ *
+ *  magic, format, count, offset[count]
+ *
+ * The offsets are the offsets of the symbols' names from the start of the
+ * table in the order of the table. The sorted format has the symbols sorted
+ * by name for a binary search. The hash format adds a GNU hash style index:
+ *
+ *  buckets, bloom words, bloom shift, bloom[], bucket[buckets], chain[count]
+ *
+ * The symbols are ordered by bucket, a bucket is the index of its first
+ * symbol or 0xffffffff if the bucket is empty, and a chain word is the
+ * symbol's hash with bit 0 set on the last symbol of the bucket. The bloom
+ * filter words are 32 bits.
+ */
+enum symbol_index_format
+{
+  index_none = 0,
+  index_sorted = 1,
+  index_hash = 2
+};
+
+static const uint32_t symbol_index_magic = 0x494c5452; /* "RTLI" */
+
+/**
+ * The GNU hash of a symbol's name.
+ */
+static uint32_t
+symbol_index_hash (const std::string& name)
+{
+  uint32_t h = 5381;
+  for (auto c : name)
+    h = (h << 5) + h + (unsigned char) c;
+  return h;
+}
+
+/**
+ * The symbols in the order they are written to the table and the table's
+ * index.
+ */
+class symbol_index
+{
+public:
+  typedef std::vector < const rld::symbols::symbol* > ordered;
+
+  symbol_index (const rld::symbols::symtab& symbols,
+                symbol_index_format         format);
+
+  /**
+   * The symbols in table order.
+   */
+  const ordered& symbols () const;
+
+  /**
+   * Append the index to the table. The table is the symbols followed by the
+   * end marker and is padded to the start of the index.
+   */
+  void append (std::string& table, size_t word_size, bool little_endian) const;
+
+private:
+  symbol_index_format      format;
+  ordered                  syms;
+  std::vector < uint32_t > hashes;
+  uint32_t                 buckets;
+};
+
+symbol_index::symbol_index (const rld::symbols::symtab& symbols,
+                            symbol_index_format         format)
+  : format (format),
+    buckets (0)
+{
+  /*
+   * The symbol table is sorted by name.
+   */
+  for (const auto& s : symbols)
+    syms.push_back (s.second);
+
+  if (format == index_hash)
+  {
+    buckets = syms.size () / 4;
+    if (buckets == 0)
+      buckets = 1;
+
+    std::stable_sort (syms.begin (),
+                      syms.end (),
+                      [this] (const rld::symbols::symbol* a,
+                              const rld::symbols::symbol* b) {
+                        return (symbol_index_hash (a->name ()) % buckets) <
+                          (symbol_index_hash (b->name ()) % buckets);
+                      });
+
+    for (auto sym : syms)
+      hashes.push_back (symbol_index_hash (sym->name ()));
+  }
+}
+
+const symbol_index::ordered&
+symbol_index::symbols () const
+{
+  return syms;
+}
+
+void
+symbol_index::append (std::string& table,
+                      size_t       word_size,
+                      bool         little_endian) const
+{
+  if (format == index_none)
+    return;
+
+  while ((table.size () % 4) != 0)
+    table += '\0';
+
+  symmap_word (table, symbol_index_magic, 4, little_endian);
+  symmap_word (table, format, 4, little_endian);
+  symmap_word (table, syms.size (), 4, little_endian);
+
+  size_t offset = 0;
+  for (auto sym : syms)
+  {
+    symmap_word (table, offset, 4, little_endian);
+    offset += sym->name ().size () + 1 + word_size;
+  }
+
+  if (format == index_hash)
+  {
+    const uint32_t bloom_shift = 5;
+    uint32_t       bloom_words = 1;
+
+    while (bloom_words * 32 < syms.size () * 2)
+      bloom_words <<= 1;
+
+    std::vector < uint32_t > bloom (bloom_words, 0);
+    std::vector < uint32_t > bucket (buckets, 0xffffffff);
+    std::vector < uint32_t > chain (hashes);
+
+    for (size_t s = 0; s < hashes.size (); ++s)
+    {
+      const uint32_t h = hashes[s];
+      const uint32_t b = h % buckets;
+      bloom[(h / 32) % bloom_words] |=
+        (1U << (h % 32)) | (1U << ((h >> bloom_shift) % 32));
+      if (bucket[b] == 0xffffffff)
+        bucket[b] = s;
+      if ((s + 1) == hashes.size () || (hashes[s + 1] % buckets) != b)
+        chain[s] |= 1;
+      else
+        chain[s] &= ~1U;
+    }
+
+    symmap_word (table, buckets, 4, little_endian);
+    symmap_word (table, bloom_words, 4, little_endian);
+    symmap_word (table, bloom_shift, 4, little_endian);
+    for (auto w : bloom)
+      symmap_word (table, w, 4, little_endian);
+    for (auto w : bucket)
+      symmap_word (table, w, 4, little_endian);
+    for (auto w : chain)
+      symmap_word (table, w, 4, little_endian);
+  }
+}
+
 static void
 generate_c (rld::process::tempfile& c,
-            rld::symbols::symtab&   symbols,
+            const symbol_index&     index,
             bool                    embed)
 {
   temporary_file_paint (c, c_header);
@@ -281,10 +531,37 @@ generate_c (rld::process::tempfile& c,
    * longer weak and should be consider a global symbol. You cannot link a
    * global symbol with the same in a dynamically loaded module.
    */
-  std::for_each (symbols.begin (),
-                 symbols.end (),
+  std::for_each (index.symbols ().begin (),
+                 index.symbols ().end (),
                  output_sym (c, embed, false));
 
+  temporary_file_paint (c, c_table_end);
+
+  /*
+   * The index is data known now so it is written as bytes.
+   */
+  std::string index_data;
+  index.append (index_data,
+                rld::elf::object_class () == ELFCLASS64 ? 8 : 4,
+                rld::elf::object_datatype () == ELFDATA2LSB);
+  if (!index_data.empty ())
+  {
+    c.write_line ("asm(\"  .balign  4\");");
+    for (size_t b = 0; b < index_data.size (); b += 16)
+    {
+      std::stringstream oss;
+      oss << "asm(\"  .byte    ";
+      for (size_t i = b; i < index_data.size () && i < (b + 16); ++i)
+      {
+        if (i != b)
+          oss << ',';
+        oss << (unsigned int) (unsigned char) index_data[i];
+      }
+      oss << "\");";
+      c.write_line (oss.str ());
+    }
+  }
+
   temporary_file_paint (c, c_trailer);
 
   if (embed)
@@ -296,7 +573,7 @@ generate_c (rld::process::tempfile& c,
 static void
 generate_symmap (rld::process::tempfile& c,
                  const std::string&      output,
-                 rld::symbols::symtab&   symbols,
+                 const symbol_index&     index,
                  bool                    embed)
 {
   c.open (true);
@@ -304,7 +581,7 @@ generate_symmap (rld::process::tempfile& c,
   if (rld::verbose ())
     std::cout << "symbol C file: " << c.name () << std::endl;
 
-  generate_c (c, symbols, embed);
+  generate_c (c, index, embed);
 
   if (rld::verbose ())
     std::cout << "symbol O file: " << output << std::endl;
@@ -320,8 +597,8 @@ generate_symmap (rld::process::tempfile& c,
   args.push_back (output);
   args.push_back (c.name ());
 
-  rld::process::tempfile out;
-  rld::process::tempfile err;
+  rld::process::tempfile out (".out", false, true);
+  rld::process::tempfile err (".err", false, true);
   rld::process::status   status;
 
   status = rld::process::execute (rld::cc::get_cc (),
@@ -338,6 +615,252 @@ generate_symmap (rld::process::tempfile& c,
   }
 }
 
+/**
+ * The relocation used to reference a symbol from the embedded symbol table
+ * for the machines the symbol map object can be written directly for.
+ */
+struct symmap_reloc
+{
+  unsigned int machinetype; //< The machine type.
+  unsigned int class_;      //< The ELF class.
+  unsigned int type;        //< The absolute data relocation.
+  bool         rela;        //< The relocation records have addends.
+};
+
+static const symmap_reloc symmap_relocs[] =
+{
+  { EM_386,     ELFCLASS32, R_386_32,        false },
+  { EM_X86_64,  ELFCLASS64, R_X86_64_64,     true  },
+  { EM_ARM,     ELFCLASS32, R_ARM_ABS32,     false },
+  { EM_AARCH64, ELFCLASS64, R_AARCH64_ABS64, true  },
+  { EM_SPARC,   ELFCLASS32, R_SPARC_32,      true  },
+  { EM_SPARCV9, ELFCLASS64, R_SPARC_64,      true  },
+  { EM_PPC,     ELFCLASS32, R_PPC_ADDR32,    true  },
+  { EM_PPC64,   ELFCLASS64, R_PPC64_ADDR64,  true  },
+  { EM_MIPS,    ELFCLASS32, R_MIPS_32,       false },
+  { EM_RISCV,   ELFCLASS32, R_RISCV_32,      true  },
+  { EM_RISCV,   ELFCLASS64, R_RISCV_64,      true  },
+  { EM_NONE,    0,          0,               false }
+};
+
+/**
+ * Write the symbol map object file directly. The object has the same symbol
+ * table as the compiled C file in a .rodata section without a compiler being
+ * run. There is no code in the object so the table is not registered by a
+ * constructor or an init call, the global rtems__rtl_base_globals and
+ * rtems__rtl_base_globals_size symbols are passed to
+ * rtems_rtl_base_sym_global_add by the application.
+ */
+static void
+generate_symmap_object (const std::string&  output,
+                        const symbol_index& index,
+                        bool                embed)
+{
+  if (rld::verbose ())
+    std::cout << "symbol O file: " << output << " (direct)" << std::endl;
+
+  const unsigned int class_ = rld::elf::object_class ();
+  const unsigned int machinetype = rld::elf::object_machine_type ();
+  const bool         little_endian =
+    rld::elf::object_datatype () == ELFDATA2LSB;
+  const size_t       word_size = class_ == ELFCLASS64 ? 8 : 4;
+
+  const symmap_reloc* reloc = 0;
+  if (embed)
+  {
+    for (reloc = &symmap_relocs[0]; reloc->machinetype != EM_NONE; ++reloc)
+      if (reloc->machinetype == machinetype && reloc->class_ == class_)
+        break;
+    if (reloc->machinetype == EM_NONE)
+      throw rld::error ("embedded symbol table not supported for machine: " +
+                        rld::elf::machine_type (),
+                        "symbol object");
+  }
+
+  /*
+   * The symbol table is the symbol names each followed by the value. The
+   * embedded table's values are relocations to the symbols resolved when the
+   * kernel is linked again. The TLS values are offsets and not relocated.
+   */
+  std::string                table;
+  std::string                strings ("\0", 1);
+  std::vector < GElf_Sym >   syms;
+  std::vector < GElf_Rela >  relocs;
+  GElf_Sym                   gsym;
+
+  memset (&gsym, 0, sizeof (gsym));
+  syms.push_back (gsym);
+
+  for (auto s : index.symbols ())
+  {
+    const rld::symbols::symbol& sym = *s;
+
+    table += sym.name ();
+    table += '\0';
+
+    if (embed && sym.type () != STT_TLS)
+    {
+      GElf_Rela grela;
+      memset (&gsym, 0, sizeof (gsym));
+      gsym.st_name = strings.size ();
+      gsym.st_info = GELF_ST_INFO (STB_GLOBAL, STT_NOTYPE);
+      gsym.st_shndx = SHN_UNDEF;
+      strings += sym.name ();
+      strings += '\0';
+      grela.r_offset = table.size ();
+      grela.r_info = GELF_R_INFO (syms.size (), reloc->type);
+      grela.r_addend = 0;
+      syms.push_back (gsym);
+      relocs.push_back (grela);
+      symmap_word (table, 0, word_size, little_endian);
+    }
+    else
+    {
+      symmap_word (table, sym.value (), word_size, little_endian);
+    }
+  }
+
+  table += '\0';
+  table += "\xde\xad\xbe\xef";
+
+  index.append (table, word_size, little_endian);
+
+  const size_t table_size = table.size ();
+
+  while ((table.size () % 4) != 0)
+    table += '\0';
+
+  const size_t size_offset = table.size ();
+
+  symmap_word (table, size_offset, 4, little_endian);
+
+  /*
+   * The table's symbols are global so the application can add the table.
+   */
+  const char* labels[2] = {
+    "rtems__rtl_base_globals", "rtems__rtl_base_globals_size"
+  };
+  const size_t values[2] = { 0, size_offset };
+  const size_t sizes[2] = { table_size, 4 };
+
+  for (int l = 0; l < 2; ++l)
+  {
+    memset (&gsym, 0, sizeof (gsym));
+    gsym.st_name = strings.size ();
+    gsym.st_value = values[l];
+    gsym.st_size = sizes[l];
+    gsym.st_info = GELF_ST_INFO (STB_GLOBAL, STT_OBJECT);
+    gsym.st_shndx = 1;
+    strings += labels[l];
+    strings += '\0';
+    syms.push_back (gsym);
+  }
+
+  rld::files::object obj (output);
+
+  obj.open (true);
+  obj.begin ();
+
+  rld::elf::file& elf = obj.elf ();
+
+  elf.set_header (ET_REL,
+                  class_,
+                  machinetype,
+                  rld::elf::object_datatype (),
+                  rld::elf::object_flags ());
+
+  const rld::elf::elf_type rel_type =
+    reloc && reloc->rela ? ELF_T_RELA : ELF_T_REL;
+  const size_t sym_size =
+    ::gelf_fsize (elf.get_elf (), ELF_T_SYM, 1, EV_CURRENT);
+  const size_t rel_size =
+    ::gelf_fsize (elf.get_elf (), rel_type, 1, EV_CURRENT);
+
+  std::vector < char > sym_data (syms.size () * sym_size);
+  std::vector < char > rel_data (relocs.size () * rel_size);
+
+  rld::elf::section rodata (elf,
+                            1,
+                            ".rodata",
+                            SHT_PROGBITS,
+                            4,
+                            SHF_ALLOC,
+                            0,
+                            0,
+                            table.size ());
+  rodata.add_data (ELF_T_BYTE, 4, table.size (), (void*) table.c_str ());
+
+  rld::elf::section symtab (elf,
+                            2,
+                            ".symtab",
+                            SHT_SYMTAB,
+                            word_size,
+                            0,
+                            0,
+                            0,
+                            sym_data.size (),
+                            3,
+                            1,
+                            sym_size);
+  symtab.add_data (ELF_T_SYM, word_size, sym_data.size (), sym_data.data ());
+  for (size_t s = 0; s < syms.size (); ++s)
+    if (!::gelf_update_sym (symtab.data (), s, &syms[s]))
+      throw rld::error (::elf_errmsg (-1), "symbol object: symtab");
+
+  rld::elf::section strtab (elf,
+                            3,
+                            ".strtab",
+                            SHT_STRTAB,
+                            1,
+                            0,
+                            0,
+                            0,
+                            strings.size ());
+  strtab.add_data (ELF_T_BYTE, 1, strings.size (), (void*) strings.c_str ());
+
+  elf.add (rodata);
+  elf.add (symtab);
+  elf.add (strtab);
+
+  if (!relocs.empty ())
+  {
+    rld::elf::section relsec (elf,
+                              4,
+                              reloc->rela ? ".rela.rodata" : ".rel.rodata",
+                              reloc->rela ? SHT_RELA : SHT_REL,
+                              word_size,
+                              SHF_INFO_LINK,
+                              0,
+                              0,
+                              rel_data.size (),
+                              2,
+                              1,
+                              rel_size);
+    relsec.add_data (rel_type, word_size, rel_data.size (), rel_data.data ());
+    for (size_t r = 0; r < relocs.size (); ++r)
+    {
+      bool updated;
+      if (reloc->rela)
+        updated = ::gelf_update_rela (relsec.data (), r, &relocs[r]);
+      else
+      {
+        GElf_Rel grel;
+        grel.r_offset = relocs[r].r_offset;
+        grel.r_info = relocs[r].r_info;
+        updated = ::gelf_update_rel (relsec.data (), r, &grel);
+      }
+      if (!updated)
+        throw rld::error (::elf_errmsg (-1), "symbol object: relocations");
+    }
+    elf.add (relsec);
+  }
+
+  elf.write ();
+
+  obj.end ();
+  obj.close ();
+}
+
 /**
  * RTEMS Symbols options.
  */
@@ -356,6 +879,10 @@ static struct option rld_opts[] = {
   { "cflags",      required_argument,      NULL,           'c' },
   { "filter",      required_argument,      NULL,           'f' },
   { "filter-re",   required_argument,      NULL,           'F' },
+  { "direct",      no_argument,            NULL,           'd' },
+  { "index",       required_argument,      NULL,           'i' },
+  { "trace-events", required_argument,     NULL,           'T' },
+  { "module",      required_argument,      NULL,           'M' },
   { NULL,          0,                      NULL,            0 }
 };
 
@@ -378,7 +905,15 @@ usage (int exit_code)
             << " -E prefix : the RTEMS tool prefix (also --exec-prefix)" << std::endl
             << " -c cflags : C compiler flags (also --cflags)" << std::endl
             << " -f file   : file of symbol filters (also --filter)" << std::endl
-            << " -F re     : filter regx expression (also --filter-re)" << std::endl;
+            << " -F re     : filter regx expression (also --filter-re)" << std::endl
+            << " -d        : write the output object file without the C compiler," << std::endl
+            << "             the symbol table is not registered (also --direct)" << std::endl
+            << " -i index  : symbol table index, `sorted' or `hash' (also --index)" << std::endl
+            << " -T file   : write the time of each stage as Chrome trace" << std::endl
+            << "             events (also --trace-events)" << std::endl
+            << " -M file   : a module object file or archive, only the filtered" << std::endl
+            << "             symbols the modules import are in the table, add" << std::endl
+            << "             multiple for more than one module (also --module)" << std::endl;
   ::exit (exit_code);
 }
 
@@ -434,12 +969,16 @@ main (int argc, char* argv[])
     std::string         cc;
     std::string         symc;
     bool                embed = false;
+    bool                direct = false;
+    symbol_index_format index = index_none;
+    bool                warnings = false;
+    std::vector < std::string > modules;
 
     rld::set_cmdline (argc, argv);
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hvVwkef:S:o:m:E:c:C:f:F:", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hvVwkedi:f:S:o:m:E:c:C:f:F:T:M:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -457,6 +996,7 @@ main (int argc, char* argv[])
           break;
 
         case 'w':
+          warnings = true;
           break;
 
         case 'k':
@@ -467,6 +1007,20 @@ main (int argc, char* argv[])
           embed = true;
           break;
 
+        case 'd':
+          direct = true;
+          break;
+
+        case 'i':
+          if (::strcmp (optarg, "sorted") == 0)
+            index = index_sorted;
+          else if (::strcmp (optarg, "hash") == 0)
+            index = index_hash;
+          else
+            throw rld::error ("invalid index: " + std::string (optarg),
+                              "options");
+          break;
+
         case 'o':
           output = optarg;
           break;
@@ -503,6 +1057,14 @@ main (int argc, char* argv[])
           filter.add (optarg);
           break;
 
+        case 'T':
+          rld::trace_events_enable (optarg);
+          break;
+
+        case 'M':
+          modules.push_back (optarg);
+          break;
+
         case '?':
           usage (3);
           break;
@@ -547,27 +1109,49 @@ main (int argc, char* argv[])
       /*
        * Load the kernel ELF file symbol table.
        */
-      kernel.open ();
-      kernel.add (kernel_name);
-      kernel.load_symbols (symbols, true);
+      {
+        rld::span span ("symbol load");
+        kernel.open ();
+        kernel.add (kernel_name);
+        kernel.load_symbols (symbols, true);
+      }
 
       /*
        * If the full path to CC is not provided and the exec-prefix is not set
        * by the command line see if it can be detected from the object file
        * types. This must be after we have added the object files because they
-       * are used when detecting.
+       * are used when detecting. The compiler is not used when the output is
+       * written directly.
        */
       if (!cc.empty ())
         rld::cc::set_cc (cc);
-      if (!rld::cc::is_cc_set () && !rld::cc::is_exec_prefix_set ())
+      if (!direct &&
+          !rld::cc::is_cc_set () && !rld::cc::is_exec_prefix_set ())
         rld::cc::set_exec_prefix (rld::elf::machine_type ());
 
       /*
        * Filter the symbols.
        */
       rld::symbols::symtab filter_symbols;
-      filter.filter (symbols.globals (), filter_symbols);
-      filter.filter (symbols.weaks (), filter_symbols);
+      {
+        rld::span span ("filter");
+        filter.filter (symbols.globals (), filter_symbols);
+        filter.filter (symbols.weaks (), filter_symbols);
+      }
+
+      /*
+       * Only export the symbols the modules import if the modules are known.
+       */
+      if (!modules.empty ())
+      {
+        rld::span      span ("modules");
+        module_imports imports;
+        load_module_imports (modules, imports);
+        if (rld::verbose ())
+          std::cout << "Module imports: " << imports.size () << std::endl;
+        prune_symbols (filter_symbols, imports, warnings);
+      }
+
       if (filter_symbols.size () == 0)
         throw rld::error ("no filtered symbols", "filter");
       if (rld::verbose ())
@@ -592,7 +1176,17 @@ main (int argc, char* argv[])
       /*
        * Create an output file if asked too.
        */
-      if (!output.empty ())
+      if (!output.empty () && direct)
+      {
+        /*
+         * Write the symbol map object.
+         */
+        rld::span span ("write");
+        generate_symmap_object (output,
+                                symbol_index (filter_symbols, index),
+                                embed);
+      }
+      else if (!output.empty ())
       {
         rld::process::tempfile c (".c");
 
@@ -605,7 +1199,11 @@ main (int argc, char* argv[])
         /*
          * Generate and compile the symbol map.
          */
-        generate_symmap (c, output, filter_symbols, embed);
+        rld::span span ("write");
+        generate_symmap (c,
+                         output,
+                         symbol_index (filter_symbols, index),
+                         embed);
       }
 
       kernel.close ();
@@ -617,6 +1215,8 @@ main (int argc, char* argv[])
     }
 
     kernel.close ();
+
+    rld::trace_events_write ();
   }
   catch (rld::error re)
   {
@@ -28,10 +28,13 @@
 
 #include <algorithm>
 #include <cctype>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <iomanip>
+#include <list>
 #include <locale>
+#include <map>
 #include <sstream>
 
 #include <cxxabi.h>
@@ -47,6 +50,9 @@
 #include <rld-config.h>
 #include <rld-process.h>
 #include <rld-rtems.h>
+#include <rld-tasks.h>
+
+#include <pkgconfig.h>
 
 #ifndef HAVE_KILL
 #define kill(p,s) raise(s)
@@ -74,6 +80,18 @@ namespace rld
      */
     typedef std::string function_return;
 
+    /**
+     * The number of bits of a function's arguments.
+     */
+    typedef std::vector < uint32_t > arg_bits;
+
+    /**
+     * The timestamp reads of a generator. The first of a pair is the macro
+     * identifying the architecture and the second the code to read the
+     * timestamp.
+     */
+    typedef std::vector < std::pair < std::string, std::string > > timestamp_reads;
+
     /**
      * An option is a name and value pair. We consider options as global.
      */
@@ -96,6 +114,41 @@ namespace rld
      */
     typedef std::vector < option > options;
 
+    /**
+     * The configuration cache holds the resolved tracer definitions so a trace
+     * link does not parse the configuration files again. The data is length
+     * prefixed strings and 64bit values in little endian byte order.
+     */
+    class cache_writer
+    {
+    public:
+      void put (uint64_t value);
+      void put (const std::string& s);
+      void put (const rld::strings& ss);
+
+      /**
+       * The data written.
+       */
+      const std::string& data () const;
+
+    private:
+      std::string data_;
+    };
+
+    class cache_reader
+    {
+    public:
+      cache_reader (const std::string& data);
+
+      uint64_t get_value ();
+      const std::string get_string ();
+      void get (rld::strings& ss);
+
+    private:
+      const std::string& data_;
+      size_t             offset;
+    };
+
     /**
      * A function's signature.
      */
@@ -104,12 +157,20 @@ namespace rld
       std::string     name; /**< The function's name. */
       function_args   args; /**< The function's list of arguments. */
       function_return ret;  /**< The fuctions return value. */
+      arg_bits        bits; /**< The bits of each argument packed into a
+                             *   record, 0 is all of the argument. */
 
       /**
        * The default constructor.
        */
       signature ();
 
+      /**
+       * Save and restore the signature with the configuration cache.
+       */
+      void save (cache_writer& out) const;
+      void restore (cache_reader& in);
+
       /**
        * Construct the signature loading it from the configuration.
        */
@@ -125,6 +186,22 @@ namespace rld
        */
       bool has_args () const;
 
+      /**
+       * Is the argument a scalar packed into fewer bits than its type ?
+       */
+      bool packed (size_t arg) const;
+
+      /**
+       * The size in bytes of the argument in a record as a C expression. A
+       * packed argument is the bytes holding its bits if packing.
+       */
+      const std::string arg_size (size_t arg, bool pack) const;
+
+      /**
+       * The number of bits of the argument in a record as a C expression.
+       */
+      const std::string arg_bit_count (size_t arg, bool pack) const;
+
       /**
        * Return the function's declaration.
        */
@@ -147,12 +224,23 @@ namespace rld
       rld::strings defines;     /**< Define statements. */
       signatures   signatures_; /**< Signatures in this function. */
 
+      /**
+       * The default constructor.
+       */
+      function ();
+
       /**
        * Load the function.
        */
       function (rld::config::config& config,
                 const std::string&   name);
 
+      /**
+       * Save and restore the function with the configuration cache.
+       */
+      void save (cache_writer& out) const;
+      void restore (cache_reader& in);
+
       /**
        * Dump the function.
        */
@@ -164,6 +252,11 @@ namespace rld
      */
     typedef std::vector < function > functions;
 
+    /**
+     * The sample rates of the traced functions keyed by the function.
+     */
+    typedef std::map < std::string, uint32_t > sample_rates;
+
     /**
      * A generator and that contains the functions used to trace arguments and
      * return values. It also provides the implementation of those functions.
@@ -181,10 +274,14 @@ namespace rld
       std::string  entry_trace;     /**< Code template to trace the function entry. */
       std::string  entry_alloc;     /**< Code template to perform a buffer allocation. */
       std::string  arg_trace;       /**< Code template to trace an argument. */
+      std::string  arg_pack;        /**< Code template to trace a packed argument. */
       std::string  exit_trace;      /**< Code template to trace the function exit. */
       std::string  exit_alloc;      /**< Code template to perform a buffer allocation. */
       std::string  ret_trace;       /**< Code template to trace the return value. */
       rld::strings code;            /**< Code block inserted before the trace code. */
+      rld::strings shard_code;      /**< Code block inserted before the trace code
+                                     *   of the other wrapper shards. */
+      timestamp_reads timestamps;   /**< The timestamp reads by architecture. */
 
       /**
        * Default constructor.
@@ -197,6 +294,12 @@ namespace rld
       generator (rld::config::config& config,
                  const std::string&   name);
 
+      /**
+       * Save and restore the generator with the configuration cache.
+       */
+      void save (cache_writer& out) const;
+      void restore (cache_reader& in);
+
       /**
        * Dump the generator.
        */
@@ -223,6 +326,18 @@ namespace rld
       void load_options (rld::config::config&        config,
                          const rld::config::section& section);
 
+      /**
+       * Apply an option.
+       */
+      static void apply_option (const option& opt);
+
+      /**
+       * Save and restore the resolved tracer with the configuration cache. The
+       * options are applied again when it is restored.
+       */
+      void save (cache_writer& out) const;
+      void restore (cache_reader& in);
+
       /**
        * The defines for the trace.
        */
@@ -247,6 +362,12 @@ namespace rld
       void load_triggers (rld::config::config&        config,
                           const rld::config::section& section);
 
+      /**
+       * The sample rates for the tracer.
+       */
+      void load_samples (rld::config::config&        config,
+                         const rld::config::section& section);
+
       /**
        * The traces for the tracer.
        */
@@ -259,9 +380,24 @@ namespace rld
       const std::string get_option (const std::string& name) const;
 
       /**
-       * Generate the wrapper object file.
+       * Generate the wrapper C file. The traces are split into the number of
+       * shards and the wrappers of the shard are generated. The first shard
+       * holds the tables and the generator's code.
+       */
+      void generate (rld::process::tempfile& c,
+                     size_t                  shard = 0,
+                     size_t                  shards = 1);
+
+      /**
+       * The number of shards the wrappers can be split into. The generator
+       * needs shard code to be split.
+       */
+      size_t shards (size_t wanted) const;
+
+      /**
+       * Generate the generator's timestamp read.
        */
-      void generate (rld::process::tempfile& c);
+      void generate_timestamps (rld::process::tempfile& c);
 
       /**
        * Generate the trace names as a string table.
@@ -274,14 +410,37 @@ namespace rld
       void generate_signatures (rld::process::tempfile& c);
 
       /**
-       * Generate the enabled trace bitmap.
+       * Generate the enabled trace bitmap. A local bitmap is a static copy
+       * in a shard so a static enable can be folded by the compiler.
        */
-      void generate_enables (rld::process::tempfile& c);
+      void generate_enables (rld::process::tempfile& c, bool local = false);
 
       /**
        * Generate the triggered trace bitmap.
        */
-      void generate_triggers (rld::process::tempfile& c);
+      void generate_triggers (rld::process::tempfile& c, bool local = false);
+
+      /**
+       * Is the trace enabled when the enables are fixed at link time?
+       */
+      bool static_enabled (const std::string& trace) const;
+
+      /**
+       * The sample rate of a trace. A trace is recorded once in the rate's
+       * number of calls, 1 records every call.
+       */
+      uint32_t sample_rate (const std::string& trace) const;
+
+      /**
+       * Is any trace sampled?
+       */
+      bool sampling () const;
+
+      /**
+       * Generate the sample counters and the sample test. The counters are
+       * defined in the first shard.
+       */
+      void generate_samples (rld::process::tempfile& c, bool first);
 
       /**
        * Generate the functions.
@@ -289,9 +448,11 @@ namespace rld
       void generate_functions (rld::process::tempfile& c);
 
       /**
-       * Generate the trace functions.
+       * Generate the trace functions of a shard.
        */
-      void generate_traces (rld::process::tempfile& c);
+      void generate_traces (rld::process::tempfile& c,
+                            size_t                  shard,
+                            size_t                  shards);
 
       /**
        * Generate a bitmap.
@@ -299,7 +460,8 @@ namespace rld
       void generate_bitmap (rld::process::tempfile& c,
                             const rld::strings&     names,
                             const std::string&      label,
-                            const bool              global_set);
+                            const bool              global_set,
+                            const bool              local);
 
       /**
        * Function macro replace.
@@ -329,6 +491,7 @@ namespace rld
       rld::strings defines;       /**< Define statements. */
       rld::strings enables;       /**< The default enabled functions. */
       rld::strings triggers;      /**< The default trigger functions. */
+      sample_rates samples;       /**< The sample rates of the functions. */
       rld::strings traces;        /**< The functions to trace. */
       options      options_;      /**< The options. */
       functions    functions_;    /**< The functions that can be traced. */
@@ -344,16 +507,21 @@ namespace rld
       linker ();
 
       /**
-       * Load the user's configuration.
+       * Load the user's configuration. If there is a configuration cache the
+       * resolved tracer is loaded from it if none of the configuration files
+       * it was resolved from have changed.
        */
       void load_config (const std::string& name,
                         const std::string& trace,
-                        const std::string& path);
+                        const std::string& path,
+                        const std::string& cache = "");
 
       /**
        * Generate the C file.
        */
-      void generate_wrapper (rld::process::tempfile& c);
+      void generate_wrapper (rld::process::tempfile& c,
+                             size_t                  shard = 0,
+                             size_t                  shards = 1);
 
       /**
        * Compile the C file.
@@ -361,11 +529,19 @@ namespace rld
       void compile_wrapper (rld::process::tempfile& c,
                             rld::process::tempfile& o);
 
+      /**
+       * Generate and compile the wrappers on up to the number of jobs. The
+       * wrappers are split into a C file per job if the generator can be
+       * split. If the wrappers are kept an object is reused if its C file has
+       * not changed.
+       */
+      void build_wrappers (const std::string& wrapper,
+                           unsigned int       jobs);
+
       /**
        * Link the application.
        */
-      void link (rld::process::tempfile& o,
-                 const std::string&      ld_cmds);
+      void link (const std::string& ld_cmds);
 
       /**
        * Dump the linker.
@@ -374,10 +550,23 @@ namespace rld
 
     private:
 
+      typedef std::list < rld::process::tempfile > tempfiles;
+
+      /**
+       * Load the tracer from the configuration cache entry.
+       */
+      bool load_cache (const std::string& entry);
+
+      /**
+       * Save the tracer to the configuration cache entry.
+       */
+      void save_cache (const std::string& entry);
+
       rld::config::config    config;     /**< User configuration. */
+      rld::config::paths     paths;      /**< The configuration files. */
       tracer                 tracer_;    /**< The tracer */
-      rld::process::tempfile c; /**< The C wrapper file */
-      rld::process::tempfile o; /**< The wrapper object file */
+      tempfiles              cs;         /**< The C wrapper files */
+      tempfiles              os;         /**< The wrapper object files */
     };
 
     /**
@@ -417,10 +606,124 @@ namespace rld
       items.resize (std::distance (items.begin (), ii));
     }
 
+    void
+    cache_writer::put (uint64_t value)
+    {
+      for (int b = 0; b < 8; ++b)
+        data_ += (char) ((value >> (b * 8)) & 0xff);
+    }
+
+    void
+    cache_writer::put (const std::string& s)
+    {
+      put (s.size ());
+      data_ += s;
+    }
+
+    void
+    cache_writer::put (const rld::strings& ss)
+    {
+      put (ss.size ());
+      for (auto& s : ss)
+        put (s);
+    }
+
+    const std::string&
+    cache_writer::data () const
+    {
+      return data_;
+    }
+
+    cache_reader::cache_reader (const std::string& data)
+      : data_ (data),
+        offset (0)
+    {
+    }
+
+    uint64_t
+    cache_reader::get_value ()
+    {
+      if ((data_.size () - offset) < 8)
+        throw rld::error ("truncated", "config-cache");
+      uint64_t value = 0;
+      for (int b = 0; b < 8; ++b)
+        value |= ((uint64_t) (uint8_t) data_[offset++]) << (b * 8);
+      return value;
+    }
+
+    const std::string
+    cache_reader::get_string ()
+    {
+      uint64_t size = get_value ();
+      if ((data_.size () - offset) < size)
+        throw rld::error ("truncated", "config-cache");
+      std::string s = data_.substr (offset, size);
+      offset += size;
+      return s;
+    }
+
+    void
+    cache_reader::get (rld::strings& ss)
+    {
+      uint64_t count = get_value ();
+      ss.clear ();
+      for (uint64_t s = 0; s < count; ++s)
+        ss.push_back (get_string ());
+    }
+
+    /**
+     * The FNV-1a hash of the data.
+     */
+    static uint64_t
+    cache_hash (const std::string& data,
+                uint64_t           hash = 14695981039346656037ULL)
+    {
+      for (auto c : data)
+      {
+        hash ^= (uint8_t) c;
+        hash *= 1099511628211ULL;
+      }
+      return hash;
+    }
+
+    static bool
+    cache_read_file (const std::string& name, std::string& data)
+    {
+      std::ifstream in (name, std::ios::in | std::ios::binary);
+      if (!in.is_open ())
+        return false;
+      std::stringstream ss;
+      ss << in.rdbuf ();
+      data = ss.str ();
+      return !in.bad ();
+    }
+
     signature::signature ()
     {
     }
 
+    void
+    signature::save (cache_writer& out) const
+    {
+      out.put (name);
+      out.put (args);
+      out.put (ret);
+      out.put (bits.size ());
+      for (auto b : bits)
+        out.put (b);
+    }
+
+    void
+    signature::restore (cache_reader& in)
+    {
+      name = in.get_string ();
+      in.get (args);
+      ret = in.get_string ();
+      bits.resize (in.get_value ());
+      for (auto& b : bits)
+        b = in.get_value ();
+    }
+
     signature::signature (const rld::config::record& record)
     {
       /*
@@ -447,6 +750,28 @@ namespace rld
       ret = si[0];
       args.resize (si.size () - 1);
       std::copy (si.begin ()  + 1, si.end (), args.begin ());
+
+      /*
+       * A scalar argument can be followed by the number of bits it holds,
+       * for example `rtems_task_priority:8`. Only those bits are packed into
+       * a record.
+       */
+      bits.resize (args.size (), 0);
+      for (size_t a = 0; a < args.size (); ++a)
+      {
+        std::string::size_type colon = args[a].find_last_of (':');
+        if (colon == std::string::npos || colon == 0 ||
+            args[a][colon - 1] == ':')
+          continue;
+        std::string   count = rld::trim (args[a].substr (colon + 1));
+        char*         end = 0;
+        unsigned long b = ::strtoul (count.c_str (), &end, 10);
+        if (count.empty () || *end != '\0' || b == 0 || b > 64)
+          throw rld::error ("invalid argument bits: " + args[a],
+                            "signature: " + name);
+        args[a] = rld::trim (args[a].substr (0, colon));
+        bits[a] = b;
+      }
     }
 
     bool
@@ -467,6 +792,28 @@ namespace rld
       return ((args.size() == 1) && (args[0] == "void")) ? false : true;
     }
 
+    bool
+    signature::packed (size_t arg) const
+    {
+      return arg < bits.size () && bits[arg] != 0;
+    }
+
+    const std::string
+    signature::arg_size (size_t arg, bool pack) const
+    {
+      if (pack && packed (arg))
+        return rld::to_string ((int) ((bits[arg] + 7) / 8));
+      return "sizeof(" + args[arg] + ')';
+    }
+
+    const std::string
+    signature::arg_bit_count (size_t arg, bool pack) const
+    {
+      if (pack && packed (arg))
+        return rld::to_string ((int) bits[arg]);
+      return "(8 * sizeof(" + args[arg] + "))";
+    }
+
     const std::string
     signature::decl (const std::string& prefix) const
     {
@@ -491,6 +838,37 @@ namespace rld
       return ds;
     }
 
+    function::function ()
+    {
+    }
+
+    void
+    function::save (cache_writer& out) const
+    {
+      out.put (name);
+      out.put (headers);
+      out.put (defines);
+      out.put (signatures_.size ());
+      for (auto& si : signatures_)
+        si.second.save (out);
+    }
+
+    void
+    function::restore (cache_reader& in)
+    {
+      name = in.get_string ();
+      in.get (headers);
+      in.get (defines);
+      signatures_.clear ();
+      uint64_t count = in.get_value ();
+      for (uint64_t s = 0; s < count; ++s)
+      {
+        signature sig;
+        sig.restore (in);
+        signatures_[sig.name] = sig;
+      }
+    }
+
     function::function (rld::config::config& config,
                         const std::string&   name)
       : name (name)
@@ -590,6 +968,10 @@ namespace rld
        * # arg-trace    The wrapper call made for each argment to the trace function if
        *                the function is being traced. This call is made without the
        *                lock being held if a lock is defined.
+       * # arg-pack     The wrapper call made in place of the `arg-trace` for an
+       *                argument with a number of bits in the signature. The
+       *                argument is passed by value and only the bytes holding
+       *                the bits are in the record.
        * # exit-trace   The wrapper call made after a function's exit. Returns `bool
        *                where `true` is the function is being traced. This call is made
        *                without the lock being held if a lock is defined.
@@ -609,7 +991,18 @@ namespace rld
        *                making the alloc all.
        * # code-blocks  A list of code blcok section names.
        * # code         A code block in `<<CODE ... CODE` (without the single quote).
+       * # shard-code-blocks
+       *                A list of code block section names used in place of the
+       *                code blocks in the wrapper shards after the first. The
+       *                blocks declare the data the code blocks define. The
+       *                wrappers are not split into shards without them.
        * # includes     A list of files to include.
+       * # timestamps   A section of records of code that reads a timestamp. The
+       *                record's name is a macro the compiler defines for an
+       *                architecture and the first defined is used. The `default`
+       *                record is used if no macro is defined. The code is the
+       *                `RTLD_TRACE_TIMESTAMP()` macro and `RTLD_TRACE_TIMESTAMP_COUNTER`
+       *                is 1 if an architecture's code is used.
        *
        * The following macros can be used in specific wrapper calls. The lists of
        * where you can use them is listed before. The macros are:
@@ -628,6 +1021,7 @@ namespace rld
        * # @ARG_NUM@              The argument number to the trace function.
        * # @ARG_TYPE@             The type of the argument as a C string.
        * # @ARG_SIZE@             The size of the type of the argument in bytes.
+       * # @ARG_BITS@             The number of bits of the argument.
        * # @ARG_LABEL@            The argument as a C label that can be referenced.
        * # @RET_TYPE@             The type of the return value as a C string.
        * # @RET_SIZE@             The size of the type of the return value in bytes.
@@ -643,11 +1037,13 @@ namespace rld
        * # @FUNC_DATA_ENTRY_SZIE@
        * # @FUNC_DATA_EXIT_SZIE@
        *
-       * The `arg-trace` can be transformed using the following macros:
+       * The `arg-trace` and `arg-pack` can be transformed using the following
+       * macros:
        *
        * # @ARG_NUM@
        * # @ARG_TYPE@
        * # @ARG_SIZE@
+       * # @ARG_BITS@
        * # @ARG_LABEL@
        *
        * The `ret-trace` can be transformed using the following macros:
@@ -666,6 +1062,18 @@ namespace rld
       parse (config, section, "headers",     "header", headers);
       parse (config, section, "defines",     "define", defines);
       parse (config, section, "code-blocks", "code",   code, false);
+      if (section.has_record ("shard-code-blocks"))
+      {
+        rld::strings sl;
+        rld::config::parse_items (section, "shard-code-blocks", sl);
+        for (rld::strings::iterator sli = sl.begin ();
+             sli != sl.end ();
+             ++sli)
+        {
+          const rld::config::section& sec = config.get_section (*sli);
+          parse (config, sec, "code-blocks", "code", shard_code, false);
+        }
+      }
 
       if (section.has_record ("lock-model"))
         lock_model = rld::dequote (section.get_record_item ("lock-model"));
@@ -689,6 +1097,83 @@ namespace rld
         exit_alloc = rld::dequote (section.get_record_item ("exit-alloc"));
       if (section.has_record ("ret-trace"))
         ret_trace = rld::dequote (section.get_record_item ("ret-trace"));
+      if (section.has_record ("arg-pack"))
+        arg_pack = rld::dequote (section.get_record_item ("arg-pack"));
+
+      if (section.has_record ("timestamps"))
+      {
+        const rld::config::section& tsec =
+          config.get_section (rld::dequote (section.get_record_item ("timestamps")));
+        std::string default_read;
+        for (auto& rec : tsec.recs)
+        {
+          if (!rec.single ())
+            throw rld::error ("more than one read specified",
+                              "timestamp: " + rec.name);
+          if (rec.name == "default")
+            default_read = rld::dequote (rec[0]);
+          else
+            timestamps.push_back (std::make_pair (rec.name, rld::dequote (rec[0])));
+        }
+        if (!default_read.empty ())
+          timestamps.push_back (std::make_pair (std::string (), default_read));
+      }
+    }
+
+    void
+    generator::save (cache_writer& out) const
+    {
+      out.put (name);
+      out.put (lock_model);
+      out.put (lock_local);
+      out.put (lock_acquire);
+      out.put (lock_release);
+      out.put (buffer_local);
+      out.put (headers);
+      out.put (defines);
+      out.put (entry_trace);
+      out.put (entry_alloc);
+      out.put (arg_trace);
+      out.put (exit_trace);
+      out.put (exit_alloc);
+      out.put (ret_trace);
+      out.put (code);
+      out.put (shard_code);
+      out.put (arg_pack);
+      out.put (timestamps.size ());
+      for (auto& ts : timestamps)
+      {
+        out.put (ts.first);
+        out.put (ts.second);
+      }
+    }
+
+    void
+    generator::restore (cache_reader& in)
+    {
+      name = in.get_string ();
+      lock_model = in.get_string ();
+      lock_local = in.get_string ();
+      lock_acquire = in.get_string ();
+      lock_release = in.get_string ();
+      buffer_local = in.get_string ();
+      in.get (headers);
+      in.get (defines);
+      entry_trace = in.get_string ();
+      entry_alloc = in.get_string ();
+      arg_trace = in.get_string ();
+      exit_trace = in.get_string ();
+      exit_alloc = in.get_string ();
+      ret_trace = in.get_string ();
+      in.get (code);
+      in.get (shard_code);
+      arg_pack = in.get_string ();
+      timestamps.resize (in.get_value ());
+      for (auto& ts : timestamps)
+      {
+        ts.first = in.get_string ();
+        ts.second = in.get_string ();
+      }
     }
 
     void
@@ -710,8 +1195,15 @@ namespace rld
         out << "    " << (*di) << std::endl;
       }
       out << "   Arg Trace Code: " << arg_trace << std::endl
+          << "   Arg Pack Code: " << arg_pack << std::endl
           << "   Return Trace Code: " << ret_trace << std::endl
-          << "   Code blocks: " << std::endl;
+          << "   Timestamps: " << timestamps.size () << std::endl;
+      for (auto& ts : timestamps)
+      {
+        out << "    " << (ts.first.empty () ? "default" : ts.first)
+            << ": " << ts.second << std::endl;
+      }
+      out << "   Code blocks: " << std::endl;
       for (rld::strings::const_iterator ci = code.begin ();
            ci != code.end ();
            ++ci)
@@ -719,6 +1211,14 @@ namespace rld
         out << "      > "
             << rld::find_replace (*ci, "\n", "\n      | ") << std::endl;
       }
+      out << "   Shard code blocks: " << std::endl;
+      for (rld::strings::const_iterator ci = shard_code.begin ();
+           ci != shard_code.end ();
+           ++ci)
+      {
+        out << "      > "
+            << rld::find_replace (*ci, "\n", "\n      | ") << std::endl;
+      }
     }
 
     tracer::tracer ()
@@ -739,6 +1239,7 @@ namespace rld
        *  # define    A list of define string that are single or double quoted.
        *  # enables   The list of sections containing enabled functions to trace.
        *  # triggers  The list of sections containing enabled functions to trigger trace on.
+       *  # samples   The list of sections containing the sample rates of functions.
        *  # traces    The list of sections containing function lists to trace.
        *  # functions The list of sections containing function details.
        *  # include   The list of files to include.
@@ -758,6 +1259,7 @@ namespace rld
       load_functions (config, section);
       load_enables (config, section);
       load_triggers (config, section);
+      load_samples (config, section);
       load_traces (config, section);
     }
 
@@ -793,47 +1295,114 @@ namespace rld
               throw rld::error ("mode than one option specified", "option: " + opt.name);
 
           options_.push_back (option (opt.name, opt[0]));
-
-          if (opt.name == "dump-on-error")
-          {
-            dump_on_error = true;
-          }
-          else if (opt.name == "verbose")
-          {
-            int level = ::strtoul(opt[0].c_str (), 0, 0);
-            if (level == 0)
-              level = 1;
-            for (int l = 0; l < level; ++l)
-              rld::verbose_inc ();
-          }
-          else if (opt.name == "prefix")
-          {
-            rld::cc::set_exec_prefix (opt[0]);
-          }
-          else if (opt.name == "cc")
-          {
-            rld::cc::set_cc (opt[0]);
-          }
-          else if (opt.name == "ld")
-          {
-            rld::cc::set_ld (opt[0]);
-          }
-          else if (opt.name == "cflags")
-          {
-            rld::cc::append_flags (opt[0], rld::cc::ft_cflags);
-          }
-          else if (opt.name == "rtems-path")
-          {
-            rld::rtems::set_path(opt[0]);
-          }
-          else if (opt.name == "rtems-bsp")
-          {
-            rld::rtems::set_arch_bsp(opt[0]);
-          }
+          apply_option (options_.back ());
         }
       }
     }
 
+    void
+    tracer::apply_option (const option& opt)
+    {
+      if (opt.name == "dump-on-error")
+      {
+        dump_on_error = true;
+      }
+      else if (opt.name == "verbose")
+      {
+        int level = ::strtoul(opt.value.c_str (), 0, 0);
+        if (level == 0)
+          level = 1;
+        for (int l = 0; l < level; ++l)
+          rld::verbose_inc ();
+      }
+      else if (opt.name == "prefix")
+      {
+        rld::cc::set_exec_prefix (opt.value);
+      }
+      else if (opt.name == "cc")
+      {
+        rld::cc::set_cc (opt.value);
+      }
+      else if (opt.name == "ld")
+      {
+        rld::cc::set_ld (opt.value);
+      }
+      else if (opt.name == "cflags")
+      {
+        rld::cc::append_flags (opt.value, rld::cc::ft_cflags);
+      }
+      else if (opt.name == "rtems-path")
+      {
+        rld::rtems::set_path(opt.value);
+      }
+      else if (opt.name == "rtems-bsp")
+      {
+        rld::rtems::set_arch_bsp(opt.value);
+      }
+    }
+
+    void
+    tracer::save (cache_writer& out) const
+    {
+      out.put (name);
+      out.put (options_.size ());
+      for (auto& opt : options_)
+      {
+        out.put (opt.name);
+        out.put (opt.value);
+      }
+      out.put (defines);
+      out.put (enables);
+      out.put (triggers);
+      out.put (samples.size ());
+      for (auto& sample : samples)
+      {
+        out.put (sample.first);
+        out.put (sample.second);
+      }
+      out.put (traces);
+      out.put (functions_.size ());
+      for (auto& func : functions_)
+        func.save (out);
+      generator_.save (out);
+    }
+
+    void
+    tracer::restore (cache_reader& in)
+    {
+      name = in.get_string ();
+      options_.clear ();
+      uint64_t count = in.get_value ();
+      for (uint64_t o = 0; o < count; ++o)
+      {
+        std::string oname = in.get_string ();
+        std::string ovalue = in.get_string ();
+        options_.push_back (option (oname, ovalue));
+      }
+      in.get (defines);
+      in.get (enables);
+      in.get (triggers);
+      samples.clear ();
+      count = in.get_value ();
+      for (uint64_t s = 0; s < count; ++s)
+      {
+        std::string sname = in.get_string ();
+        samples[sname] = in.get_value ();
+      }
+      in.get (traces);
+      functions_.clear ();
+      count = in.get_value ();
+      for (uint64_t f = 0; f < count; ++f)
+      {
+        functions_.push_back (function ());
+        functions_.back ().restore (in);
+      }
+      generator_.restore (in);
+
+      for (auto& opt : options_)
+        apply_option (opt);
+    }
+
     void
     tracer::load_defines (rld::config::config&        config,
                           const rld::config::section& section)
@@ -869,6 +1438,42 @@ namespace rld
       parse (config, section, "triggers", "trigger", triggers);
     }
 
+    void
+    tracer::load_samples (rld::config::config&        config,
+                          const rld::config::section& section)
+    {
+      /*
+       * Each record of a samples section is a function and its sample rate,
+       * the function is traced once in the rate's number of calls, for
+       * example:
+       *
+       *  [hot-samples]
+       *  _Scheduler_Tick = 64
+       */
+      rld::strings ss;
+      rld::config::parse_items (section, "samples", ss, false, true, true);
+
+      for (auto& sname : ss)
+      {
+        const rld::config::section& ssec = config.get_section (sname);
+
+        for (auto& rec : ssec.recs)
+        {
+          if (!rec.single ())
+            throw rld::error ("more than one rate specified",
+                              "sample: " + rec.name);
+
+          char*         end = 0;
+          unsigned long rate = ::strtoul (rec[0].c_str (), &end, 0);
+
+          if (rec[0].empty () || *end != '\0' || rate == 0 || rate > 0xffffffffUL)
+            throw rld::error ("invalid rate: " + rec[0], "sample: " + rec.name);
+
+          samples[rec.name] = rate;
+        }
+      }
+    }
+
     void
     tracer::load_traces (rld::config::config&        config,
                          const rld::config::section& section)
@@ -921,8 +1526,18 @@ namespace rld
       return value;
     }
 
+    size_t
+    tracer::shards (size_t wanted) const
+    {
+      if (generator_.shard_code.empty () || wanted == 0)
+        return 1;
+      return std::min (wanted, traces.size ());
+    }
+
     void
-    tracer::generate (rld::process::tempfile& c)
+    tracer::generate (rld::process::tempfile& c,
+                      size_t                  shard,
+                      size_t                  shards)
     {
       c.open (true);
 
@@ -931,9 +1546,24 @@ namespace rld
 
       try
       {
+        /*
+         * The compiler command is part of the file so a kept wrapper is only
+         * reused if it is compiled the same way.
+         */
+        rld::process::arg_container args;
+        rld::cc::make_cc_command (args);
+        rld::cc::append_flags (rld::cc::ft_cflags, args);
+
         c.write_line ("/*");
         c.write_line (" * RTEMS Trace Linker Wrapper");
         c.write_line (" *  Automatically generated.");
+        c.write_line (" *  Compiler: " + rld::join (args, " "));
+        if (shards > 1)
+        {
+          std::stringstream sss;
+          sss << " *  Shard: " << shard + 1 << " of " << shards;
+          c.write_line (sss.str ());
+        }
         c.write_line (" */");
 
         c.write_line ("");
@@ -948,16 +1578,36 @@ namespace rld
         c.write_line (" */");
         c.write_lines (generator_.defines);
         c.write_lines (generator_.headers);
+        generate_timestamps (c);
         c.write_line ("");
         generate_functions (c);
-        generate_names (c);
-        generate_signatures (c);
-        generate_enables (c);
-        generate_triggers (c);
-        c.write_line ("");
-        c.write_lines (generator_.code);
+        if (shard == 0)
+        {
+          generate_names (c);
+          generate_signatures (c);
+          generate_enables (c);
+          generate_triggers (c);
+          generate_samples (c, true);
+          c.write_line ("");
+          c.write_lines (generator_.code);
+        }
+        else
+        {
+          c.write_line ("");
+          if (get_option ("gen-enables") == "static")
+            generate_enables (c, true);
+          else if (get_option ("gen-enables") != "disable")
+            c.write_line ("extern const uint32_t __rtld_trace_enables[];");
+          if (get_option ("gen-triggers") == "static")
+            generate_triggers (c, true);
+          else if (get_option ("gen-triggers") != "disable")
+            c.write_line ("extern const uint32_t __rtld_trace_triggers[];");
+          generate_samples (c, false);
+          c.write_line ("");
+          c.write_lines (generator_.shard_code);
+        }
 
-        generate_traces (c);
+        generate_traces (c, shard, shards);
       }
       catch (...)
       {
@@ -1074,8 +1724,12 @@ namespace rld
             {
               for (size_t a = 0; a < sig.args.size (); ++a)
               {
-                sss << "  { sizeof (" << sig.args[a] << "), \"" << sig.args[a] << "\" },"
-                    << std::endl;
+                sss << "  { ";
+                if (!generator_.arg_pack.empty () && sig.packed (a))
+                  sss << sig.arg_size (a, true);
+                else
+                  sss << "sizeof (" << sig.args[a] << ")";
+                sss << ", \"" << sig.args[a] << "\" }," << std::endl;
               }
             }
             else
@@ -1125,7 +1779,7 @@ namespace rld
     }
 
     void
-    tracer::generate_enables (rld::process::tempfile& c)
+    tracer::generate_enables (rld::process::tempfile& c, bool local)
     {
       const std::string opt = get_option ("gen-enables");
       bool              global_state = false;
@@ -1141,11 +1795,11 @@ namespace rld
       c.write_line (" * Enables.");
       c.write_line (" */");
 
-      generate_bitmap (c, enables, "enables", global_state);
+      generate_bitmap (c, enables, "enables", global_state, local);
     }
 
     void
-    tracer::generate_triggers (rld::process::tempfile& c)
+    tracer::generate_triggers (rld::process::tempfile& c, bool local)
     {
       const std::string opt = get_option ("gen-triggers");
       bool              global_state = false;
@@ -1161,9 +1815,136 @@ namespace rld
       c.write_line (" * Triggers.");
       c.write_line (" */");
 
-      generate_bitmap (c, triggers, "triggers", global_state);
+      generate_bitmap (c, triggers, "triggers", global_state, local);
+
+      c.write_line ("");
+    }
+
+    bool
+    tracer::static_enabled (const std::string& trace) const
+    {
+      if (get_option ("gen-enables") != "static")
+        return true;
+      return std::find (enables.begin (), enables.end (), trace) != enables.end ();
+    }
+
+    uint32_t
+    tracer::sample_rate (const std::string& trace) const
+    {
+      sample_rates::const_iterator si = samples.find (trace);
+      if (si != samples.end ())
+        return (*si).second;
+      const std::string opt = get_option ("sample-rate");
+      if (!opt.empty ())
+      {
+        uint32_t rate = ::strtoul (opt.c_str (), 0, 0);
+        if (rate > 1)
+          return rate;
+      }
+      return 1;
+    }
+
+    bool
+    tracer::sampling () const
+    {
+      for (auto& trace : traces)
+        if (static_enabled (trace) && sample_rate (trace) > 1)
+          return true;
+      return false;
+    }
+
+    void
+    tracer::generate_timestamps (rld::process::tempfile& c)
+    {
+      if (generator_.timestamps.empty ())
+        return;
 
+      /*
+       * The compiler selects the read for the architecture so the read is
+       * inlined into the wrappers.
+       */
       c.write_line ("");
+      c.write_line ("/*");
+      c.write_line (" * Timestamp.");
+      c.write_line (" */");
+
+      /*
+       * The default is last and it is the only read if no architecture has
+       * one.
+       */
+      const bool conditional = !generator_.timestamps.front ().first.empty ();
+
+      for (size_t t = 0; t < generator_.timestamps.size (); ++t)
+      {
+        const std::string& arch = generator_.timestamps[t].first;
+        if (arch.empty ())
+        {
+          if (conditional)
+            c.write_line ("#else");
+        }
+        else
+          c.write_line ((t == 0 ? "#if" : "#elif") + std::string (" defined(") + arch + ')');
+        c.write_line (" #define RTLD_TRACE_TIMESTAMP() (" + generator_.timestamps[t].second + ')');
+        c.write_line (" #define RTLD_TRACE_TIMESTAMP_COUNTER " +
+                      std::string (arch.empty () ? "0" : "1"));
+      }
+
+      if (conditional)
+        c.write_line ("#endif");
+    }
+
+    void
+    tracer::generate_samples (rld::process::tempfile& c, bool first)
+    {
+      if (!sampling ())
+        return;
+
+      /*
+       * A counter per function and processor counts the calls. A processor
+       * only changes its own counters so they are not locked. A count lost
+       * to a preempting call on the same processor only moves a sample.
+       */
+      uint32_t cpus = ::strtoul (get_option ("sample-cpus").c_str (), 0, 0);
+      if (cpus == 0)
+        cpus = 1;
+
+      std::stringstream sss;
+
+      c.write_line ("");
+      c.write_line ("/*");
+      c.write_line (" * Samples.");
+      c.write_line (" */");
+
+      sss << "#define RTLD_TRACE_SAMPLE_CPUS (" << cpus << ")";
+      c.write_line (sss.str ());
+
+      sss.str (std::string ());
+      if (!first)
+        sss << "extern ";
+      sss << "uint32_t __rtld_trace_sample_counts[RTLD_TRACE_SAMPLE_CPUS * "
+          << traces.size () << "];";
+      c.write_line (sss.str ());
+
+      if (cpus > 1)
+        c.write_line ("#include <rtems.h>");
+
+      c.write_line ("static inline int __rtld_trace_sampled(uint32_t func_index, uint32_t rate)");
+      c.write_line ("{");
+      if (cpus > 1)
+      {
+        sss.str (std::string ());
+        sss << " uint32_t* count = &__rtld_trace_sample_counts["
+            << "((rtems_scheduler_get_processor() % RTLD_TRACE_SAMPLE_CPUS) * "
+            << traces.size () << ") + func_index];";
+        c.write_line (sss.str ());
+      }
+      else
+        c.write_line (" uint32_t* count = &__rtld_trace_sample_counts[func_index];");
+      c.write_line (" if (++(*count) < rate)");
+      c.write_line ("  return 0;");
+      c.write_line (" *count = 0;");
+      c.write_line (" return 1;");
+      c.write_line ("}");
     }
 
     void
@@ -1201,18 +1982,33 @@ namespace rld
     }
 
     void
-    tracer::generate_traces (rld::process::tempfile& c)
+    tracer::generate_traces (rld::process::tempfile& c,
+                             size_t                  shard,
+                             size_t                  shards)
     {
       c.write_line ("/*");
       c.write_line (" * Wrappers.");
       c.write_line (" */");
 
+      /*
+       * A shard is a contiguous range of the sorted traces. The function
+       * index is the index in all the traces.
+       */
+      const size_t first = (traces.size () * shard) / shards;
+      const size_t last = (traces.size () * (shard + 1)) / shards;
+
       size_t count = 0;
 
       for (rld::strings::const_iterator ti = traces.begin ();
            ti != traces.end ();
            ++ti)
       {
+        if (count < first || count >= last)
+        {
+          ++count;
+          continue;
+        }
+
         const std::string& trace = *ti;
         bool               found = false;
 
@@ -1240,6 +2036,7 @@ namespace rld
             bool        ds_added = false;
             bool        des_added = false;
             bool        drs_added = false;
+            const bool  pack = !generator_.arg_pack.empty ();
             ds  = "#define FUNC_DATA_SIZE_" + sig.name + " (";
             des = "#define FUNC_DATA_ENTRY_SIZE_" + sig.name + " (";
             drs = "#define FUNC_DATA_RET_SIZE_" + sig.name + " (";
@@ -1256,8 +2053,8 @@ namespace rld
                   des += " + ";
                 else
                   des_added = true;
-                ds += "sizeof(" + sig.args[a] + ')';
-                des += "sizeof(" + sig.args[a] + ')';
+                ds += sig.arg_size (a, pack);
+                des += sig.arg_size (a, pack);
               }
             }
             if (sig.has_ret () && !generator_.ret_trace.empty ())
@@ -1288,6 +2085,31 @@ namespace rld
             c.write_line(sig.decl ("__wrap_"));
             c.write_line("{");
 
+            /*
+             * A trace disabled at link time is a direct call to the real
+             * function with no trace code.
+             */
+            if (!static_enabled (trace))
+            {
+              std::string l = " ";
+              if (sig.has_ret ())
+                l += "return ";
+              l += "__real_" + sig.name + '(';
+              if (sig.has_args ())
+              {
+                for (size_t a = 0; a < sig.args.size (); ++a)
+                {
+                  if (a)
+                    l += ", ";
+                  l += "a" + rld::to_string ((int) (a + 1));
+                }
+              }
+              l += ");";
+              c.write_line(l);
+              c.write_line("}");
+              continue;
+            }
+
             if (!generator_.lock_local.empty ())
               c.write_line(generator_.lock_local);
 
@@ -1299,6 +2121,41 @@ namespace rld
 
             std::string l;
 
+            /*
+             * A sampled trace calls the real function with no trace code
+             * unless the call is sampled.
+             */
+            const uint32_t rate = sample_rate (trace);
+            if (rate > 1)
+            {
+              std::stringstream sss;
+              sss << " if (!__rtld_trace_sampled(" << count << ", " << rate << "))";
+              c.write_line(sss.str ());
+              l = "  ";
+              if (sig.has_ret ())
+                l += "return ";
+              l += "__real_" + sig.name + '(';
+              if (sig.has_args ())
+              {
+                for (size_t a = 0; a < sig.args.size (); ++a)
+                {
+                  if (a)
+                    l += ", ";
+                  l += "a" + rld::to_string ((int) (a + 1));
+                }
+              }
+              l += ");";
+              if (sig.has_ret ())
+                c.write_line(l);
+              else
+              {
+                c.write_line(" {");
+                c.write_line(" " + l);
+                c.write_line("   return;");
+                c.write_line(" }");
+              }
+            }
+
             if (!generator_.lock_acquire.empty ())
               c.write_line(generator_.lock_acquire);
 
@@ -1325,10 +2182,14 @@ namespace rld
               for (size_t a = 0; a < sig.args.size (); ++a)
               {
                 std::string n = rld::to_string ((int) (a + 1));
-                l = " " + generator_.arg_trace;
+                if (pack && sig.packed (a))
+                  l = " " + generator_.arg_pack;
+                else
+                  l = " " + generator_.arg_trace;
                 l = rld::find_replace (l, "@ARG_NUM@", n);
                 l = rld::find_replace (l, "@ARG_TYPE@", '"' + sig.args[a] + '"');
-                l = rld::find_replace (l, "@ARG_SIZE@", "sizeof(" + sig.args[a] + ')');
+                l = rld::find_replace (l, "@ARG_SIZE@", sig.arg_size (a, pack));
+                l = rld::find_replace (l, "@ARG_BITS@", sig.arg_bit_count (a, pack));
                 l = rld::find_replace (l, "@ARG_LABEL@", "a" + n);
                 c.write_line(l);
               }
@@ -1406,14 +2267,18 @@ namespace rld
     tracer::generate_bitmap (rld::process::tempfile& c,
                              const rld::strings&     names,
                              const std::string&      label,
-                             const bool              global_set)
+                             const bool              global_set,
+                             const bool              local)
     {
       uint32_t bitmap_size = ((traces.size () - 1) / (4 * 8)) + 1;
 
       std::stringstream ss;
 
-      ss << "uint32_t __rtld_trace_" << label << "_size = " << traces.size() << ";" << std::endl
-         << "const uint32_t __rtld_trace_" << label << "[" << bitmap_size << "] = " << std::endl
+      if (local)
+        ss << "static ";
+      else
+        ss << "uint32_t __rtld_trace_" << label << "_size = " << traces.size() << ";" << std::endl;
+      ss << "const uint32_t __rtld_trace_" << label << "[" << bitmap_size << "] = " << std::endl
          << "{" << std::endl;
 
       size_t   count = 0;
@@ -1504,7 +2369,8 @@ namespace rld
     void
     linker::load_config (const std::string& name,
                          const std::string& trace,
-                         const std::string& path)
+                         const std::string& path,
+                         const std::string& cache)
     {
       std::string sp = rld::get_prefix ();
 
@@ -1518,16 +2384,127 @@ namespace rld
       if (rld::verbose ())
         std::cout << "search path: " << sp << std::endl;
 
+      /*
+       * The cache entry is keyed by what is resolved. The entry holds the
+       * hashes of the configuration files so a change in any of them is seen.
+       */
+      std::string entry;
+      if (!cache.empty ())
+      {
+        std::ostringstream oss;
+        oss << std::hex << std::setfill ('0') << std::setw (16)
+            << cache_hash (rld::version () + '\0' + name + '\0' +
+                           trace + '\0' + sp)
+            << ".tlc";
+        rld::path::path_join (cache, oss.str (), entry);
+        if (load_cache (entry))
+          return;
+      }
+
       config.set_search_path (sp);
       config.clear ();
       config.load (name);
       tracer_.load (config, trace);
+      paths = config.get_paths ();
+
+      if (!entry.empty ())
+        save_cache (entry);
+    }
+
+    static const char* const cache_magic = "RTLDTC03";
+
+    bool
+    linker::load_cache (const std::string& entry)
+    {
+      std::string data;
+
+      if (!cache_read_file (entry, data))
+        return false;
+
+      try
+      {
+        cache_reader in (data);
+
+        if (in.get_string () != cache_magic)
+          return false;
+
+        rld::config::paths cpaths;
+        uint64_t           count = in.get_value ();
+
+        for (uint64_t p = 0; p < count; ++p)
+        {
+          std::string path = in.get_string ();
+          uint64_t    hash = in.get_value ();
+          std::string content;
+          if (!cache_read_file (path, content) || cache_hash (content) != hash)
+          {
+            if (rld::verbose ())
+              std::cout << "config cache: changed: " << path << std::endl;
+            return false;
+          }
+          cpaths.push_back (path);
+        }
+
+        tracer_.restore (in);
+        paths = cpaths;
+      }
+      catch (rld::error re)
+      {
+        if (rld::verbose ())
+          std::cout << "config cache: invalid: " << entry << std::endl;
+        return false;
+      }
+
+      if (rld::verbose ())
+        std::cout << "config cache: loaded: " << entry << std::endl;
+
+      return true;
+    }
+
+    void
+    linker::save_cache (const std::string& entry)
+    {
+      cache_writer out;
+
+      out.put (cache_magic);
+      out.put (paths.size ());
+      for (auto& path : paths)
+      {
+        std::string content;
+        if (!cache_read_file (path, content))
+          return;
+        out.put (path);
+        out.put (cache_hash (content));
+      }
+      tracer_.save (out);
+
+      /*
+       * Written to a temporary file and renamed so a reader never sees a
+       * partial entry.
+       */
+      std::ostringstream temp;
+      temp << entry << '.' << ::getpid ();
+      std::ofstream cf (temp.str (),
+                        std::ios::out | std::ios::binary | std::ios::trunc);
+      if (cf.is_open ())
+      {
+        cf << out.data ();
+        cf.close ();
+      }
+      if (!cf || ::rename (temp.str ().c_str (), entry.c_str ()) != 0)
+      {
+        ::unlink (temp.str ().c_str ());
+        std::cerr << "warning: cannot write config cache: " << entry
+                  << std::endl;
+      }
     }
 
     void
-    linker::generate_wrapper (rld::process::tempfile& c)
+    linker::generate_wrapper (rld::process::tempfile& c,
+                              size_t                  shard,
+                              size_t                  shards)
     {
-      tracer_.generate (c);
+      tracer_.generate (c, shard, shards);
     }
 
     void
@@ -1549,8 +2526,8 @@ namespace rld
       args.push_back (o.name ());
       args.push_back (c.name ());
 
-      rld::process::tempfile out;
-      rld::process::tempfile err;
+      rld::process::tempfile out (".out", false, true);
+      rld::process::tempfile err (".err", false, true);
       rld::process::status   status;
 
       status = rld::process::execute (rld::cc::get_cc (),
@@ -1569,13 +2546,90 @@ namespace rld
     }
 
     void
-    linker::link (rld::process::tempfile& o,
-                  const std::string&      ld_cmd)
+    linker::build_wrappers (const std::string& wrapper,
+                            unsigned int       jobs)
+    {
+      const size_t shards = tracer_.shards (jobs);
+
+      if (rld::verbose ())
+        std::cout << "wrapper shards: " << shards << std::endl;
+
+      cs.clear ();
+      os.clear ();
+
+      for (size_t s = 0; s < shards; ++s)
+      {
+        cs.emplace_back (".c");
+        os.emplace_back (".o");
+        if (!wrapper.empty ())
+        {
+          std::string name = wrapper;
+          if (s > 0)
+            name += '-' + std::to_string (s);
+          cs.back ().override (name);
+          cs.back ().keep ();
+          os.back ().override (name);
+          os.back ().keep ();
+        }
+      }
+
+      std::vector < rld::process::tempfile* > shard_cs;
+      std::vector < rld::process::tempfile* > shard_os;
+      for (auto& c : cs)
+        shard_cs.push_back (&c);
+      for (auto& o : os)
+        shard_os.push_back (&o);
+
+      rld::tasks::parallel_for (shards, jobs, [&] (size_t s) {
+        rld::process::tempfile& c = *shard_cs[s];
+        rld::process::tempfile& o = *shard_os[s];
+
+        /*
+         * A kept wrapper's object is reused if the C file generated is
+         * the same as the last one.
+         */
+        std::string previous;
+        if (!wrapper.empty () &&
+            rld::path::check_file (c.name ()) &&
+            rld::path::check_file (o.name ()))
+        {
+          std::ifstream in (c.name ());
+          std::stringstream pss;
+          pss << in.rdbuf ();
+          previous = pss.str ();
+        }
+
+        {
+          rld::span span ("generate wrapper " + std::to_string (s));
+          generate_wrapper (c, s, shards);
+        }
+
+        if (!previous.empty ())
+        {
+          std::string current;
+          c.open ();
+          c.read (current);
+          c.close ();
+          if (current == previous)
+          {
+            if (rld::verbose ())
+              std::cout << "wrapper O file reused: " << o.name () << std::endl;
+            return;
+          }
+        }
+
+        compile_wrapper (c, o);
+      });
+    }
+
+    void
+    linker::link (const std::string& ld_cmd)
     {
      rld::process::arg_container args;
 
       if (rld::verbose ())
-        std::cout << "linking: " << o.name () << std::endl;
+        for (auto& o : os)
+          std::cout << "linking: " << o.name () << std::endl;
 
       std::string wrap = " -Wl,--wrap=";
 
@@ -1583,11 +2637,12 @@ namespace rld
 
       rld::process::args_append (args,
                                  wrap + rld::join (tracer_.get_traces (), wrap));
-      args.push_back (o.name ());
+      for (auto& o : os)
+        args.push_back (o.name ());
       rld::process::args_append (args, ld_cmd);
 
-      rld::process::tempfile out;
-      rld::process::tempfile err;
+      rld::process::tempfile out (".out", false, true);
+      rld::process::tempfile err (".err", false, true);
       rld::process::status   status;
 
       status = rld::process::execute (rld::cc::get_ld (),
@@ -1607,10 +2662,9 @@ namespace rld
     void
     linker::dump (std::ostream& out) const
     {
-      const rld::config::paths& cpaths = config.get_paths ();
-      out << " Configuration Files: " << cpaths.size () << std::endl;
-      for (rld::config::paths::const_iterator pi = cpaths.begin ();
-           pi != cpaths.end ();
+      out << " Configuration Files: " << paths.size () << std::endl;
+      for (rld::config::paths::const_iterator pi = paths.begin ();
+           pi != paths.end ();
            ++pi)
       {
         out << "  " << (*pi) << std::endl;
@@ -1641,6 +2695,9 @@ static struct option rld_opts[] = {
   { "config",      required_argument,      NULL,           'C' },
   { "path",        required_argument,      NULL,           'P' },
   { "wrapper",     required_argument,      NULL,           'W' },
+  { "jobs",        required_argument,      NULL,           'j' },
+  { "config-cache", required_argument,     NULL,           'K' },
+  { "trace-events", required_argument,     NULL,           'T' },
   { NULL,          0,                      NULL,            0 }
 };
 
@@ -1662,8 +2719,15 @@ usage (int exit_code)
             << " -r path     : RTEMS path (also --rtems)" << std::endl
             << " -B bsp      : RTEMS arch/bsp (also --rtems-bsp)" << std::endl
             << " -W wrapper  : wrapper file name without ext (also --wrapper)" << std::endl
+            << " -j jobs     : wrapper files compiled in parallel, 0 for all" << std::endl
+            << "               cores, the default is $" RLD_TASKS_JOBS_ENV " or 1" << std::endl
+            << "               (also --jobs)" << std::endl
             << " -C ini      : user configuration INI file (also --config)" << std::endl
-            << " -P path     : user configuration file search path (also --path)" << std::endl;
+            << " -P path     : user configuration file search path (also --path)" << std::endl
+            << " -K dir      : resolved configuration and package cache directory"
+            << "               (also --config-cache)" << std::endl
+            << " -T file     : write the time of each stage as Chrome trace" << std::endl
+            << "               events (also --trace-events)" << std::endl;
   ::exit (exit_code);
 }
 
@@ -1720,12 +2784,14 @@ main (int argc, char* argv[])
     std::string        wrapper;
     std::string        rtems_path;
     std::string        rtems_arch_bsp;
+    unsigned int       jobs = rld::tasks::default_jobs ();
+    std::string        config_cache;
 
     rld::set_cmdline (argc, argv);
 
     while (true)
     {
-      int opt = ::getopt_long (argc, argv, "hvwkVc:l:E:f:C:P:r:B:W:", rld_opts, NULL);
+      int opt = ::getopt_long (argc, argv, "hvwkVc:l:E:f:C:P:r:B:W:j:K:T:", rld_opts, NULL);
       if (opt < 0)
         break;
 
@@ -1790,6 +2856,19 @@ main (int argc, char* argv[])
           wrapper = optarg;
           break;
 
+        case 'K':
+          config_cache = optarg;
+          pkgconfig::set_cache (optarg);
+          break;
+
+        case 'T':
+          rld::trace_events_enable (optarg);
+          break;
+
+        case 'j':
+          jobs = rld::tasks::parse_jobs (optarg);
+          break;
+
         case '?':
           usage (3);
           break;
@@ -1808,6 +2887,8 @@ main (int argc, char* argv[])
     argc -= optind;
     argv += optind;
 
+    rld::tasks::set_jobs (jobs);
+
     if (rld::verbose ())
     {
       std::cout << "RTEMS Trace Linker " << rld::version () << std::endl;
@@ -1861,22 +2942,18 @@ main (int argc, char* argv[])
      */
     try
     {
-      linker.load_config (configuration, trace, path);
-
-      rld::process::tempfile c (".c");
-      rld::process::tempfile o (".o");
-
-      if (!wrapper.empty ())
       {
-        c.override (wrapper);
-        c.keep ();
-        o.override (wrapper);
-        o.keep ();
+        rld::span span ("load config");
+        linker.load_config (configuration, trace, path, config_cache);
+      }
+      {
+        rld::span span ("build wrappers");
+        linker.build_wrappers (wrapper, jobs);
+      }
+      {
+        rld::span span ("link");
+        linker.link (ld_cmd);
       }
-
-      linker.generate_wrapper (c);
-      linker.compile_wrapper (c, o);
-      linker.link (o, ld_cmd);
 
       if (rld::verbose ())
         linker.dump (std::cout);
@@ -1886,6 +2963,8 @@ main (int argc, char* argv[])
       throw;
     }
 
+    rld::trace_events_write ();
+
   }
   catch (rld::error re)
   {
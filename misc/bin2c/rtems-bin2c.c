@@ -18,6 +18,7 @@
  *    -s    add the "static" keywork to definition
  *    -v    verbose
  *    -z    terminate the array with a zero (useful for embedded C strings)
+ *    -i    include the input file with an assembler .incbin directive
  *
  * examples:
  *     bin2c -c myimage.png myimage_png.cpp
@@ -42,8 +43,17 @@ int verbose = 0;
 int zeroterminated = 0;
 int createC = 1;
 int createH = 1;
+int incbin = 0;
 unsigned int align = 0;
 
+/*
+ * The input is converted a block at a time. Each byte is written as
+ * "0x??, " and a line holds BYTES_PER_LINE of them.
+ */
+#define BLOCK_SIZE (64 * 1024)
+#define BYTES_PER_LINE 12
+#define LINE_SIZE (3 + (BYTES_PER_LINE * 6))
+
 static void sanitize_file_name(char *p)
 {
   while (*p != '\0') {
@@ -53,14 +63,116 @@ static void sanitize_file_name(char *p)
   }
 }
 
-int myfgetc(FILE *f)
+static void write_array(FILE *ifile, FILE *ocfile)
+{
+  static const char hex[] = "0123456789abcdef";
+  static unsigned char in[BLOCK_SIZE + 1];
+  static char out[((BLOCK_SIZE + 1) / BYTES_PER_LINE + 1) * LINE_SIZE];
+  size_t col = 0;
+  int zero = zeroterminated;
+
+  while (1) {
+    size_t n = fread(in, 1, BLOCK_SIZE, ifile);
+    size_t i;
+    char *o = out;
+
+    if (n < BLOCK_SIZE && zero) {
+      in[n++] = 0;
+      zero = 0;
+    }
+
+    for (i = 0; i < n; ++i) {
+      if (col == BYTES_PER_LINE) {
+        *o++ = '\n';
+        *o++ = ' ';
+        *o++ = ' ';
+        col = 0;
+      }
+      o[0] = '0';
+      o[1] = 'x';
+      o[2] = hex[in[i] >> 4];
+      o[3] = hex[in[i] & 0xf];
+      o[4] = ',';
+      o[5] = ' ';
+      o += 6;
+      ++col;
+    }
+
+    if (o != out && fwrite(out, 1, o - out, ocfile) != (size_t) (o - out)) {
+      fprintf(stderr, "error: cannot write C file\n");
+      exit(1);
+    }
+
+    if (n < BLOCK_SIZE) {
+      if (ferror(ifile)) {
+        fprintf(stderr, "error: cannot read input file\n");
+        exit(1);
+      }
+      break;
+    }
+  }
+}
+
+static void write_incbin(
+  FILE *ocfile,
+  const char *ifname,
+  const char *name,
+  long size
+)
 {
-  int c = fgetc(f);
-  if (c == EOF && zeroterminated) {
-    zeroterminated = 0;
-    return 0;
+  const char *p;
+
+  /*
+   * The symbol is defined by the assembler so the compiler does not see the
+   * data. The size is the size of the input file when it was converted.
+   */
+  fprintf(
+    ocfile,
+    "#define BIN2C_STR(s) #s\n"
+    "#define BIN2C_XSTR(s) BIN2C_STR(s)\n"
+    "#ifdef __USER_LABEL_PREFIX__\n"
+    "#define BIN2C_SYM(s) BIN2C_XSTR(__USER_LABEL_PREFIX__) #s\n"
+    "#else\n"
+    "#define BIN2C_SYM(s) #s\n"
+    "#endif\n"
+    "\n"
+    "__asm__(\n"
+    "  \"  .pushsection %s\\n\"\n",
+    useconst ? ".rodata" : ".data"
+  );
+  if (!usestatic) {
+    fprintf(ocfile, "  \"  .global \" BIN2C_SYM(%s) \"\\n\"\n", name);
   }
-  return c;
+  if (align > 0) {
+    fprintf(ocfile, "  \"  .balign %u\\n\"\n", align);
+  }
+  fprintf(ocfile, "  BIN2C_SYM(%s) \":\\n\"\n", name);
+  fprintf(ocfile, "  \"  .incbin \\\"");
+  for (p = ifname; *p != '\0'; ++p) {
+    if (*p == '"' || *p == '\\') {
+      fputs("\\\\\\", ocfile);
+    }
+    fputc(*p, ocfile);
+  }
+  fprintf(ocfile, "\\\"\\n\"\n");
+  if (zeroterminated) {
+    fprintf(ocfile, "  \"  .byte 0\\n\"\n");
+  }
+  fprintf(
+    ocfile,
+    "  \"  .popsection\\n\"\n"
+    ");\n"
+    "\n"
+    "extern %sunsigned char %s[];\n"
+    "\n"
+    "%s%ssize_t %s_size = %ld;\n",
+    ((useconst) ? "const " : ""),
+    name,
+    ((usestatic) ? "static " : ""),
+    ((useconst) ? "const " : ""),
+    name,
+    size + (zeroterminated ? 1 : 0)
+  );
 }
 
 void process(const char *ifname, const char *ofname, const char *forced_name)
@@ -118,6 +230,7 @@ void process(const char *ifname, const char *ofname, const char *forced_name)
       fprintf(stderr, "cannot open %s for writing\n", ocname);
       exit(1);
     }
+    setvbuf(ocfile, NULL, _IOFBF, BLOCK_SIZE);
   }
 
   if ( createH ) {
@@ -173,47 +286,48 @@ void process(const char *ifname, const char *ofname, const char *forced_name)
       ifbasename
     );
 
-    /* print structure */
-    fprintf(
-      ocfile,
-      "%s%sunsigned char %s[] ",
-      ((usestatic) ? "static " : ""),
-      ((useconst) ? "const " : ""),
-      buf
-    );
-    if (align > 0) {
+    if ( incbin ) {
+      long size;
+
+      if (fseek(ifile, 0, SEEK_END) != 0 || (size = ftell(ifile)) < 0) {
+        fprintf(stderr, "error: cannot get the size of %s\n", ifname);
+        exit(1);
+      }
+      write_incbin(ocfile, ifname, buf, size);
+    } else {
+      /* print structure */
       fprintf(
         ocfile,
-        "__attribute__(( __aligned__(%d) )) ",
-        align
+        "%s%sunsigned char %s[] ",
+        ((usestatic) ? "static " : ""),
+        ((useconst) ? "const " : ""),
+        buf
       );
-    }
-    fprintf(
-      ocfile,
-      "= {\n  "
-    );
-    int c, col = 1;
-    while ((c = myfgetc(ifile)) != EOF) {
-      if (col >= 78 - 6) {
-        fprintf(ocfile, "\n  ");
-        col = 1;
+      if (align > 0) {
+        fprintf(
+          ocfile,
+          "__attribute__(( __aligned__(%d) )) ",
+          align
+        );
       }
-      fprintf(ocfile, "0x%.2x, ", c);
-      col += 6;
-
-    }
-    fprintf(ocfile, "\n};\n");
+      fprintf(
+        ocfile,
+        "= {\n  "
+      );
+      write_array(ifile, ocfile);
+      fprintf(ocfile, "\n};\n");
 
-    /* print sizeof */
-    fprintf(
-      ocfile,
-      "\n"
-      "%s%ssize_t %s_size = sizeof(%s);\n",
-      ((usestatic) ? "static " : ""),
-      ((useconst) ? "const " : ""),
-      buf,
-      buf
-    );
+      /* print sizeof */
+      fprintf(
+        ocfile,
+        "\n"
+        "%s%ssize_t %s_size = sizeof(%s);\n",
+        ((usestatic) ? "static " : ""),
+        ((useconst) ? "const " : ""),
+        buf,
+        buf
+      );
+    } /* incbin */
   } /* createC */
 
   /*****************************************************************/
@@ -293,7 +407,7 @@ void usage(void)
 {
   fprintf(
      stderr,
-     "usage: bin2c [-csvzCH] [-N name] [-A alignment] <input_file> <output_file>\n"
+     "usage: bin2c [-csvziCH] [-N name] [-A alignment] <input_file> <output_file>\n"
      "  <input_file> is the binary file to convert\n"
      "  <output_file> should not have a .c or .h extension\n"
      "\n"
@@ -301,6 +415,8 @@ void usage(void)
      "  -s - do use static in declaration\n"
      "  -v - verbose\n"
      "  -z - add zero terminator\n"
+     "  -i - include the input file with an assembler .incbin directive,\n"
+     "       the C file must be compiled where the input file is found\n"
      "  -H - create c-header only\n"
      "  -C - create c-source file only\n"
      "  -N - force name of data array\n"
@@ -329,6 +445,10 @@ int main(int argc, char **argv)
       zeroterminated = 1;
       --argc;
       ++argv;
+    } else if (!strcmp(argv[1], "-i")) {
+      incbin = 1;
+      --argc;
+      ++argv;
     } else if (!strcmp(argv[1], "-C")) {
       createH = 0;
       createC = 1;
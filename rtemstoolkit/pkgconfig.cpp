@@ -16,13 +16,64 @@
 
 #include <algorithm>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <string>
 
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <rld.h>
+#include <rld-hash.h>
 #include <pkgconfig.h>
 
 namespace pkgconfig
 {
+  /**
+   * The package cache directory.
+   */
+  static std::string cache;
+
+  /**
+   * The first line of a cache entry. Change it if the format changes.
+   */
+  static const std::string cache_magic = "RLDPKG01";
+
+  void
+  set_cache (const std::string& path)
+  {
+    cache = path;
+  }
+
+  /**
+   * The cache entry is the hash of the tool version and the path,
+   * modification time and size of the package file. An empty entry is
+   * returned if there is no cache or the package cannot be found.
+   */
+  static const std::string
+  cache_entry (const std::string& name)
+  {
+    if (cache.empty ())
+      return "";
+
+    struct stat sb;
+    if (::stat (name.c_str (), &sb) != 0)
+      return "";
+
+    std::ostringstream key;
+    key << rld::version () << '\0' << name << '\0'
+        << sb.st_mtime << '\0' << sb.st_size;
+
+    std::ostringstream oss;
+    oss << std::hex << std::setfill ('0') << std::setw (16)
+        << rld::hash::hash (key.str ()) << ".pc";
+
+    std::string entry;
+    rld::path::path_join (cache, oss.str (), entry);
+    return entry;
+  }
+
   package::package (const std::string& name)
   {
     load (name);
@@ -35,16 +86,92 @@ namespace pkgconfig
   void
   package::load (const std::string& name)
   {
-    std::ifstream in (name.c_str (), std::ios::in);
+    const std::string entry = cache_entry (name);
 
-    while (!in.eof ())
+    if (cache_get (entry))
+      return;
+
+    parse (name);
+
+    if (!entry.empty ())
     {
-      char buffer[1024];
+      /*
+       * Resolve the fields so the entry does not need the defines.
+       */
+      table resolved;
+      for (auto& f : fields)
+        get (f.first, resolved[f.first]);
+      fields.swap (resolved);
+      defines.clear ();
+      cache_put (entry);
+    }
+  }
 
-      in.getline (buffer, sizeof (buffer));
+  bool
+  package::cache_get (const std::string& entry)
+  {
+    if (entry.empty ())
+      return false;
 
-      std::string line (buffer);
-      size_t      hash;
+    std::ifstream in (entry.c_str (), std::ios::in);
+    if (!in.is_open ())
+      return false;
+
+    std::string line;
+    if (!std::getline (in, line) || line != cache_magic)
+      return false;
+
+    table resolved;
+    while (std::getline (in, line))
+    {
+      size_t eq = line.find ('=');
+      if (eq == std::string::npos)
+        return false;
+      resolved[line.substr (0, eq)] = line.substr (eq + 1);
+    }
+
+    defines.clear ();
+    fields.swap (resolved);
+
+    if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+      std::cout << "pkgconfig::cache: " << entry << std::endl;
+
+    return true;
+  }
+
+  /**
+   * The entry is written to a temporary file and renamed so a reader never
+   * sees a partial entry.
+   */
+  void
+  package::cache_put (const std::string& entry)
+  {
+    std::ostringstream temp;
+    temp << entry << '.' << ::getpid ();
+    std::ofstream cf (temp.str ().c_str (), std::ios::out | std::ios::trunc);
+    if (cf.is_open ())
+    {
+      cf << cache_magic << std::endl;
+      for (auto& f : fields)
+        cf << f.first << '=' << f.second << std::endl;
+      cf.close ();
+      if (cf && ::rename (temp.str ().c_str (), entry.c_str ()) == 0)
+        return;
+      ::unlink (temp.str ().c_str ());
+    }
+    std::cerr << "warning: cannot write package cache: " << entry
+              << std::endl;
+  }
+
+  void
+  package::parse (const std::string& name)
+  {
+    std::ifstream in (name.c_str (), std::ios::in);
+    std::string   line;
+
+    while (std::getline (in, line))
+    {
+      size_t hash;
 
       hash = line.find ('#');
       if (hash != std::string::npos)
@@ -22,6 +22,16 @@
 
 namespace pkgconfig
 {
+  /**
+   * Set the directory of the package cache. The resolved fields of a package
+   * are held in the cache keyed by the package file's path, modification time
+   * and size so the tools do not parse and resolve the same packages on each
+   * start. An empty path disables the cache.
+   *
+   * @param path The cache directory.
+   */
+  void set_cache (const std::string& path);
+
   /**
    * A simple class to parse a pkgconfig file as used in RTEMS. The RTEMS use
    * is simple and basically provides a simplified method to manage the various
@@ -46,7 +56,8 @@ namespace pkgconfig
     package ();
 
     /**
-     * Load a package configuration file.
+     * Load a package configuration file. The resolved fields are loaded from
+     * the cache if it has the package.
      *
      * @param name The file name of the package.
      */
@@ -63,6 +74,21 @@ namespace pkgconfig
     bool get (const std::string& label, std::string& result);
 
   private:
+    /**
+     * Parse a package configuration file.
+     */
+    void parse (const std::string& name);
+
+    /**
+     * Load the resolved fields from the cache entry.
+     */
+    bool cache_get (const std::string& entry);
+
+    /**
+     * Write the resolved fields to the cache entry.
+     */
+    void cache_put (const std::string& entry);
+
     table defines;  ///< The defines.
     table fields;   ///< The fields.
   };
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2026, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems-ld
+ *
+ * @brief Allocation profiling of the tools.
+ *
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <stdlib.h>
+
+#if HAVE_MALLOC_USABLE_SIZE
+#include <malloc.h>
+#endif
+
+#include <rld.h>
+#include <rld-alloc.h>
+
+namespace rld
+{
+  namespace alloc
+  {
+    /*
+     * The counters are constant initialised so allocations made before the
+     * static constructors run are safe.
+     */
+    static bool                    profiling = false;
+    static std::atomic < uint64_t > allocs (0);
+    static std::atomic < uint64_t > frees (0);
+    static std::atomic < uint64_t > bytes (0);
+    static std::atomic < int64_t >  live (0);
+    static std::atomic < int64_t >  peak (0);
+
+    /*
+     * The phases in the order they are first recorded. They are allocated
+     * and not freed so they can be reported at exit.
+     */
+    struct phase_counters
+    {
+      std::string name;
+      uint64_t    calls;
+      uint64_t    allocs;
+      uint64_t    bytes;
+      int64_t     live;
+    };
+
+    typedef std::vector < phase_counters > phase_table;
+
+    static std::string*                   report_path;
+    static phase_table*                   phases;
+    static std::map < std::string, int >* phase_index;
+    static std::mutex                     phase_lock;
+
+    static void
+    report_at_exit ()
+    {
+      profiling = false;
+      if (*report_path == "-")
+        report (std::cerr);
+      else
+      {
+        std::ofstream out (report_path->c_str (),
+                           std::ios::out | std::ios::trunc);
+        if (out.is_open ())
+          report (out);
+        else
+          std::cerr << "error: alloc-profile: cannot open: "
+                    << *report_path << std::endl;
+      }
+    }
+
+    bool
+    enable (const std::string& path)
+    {
+#if HAVE_MALLOC_USABLE_SIZE
+      if (!profiling)
+      {
+        report_path = new std::string (path);
+        phases = new phase_table;
+        phase_index = new std::map < std::string, int >;
+        ::atexit (report_at_exit);
+        profiling = true;
+      }
+      return true;
+#else
+      (void) path;
+      return false;
+#endif
+    }
+
+    bool
+    enabled ()
+    {
+      return profiling;
+    }
+
+    void
+    get (counters& c)
+    {
+      c.allocs = allocs.load (std::memory_order_relaxed);
+      c.frees = frees.load (std::memory_order_relaxed);
+      c.bytes = bytes.load (std::memory_order_relaxed);
+      c.live = live.load (std::memory_order_relaxed);
+      c.peak = peak.load (std::memory_order_relaxed);
+    }
+
+    void
+    phase (const std::string& name, const counters& begin)
+    {
+      if (!profiling)
+        return;
+
+      counters end;
+      get (end);
+
+      std::lock_guard < std::mutex > guard (phase_lock);
+
+      auto pi = phase_index->find (name);
+      if (pi == phase_index->end ())
+      {
+        phase_counters pc = { name, 0, 0, 0, 0 };
+        pi = phase_index->insert (
+          std::make_pair (name, (int) phases->size ())).first;
+        phases->push_back (pc);
+      }
+
+      phase_counters& pc = (*phases)[pi->second];
+
+      ++pc.calls;
+      pc.allocs += end.allocs - begin.allocs;
+      pc.bytes += end.bytes - begin.bytes;
+      pc.live += end.live - begin.live;
+    }
+
+    void
+    report (std::ostream& out)
+    {
+      counters c;
+
+      get (c);
+
+      out << "Allocations: " << get_program_name () << std::endl
+          << " allocs: " << c.allocs
+          << " frees: " << c.frees
+          << " bytes: " << c.bytes
+          << " live: " << c.live
+          << " peak live: " << c.peak << std::endl;
+
+      if (phases == nullptr || phases->empty ())
+        return;
+
+      std::lock_guard < std::mutex > guard (phase_lock);
+
+      size_t width = 5;
+      for (auto& pc : *phases)
+        if (pc.name.size () > width)
+          width = pc.name.size ();
+
+      out << ' ' << std::left << std::setw (width) << "phase" << std::right
+          << std::setw (8) << "calls"
+          << std::setw (12) << "allocs"
+          << std::setw (14) << "bytes"
+          << std::setw (14) << "live" << std::endl;
+
+      for (auto& pc : *phases)
+        out << ' ' << std::left << std::setw (width) << pc.name << std::right
+            << std::setw (8) << pc.calls
+            << std::setw (12) << pc.allocs
+            << std::setw (14) << pc.bytes
+            << std::setw (14) << pc.live << std::endl;
+    }
+
+#if HAVE_MALLOC_USABLE_SIZE
+    static inline void
+    allocated (void* ptr)
+    {
+      const int64_t size = ::malloc_usable_size (ptr);
+      allocs.fetch_add (1, std::memory_order_relaxed);
+      bytes.fetch_add (size, std::memory_order_relaxed);
+      const int64_t now = live.fetch_add (size, std::memory_order_relaxed) + size;
+      int64_t       high = peak.load (std::memory_order_relaxed);
+      while (now > high &&
+             !peak.compare_exchange_weak (high, now, std::memory_order_relaxed))
+        ;
+    }
+
+    static inline void
+    freed (void* ptr)
+    {
+      frees.fetch_add (1, std::memory_order_relaxed);
+      live.fetch_sub (::malloc_usable_size (ptr), std::memory_order_relaxed);
+    }
+
+    /*
+     * Enable the profiling from the environment when the tool starts.
+     */
+    static struct enable_from_environment
+    {
+      enable_from_environment ()
+      {
+        const char* path = ::getenv ("RLD_ALLOC_PROFILE");
+        if (path != nullptr && *path != '\0')
+          enable (path);
+      }
+    } enable_at_start;
+#endif
+  }
+}
+
+#if HAVE_MALLOC_USABLE_SIZE
+/*
+ * The replacement allocation operators. The other forms of the operators
+ * call these.
+ */
+void*
+operator new (std::size_t size)
+{
+  if (size == 0)
+    size = 1;
+
+  void* ptr;
+
+  while ((ptr = ::malloc (size)) == nullptr)
+  {
+    std::new_handler handler = std::get_new_handler ();
+    if (handler == nullptr)
+      throw std::bad_alloc ();
+    handler ();
+  }
+
+  if (rld::alloc::profiling)
+    rld::alloc::allocated (ptr);
+
+  return ptr;
+}
+
+void
+operator delete (void* ptr) noexcept
+{
+  if (ptr == nullptr)
+    return;
+
+  if (rld::alloc::profiling)
+    rld::alloc::freed (ptr);
+
+  ::free (ptr);
+}
+
+void
+operator delete (void* ptr, std::size_t) noexcept
+{
+  ::operator delete (ptr);
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems-ld
+ *
+ * @brief Allocation profiling of the tools.
+ *
+ * The C++ allocation operators are replaced to count the allocations, the
+ * bytes allocated and the live bytes. The counts are kept when the profiling
+ * is enabled with the RLD_ALLOC_PROFILE environment variable set to the file
+ * the report is written to at exit, or "-" for stderr. The rld::span phases
+ * record the allocations made while they are active. The bytes are the
+ * usable sizes of the allocations. The live bytes do not include the
+ * allocations made before the profiling is enabled and so can be negative.
+ */
+
+#if !defined (_RLD_ALLOC_H_)
+#define _RLD_ALLOC_H_
+
+#include <iostream>
+#include <string>
+
+#include <stdint.h>
+
+namespace rld
+{
+  namespace alloc
+  {
+    /**
+     * The allocation counters.
+     */
+    struct counters
+    {
+      uint64_t allocs;  //< The number of allocations.
+      uint64_t frees;   //< The number of frees.
+      uint64_t bytes;   //< The bytes allocated.
+      int64_t  live;    //< The bytes allocated and not freed.
+      int64_t  peak;    //< The peak of the live bytes.
+    };
+
+    /**
+     * Enable the profiling and write the report to the path at exit. A path
+     * of "-" writes to stderr. The profiling cannot be enabled if the host
+     * cannot get the size of an allocation.
+     *
+     * @param path The path of the report.
+     * @retval true The profiling is enabled.
+     * @retval false The profiling is not supported on the host.
+     */
+    bool enable (const std::string& path);
+
+    /**
+     * Is the profiling enabled?
+     */
+    bool enabled ();
+
+    /**
+     * Get the counters of the process.
+     *
+     * @param c The counters.
+     */
+    void get (counters& c);
+
+    /**
+     * Record the allocations of a phase. A phase can be recorded more than
+     * once and from more than one thread. The allocations of other threads
+     * while the phase is active are included.
+     *
+     * @param name The name of the phase.
+     * @param begin The counters when the phase began.
+     */
+    void phase (const std::string& name, const counters& begin);
+
+    /**
+     * Report the counters of the process and the phases.
+     *
+     * @param out The stream to report to.
+     */
+    void report (std::ostream& out);
+  }
+}
+
+#endif
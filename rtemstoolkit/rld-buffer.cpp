@@ -29,19 +29,34 @@ namespace rld
         le (le),
         in (0),
         out (0),
-        level_ (0)
+        level_ (0),
+        owner (true)
     {
       data = new uint8_t[size];
       clear ();
     }
 
+    buffer::buffer (void* data_, const size_t size, const size_t level, bool le)
+      : data (static_cast < uint8_t* > (data_)),
+        size (size),
+        le (le),
+        in (0),
+        out (level),
+        level_ (level),
+        owner (false)
+    {
+      if (level > size)
+        throw rld::error ("Invalid level", "buffer:view");
+    }
+
     buffer::buffer ()
       : data (0),
         size (0),
         le (true),
         in (0),
         out (0),
-        level_ (0)
+        level_ (0),
+        owner (true)
     {
     }
 
@@ -51,7 +66,8 @@ namespace rld
         le (orig.le),
         in (orig.in),
         out (orig.out),
-        level_ (orig.level_)
+        level_ (orig.level_),
+        owner (true)
     {
       data = new uint8_t[size];
       memcpy (data, orig.data, size);
@@ -59,7 +75,7 @@ namespace rld
 
     buffer::~buffer ()
     {
-      if (data)
+      if (owner && data)
         delete [] data;
     }
 
@@ -111,6 +127,44 @@ namespace rld
       fill (out_ - out, value);
     }
 
+    void
+    buffer::skip (const size_t length)
+    {
+      if ((in + length) > level_)
+        throw rld::error ("Buffer underflow", "buffer:skip");
+      in += length;
+    }
+
+    void
+    buffer::rewind (const size_t in_)
+    {
+      if (in_ > level_)
+        throw rld::error ("Invalid rewind in", "buffer:rewind");
+      in = in_;
+    }
+
+    uint8_t*
+    buffer::reserve (const size_t length)
+    {
+      if ((out + length) > size)
+        throw rld::error ("Buffer overflow", "buffer:reserve");
+      uint8_t* space = &data[out];
+      out += length;
+      if (out > level_)
+        level_ = out;
+      return space;
+    }
+
+    const uint8_t*
+    buffer::take (const size_t length)
+    {
+      if ((in + length) > level_)
+        throw rld::error ("Buffer underflow", "buffer:take");
+      const uint8_t* taken = &data[in];
+      in += length;
+      return taken;
+    }
+
     size_t
     buffer::level () const
     {
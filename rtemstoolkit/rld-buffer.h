@@ -27,6 +27,8 @@
 
 #include <string>
 
+#include <string.h>
+
 #include <rld-files.h>
 
 namespace rld
@@ -44,13 +46,25 @@ namespace rld
        */
       buffer (const size_t size, bool le = true);
 
+      /**
+       * Create a buffer that is a view of existing memory. The memory is not
+       * copied and is not freed when the buffer is destroyed. The data up to
+       * the level can be read and data can be written up to the size.
+       *
+       * @param data_ The memory the buffer views.
+       * @param size The size of the memory in bytes.
+       * @param level The amount of data in the memory to read.
+       * @param le The byte order of the data.
+       */
+      buffer (void* data_, const size_t size, const size_t level, bool le = true);
+
       /**
        * An empty buffer
        */
       buffer ();
 
       /**
-       * Copy a buffer.
+       * Copy a buffer. A copy of a view owns a copy of the memory.
        */
       buffer (const buffer& orig);
 
@@ -118,6 +132,24 @@ namespace rld
        */
       void rewind (const size_t in_);
 
+      /**
+       * Reserve the space in the buffer to write the length of data moving the
+       * write pointer. The data is written by the caller.
+       *
+       * @param length The amount of data in bytes to reserve.
+       * @return uint8_t* The address of the space in the buffer.
+       */
+      uint8_t* reserve (const size_t length);
+
+      /**
+       * Take the length of data from the buffer moving the read pointer. The
+       * data is valid until the buffer is cleared or destroyed.
+       *
+       * @param length The amount of data in bytes to take.
+       * @return const uint8_t* The address of the data in the buffer.
+       */
+      const uint8_t* take (const size_t length);
+
       /*
        * The level in the buffer.
        */
@@ -145,8 +177,67 @@ namespace rld
       size_t   in;      //< The data in pointer, used when writing.
       size_t   out;     //< The data out ponter, used when reading.
       size_t   level_;  //< The level of data in the buffer.
+      bool     owner;   //< True if the buffer frees the data.
     };
 
+    /**
+     * Return true if the host byte order is little-endian.
+     */
+    inline bool host_little_endian ()
+    {
+      const uint16_t v = 1;
+      return *reinterpret_cast < const uint8_t* > (&v) == 1;
+    }
+
+    /**
+     * Swap the bytes of the values. These are the compiler's builtins so a
+     * loop of swaps can be vectorised.
+     */
+    inline uint8_t byte_swap (const uint8_t value)
+    {
+      return value;
+    }
+
+    inline uint16_t byte_swap (const uint16_t value)
+    {
+      return __builtin_bswap16 (value);
+    }
+
+    inline uint32_t byte_swap (const uint32_t value)
+    {
+      return __builtin_bswap32 (value);
+    }
+
+    inline uint64_t byte_swap (const uint64_t value)
+    {
+      return __builtin_bswap64 (value);
+    }
+
+    /**
+     * Copy the count of values from one place to another swapping the bytes of
+     * each value if the byte order of the buffer is not the host's. The
+     * places may be the same.
+     */
+    template < typename T >
+    void copy_values (const buffer& buf,
+                      uint8_t*      to,
+                      const uint8_t* from,
+                      const size_t   count)
+    {
+      if (to != from)
+        ::memcpy (to, from, count * sizeof (T));
+      if (buf.little_endian () != host_little_endian ())
+      {
+        for (size_t i = 0; i < count; ++i)
+        {
+          T v;
+          ::memcpy (&v, to + (i * sizeof (T)), sizeof (T));
+          v = byte_swap (v);
+          ::memcpy (to + (i * sizeof (T)), &v, sizeof (T));
+        }
+      }
+    }
+
     /**
      * Buffer template function for writing data to the buffer.
      */
@@ -157,19 +248,19 @@ namespace rld
       T       v = value;
       if (buf.little_endian ())
       {
-        size_t b = sizeof (T);
-        while (b != 0)
+        size_t b = 0;
+        while (b < sizeof (T))
         {
-          bytes[--b] = (uint8_t) v;
+          bytes[b++] = (uint8_t) v;
           v >>= 8;
         }
       }
       else
       {
-        size_t b = 0;
-        while (b < sizeof (T))
+        size_t b = sizeof (T);
+        while (b != 0)
         {
-          bytes[b++] = (uint8_t) v;
+          bytes[--b] = (uint8_t) v;
           v >>= 8;
         }
       }
@@ -205,6 +296,43 @@ namespace rld
       }
     }
 
+    /**
+     * Buffer template function for writing an array of values to the
+     * buffer. The values are copied in one block and converted to the byte
+     * order of the buffer as a span. The values are laid out in the buffer as
+     * if each was written on its own.
+     *
+     * @param buf The buffer to write to.
+     * @param values The values to write.
+     * @param count The number of values to write.
+     */
+    template < typename T >
+    void write (buffer& buf, const T* values, const size_t count)
+    {
+      copy_values < T > (buf,
+                         buf.reserve (count * sizeof (T)),
+                         reinterpret_cast < const uint8_t* > (values),
+                         count);
+    }
+
+    /**
+     * Buffer template function for reading an array of values from the
+     * buffer. The values are copied in one block and converted to the host
+     * byte order as a span.
+     *
+     * @param buf The buffer to read from.
+     * @param values The values to read into.
+     * @param count The number of values to read.
+     */
+    template < typename T >
+    void read (buffer& buf, T* values, const size_t count)
+    {
+      copy_values < T > (buf,
+                         reinterpret_cast < uint8_t* > (values),
+                         buf.take (count * sizeof (T)),
+                         count);
+    }
+
     /*
      * Insertion operators.
      */
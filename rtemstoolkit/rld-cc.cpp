@@ -15,8 +15,12 @@
  */
 
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <fstream>
+#include <iomanip>
+#include <map>
 
 #include <rld.h>
 #include <rld-cc.h>
@@ -51,6 +55,18 @@ namespace rld
     static std::string programs_path;   //< The CC reported programs path.
     static std::string libraries_path;  //< The CC reported libraries path.
 
+    /**
+     * The command of the search dirs known.
+     */
+    static rld::process::arg_container searched;
+
+    static std::string query_cache;     //< The query cache directory.
+
+    /**
+     * The file names the compiler reported keyed by the command.
+     */
+    static std::map < std::string, std::string > library_paths;
+
     /**
      * The list of standard libraries.
      */
@@ -478,6 +494,25 @@ namespace rld
       }
     }
 
+    /*
+     * Output the captured output of a process a line at a time.
+     */
+    static void
+    output (const std::string& prefix,
+            const std::string& text,
+            bool               line_numbers = false)
+    {
+      rld::strings lines;
+      rld::split (lines, text, '\n', false, false, true);
+      for (size_t l = 0; l < lines.size (); ++l)
+      {
+        std::cout << prefix << ": ";
+        if (line_numbers)
+          std::cout << l + 1 << ": ";
+        std::cout << lines[l] << std::endl;
+      }
+    }
+
     static bool
     match_and_trim (const char* prefix, std::string& line, std::string& result)
     {
@@ -492,6 +527,99 @@ namespace rld
       return false;
     }
 
+    void
+    set_query_cache (const std::string& path)
+    {
+      query_cache = path;
+    }
+
+    /**
+     * The query cache entry is the FNV-1a hash of the tool version, the
+     * command and the path, modification time and size of the compiler. An
+     * empty entry is returned if there is no cache or the compiler cannot be
+     * found.
+     */
+    static const std::string
+    query_cache_entry (const rld::process::arg_container& args)
+    {
+      if (query_cache.empty () || args.empty ())
+        return "";
+
+      std::string compiler = args[0];
+      if (compiler.find (RLD_PATH_SEPARATOR) == std::string::npos)
+      {
+        rld::path::paths sp;
+        rld::path::get_system_path (sp);
+        rld::path::find_file (compiler, args[0], sp);
+      }
+
+      struct stat sb;
+      if (compiler.empty () || ::stat (compiler.c_str (), &sb) != 0)
+        return "";
+
+      std::ostringstream key;
+      key << rld::version () << '\0' << compiler << '\0'
+          << sb.st_mtime << '\0' << sb.st_size;
+      for (auto& arg : args)
+        key << '\0' << arg;
+
+      uint64_t hash = 14695981039346656037ULL;
+      for (auto c : key.str ())
+      {
+        hash ^= (uint8_t) c;
+        hash *= 1099511628211ULL;
+      }
+
+      std::ostringstream oss;
+      oss << std::hex << std::setfill ('0') << std::setw (16) << hash
+          << ".cc";
+
+      std::string entry;
+      rld::path::path_join (query_cache, oss.str (), entry);
+      return entry;
+    }
+
+    static bool
+    query_cache_get (const std::string& entry, std::string& out)
+    {
+      if (entry.empty ())
+        return false;
+      std::ifstream in (entry, std::ios::in | std::ios::binary);
+      if (!in.is_open ())
+        return false;
+      std::ostringstream oss;
+      oss << in.rdbuf ();
+      out = oss.str ();
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "cc::query-cache: " << entry << std::endl;
+      return true;
+    }
+
+    /**
+     * The entry is written to a temporary file and renamed so a reader never
+     * sees a partial entry.
+     */
+    static void
+    query_cache_put (const std::string& entry, const std::string& out)
+    {
+      if (entry.empty ())
+        return;
+      std::ostringstream temp;
+      temp << entry << '.' << ::getpid ();
+      std::ofstream cf (temp.str (),
+                        std::ios::out | std::ios::binary | std::ios::trunc);
+      if (cf.is_open ())
+      {
+        cf << out;
+        cf.close ();
+        if (cf && ::rename (temp.str ().c_str (), entry.c_str ()) == 0)
+          return;
+        ::unlink (temp.str ().c_str ());
+      }
+      std::cerr << "warning: cannot write query cache: " << entry
+                << std::endl;
+    }
+
     static void
     search_dirs ()
     {
@@ -502,42 +630,58 @@ namespace rld
       append_flags (ft_cflags, args);
       args.push_back ("-print-search-dirs");
 
-      rld::process::tempfile out;
-      rld::process::tempfile err;
-      rld::process::status   status;
+      if (args == searched)
+        return;
 
-      status = rld::process::execute (cc_name, args, out.name (), err.name ());
+      const std::string entry = query_cache_entry (args);
+      std::string       text;
 
-      if ((status.type == rld::process::status::normal) &&
-          (status.code == 0))
+      if (!query_cache_get (entry, text))
       {
+        rld::process::tempfile out (".out", false, true);
+        rld::process::tempfile err (".err", false, true);
+        rld::process::status   status;
+
+        status = rld::process::execute (cc_name, args, out.name (), err.name ());
+
+        if ((status.type != rld::process::status::normal) ||
+            (status.code != 0))
+        {
+          err.output (cc_name, std::cout);
+          return;
+        }
+
         if (rld::verbose () >= RLD_VERBOSE_DETAILS)
           out.output (cc_name, std::cout, true);
         out.open ();
-        while (true)
-        {
-          std::string line;
-          out.read_line (line);
-          if (line.size () == 0)
-            break;
-          if (match_and_trim ("install: ", line, install_path))
-            continue;
-          if (match_and_trim ("programs: ", line, programs_path))
-            continue;
-          if (match_and_trim ("libraries: ", line, libraries_path))
-            continue;
-        }
+        out.read (text);
         out.close ();
-        if (rld::verbose () >= RLD_VERBOSE_DETAILS)
-        {
-          std::cout << "cc::install: " << install_path << std::endl
-                    << "cc::programs: " << programs_path << std::endl
-                    << "cc::libraries: " << libraries_path << std::endl;
-        }
+        query_cache_put (entry, text);
       }
-      else
+
+      std::string::size_type pos = 0;
+      while (pos < text.size ())
+      {
+        std::string::size_type lf = text.find ('\n', pos);
+        if (lf == std::string::npos)
+          lf = text.size () - 1;
+        std::string line = text.substr (pos, lf - pos + 1);
+        pos = lf + 1;
+        if (match_and_trim ("install: ", line, install_path))
+          continue;
+        if (match_and_trim ("programs: ", line, programs_path))
+          continue;
+        if (match_and_trim ("libraries: ", line, libraries_path))
+          continue;
+      }
+
+      searched = args;
+
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
       {
-        err.output (cc_name, std::cout);
+        std::cout << "cc::install: " << install_path << std::endl
+                  << "cc::programs: " << programs_path << std::endl
+                  << "cc::libraries: " << libraries_path << std::endl;
       }
     }
 
@@ -551,27 +695,40 @@ namespace rld
       append_flags (ft_cflags, args);
       args.push_back ("-print-file-name=" + name);
 
-      rld::process::tempfile out;
-      rld::process::tempfile err;
-      rld::process::status   status;
+      const std::string command = rld::join (args, " ");
+      auto              lpi = library_paths.find (command);
+      if (lpi != library_paths.end ())
+      {
+        path = lpi->second;
+        return;
+      }
 
-      status = rld::process::execute (cc_name, args, out.name (), err.name ());
+      const std::string entry = query_cache_entry (args);
+      std::string       out;
 
-      if ((status.type == rld::process::status::normal) &&
-          (status.code == 0))
+      if (!query_cache_get (entry, out))
       {
+        std::string          err;
+        rld::process::status status;
+
+        status = rld::process::execute (args, out, err);
+
+        if ((status.type != rld::process::status::normal) ||
+            (status.code != 0))
+        {
+          output ("cc", err);
+          return;
+        }
+
         if (rld::verbose () >= RLD_VERBOSE_DETAILS)
-          out.output ("cc", std::cout, true);
-        out.open ();
-        out.read (path);
-        out.close ();
-        if (rld::verbose () >= RLD_VERBOSE_DETAILS)
-          std::cout << "cc::libpath: " << name << " -> " << path << std::endl;
-      }
-      else
-      {
-        err.output ("cc", std::cout);
+          output ("cc", out, true);
+        query_cache_put (entry, out);
       }
+
+      path = out;
+      library_paths[command] = path;
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "cc::libpath: " << name << " -> " << path << std::endl;
     }
 
     void
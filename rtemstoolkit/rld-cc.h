@@ -198,7 +198,16 @@ namespace rld
     void make_ld_command (rld::process::arg_container& args);
 
     /**
-     * Get the standard libraries paths from the compiler.
+     * Set the directory of the compiler query cache. The search directories
+     * and file names the compiler reports are held in the cache keyed by the
+     * compiler's path, modification time and size, and the flags, so a warm
+     * run does not run the compiler. An empty path disables the cache.
+     */
+    void set_query_cache (const std::string& path);
+
+    /**
+     * Get the standard libraries paths from the compiler. The compiler is
+     * queried once.
      */
     void get_standard_libpaths (rld::path::paths& libpaths);
 
@@ -26,14 +26,20 @@
 #include "config.h"
 #endif
 
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <errno.h>
 #include <string.h>
 
 #include <rld.h>
 #include <rld-compression.h>
+#include <rld-tasks.h>
 
 #include "fastlz.h"
 
@@ -41,32 +47,149 @@ namespace rld
 {
   namespace compress
   {
+    codec
+    find_codec (const std::string& name)
+    {
+      if (name == "none")
+        return codec_none;
+      if (name == "lz77")
+        return codec_lz77;
+      if (name == "lz77-l2")
+        return codec_lz77_l2;
+      throw rld::error ("Invalid codec: " + name, "compression");
+    }
+
+    const char*
+    rap_header_name (codec method)
+    {
+      if (method == codec_none)
+        return "NONE";
+      return "LZ77";
+    }
+
+    /**
+     * The stages of a compressor's output pipeline. The caller fills a batch
+     * of blocks, the compress stage compresses the blocks of a batch in
+     * parallel and the write stage writes the compressed blocks to the image
+     * in order. A batch returns to the free queue once written so the number
+     * of batches bounds the queues between the stages.
+     */
+    struct compressor::pipeline
+    {
+      /*
+       * The number of batches, one for each stage and the caller.
+       */
+      static const size_t depth = 3;
+
+      /*
+       * A batch of up to a block per job.
+       */
+      struct batch
+      {
+        std::vector < uint8_t > data;    //< The data to compress.
+        size_t                  level;   //< The amount of data.
+        std::vector < uint8_t > io;      //< The compressed blocks.
+        std::vector < int >     blocks;  //< The size of each compressed block.
+      };
+
+      typedef std::deque < batch* > queue;
+
+      batch                   batches[depth]; //< The batches.
+      batch*                  filling;        //< The batch the caller fills.
+      queue                   free;           //< The batches to fill.
+      queue                   compressing;    //< The batches to compress.
+      queue                   writing;        //< The batches to write.
+      std::mutex              lock;           //< Protect the queues.
+      std::condition_variable changed;        //< Signalled when a queue
+                                              //  changes.
+      std::exception_ptr      error;          //< The first error of a stage.
+      bool                    stopping;       //< The stages are to stop.
+      std::thread             compress_thread; //< The compress stage.
+      std::thread             write_thread;    //< The write stage.
+
+      pipeline ()
+        : filling (0),
+          stopping (false) {
+      }
+    };
+
     compressor::compressor (files::image& image,
                             size_t        size,
                             bool          out,
-                            bool          compress)
+                            codec         method,
+                            unsigned int  jobs)
       : image (image),
         size (size),
         out (out),
-        compress (compress),
+        method (method),
+        compress (method != codec_none),
+        jobs (out && jobs > 1 ? jobs : 1),
+        capacity (0),
         buffer (0),
         io (0),
         level (0),
+        head (0),
         total (0),
-        total_compressed (0)
+        total_compressed (0),
+        limit (0),
+        stages (0)
     {
       if (size > 0xffff)
         throw rld::error ("Size too big, 16 bits only", "compression");
 
-      buffer = new uint8_t[size];
-      io = new uint8_t[size + (size / 10)];
+      capacity = size * this->jobs;
+
+      if (this->jobs > 1)
+      {
+        stages = new pipeline;
+        for (size_t b = 0; b < pipeline::depth; ++b)
+        {
+          pipeline::batch& batch = stages->batches[b];
+          batch.data.resize (capacity);
+          batch.level = 0;
+          batch.io.resize ((size + (size / 10)) * this->jobs);
+          if (b == 0)
+            stages->filling = &batch;
+          else
+            stages->free.push_back (&batch);
+        }
+        buffer = stages->filling->data.data ();
+        stages->compress_thread = std::thread (&compressor::compress_stage, this);
+        stages->write_thread = std::thread (&compressor::write_stage, this);
+      }
+      else
+      {
+        buffer = new uint8_t[capacity];
+        io = new uint8_t[(size + (size / 10)) * this->jobs];
+      }
     }
 
     compressor::~compressor ()
     {
-      flush ();
-      delete [] buffer;
-      delete [] io;
+      if (stages)
+      {
+        /*
+         * Write what is buffered and stop the stages once they are idle. An
+         * error is lost.
+         */
+        if (level)
+          queue_buffer ();
+        drain (false);
+        {
+          std::lock_guard < std::mutex > guard (stages->lock);
+          stages->stopping = true;
+          stages->changed.notify_all ();
+        }
+        stages->compress_thread.join ();
+        stages->write_thread.join ();
+        delete stages;
+      }
+      else
+      {
+        flush ();
+        delete [] buffer;
+        delete [] io;
+      }
     }
 
     void
@@ -79,10 +202,24 @@ namespace rld
 
       while (length)
       {
+        /*
+         * If the buffer is empty compress full buffers straight from the
+         * caller's data.
+         */
+        if (!stages && level == 0 && length >= capacity)
+        {
+          size_t direct = length - (length % capacity);
+          output_blocks (data, direct);
+          data += direct;
+          length -= direct;
+          total += direct;
+          continue;
+        }
+
         size_t appending;
 
-        if (length > (size - level))
-          appending = size - level;
+        if (length > (capacity - level))
+          appending = capacity - level;
         else
           appending = length;
 
@@ -103,14 +240,28 @@ namespace rld
       if (!out)
         throw rld::error ("Write on read-only", "compression");
 
+      /*
+       * A mapped input is compressed from the mapped memory.
+       */
+      const uint8_t* map = input.mapped ();
+      if (map)
+      {
+        size_t start = input.name ().offset () + offset;
+        if (start + length <= input.mapped_size ())
+        {
+          write (map + start, length);
+          return;
+        }
+      }
+
       input.seek (offset);
 
       while (length)
       {
         size_t appending;
 
-        if (length > (size - level))
-          appending = size - level;
+        if (length > (capacity - level))
+          appending = capacity - level;
         else
           appending = length;
 
@@ -148,10 +299,10 @@ namespace rld
         else
           appending = length;
 
-        ::memcpy (data, buffer, appending);
-        ::memmove (buffer, buffer + appending, level - appending);
+        ::memcpy (data, buffer + head, appending);
 
         data += appending;
+        head += appending;
         level -= appending;
         length -= appending;
         total += appending;
@@ -194,10 +345,9 @@ namespace rld
         else
           appending = length;
 
-        output_.write (buffer, appending);
-
-        ::memmove (buffer, buffer + appending, level - appending);
+        output_.write (buffer + head, appending);
 
+        head += appending;
         level -= appending;
         length -= appending;
         total += appending;
@@ -207,10 +357,44 @@ namespace rld
       return amount;
     }
 
+    size_t
+    compressor::skip (size_t length)
+    {
+      if (out)
+        throw rld::error ("Skip on write-only", "compression");
+
+      size_t amount = 0;
+
+      while (length)
+      {
+        input ();
+
+        if (level == 0)
+          break;
+
+        size_t skipping;
+
+        if (length > level)
+          skipping = level;
+        else
+          skipping = length;
+
+        head += skipping;
+        level -= skipping;
+        length -= skipping;
+        total += skipping;
+        amount += skipping;
+      }
+
+      return amount;
+    }
+
     void
     compressor::flush ()
     {
       output (true);
+      if (stages)
+        drain (true);
     }
 
     size_t
@@ -231,34 +415,221 @@ namespace rld
       return total;
     }
 
+    void
+    compressor::set_limit (size_t compressed)
+    {
+      limit = compressed;
+    }
+
     void
     compressor::output (bool forced)
     {
-      if (out && ((forced && level) || (level >= size)))
+      if (out && ((forced && level) || (level >= capacity)))
       {
-        if (compress)
+        if (stages)
+          queue_buffer ();
+        else
         {
-          int     writing = ::fastlz_compress (buffer, level, io);
-          uint8_t header[2];
+          output_blocks (buffer, level);
+          level = 0;
+        }
+      }
+    }
+
+    void
+    compressor::output_blocks (const uint8_t* data, size_t length)
+    {
+      if (!compress)
+      {
+        image.write (data, length);
+        total_compressed += length;
+        return;
+      }
+
+      std::vector < int > blocks;
+
+      while (length)
+      {
+        size_t amount = length < capacity ? length : capacity;
+
+        compress_blocks (data, amount, io, blocks);
+        write_blocks (io, blocks);
+
+        data += amount;
+        length -= amount;
+      }
+    }
+
+    void
+    compressor::compress_blocks (const uint8_t*       data,
+                                 size_t               length,
+                                 uint8_t*             io,
+                                 std::vector < int >& blocks)
+    {
+      /*
+       * Up to a block per job is compressed at a time. The blocks are
+       * independent so compress them in parallel.
+       */
+      size_t io_size = size + (size / 10);
+      int    clevel = method == codec_lz77_l2 ? 2 : 1;
+
+      blocks.resize ((length + size - 1) / size);
+
+      auto compress_block = [&] (size_t b) {
+        size_t offset = b * size;
+        size_t block = length - offset < size ? length - offset : size;
+        blocks[b] = ::fastlz_compress_level (clevel,
+                                             data + offset, block,
+                                             io + (b * io_size));
+      };
+
+      rld::tasks::parallel_for (blocks.size (), jobs, compress_block);
+    }
+
+    void
+    compressor::write_blocks (const uint8_t*             io,
+                              const std::vector < int >& blocks)
+    {
+      size_t io_size = size + (size / 10);
+
+      for (size_t b = 0; b < blocks.size (); ++b)
+      {
+        uint8_t header[2];
+
+        if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
+          std::cout << "rtl: comp: offset=" << total_compressed
+                    << " block-size=" << blocks[b] << std::endl;
+
+        header[0] = blocks[b] >> 8;
+        header[1] = blocks[b];
+
+        image.write (header, 2);
+        image.write (io + (b * io_size), blocks[b]);
+
+        total_compressed += 2 + blocks[b];
+      }
+    }
+
+    void
+    compressor::queue_buffer ()
+    {
+      std::unique_lock < std::mutex > guard (stages->lock);
+
+      stages->filling->level = level;
+      stages->compressing.push_back (stages->filling);
+      stages->changed.notify_all ();
+
+      while (stages->free.empty ())
+        stages->changed.wait (guard);
+
+      stages->filling = stages->free.front ();
+      stages->free.pop_front ();
+
+      buffer = stages->filling->data.data ();
+      level = 0;
+    }
+
+    void
+    compressor::compress_stage ()
+    {
+      std::unique_lock < std::mutex > guard (stages->lock);
 
-          if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
-            std::cout << "rtl: comp: offset=" << total_compressed
-                      << " block-size=" << writing << std::endl;
+      while (true)
+      {
+        while (!stages->stopping && stages->compressing.empty ())
+          stages->changed.wait (guard);
 
-          header[0] = writing >> 8;
-          header[1] = writing;
+        if (stages->compressing.empty ())
+          return;
 
-          image.write (header, 2);
-          image.write (io, writing);
+        pipeline::batch* batch = stages->compressing.front ();
+        stages->compressing.pop_front ();
 
-          total_compressed += 2 + writing;
+        /*
+         * Once a stage has failed the batches pass through so the caller is
+         * not blocked.
+         */
+        if (compress && !stages->error)
+        {
+          guard.unlock ();
+          try
+          {
+            compress_blocks (batch->data.data (), batch->level,
+                             batch->io.data (), batch->blocks);
+          }
+          catch (...)
+          {
+            guard.lock ();
+            if (!stages->error)
+              stages->error = std::current_exception ();
+            guard.unlock ();
+          }
+          guard.lock ();
         }
-        else
+
+        stages->writing.push_back (batch);
+        stages->changed.notify_all ();
+      }
+    }
+
+    void
+    compressor::write_stage ()
+    {
+      std::unique_lock < std::mutex > guard (stages->lock);
+
+      while (true)
+      {
+        while (!stages->stopping && stages->writing.empty ())
+          stages->changed.wait (guard);
+
+        if (stages->writing.empty ())
+          return;
+
+        pipeline::batch* batch = stages->writing.front ();
+        stages->writing.pop_front ();
+
+        if (!stages->error)
         {
-          image.write (buffer, level);
+          guard.unlock ();
+          try
+          {
+            if (compress)
+              write_blocks (batch->io.data (), batch->blocks);
+            else
+            {
+              image.write (batch->data.data (), batch->level);
+              total_compressed += batch->level;
+            }
+          }
+          catch (...)
+          {
+            guard.lock ();
+            if (!stages->error)
+              stages->error = std::current_exception ();
+            guard.unlock ();
+          }
+          guard.lock ();
         }
 
-        level = 0;
+        batch->level = 0;
+        stages->free.push_back (batch);
+        stages->changed.notify_all ();
+      }
+    }
+
+    void
+    compressor::drain (bool rethrow)
+    {
+      std::unique_lock < std::mutex > guard (stages->lock);
+
+      while (stages->free.size () < pipeline::depth - 1)
+        stages->changed.wait (guard);
+
+      if (rethrow && stages->error)
+      {
+        std::exception_ptr error = stages->error;
+        stages->error = nullptr;
+        std::rethrow_exception (error);
       }
     }
 
@@ -267,6 +638,11 @@ namespace rld
     {
       if (!out && (level == 0))
       {
+        head = 0;
+
+        if ((limit != 0) && (total_compressed >= limit))
+          return;
+
         if (compress)
         {
           uint8_t header[2];
@@ -285,16 +661,27 @@ namespace rld
               std::cout << "rtl: decomp: block-size=" << block_size
                         << std::endl;
 
-            if (image.read (io, block_size) != block_size)
-              throw rld::error ("Read past end", "compression");
-
-            level = ::fastlz_decompress (io, block_size, buffer, size);
+            /*
+             * A mapped image is decompressed from the mapped memory.
+             */
+            const uint8_t* block = image.read_mapped (block_size);
+            if (!block)
+            {
+              if (image.read (io, block_size) != block_size)
+                throw rld::error ("Read past end", "compression");
+              block = io;
+            }
+
+            level = ::fastlz_decompress (block, block_size, buffer, size);
           }
         }
         else
         {
-          image.read (buffer, size);
-          level = size;
+          size_t amount = size;
+          if ((limit != 0) && ((limit - total_compressed) < amount))
+            amount = limit - total_compressed;
+          level = image.read (buffer, amount);
+          total_compressed += level;
         }
       }
     }
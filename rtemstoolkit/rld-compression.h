@@ -25,12 +25,43 @@
 #if !defined (_RLD_COMPRESSION_H_)
 #define _RLD_COMPRESSION_H_
 
+#include <vector>
+
 #include <rld-files.h>
 
 namespace rld
 {
   namespace compress
   {
+    /**
+     * The codecs a block can be compressed with. Every FastLZ level is
+     * decompressed by the same decoder so a loader that reads LZ77 images
+     * reads all of the LZ77 levels.
+     */
+    enum codec
+    {
+      codec_none,     //< No compression.
+      codec_lz77,     //< FastLZ level 1, the default.
+      codec_lz77_l2   //< FastLZ level 2, smaller and slower to compress.
+    };
+
+    /**
+     * Find the codec for a name. The names are 'none', 'lz77' and 'lz77-l2'.
+     *
+     * @param name The name of the codec.
+     * @return codec The codec.
+     * @throw rld::error If the name is not a codec.
+     */
+    codec find_codec (const std::string& name);
+
+    /**
+     * The codec's compression field in a RAP header.
+     *
+     * @param method The codec.
+     * @return const char* The 4 character RAP header compression field.
+     */
+    const char* rap_header_name (codec method);
+
     /**
      * A compressor.
      */
@@ -43,12 +74,19 @@ namespace rld
        * @param image The image to read or write to.
        * @param size The size of the input and output buffers.
        * @param out The compressor is compressing.
-       * @param compress Set to false to disable compression.
+       * @param method The codec used to compress the blocks.
+       * @param jobs The number of blocks buffered and compressed in parallel
+       *             when compressing. Each block is compressed on its own so
+       *             the output is the same for any number of jobs. With more
+       *             than one job the blocks are compressed and written to
+       *             the image by a pipeline of stages while the caller writes
+       *             more data.
        */
       compressor (files::image& image,
                   size_t        size,
                   bool          out = true,
-                  bool          compress = true);
+                  codec         method = codec_lz77,
+                  unsigned int  jobs = 1);
 
       /**
        * Destruct the compressor.
@@ -76,7 +114,8 @@ namespace rld
       void write (files::image& input, off_t offset, size_t length);
 
       /**
-       * Flush the output buffer is data is present.
+       * Flush the output buffer is data is present. The data is in the image
+       * when the flush returns.
        */
       void flush ();
 
@@ -109,6 +148,14 @@ namespace rld
        */
       size_t read (files::image& output_, size_t length);
 
+      /**
+       * Skip over decompressed data without copying it.
+       *
+       * @param length The mount of data in bytes to skip.
+       * @return size_t The amount of data skipped.
+       */
+      size_t skip (size_t length);
+
       /**
        * The amount of uncompressed data transferred.
        *
@@ -130,6 +177,14 @@ namespace rld
        */
       off_t offset () const;
 
+      /**
+       * Limit the amount of compressed data read. A read stops at the limit
+       * so data that follows the compressed data in the image is not read.
+       *
+       * @param compressed The amount of compressed data or 0 for no limit.
+       */
+      void set_limit (size_t compressed);
+
     private:
 
       /**
@@ -139,22 +194,83 @@ namespace rld
        */
       void output (bool forced = false);
 
+      /**
+       * Compress the data in blocks and write them to the image. The data
+       * can be the buffer or the caller's data.
+       *
+       * @param data The data to compress.
+       * @param length The amount of data in bytes.
+       */
+      void output_blocks (const uint8_t* data, size_t length);
+
+      /**
+       * Compress the blocks of data. The compressed size of each block is
+       * returned in the blocks.
+       *
+       * @param data The data to compress.
+       * @param length The amount of data in bytes, up to the capacity.
+       * @param io The compressed blocks.
+       * @param blocks The size of each compressed block.
+       */
+      void compress_blocks (const uint8_t*      data,
+                            size_t              length,
+                            uint8_t*            io,
+                            std::vector < int >& blocks);
+
+      /**
+       * Write the compressed blocks to the image with their headers.
+       *
+       * @param io The compressed blocks.
+       * @param blocks The size of each compressed block.
+       */
+      void write_blocks (const uint8_t* io, const std::vector < int >& blocks);
+
+      /**
+       * Queue the buffer to the pipeline and fill the next free batch.
+       */
+      void queue_buffer ();
+
+      /**
+       * The stages of the pipeline run in their own threads.
+       */
+      void compress_stage ();
+      void write_stage ();
+
+      /**
+       * Wait for the pipeline to write all the queued batches.
+       *
+       * @param rethrow If true rethrow the first error of a stage.
+       */
+      void drain (bool rethrow);
+
       /**
        * Input a block of compressed data and decompress it.
        */
       void input ();
 
+      struct pipeline;
+
       files::image& image;            //< The image to read or write to or from.
-      size_t        size;             //< The size of the buffer.
+      size_t        size;             //< The size of a block.
       bool          out;              //< If true the it is compression.
+      codec         method;           //< The codec.
       bool          compress;         //< If true compress the data.
+      unsigned int  jobs;             //< The number of blocks compressed in
+                                      //  parallel.
+      size_t        capacity;         //< The size of the buffer.
       uint8_t*      buffer;           //< The decompressed buffer
       uint8_t*      io;               //< The I/O buffer.
       size_t        level;            //< The amount of data in the buffer.
+      size_t        head;             //< The offset of the data not read
+                                      //  yet in the buffer.
       size_t        total;            //< The amount of uncompressed data
                                       //  transferred.
       size_t        total_compressed; //< The amount of compressed data
                                       //  transferred.
+      size_t        limit;            //< The compressed data that can be
+                                      //  read, 0 is no limit.
+      pipeline*     stages;           //< The output pipeline if compressing
+                                      //  with more than one job.
     };
 
     /**
@@ -23,15 +23,253 @@
  */
 
 #include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 
-#include <rld-config.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 
-#include <SimpleIni.h>
+#include <rld-config.h>
 
 namespace rld
 {
   namespace config
   {
+    /**
+     * Section and record names are case sensitive and ordered by their
+     * characters as the host's 'char' type orders them.
+     */
+    struct name_less
+    {
+      bool operator () (const std::string& lhs, const std::string& rhs) const {
+        size_t len = std::min (lhs.size (), rhs.size ());
+        for (size_t c = 0; c < len; ++c)
+        {
+          if (lhs[c] != rhs[c])
+            return lhs[c] < rhs[c];
+        }
+        return lhs.size () < rhs.size ();
+      }
+    };
+
+    /**
+     * The parsed files. A file included more than once is parsed once.
+     */
+    typedef std::map < std::string, sections > parsed_files;
+
+    static parsed_files parsed_cache;
+    static std::mutex   parsed_cache_lock;
+
+    static inline bool
+    is_space (char c)
+    {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static inline bool
+    is_newline (char c)
+    {
+      return c == '\r' || c == '\n';
+    }
+
+    static inline void
+    skip_newline (const char*& p, const char* end)
+    {
+      p += (*p == '\r' && (p + 1) < end && *(p + 1) == '\n') ? 2 : 1;
+    }
+
+    static inline void
+    skip_line (const char*& p, const char* end)
+    {
+      while (p < end && !is_newline (*p))
+        ++p;
+    }
+
+    /**
+     * Load the lines of a multi-line value up to the line that is the tag. The
+     * lines are joined with a single newline. If there is no tag the value is
+     * the rest of the text.
+     */
+    static void
+    parse_multiline (const char*&       p,
+                     const char*        end,
+                     const std::string& tag,
+                     std::string&       value)
+    {
+      bool first = true;
+      while (true)
+      {
+        const char* line = p;
+        skip_line (p, end);
+        std::string text (line, p);
+        if (text == tag)
+        {
+          if (p < end)
+            skip_newline (p, end);
+          break;
+        }
+        if (!first)
+          value += '\n';
+        value += text;
+        if (p == end)
+          break;
+        skip_newline (p, end);
+        first = false;
+      }
+    }
+
+    /**
+     * Parse the text of a configuration file. The text is scanned once in
+     * place and only the names and values are copied. The sections and the
+     * records in a section are ordered by name and the items of a record are
+     * in the order they are in the file. Keys before any section are in an
+     * unnamed section.
+     */
+    static void
+    parse_ini (const std::string& text, sections& secs)
+    {
+      typedef std::map < std::string, record, name_less > record_map;
+      typedef std::map < std::string, record_map, name_less > section_map;
+
+      section_map           smap;
+      section_map::iterator si = smap.end ();
+
+      const char* p = text.c_str ();
+      const char* end = p + ::strlen (p);
+
+      while (p < end)
+      {
+        while (p < end && is_space (*p))
+          ++p;
+        if (p == end)
+          break;
+
+        if (*p == ';' || *p == '#')
+        {
+          skip_line (p, end);
+          continue;
+        }
+
+        if (*p == '[')
+        {
+          ++p;
+          while (p < end && is_space (*p))
+            ++p;
+          const char* name = p;
+          while (p < end && *p != ']' && !is_newline (*p))
+            ++p;
+          if (p == end || *p != ']')
+            continue;
+          const char* trail = p;
+          while (trail > name && is_space (*(trail - 1)))
+            --trail;
+          si = smap.insert (std::make_pair (std::string (name, trail),
+                                            record_map ())).first;
+          skip_line (p, end);
+          continue;
+        }
+
+        const char* key = p;
+        while (p < end && *p != '=' && !is_newline (*p))
+          ++p;
+        if (p == end || *p != '=')
+          continue;
+        if (key == p)
+        {
+          skip_line (p, end);
+          continue;
+        }
+        const char* key_end = p;
+        while (key_end > key && is_space (*(key_end - 1)))
+          --key_end;
+
+        ++p;
+        while (p < end && !is_newline (*p) && is_space (*p))
+          ++p;
+        const char* val = p;
+        skip_line (p, end);
+        const char* val_end = p;
+        if (p < end)
+          skip_newline (p, end);
+        while (val_end > val && is_space (*(val_end - 1)))
+          --val_end;
+
+        std::string value;
+        if ((val_end - val) >= 3 && ::strncmp (val, "<<<", 3) == 0)
+          parse_multiline (p, end, std::string (val + 3, val_end), value);
+        else
+          value.assign (val, val_end);
+
+        if (si == smap.end ())
+          si = smap.insert (std::make_pair (std::string (),
+                                            record_map ())).first;
+
+        std::string name (key, key_end);
+        record_map::iterator ri = si->second.find (name);
+        if (ri == si->second.end ())
+        {
+          ri = si->second.insert (std::make_pair (name, record ())).first;
+          (*ri).second.name = name;
+        }
+        (*ri).second.items_.push_back (item (value));
+      }
+
+      for (section_map::iterator smi = smap.begin ();
+           smi != smap.end ();
+           ++smi)
+      {
+        secs.push_back (section ());
+        section& sec = secs.back ();
+        sec.name = (*smi).first;
+        for (record_map::iterator rmi = (*smi).second.begin ();
+             rmi != (*smi).second.end ();
+             ++rmi)
+        {
+          sec.recs.push_back (record ());
+          sec.recs.back ().name.swap ((*rmi).second.name);
+          sec.recs.back ().items_.swap ((*rmi).second.items_);
+        }
+      }
+    }
+
+    /**
+     * Return the parsed sections of a file, reading and parsing it if it is
+     * not in the cache.
+     */
+    static const sections&
+    parsed_file (const std::string& path)
+    {
+      std::lock_guard < std::mutex > guard (parsed_cache_lock);
+
+      parsed_files::iterator pfi = parsed_cache.find (path);
+      if (pfi != parsed_cache.end ())
+        return (*pfi).second;
+
+      std::string text;
+      FILE*       file = ::fopen (path.c_str (), "rb");
+      if (file == 0)
+        throw rld::error (::strerror (errno), "load config: " + path);
+      struct stat sb;
+      if (::fstat (::fileno (file), &sb) == 0 && sb.st_size > 0)
+        text.resize (sb.st_size);
+      size_t in = text.empty () ? 0 : ::fread (&text[0], 1, text.size (), file);
+      if (::ferror (file))
+      {
+        int err = errno;
+        ::fclose (file);
+        throw rld::error (::strerror (err), "load config: " + path);
+      }
+      ::fclose (file);
+      text.resize (in);
+
+      sections& secs = parsed_cache[path];
+      parse_ini (text, secs);
+
+      return secs;
+    }
+
     item::item (const std::string& text)
       : text (text)
     {
@@ -116,8 +354,6 @@ namespace rld
     void
     config::load (const std::string& path)
     {
-      CSimpleIniCaseA ini (false, true, true);
-
       std::string checked_path;
 
       if (rld::path::check_file (path))
@@ -142,8 +378,7 @@ namespace rld
           throw rld::error ("Not found.", "load config: " + path);
       }
 
-      if (ini.LoadFile (checked_path.c_str ()) != SI_OK)
-        throw rld::error (::strerror (errno), "load config: " + path);
+      const sections& file_secs = parsed_file (checked_path);
 
       paths_.push_back (checked_path);
 
@@ -151,52 +386,17 @@ namespace rld
        * Merge the loaded configuration into our configuration.
        */
 
-      CSimpleIniCaseA::TNamesDepend skeys;
-
-      ini.GetAllSections(skeys);
-
-      for (CSimpleIniCaseA::TNamesDepend::const_iterator si = skeys.begin ();
-           si != skeys.end ();
+      for (sections::const_iterator si = file_secs.begin ();
+           si != file_secs.end ();
            ++si)
       {
-        section sec;
-
-        sec.name = (*si).pItem;
+        secs.push_back (*si);
 
-        CSimpleIniCaseA::TNamesDepend rkeys;
-
-        ini.GetAllKeys((*si).pItem, rkeys);
-
-        for (CSimpleIniCaseA::TNamesDepend::const_iterator ri = rkeys.begin ();
-             ri != rkeys.end ();
-             ++ri)
-        {
-          record rec;
-
-          rec.name = (*ri).pItem;
-
-          CSimpleIniCaseA::TNamesDepend vals;
-
-          ini.GetAllValues((*si).pItem, (*ri).pItem, vals);
-
-          for (CSimpleIniCaseA::TNamesDepend::const_iterator vi = vals.begin ();
-               vi != vals.end ();
-               ++vi)
-          {
-            rec.items_.push_back (item ((*vi).pItem));
-          }
-
-          sec.recs.push_back (rec);
-        }
-
-        secs.push_back (sec);
-
-        if (sec.name == "includes")
-          includes(sec);
+        if ((*si).name == "includes")
+          includes (*si);
       }
     }
 
-
     void
     config::includes (const section& sec, bool must_exist)
     {
@@ -250,5 +450,12 @@ namespace rld
     {
       return paths_;
     }
+
+    void
+    flush_cache ()
+    {
+      std::lock_guard < std::mutex > guard (parsed_cache_lock);
+      parsed_cache.clear ();
+    }
   }
 }
@@ -180,6 +180,14 @@ namespace rld
       sections secs;   //< The sections loaded from configuration files
     };
 
+    /**
+     * Flush the cache of parsed configuration files. Files are parsed once
+     * when first loaded and loading the file again uses the parsed
+     * result. Call this if a configuration file changes and do not call it
+     * while a configuration is being loaded.
+     */
+    void flush_cache ();
+
     /**
      * Return the items from a record.
      */
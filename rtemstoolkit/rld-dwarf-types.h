@@ -56,6 +56,7 @@ namespace rld
     typedef enum ::Dwarf_Ranges_Entry_Type dwarf_ranges_type;
     typedef enum ::Dwarf_Form_Class        dwarf_form_class;
     typedef ::Dwarf_Type                   dwarf_type;
+    typedef ::Dwarf_Global                 dwarf_global;
   }
 }
 
@@ -24,15 +24,22 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <list>
 #include <map>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <set>
 
 #include <rld.h>
+#include <rld-files.h>
 #include <rld-path.h>
 #include <rld-dwarf.h>
 #include <rld-symbols.h>
+#include <rld-tasks.h>
 
 namespace rld
 {
@@ -41,6 +48,11 @@ namespace rld
     typedef std::vector < dwarf_die > dies_active;
     dies_active active_dies;
 
+    /**
+     * Files can be loaded on more than one thread so lock the active list.
+     */
+    std::mutex active_dies_lock;
+
     bool active_dies_present (dwarf_die die)
     {
       return std::find (active_dies.begin(), active_dies.end(), die) != active_dies.end();
@@ -48,6 +60,7 @@ namespace rld
 
     void dies_active_add (dwarf_die die)
     {
+      std::lock_guard < std::mutex > guard (active_dies_lock);
       if (active_dies_present (die))
       {
         std::cout << "DDdd : dup : " << die << std::endl;
@@ -60,6 +73,7 @@ namespace rld
 
     void dies_active_remove (dwarf_die die)
     {
+      std::lock_guard < std::mutex > guard (active_dies_lock);
       dies_active::iterator di = std::find (active_dies.begin(), active_dies.end(), die);
       if (di == active_dies.end ())
       {
@@ -88,35 +102,185 @@ namespace rld
       }
     }
 
-    address::address (const sources& source, dwarf_line& line)
-      : addr (0),
+    /**
+     * The split DWARF skeleton attributes of DWARF 5 and the GNU extension
+     * to DWARF 4.
+     */
+    static const dwarf_attr dw_at_dwo_name = 0x76;
+    static const dwarf_attr dw_at_gnu_dwo_name = 0x2130;
+
+    /**
+     * Read the values in a DWARF section's data. A read past the end of the
+     * data makes the reader invalid and returns 0.
+     */
+    class table_reader
+    {
+    public:
+      table_reader (const uint8_t* data, size_t size, bool msb)
+        : data (data),
+          size (size),
+          msb (msb),
+          pos (0),
+          valid_ (true)
+      {
+      }
+
+      uint64_t read (size_t bytes)
+      {
+        uint64_t value = 0;
+        if (!check (bytes))
+          return 0;
+        for (size_t b = 0; b < bytes; ++b)
+        {
+          uint64_t byte = data[pos + (msb ? b : bytes - b - 1)];
+          value = (value << 8) | byte;
+        }
+        pos += bytes;
+        return value;
+      }
+
+      uint64_t uleb ()
+      {
+        uint64_t value = 0;
+        int      shift = 0;
+        while (check (1))
+        {
+          uint8_t byte = data[pos++];
+          if (shift < 64)
+            value |= uint64_t (byte & 0x7f) << shift;
+          shift += 7;
+          if ((byte & 0x80) == 0)
+            break;
+        }
+        return value;
+      }
+
+      int64_t sleb ()
+      {
+        uint64_t value = 0;
+        int      shift = 0;
+        uint8_t  byte = 0;
+        while (check (1))
+        {
+          byte = data[pos++];
+          if (shift < 64)
+            value |= uint64_t (byte & 0x7f) << shift;
+          shift += 7;
+          if ((byte & 0x80) == 0)
+            break;
+        }
+        if (shift < 64 && (byte & 0x40) != 0)
+          value |= ~uint64_t (0) << shift;
+        return static_cast < int64_t > (value);
+      }
+
+      /**
+       * Read the string at the current offset, nullptr if it is not
+       * terminated.
+       */
+      const char* cstring ()
+      {
+        const char* str = string (pos);
+        if (str == nullptr)
+          valid_ = false;
+        else
+          pos += ::strlen (str) + 1;
+        return str;
+      }
+
+      void skip (size_t bytes)
+      {
+        if (check (bytes))
+          pos += bytes;
+      }
+
+      void seek (size_t offset)
+      {
+        if (offset > size)
+          valid_ = false;
+        else
+          pos = offset;
+      }
+
+      size_t offset () const
+      {
+        return pos;
+      }
+
+      bool valid () const
+      {
+        return valid_;
+      }
+
+      /**
+       * Get the string at the offset, nullptr if it is not terminated.
+       */
+      const char* string (size_t offset) const
+      {
+        if (offset >= size ||
+            ::memchr (data + offset, 0, size - offset) == nullptr)
+          return nullptr;
+        return reinterpret_cast < const char* > (data + offset);
+      }
+
+    private:
+      bool check (size_t bytes)
+      {
+        if (!valid_ || bytes > size - pos)
+        {
+          valid_ = false;
+          return false;
+        }
+        return true;
+      }
+
+      const uint8_t* data;
+      size_t         size;
+      bool           msb;
+      size_t         pos;
+      bool           valid_;
+    };
+
+    /**
+     * Find the data of a section in the ELF file. A compressed section's
+     * data cannot be read.
+     */
+    static bool
+    section_data (rld::elf::file& elf,
+                  const char*     name,
+                  const uint8_t*& data,
+                  size_t&         size,
+                  unsigned int    type = SHT_PROGBITS)
+    {
+      rld::elf::sections secs;
+      elf.get_sections (secs, type);
+      for (auto sec : secs)
+      {
+        if (sec->name () == name)
+        {
+          rld::elf::elf_data* edata = sec->data ();
+          if (edata == nullptr || edata->d_buf == nullptr)
+            return false;
+          data = static_cast < const uint8_t* > (edata->d_buf);
+          size = edata->d_size;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    address::address (const sources&   source,
+                      const line_table& table,
+                      size_t            row,
+                      dwarf_address     addr)
+      : addr (addr),
         source (&source),
-        source_index (-1),
-        source_line (-1),
-        begin_statement (false),
-        block (false),
-        end_sequence (false)
+        source_index (table.files[row]),
+        source_line (table.lines[row]),
+        begin_statement ((table.flags[row] & line_table::begin_statement) != 0),
+        block ((table.flags[row] & line_table::basic_block) != 0),
+        end_sequence ((table.flags[row] & line_table::end_sequence) != 0)
     {
-      dwarf_error de;
-      int         dr;
-      dr = ::dwarf_lineaddr(line, &addr, &de);
-      libdwarf_error_check ("address::address", dr, de);
-      dr = ::dwarf_line_srcfileno(line, &source_index, &de);
-      libdwarf_error_check ("address::address", dr, de);
-      dwarf_unsigned src_line;
-      dr = ::dwarf_lineno(line, &src_line, &de);
-      libdwarf_error_check ("address::address", dr, de);
-      source_line = src_line;
-      dwarf_bool b;
-      dr = ::dwarf_linebeginstatement(line, &b, &de);
-      libdwarf_error_check ("address::address", dr, de);
-      begin_statement = b ? true : false;
-      dr = ::dwarf_lineblock(line, &b, &de);
-      libdwarf_error_check ("address::address", dr, de);
-      block = b ? true : false;
-      dr = ::dwarf_lineendsequence(line, &b, &de);
-      libdwarf_error_check ("address::address", dr, de);
-      end_sequence = b ? true : false;
     }
 
     address::address (const address& orig, const sources& source)
@@ -141,7 +305,7 @@ namespace rld
     {
     }
 
-    address::address (const address& orig)
+    address::address (const address& orig) noexcept
       : addr (orig.addr),
         source (orig.source),
         source_index (orig.source_index),
@@ -214,7 +378,7 @@ namespace rld
     }
 
     address&
-    address::operator = (const address& rhs)
+    address::operator = (const address& rhs) noexcept
     {
       if (this != &rhs)
       {
@@ -240,7 +404,7 @@ namespace rld
     {
     }
 
-    range::range (const range& orig)
+    range::range (const range& orig) noexcept
       : range_ (orig.range_)
     {
     }
@@ -292,7 +456,7 @@ namespace rld
     }
 
     range&
-    range::operator = (const range& rhs)
+    range::operator = (const range& rhs) noexcept
     {
       if (this != &rhs)
         range_ = rhs.range_;
@@ -353,6 +517,18 @@ namespace rld
       load (orig.offset);
     }
 
+    address_ranges::address_ranges (address_ranges&& orig) noexcept
+      : debug (orig.debug),
+        offset (orig.offset),
+        dranges (orig.dranges),
+        dranges_count (orig.dranges_count),
+        ranges_ (std::move (orig.ranges_))
+    {
+      orig.dranges = nullptr;
+      orig.dranges_count = 0;
+      orig.ranges_.clear ();
+    }
+
     address_ranges::~address_ranges ()
     {
       if (dranges != nullptr)
@@ -391,7 +567,11 @@ namespace rld
     bool
     address_ranges::load (dwarf_offset offset_, bool error)
     {
-      if (offset_ > 0)
+      /*
+       * An offset of 0 is the first list in the ranges section. An offset of
+       * -1 is no ranges.
+       */
+      if (offset_ != (dwarf_offset) -1)
       {
         if (dranges != nullptr)
           ::dwarf_ranges_dealloc (debug, dranges, dranges_count);
@@ -417,8 +597,9 @@ namespace rld
 
         if (dranges != nullptr && dranges_count > 0)
         {
+          ranges_.reserve (dranges_count);
           for (dwarf_signed r = 0; r < dranges_count; ++r)
-            ranges_.push_back (range (&dranges[r]));
+            ranges_.emplace_back (&dranges[r]);
         }
       }
 
@@ -449,6 +630,26 @@ namespace rld
       return *this;
     }
 
+    address_ranges&
+    address_ranges::operator = (address_ranges&& rhs)
+    {
+      if (this != &rhs)
+      {
+        if (debug != rhs.debug)
+          throw rld::error ("invalid debug", "address_ranges:=");
+        if (dranges != nullptr)
+          ::dwarf_ranges_dealloc (debug, dranges, dranges_count);
+        offset = rhs.offset;
+        dranges = rhs.dranges;
+        dranges_count = rhs.dranges_count;
+        ranges_ = std::move (rhs.ranges_);
+        rhs.dranges = nullptr;
+        rhs.dranges_count = 0;
+        rhs.ranges_.clear ();
+      }
+      return *this;
+    }
+
     void
     address_ranges::dump (std::ostream& out) const
     {
@@ -502,85 +703,110 @@ namespace rld
       return lines[index];
     }
 
-    sources::sources (file& debug, dwarf_offset die_offset)
-      : debug (debug),
-        source (nullptr),
-        count (0),
-        die_offset (die_offset)
+    void
+    line_table::add (dwarf_address addr,
+                     uint32_t      file,
+                     int32_t       line,
+                     uint8_t       flags_)
     {
-      debug_info_entry die (debug, die_offset);
-      die.source_files (source, count);
+      addrs.push_back (addr);
+      files.push_back (file);
+      lines.push_back (line);
+      flags.push_back (flags_);
     }
 
-    sources::sources (const sources& orig)
-      : debug (orig.debug),
-        source (nullptr),
-        count (0),
-        die_offset (orig.die_offset)
+    size_t
+    line_table::size () const
     {
-      /*
-       * In a copy constructor we need to get our own copy of the strings. To
-       * do that we need to get the DIE at the offset in the original.
-       */
-      debug_info_entry die (debug, die_offset);
-      die.source_files (source, count);
+      return addrs.size ();
     }
 
-    sources::~sources ()
+    void
+    line_table::clear ()
     {
-      dealloc ();
+      line_table empty;
+      addrs.swap (empty.addrs);
+      files.swap (empty.files);
+      lines.swap (empty.lines);
+      flags.swap (empty.flags);
+      paths.swap (empty.paths);
+    }
+
+    /**
+     * Add a libdwarf line to a line table.
+     */
+    static void
+    add_line (line_table& table, dwarf_line& line)
+    {
+      dwarf_address  addr;
+      dwarf_unsigned fileno;
+      dwarf_unsigned lineno;
+      uint8_t        flags = 0;
+      dwarf_bool     b;
+      dwarf_error    de;
+      int            dr;
+      dr = ::dwarf_lineaddr(line, &addr, &de);
+      libdwarf_error_check ("address::address", dr, de);
+      dr = ::dwarf_line_srcfileno(line, &fileno, &de);
+      libdwarf_error_check ("address::address", dr, de);
+      dr = ::dwarf_lineno(line, &lineno, &de);
+      libdwarf_error_check ("address::address", dr, de);
+      dr = ::dwarf_linebeginstatement(line, &b, &de);
+      libdwarf_error_check ("address::address", dr, de);
+      if (b)
+        flags |= line_table::begin_statement;
+      dr = ::dwarf_lineblock(line, &b, &de);
+      libdwarf_error_check ("address::address", dr, de);
+      if (b)
+        flags |= line_table::basic_block;
+      dr = ::dwarf_lineendsequence(line, &b, &de);
+      libdwarf_error_check ("address::address", dr, de);
+      if (b)
+        flags |= line_table::end_sequence;
+      table.add (addr, fileno, lineno, flags);
+    }
+
+    sources::sources ()
+    {
+    }
+
+    sources::sources (file& debug, dwarf_offset die_offset)
+    {
+      debug_info_entry die (debug, die_offset);
+      char**           source = nullptr;
+      dwarf_signed     count = 0;
+      die.source_files (source, count);
+      /*
+       * The elftoolchain owns and cleans up the strings.
+       */
+      for (dwarf_signed s = 0; s < count; ++s)
+        paths.push_back (source[s]);
     }
 
     std::string
     sources::operator [] (const int index) const
     {
-      if (index <= 0 || index > count)
+      if (index <= 0 || index > static_cast < int > (paths.size ()))
         return "unknown";
-      return std::string (source[index - 1]);
+      return paths[index - 1];
     }
 
     void
-    sources::dealloc ()
-    {
-      if (source && count > 0)
-      {
-        /*
-         * The elftoolchain cleans the memory up and there is no compatible
-         * call we can put here so adding the required code causes is a double
-         * free resulting in a crash.
-         */
-        if (false)
-        {
-          for (int s = 0; s < count; ++s)
-            ::dwarf_dealloc (debug, source[s], DW_DLA_STRING);
-          ::dwarf_dealloc (debug, source, DW_DLA_LIST);
-        }
-        source = nullptr;
-        count = 0;
-      }
-    }
-
-    sources&
-    sources::operator = (sources&& rhs)
+    sources::set (rld::strings& paths_)
     {
-      if (this != &rhs)
-      {
-        debug = rhs.debug;
-        source = rhs.source;
-        count = rhs.count;
-        die_offset = rhs.die_offset;
-        rhs.source = nullptr;
-        rhs.count = 0;
-      }
-      return *this;
+      paths.swap (paths_);
     }
 
     variable::variable (file& debug, debug_info_entry& die)
       : debug (debug),
         external_ (false),
-        declaration_ (false)
+        declaration_ (false),
+        name_ (&rld::intern ("")),
+        decl_file_ (name_)
     {
-      dwarf_bool db;
+      dwarf_bool  db;
+      std::string name;
+      std::string decl_file;
 
       if (die.attribute (DW_AT_external, db, false))
         external_ = db ? true : false;
@@ -591,10 +817,13 @@ namespace rld
       /*
        * Get the name attribute. (if present)
        */
-      die.attribute (DW_AT_name, name_);
-      die.attribute (DW_AT_decl_file, decl_file_);
+      die.attribute (DW_AT_name, name);
+      die.attribute (DW_AT_decl_file, decl_file);
       die.attribute (DW_AT_decl_line, decl_line_);
 
+      name_ = &rld::intern (name);
+      decl_file_ = &rld::intern (decl_file);
+
       if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
       {
         std::cout << "dwarf::variable: ";
@@ -613,14 +842,24 @@ namespace rld
     {
     }
 
+    variable::variable (variable&& orig) noexcept
+      : debug (orig.debug),
+        external_ (orig.external_),
+        declaration_ (orig.declaration_),
+        name_ (orig.name_),
+        decl_file_ (orig.decl_file_),
+        decl_line_ (orig.decl_line_)
+    {
+    }
+
     variable::~variable ()
     {
     }
 
-    std::string
+    const std::string&
     variable::name () const
     {
-      return name_;
+      return *name_;
     }
 
     bool
@@ -647,7 +886,8 @@ namespace rld
     {
       if (this != &rhs)
       {
-        debug = rhs.debug;
+        if (&debug != &rhs.debug)
+          throw rld::error ("invalid debug", "variable:=");
         external_ = rhs.external_;
         declaration_ = rhs.declaration_;
         name_ = rhs.name_;
@@ -657,13 +897,19 @@ namespace rld
       return *this;
     }
 
+    variable&
+    variable::operator = (variable&& rhs)
+    {
+      return *this = static_cast < const variable& > (rhs);
+    }
+
     void
     variable::dump (std::ostream& out) const
     {
-      if (name_.empty ())
+      if (name_->empty ())
         out << "NO-NAME";
       else
-        out << name_;
+        out << *name_;
       out << " ["
           << (char) (external_ ? 'E' : '-')
           << (char) (declaration_ ? 'D' : '-')
@@ -686,11 +932,18 @@ namespace rld
         pc_low_ (0),
         pc_high_ (0),
         ranges_ (debug),
-        linkage_name_ (),
+        name_ (&rld::intern ("")),
+        linkage_name_ (name_),
+        decl_file_ (name_),
         decl_line_ (0),
+        call_file_ (name_),
         call_line_ (0)
     {
-      dwarf_bool db;
+      dwarf_bool  db;
+      std::string name;
+      std::string linkage_name;
+      std::string decl_file;
+      std::string call_file;
 
       if (die.attribute (DW_AT_external, db, false))
         external_ = db ? true : false;
@@ -701,10 +954,10 @@ namespace rld
       if (die.attribute (DW_AT_entry_pc, entry_pc_, false))
         has_entry_pc_ = true;
 
-      die.attribute (DW_AT_linkage_name, linkage_name_, false);
-      die.attribute (DW_AT_call_file, decl_file_, false);
+      die.attribute (DW_AT_linkage_name, linkage_name, false);
+      die.attribute (DW_AT_call_file, decl_file, false);
       die.attribute (DW_AT_call_line, decl_line_, false);
-      die.attribute (DW_AT_call_file, call_file_, false);
+      die.attribute (DW_AT_call_file, call_file, false);
       die.attribute (DW_AT_call_line, call_line_, false);
 
       if (!die.attribute (DW_AT_inline, inline_, false))
@@ -740,7 +993,7 @@ namespace rld
       /*
        * Get the name attribute. (if present)
        */
-      if (!die.attribute (DW_AT_name, name_, false))
+      if (!die.attribute (DW_AT_name, name, false))
       {
         bool found = false;
 
@@ -758,7 +1011,7 @@ namespace rld
           if (dr == DW_DLV_OK)
           {
             debug_info_entry abst_at_die (debug, abst_at_die_offset);
-            if (abst_at_die.attribute (DW_AT_name, name_, false))
+            if (abst_at_die.attribute (DW_AT_name, name, false))
             {
               found = true;
               abst_at_die.attribute (DW_AT_inline, inline_, false);
@@ -766,8 +1019,8 @@ namespace rld
                 external_ = db ? true : false;
               if (abst_at_die.attribute (DW_AT_declaration, db, false))
                 declaration_ = db ? true : false;
-              abst_at_die.attribute (DW_AT_linkage_name, linkage_name_, false);
-              abst_at_die.attribute (DW_AT_decl_file, decl_file_, false);
+              abst_at_die.attribute (DW_AT_linkage_name, linkage_name, false);
+              abst_at_die.attribute (DW_AT_decl_file, decl_file, false);
               abst_at_die.attribute (DW_AT_decl_line, decl_line_, false);
             }
           }
@@ -790,15 +1043,15 @@ namespace rld
             if (dr == DW_DLV_OK)
             {
               debug_info_entry spec_die (debug, spec_die_offset);
-              if (spec_die.attribute (DW_AT_name, name_, false))
+              if (spec_die.attribute (DW_AT_name, name, false))
               {
                 found = true;
                 if (spec_die.attribute (DW_AT_external, db, false))
                   external_ = db ? true : false;
                 if (spec_die.attribute (DW_AT_declaration, db, false))
                   declaration_ = db ? true : false;
-                spec_die.attribute (DW_AT_linkage_name, linkage_name_, false);
-                spec_die.attribute (DW_AT_decl_file, decl_file_, false);
+                spec_die.attribute (DW_AT_linkage_name, linkage_name, false);
+                spec_die.attribute (DW_AT_decl_file, decl_file, false);
                 spec_die.attribute (DW_AT_decl_line, decl_line_, false);
               }
             }
@@ -806,8 +1059,13 @@ namespace rld
         }
       }
 
-      if (!linkage_name_.empty() && name_.empty())
-        rld::symbols::demangle_name(linkage_name_, name_);
+      if (!linkage_name.empty() && name.empty())
+        rld::symbols::demangle_name(linkage_name, name);
+
+      name_ = &rld::intern (name);
+      linkage_name_ = &rld::intern (linkage_name);
+      decl_file_ = &rld::intern (decl_file);
+      call_file_ = &rld::intern (call_file);
 
       if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
       {
@@ -838,14 +1096,41 @@ namespace rld
     {
     }
 
+    function::function (function&& orig) noexcept
+      : debug (orig.debug),
+        machine_code_ (orig.machine_code_),
+        external_ (orig.external_),
+        declaration_ (orig.declaration_),
+        prototyped_ (orig.prototyped_),
+        inline_ (orig.inline_),
+        entry_pc_ (orig.entry_pc_),
+        has_entry_pc_ (orig.has_entry_pc_),
+        pc_low_ (orig.pc_low_),
+        pc_high_ (orig.pc_high_),
+        ranges_ (std::move (orig.ranges_)),
+        name_ (orig.name_),
+        linkage_name_ (orig.linkage_name_),
+        decl_file_ (orig.decl_file_),
+        decl_line_ (orig.decl_line_),
+        call_file_ (orig.call_file_),
+        call_line_ (orig.call_line_)
+    {
+    }
+
     function::~function ()
     {
     }
 
-    std::string
+    const std::string&
     function::name () const
     {
-      return name_;
+      return *name_;
+    }
+
+    const std::string&
+    function::linkage_name () const
+    {
+      return *linkage_name_;
     }
 
     const address_ranges&
@@ -942,24 +1227,45 @@ namespace rld
       return i;
     }
 
-    std::string
+    const std::string&
     function::call_file () const
     {
-      return call_file_;
+      return *call_file_;
+    }
+
+    dwarf_unsigned
+    function::call_line () const
+    {
+      return call_line_;
     }
 
     bool
     function::inside (dwarf_address addr) const
     {
-      return !name_.empty () && has_machine_code () &&
+      return !name_->empty () && has_machine_code () &&
         addr >= pc_low () && addr <= pc_high ();
     }
 
+    bool
+    function::contains (dwarf_address addr) const
+    {
+      if (name_->empty () || !has_machine_code ())
+        return false;
+      if (ranges_.empty ())
+        return addr >= pc_low () && addr < pc_high ();
+      for (auto& r : ranges_.get ())
+      {
+        if (!r.end () && !r.empty () && addr >= r.addr1 () && addr < r.addr2 ())
+          return true;
+      }
+      return false;
+    }
+
     size_t
     function::size () const
     {
       size_t s = 0;
-      if (!name_.empty () && has_machine_code ())
+      if (!name_->empty () && has_machine_code ())
       {
         if (ranges_.empty ())
           s = pc_high () - pc_low ();
@@ -980,7 +1286,8 @@ namespace rld
     {
       if (this != &rhs)
       {
-        debug = rhs.debug;
+        if (&debug != &rhs.debug)
+          throw rld::error ("invalid debug", "function:=");
         machine_code_ = rhs.machine_code_;
         external_ = rhs.external_;
         declaration_ = rhs.declaration_;
@@ -1000,13 +1307,39 @@ namespace rld
       return *this;
     }
 
+    function&
+    function::operator = (function&& rhs)
+    {
+      if (this != &rhs)
+      {
+        if (&debug != &rhs.debug)
+          throw rld::error ("invalid debug", "function:=");
+        machine_code_ = rhs.machine_code_;
+        external_ = rhs.external_;
+        declaration_ = rhs.declaration_;
+        inline_ = rhs.inline_;
+        entry_pc_ = rhs.entry_pc_;
+        has_entry_pc_ = rhs.has_entry_pc_;
+        pc_low_ = rhs.pc_low_;
+        pc_high_ = rhs.pc_high_;
+        ranges_ = std::move (rhs.ranges_);
+        name_ = rhs.name_;
+        linkage_name_ = rhs.linkage_name_;
+        decl_file_ = rhs.decl_file_;
+        decl_line_ = rhs.decl_line_;
+        call_file_ = rhs.call_file_;
+        call_line_ = rhs.call_line_;
+      }
+      return *this;
+    }
+
     void
     function::dump (std::ostream& out) const
     {
-      if (name_.empty ())
+      if (name_->empty ())
         out << "NO-NAME";
       else
-        out << name_;
+        out << *name_;
       out << " ["
           << (char) (machine_code_ ? 'M' : '-')
           << (char) (external_ ? 'E' : '-')
@@ -1020,15 +1353,15 @@ namespace rld
         out << " epc=0x" << entry_pc_;
       out << " pc_low=0x" << pc_low_
           << " pc_high=0x" << pc_high_;
-      if (!linkage_name_.empty ())
+      if (!linkage_name_->empty ())
       {
         std::string show_name;
-        rld::symbols::demangle_name(linkage_name_, show_name);
+        rld::symbols::demangle_name(*linkage_name_, show_name);
         out << " ln=" << show_name;
       }
       out << std::dec << std::setfill (' ');
-      if (!call_file_.empty ())
-        out << " cf=" << call_file_ << ':' << call_line_;
+      if (!call_file_->empty ())
+        out << " cf=" << *call_file_ << ':' << call_line_;
       if (!ranges_.empty ())
       {
         out << " ranges=";
@@ -1311,17 +1644,46 @@ namespace rld
     }
 
     bool
-    debug_info_entry::source_lines (dwarf_line*&  lines,
-                                    dwarf_signed& linecount) const
+    debug_info_entry::section_offset (dwarf_attr      attr,
+                                      dwarf_unsigned& value,
+                                      bool            error) const
     {
-      dwarf_error de;
-      int         dr;
-      if (lines != nullptr)
-        throw rld::error ("lines is not null", "debug_info_entry:source_lines");
-      linecount = 0;
-      dr = ::dwarf_srclines (die, &lines, &linecount, &de);
-      if (dr ==  DW_DLV_NO_ENTRY)
-        return false;
+      dwarf_attribute at;
+      dwarf_half      form;
+      dwarf_error     de;
+      int             dr;
+      value = 0;
+      dr = ::dwarf_attr (die, attr, &at, &de);
+      if (dr == DW_DLV_OK)
+        dr = ::dwarf_whatform (at, &form, &de);
+      if (dr == DW_DLV_OK)
+      {
+        if (form == DW_FORM_sec_offset)
+        {
+          dwarf_offset offset;
+          dr = ::dwarf_global_formref (at, &offset, &de);
+          value = offset;
+        }
+        else
+          dr = ::dwarf_formudata (at, &value, &de);
+      }
+      if (error)
+        libdwarf_error_check ("debug_info_entry:section_offset", dr, de);
+      return dr == DW_DLV_OK;
+    }
+
+    bool
+    debug_info_entry::source_lines (dwarf_line*&  lines,
+                                    dwarf_signed& linecount) const
+    {
+      dwarf_error de;
+      int         dr;
+      if (lines != nullptr)
+        throw rld::error ("lines is not null", "debug_info_entry:source_lines");
+      linecount = 0;
+      dr = ::dwarf_srclines (die, &lines, &linecount, &de);
+      if (dr ==  DW_DLV_NO_ENTRY)
+        return false;
       libdwarf_error_check ("debug_info_entry:source_lines ", dr, de);
       return true;
     }
@@ -1546,11 +1908,10 @@ namespace rld
               dr = ::dwarf_attrval_string (die, attr, &s, &de);
               libdwarf_error_check ("debug_info_entry::dump", dr, de);
               out << " : " << s;
-              if (rld::symbols::is_cplusplus(s))
               {
-                std::string cpps;
-                rld::symbols::demangle_name(s, cpps);
-                out << " `" << cpps << '`';
+                const std::string* cpps = rld::symbols::demangle (s);
+                if (cpps)
+                  out << " `" << *cpps << '`';
               }
               break;
             case DW_FORM_sec_offset:
@@ -1620,18 +1981,35 @@ namespace rld
 
     compilation_unit::compilation_unit (file&             debug,
                                         debug_info_entry& die,
-                                        dwarf_unsigned    offset)
+                                        dwarf_unsigned    offset,
+                                        bool              lazy)
       : debug (debug),
         offset_ (offset),
         pc_low_ (0),
         pc_high_ (0),
         ranges_ (debug),
         die_offset (die.offset ()),
-        source_ (debug, die_offset)
+        stmt_list_ (0),
+        dwo_found_ (false),
+        native_lines_ (false),
+        lines_loaded_ (false),
+        functions_on_demand_ (false)
     {
-      die.attribute (DW_AT_name, name_);
+      /*
+       * A split DWARF skeleton's name and producer are in the .dwo file.
+       */
+      if (!die.attribute (dw_at_dwo_name, dwo_name_, false))
+        die.attribute (dw_at_gnu_dwo_name, dwo_name_, false);
+
+      die.attribute (DW_AT_name, name_, dwo_name_.empty ());
 
-      die.attribute (DW_AT_producer, producer_);
+      die.attribute (DW_AT_producer, producer_, dwo_name_.empty ());
+
+      if (die.section_offset (DW_AT_stmt_list, stmt_list_, false))
+      {
+        die.attribute (DW_AT_comp_dir, comp_dir_, false);
+        native_lines_ = debug.native_lines (stmt_list_);
+      }
 
       ranges_.load (die, false);
 
@@ -1678,15 +2056,63 @@ namespace rld
                   << std::endl;
       }
 
-      line_addresses lines (debug, die);
+      if (!lazy)
+        load_lines ();
+    }
+
+    void
+    compilation_unit::load_lines () const
+    {
+      if (lines_loaded_)
+        return;
+
+      read_lines ();
+      process_lines ();
+      trace_lines ();
+    }
+
+    void
+    compilation_unit::read_lines () const
+    {
+      lines_loaded_ = true;
+
+      if (native_lines_)
+      {
+        debug.decode_lines (stmt_list_, comp_dir_, line_rows_);
+        source_.set (line_rows_.paths);
+      }
+      else
+      {
+        debug_info_entry die (debug, die_offset);
+        line_addresses   lines (debug, die);
+
+        source_ = sources (debug, die_offset);
+
+        for (size_t l = 0; l < lines.count (); ++l)
+          add_line (line_rows_, lines[l]);
+      }
+    }
+
+    bool
+    compilation_unit::native_lines () const
+    {
+      return native_lines_;
+    }
+
+    void
+    compilation_unit::process_lines () const
+    {
       dwarf_address  pc = 0;
       bool           seq_check = true;
       dwarf_address  seq_base = 0;
 
-      for (size_t l = 0; l < lines.count (); ++l)
+      addr_lines_.reserve (line_rows_.size ());
+
+      for (size_t row = 0; row < line_rows_.size (); ++row)
       {
-        address       daddr (source_, lines[l]);
-        dwarf_address loc = daddr.location ();
+        dwarf_address loc = line_rows_.addrs[row];
+        bool          is_an_end_sequence =
+          (line_rows_.flags[row] & line_table::end_sequence) != 0;
         /*
          * A CU's line program can have some sequences at the start where the
          * address is incorrectly set to 0. Ignore these entries.
@@ -1695,7 +2121,7 @@ namespace rld
         {
           if (!seq_check)
           {
-            seq_check = daddr.is_an_end_sequence ();
+            seq_check = is_an_end_sequence;
             continue;
           }
           if (loc == 0)
@@ -1714,19 +2140,26 @@ namespace rld
           seq_base = pc;
         if (seq_base != 0)
           loc += seq_base;
-        if (daddr.is_an_end_sequence ())
+        if (is_an_end_sequence)
           seq_base = 0;
-        address addr (daddr, loc);
         if (loc >= pc_low_ && loc <= pc_high_)
         {
           pc = loc;
-          addr_lines_.push_back (addr);
+          addr_lines_.push_back (address (source_, line_rows_, row, loc));
         }
       }
 
+      line_rows_.clear ();
+      addr_lines_.shrink_to_fit ();
+
+      std::stable_sort (addr_lines_.begin (), addr_lines_.end ());
+    }
+
+    void
+    compilation_unit::trace_lines () const
+    {
       if (!addr_lines_.empty ())
       {
-        std::stable_sort (addr_lines_.begin (), addr_lines_.end ());
         if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
         {
           auto first = addr_lines_.begin ();
@@ -1772,7 +2205,15 @@ namespace rld
         pc_high_ (orig.pc_high_),
         ranges_ (orig.ranges_),
         die_offset (orig.die_offset),
-        source_ (debug, die_offset)
+        stmt_list_ (orig.stmt_list_),
+        comp_dir_ (orig.comp_dir_),
+        dwo_name_ (orig.dwo_name_),
+        dwo_path_ (orig.dwo_path_),
+        dwo_found_ (orig.dwo_found_),
+        native_lines_ (orig.native_lines_),
+        source_ (orig.source_),
+        lines_loaded_ (orig.lines_loaded_),
+        functions_on_demand_ (orig.functions_on_demand_)
     {
       for (auto& line : orig.addr_lines_)
         addr_lines_.push_back (address (line, source_));
@@ -1805,8 +2246,7 @@ namespace rld
       {
         if (die.tag () == DW_TAG_variable)
         {
-          function func (debug, die);
-          functions_.push_back (func);
+          functions_.emplace_back (debug, die);
         }
 
         debug_info_entry next (die.get_debug ());
@@ -1830,6 +2270,12 @@ namespace rld
         load_functions (child);
     }
 
+    void
+    compilation_unit::load_functions_on_demand ()
+    {
+      functions_on_demand_ = true;
+    }
+
     void
     compilation_unit::load_functions (debug_info_entry& die)
     {
@@ -1839,8 +2285,7 @@ namespace rld
             die.tag () == DW_TAG_entry_point ||
             die.tag () == DW_TAG_inlined_subroutine)
         {
-          function func (debug, die);
-          functions_.push_back (func);
+          functions_.emplace_back (debug, die);
         }
 
         debug_info_entry next (die.get_debug ());
@@ -1883,20 +2328,30 @@ namespace rld
     compilation_unit::get_source (const dwarf_address addr,
                                   address&            addr_line)
     {
+      if (inside (addr))
+        load_lines ();
       if (!addr_lines_.empty () && inside (addr))
       {
-        address last_loc;
-        for (auto& loc : addr_lines_)
+        /*
+         * The table is sorted so find the first line at or above the
+         * address. An exact match is the line, otherwise the address is part
+         * of the line before it.
+         */
+        auto loc = std::lower_bound (addr_lines_.begin (),
+                                     addr_lines_.end (),
+                                     addr,
+                                     [] (const address& a, dwarf_address v) {
+                                       return a.location () < v;
+                                     });
+        if (loc != addr_lines_.end ())
         {
-          if (addr <= loc.location ())
-          {
-            if (addr == loc.location ())
-              addr_line = loc;
-            else
-              addr_line = last_loc;
-            return addr_line.valid ();
-          }
-          last_loc = loc;
+          if (addr == loc->location ())
+            addr_line = *loc;
+          else if (loc != addr_lines_.begin ())
+            addr_line = *(loc - 1);
+          else
+            addr_line = address ();
+          return addr_line.valid ();
         }
       }
       return false;
@@ -1904,12 +2359,18 @@ namespace rld
 
     const addresses& compilation_unit::get_addresses () const
     {
+      load_lines ();
       return addr_lines_;
     }
 
     functions&
     compilation_unit::get_functions ()
     {
+      if (functions_on_demand_)
+      {
+        functions_on_demand_ = false;
+        load_functions ();
+      }
       return functions_;
     }
 
@@ -1919,6 +2380,57 @@ namespace rld
       return addr >= pc_low_ && addr < pc_high_;
     }
 
+    dwarf_unsigned
+    compilation_unit::offset () const
+    {
+      return offset_;
+    }
+
+    bool
+    compilation_unit::skeleton () const
+    {
+      return !dwo_name_.empty ();
+    }
+
+    const std::string&
+    compilation_unit::dwo_name () const
+    {
+      return dwo_name_;
+    }
+
+    const std::string&
+    compilation_unit::dwo_path () const
+    {
+      if (!dwo_found_ && !dwo_name_.empty ())
+      {
+        dwo_found_ = true;
+        if (dwo_name_[0] == '/')
+        {
+          if (rld::path::check_file (dwo_name_))
+            dwo_path_ = dwo_name_;
+        }
+        else
+        {
+          rld::path::paths dirs;
+          if (!comp_dir_.empty ())
+            dirs.push_back (comp_dir_);
+          dirs.push_back (rld::path::dirname (debug.name ()));
+          dirs.push_back (".");
+          for (auto& dir : dirs)
+          {
+            std::string path;
+            rld::path::path_join (dir, dwo_name_, path);
+            if (rld::path::check_file (path))
+            {
+              dwo_path_ = path;
+              break;
+            }
+          }
+        }
+      }
+      return dwo_path_;
+    }
+
     compilation_unit&
     compilation_unit::operator = (const compilation_unit& rhs)
     {
@@ -1927,19 +2439,28 @@ namespace rld
         debug = rhs.debug;
 
         /*
-         * This is a copy operator so we need to get a new copy of the strings,
-         * we cannot steal the other copy.
+         * The addresses reference the sources table so they are copied to
+         * reference this CU's copy.
          */
         offset_ = rhs.offset_;
         name_ = rhs.name_;
         producer_ = rhs.producer_;
-        source_ = sources (debug, die_offset);
+        stmt_list_ = rhs.stmt_list_;
+        comp_dir_ = rhs.comp_dir_;
+        dwo_name_ = rhs.dwo_name_;
+        dwo_path_ = rhs.dwo_path_;
+        dwo_found_ = rhs.dwo_found_;
+        native_lines_ = rhs.native_lines_;
+        source_ = rhs.source_;
+        addr_lines_.clear ();
         for (auto& line : rhs.addr_lines_)
           addr_lines_.push_back (address (line, source_));
+        lines_loaded_ = rhs.lines_loaded_;
         pc_low_ = rhs.pc_low_;
         pc_high_ = rhs.pc_high_;
         ranges_ = rhs.ranges_;
         die_offset = rhs.die_offset;
+        functions_on_demand_ = rhs.functions_on_demand_;
       }
       return *this;
     }
@@ -1984,7 +2505,14 @@ namespace rld
 
     file::file ()
       : debug (nullptr),
-        elf_ (nullptr)
+        elf_ (nullptr),
+        line_data (nullptr),
+        line_size (0),
+        line_msb (false),
+        lazy_ (false),
+        func_indexed (false),
+        names_indexed (false),
+        names_complete (false)
     {
     }
 
@@ -2040,6 +2568,20 @@ namespace rld
        */
       elf__.reference_obtain ();
       elf_ = &elf__;
+
+      /*
+       * The line programs of a relocatable file need the relocations
+       * libdwarf applies so only decode the lines of other files.
+       */
+      if (!elf__.is_relocatable ())
+      {
+        if (!section_data (elf__, ".debug_line", line_data, line_size))
+        {
+          line_data = nullptr;
+          line_size = 0;
+        }
+        line_msb = elf__.data_type () == ELFDATA2MSB;
+      }
     }
 
     void
@@ -2051,6 +2593,15 @@ namespace rld
           std::cout << "dwarf::end: " << name () << std::endl;
 
         cus.clear ();
+        cu_index.clear ();
+        func_index.clear ();
+        func_indexed = false;
+        names.clear ();
+        names_indexed = false;
+        names_complete = false;
+
+        line_data = nullptr;
+        line_size = 0;
 
         ::dwarf_finish (debug, 0);
         if (elf_)
@@ -2096,9 +2647,18 @@ namespace rld
     }
 
     void
-    file::load_debug ()
+    file::load_debug (bool lazy, unsigned int jobs)
     {
       dwarf_unsigned cu_offset = 0;
+      bool           parallel = !lazy && jobs > 1;
+
+      lazy_ = lazy;
+
+      /*
+       * The line tables of the compilation units are processed as the
+       * units are read.
+       */
+      rld::tasks::group lines;
 
       while (true)
       {
@@ -2127,7 +2687,23 @@ namespace rld
 
           if (ret_die.tag () == DW_TAG_compile_unit)
           {
-            cus.push_back (compilation_unit (*this, ret_die, cu_offset));
+            cus.emplace_back (*this, ret_die, cu_offset, lazy || parallel);
+            if (parallel)
+            {
+              compilation_unit& cu = cus.back ();
+              if (cu.native_lines ())
+              {
+                lines.run ([&cu] {
+                    cu.read_lines ();
+                    cu.process_lines ();
+                  });
+              }
+              else
+              {
+                cu.read_lines ();
+                lines.run ([&cu] { cu.process_lines (); });
+              }
+            }
             break;
           }
 
@@ -2136,6 +2712,74 @@ namespace rld
 
         cu_offset = cu_next_offset;
       }
+
+      if (parallel)
+      {
+        lines.wait ();
+        for (auto& cu : cus)
+          cu.trace_lines ();
+      }
+
+      index_cus ();
+    }
+
+    void
+    file::index_cus ()
+    {
+      /*
+       * A CU can only resolve an address between its first and last line so
+       * index that range. A lazy CU's lines are not loaded so index the CU's
+       * address range. The entries are sorted by the low address and each
+       * holds the highest address of it and the entries before it so a search
+       * can stop walking down once no lower entry can contain the address.
+       */
+      cu_index.clear ();
+
+      size_t order = 0;
+      for (auto& cu : cus)
+      {
+        cu_index_entry entry;
+        bool           indexed = false;
+
+        if (lazy_)
+        {
+          if (cu.pc_low () < cu.pc_high ())
+          {
+            entry.low = cu.pc_low ();
+            entry.high = cu.pc_high () - 1;
+            indexed = true;
+          }
+        }
+        else
+        {
+          const addresses& lines = cu.get_addresses ();
+          if (!lines.empty ())
+          {
+            entry.low = lines.front ().location ();
+            entry.high = lines.back ().location ();
+            indexed = true;
+          }
+        }
+
+        if (indexed)
+        {
+          entry.max_high = entry.high;
+          entry.order = order;
+          entry.cu = &cu;
+          cu_index.push_back (entry);
+        }
+
+        ++order;
+      }
+
+      std::stable_sort (cu_index.begin (), cu_index.end (),
+                        [] (const cu_index_entry& a, const cu_index_entry& b) {
+                          return a.low < b.low;
+                        });
+
+      for (size_t e = 1; e < cu_index.size (); ++e)
+        cu_index[e].max_high = std::max (cu_index[e].max_high,
+                                         cu_index[e - 1].max_high);
     }
 
     void
@@ -2156,7 +2800,12 @@ namespace rld
     file::load_functions ()
     {
       for (auto& cu : cus)
-        cu.load_functions ();
+      {
+        if (lazy_)
+          cu.load_functions_on_demand ();
+        else
+          cu.load_functions ();
+      }
     }
 
     bool
@@ -2175,10 +2824,37 @@ namespace rld
 
       address match;
 
-      for (auto& cu : cus)
+      /*
+       * Find the CUs whose lines cover the address and check them in the
+       * order they are in the image.
+       */
+      std::vector < const cu_index_entry* > candidates;
+
+      auto upper = std::upper_bound (cu_index.begin (),
+                                     cu_index.end (),
+                                     addr,
+                                     [] (dwarf_address v,
+                                         const cu_index_entry& e) {
+                                       return v < e.low;
+                                     });
+      while (upper != cu_index.begin ())
+      {
+        --upper;
+        if (upper->max_high < addr)
+          break;
+        if (upper->high >= addr)
+          candidates.push_back (&(*upper));
+      }
+
+      std::sort (candidates.begin (), candidates.end (),
+                 [] (const cu_index_entry* a, const cu_index_entry* b) {
+                   return a->order < b->order;
+                 });
+
+      for (auto c : candidates)
       {
         address line;
-        r = cu.get_source (addr, line);
+        r = c->cu->get_source (addr, line);
         if (r)
         {
           if (!match.valid ())
@@ -2202,14 +2878,74 @@ namespace rld
       return r;
     }
 
+    /**
+     * Sort the lookups by address returning the order.
+     */
+    static void
+    sort_lookups (const source_lookups& lookups, std::vector < size_t >& order)
+    {
+      order.resize (lookups.size ());
+      std::iota (order.begin (), order.end (), 0);
+      std::stable_sort (order.begin (), order.end (),
+                        [&lookups] (size_t a, size_t b) {
+                          return lookups[a].location < lookups[b].location;
+                        });
+    }
+
+    /**
+     * Is a sorted lookup inside the address range? The range includes the
+     * high address.
+     */
+    static bool
+    lookups_inside (dwarf_address                 low,
+                    dwarf_address                 high,
+                    const source_lookups&         lookups,
+                    const std::vector < size_t >& order)
+    {
+      auto first = std::lower_bound (order.begin (), order.end (),
+                                     low,
+                                     [&lookups] (size_t o, dwarf_address v) {
+                                       return lookups[o].location < v;
+                                     });
+      return first != order.end () && lookups[*first].location <= high;
+    }
+
+    /**
+     * Can the function of the address be in the CU? A function's range
+     * includes its high address so do the same for the CU.
+     */
+    static bool
+    function_inside (const compilation_unit& cu, dwarf_address addr)
+    {
+      return addr >= cu.pc_low () && addr <= cu.pc_high ();
+    }
+
     bool
     file::get_function (const unsigned int addr,
                         std::string&       name)
     {
       name = "unknown";
 
+      if (func_indexed)
+      {
+        std::vector < const function* > candidates;
+        function_candidates (addr, candidates);
+        for (auto func : candidates)
+        {
+          if (func->inside (addr))
+          {
+            name = func->name ();
+            return true;
+          }
+        }
+        return false;
+      }
+
       for (auto& cu : cus)
       {
+        if (lazy_ && !function_inside (cu, addr))
+          continue;
+
         for (auto& func : cu.get_functions ())
         {
           if (func.inside (addr))
@@ -2224,72 +2960,1081 @@ namespace rld
     }
 
     void
-    file::get_producer_sources (producer_sources& producers)
+    file::index_functions ()
     {
+      /*
+       * Index each function's address range. A lazy search only looks in the
+       * CUs whose range holds the address so limit a function's range to its
+       * CU's range. The entries are sorted and searched the same way as the
+       * CU index.
+       */
+      func_index.clear ();
+
+      size_t order = 0;
       for (auto& cu : cus)
       {
-        std::string     producer = cu.producer ();
-        producer_source new_producer;
-        source_flags    sf (cu.name ());
-        rld::strings    parts;
-
-        rld::split (parts, producer);
-
-        for (auto& s : parts)
-        {
-          if (s[0] == '-')
-            sf.flags.push_back (s);
-          else
-            new_producer.producer +=  ' ' + s;
-        }
-
-        bool add = true;
-
-        for (auto& p : producers)
+        for (auto& func : cu.get_functions ())
         {
-          if (p.producer == new_producer.producer)
+          if (!func.name ().empty () && func.has_machine_code ())
           {
-            p.sources.push_back (sf);
-            add = false;
-            break;
+            func_index_entry entry;
+            entry.low = func.pc_low ();
+            entry.high = func.pc_high ();
+            if (lazy_)
+            {
+              entry.low = std::max (entry.low, dwarf_address (cu.pc_low ()));
+              entry.high = std::min (entry.high, dwarf_address (cu.pc_high ()));
+            }
+            if (entry.low <= entry.high)
+            {
+              entry.max_high = entry.high;
+              entry.order = order;
+              entry.func = &func;
+              func_index.push_back (entry);
+            }
           }
-        }
-        if (add)
-        {
-          new_producer.sources.push_back (sf);
-          producers.push_back (new_producer);
+          ++order;
         }
       }
-    }
 
-    dwarf&
-    file::get_debug ()
-    {
-      return debug;
+      std::stable_sort (func_index.begin (), func_index.end (),
+                        [] (const func_index_entry& a,
+                            const func_index_entry& b) {
+                          return a.low < b.low;
+                        });
+
+      for (size_t e = 1; e < func_index.size (); ++e)
+        func_index[e].max_high = std::max (func_index[e].max_high,
+                                           func_index[e - 1].max_high);
+
+      func_indexed = true;
     }
 
-    compilation_units&
-    file::get_cus ()
-    {
-      return cus;
+    void
+    file::function_candidates (dwarf_address                   addr,
+                               std::vector < const function* >& candidates)
+    {
+      std::vector < const func_index_entry* > entries;
+
+      auto upper = std::upper_bound (func_index.begin (),
+                                     func_index.end (),
+                                     addr,
+                                     [] (dwarf_address v,
+                                         const func_index_entry& e) {
+                                       return v < e.low;
+                                     });
+      while (upper != func_index.begin ())
+      {
+        --upper;
+        if (upper->max_high < addr)
+          break;
+        if (upper->high >= addr)
+          entries.push_back (&(*upper));
+      }
+
+      std::sort (entries.begin (), entries.end (),
+                 [] (const func_index_entry* a, const func_index_entry* b) {
+                   return a->order < b->order;
+                 });
+
+      candidates.clear ();
+      for (auto e : entries)
+        candidates.push_back (e->func);
     }
 
-    const std::string&
-    file::name () const
+    const function*
+    file::find_function (dwarf_address addr)
     {
-      if (!elf_)
-        throw rld::error ("No begin called", "dwarf:fie:name");
-      return elf_->name ();
+      function_pointers frames;
+      find_functions (addr, frames);
+      if (frames.empty ())
+        return nullptr;
+      return frames.back ();
     }
 
     void
-    file::check (const char* where) const
+    file::find_functions (dwarf_address addr, function_pointers& frames)
     {
-      if (!debug || !elf_)
+      if (!func_indexed)
+        index_functions ();
+
+      std::vector < const function* > candidates;
+      function_candidates (addr, candidates);
+
+      frames.clear ();
+      for (auto func : candidates)
       {
-        std::string w = where;
-        throw rld::error ("No DWARF or ELF file", "dwarf:file:" + w);
+        if (func->contains (addr))
+          frames.push_back (func);
       }
+
+      /*
+       * An inlined instance is nested inside the function it is inlined into
+       * and follows it in the image so the larger and earlier functions are
+       * the outer frames.
+       */
+      std::stable_sort (frames.begin (), frames.end (),
+                        [] (const function* a, const function* b) {
+                          return (a->pc_high () - a->pc_low ()) >
+                            (b->pc_high () - b->pc_low ());
+                        });
+    }
+
+    /**
+     * The .debug_names index attributes, DWARF 5 section 6.1.1.4.7.
+     */
+    static const dwarf_unsigned dw_idx_compile_unit = 1;
+
+    bool
+    file::native_lines (dwarf_unsigned offset) const
+    {
+      if (line_data == nullptr || offset >= line_size)
+        return false;
+      table_reader r (line_data, line_size, line_msb);
+      r.seek (offset);
+      if (r.read (4) == 0xffffffff)
+        r.skip (8);
+      const uint64_t version = r.read (2);
+      return r.valid () && version >= 2 && version <= 4;
+    }
+
+    void
+    file::decode_lines (dwarf_unsigned     offset,
+                        const std::string& comp_dir,
+                        line_table&        table) const
+    {
+      if (!native_lines (offset))
+        throw rld::error ("line program cannot be decoded", "dwarf:lines");
+
+      table_reader r (line_data, line_size, line_msb);
+
+      r.seek (offset);
+
+      uint64_t length = r.read (4);
+      size_t   offset_size = 4;
+      if (length == 0xffffffff)
+      {
+        length = r.read (8);
+        offset_size = 8;
+      }
+
+      const size_t end = r.offset () + length;
+      if (!r.valid () || length > line_size - r.offset ())
+        throw rld::error ("invalid line program length", "dwarf:lines");
+
+      const uint64_t version = r.read (2);
+      const uint64_t header_length = r.read (offset_size);
+      const size_t   program = r.offset () + header_length;
+      const uint64_t min_length = r.read (1);
+      if (version == 4)
+        r.skip (1);
+      const bool     default_is_stmt = r.read (1) != 0;
+      const int8_t   line_base = static_cast < int8_t > (r.read (1));
+      const uint64_t line_range = r.read (1);
+      const uint64_t opcode_base = r.read (1);
+
+      if (line_range == 0 || opcode_base == 0)
+        throw rld::error ("invalid line program header", "dwarf:lines");
+
+      std::vector < uint64_t > opcode_lengths (opcode_base, 0);
+      for (uint64_t o = 1; o < opcode_base; ++o)
+        opcode_lengths[o] = r.read (1);
+
+      std::vector < const char* > include_dirs;
+      while (r.valid ())
+      {
+        const char* dir = r.cstring ();
+        if (dir == nullptr || *dir == '\0')
+          break;
+        include_dirs.push_back (dir);
+      }
+
+      /*
+       * The paths are made the same way as libdwarf makes them.
+       */
+      auto add_file = [&] () -> bool {
+        const char* name = r.cstring ();
+        if (name == nullptr || *name == '\0')
+          return false;
+        const uint64_t dir = r.uleb ();
+        r.uleb ();
+        r.uleb ();
+        if (dir > include_dirs.size ())
+          throw rld::error ("invalid line program directory", "dwarf:lines");
+        if (*name != '/')
+        {
+          if (dir > 0)
+          {
+            table.paths.push_back (std::string (include_dirs[dir - 1]) + '/' +
+                                   name);
+            return true;
+          }
+          if (!comp_dir.empty ())
+          {
+            table.paths.push_back (comp_dir + '/' + name);
+            return true;
+          }
+        }
+        table.paths.push_back (name);
+        return true;
+      };
+
+      while (r.valid () && add_file ())
+        ;
+
+      if (!r.valid () || r.offset () != program || program > end)
+        throw rld::error ("invalid line program header", "dwarf:lines");
+
+      /*
+       * Run the line number program creating a row for each line.
+       */
+      dwarf_address address;
+      uint32_t      file;
+      int32_t       line;
+      bool          is_stmt;
+      bool          basic_block;
+
+      auto reset = [&] () {
+        address = 0;
+        file = 1;
+        line = 1;
+        is_stmt = default_is_stmt;
+        basic_block = false;
+      };
+
+      auto append = [&] (bool end_sequence) {
+        uint8_t flags = 0;
+        if (is_stmt)
+          flags |= line_table::begin_statement;
+        if (basic_block)
+          flags |= line_table::basic_block;
+        if (end_sequence)
+          flags |= line_table::end_sequence;
+        table.add (address, file, line, flags);
+      };
+
+      reset ();
+
+      while (r.valid () && r.offset () < end)
+      {
+        const uint64_t opcode = r.read (1);
+
+        if (opcode >= opcode_base)
+        {
+          const uint64_t adjusted = opcode - opcode_base;
+          line += line_base + static_cast < int32_t > (adjusted % line_range);
+          address += (adjusted / line_range) * min_length;
+          append (false);
+          basic_block = false;
+        }
+        else if (opcode == 0)
+        {
+          const uint64_t size = r.uleb ();
+          const size_t   next = r.offset () + size;
+          if (size == 0)
+            continue;
+          switch (r.read (1))
+          {
+            case DW_LNE_end_sequence:
+              append (true);
+              reset ();
+              break;
+            case DW_LNE_set_address:
+              address = r.read (size - 1);
+              break;
+            case DW_LNE_define_file:
+              add_file ();
+              break;
+            default:
+              break;
+          }
+          r.seek (next);
+        }
+        else
+        {
+          switch (opcode)
+          {
+            case DW_LNS_copy:
+              append (false);
+              basic_block = false;
+              break;
+            case DW_LNS_advance_pc:
+              address += r.uleb () * min_length;
+              break;
+            case DW_LNS_advance_line:
+              line += static_cast < int32_t > (r.sleb ());
+              break;
+            case DW_LNS_set_file:
+              file = static_cast < uint32_t > (r.uleb ());
+              break;
+            case DW_LNS_negate_stmt:
+              is_stmt = !is_stmt;
+              break;
+            case DW_LNS_set_basic_block:
+              basic_block = true;
+              break;
+            case DW_LNS_const_add_pc:
+              address += ((255 - opcode_base) / line_range) * min_length;
+              break;
+            case DW_LNS_fixed_advance_pc:
+              address += r.read (2);
+              break;
+            default:
+              /*
+               * Skip the operands of the other standard opcodes.
+               */
+              for (uint64_t a = 0; a < opcode_lengths[opcode]; ++a)
+                r.uleb ();
+              break;
+          }
+        }
+      }
+
+      if (!r.valid ())
+        throw rld::error ("invalid line program", "dwarf:lines");
+    }
+
+    bool
+    file::index_names ()
+    {
+      if (!names_indexed)
+      {
+        names.clear ();
+        names_complete = true;
+        names_indexed = load_debug_names () || load_gdb_index ();
+        if (!names_indexed)
+        {
+          names.clear ();
+          names_complete = false;
+          names_indexed = load_pubnames ();
+        }
+        for (auto& n : names)
+        {
+          std::sort (n.second.begin (), n.second.end ());
+          n.second.erase (std::unique (n.second.begin (), n.second.end ()),
+                          n.second.end ());
+        }
+        if (rld::verbose () >= RLD_VERBOSE_INFO)
+          std::cout << "dwarf::index-names: " << name ()
+                    << ": names: " << names.size () << std::endl;
+      }
+      return names_indexed;
+    }
+
+    bool
+    file::load_debug_names ()
+    {
+      const uint8_t* data;
+      size_t         size;
+      const uint8_t* strs;
+      size_t         strs_size;
+
+      if (!section_data (*elf_, ".debug_names", data, size) ||
+          !section_data (*elf_, ".debug_str", strs, strs_size))
+        return false;
+
+      const bool   msb = elf_->data_type () == ELFDATA2MSB;
+      table_reader r (data, size, msb);
+      table_reader str (strs, strs_size, msb);
+
+      /*
+       * There is an index for each module linked. Only the 32bit DWARF format
+       * is supported.
+       */
+      while (r.valid () && r.offset () < size)
+      {
+        const size_t   unit = r.offset ();
+        const uint64_t length = r.read (4);
+        if (length >= 0xfffffff0)
+          return false;
+        const size_t end = unit + 4 + length;
+
+        if (r.read (2) != 5)
+        {
+          r.seek (end);
+          continue;
+        }
+
+        r.skip (2);
+        const uint64_t cu_count = r.read (4);
+        const uint64_t local_tu_count = r.read (4);
+        const uint64_t foreign_tu_count = r.read (4);
+        const uint64_t bucket_count = r.read (4);
+        const uint64_t name_count = r.read (4);
+        const uint64_t abbrev_size = r.read (4);
+        r.skip (r.read (4));
+
+        cu_offsets cus_;
+        for (uint64_t c = 0; r.valid () && c < cu_count; ++c)
+          cus_.push_back (r.read (4));
+
+        r.skip (local_tu_count * 4 + foreign_tu_count * 8);
+        r.skip (bucket_count * 4);
+        if (bucket_count != 0)
+          r.skip (name_count * 4);
+
+        const size_t str_offsets = r.offset ();
+        const size_t entry_offsets = str_offsets + name_count * 4;
+        const size_t abbrevs = entry_offsets + name_count * 4;
+        const size_t pool = abbrevs + abbrev_size;
+
+        if (!r.valid () || pool > end)
+          return false;
+
+        /*
+         * The abbreviations are the index attributes and their forms for each
+         * abbreviation code.
+         */
+        typedef std::vector < std::pair < uint64_t, uint64_t > > idx_forms;
+        std::map < uint64_t, idx_forms > abbrev_table;
+
+        r.seek (abbrevs);
+        while (r.valid () && r.offset () < pool)
+        {
+          const uint64_t code = r.uleb ();
+          if (code == 0)
+            break;
+          r.uleb ();
+          idx_forms& forms = abbrev_table[code];
+          while (r.valid ())
+          {
+            const uint64_t idx = r.uleb ();
+            const uint64_t form = r.uleb ();
+            if (idx == 0 && form == 0)
+              break;
+            forms.push_back (std::make_pair (idx, form));
+          }
+        }
+
+        for (uint64_t n = 0; r.valid () && n < name_count; ++n)
+        {
+          r.seek (str_offsets + n * 4);
+          const char* name_ = str.string (r.read (4));
+          r.seek (entry_offsets + n * 4);
+          r.seek (pool + r.read (4));
+
+          if (name_ == nullptr)
+            continue;
+
+          while (r.valid ())
+          {
+            const uint64_t code = r.uleb ();
+            if (code == 0)
+              break;
+
+            auto abbrev = abbrev_table.find (code);
+            if (abbrev == abbrev_table.end ())
+              return false;
+
+            uint64_t cu = cu_count == 1 ? 0 : cu_count;
+
+            for (auto& f : abbrev->second)
+            {
+              uint64_t value = 0;
+              switch (f.second)
+              {
+                case DW_FORM_flag_present:
+                  break;
+                case DW_FORM_data1:
+                case DW_FORM_ref1:
+                case DW_FORM_flag:
+                  value = r.read (1);
+                  break;
+                case DW_FORM_data2:
+                case DW_FORM_ref2:
+                  value = r.read (2);
+                  break;
+                case DW_FORM_data4:
+                case DW_FORM_ref4:
+                case DW_FORM_strp:
+                case DW_FORM_sec_offset:
+                  value = r.read (4);
+                  break;
+                case DW_FORM_data8:
+                case DW_FORM_ref8:
+                case DW_FORM_ref_sig8:
+                  value = r.read (8);
+                  break;
+                case DW_FORM_udata:
+                case DW_FORM_ref_udata:
+                case DW_FORM_sdata:
+                  value = r.uleb ();
+                  break;
+                default:
+                  return false;
+              }
+              if (f.first == dw_idx_compile_unit)
+                cu = value;
+            }
+
+            if (cu < cus_.size ())
+              names[name_].push_back (cus_[cu]);
+          }
+        }
+
+        r.seek (end);
+      }
+
+      return r.valid () && !names.empty ();
+    }
+
+    bool
+    file::load_gdb_index ()
+    {
+      const uint8_t* data;
+      size_t         size;
+
+      if (!section_data (*elf_, ".gdb_index", data, size))
+        return false;
+
+      /*
+       * The index is always little endian. Version 9 adds the shortcut table
+       * before the constant pool.
+       */
+      table_reader   r (data, size, false);
+      const uint64_t version = r.read (4);
+
+      if (version < 7 || version > 9)
+        return false;
+
+      const uint64_t cu_list = r.read (4);
+      const uint64_t types_list = r.read (4);
+      r.read (4);
+      const uint64_t symbol_table = r.read (4);
+      const uint64_t symbol_table_end = r.read (4);
+      const uint64_t constant_pool =
+        version >= 9 ? r.read (4) : symbol_table_end;
+
+      if (!r.valid () || types_list < cu_list ||
+          symbol_table_end < symbol_table)
+        return false;
+
+      cu_offsets cus_;
+      r.seek (cu_list);
+      for (uint64_t c = 0; r.valid () && c < (types_list - cu_list) / 16; ++c)
+      {
+        cus_.push_back (r.read (8));
+        r.skip (8);
+      }
+
+      const uint64_t slots = (symbol_table_end - symbol_table) / 8;
+
+      for (uint64_t s = 0; r.valid () && s < slots; ++s)
+      {
+        r.seek (symbol_table + s * 8);
+        const uint64_t name_offset = r.read (4);
+        const uint64_t vector_offset = r.read (4);
+
+        if (name_offset == 0 && vector_offset == 0)
+          continue;
+
+        const char* name_ = r.string (constant_pool + name_offset);
+        if (name_ == nullptr)
+          return false;
+
+        r.seek (constant_pool + vector_offset);
+        const uint64_t count = r.read (4);
+        for (uint64_t e = 0; r.valid () && e < count; ++e)
+        {
+          const uint64_t cu = r.read (4) & 0xffffff;
+          if (cu < cus_.size ())
+            names[name_].push_back (cus_[cu]);
+        }
+      }
+
+      return r.valid () && !names.empty ();
+    }
+
+    bool
+    file::load_pubnames ()
+    {
+      dwarf_global* globals = nullptr;
+      dwarf_signed  count = 0;
+      dwarf_error   de;
+      int           dr;
+
+      dr = ::dwarf_get_globals (debug, &globals, &count, &de);
+      if (dr != DW_DLV_OK)
+        return false;
+
+      for (dwarf_signed g = 0; g < count; ++g)
+      {
+        char*        name_ = nullptr;
+        dwarf_offset cu_offset = 0;
+        if (::dwarf_globname (globals[g], &name_, &de) == DW_DLV_OK &&
+            ::dwarf_global_cu_offset (globals[g], &cu_offset, &de) == DW_DLV_OK)
+          names[name_].push_back (cu_offset);
+      }
+
+      ::dwarf_globals_dealloc (debug, globals, count);
+
+      return !names.empty ();
+    }
+
+    /**
+     * Find the function with the name in the functions. A function with
+     * machine code is preferred to a declaration.
+     */
+    static function*
+    find_named (functions& funcs, const std::string& name, function* found)
+    {
+      for (auto& func : funcs)
+      {
+        if (func.name () == name || func.linkage_name () == name)
+        {
+          if (func.has_machine_code ())
+            return &func;
+          if (found == nullptr)
+            found = &func;
+        }
+      }
+      return found;
+    }
+
+    function*
+    file::find_function_by_name (const std::string& name)
+    {
+      function* found = nullptr;
+
+      if (names_indexed)
+      {
+        auto ni = names.find (name);
+        if (ni != names.end ())
+        {
+          for (auto& cu : cus)
+          {
+            if (std::binary_search (ni->second.begin (), ni->second.end (),
+                                    cu.offset ()))
+            {
+              found = find_named (cu.get_functions (), name, found);
+              if (found != nullptr && found->has_machine_code ())
+                return found;
+            }
+          }
+        }
+        if (found != nullptr || names_complete)
+          return found;
+      }
+
+      for (auto& cu : cus)
+      {
+        found = find_named (cu.get_functions (), name, found);
+        if (found != nullptr && found->has_machine_code ())
+          break;
+      }
+
+      return found;
+    }
+
+    bool
+    file::function_valid (std::string& name)
+    {
+      return find_function_by_name (name) != nullptr;
+    }
+
+    function&
+    file::get_function (std::string& name)
+    {
+      function* func = find_function_by_name (name);
+      if (func == nullptr)
+        throw rld::error ("function not found: " + name, "dwarf:get-function");
+      return *func;
+    }
+
+    source_lookup::source_lookup (dwarf_address location)
+      : location (location),
+        source_file ("unknown"),
+        source_line (-1),
+        function ("unknown")
+    {
+    }
+
+    void
+    file::get_sources (source_lookups& lookups)
+    {
+      std::vector < size_t >  order;
+      std::vector < address > matches (lookups.size ());
+
+      sort_lookups (lookups, order);
+
+      auto location_less = [] (const address& a, dwarf_address v) {
+        return a.location () < v;
+      };
+
+      /*
+       * Merge the sorted addresses with each CU's sorted lines. The CUs are
+       * checked in image order so the match selected when an address is in
+       * more than one CU is the same as get_source.
+       */
+      for (auto& cu : cus)
+      {
+        if (cu.pc_low () >= cu.pc_high ()
+            || !lookups_inside (cu.pc_low (), cu.pc_high () - 1,
+                                lookups, order))
+          continue;
+
+        const addresses& lines = cu.get_addresses ();
+
+        if (lines.empty ())
+          continue;
+
+        auto line = lines.begin ();
+        auto first = std::lower_bound (order.begin (), order.end (),
+                                       lines.front ().location (),
+                                       [&lookups] (size_t o, dwarf_address v) {
+                                         return lookups[o].location < v;
+                                       });
+
+        for (auto o = first; o != order.end (); ++o)
+        {
+          dwarf_address addr = lookups[*o].location;
+
+          if (addr > lines.back ().location ())
+            break;
+
+          if (!cu.inside (addr))
+            continue;
+
+          line = std::lower_bound (line, lines.end (), addr, location_less);
+
+          address found;
+          if (addr == line->location ())
+            found = *line;
+          else if (line != lines.begin ())
+            found = *(line - 1);
+
+          if (found.valid ())
+          {
+            address& match = matches[*o];
+            if (!match.valid ()
+                || match.is_an_end_sequence ()
+                || !found.is_an_end_sequence ())
+              match = found;
+          }
+        }
+      }
+
+      for (size_t l = 0; l < lookups.size (); ++l)
+      {
+        if (matches[l].valid ())
+        {
+          lookups[l].source_file = matches[l].path ();
+          lookups[l].source_line = matches[l].line ();
+        }
+        else
+        {
+          lookups[l].source_file = "unknown";
+          lookups[l].source_line = -1;
+        }
+      }
+    }
+
+    void
+    file::get_functions (source_lookups& lookups)
+    {
+      struct func_range
+      {
+        dwarf_address   low;
+        dwarf_address   high;
+        const function* func;
+      };
+
+      std::vector < size_t >     order;
+      std::vector < func_range > funcs;
+
+      sort_lookups (lookups, order);
+
+      /*
+       * The functions in image order. The first function containing an
+       * address is the one get_function returns. A lazy load only searches
+       * the CUs that can hold the address's function so limit the functions
+       * to the range of their CU.
+       */
+      for (auto& cu : cus)
+      {
+        if (lazy_ && !lookups_inside (cu.pc_low (), cu.pc_high (),
+                                      lookups, order))
+          continue;
+
+        for (auto& func : cu.get_functions ())
+        {
+          if (!func.name ().empty () && func.has_machine_code ())
+          {
+            func_range fr;
+            fr.low = func.pc_low ();
+            fr.high = func.pc_high ();
+            fr.func = &func;
+            if (lazy_)
+            {
+              fr.low = std::max (fr.low, dwarf_address (cu.pc_low ()));
+              fr.high = std::min (fr.high, dwarf_address (cu.pc_high ()));
+            }
+            if (fr.low <= fr.high)
+              funcs.push_back (fr);
+          }
+        }
+      }
+
+      std::vector < size_t > by_low (funcs.size ());
+      std::iota (by_low.begin (), by_low.end (), 0);
+      std::stable_sort (by_low.begin (), by_low.end (),
+                        [&funcs] (size_t a, size_t b) {
+                          return funcs[a].low < funcs[b].low;
+                        });
+
+      /*
+       * Sweep the sorted addresses holding the functions whose range has
+       * started. The active functions are held in image order and removed
+       * once the sweep passes their high address.
+       */
+      typedef std::pair < dwarf_address, size_t > func_end;
+
+      std::set < size_t >  active;
+      std::priority_queue < func_end,
+                            std::vector < func_end >,
+                            std::greater < func_end > > ends;
+      size_t next = 0;
+
+      for (auto o : order)
+      {
+        dwarf_address addr = lookups[o].location;
+
+        while (next < by_low.size () && funcs[by_low[next]].low <= addr)
+        {
+          active.insert (by_low[next]);
+          ends.push (func_end (funcs[by_low[next]].high, by_low[next]));
+          ++next;
+        }
+
+        while (!ends.empty () && ends.top ().first < addr)
+        {
+          active.erase (ends.top ().second);
+          ends.pop ();
+        }
+
+        if (active.empty ())
+          lookups[o].function = "unknown";
+        else
+          lookups[o].function = funcs[*active.begin ()].func->name ();
+      }
+    }
+
+    void
+    file::get_producer_sources (producer_sources& producers)
+    {
+      for (auto& cu : cus)
+      {
+        std::string     producer = cu.producer ();
+        producer_source new_producer;
+        source_flags    sf (cu.name ());
+        rld::strings    parts;
+
+        rld::split (parts, producer);
+
+        for (auto& s : parts)
+        {
+          if (s[0] == '-')
+            sf.flags.push_back (s);
+          else
+            new_producer.producer +=  ' ' + s;
+        }
+
+        bool add = true;
+
+        for (auto& p : producers)
+        {
+          if (p.producer == new_producer.producer)
+          {
+            p.sources.push_back (sf);
+            add = false;
+            break;
+          }
+        }
+        if (add)
+        {
+          new_producer.sources.push_back (sf);
+          producers.push_back (new_producer);
+        }
+      }
+    }
+
+    dwarf&
+    file::get_debug ()
+    {
+      return debug;
+    }
+
+    compilation_units&
+    file::get_cus ()
+    {
+      return cus;
+    }
+
+    const std::string&
+    file::name () const
+    {
+      if (!elf_)
+        throw rld::error ("No begin called", "dwarf:fie:name");
+      return elf_->name ();
+    }
+
+    void
+    file::check (const char* where) const
+    {
+      if (!debug || !elf_)
+      {
+        std::string w = where;
+        throw rld::error ("No DWARF or ELF file", "dwarf:file:" + w);
+      }
+    }
+
+    bool
+    has_debug_info (rld::elf::file& elf)
+    {
+      const uint8_t* data;
+      size_t         size;
+      return section_data (elf, ".debug_info", data, size) && size != 0;
+    }
+
+    /**
+     * The CRC of a .gnu_debuglink file.
+     */
+    static uint32_t
+    debuglink_crc (const uint8_t* data, size_t size, uint32_t crc)
+    {
+      crc = ~crc;
+      for (size_t b = 0; b < size; ++b)
+      {
+        crc ^= data[b];
+        for (int bit = 0; bit < 8; ++bit)
+          crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+      }
+      return ~crc;
+    }
+
+    static bool
+    debuglink_matches (const std::string& path, uint32_t crc)
+    {
+      if (!rld::path::check_file (path))
+        return false;
+
+      rld::files::view file (path);
+      uint32_t         file_crc = 0;
+
+      if (file.mapped ())
+        file_crc = debuglink_crc (file.data (), file.size (), 0);
+      else
+      {
+        std::vector < uint8_t > buffer (64 * 1024);
+        off_t                   offset = 0;
+        while (true)
+        {
+          size_t size = file.read (offset, buffer.data (), buffer.size ());
+          if (size == 0)
+            break;
+          file_crc = debuglink_crc (buffer.data (), size, file_crc);
+          offset += size;
+        }
+      }
+
+      return file_crc == crc;
+    }
+
+    bool
+    find_debug_file (rld::elf::file&         elf,
+                     std::string&            path,
+                     const rld::path::paths& debug_dirs)
+    {
+      rld::path::paths dirs (debug_dirs);
+      const uint8_t*   data;
+      size_t           size;
+
+      if (dirs.empty ())
+        dirs.push_back (RLD_DWARF_DEBUG_DIR);
+
+      path.clear ();
+
+      const bool msb = elf.data_type () == ELFDATA2MSB;
+
+      /*
+       * The build-id note's descriptor is the ID and the file is
+       * .build-id/xx/yyyy.debug where xx is the first byte in hex.
+       */
+      if (section_data (elf, ".note.gnu.build-id", data, size, SHT_NOTE))
+      {
+        table_reader   r (data, size, msb);
+        const uint64_t name_size = r.read (4);
+        const uint64_t desc_size = r.read (4);
+        const uint64_t type = r.read (4);
+        r.skip ((name_size + 3) & ~3);
+        const size_t   desc = r.offset ();
+        r.skip (desc_size);
+        if (r.valid () && type == NT_GNU_BUILD_ID && desc_size > 1)
+        {
+          std::ostringstream id;
+          id << std::hex << std::setfill ('0');
+          for (size_t b = 0; b < desc_size; ++b)
+          {
+            if (b == 1)
+              id << '/';
+            id << std::setw (2) << static_cast < unsigned int > (data[desc + b]);
+          }
+          id << ".debug";
+          for (auto& dir : dirs)
+          {
+            std::string build_id;
+            rld::path::path_join (dir, ".build-id", build_id);
+            rld::path::path_join (build_id, id.str (), build_id);
+            if (rld::path::check_file (build_id))
+            {
+              path = build_id;
+              return true;
+            }
+          }
+        }
+      }
+
+      /*
+       * The debug link is the file's name, padding to 4 bytes and the CRC.
+       */
+      if (section_data (elf, ".gnu_debuglink", data, size))
+      {
+        table_reader r (data, size, msb);
+        const char*  name = r.cstring ();
+        if (name != nullptr && *name != '\0')
+        {
+          r.seek ((r.offset () + 3) & ~3);
+          const uint32_t crc = r.read (4);
+          if (r.valid ())
+          {
+            const std::string image_dir =
+              rld::path::dirname (rld::path::path_abs (elf.name ()));
+            rld::path::paths candidates;
+            std::string      candidate;
+            rld::path::path_join (image_dir, name, candidate);
+            candidates.push_back (candidate);
+            rld::path::path_join (image_dir, ".debug", candidate);
+            rld::path::path_join (candidate, name, candidate);
+            candidates.push_back (candidate);
+            for (auto& dir : dirs)
+            {
+              rld::path::path_join (dir, image_dir, candidate);
+              rld::path::path_join (candidate, name, candidate);
+              candidates.push_back (candidate);
+            }
+            for (auto& c : candidates)
+            {
+              if (c != elf.name () && debuglink_matches (c, crc))
+              {
+                path = c;
+                return true;
+              }
+            }
+          }
+        }
+      }
+
+      return false;
     }
 
   }
@@ -26,9 +26,11 @@
 #define _RLD_DWARF_H_
 
 #include <iostream>
+#include <unordered_map>
 
 #include <rld.h>
 #include <rld-dwarf-types.h>
+#include <rld-path.h>
 
 namespace rld
 {
@@ -40,6 +42,7 @@ namespace rld
     class sources;
     class debug_info_entry;
     class file;
+    struct line_table;
 
     /**
      * Address.
@@ -47,10 +50,13 @@ namespace rld
     class address
     {
     public:
-      address (const sources& source, dwarf_line& line);
+      address (const sources&   source,
+               const line_table& table,
+               size_t            row,
+               dwarf_address     addr);
       address (const address& orig, const sources& source);
       address (const address& orig, dwarf_address addr);
-      address (const address& orig);
+      address (const address& orig) noexcept;
       address ();
       ~address ();
 
@@ -90,9 +96,10 @@ namespace rld
       bool is_an_end_sequence () const;
 
       /**
-       * Assigment operator.
+       * Assigment operator. An address is a few values and a pointer to its
+       * sources table so a copy is a move.
        */
-      address& operator = (const address& rhs);
+      address& operator = (const address& rhs) noexcept;
 
       /**
        * Less than operator to allow sorting.
@@ -103,8 +110,8 @@ namespace rld
 
       dwarf_address  addr;
       sources const* source;
-      dwarf_unsigned source_index;
-      dwarf_signed   source_line;
+      uint32_t       source_index;
+      int32_t        source_line;
       bool           begin_statement;
       bool           block;
       bool           end_sequence;
@@ -122,7 +129,7 @@ namespace rld
     {
     public:
       range (const dwarf_ranges* range);
-      range (const range& orig);
+      range (const range& orig) noexcept;
       ~range ();
 
       /**
@@ -147,9 +154,10 @@ namespace rld
       bool empty () const;
 
       /**
-       * Assigment operator.
+       * Assigment operator. A range is a pointer to the libdwarf range so a
+       * copy is a move.
        */
-      range& operator = (const range& rhs);
+      range& operator = (const range& rhs) noexcept;
 
       /**
        * Dump the range.
@@ -173,6 +181,7 @@ namespace rld
       address_ranges (debug_info_entry& die);
       address_ranges (file& debug, dwarf_offset offset);
       address_ranges (const address_ranges& orig);
+      address_ranges (address_ranges&& orig) noexcept;
       ~address_ranges ();
 
       /**
@@ -196,10 +205,16 @@ namespace rld
       bool empty () const;
 
       /**
-       * Assigment operator.
+       * Assigment operator. The ranges are loaded again.
        */
       address_ranges& operator = (const address_ranges& rhs);
 
+      /**
+       * Move assigment operator. The libdwarf ranges are taken from the
+       * right hand side and are not loaded again.
+       */
+      address_ranges& operator = (address_ranges&& rhs);
+
       /**
        * Dump the address ranges.
        */
@@ -240,6 +255,47 @@ namespace rld
       dwarf_signed count_;
     };
 
+    /**
+     * Line table.
+     *
+     * The rows of a CU's line program. Each register is held in its own
+     * array to keep the table compact. The file numbers index the paths
+     * from 1.
+     */
+    struct line_table
+    {
+      /**
+       * The row flags.
+       */
+      enum row_flag
+      {
+        begin_statement = 1 << 0,
+        basic_block     = 1 << 1,
+        end_sequence    = 1 << 2
+      };
+
+      std::vector < dwarf_address > addrs; ///< The row addresses.
+      std::vector < uint32_t >      files; ///< The row file numbers.
+      std::vector < int32_t >       lines; ///< The row line numbers.
+      std::vector < uint8_t >       flags; ///< The row flags.
+      rld::strings                  paths; ///< The source file paths.
+
+      /**
+       * Add a row.
+       */
+      void add (dwarf_address addr, uint32_t file, int32_t line, uint8_t flags);
+
+      /**
+       * The number of rows.
+       */
+      size_t size () const;
+
+      /**
+       * Release the rows and paths.
+       */
+      void clear ();
+    };
+
     /**
      * Sources.
      *
@@ -249,31 +305,26 @@ namespace rld
     class sources
     {
     public:
-      sources (file& debug, dwarf_offset die_offset);
-      sources (const sources& orig);
-      ~sources ();
+      sources ();
 
       /**
-       * Index operator.
+       * Load the CU's table of sources using libdwarf.
        */
-      std::string operator [] (const int index) const;
+      sources (file& debug, dwarf_offset die_offset);
 
       /**
-       * Deallocate.
+       * Index operator.
        */
-      void dealloc ();
+      std::string operator [] (const int index) const;
 
       /**
-       * Move assignment operator.
+       * Take the paths of a line table.
        */
-      sources& operator = (sources&& rhs);
+      void set (rld::strings& paths);
 
     private:
 
-      file&        debug;
-      char**       source;
-      dwarf_signed count;
-      dwarf_offset die_offset;
+      rld::strings paths; ///< The source paths.
     };
 
     /**
@@ -285,12 +336,13 @@ namespace rld
 
       variable (file& debug, debug_info_entry& die);
       variable (const variable& orig);
+      variable (variable&& orig) noexcept;
       ~variable ();
 
       /**
        * Get the name of the variable.
        */
-      std::string name () const;
+      const std::string& name () const;
 
       /**
        * Is the variable external?
@@ -312,6 +364,11 @@ namespace rld
        */
       variable& operator = (const variable& rhs);
 
+      /**
+       * Move assigment operator.
+       */
+      variable& operator = (variable&& rhs);
+
       /**
        * Dump the variable.
        */
@@ -319,12 +376,12 @@ namespace rld
 
     private:
 
-      file&          debug;
-      bool           external_;
-      bool           declaration_;
-      std::string    name_;
-      std::string    decl_file_;
-      dwarf_unsigned decl_line_;
+      file&              debug;
+      bool               external_;
+      bool               declaration_;
+      const std::string* name_;      ///< Interned, see rld::intern.
+      const std::string* decl_file_; ///< Interned.
+      dwarf_unsigned     decl_line_;
     };
 
     typedef std::vector < variable > variables;
@@ -348,17 +405,18 @@ namespace rld
 
       function (file& debug, debug_info_entry& die);
       function (const function& orig);
+      function (function&& orig) noexcept;
       ~function ();
 
       /**
        * Get the name of the function.
        */
-      std::string name () const;
+      const std::string& name () const;
 
       /**
        * Get the linkage name of the function.
        */
-      std::string linkage_name () const;
+      const std::string& linkage_name () const;
 
       /**
        * Get the ranges for the funcion, if empty the PC low and PC high values
@@ -409,13 +467,25 @@ namespace rld
       /**
        * Get the call file of the inlined function.
        */
-      std::string call_file () const;
+      const std::string& call_file () const;
+
+      /**
+       * Get the call line of the inlined function.
+       */
+      dwarf_unsigned call_line () const;
 
       /**
        * Is the address inside the function.
        */
       bool inside (dwarf_address addr) const;
 
+      /**
+       * Is the address in the function's machine code? The address ranges
+       * are checked if the function has them and the high addresses are not
+       * included.
+       */
+      bool contains (dwarf_address addr) const;
+
       /**
        * Size of the function.
        */
@@ -426,6 +496,12 @@ namespace rld
        */
       function& operator = (const function& rhs);
 
+      /**
+       * Move assigment operator. Sorting the functions moves them and does
+       * not reload their address ranges.
+       */
+      function& operator = (function&& rhs);
+
       /**
        * Dump the function.
        */
@@ -433,26 +509,27 @@ namespace rld
 
     private:
 
-      file&          debug;
-      bool           machine_code_;
-      bool           external_;
-      bool           declaration_;
-      bool           prototyped_;
-      dwarf_unsigned inline_;
-      dwarf_unsigned entry_pc_;
-      bool           has_entry_pc_;
-      dwarf_unsigned pc_low_;
-      dwarf_unsigned pc_high_;
-      address_ranges ranges_;
-      std::string    name_;
-      std::string    linkage_name_;
-      std::string    decl_file_;
-      dwarf_unsigned decl_line_;
-      std::string    call_file_;
-      dwarf_unsigned call_line_;
+      file&              debug;
+      bool               machine_code_;
+      bool               external_;
+      bool               declaration_;
+      bool               prototyped_;
+      dwarf_unsigned     inline_;
+      dwarf_unsigned     entry_pc_;
+      bool               has_entry_pc_;
+      dwarf_unsigned     pc_low_;
+      dwarf_unsigned     pc_high_;
+      address_ranges     ranges_;
+      const std::string* name_;         ///< Interned, see rld::intern.
+      const std::string* linkage_name_; ///< Interned.
+      const std::string* decl_file_;    ///< Interned.
+      dwarf_unsigned     decl_line_;
+      const std::string* call_file_;    ///< Interned.
+      dwarf_unsigned     call_line_;
     };
 
     typedef std::vector < function > functions;
+    typedef std::vector < const function* > function_pointers;
 
     /**
      * Worker to sort the functions.
@@ -572,6 +649,14 @@ namespace rld
                       std::string& value,
                       bool         error = true) const;
 
+      /**
+       * Get a section offset attribute. The offset can be a constant or a
+       * section offset form.
+       */
+      bool section_offset (dwarf_attr      attr,
+                           dwarf_unsigned& value,
+                           bool            error = true) const;
+
       /**
        * Get source lines. Returns the CU line table with all columns.
        *
@@ -668,7 +753,8 @@ namespace rld
     public:
       compilation_unit (file&             debug,
                         debug_info_entry& die,
-                        dwarf_offset      offset);
+                        dwarf_offset      offset,
+                        bool              lazy = false);
       compilation_unit (const compilation_unit& orig);
       ~compilation_unit ();
 
@@ -687,6 +773,35 @@ namespace rld
        */
       void load_functions ();
 
+      /**
+       * Load the functions the first time they are requested.
+       */
+      void load_functions_on_demand ();
+
+      /**
+       * Read the line table. The lines cannot be used until they have been
+       * processed. If the CU's line program is not decoded natively only one
+       * thread can read a file's line tables at a time.
+       */
+      void read_lines () const;
+
+      /**
+       * Is the line program decoded natively? A native decode does not use
+       * libdwarf and can run on any thread.
+       */
+      bool native_lines () const;
+
+      /**
+       * Process the read line table. This does not access the DWARF data so
+       * different CUs can be processed on different threads.
+       */
+      void process_lines () const;
+
+      /**
+       * Trace the line table if the verbose level is full debug.
+       */
+      void trace_lines () const;
+
       /**
        * Name of the CU.
        */
@@ -708,7 +823,8 @@ namespace rld
       unsigned int pc_high () const;
 
       /**
-       * The addresses associated with this compilation unit.
+       * The addresses associated with this compilation unit. A lazy CU loads
+       * its line table the first time it is needed.
        */
       const addresses& get_addresses () const;
 
@@ -731,6 +847,31 @@ namespace rld
        */
       bool inside (dwarf_unsigned addr) const;
 
+      /**
+       * The offset of the CU's header in the .debug_info section.
+       */
+      dwarf_unsigned offset () const;
+
+      /**
+       * Is the CU a split DWARF skeleton? The skeleton holds the line table
+       * and address range and the rest of the unit is in a .dwo file.
+       */
+      bool skeleton () const;
+
+      /**
+       * The name of the skeleton's .dwo file, empty if not a skeleton.
+       */
+      const std::string& dwo_name () const;
+
+      /**
+       * The path of the skeleton's .dwo file. The path is found the first
+       * time it is requested. A relative name is found in the compilation
+       * directory, the image's directory or the current directory.
+       *
+       * @return const std::string& The path, empty if the file is not found.
+       */
+      const std::string& dwo_path () const;
+
       /**
        * Copy assignment operator.
        */
@@ -747,6 +888,7 @@ namespace rld
 
       void load_variables (debug_info_entry& die);
       void load_functions (debug_info_entry& die);
+      void load_lines () const;
 
       file&          debug;       ///< The DWARF debug handle.
       dwarf_unsigned offset_;     ///< The CU offset in .debug_info
@@ -757,11 +899,22 @@ namespace rld
       address_ranges ranges_;     ///< Non-continous address range.
 
       dwarf_offset   die_offset;  ///< The offset of the DIE in the image.
-
-      sources        source_;     ///< Sources table for this CU.
-      addresses      addr_lines_; ///< Address table.
+      dwarf_unsigned stmt_list_;  ///< The line program's offset.
+      std::string    comp_dir_;   ///< The compilation directory.
+      std::string    dwo_name_;   ///< The skeleton's .dwo file name.
+      mutable std::string dwo_path_;  ///< The .dwo file path.
+      mutable bool        dwo_found_; ///< The .dwo file path is searched for.
+      bool           native_lines_; ///< The line program is decoded
+                                    ///  natively.
+
+      mutable sources    source_;      ///< Sources table for this CU.
+      mutable line_table line_rows_;   ///< The read and unprocessed lines.
+      mutable addresses  addr_lines_;  ///< Address table.
+      mutable bool       lines_loaded_;  ///< The address table is loaded.
 
       functions      functions_;  ///< The functions in the CU.
+      bool           functions_on_demand_; ///< Load the functions when
+                                           ///  requested.
     };
 
     typedef std::list < compilation_unit > compilation_units;
@@ -806,6 +959,21 @@ namespace rld
 
     typedef std::list < producer_source > producer_sources;
 
+    /**
+     * An address to resolve as part of a batch of addresses.
+     */
+    struct source_lookup
+    {
+      dwarf_address location;    ///< The address to resolve.
+      std::string   source_file; ///< The source file, 'unknown' if not found.
+      int           source_line; ///< The source line, -1 if not found.
+      std::string   function;    ///< The function, 'unknown' if not found.
+
+      source_lookup (dwarf_address location = 0);
+    };
+
+    typedef std::vector < source_lookup > source_lookups;
+
     /**
      * A DWARF file.
      */
@@ -835,9 +1003,21 @@ namespace rld
       void end ();
 
       /**
-       * Load the DWARF debug information.
+       * Load the DWARF debug information. A lazy load only reads the
+       * compilation unit DIEs. A compilation unit's line table and functions
+       * are loaded the first time a lookup needs them and only the compilation
+       * units whose address range covers the address are searched. A lazily
+       * loaded file cannot be shared between threads.
+       *
+       * An eager load can process the line tables of the compilation units
+       * on more than one thread. The line tables are read from libdwarf on
+       * the calling thread while the read tables are processed and sorted by
+       * the other threads.
+       *
+       * @param lazy Load the compilation units on demand.
+       * @param jobs The number of threads to process the line tables with.
        */
-      void load_debug ();
+      void load_debug (bool lazy = false, unsigned int jobs = 1);
 
       /**
        * Load the DWARF type information.
@@ -861,6 +1041,20 @@ namespace rld
                        std::string&       source_file,
                        int&               source_line);
 
+      /**
+       * Get the source locations of a batch of addresses. The addresses are
+       * sorted and each CU's line table is walked once. The results match
+       * calling get_source for each address.
+       */
+      void get_sources (source_lookups& lookups);
+
+      /**
+       * Get the functions of a batch of addresses. The addresses are sorted
+       * and the function ranges are swept once. The results match calling
+       * get_function for each address.
+       */
+      void get_functions (source_lookups& lookups);
+
       /**
        * Get the producer sources from the compilation units.
        */
@@ -872,21 +1066,86 @@ namespace rld
       variable& get_variable (std::string& name);
 
       /**
-       * Does the function exist.
+       * Load the name index from the image's .debug_names or .gdb_index
+       * accelerator table or its .debug_pubnames section. A name lookup only
+       * loads the functions of the CUs the index lists for the name. The
+       * public names only hold the global names so a name not found in them
+       * is searched for in all the CUs.
+       *
+       * @retval true The image has a name index.
+       * @retval false There is no name index and lookups search all CUs.
+       */
+      bool index_names ();
+
+      /**
+       * Does the function exist. The name index is used if it is loaded.
        */
       bool function_valid (std::string&name);
 
       /**
-       * Get the function given a name. Raises an exception if not found.
+       * Get the function given a name. Raises an exception if not found. The
+       * name index is used if it is loaded.
        */
       function& get_function (std::string& name);
 
       /**
-       * Get the function given an address.
+       * Get the function given an address. The function index is used if it
+       * has been built.
        */
       bool get_function (const unsigned int address,
                          std::string&       name);
 
+      /**
+       * Build the index of the address ranges of the functions and their
+       * inlined instances. The functions of all the CUs are loaded. Once
+       * built the function queries only read the index and can be made from
+       * more than one thread.
+       */
+      void index_functions ();
+
+      /**
+       * Get the innermost function whose machine code contains the address.
+       * If the address is in inlined code this is the inlined instance. The
+       * function index is built if it has not been.
+       *
+       * @param addr The address.
+       * @return const function* The function or nullptr if not found.
+       */
+      const function* find_function (dwarf_address addr);
+
+      /**
+       * Get the functions whose machine code contains the address from the
+       * outermost to the innermost. The functions after the first are the
+       * inlined frames at the address. The function index is built if it has
+       * not been.
+       *
+       * @param addr The address.
+       * @param frames The functions containing the address.
+       */
+      void find_functions (dwarf_address addr, function_pointers& frames);
+
+      /**
+       * Can the line program at the offset in the .debug_line section be
+       * decoded natively? The section has to be present, not compressed and
+       * not need relocating and the program's version is 2 to 4.
+       */
+      bool native_lines (dwarf_unsigned offset) const;
+
+      /**
+       * Decode the line program at the offset in the .debug_line section
+       * into the table. This reads the section's data and does not use
+       * libdwarf so different line programs can be decoded on different
+       * threads. The rows match the ones libdwarf returns.
+       *
+       * @param offset The offset of the line program.
+       * @param comp_dir The CU's compilation directory.
+       * @param table The table the rows and paths are added to.
+       * @throw rld::error The line program is not valid.
+       */
+      void decode_lines (dwarf_unsigned     offset,
+                         const std::string& comp_dir,
+                         line_table&        table) const;
+
       /**
        * Get the DWARF debug information reference.
        */
@@ -923,13 +1182,118 @@ namespace rld
        */
       void check (const char* where) const;
 
+      /**
+       * Build the index of the address ranges of the compilation units.
+       */
+      void index_cus ();
+
+      /**
+       * An entry in the compilation unit address index.
+       */
+      struct cu_index_entry
+      {
+        dwarf_address     low;      ///< The lowest line address.
+        dwarf_address     high;     ///< The highest line address.
+        dwarf_address     max_high; ///< The highest address of this and the
+                                    ///  lower entries.
+        size_t            order;    ///< The position of the CU in the image.
+        compilation_unit* cu;       ///< The compilation unit.
+      };
+
+      typedef std::vector < cu_index_entry > cu_indexes;
+
+      /**
+       * Get the entries of the function index that can contain the address
+       * in image order.
+       */
+      void function_candidates (dwarf_address                   addr,
+                                std::vector < const function* >& candidates);
+
+      /**
+       * An entry in the function address index.
+       */
+      struct func_index_entry
+      {
+        dwarf_address   low;      ///< The function's low address.
+        dwarf_address   high;     ///< The function's high address.
+        dwarf_address   max_high; ///< The highest address of this and the
+                                  ///  lower entries.
+        size_t          order;    ///< The position of the function in the
+                                  ///  image.
+        const function* func;     ///< The function.
+      };
+
+      typedef std::vector < func_index_entry > func_indexes;
+
+      /**
+       * Load the name index from the accelerator tables.
+       */
+      bool load_debug_names ();
+      bool load_gdb_index ();
+      bool load_pubnames ();
+
+      /**
+       * Find a function by name, nullptr if not found.
+       */
+      function* find_function_by_name (const std::string& name);
+
+      /**
+       * The offsets of the CUs holding a name.
+       */
+      typedef std::vector < dwarf_unsigned > cu_offsets;
+      typedef std::unordered_map < std::string, cu_offsets > name_indexes;
+
       dwarf           debug;   ///< The libdwarf debug data
       rld::elf::file* elf_;    ///< The libelf reference used to access the
                                ///  DWARF data.
-
-      compilation_units cus;   ///< Image's compilation units
+      const uint8_t*  line_data; ///< The .debug_line data if it can be
+                                 ///  decoded natively.
+      size_t          line_size; ///< The size of the .debug_line data.
+      bool            line_msb;  ///< The data is big endian.
+
+      bool              lazy_;    ///< The CUs are loaded on demand.
+      compilation_units cus;      ///< Image's compilation units
+      cu_indexes        cu_index; ///< The CU address index sorted by the
+                                  ///  low address.
+      func_indexes      func_index;   ///< The function address index sorted
+                                      ///  by the low address.
+      bool              func_indexed; ///< The function index is built.
+      name_indexes      names;          ///< The CUs a name is in.
+      bool              names_indexed;  ///< The name index is loaded.
+      bool              names_complete; ///< The name index has all names.
     };
 
+    /**
+     * The directory separate debug files are installed under.
+     */
+    #define RLD_DWARF_DEBUG_DIR "/usr/lib/debug"
+
+    /**
+     * Does the ELF file hold DWARF debug information? The debug information
+     * of a stripped image can be in a separate debug file.
+     *
+     * @param elf The ELF file.
+     * @retval true The file has a .debug_info section.
+     */
+    bool has_debug_info (rld::elf::file& elf);
+
+    /**
+     * Find the separate debug file of an image. The image's build-id is
+     * looked for in the .build-id directory of each debug directory. The
+     * image's .gnu_debuglink file is looked for next to the image, in the
+     * image's .debug directory and in the image's directory under each debug
+     * directory, and its CRC has to match the link's.
+     *
+     * @param elf The image.
+     * @param path The path of the debug file if found.
+     * @param debug_dirs The debug directories, RLD_DWARF_DEBUG_DIR if empty.
+     * @retval true A debug file is found.
+     * @retval false There is no debug file.
+     */
+    bool find_debug_file (rld::elf::file&         elf,
+                          std::string&            path,
+                          const rld::path::paths& debug_dirs =
+                            rld::path::paths ());
   }
 }
 
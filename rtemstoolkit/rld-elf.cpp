@@ -23,6 +23,9 @@
  */
 
 #include <string.h>
+#include <sys/stat.h>
+
+#include <mutex>
 
 #include <rld.h>
 
@@ -40,30 +43,111 @@ namespace rld
       throw rld::error (::elf_errmsg (-1), "libelf:" + where);
     }
 
-    /**
-     * We record the first class, machine and .. type of object file we get the
-     * header of and all header must match. We cannot mix object module types.
-     */
-    static unsigned int elf_object_class = ELFCLASSNONE;
-    static unsigned int elf_object_machinetype = EM_NONE;
-    static unsigned int elf_object_datatype = ELFDATANONE;
-
     /**
      * A single place to initialise the libelf library. This must be called
-     * before any libelf API calls are made.
+     * before any libelf API calls are made. Files can be opened on more than
+     * one thread.
      */
     static void
     libelf_initialise ()
     {
-      static bool libelf_initialised = false;
-      if (!libelf_initialised)
+      static std::once_flag libelf_initialised;
+      std::call_once (libelf_initialised, [] {
+          if (::elf_version (EV_CURRENT) == EV_NONE)
+            libelf_error ("initialisation");
+        });
+    }
+
+    /*
+     * Widen an entry of the native ELF class to the generic form as the gelf
+     * calls do.
+     */
+    static inline void
+    widen (const Elf32_Sym& in, elf_sym& out)
+    {
+      out.st_name = in.st_name;
+      out.st_info = in.st_info;
+      out.st_other = in.st_other;
+      out.st_shndx = in.st_shndx;
+      out.st_value = in.st_value;
+      out.st_size = in.st_size;
+    }
+
+    static inline void
+    widen (const Elf64_Sym& in, elf_sym& out)
+    {
+      out = in;
+    }
+
+    static inline void
+    widen (const Elf32_Rel& in, elf_rela& out)
+    {
+      out.r_offset = in.r_offset;
+      out.r_info = ELF64_R_INFO ((Elf64_Xword) ELF32_R_SYM (in.r_info),
+                                 ELF32_R_TYPE (in.r_info));
+      out.r_addend = 0;
+    }
+
+    static inline void
+    widen (const Elf32_Rela& in, elf_rela& out)
+    {
+      out.r_offset = in.r_offset;
+      out.r_info = ELF64_R_INFO ((Elf64_Xword) ELF32_R_SYM (in.r_info),
+                                 ELF32_R_TYPE (in.r_info));
+      out.r_addend = in.r_addend;
+    }
+
+    static inline void
+    widen (const Elf64_Rel& in, elf_rela& out)
+    {
+      out.r_offset = in.r_offset;
+      out.r_info = in.r_info;
+      out.r_addend = 0;
+    }
+
+    static inline void
+    widen (const Elf64_Rela& in, elf_rela& out)
+    {
+      out = in;
+    }
+
+    /*
+     * Widen the entries of a section's data in one pass. The data of a
+     * mapped file may not be aligned for the host so each entry is copied.
+     */
+    template < typename E, typename G >
+    static void
+    widen_entries (const elf_data* data, size_t count, std::vector < G >& out)
+    {
+      const uint8_t* in = static_cast < const uint8_t* > (data->d_buf);
+      out.resize (count);
+      for (size_t e = 0; e < count; ++e, in += sizeof (E))
       {
-        if (::elf_version (EV_CURRENT) == EV_NONE)
-          libelf_error ("initialisation");
-        libelf_initialised = true;
+        E entry;
+        ::memcpy (&entry, in, sizeof (entry));
+        widen (entry, out[e]);
       }
     }
 
+    /*
+     * Check the data of a section holds the entries of the type.
+     */
+    static void
+    check_entries (const section& sec,
+                   const elf_data* data,
+                   Elf_Type        type,
+                   size_t          count,
+                   size_t          entry_size,
+                   const char*     where,
+                   const file&     file_)
+    {
+      if (data == nullptr || data->d_buf == nullptr || data->d_type != type ||
+          (data->d_size / entry_size) < count)
+        throw rld::error ("invalid data: " + sec.name (),
+                          std::string ("elf:file:") + where + ": " +
+                          file_.name ());
+    }
+
     relocation::relocation (const symbols::symbol& sym,
                             elf_addr               offset,
                             elf_xword              info,
@@ -129,7 +213,7 @@ namespace rld
                       elf_xword          entry_size)
       : file_ (&file_),
         index_ (index_),
-        name_ (name_),
+        name_ (&rld::intern (name_)),
         scn (0),
         data_ (0),
         rela (false)
@@ -166,6 +250,7 @@ namespace rld
     section::section (file& file_, int index_)
       : file_ (&file_),
         index_ (index_),
+        name_ (&rld::intern ("")),
         scn (0),
         data_ (0),
         rela (false)
@@ -179,17 +264,11 @@ namespace rld
       if (!::gelf_getshdr (scn, &shdr))
         libelf_error ("gelf_getshdr: " + file_.name ());
 
+      /*
+       * The data is read when it is first used.
+       */
       if (shdr.sh_type != SHT_NULL)
-      {
-        name_ = file_.get_string (shdr.sh_name);
-        data_ = ::elf_getdata (scn, 0);
-        if (!data_)
-        {
-          data_ = ::elf_rawdata (scn, 0);
-          if (!data_)
-            libelf_error ("elf_getdata: " + name_ + '(' + file_.name () + ')');
-        }
-      }
+        name_ = &rld::intern (file_.get_string (shdr.sh_name));
 
       if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
         std::cout << "elf::section: index=" << index ()
@@ -215,6 +294,7 @@ namespace rld
     section::section ()
       : file_ (0),
         index_ (-1),
+        name_ (&rld::intern ("")),
         scn (0),
         data_ (0),
         rela (false)
@@ -233,7 +313,7 @@ namespace rld
 
       data_ = ::elf_newdata(scn);
       if (!data_)
-        libelf_error ("elf_newdata: " + name_ + " (" + file_->name () + ')');
+        libelf_error ("elf_newdata: " + *name_ + " (" + file_->name () + ')');
 
       data_->d_type = type;
       data_->d_off = offset;
@@ -243,7 +323,7 @@ namespace rld
       data_->d_buf = buffer;
 
       if (!gelf_update_shdr (scn, &shdr))
-        libelf_error ("gelf_update_shdr: " + name_ + " (" + file_->name () + ')');
+        libelf_error ("gelf_update_shdr: " + *name_ + " (" + file_->name () + ')');
     }
 
     int
@@ -257,13 +337,29 @@ namespace rld
     section::name () const
     {
       check ("name");
-      return name_;
+      return *name_;
     }
 
     elf_data*
     section::data ()
     {
       check ("data");
+      if (!data_ && (shdr.sh_type != SHT_NULL))
+      {
+        if (!scn)
+        {
+          scn = ::elf_getscn (file_->get_elf (), index_);
+          if (!scn)
+            libelf_error ("elf_getscn: " + file_->name ());
+        }
+        data_ = ::elf_getdata (scn, 0);
+        if (!data_)
+        {
+          data_ = ::elf_rawdata (scn, 0);
+          if (!data_)
+            libelf_error ("elf_getdata: " + *name_ + '(' + file_->name () + ')');
+        }
+      }
       return data_;
     }
 
@@ -348,7 +444,7 @@ namespace rld
       check_writable ("set_name");
       shdr.sh_name = index;
       if (!gelf_update_shdr (scn, &shdr))
-        libelf_error ("gelf_update_shdr: " + name_ + " (" + file_->name () + ')');
+        libelf_error ("gelf_update_shdr: " + *name_ + " (" + file_->name () + ')');
     }
 
     void
@@ -369,10 +465,17 @@ namespace rld
       return relocs;
     }
 
+    void
+    section::detach ()
+    {
+      scn = 0;
+      data_ = 0;
+    }
+
     void
     section::check (const char* where) const
     {
-      if (!file_ || (index_ < 0) || !scn)
+      if (!file_ || (index_ < 0))
       {
         std::string w = where;
         throw rld::error ("Section not initialised.", "section:check:" + w);
@@ -430,7 +533,12 @@ namespace rld
         ident_str (0),
         ident_size (0),
         ehdr (0),
-        phdr (0)
+        phdr (0),
+        symbols_loaded (false),
+        relocs_loaded (false),
+        cache_offset (0),
+        cache_mtime (0),
+        cache_size (0)
     {
     }
 
@@ -571,10 +679,47 @@ namespace rld
       if (!archive && !writable)
       {
         load_header ();
+        check_cache (fd__, offset_);
         load_sections ();
       }
     }
 
+    void
+    file::check_cache (int fd__, off_t offset_)
+    {
+      struct stat sb;
+      bool        changed = false;
+
+      if (::fstat (fd__, &sb) == 0)
+      {
+        /*
+         * The first session records the file. The symbols of an object in an
+         * archive can be set from the archive's index before it.
+         */
+        changed = !cache_name.empty () &&
+          ((cache_name != name_) ||
+           (cache_offset != offset_) ||
+           (cache_mtime != sb.st_mtime) ||
+           (cache_size != sb.st_size));
+        cache_name = name_;
+        cache_offset = offset_;
+        cache_mtime = sb.st_mtime;
+        cache_size = sb.st_size;
+      }
+      else
+        cache_name.clear ();
+
+      if (changed)
+      {
+        if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG && !secs.empty ())
+          std::cout << "elf::cache: invalidated: " << name_ << std::endl;
+        secs.clear ();
+        symbols.clear ();
+        symbols_loaded = false;
+        relocs_loaded = false;
+      }
+    }
+
     void
     file::end ()
     {
@@ -597,6 +742,18 @@ namespace rld
           }
         }
 
+        /*
+         * The sections of a file being read are kept for the next session
+         * with their handles detached.
+         */
+        if (writable)
+          secs.clear ();
+        else
+        {
+          for (auto& si : secs)
+            si.second.detach ();
+        }
+
         fd_ = -1;
         name_.clear ();
         archive = false;
@@ -605,8 +762,6 @@ namespace rld
         ident_size = 0;
         writable = false;
 
-        secs.clear ();
-
         if (elf_)
         {
           if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
@@ -642,6 +797,7 @@ namespace rld
        */
       shstrtab += '\0';
       shstrtab += ".shstrtab";
+      shstrtab += '\0';
 
       /*
        * Create the string table section.
@@ -702,6 +858,13 @@ namespace rld
       return ehdr->e_machine;
     }
 
+    unsigned int
+    file::flags () const
+    {
+      check_ehdr ("flags");
+      return ehdr->e_flags;
+    }
+
     unsigned int
     file::type () const
     {
@@ -808,7 +971,7 @@ namespace rld
     void
     file::load_symbols ()
     {
-      if (symbols.empty ())
+      if (!symbols_loaded)
       {
         if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
           std::cout << "elf:symbol: " << name () << std::endl;
@@ -821,17 +984,42 @@ namespace rld
              si != symbol_secs.end ();
              ++si)
         {
-          section& sec = *(*si);
-          int      syms = sec.entries ();
-
-          for (int s = 0; s < syms; ++s)
+          section&    sec = *(*si);
+          elf_syms    esyms;
+          const char* strs = nullptr;
+          size_t      strs_size = 0;
+
+          decode_symbols (sec, esyms);
+
+          /*
+           * Take the names from the string table's data. A name outside of
+           * it is looked up with libelf to report the error.
+           */
+          section&  strings = get_section (sec.link ());
+          elf_data* strings_data = strings.data ();
+
+          if (strings.type () == SHT_STRTAB && strings_data != nullptr &&
+              strings_data->d_buf != nullptr)
           {
-            elf_sym esym;
+            strs = static_cast < const char* > (strings_data->d_buf);
+            strs_size = strings_data->d_size;
+          }
 
-            if (!::gelf_getsym (sec.data (), s, &esym))
-             error ("gelf_getsym");
+          for (size_t s = 0; s < esyms.size (); ++s)
+          {
+            const elf_sym& esym = esyms[s];
+            std::string    name;
+
+            if (esym.st_name < strs_size)
+            {
+              const char* str = strs + esym.st_name;
+              name.assign (str, ::strnlen (str, strs_size - esym.st_name));
+            }
+            else
+            {
+              name = get_string (sec.link (), esym.st_name);
+            }
 
-            std::string     name = get_string (sec.link (), esym.st_name);
             symbols::symbol sym (s, name, esym);
 
             if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
@@ -840,9 +1028,25 @@ namespace rld
             symbols.push_back (sym);
           }
         }
+
+        symbols_loaded = true;
       }
     }
 
+    void
+    file::set_symbols (const rld::symbols::bucket& syms)
+    {
+      symbols = syms;
+      symbols_loaded = true;
+    }
+
+    const rld::symbols::bucket&
+    file::get_symbol_bucket ()
+    {
+      load_symbols ();
+      return symbols;
+    }
+
     void
     file::get_symbols (symbols::pointers& filtered_syms,
                        bool               unresolved,
@@ -923,6 +1127,9 @@ namespace rld
     void
     file::load_relocations ()
     {
+      if (relocs_loaded)
+        return;
+
       if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
         std::cout << "elf:reloc: " << name () << std::endl;
 
@@ -931,14 +1138,31 @@ namespace rld
       get_sections (rel_secs, SHT_REL);
       get_sections (rel_secs, SHT_RELA);
 
+      /*
+       * Index the symbols so each record finds its symbol at once. The first
+       * symbol of an index is the one get_symbol returns.
+       */
+      std::vector < const symbols::symbol* > syms_by_index;
+
+      for (auto& sym : symbols)
+      {
+        if (sym.index () < 0)
+          continue;
+        size_t index = sym.index ();
+        if (index >= syms_by_index.size ())
+          syms_by_index.resize (index + 1, nullptr);
+        if (syms_by_index[index] == nullptr)
+          syms_by_index[index] = &sym;
+      }
+
       for (sections::iterator si = rel_secs.begin ();
            si != rel_secs.end ();
            ++si)
       {
-        section& sec = *(*si);
-        section& targetsec = get_section (sec.info ());
-        int      rels = sec.entries ();
-        bool     rela = sec.type () == SHT_RELA;
+        section&  sec = *(*si);
+        section&  targetsec = get_section (sec.info ());
+        bool      rela = sec.type () == SHT_RELA;
+        elf_relas erelas;
 
         targetsec.set_reloc_type (rela);
 
@@ -947,56 +1171,116 @@ namespace rld
                     << " -> " << targetsec.name ()
                     << std::endl;
 
-        for (int r = 0; r < rels; ++r)
+        decode_relocations (sec, erelas);
+
+        for (const auto& erela : erelas)
         {
-          if (rela)
+          if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
           {
-            elf_rela erela;
+            std::cout << "elf:reloc: " << (rela ? "rela" : "rel")
+                      << ": offset: " << erela.r_offset
+                      << " sym:" << GELF_R_SYM (erela.r_info)
+                      << " type:" << GELF_R_TYPE (erela.r_info);
+            if (rela)
+              std::cout << " addend:" << erela.r_addend;
+            std::cout << std::endl;
+          }
 
-            if (!::gelf_getrela (sec.data (), r, &erela))
-              error ("gelf_getrela");
+          /*
+           * The target section is updated with the fix up, and symbol
+           * section indicates the section offset being referenced by the
+           * fixup.
+           */
 
-            if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
-              std::cout << "elf:reloc: rela: offset: " << erela.r_offset
-                        << " sym:" << GELF_R_SYM (erela.r_info)
-                        << " type:" << GELF_R_TYPE (erela.r_info)
-                        << " addend:" << erela.r_addend
-                        << std::endl;
-
-            /*
-             * The target section is updated with the fix up, and symbol
-             * section indicates the section offset being referenced by the
-             * fixup.
-             */
-
-            const symbols::symbol& sym = get_symbol (GELF_R_SYM (erela.r_info));
-
-            relocation reloc (sym,
-                              erela.r_offset,
-                              erela.r_info,
-                              erela.r_addend);
-
-            targetsec.add (reloc);
-          }
-          else
-          {
-            elf_rel erel;
+          size_t                 index = GELF_R_SYM (erela.r_info);
+          const symbols::symbol* sym = nullptr;
 
-            if (!::gelf_getrel (sec.data (), r, &erel))
-              error ("gelf_getrel");
+          if (index < syms_by_index.size ())
+            sym = syms_by_index[index];
+          if (sym == nullptr)
+            sym = &get_symbol (index);
 
-            if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
-              std::cout << "elf:reloc: rel: offset: " << erel.r_offset
-                        << " sym:" << GELF_R_SYM (erel.r_info)
-                        << " type:" << GELF_R_TYPE (erel.r_info)
-                        << std::endl;
+          relocation reloc (*sym,
+                            erela.r_offset,
+                            erela.r_info,
+                            erela.r_addend);
 
-            const symbols::symbol& sym = get_symbol (GELF_R_SYM (erel.r_info));
+          targetsec.add (reloc);
+        }
+      }
 
-            relocation reloc (sym, erel.r_offset, erel.r_info);
+      relocs_loaded = true;
+    }
 
-            targetsec.add (reloc);
-          }
+    void
+    file::decode_symbols (section& sec, elf_syms& syms)
+    {
+      check ("decode_symbols");
+
+      elf_data*    data = sec.data ();
+      const size_t count = sec.entries ();
+
+      syms.clear ();
+
+      if (count == 0)
+        return;
+
+      if (oclass == ELFCLASS64)
+      {
+        check_entries (sec, data, ELF_T_SYM, count, sizeof (Elf64_Sym),
+                       "decode_symbols", *this);
+        widen_entries < Elf64_Sym > (data, count, syms);
+      }
+      else
+      {
+        check_entries (sec, data, ELF_T_SYM, count, sizeof (Elf32_Sym),
+                       "decode_symbols", *this);
+        widen_entries < Elf32_Sym > (data, count, syms);
+      }
+    }
+
+    void
+    file::decode_relocations (section& sec, elf_relas& relas)
+    {
+      check ("decode_relocations");
+
+      elf_data*    data = sec.data ();
+      const size_t count = sec.entries ();
+      const bool   rela = sec.type () == SHT_RELA;
+
+      relas.clear ();
+
+      if (count == 0)
+        return;
+
+      if (oclass == ELFCLASS64)
+      {
+        if (rela)
+        {
+          check_entries (sec, data, ELF_T_RELA, count, sizeof (Elf64_Rela),
+                         "decode_relocations", *this);
+          widen_entries < Elf64_Rela > (data, count, relas);
+        }
+        else
+        {
+          check_entries (sec, data, ELF_T_REL, count, sizeof (Elf64_Rel),
+                         "decode_relocations", *this);
+          widen_entries < Elf64_Rel > (data, count, relas);
+        }
+      }
+      else
+      {
+        if (rela)
+        {
+          check_entries (sec, data, ELF_T_RELA, count, sizeof (Elf32_Rela),
+                         "decode_relocations", *this);
+          widen_entries < Elf32_Rela > (data, count, relas);
+        }
+        else
+        {
+          check_entries (sec, data, ELF_T_REL, count, sizeof (Elf32_Rel),
+                         "decode_relocations", *this);
+          widen_entries < Elf32_Rel > (data, count, relas);
         }
       }
     }
@@ -1025,7 +1309,8 @@ namespace rld
     file::set_header (elf_half      type,
                       int           class_,
                       elf_half      machinetype,
-                      unsigned char datatype)
+                      unsigned char datatype,
+                      elf_word      flags)
     {
       check_writable ("set_header");
 
@@ -1049,7 +1334,7 @@ namespace rld
       {
         ((elf32_ehdr*)ehdr)->e_type = type;
         ((elf32_ehdr*)ehdr)->e_machine = machinetype;
-        ((elf32_ehdr*)ehdr)->e_flags = 0;
+        ((elf32_ehdr*)ehdr)->e_flags = flags;
         ((elf32_ehdr*)ehdr)->e_ident[EI_DATA] = datatype;
         ((elf32_ehdr*)ehdr)->e_version = EV_CURRENT;
       }
@@ -1057,7 +1342,7 @@ namespace rld
       {
         ehdr->e_type = type;
         ehdr->e_machine = machinetype;
-        ehdr->e_flags = 0;
+        ehdr->e_flags = flags;
         ehdr->e_ident[EI_DATA] = datatype;
         ehdr->e_version = EV_CURRENT;
       }
@@ -1210,58 +1495,126 @@ namespace rld
       }
 
       std::ostringstream what;
-      what << "unknown machine type: " << elf_object_machinetype;
+      what << "unknown machine type: " << machinetype;
       throw rld::error (what, "machine-type");
     }
 
+    object_type::object_type ()
+      : oclass (ELFCLASSNONE),
+        mtype (EM_NONE),
+        dtype (ELFDATANONE),
+        mflags (0)
+    {
+    }
+
+    void
+    object_type::check (const file& file)
+    {
+      std::lock_guard < std::mutex > guard (lock);
+
+      if (mtype == EM_NONE)
+      {
+        mtype = file.machinetype ();
+        mflags = file.flags ();
+      }
+      else if (file.machinetype () != mtype)
+      {
+        std::ostringstream oss;
+        oss << "elf:check_file:" << file.name ()
+            << ": " << mtype << '/' << file.machinetype ();
+        throw rld::error ("Mixed machine types not supported.", oss.str ());
+      }
+
+      if (oclass == ELFCLASSNONE)
+        oclass = file.object_class ();
+      else if (file.object_class () != oclass)
+        throw rld::error ("Mixed classes not allowed (32bit/64bit).",
+                          "elf:check_file: " + file.name ());
+
+      if (dtype == ELFDATANONE)
+        dtype = file.data_type ();
+      else if (dtype != file.data_type ())
+        throw rld::error ("Mixed data types not allowed (LSB/MSB).",
+                          "elf:check_file: " + file.name ());
+    }
+
+    unsigned int
+    object_type::object_class () const
+    {
+      return oclass;
+    }
+
+    unsigned int
+    object_type::machinetype () const
+    {
+      return mtype;
+    }
+
+    const std::string
+    object_type::machine_type () const
+    {
+      return rld::elf::machine_type (mtype);
+    }
+
+    unsigned int
+    object_type::datatype () const
+    {
+      return dtype;
+    }
+
+    unsigned int
+    object_type::flags () const
+    {
+      return mflags;
+    }
+
+    object_type&
+    default_object_type ()
+    {
+      static object_type types;
+      return types;
+    }
+
     const std::string
     machine_type ()
     {
-      return machine_type (elf_object_machinetype);
+      return default_object_type ().machine_type ();
     }
 
     unsigned int
     object_class ()
     {
-      return elf_object_class;
+      return default_object_type ().object_class ();
     }
 
     unsigned int
     object_machine_type ()
     {
-      return elf_object_machinetype;
+      return default_object_type ().machinetype ();
     }
 
     unsigned int
     object_datatype ()
     {
-      return elf_object_datatype;
+      return default_object_type ().datatype ();
     }
 
-    void
-    check_file(const file& file)
+    unsigned int
+    object_flags ()
     {
-      if (elf_object_machinetype == EM_NONE)
-        elf_object_machinetype = file.machinetype ();
-      else if (file.machinetype () != elf_object_machinetype)
-      {
-        std::ostringstream oss;
-        oss << "elf:check_file:" << file.name ()
-            << ": " << elf_object_machinetype << '/' << file.machinetype ();
-        throw rld::error ("Mixed machine types not supported.", oss.str ());
-      }
+      return default_object_type ().flags ();
+    }
 
-      if (elf_object_class == ELFCLASSNONE)
-        elf_object_class = file.object_class ();
-      else if (file.object_class () != elf_object_class)
-        throw rld::error ("Mixed classes not allowed (32bit/64bit).",
-                          "elf:check_file: " + file.name ());
+    void
+    check_file (const file& file)
+    {
+      default_object_type ().check (file);
+    }
 
-      if (elf_object_datatype == ELFDATANONE)
-        elf_object_datatype = file.data_type ();
-      else if (elf_object_datatype != file.data_type ())
-        throw rld::error ("Mixed data types not allowed (LSB/MSB).",
-                          "elf:check_file: " + file.name ());
+    void
+    check_file (const file& file, object_type& types)
+    {
+      types.check (file);
     }
 
   }
@@ -25,8 +25,10 @@
 #if !defined (_RLD_ELF_H_)
 #define _RLD_ELF_H_
 
+#include <atomic>
 #include <list>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include <rld.h>
@@ -101,6 +103,13 @@ namespace rld
      */
     typedef std::vector < relocation > relocations;
 
+    /**
+     * Flat arrays of the decoded entries of a symbol table or relocation
+     * section.
+     */
+    typedef std::vector < elf_sym > elf_syms;
+    typedef std::vector < elf_rela > elf_relas;
+
     /**
      * An ELF Section. The current implementation only supports a single data
      * descriptor with a section.
@@ -326,6 +335,13 @@ namespace rld
        */
       const relocations& get_relocations () const;
 
+      /**
+       * Detach the section from the ELF handle when the file's session
+       * ends. The header is kept and the handle and data are obtained again
+       * when the data is next used.
+       */
+      void detach ();
+
     private:
 
       /**
@@ -344,7 +360,7 @@ namespace rld
 
       file*       file_;  //< The ELF file.
       int         index_; //< The section header index.
-      std::string name_;  //< The section's name.
+      const std::string* name_;  //< The section's interned name.
       elf_scn*    scn;    //< ELF private section data.
       elf_shdr    shdr;   //< The section header.
       elf_data*   data_;  //< The section's data.
@@ -465,6 +481,11 @@ namespace rld
        */
       unsigned int machinetype () const;
 
+      /**
+       * Get the machine specific flags.
+       */
+      unsigned int flags () const;
+
       /**
        * Get the type of ELF file.
        */
@@ -553,6 +574,19 @@ namespace rld
        */
       void load_symbols ();
 
+      /**
+       * Set the symbols. The symbols are not loaded from the ELF file. This
+       * is used when the symbols have been loaded from a symbol index.
+       *
+       * @param syms The symbols of the ELF file.
+       */
+      void set_symbols (const rld::symbols::bucket& syms);
+
+      /**
+       * Get the symbols. The symbols are loaded if not loaded.
+       */
+      const rld::symbols::bucket& get_symbol_bucket ();
+
       /**
        * Get a filtered container of symbols given the various types. If the
        * symbols are not loaded they are loaded.
@@ -575,6 +609,25 @@ namespace rld
        */
       const symbols::symbol& get_symbol (const int index) const;
 
+      /**
+       * Decode all the entries of a symbol table section in one pass. The
+       * section data is in the byte order of the host so the entries are
+       * widened to the generic form without a libelf call for each entry.
+       *
+       * @param sec The symbol table section.
+       * @param syms The symbols of the section in index order.
+       */
+      void decode_symbols (section& sec, elf_syms& syms);
+
+      /**
+       * Decode all the entries of a relocation section in one pass. The
+       * records of a REL section have an addend of 0.
+       *
+       * @param sec The REL or RELA section.
+       * @param relas The relocation records of the section in order.
+       */
+      void decode_relocations (section& sec, elf_relas& relas);
+
       /**
        * Load the relocation records.
        */
@@ -613,11 +666,13 @@ namespace rld
        * @param class_ The files ELF class.
        * @param machinetype The type of machine code present in the ELF file.
        * @param datatype The data type, ie LSB or MSB.
+       * @param flags The machine specific flags, ie the ABI.
        */
       void set_header (elf_half      type,
                        int           class_,
                        elf_half      machinetype,
-                       unsigned char datatype);
+                       unsigned char datatype,
+                       elf_word      flags = 0);
 
       /**
        * Add a section to the ELF file if writable.
@@ -682,6 +737,16 @@ namespace rld
                   file*              archive,
                   off_t              offset);
 
+      /**
+       * The section headers, symbols and relocations are held across the
+       * sessions of a file. Check the file has not changed since they were
+       * loaded and drop them if it has.
+       *
+       * @param fd The file descriptor of the file or the archive.
+       * @param offset The offset of the ELF file in the archive.
+       */
+      void check_cache (int fd, off_t offset);
+
       /**
        * Check if the file is usable. Throw an exception if not.
        *
@@ -733,6 +798,12 @@ namespace rld
       program_headers      phdrs;      //< The program headers when creating
                                        //  ELF files.
       rld::symbols::bucket symbols;    //< The symbols. All tables point here.
+      bool                 symbols_loaded; //< The symbols are loaded.
+      bool                 relocs_loaded;  //< The relocations are loaded.
+      std::string          cache_name;     //< The name of the cached file.
+      off_t                cache_offset;   //< The offset in an archive.
+      time_t               cache_mtime;    //< The modification time.
+      off_t                cache_size;     //< The size of the file.
     };
 
     /**
@@ -742,6 +813,71 @@ namespace rld
      */
     const std::string machine_type (unsigned int machinetype);
 
+    /**
+     * The type of object files a context accepts. The first file checked
+     * sets the class, machine type, data type and flags and all other files
+     * checked must match. Contexts are independent so images of different
+     * types can be processed at the same time, for example on different
+     * threads.
+     */
+    class object_type
+    {
+    public:
+      object_type ();
+
+      /**
+       * Check the file against the context. If this is the first file
+       * checked it sets the type all other files are checked against. This
+       * can be called from more than one thread.
+       *
+       * @param file The file to check.
+       */
+      void check (const file& file);
+
+      /**
+       * The class set by the first check.
+       */
+      unsigned int object_class () const;
+
+      /**
+       * The machine type set by the first check.
+       */
+      unsigned int machinetype () const;
+
+      /**
+       * The machine type set by the first check as a string.
+       */
+      const std::string machine_type () const;
+
+      /**
+       * The data type set by the first check.
+       */
+      unsigned int datatype () const;
+
+      /**
+       * The machine specific flags set by the first check.
+       */
+      unsigned int flags () const;
+
+    private:
+      std::mutex                  lock;     //< Serialise the first check.
+      std::atomic < unsigned int > oclass;  //< The object class.
+      std::atomic < unsigned int > mtype;   //< The machine type.
+      std::atomic < unsigned int > dtype;   //< The data type.
+      std::atomic < unsigned int > mflags;  //< The machine flags.
+
+      /*
+       * Cannot copy a context.
+       */
+      object_type (const object_type& orig) = delete;
+      object_type& operator= (const object_type& rhs) = delete;
+    };
+
+    /**
+     * The process wide default context the global calls use.
+     */
+    object_type& default_object_type ();
+
     /**
      * Return the global machine type set by the check_file call as a string.
      */
@@ -762,6 +898,11 @@ namespace rld
      */
     unsigned int object_datatype ();
 
+    /**
+     * Return the global machine specific flags set by the check_file call.
+     */
+    unsigned int object_flags ();
+
     /**
      * Check the file against the global machine type, object class and data
      * type. If this is the first file checked it becomes the default all
@@ -770,7 +911,15 @@ namespace rld
      *
      * @param file The check to check.
      */
-    void check_file(const file& file);
+    void check_file (const file& file);
+
+    /**
+     * Check the file against a context.
+     *
+     * @param file The file to check.
+     * @param types The context to check against.
+     */
+    void check_file (const file& file, object_type& types);
 
   }
 }
@@ -19,6 +19,10 @@
 #endif
 
 #include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
 
 #include <errno.h>
 #include <fcntl.h>
@@ -27,14 +31,25 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#if !__WIN32__
+#include <sys/mman.h>
+#if HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+#include <sys/resource.h>
+#endif
+
 #include <rld.h>
+#include <rld-tasks.h>
 
 #if __WIN32__
 #define CREATE_MODE (S_IRUSR | S_IWUSR)
 #define OPEN_FLAGS  (O_BINARY)
+#define MAP_IMAGES  (0)
 #else
 #define CREATE_MODE (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH)
 #define OPEN_FLAGS  (0)
+#define MAP_IMAGES  (1)
 #endif
 
 namespace rld
@@ -73,6 +88,81 @@ namespace rld
       memcpy (string, oss.str ().c_str (), l);
     }
 
+    /*
+     * The symbol index entry header. Change the version if the format
+     * changes. The entries are written in the host's byte order.
+     */
+    static const char     index_magic[8] = { 'R', 'L', 'D', 'S', 'Y', 'M', 'I', 0 };
+    static const uint32_t index_version = 1;
+
+    template < typename T >
+    static void
+    index_write (std::ostream& out, const T value)
+    {
+      out.write (reinterpret_cast < const char* > (&value), sizeof (value));
+    }
+
+    static void
+    index_write (std::ostream& out, const std::string& s)
+    {
+      index_write (out, static_cast < uint32_t > (s.size ()));
+      out.write (s.data (), s.size ());
+    }
+
+    template < typename T >
+    static bool
+    index_read (std::istream& in, T& value)
+    {
+      in.read (reinterpret_cast < char* > (&value), sizeof (value));
+      return in.good ();
+    }
+
+    static bool
+    index_read (std::istream& in, std::string& s)
+    {
+      uint32_t size;
+      if (!index_read (in, size))
+        return false;
+      s.resize (size);
+      if (size != 0)
+        in.read (&s[0], size);
+      return in.good ();
+    }
+
+    /**
+     * Get the size and modification time of the file. Returns false if the
+     * file cannot be checked.
+     */
+    static bool
+    index_stat (const std::string& path, uint64_t& size, int64_t& mtime)
+    {
+      struct stat sb;
+      if (::stat (path.c_str (), &sb) != 0)
+        return false;
+      size = sb.st_size;
+      mtime = sb.st_mtime;
+      return true;
+    }
+
+    /**
+     * The path of an archive's symbol index entry in the index directory.
+     */
+    static std::string
+    index_entry (const std::string& directory, const std::string& archive)
+    {
+      uint64_t hash = 14695981039346656037ULL;
+      for (size_t c = 0; c < archive.size (); ++c)
+      {
+        hash ^= static_cast < uint8_t > (archive[c]);
+        hash *= 1099511628211ULL;
+      }
+      std::ostringstream oss;
+      oss << std::hex << std::setfill ('0') << std::setw (16) << hash << ".rsi";
+      std::string entry;
+      path::path_join (directory, oss.str (), entry);
+      return entry;
+    }
+
     file::file (const std::string& aname,
                 const std::string& oname,
                 off_t              offset,
@@ -224,10 +314,154 @@ namespace rld
        return size_;
     }
 
+    view::view ()
+      : fd_ (-1),
+        owner (false),
+        data_ (0),
+        size_ (0)
+    {
+    }
+
+    view::view (const std::string& path, access advice)
+      : fd_ (-1),
+        owner (false),
+        data_ (0),
+        size_ (0)
+    {
+      open (path, advice);
+    }
+
+    view::~view ()
+    {
+      close ();
+    }
+
+    void
+    view::open (const std::string& path, access advice)
+    {
+      int fd = ::open (path.c_str (), O_RDONLY | OPEN_FLAGS);
+      if (fd < 0)
+        throw rld::error (::strerror (errno), "view:open:" + path);
+      try
+      {
+        open (fd, path, advice);
+      }
+      catch (...)
+      {
+        ::close (fd);
+        throw;
+      }
+      owner = true;
+    }
+
+    void
+    view::open (int fd, const std::string& path, access advice)
+    {
+      close ();
+
+      struct stat sb;
+      if (::fstat (fd, &sb) < 0)
+        throw rld::error (::strerror (errno), "view:stat:" + path);
+
+      path_ = path;
+      fd_ = fd;
+      owner = false;
+      size_ = S_ISREG (sb.st_mode) ? sb.st_size : 0;
+
+#if MAP_IMAGES
+      if (size_ > 0)
+      {
+        void* m = ::mmap (0, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (m != MAP_FAILED)
+        {
+#if HAVE_MADVISE
+          ::madvise (m, size_,
+                     advice == sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+          data_ = static_cast < const uint8_t* > (m);
+        }
+      }
+#endif
+    }
+
+    void
+    view::close ()
+    {
+#if MAP_IMAGES
+      if (data_)
+        ::munmap (const_cast < uint8_t* > (data_), size_);
+#endif
+      if (owner && (fd_ >= 0))
+        ::close (fd_);
+      path_.clear ();
+      fd_ = -1;
+      owner = false;
+      data_ = 0;
+      size_ = 0;
+    }
+
+    size_t
+    view::read (off_t offset, void* buffer_, size_t size) const
+    {
+      if ((offset < 0) || ((size_t) offset >= size_))
+        return 0;
+
+      size = std::min (size, size_ - offset);
+
+      if (data_)
+      {
+        ::memcpy (buffer_, data_ + offset, size);
+        return size;
+      }
+
+      uint8_t* buffer = static_cast < uint8_t* > (buffer_);
+      size_t   have_read = 0;
+      while (have_read < size)
+      {
+        const ssize_t rsize = ::pread (fd_, buffer + have_read,
+                                       size - have_read, offset + have_read);
+        if (rsize < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          throw rld::error (::strerror (errno), "view:read:" + path_);
+        }
+        if (rsize == 0)
+          break;
+        have_read += rsize;
+      }
+      return have_read;
+    }
+
+    const uint8_t*
+    view::data () const
+    {
+      return data_;
+    }
+
+    size_t
+    view::size () const
+    {
+      return size_;
+    }
+
+    bool
+    view::mapped () const
+    {
+      return data_ != 0;
+    }
+
+    bool
+    view::is_open () const
+    {
+      return fd_ >= 0;
+    }
+
     image::image (file& name)
       : name_ (name),
         references_ (0),
         fd_ (-1),
+        position_ (0),
         symbol_refs (0),
         writable (false),
         remove (false)
@@ -238,6 +472,7 @@ namespace rld
       : name_ (path, is_object),
         references_ (0),
         fd_ (-1),
+        position_ (0),
         symbol_refs (0),
         writable (false),
         remove (false)
@@ -247,6 +482,7 @@ namespace rld
     image::image ()
       : references_ (0),
         fd_ (-1),
+        position_ (0),
         symbol_refs (0),
         writable (false),
         remove (false)
@@ -260,6 +496,7 @@ namespace rld
 
       if (fd_ >= 0)
       {
+        unmap ();
         ::close (fd_);
         fd_= -1;
         if (writable && remove)
@@ -319,6 +556,8 @@ namespace rld
           fd_ = ::open (path.c_str (), OPEN_FLAGS | O_RDONLY);
         if (fd_ < 0)
           throw rld::error (::strerror (errno), "open:" + path);
+        if (!writable)
+          map ();
       }
       else
       {
@@ -329,6 +568,25 @@ namespace rld
       ++references_;
     }
 
+    void
+    image::open_update ()
+    {
+      const std::string path = name_.path ();
+
+      if (rld::verbose () >= RLD_VERBOSE_TRACE_FILE)
+        std::cout << "image::open-update:  " << name (). full () << std::endl;
+
+      if (fd_ >= 0)
+        throw rld::error ("Already open", "open-update:" + path);
+
+      fd_ = ::open (path.c_str (), OPEN_FLAGS | O_RDWR);
+      if (fd_ < 0)
+        throw rld::error (::strerror (errno), "open-update:" + path);
+
+      writable = true;
+      ++references_;
+    }
+
     void
     image::close ()
     {
@@ -341,6 +599,7 @@ namespace rld
         --references_;
         if (references_ == 0)
         {
+          unmap ();
           ::close (fd_);
           fd_ = -1;
           if (writable && remove)
@@ -358,6 +617,18 @@ namespace rld
     ssize_t
     image::read (void* buffer_, size_t size)
     {
+      const uint8_t* map = mapped ();
+      if (map)
+      {
+        size_t map_size = mapped_size ();
+        size_t have_read = 0;
+        if (position_ < map_size)
+          have_read = std::min (size, map_size - position_);
+        ::memcpy (buffer_, map + position_, have_read);
+        position_ += have_read;
+        return have_read;
+      }
+
       uint8_t* buffer = static_cast <uint8_t*> (buffer_);
       size_t   have_read = 0;
       size_t   to_read = size;
@@ -396,10 +667,24 @@ namespace rld
     void
     image::seek (off_t offset)
     {
-      if (::lseek (fd (), name_.offset () + offset, SEEK_SET) < 0)
+      if (mapped ())
+        position_ = name_.offset () + offset;
+      else if (::lseek (fd (), name_.offset () + offset, SEEK_SET) < 0)
         throw rld::error (strerror (errno), "lseek:" + name ().path ());
     }
 
+    const uint8_t*
+    image::read_mapped (size_t size)
+    {
+      const uint8_t* map = mapped ();
+      if (!map || position_ > mapped_size () ||
+          size > mapped_size () - position_)
+        return 0;
+      const uint8_t* block = map + position_;
+      position_ += size;
+      return block;
+    }
+
     bool
     image::seek_read (off_t offset, uint8_t* buffer, size_t size)
     {
@@ -438,12 +723,43 @@ namespace rld
       return fd_;
     }
 
+    const uint8_t*
+    image::mapped () const
+    {
+      return view_.data ();
+    }
+
+    size_t
+    image::mapped_size () const
+    {
+      return view_.mapped () ? view_.size () : 0;
+    }
+
     rld::elf::file&
     image::elf ()
     {
       return elf_;
     }
 
+    void
+    image::map ()
+    {
+      /*
+       * Only regular files with data can be mapped. Anything else is read
+       * using the file descriptor.
+       */
+      view_.open (fd_, name_.path (), view::random);
+      if (!view_.mapped ())
+        view_.close ();
+      position_ = 0;
+    }
+
+    void
+    image::unmap ()
+    {
+      view_.close ();
+    }
+
     byteorder
     image::get_byteorder () const
     {
@@ -469,29 +785,111 @@ namespace rld
       return symbol_refs;
     }
 
+    static void
+    copy_write (image& out, const uint8_t* data, size_t size)
+    {
+      while (size)
+      {
+        ssize_t w = ::write (out.fd (), data, size);
+
+        if (w < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          throw rld::error (::strerror (errno), "writing: " + out.name ().full ());
+        }
+
+        if (w == 0)
+          throw rld::error ("output trucated", "writing: " + out.name ().full ());
+
+        data += w;
+        size -= w;
+      }
+    }
+
+    /**
+     * Can the kernel's failure to copy between the files be handled by copying
+     * another way?
+     */
+    static bool
+    copy_fallback (int err)
+    {
+      return err == ENOSYS || err == EXDEV || err == EINVAL ||
+        err == EOPNOTSUPP;
+    }
+
     void
     copy_file (image& in, image& out, size_t size)
     {
-      #define COPY_FILE_BUFFER_SIZE (8 * 1024)
+      #define COPY_FILE_BUFFER_SIZE (128 * 1024)
       uint8_t* buffer = 0;
 
       if (size == 0)
         size = in.name ().size ();
 
+      /*
+       * A mapped input is written straight from the mapped memory.
+       */
+      const uint8_t* data = in.read_mapped (size);
+      if (data)
+      {
+        copy_write (out, data, size);
+        return;
+      }
+
+#if HAVE_COPY_FILE_RANGE
+      /*
+       * Let the kernel copy the data between the files. A file system that
+       * shares extents clones the data rather than copying it. If the files
+       * cannot be copied this way fall back to sending the data or copying
+       * through a buffer. A mapped input's read position is not the file's
+       * offset.
+       */
+      while (size && !in.mapped ())
+      {
+        ssize_t c = ::copy_file_range (in.fd (), 0, out.fd (), 0, size, 0);
+        if (c <= 0)
+        {
+          if (c < 0 && errno == EINTR)
+            continue;
+          if (c < 0 && !copy_fallback (errno))
+            throw rld::error (::strerror (errno),
+                              "copying: " + in.name ().full ());
+          break;
+        }
+        size -= c;
+      }
+#endif
+
+#if HAVE_SENDFILE
+      /*
+       * Send the data between the files in the kernel. The files can be on
+       * different file systems.
+       */
+      while (size && !in.mapped ())
+      {
+        ssize_t c = ::sendfile (out.fd (), in.fd (), 0, size);
+        if (c <= 0)
+        {
+          if (c < 0 && errno == EINTR)
+            continue;
+          if (c < 0 && !copy_fallback (errno))
+            throw rld::error (::strerror (errno),
+                              "copying: " + in.name ().full ());
+          break;
+        }
+        size -= c;
+      }
+#endif
+
       try
       {
-        buffer = new uint8_t[COPY_FILE_BUFFER_SIZE];
+        if (size)
+          buffer = new uint8_t[COPY_FILE_BUFFER_SIZE];
         while (size)
         {
-          /*
-           * @fixme the reading and writing are not POSIX; sigints could split them.
-           */
-
           size_t l = size < COPY_FILE_BUFFER_SIZE ? size : COPY_FILE_BUFFER_SIZE;
-          ssize_t r = ::read (in.fd (), buffer, l);
-
-          if (r < 0)
-            throw rld::error (::strerror (errno), "reading: " + in.name ().full ());
+          ssize_t r = in.read (buffer, l);
 
           if (r == 0)
           {
@@ -500,13 +898,7 @@ namespace rld
             throw rld::error ("input too short", oss.str ());
           }
 
-          ssize_t w = ::write (out.fd (), buffer, r);
-
-          if (w < 0)
-            throw rld::error (::strerror (errno), "writing: " + out.name ().full ());
-
-          if (w != r)
-            throw rld::error ("output trucated", "writing: " + out.name ().full ());
+          copy_write (out, buffer, r);
 
           size -= r;
         }
@@ -526,6 +918,7 @@ namespace rld
      */
     #define rld_archive_ident         "!<arch>\n"
     #define rld_archive_ident_size    (sizeof (rld_archive_ident) - 1)
+    #define rld_archive_thin_ident    "!<thin>\n"
     #define rld_archive_fhdr_base     rld_archive_ident_size
     #define rld_archive_fname         (0)
     #define rld_archive_fname_size    (16)
@@ -544,8 +937,94 @@ namespace rld
     #define rld_archive_fhdr_size     (60)
     #define rld_archive_max_file_size (1024)
 
+    /**
+     * The archives held open between the uses of their members with the most
+     * recently used first. The number held is limited so a link with many
+     * libraries does not run out of file handles. An archive that is not in
+     * use is closed to stay in the limit and is opened again when one of its
+     * members is next used. The lock serializes the archives' references.
+     */
+    static std::mutex             held_lock;
+    static std::list < archive* > held;
+    static size_t                 held_limit = 0;
+
+    void
+    set_open_archives (size_t limit)
+    {
+      std::lock_guard < std::mutex > guard (held_lock);
+      held_limit = limit;
+    }
+
+    static size_t
+    open_archives ()
+    {
+      if (held_limit == 0)
+      {
+        held_limit = 256;
+#if !__WIN32__
+        struct rlimit rl;
+        if ((::getrlimit (RLIMIT_NOFILE, &rl) == 0) &&
+            (rl.rlim_cur != RLIM_INFINITY) && (rl.rlim_cur > 2))
+          held_limit = rl.rlim_cur / 2;
+#endif
+      }
+      return held_limit;
+    }
+
+    /**
+     * Hold the archive open for a member. The lock must be held.
+     */
+    static void
+    hold (archive* ar)
+    {
+      std::list < archive* >::iterator hi =
+        std::find (held.begin (), held.end (), ar);
+      if (hi != held.end ())
+      {
+        held.splice (held.begin (), held, hi);
+        return;
+      }
+
+      /*
+       * An archive the cache has begun is open until the cache ends it.
+       */
+      if (ar->is_open ())
+        return;
+
+      size_t                           limit = open_archives ();
+      std::list < archive* >::iterator ei = held.end ();
+      while ((held.size () >= limit) && (ei != held.begin ()))
+      {
+        --ei;
+        archive* idle = *ei;
+        if (idle->references () == 1)
+        {
+          if (rld::verbose () >= RLD_VERBOSE_TRACE)
+            std::cout << "archive:release: " << idle->name ().path ()
+                      << std::endl;
+          idle->end ();
+          idle->close ();
+          ei = held.erase (ei);
+        }
+      }
+
+      ar->open ();
+      ar->begin ();
+      held.push_front (ar);
+    }
+
+    /**
+     * The archive is no longer held open. The lock must be held.
+     */
+    static void
+    unhold (archive* ar)
+    {
+      held.remove (ar);
+    }
+
     archive::archive (const std::string& path)
-      : image (path, false)
+      : image (path, false),
+        thin_ (false)
     {
       if (!name ().is_valid ())
         throw rld_error_at ("name is empty");
@@ -557,6 +1036,8 @@ namespace rld
     {
       try
       {
+        std::lock_guard < std::mutex > guard (held_lock);
+        unhold (this);
         end ();
         close ();
       }
@@ -576,7 +1057,10 @@ namespace rld
     void
     archive::begin ()
     {
-      if (references () == 1)
+      /*
+       * A thin archive has no members for the ELF library to read.
+       */
+      if (references () == 1 && !thin_)
       {
         elf ().begin (name ().full (), fd ());
 
@@ -592,7 +1076,7 @@ namespace rld
     void
     archive::end ()
     {
-      if (references () == 1)
+      if (references () == 1 && !thin_)
         elf ().end ();
     }
 
@@ -610,10 +1094,22 @@ namespace rld
       seek_read (0, &header[0], rld_archive_ident_size);
       bool result = ::memcmp (header, rld_archive_ident,
                               rld_archive_ident_size) == 0 ? true : false;
+      if (!result)
+      {
+        thin_ = ::memcmp (header, rld_archive_thin_ident,
+                          rld_archive_ident_size) == 0;
+        result = thin_;
+      }
       close ();
       return result;
     }
 
+    bool
+    archive::is_thin () const
+    {
+      return thin_;
+    }
+
     void
     archive::load_objects (objects& objs)
     {
@@ -634,6 +1130,7 @@ namespace rld
         size =
           (scan_decimal (&header[rld_archive_size],
                          rld_archive_size_size) + 1) & ~1;
+        size_t data = thin_ && !special_member (header) ? 0 : size;
 
         /*
          * Check for the GNU extensions.
@@ -679,6 +1176,8 @@ namespace rld
                   size_t esize =
                     (scan_decimal (&header[rld_archive_size],
                                    rld_archive_size_size) + 1) & ~1;
+                  if (thin_ && !special_member (header))
+                    esize = 0;
                   off += esize + rld_archive_fhdr_size;
 
                   if (!read_header (off, &header[0]))
@@ -724,8 +1223,280 @@ namespace rld
                       offset + rld_archive_fhdr_size, size);
         }
 
-        offset += size + rld_archive_fhdr_size;
+        offset += data + rld_archive_fhdr_size;
+      }
+    }
+
+    bool
+    archive::load_index (objects& objs, const std::string& index)
+    {
+      uint64_t ar_size;
+      int64_t  ar_mtime;
+
+      if (thin_ || !index_stat (name ().path (), ar_size, ar_mtime))
+        return false;
+
+      std::string   entry = index_entry (index, name ().path ());
+      std::ifstream in (entry.c_str (), std::ios::in | std::ios::binary);
+      if (!in.is_open ())
+        return false;
+
+      char        magic[sizeof (index_magic)];
+      uint32_t    version;
+      std::string path;
+      uint64_t    size;
+      int64_t     mtime;
+      uint32_t    members;
+
+      in.read (magic, sizeof (magic));
+      if (!in.good () ||
+          ::memcmp (magic, index_magic, sizeof (magic)) != 0 ||
+          !index_read (in, version) || version != index_version ||
+          !index_read (in, path) || path != name ().path () ||
+          !index_read (in, size) || size != ar_size ||
+          !index_read (in, mtime) || mtime != ar_mtime ||
+          !index_read (in, members))
+        return false;
+
+      /*
+       * Read all the members before adding any so a truncated entry does not
+       * leave a partial set of objects.
+       */
+      struct member
+      {
+        std::string     oname;
+        uint64_t        offset;
+        uint64_t        size;
+        symbols::bucket syms;
+      };
+
+      std::list < member > loaded;
+
+      for (uint32_t m = 0; m < members; ++m)
+      {
+        loaded.push_back (member ());
+        member&  mem = loaded.back ();
+        uint32_t count;
+
+        if (!index_read (in, mem.oname) ||
+            !index_read (in, mem.offset) ||
+            !index_read (in, mem.size) ||
+            !index_read (in, count))
+          return false;
+
+        for (uint32_t s = 0; s < count; ++s)
+        {
+          int32_t      sindex;
+          std::string  sname;
+          elf::elf_sym esym;
+
+          if (!index_read (in, sindex) ||
+              !index_read (in, sname) ||
+              !index_read (in, esym.st_name) ||
+              !index_read (in, esym.st_info) ||
+              !index_read (in, esym.st_other) ||
+              !index_read (in, esym.st_shndx) ||
+              !index_read (in, esym.st_value) ||
+              !index_read (in, esym.st_size))
+            return false;
+
+          mem.syms.push_back (symbols::symbol (sindex, sname, esym));
+        }
+      }
+
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "archive:load-index: " << name ().path ()
+                  << ": " << entry << std::endl;
+
+      for (std::list < member >::iterator mi = loaded.begin ();
+           mi != loaded.end ();
+           ++mi)
+      {
+        member& mem = *mi;
+        file    n (name ().path (), mem.oname, mem.offset, mem.size);
+        object* obj = new object (*this, n);
+        objs[n.full ()] = obj;
+        obj->set_symbols (mem.syms);
+      }
+
+      return true;
+    }
+
+    void
+    archive::save_index (objects& objs, const std::string& index)
+    {
+      uint64_t ar_size;
+      int64_t  ar_mtime;
+
+      if (thin_ || !index_stat (name ().path (), ar_size, ar_mtime))
+        return;
+
+      std::list < object* > members;
+
+      for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+      {
+        object* obj = (*oi).second;
+        if (obj->get_archive () == this)
+          members.push_back (obj);
+      }
+
+      std::string entry = index_entry (index, name ().path ());
+
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "archive:save-index: " << name ().path ()
+                  << ": " << entry << std::endl;
+
+      /*
+       * Write to a file of our own and rename it so a reader never sees a
+       * partial entry.
+       */
+      std::string temp = entry + '.' + rld::to_string (::getpid ());
+
+      {
+        std::ofstream out (temp.c_str (),
+                           std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (out.is_open ())
+        {
+          out.write (index_magic, sizeof (index_magic));
+          index_write (out, index_version);
+          index_write (out, name ().path ());
+          index_write (out, ar_size);
+          index_write (out, ar_mtime);
+          index_write (out, static_cast < uint32_t > (members.size ()));
+
+          for (std::list < object* >::iterator mi = members.begin ();
+               mi != members.end ();
+               ++mi)
+          {
+            object&                obj = *(*mi);
+            const symbols::bucket& syms = obj.elf ().get_symbol_bucket ();
+
+            index_write (out, obj.name ().oname ());
+            index_write (out, static_cast < uint64_t > (obj.name ().offset ()));
+            index_write (out, static_cast < uint64_t > (obj.name ().size ()));
+            index_write (out, static_cast < uint32_t > (syms.size ()));
+
+            for (symbols::bucket::const_iterator si = syms.begin ();
+                 si != syms.end ();
+                 ++si)
+            {
+              const symbols::symbol& sym = *si;
+              const elf::elf_sym&    esym = sym.esym ();
+
+              index_write (out, static_cast < int32_t > (sym.index ()));
+              index_write (out, sym.name ());
+              index_write (out, esym.st_name);
+              index_write (out, esym.st_info);
+              index_write (out, esym.st_other);
+              index_write (out, esym.st_shndx);
+              index_write (out, esym.st_value);
+              index_write (out, esym.st_size);
+            }
+          }
+
+          out.close ();
+        }
+
+        if (!out)
+        {
+          std::cerr << "warning: cannot write symbol index: " << entry
+                    << std::endl;
+          ::unlink (temp.c_str ());
+          return;
+        }
+      }
+
+      if (::rename (temp.c_str (), entry.c_str ()) != 0)
+        ::unlink (temp.c_str ());
+    }
+
+    static uint64_t
+    armap_value (const uint8_t* data, size_t width)
+    {
+      uint64_t value = 0;
+      for (size_t b = 0; b < width; ++b)
+        value = (value << 8) | data[b];
+      return value;
+    }
+
+    bool
+    archive::load_armap (objects& objs, armap& syms)
+    {
+      uint8_t header[rld_archive_fhdr_size];
+
+      if (!read_header (rld_archive_fhdr_base, &header[0]))
+        return false;
+
+      /*
+       * The GNU symbol table is the first member. The number of symbols and
+       * the offsets of the members' headers are big endian and are followed
+       * by the symbols' names.
+       */
+      size_t width;
+      if (::memcmp (&header[rld_archive_fname], "/               ",
+                    rld_archive_fname_size) == 0)
+        width = 4;
+      else if (::memcmp (&header[rld_archive_fname], "/SYM64/         ",
+                         rld_archive_fname_size) == 0)
+        width = 8;
+      else
+        return false;
+
+      size_t size = scan_decimal (&header[rld_archive_size],
+                                  rld_archive_size_size);
+      if (size < width)
+        return false;
+
+      std::vector < uint8_t > table (size);
+      if (!seek_read (rld_archive_fhdr_base + rld_archive_fhdr_size,
+                      &table[0], size))
+        return false;
+
+      uint64_t count = armap_value (&table[0], width);
+      if (count == 0 || count >= (size / width))
+        return false;
+
+      std::map < uint64_t, object* > members (members_);
+      if (!thin_)
+      {
+        for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+        {
+          object* obj = (*oi).second;
+          if (obj->get_archive () == this)
+            members[obj->name ().offset ()] = obj;
+        }
+      }
+
+      const char* names = (const char*) &table[(count + 1) * width];
+      const char* end = (const char*) &table[0] + size;
+      armap       loaded;
+
+      for (uint64_t s = 0; s < count; ++s)
+      {
+        uint64_t offset =
+          armap_value (&table[(s + 1) * width], width) + rld_archive_fhdr_size;
+
+        std::map < uint64_t, object* >::iterator mi = members.find (offset);
+        if (mi == members.end ())
+          return false;
+
+        const char* name_end = std::find (names, end, '\0');
+        if (name_end == end)
+          return false;
+
+        loaded.insert (std::make_pair (std::string (names, name_end),
+                                       (*mi).second));
+        names = name_end + 1;
       }
+
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "archive:load-armap: " << name ().path ()
+                  << ": symbols: " << count << std::endl;
+
+      syms.insert (loaded.begin (), loaded.end ());
+
+      return true;
     }
 
     bool
@@ -748,12 +1519,34 @@ namespace rld
       return true;
     }
 
+    bool
+    archive::special_member (const uint8_t* header)
+    {
+      return
+        (header[0] == '/') &&
+        ((header[1] == ' ') || (header[1] == '/') ||
+         (::memcmp (&header[rld_archive_fname], "/SYM64/", 7) == 0));
+    }
+
     void
     archive::add_object (objects& objs, const char* path, off_t offset, size_t size)
     {
+      /*
+       * The name of a thin archive's member is a path and ends with a '/'
+       * before the new line or the padding.
+       */
       const char* end = path;
-      while ((*end != '\0') && (*end != '/') && (*end != '\n'))
-        ++end;
+      if (thin_)
+      {
+        while ((*end != '\0') && (*end != '\n') &&
+               !((*end == '/') && ((end[1] == '\n') || (end[1] == ' '))))
+          ++end;
+      }
+      else
+      {
+        while ((*end != '\0') && (*end != '/') && (*end != '\n'))
+          ++end;
+      }
 
       std::string str;
       str.append (path, end - path);
@@ -761,8 +1554,26 @@ namespace rld
       if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
         std::cout << "archive::add-object: " << str << std::endl;
 
-      file n (name ().path (), str, offset, size);
-      objs[n.full()] = new object (*this, n);
+      if (thin_)
+      {
+        /*
+         * The member's path is relative to the archive's directory. The
+         * member is found by the offset of its header.
+         */
+        const std::string& ar = name ().path ();
+        size_t             sep = ar.find_last_of (RLD_PATH_SEPARATOR);
+        if ((sep != std::string::npos) && (str[0] != RLD_PATH_SEPARATOR))
+          str = ar.substr (0, sep + 1) + str;
+        file    n (str);
+        object* obj = new object (*this, n);
+        objs[n.full ()] = obj;
+        members_[offset] = obj;
+      }
+      else
+      {
+        file n (name ().path (), str, offset, size);
+        objs[n.full()] = new object (*this, n);
+      }
     }
 
     void
@@ -791,89 +1602,297 @@ namespace rld
         header[rld_archive_magic] = 0x60;
         header[rld_archive_magic + 1] = 0x0a;
 
-        write (header, sizeof (header));
-    }
+        write (header, sizeof (header));
+    }
+
+    void
+    archive::create (object_list& objects)
+    {
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "archive::create: " << name ().full ()
+                  << ", objects: " << objects.size () << std::endl;
+
+      open (true);
+
+      try
+      {
+        seek_write (0, rld_archive_ident, rld_archive_ident_size);
+
+        /*
+         * GNU extended filenames.
+         */
+        std::string extended_file_names;
+
+        for (object_list::iterator oi = objects.begin ();
+             oi != objects.end ();
+             ++oi)
+        {
+          object& obj = *(*oi);
+          const std::string&  oname = path::basename (obj.name ().oname ());
+          if (oname.length () >= rld_archive_fname_size)
+            extended_file_names += oname + '\n';
+        }
+
+        if (!extended_file_names.empty ())
+        {
+          if (extended_file_names.length () & 1)
+          {
+            extended_file_names += ' ';
+          }
+          write_header ("//", 0, 0, 0, 0, extended_file_names.length ());
+          write (extended_file_names.c_str (), extended_file_names.length ());
+        }
+
+        for (object_list::iterator oi = objects.begin ();
+             oi != objects.end ();
+             ++oi)
+          write_member (*(*oi), extended_file_names);
+      }
+      catch (...)
+      {
+        close ();
+        throw;
+      }
+
+      close ();
+    }
+
+    void
+    archive::write_member (object& obj, const std::string& extended_file_names)
+    {
+      obj.open ();
+
+      try
+      {
+        std::string oname = path::basename (obj.name ().oname ());
+
+        /*
+         * Convert the file name to an offset into the extended file name
+         * table if the file name is too long for the header.
+         */
+
+        if (oname.length () >= rld_archive_fname_size)
+        {
+          size_t pos = extended_file_names.find (oname + '\n');
+          if (pos == std::string::npos)
+            throw rld_error_at ("extended file name not found");
+          std::ostringstream oss;
+          oss << '/' << pos;
+          oname = oss.str ();
+        }
+        else oname += '/';
+
+        write_header (oname, 0, 0, 0, 0666, (obj.name ().size () + 1) & ~1);
+        obj.seek (0);
+        copy_file (obj, *this);
+        if (obj.name ().size () & 1)
+          write ("\n", 1);
+      }
+      catch (...)
+      {
+        obj.close ();
+        throw;
+      }
+
+      obj.close ();
+    }
+
+    /**
+     * Are the paths the same file?
+     */
+    static bool
+    same_file (const std::string& a, const std::string& b)
+    {
+      struct stat sa;
+      struct stat sb;
+      if (::stat (a.c_str (), &sa) < 0 || ::stat (b.c_str (), &sb) < 0)
+        return false;
+      return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    }
+
+    bool
+    archive::update (object_list& objects)
+    {
+#if __WIN32__
+      return false;
+#else
+      /*
+       * A member's range in the archive is its header and its padded data.
+       */
+      struct member
+      {
+        off_t  offset;
+        size_t size;
+      };
+
+      std::vector < member > members;
+      std::string            extended_file_names;
+      off_t                  end;
 
-    void
-    archive::create (object_list& objects)
-    {
       if (rld::verbose () >= RLD_VERBOSE_DETAILS)
-        std::cout << "archive::create: " << name ().full ()
+        std::cout << "archive::update: " << name ().full ()
                   << ", objects: " << objects.size () << std::endl;
 
-      open (true);
+      /*
+       * Read the members' headers.
+       */
+      open ();
 
       try
       {
-        seek_write (0, rld_archive_ident, rld_archive_ident_size);
+        if (!is_valid () || thin_)
+        {
+          close ();
+          return false;
+        }
 
-        /*
-         * GNU extended filenames.
-         */
-        std::string extended_file_names;
+        end = image::size ();
 
-        for (object_list::iterator oi = objects.begin ();
-             oi != objects.end ();
-             ++oi)
+        off_t offset = rld_archive_ident_size;
+
+        while (offset < end)
         {
-          object& obj = *(*oi);
-          const std::string&  oname = path::basename (obj.name ().oname ());
-          if (oname.length () >= rld_archive_fname_size)
-            extended_file_names += oname + '\n';
+          uint8_t header[rld_archive_fhdr_size];
+
+          if (!read_header (offset, &header[0]))
+            throw rld::error ("truncated header", "archive-update:" + name ().path ());
+
+          size_t size = scan_decimal (&header[rld_archive_size],
+                                      rld_archive_size_size);
+
+          if (::memcmp (&header[rld_archive_fname], "//", 2) == 0)
+          {
+            extended_file_names.resize (size);
+            if (size && !seek_read (offset + rld_archive_fhdr_size,
+                                    (uint8_t*) &extended_file_names[0], size))
+              throw rld::error ("truncated extended file names",
+                                "archive-update:" + name ().path ());
+          }
+          else if (special_member (header))
+          {
+            /*
+             * The symbol table would need to be written again.
+             */
+            close ();
+            return false;
+          }
+          else
+          {
+            member m = { offset, rld_archive_fhdr_size + ((size + 1) & ~1) };
+            members.push_back (m);
+          }
+
+          offset += rld_archive_fhdr_size + ((size + 1) & ~1);
         }
+      }
+      catch (...)
+      {
+        close ();
+        throw;
+      }
 
-        if (!extended_file_names.empty ())
+      /*
+       * Split the objects into the members kept and the objects appended.
+       */
+      std::set < off_t > kept;
+      object_list        appended;
+
+      for (object_list::iterator oi = objects.begin ();
+           oi != objects.end ();
+           ++oi)
+      {
+        object& obj = *(*oi);
+        if (obj.get_archive () &&
+            same_file (obj.get_archive ()->name ().path (), name ().path ()))
+          kept.insert (obj.name ().offset () - rld_archive_fhdr_size);
+        else
         {
-          if (extended_file_names.length () & 1)
+          const std::string oname = path::basename (obj.name ().oname ());
+          if (oname.length () >= rld_archive_fname_size &&
+              extended_file_names.find (oname + '\n') == std::string::npos)
           {
-            extended_file_names += ' ';
+            close ();
+            return false;
           }
-          write_header ("//", 0, 0, 0, 0, extended_file_names.length ());
-          write (extended_file_names.c_str (), extended_file_names.length ());
+          appended.push_back (&obj);
         }
+      }
 
-        for (object_list::iterator oi = objects.begin ();
-             oi != objects.end ();
-             ++oi)
+      /*
+       * The archive is cut at the first member removed and the members kept
+       * after it are moved up.
+       */
+      off_t                  cut = end;
+      std::vector < member > moved;
+      size_t                 moved_size = 0;
+
+      for (auto& m : members)
+      {
+        if (kept.find (m.offset) == kept.end ())
         {
-          object& obj = *(*oi);
+          if (cut == end)
+            cut = m.offset;
+        }
+        else if (cut != end)
+        {
+          moved.push_back (m);
+          moved_size += m.size;
+        }
+      }
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "archive::update: " << name ().full ()
+                  << ": untouched: " << cut
+                  << " moved: " << moved.size ()
+                  << " appended: " << appended.size () << std::endl;
 
-          obj.open ();
+      image moving (name ().path () + ".rld-update", false);
 
-          try
+      try
+      {
+        if (!moved.empty ())
+        {
+          moving.open (true);
+          for (auto& m : moved)
           {
-            std::string oname = path::basename (obj.name ().oname ());
+            seek (m.offset);
+            copy_file (*this, moving, m.size);
+          }
+          moving.close ();
+        }
+      }
+      catch (...)
+      {
+        close ();
+        if (!moved.empty ())
+          ::unlink (moving.name ().path ().c_str ());
+        throw;
+      }
 
-            /*
-             * Convert the file name to an offset into the extended file name
-             * table if the file name is too long for the header.
-             */
+      close ();
 
-            if (oname.length () >= rld_archive_fname_size)
-            {
-              size_t pos = extended_file_names.find (oname + '\n');
-              if (pos == std::string::npos)
-                throw rld_error_at ("extended file name not found");
-              std::ostringstream oss;
-              oss << '/' << pos;
-              oname = oss.str ();
-            }
-            else oname += '/';
+      open_update ();
 
-            write_header (oname, 0, 0, 0, 0666, (obj.name ().size () + 1) & ~1);
-            obj.seek (0);
-            copy_file (obj, *this);
-            if (obj.name ().size () & 1)
-              write ("\n", 1);
-          }
-          catch (...)
-          {
-            obj.close ();
-            throw;
-          }
+      try
+      {
+        if (::ftruncate (fd (), cut) < 0)
+          throw rld::error (::strerror (errno), "archive-update:" + name ().path ());
+
+        seek (cut);
 
-          obj.close ();
+        if (!moved.empty ())
+        {
+          moving.open ();
+          moving.seek (0);
+          copy_file (moving, *this, moved_size);
+          moving.close ();
+          ::unlink (moving.name ().path ().c_str ());
         }
+
+        for (object_list::iterator oi = appended.begin ();
+             oi != appended.end ();
+             ++oi)
+          write_member (*(*oi), extended_file_names);
       }
       catch (...)
       {
@@ -882,6 +1901,9 @@ namespace rld
       }
 
       close ();
+
+      return true;
+#endif
     }
 
     relocation::relocation (const elf::relocation& er)
@@ -889,7 +1911,7 @@ namespace rld
         type (er.type ()),
         info (er.info ()),
         addend (er.addend ()),
-        symname (er.symbol ().name ()),
+        symname (rld::intern (er.symbol ().name ())),
         symtype (er.symbol ().type ()),
         symsect (er.symbol ().section_index ()),
         symvalue (er.symbol ().value ()),
@@ -916,6 +1938,7 @@ namespace rld
     section::load_relocations (const elf::section& es)
     {
       const elf::relocations& es_relocs = es.get_relocations ();
+      relocs.reserve (relocs.size () + es_relocs.size ());
       for (elf::relocations::const_iterator ri = es_relocs.begin ();
            ri != es_relocs.end ();
            ++ri)
@@ -965,7 +1988,9 @@ namespace rld
         archive_ (&archive_),
         valid_ (false),
         resolving_ (false),
-        resolved_ (false)
+        resolved_ (false),
+        indexed_ (false),
+        types_ (0)
     {
       if (!name ().is_valid ())
         throw rld_error_at ("name is empty");
@@ -976,7 +2001,9 @@ namespace rld
         archive_ (0),
         valid_ (false),
         resolving_ (false),
-        resolved_ (false)
+        resolved_ (false),
+        indexed_ (false),
+        types_ (0)
     {
       if (!name ().is_valid ())
         throw rld_error_at ("name is empty");
@@ -986,7 +2013,9 @@ namespace rld
       : archive_ (0),
         valid_ (false),
         resolving_ (false),
-        resolved_ (false)
+        resolved_ (false),
+        indexed_ (false),
+        types_ (0)
     {
     }
 
@@ -1013,10 +2042,16 @@ namespace rld
     void
     object::open (bool writable)
     {
-      if (archive_)
+      if (in_archive ())
       {
         if (writable)
           throw rld_error_at ("object files in archives are not writable");
+        /*
+         * An archive is opened when a member is used and held open for its
+         * other members until the cache's archives end or it is released.
+         */
+        std::lock_guard < std::mutex > guard (held_lock);
+        hold (archive_);
         archive_->open ();
       }
       else
@@ -1026,8 +2061,9 @@ namespace rld
     void
     object::close ()
     {
-      if (archive_)
+      if (in_archive ())
       {
+        std::lock_guard < std::mutex > guard (held_lock);
         archive_->end ();
         archive_->close ();
       }
@@ -1049,7 +2085,7 @@ namespace rld
         std::cout << "object:begin: " << name ().full () << " in-archive:"
                   << ((char*) (archive_ ? "yes" : "no")) << std::endl;
 
-      if (archive_)
+      if (in_archive ())
         elf ().begin (name ().full (), archive_->elf(), name ().offset ());
       else
         elf ().begin (name ().full (), fd (), is_writable ());
@@ -1070,7 +2106,10 @@ namespace rld
           throw rld::error ("Invalid ELF type (only ET_EXEC/ET_REL supported).",
                             "object-begin:" + name ().full ());
 
-        elf::check_file (elf ());
+        if (types_ != 0)
+          elf::check_file (elf (), *types_);
+        else
+          elf::check_file (elf ());
 
         /**
          * We assume the ELF file is invariant over the linking process.
@@ -1112,6 +2151,12 @@ namespace rld
       return valid_;
     }
 
+    void
+    object::set_object_type (elf::object_type& types)
+    {
+      types_ = &types;
+    }
+
     void
     object::load_symbols (rld::symbols::table& symbols, bool local)
     {
@@ -1205,6 +2250,20 @@ namespace rld
       }
     }
 
+    void
+    object::set_symbols (const symbols::bucket& syms)
+    {
+      elf ().set_symbols (syms);
+      valid_ = true;
+      indexed_ = true;
+    }
+
+    bool
+    object::indexed () const
+    {
+      return indexed_;
+    }
+
     void
     object::load_relocations ()
     {
@@ -1226,7 +2285,7 @@ namespace rld
     int
     object::references () const
     {
-      if (archive_)
+      if (in_archive ())
         return archive_->references ();
       return image::references ();
     }
@@ -1234,7 +2293,7 @@ namespace rld
     size_t
     object::size () const
     {
-      if (archive_)
+      if (in_archive ())
         return archive_->size ();
       return image::size ();
     }
@@ -1242,11 +2301,27 @@ namespace rld
     int
     object::fd () const
     {
-      if (archive_)
+      if (in_archive ())
         return archive_->fd ();
       return image::fd ();
     }
 
+    const uint8_t*
+    object::mapped () const
+    {
+      if (in_archive ())
+        return archive_->mapped ();
+      return image::mapped ();
+    }
+
+    size_t
+    object::mapped_size () const
+    {
+      if (in_archive ())
+        return archive_->mapped_size ();
+      return image::mapped_size ();
+    }
+
     void
     object::symbol_referenced ()
     {
@@ -1261,6 +2336,12 @@ namespace rld
       return archive_;
     }
 
+    bool
+    object::in_archive () const
+    {
+      return archive_ != 0 && !archive_->is_thin ();
+    }
+
     rld::symbols::symtab&
     object::unresolved_symbols ()
     {
@@ -1358,7 +2439,9 @@ namespace rld
     }
 
     cache::cache ()
-      : opened (false)
+      : opened (false),
+        use_armap (false),
+        locals (false)
     {
     }
 
@@ -1387,7 +2470,6 @@ namespace rld
       if (!opened)
       {
         collect_object_files ();
-        archives_begin ();
         opened = true;
       }
     }
@@ -1461,6 +2543,8 @@ namespace rld
         {
           if (rld::verbose () >= RLD_VERBOSE_TRACE)
             std::cout << "cache:archive-end: " << path << std::endl;
+          std::lock_guard < std::mutex > guard (held_lock);
+          unhold (ar);
           ar->end ();
           ar->close ();
         }
@@ -1481,6 +2565,60 @@ namespace rld
         archive_end (((*ai).second)->path ());
     }
 
+    void
+    cache::set_index (const std::string& directory)
+    {
+      index_ = directory;
+    }
+
+    void
+    cache::set_armap (bool use)
+    {
+      use_armap = use;
+    }
+
+    bool
+    cache::armapped (object* obj) const
+    {
+      return
+        obj->get_archive () != 0 &&
+        armapped_.find (obj->get_archive ()) != armapped_.end ();
+    }
+
+    bool
+    cache::load_armap_symbol (const std::string& name,
+                              symbols::table&    symbols)
+    {
+      armap::iterator ami = armap_.find (name);
+      if (ami == armap_.end ())
+        return false;
+
+      object* obj = (*ami).second;
+
+      if (!loaded_.insert (obj).second)
+        return false;
+
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+        std::cout << "cache:load-armap-sym: " << name
+                  << ": " << obj->name ().full () << std::endl;
+
+      obj->open ();
+      try
+      {
+        obj->begin ();
+        obj->load_symbols (symbols, locals);
+        obj->end ();
+      }
+      catch (...)
+      {
+        obj->close ();
+        throw;
+      }
+      obj->close ();
+
+      return true;
+    }
+
     void
     cache::collect_object_files ()
     {
@@ -1497,9 +2635,14 @@ namespace rld
       {
         try
         {
-          ar->open ();
-          ar->load_objects (objects_);
-          ar->close ();
+          if (index_.empty () || !ar->load_index (objects_, index_))
+          {
+            ar->open ();
+            ar->load_objects (objects_);
+            ar->close ();
+            if (!index_.empty ())
+              unindexed_.push_back (path);
+          }
           archives_[path] = ar;
         }
         catch (...)
@@ -1535,29 +2678,182 @@ namespace rld
     }
 
     void
-    cache::load_symbols (rld::symbols::table& symbols, bool local)
+    cache::load_symbols (rld::symbols::table& symbols,
+                         bool                 local,
+                         unsigned int         jobs)
     {
       if (rld::verbose () >= RLD_VERBOSE_INFO)
         std::cout << "cache:load-sym: object files: " << objects_.size ()
                   << std::endl;
 
+      locals = local;
+
+      /*
+       * The members of an archive with a symbol table are loaded when a
+       * symbol they define is needed. An archive read from the symbol index
+       * already has its symbols.
+       */
+      if (use_armap)
+      {
+        for (archives::iterator ai = archives_.begin ();
+             ai != archives_.end ();
+             ++ai)
+        {
+          archive* ar = (*ai).second;
+          bool     indexed = false;
+          for (objects::iterator oi = objects_.begin ();
+               oi != objects_.end ();
+               ++oi)
+          {
+            object* obj = (*oi).second;
+            if (obj->get_archive () == ar)
+            {
+              indexed = obj->indexed ();
+              break;
+            }
+          }
+          if (indexed)
+            continue;
+          ar->open ();
+          bool loaded;
+          try
+          {
+            loaded = ar->load_armap (objects_, armap_);
+          }
+          catch (...)
+          {
+            ar->close ();
+            throw;
+          }
+          ar->close ();
+          if (loaded)
+          {
+            armapped_.insert (ar);
+            unindexed_.erase (std::remove (unindexed_.begin (),
+                                           unindexed_.end (),
+                                           ar->path ()),
+                              unindexed_.end ());
+          }
+          else if (rld::verbose () >= RLD_VERBOSE_INFO)
+            std::cout << "cache:load-sym: no archive symbol table: "
+                      << ar->path () << std::endl;
+        }
+
+        if (rld::verbose () >= RLD_VERBOSE_INFO)
+          std::cout << "cache:load-sym: armap: archives: " << armapped_.size ()
+                    << " symbols: " << armap_.size () << std::endl;
+      }
+
+      /*
+       * The ELF symbols are read on the threads and the symbol table is
+       * loaded here in the same order as a serial load.
+       */
+      bool read = jobs > 1;
+      if (read)
+        read_symbols (jobs);
+
       for (objects::iterator oi = objects_.begin ();
            oi != objects_.end ();
            ++oi)
       {
         object* obj = (*oi).second;
-        obj->open ();
-        obj->begin ();
-        obj->load_symbols (symbols, local);
-        obj->end ();
-        obj->close ();
+        if (armapped (obj))
+          continue;
+        if (read || obj->indexed ())
+          obj->load_symbols (symbols, local);
+        else
+        {
+          obj->open ();
+          obj->begin ();
+          obj->load_symbols (symbols, local);
+          obj->end ();
+          obj->close ();
+        }
+      }
+
+      /*
+       * Save the symbol index of the archives that were read.
+       */
+      for (path::paths::iterator pi = unindexed_.begin ();
+           pi != unindexed_.end ();
+           ++pi)
+      {
+        archives::iterator ai = archives_.find (*pi);
+        if (ai != archives_.end ())
+          (*ai).second->save_index (objects_, index_);
       }
+      unindexed_.clear ();
 
       if (rld::verbose () >= RLD_VERBOSE_INFO)
         std::cout << "cache:load-sym: symbols: " << symbols.size ()
                   << std::endl;
     }
 
+    void
+    cache::read_symbols (unsigned int jobs)
+    {
+      /*
+       * The members of an archive are read through the archive's ELF handle
+       * and the archive's references so they are read on the same thread.
+       */
+      std::vector < object_list > groups;
+      std::map < archive*, size_t > archive_groups;
+
+      for (objects::iterator oi = objects_.begin ();
+           oi != objects_.end ();
+           ++oi)
+      {
+        object* obj = (*oi).second;
+        if (obj->indexed () || armapped (obj))
+          continue;
+        archive* ar = obj->get_archive ();
+        if (ar == 0)
+        {
+          groups.push_back (object_list ());
+          groups.back ().push_back (obj);
+        }
+        else
+        {
+          std::map < archive*, size_t >::iterator agi = archive_groups.find (ar);
+          if (agi == archive_groups.end ())
+          {
+            agi = archive_groups.insert (std::make_pair (ar, groups.size ())).first;
+            groups.push_back (object_list ());
+          }
+          groups[(*agi).second].push_back (obj);
+        }
+      }
+
+      if (jobs > groups.size ())
+        jobs = groups.size ();
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "cache:read-sym: groups: " << groups.size ()
+                  << " jobs: " << jobs << std::endl;
+
+      rld::tasks::parallel_for (groups.size (), jobs, [&] (size_t g) {
+        for (object_list::iterator oi = groups[g].begin ();
+             oi != groups[g].end ();
+             ++oi)
+        {
+          object* obj = *oi;
+          obj->open ();
+          try
+          {
+            obj->begin ();
+            obj->elf ().load_symbols ();
+            obj->end ();
+          }
+          catch (...)
+          {
+            obj->close ();
+            throw;
+          }
+          obj->close ();
+        }
+      });
+    }
+
     void
     cache::output_unresolved_symbols (std::ostream& out)
     {
@@ -1657,10 +2953,7 @@ namespace rld
     cache::input (const std::string& path)
     {
       if (opened)
-      {
         collect_object_files (path);
-        archive_begin (path);
-      }
     }
 
     void
@@ -1683,7 +2976,7 @@ namespace rld
           path::path_join (libpaths[p], lib, plib);
           if (rld::verbose () >= RLD_VERBOSE_DETAILS)
               std::cout << " checking: " << plib << std::endl;
-          if (path::check_file (plib))
+          if (path::check_directory_file (libpaths[p], lib))
           {
             if (rld::verbose () >= RLD_VERBOSE_INFO)
               std::cout << " found: " << plib << std::endl;
@@ -34,7 +34,9 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <rld.h>
@@ -64,6 +66,12 @@ namespace rld
      */
     typedef std::list < object* > object_list;
 
+    /**
+     * Container of the archive members defining a symbol as read from the
+     * archive symbol tables. The index is the symbol's name.
+     */
+    typedef std::unordered_map < std::string, object* > armap;
+
     /**
      * Byte order of the image.
      */
@@ -206,6 +214,116 @@ namespace rld
       size_t      size_;   //< The object's size in the archive or on disk.
     };
 
+    /**
+     * A read only view of a file's contents. The file is mapped into memory
+     * if it can be and the data is accessed in place. If the file cannot be
+     * mapped, for example it is not a regular file or the host cannot map
+     * files, data returns 0 and reads are made with pread. An access hint
+     * tells the host how the data will be read.
+     */
+    class view
+    {
+    public:
+      /**
+       * How the data is accessed.
+       */
+      enum access
+      {
+        sequential, //< Read from the start to the end.
+        random      //< Read in any order.
+      };
+
+      /**
+       * Construct a closed view.
+       */
+      view ();
+
+      /**
+       * Construct a view of a file opening it.
+       *
+       * @param path The path of the file.
+       * @param advice How the data is accessed.
+       * @throw rld::error The file cannot be opened.
+       */
+      view (const std::string& path, access advice = sequential);
+
+      /**
+       * Close the view.
+       */
+      ~view ();
+
+      /**
+       * Open a view of the file.
+       *
+       * @param path The path of the file.
+       * @param advice How the data is accessed.
+       * @throw rld::error The file cannot be opened.
+       */
+      void open (const std::string& path, access advice = sequential);
+
+      /**
+       * Open a view of an open file. The file descriptor is used by reads if
+       * the file cannot be mapped and it is not closed by the view.
+       *
+       * @param fd The open file descriptor.
+       * @param path The path of the file for errors.
+       * @param advice How the data is accessed.
+       */
+      void open (int fd, const std::string& path, access advice = sequential);
+
+      /**
+       * Close the view.
+       */
+      void close ();
+
+      /**
+       * Read a block of data at an offset. Less than the size is read at the
+       * end of the file.
+       *
+       * @param offset The offset in the file.
+       * @param buffer The buffer to read into.
+       * @param size The size of the buffer.
+       * @return size_t The size of the data read.
+       * @throw rld::error The read failed.
+       */
+      size_t read (off_t offset, void* buffer, size_t size) const;
+
+      /**
+       * The file's data in memory.
+       *
+       * @return const uint8_t* The data or 0 if the file is not mapped.
+       */
+      const uint8_t* data () const;
+
+      /**
+       * The size of the file.
+       */
+      size_t size () const;
+
+      /**
+       * Is the file mapped into memory?
+       */
+      bool mapped () const;
+
+      /**
+       * Is the view open?
+       */
+      bool is_open () const;
+
+    private:
+      std::string    path_;  //< The path of the file.
+      int            fd_;    //< The file descriptor.
+      bool           owner;  //< The view opened the file descriptor.
+      const uint8_t* data_;  //< The mapped data, 0 if not mapped.
+      size_t         size_;  //< The size of the file.
+
+      /*
+       * Cannot copy a view.
+       */
+      view (const view& orig) = delete;
+      view& operator= (const view& rhs) = delete;
+    };
+
     /**
      * Image is the base file type and lets us have a single container to hold
      * the types of images we need to support.
@@ -255,6 +373,12 @@ namespace rld
        */
       virtual void open (bool writable = false);
 
+      /**
+       * Open the image to update it. The image is writable and the file's
+       * contents are kept. The image must not be open.
+       */
+      void open_update ();
+
       /**
        * Close the image.
        */
@@ -269,6 +393,17 @@ namespace rld
        */
       virtual ssize_t read (void* buffer, size_t size);
 
+      /**
+       * Read a block from the mapped file without copying it. The read
+       * position moves past the block.
+       *
+       * @param size The amount of data to read.
+       * @return const uint8_t* The block in the mapped memory or 0 if the
+       *                        image is not mapped or the block is not all in
+       *                        the mapped memory.
+       */
+      const uint8_t* read_mapped (size_t size);
+
       /**
        * Write a block from the file.
        *
@@ -335,6 +470,22 @@ namespace rld
        */
       virtual int fd () const;
 
+      /**
+       * The memory the file is mapped into. A file opened as not writable is
+       * mapped if it can be and reads are from the memory rather than the
+       * file descriptor.
+       *
+       * @return const uint8_t* The mapped file or 0 if not mapped.
+       */
+      virtual const uint8_t* mapped () const;
+
+      /**
+       * The size of the mapped file.
+       *
+       * @return size_t The size of the mapped memory.
+       */
+      virtual size_t mapped_size () const;
+
       /**
        * The ELF reference.
        *
@@ -398,13 +549,25 @@ namespace rld
 
     private:
 
-      file      name_;       //< The name of the file.
-      int       references_; //< The number of handles open.
-      int       fd_;         //< The file descriptor of the archive.
-      elf::file elf_;        //< The libelf reference.
-      int       symbol_refs; //< The number of symbols references made.
-      bool      writable;    //< The image is writable.
-      bool      remove;      //< Remove the image on close if writable.
+      /**
+       * Map the open file into memory if possible.
+       */
+      void map ();
+
+      /**
+       * Unmap the file.
+       */
+      void unmap ();
+
+      file           name_;       //< The name of the file.
+      int            references_; //< The number of handles open.
+      int            fd_;         //< The file descriptor of the archive.
+      view           view_;       //< The view of the file if mapped.
+      size_t         position_;   //< The read position in the mapped file.
+      elf::file      elf_;        //< The libelf reference.
+      int            symbol_refs; //< The number of symbols references made.
+      bool           writable;    //< The image is writable.
+      bool           remove;      //< Remove the image on close if writable.
     };
 
     /**
@@ -459,13 +622,22 @@ namespace rld
       bool is (const std::string& name) const;
 
       /**
-       * Check this is a valid archive.
+       * Check this is a valid archive. A GNU thin archive is valid.
        *
        * @retval true It is a valid archive.
        * @retval false It is not a valid archive.
        */
       bool is_valid ();
 
+      /**
+       * Is this a GNU thin archive? The members of a thin archive are the
+       * files the archive names and are not held in the archive.
+       *
+       * @retval true It is a thin archive.
+       * @retval false It is a normal archive or has not been checked.
+       */
+      bool is_thin () const;
+
       /**
        * Load @ref object's from the @ref archive adding each to the provided
        * @ref objects container.
@@ -474,6 +646,44 @@ namespace rld
        */
       void load_objects (objects& objs);
 
+      /**
+       * Load @ref object's and their symbols from the archive's entry in the
+       * symbol index adding each to the provided @ref objects container. The
+       * entry is only used if the archive's path, size and modification time
+       * match. A thin archive is not indexed because its members can change
+       * without the archive changing.
+       *
+       * @param objs The container the loaded object files are added too.
+       * @param index The symbol index directory.
+       * @retval true The entry was loaded.
+       * @retval false There is no entry or it does not match the archive.
+       */
+      bool load_index (objects& objs, const std::string& index);
+
+      /**
+       * Save the archive's @ref object's in the container and their symbols
+       * as an entry in the symbol index. A failure to write the entry is
+       * reported and ignored.
+       *
+       * @param objs The container of loaded object files.
+       * @param index The symbol index directory.
+       */
+      void save_index (objects& objs, const std::string& index);
+
+      /**
+       * Load the archive's symbol table, the GNU '/' or '/SYM64/' member
+       * written by ar or ranlib, adding the member that defines each symbol
+       * to the armap. A symbol already in the armap is not replaced. The
+       * archive's objects must be loaded and the archive open.
+       *
+       * @param objs The container of loaded object files.
+       * @param syms The armap to add the symbols to.
+       * @retval true The symbol table was loaded.
+       * @retval false There is no symbol table or it does not match the
+       *               archive's members.
+       */
+      bool load_armap (objects& objs, armap& syms);
+
       /**
        * Get the name.
        *
@@ -500,8 +710,31 @@ namespace rld
        */
       void create (object_list& objects);
 
+      /**
+       * Update the archive in place so it contains the given set of
+       * objects. The members before the first member not in the set are not
+       * touched. The members of the set after it are moved up and the
+       * objects that are not members are appended. The archive's objects
+       * are not valid after an update.
+       *
+       * @param objects The list of objects to place in the archive.
+       * @retval true The archive has been updated.
+       * @retval false The archive cannot be updated in place and is not
+       *               changed. It is thin, has a symbol table, needs a new
+       *               extended file name or the host cannot truncate files.
+       */
+      bool update (object_list& objects);
+
     private:
 
+      /**
+       * Write an object as a member at the archive's position.
+       *
+       * @param obj The object to write.
+       * @param extended_file_names The archive's extended file names.
+       */
+      void write_member (object& obj, const std::string& extended_file_names);
+
       /**
        * Read the archive header and check the magic number is valid.
        *
@@ -513,6 +746,14 @@ namespace rld
        */
       bool read_header (off_t offset, uint8_t* header);
 
+      /**
+       * Is the member a GNU symbol table or extended file name table? Only
+       * these members have their data in a thin archive.
+       *
+       * @param header The member's header.
+       */
+      static bool special_member (const uint8_t* header);
+
       /**
        * Add the object file from the archive to the object's container.
        *
@@ -543,6 +784,10 @@ namespace rld
                          int                mode,
                          size_t             size);
 
+      bool                           thin_;    //< The archive is thin.
+      std::map < uint64_t, object* > members_; //< A thin archive's members by
+                                               //  header offset.
+
       /**
        * Cannot copy via a copy constructor.
        */
@@ -565,7 +810,7 @@ namespace rld
       const uint32_t    type;      //< The type of relocation record.
       const uint32_t    info;      //< The ELF info field.
       const int32_t     addend;    //< The constant addend.
-      const std::string symname;   //< The name of the symbol.
+      const std::string& symname;  //< The interned name of the symbol.
       const uint32_t    symtype;   //< The type of symbol.
       const int         symsect;   //< The symbol's section symbol.
       const uint32_t    symvalue;  //< The symbol's value.
@@ -585,9 +830,11 @@ namespace rld
     };
 
     /**
-     * A container of relocations.
+     * A container of relocations. The relocations of a section are held in
+     * contiguous memory as they are iterated over a number of times when
+     * creating an image.
      */
-    typedef std::list < relocation > relocations;
+    typedef std::vector < relocation > relocations;
 
     /**
      * The sections attributes. We extract what we want because the
@@ -704,6 +951,16 @@ namespace rld
        */
       bool valid () const;
 
+      /**
+       * Set the context the object file's ELF type is checked against when
+       * the session begins. The default is the process wide context. Set a
+       * context of its own for each image of an unrelated type processed at
+       * the same time.
+       *
+       * @param types The ELF object type context.
+       */
+      void set_object_type (elf::object_type& types);
+
       /**
        * Load the symbols into the symbols table.
        *
@@ -712,6 +969,20 @@ namespace rld
        */
       void load_symbols (symbols::table& symbols, bool local = false);
 
+      /**
+       * Set the symbols from a symbol index. The object file was checked when
+       * the index was created so it is valid and does not need to be opened
+       * to load the symbols.
+       *
+       * @param syms The object file's symbols.
+       */
+      void set_symbols (const symbols::bucket& syms);
+
+      /**
+       * The symbols are from a symbol index.
+       */
+      bool indexed () const;
+
       /**
        * Load the relocations.
        */
@@ -732,6 +1003,17 @@ namespace rld
        */
       virtual int fd () const;
 
+      /**
+       * The mapped memory. An object file in an archive uses the archive's
+       * memory.
+       */
+      virtual const uint8_t* mapped () const;
+
+      /**
+       * The mapped memory size.
+       */
+      virtual size_t mapped_size () const;
+
       /**
        * A symbol in the image has been referenced.
        */
@@ -813,6 +1095,12 @@ namespace rld
       bool resolved () const;
 
     private:
+      /**
+       * The object's data is in the archive's image. The members of a thin
+       * archive are files of their own.
+       */
+      bool in_archive () const;
+
       archive*          archive_;   //< Points to the archive if part of an
                                     //  archive.
       bool              valid_;     //< If true begin has run and finished.
@@ -821,6 +1109,9 @@ namespace rld
       sections          secs;       //< The sections.
       bool              resolving_; //< The object is being resolved.
       bool              resolved_;  //< The object has been resolved.
+      bool              indexed_;   //< The symbols are from a symbol index.
+      elf::object_type* types_;     //< The ELF type context, 0 is the
+                                    //  default.
 
       /**
        * Cannot copy via a copy constructor.
@@ -834,8 +1125,9 @@ namespace rld
     };
 
     /**
-     * A collection of objects files as a cache. This currently is not a cache
-     * but it could become one.
+     * A collection of objects files as a cache. The members of the archives
+     * and their symbols can be held in an on-disk symbol index so an archive
+     * that has not changed is not read again.
      */
     class cache
     {
@@ -896,6 +1188,40 @@ namespace rld
        */
       void archives_end ();
 
+      /**
+       * Set the symbol index directory. The archives are read from the index
+       * if their entry matches and the index is updated when the symbols are
+       * loaded. The index is not used if the directory is empty, the default.
+       *
+       * @param directory The symbol index directory.
+       */
+      void set_index (const std::string& directory);
+
+      /**
+       * Use the archive symbol tables. The symbols of an archive's members are
+       * not loaded with the other symbols and a member's symbols are loaded
+       * when a symbol it defines is looked up with @ref load_armap_symbol. An
+       * archive without a symbol table or with one that does not match its
+       * members has all its members' symbols loaded. The default does not
+       * use the archive symbol tables.
+       *
+       * @param use If true use the archive symbol tables.
+       */
+      void set_armap (bool use);
+
+      /**
+       * Load the symbols of the archive member that defines the symbol if the
+       * member's symbols have not been loaded.
+       *
+       * @param name The name of the symbol.
+       * @param symbols The symbol table to load.
+       * @retval true The member's symbols were loaded.
+       * @retval false There is no member not yet loaded that defines the
+       *               symbol.
+       */
+      bool load_armap_symbol (const std::string& name,
+                              symbols::table&    symbols);
+
       /**
        * Collect the object names and add them to the cache.
        */
@@ -912,8 +1238,12 @@ namespace rld
        *
        * @param symbols The symbol table to load.
        * @param locals Include local symbols. The default does not include them.
+       * @param jobs The number of threads reading the object files' symbols.
+       *             The symbol table is the same for any number of threads.
        */
-      void load_symbols (symbols::table& symbols, bool locals = false);
+      void load_symbols (symbols::table& symbols,
+                         bool            locals = false,
+                         unsigned int    jobs = 1);
 
       /**
        * Output the unresolved symbol table to the output stream.
@@ -983,10 +1313,30 @@ namespace rld
       virtual void input (const std::string& path);
 
     private:
-      path::paths paths_;    //< The names of the files to process.
-      archives    archives_; //< The archive files.
-      objects     objects_;  //< The object files.
-      bool        opened;    //< The cache is open.
+      /**
+       * Read the ELF symbols of the object files that are not indexed using
+       * a number of threads.
+       */
+      void read_symbols (unsigned int jobs);
+
+      /**
+       * Is the object in an archive whose symbols are loaded using its
+       * symbol table?
+       */
+      bool armapped (object* obj) const;
+
+      path::paths paths_;     //< The names of the files to process.
+      archives    archives_;  //< The archive files.
+      objects     objects_;   //< The object files.
+      bool        opened;     //< The cache is open.
+      std::string index_;     //< The symbol index directory.
+      path::paths unindexed_; //< The archives to add to the symbol index.
+      bool        use_armap;  //< Use the archive symbol tables.
+      bool        locals;     //< Load the local symbols.
+      armap       armap_;     //< The archive members defining a symbol.
+      std::set < const archive* > armapped_; //< The archives using their
+                                             //  symbol tables.
+      std::set < const object* >  loaded_;   //< The armapped members loaded.
     };
 
     /**
@@ -998,6 +1348,16 @@ namespace rld
      */
     void copy_file (image& in, image& out, size_t size = 0);
 
+    /**
+     * Set the most archives held open between the uses of their members. An
+     * archive released to stay in the limit is opened again when one of its
+     * members is next used. The default of 0 is half the process's open file
+     * limit.
+     *
+     * @param limit The number of archives.
+     */
+    void set_open_archives (size_t limit);
+
     /**
      * Find the libraries given the list of libraries as bare name which
      * have 'lib' and '.a' added.
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2026, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems-ld
+ *
+ * @brief Content hashing for the caches of the tools.
+ *
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <iomanip>
+#include <sstream>
+
+#include <string.h>
+
+#include <rld.h>
+#include <rld-hash.h>
+
+namespace rld
+{
+  namespace hash
+  {
+    /*
+     * The primes of XXH64.
+     */
+    static const uint64_t prime_1 = 0x9e3779b185ebca87ULL;
+    static const uint64_t prime_2 = 0xc2b2ae3d27d4eb4fULL;
+    static const uint64_t prime_3 = 0x165667b19e3779f9ULL;
+    static const uint64_t prime_4 = 0x85ebca77c2b2ae63ULL;
+    static const uint64_t prime_5 = 0x27d4eb2f165667c5ULL;
+
+    /*
+     * The size of the blocks read from a file that is not mapped.
+     */
+    static const size_t file_block = 1024 * 1024;
+
+    static inline uint64_t
+    rotl (uint64_t value, int bits)
+    {
+      return (value << bits) | (value >> (64 - bits));
+    }
+
+    /*
+     * The data is read as little-endian on any host.
+     */
+    static inline uint64_t
+    read_64 (const uint8_t* data)
+    {
+      uint64_t value;
+      ::memcpy (&value, data, sizeof (value));
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      value = __builtin_bswap64 (value);
+#endif
+      return value;
+    }
+
+    static inline uint32_t
+    read_32 (const uint8_t* data)
+    {
+      uint32_t value;
+      ::memcpy (&value, data, sizeof (value));
+#if defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      value = __builtin_bswap32 (value);
+#endif
+      return value;
+    }
+
+    static inline uint64_t
+    lane_round (uint64_t lane, uint64_t input)
+    {
+      lane += input * prime_2;
+      lane = rotl (lane, 31);
+      return lane * prime_1;
+    }
+
+    static inline uint64_t
+    merge_round (uint64_t hash, uint64_t lane)
+    {
+      hash ^= lane_round (0, lane);
+      return (hash * prime_1) + prime_4;
+    }
+
+    /*
+     * Hash a value as little-endian so the hash is the same on any host.
+     */
+    static void
+    update_value (hasher& h, uint64_t value)
+    {
+      uint8_t bytes[sizeof (value)];
+      for (size_t b = 0; b < sizeof (value); ++b)
+        bytes[b] = (uint8_t) (value >> (b * 8));
+      h.update (bytes, sizeof (bytes));
+    }
+
+    hasher::hasher (uint64_t seed)
+    {
+      reset (seed);
+    }
+
+    void
+    hasher::reset (uint64_t seed_)
+    {
+      seed = seed_;
+      lanes[0] = seed + prime_1 + prime_2;
+      lanes[1] = seed + prime_2;
+      lanes[2] = seed;
+      lanes[3] = seed - prime_1;
+      total = 0;
+      level = 0;
+    }
+
+    void
+    hasher::update (const void* data_, size_t length)
+    {
+      const uint8_t* data = static_cast < const uint8_t* > (data_);
+
+      total += length;
+
+      /*
+       * Fill the pending data to a stripe of the lanes.
+       */
+      if (level)
+      {
+        size_t filling = sizeof (pending) - level;
+        if (filling > length)
+          filling = length;
+        ::memcpy (pending + level, data, filling);
+        level += filling;
+        data += filling;
+        length -= filling;
+        if (level < sizeof (pending))
+          return;
+        for (int l = 0; l < 4; ++l)
+          lanes[l] = lane_round (lanes[l], read_64 (pending + (l * 8)));
+        level = 0;
+      }
+
+      /*
+       * The lanes are independent so the loop keeps four multiplies in
+       * flight.
+       */
+      uint64_t v1 = lanes[0];
+      uint64_t v2 = lanes[1];
+      uint64_t v3 = lanes[2];
+      uint64_t v4 = lanes[3];
+
+      while (length >= sizeof (pending))
+      {
+        v1 = lane_round (v1, read_64 (data));
+        v2 = lane_round (v2, read_64 (data + 8));
+        v3 = lane_round (v3, read_64 (data + 16));
+        v4 = lane_round (v4, read_64 (data + 24));
+        data += sizeof (pending);
+        length -= sizeof (pending);
+      }
+
+      lanes[0] = v1;
+      lanes[1] = v2;
+      lanes[2] = v3;
+      lanes[3] = v4;
+
+      if (length)
+      {
+        ::memcpy (pending, data, length);
+        level = length;
+      }
+    }
+
+    void
+    hasher::update (const std::string& str)
+    {
+      update (str.data (), str.size ());
+    }
+
+    void
+    hasher::update (const files::view& view)
+    {
+      if (view.mapped ())
+      {
+        update (view.data (), view.size ());
+        return;
+      }
+
+      std::vector < uint8_t > block (file_block);
+      off_t                   offset = 0;
+
+      while ((size_t) offset < view.size ())
+      {
+        size_t r = view.read (offset, block.data (), block.size ());
+        if (r == 0)
+          break;
+        update (block.data (), r);
+        offset += r;
+      }
+    }
+
+    uint64_t
+    hasher::digest () const
+    {
+      uint64_t h;
+
+      if (total >= sizeof (pending))
+      {
+        h = rotl (lanes[0], 1) + rotl (lanes[1], 7) +
+          rotl (lanes[2], 12) + rotl (lanes[3], 18);
+        for (int l = 0; l < 4; ++l)
+          h = merge_round (h, lanes[l]);
+      }
+      else
+      {
+        h = seed + prime_5;
+      }
+
+      h += total;
+
+      const uint8_t* p = pending;
+      size_t         remaining = level;
+
+      while (remaining >= 8)
+      {
+        h ^= lane_round (0, read_64 (p));
+        h = (rotl (h, 27) * prime_1) + prime_4;
+        p += 8;
+        remaining -= 8;
+      }
+
+      if (remaining >= 4)
+      {
+        h ^= (uint64_t) read_32 (p) * prime_1;
+        h = (rotl (h, 23) * prime_2) + prime_3;
+        p += 4;
+        remaining -= 4;
+      }
+
+      while (remaining)
+      {
+        h ^= (*p) * prime_5;
+        h = rotl (h, 11) * prime_1;
+        ++p;
+        --remaining;
+      }
+
+      h ^= h >> 33;
+      h *= prime_2;
+      h ^= h >> 29;
+      h *= prime_3;
+      h ^= h >> 32;
+
+      return h;
+    }
+
+    std::string
+    hasher::hex () const
+    {
+      std::ostringstream oss;
+      oss << std::hex << std::setfill ('0') << std::setw (16) << digest ();
+      return oss.str ();
+    }
+
+    uint64_t
+    hasher::length () const
+    {
+      return total;
+    }
+
+    uint64_t
+    hash (const void* data, size_t length, uint64_t seed)
+    {
+      hasher h (seed);
+      h.update (data, length);
+      return h.digest ();
+    }
+
+    uint64_t
+    hash (const std::string& str, uint64_t seed)
+    {
+      return hash (str.data (), str.size (), seed);
+    }
+
+    uint64_t
+    hash_file (const std::string& path)
+    {
+      files::view view (path);
+      hasher      h;
+      h.update (view);
+      return h.digest ();
+    }
+
+    bool
+    build_id (elf::file& elf, std::vector < uint8_t >& id)
+    {
+      elf::sections secs;
+
+      id.clear ();
+
+      elf.get_sections (secs, SHT_NOTE);
+
+      const bool msb = elf.data_type () == ELFDATA2MSB;
+
+      auto word = [msb] (const uint8_t* data) {
+        uint32_t value = 0;
+        for (int b = 0; b < 4; ++b)
+          value |= (uint32_t) data[b] << (msb ? (3 - b) * 8 : b * 8);
+        return value;
+      };
+
+      for (auto sec : secs)
+      {
+        if (sec->name () != ".note.gnu.build-id")
+          continue;
+
+        elf::elf_data* edata = sec->data ();
+        if (edata == nullptr || edata->d_buf == nullptr)
+          continue;
+
+        const uint8_t* note = static_cast < const uint8_t* > (edata->d_buf);
+        const size_t   size = edata->d_size;
+
+        if (size < 12)
+          continue;
+
+        const uint32_t name_size = word (note);
+        const uint32_t desc_size = word (note + 4);
+        const uint32_t type = word (note + 8);
+        const size_t   desc = 12 + ((name_size + 3) & ~3);
+
+        if (type != NT_GNU_BUILD_ID || desc_size == 0 ||
+            desc > size || desc_size > size - desc)
+          continue;
+
+        id.assign (note + desc, note + desc + desc_size);
+        return true;
+      }
+
+      return false;
+    }
+
+    std::string
+    elf_identity (elf::file& elf)
+    {
+      std::vector < uint8_t > id;
+      std::ostringstream      oss;
+
+      oss << std::hex << std::setfill ('0');
+
+      if (build_id (elf, id))
+      {
+        oss << "b-";
+        for (auto b : id)
+          oss << std::setw (2) << static_cast < unsigned int > (b);
+        return oss.str ();
+      }
+
+      elf::sections secs;
+      hasher        h;
+
+      elf.get_sections (secs, 0);
+
+      for (auto sec : secs)
+      {
+        if ((sec->flags () & SHF_ALLOC) == 0)
+          continue;
+
+        h.update (sec->name ().c_str (), sec->name ().size () + 1);
+        update_value (h, sec->address ());
+        update_value (h, sec->size ());
+        update_value (h, sec->type ());
+
+        if (sec->type () == SHT_NOBITS)
+          continue;
+
+        elf::elf_data* edata = sec->data ();
+        if (edata != nullptr && edata->d_buf != nullptr)
+          h.update (edata->d_buf, edata->d_size);
+      }
+
+      oss << "h-" << h.hex ();
+
+      return oss.str ();
+    }
+
+    std::string
+    elf_identity (const std::string& path)
+    {
+      elf::object_type types;
+      files::object    object (path);
+
+      object.set_object_type (types);
+      object.open ();
+
+      try
+      {
+        object.begin ();
+        std::string identity = elf_identity (object.elf ());
+        object.end ();
+        object.close ();
+        return identity;
+      }
+      catch (...)
+      {
+        object.close ();
+        throw;
+      }
+    }
+  }
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems-ld
+ *
+ * @brief Content hashing for the caches of the tools.
+ *
+ * The hash is the 64 bit xxHash (XXH64). It hashes four independent lanes
+ * of 8 bytes at a time so it runs at memory speed on large inputs. The
+ * digest is the same on any host and for any way the data is split between
+ * updates.
+ */
+
+#if !defined (_RLD_HASH_H_)
+#define _RLD_HASH_H_
+
+#include <string>
+#include <vector>
+
+#include <rld-elf.h>
+#include <rld-files.h>
+
+namespace rld
+{
+  namespace hash
+  {
+    /**
+     * A streaming hash of data.
+     */
+    class hasher
+    {
+    public:
+      /**
+       * Construct a hasher.
+       *
+       * @param seed The seed of the hash.
+       */
+      hasher (uint64_t seed = 0);
+
+      /**
+       * Reset the hasher to hash new data.
+       *
+       * @param seed The seed of the hash.
+       */
+      void reset (uint64_t seed = 0);
+
+      /**
+       * Hash the data.
+       *
+       * @param data The data to hash.
+       * @param length The amount of data in bytes.
+       */
+      void update (const void* data, size_t length);
+
+      /**
+       * Hash the characters of the string.
+       *
+       * @param str The string to hash.
+       */
+      void update (const std::string& str);
+
+      /**
+       * Hash the file of the view. A mapped file is hashed from memory else
+       * it is read in blocks.
+       *
+       * @param view The view of the file.
+       */
+      void update (const files::view& view);
+
+      /**
+       * The digest of the data hashed. More data can be hashed after.
+       *
+       * @return uint64_t The digest.
+       */
+      uint64_t digest () const;
+
+      /**
+       * The digest as 16 hex digits.
+       */
+      std::string hex () const;
+
+      /**
+       * The amount of data hashed in bytes.
+       */
+      uint64_t length () const;
+
+    private:
+      uint64_t lanes[4];   //< The accumulators of the lanes.
+      uint64_t seed;       //< The seed.
+      uint64_t total;      //< The amount of data hashed.
+      uint8_t  pending[32]; //< The data not hashed by the lanes yet.
+      size_t   level;      //< The amount of pending data.
+    };
+
+    /**
+     * Hash the data.
+     *
+     * @param data The data to hash.
+     * @param length The amount of data in bytes.
+     * @param seed The seed of the hash.
+     * @return uint64_t The digest.
+     */
+    uint64_t hash (const void* data, size_t length, uint64_t seed = 0);
+
+    /**
+     * Hash the characters of the string.
+     *
+     * @param str The string to hash.
+     * @param seed The seed of the hash.
+     * @return uint64_t The digest.
+     */
+    uint64_t hash (const std::string& str, uint64_t seed = 0);
+
+    /**
+     * Hash the contents of a file.
+     *
+     * @param path The path of the file.
+     * @return uint64_t The digest.
+     * @throw rld::error The file cannot be opened or read.
+     */
+    uint64_t hash_file (const std::string& path);
+
+    /**
+     * Get the build-id of an ELF file. The ID is the descriptor of the GNU
+     * build-id note read in the file's byte order.
+     *
+     * @param elf The ELF file.
+     * @param id The ID's bytes.
+     * @retval true The file has a build-id.
+     * @retval false The file has no build-id.
+     */
+    bool build_id (elf::file& elf, std::vector < uint8_t >& id);
+
+    /**
+     * Get the identity of an ELF file. It is "b-" and the build-id in hex if
+     * the file has one else "h-" and the hash in hex of the allocated sections
+     * with their names, addresses and sizes. Files with the same identity
+     * load the same image while the debug information can differ.
+     *
+     * @param elf The ELF file.
+     * @return std::string The identity.
+     */
+    std::string elf_identity (elf::file& elf);
+
+    /**
+     * Get the identity of the ELF file at the path.
+     *
+     * @param path The path of the ELF file.
+     * @return std::string The identity.
+     * @throw rld::error The file is not a valid ELF file.
+     */
+    std::string elf_identity (const std::string& path);
+  }
+}
+
+#endif
@@ -27,12 +27,16 @@
 #endif
 
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 #include <errno.h>
 #include <string.h>
 
 #include <rld.h>
+#include <rld-path.h>
 #include <rld-rap.h>
 
 #include <sys/types.h>
@@ -62,6 +66,179 @@ namespace rld
 #endif
     }
 
+    /*
+     * The output cache directory, empty if there is no output cache.
+     */
+    static std::string output_cache;
+
+    void
+    set_output_cache (const std::string& path)
+    {
+      output_cache = path;
+    }
+
+    static void
+    output_hash (uint64_t& hash, const void* data_, size_t length)
+    {
+      const uint8_t* data = static_cast < const uint8_t* > (data_);
+      for (size_t b = 0; b < length; ++b)
+      {
+        hash ^= data[b];
+        hash *= 1099511628211ULL;
+      }
+    }
+
+    /**
+     * The symbol order changes the layout so it is part of the key.
+     */
+    static std::string
+    symbol_order_key ()
+    {
+      std::string key;
+      for (rld::strings::const_iterator si = rap::symbol_order.begin ();
+           si != rap::symbol_order.end ();
+           ++si)
+        key += *si + '\n';
+      return key;
+    }
+
+    /**
+     * The load addresses change the section data so they are part of the
+     * key.
+     */
+    static std::string
+    load_address_key ()
+    {
+      std::string key;
+      for (std::map < int, uint32_t >::const_iterator lai =
+             rap::load_addresses.begin ();
+           lai != rap::load_addresses.end ();
+           ++lai)
+        key += rld::to_string (lai->first) + '=' +
+          rld::to_string (lai->second) + '\n';
+      return key;
+    }
+
+    /**
+     * The output cache key is the FNV-1a hash of the tool version, the kind
+     * of output, the options used to create it and the name and contents of
+     * each object file in the order they are output.
+     */
+    static std::string
+    output_key (const std::string&        kind,
+                const std::string&        options,
+                const files::object_list& objects)
+    {
+      uint64_t hash = 14695981039346656037ULL;
+
+      std::string header = rld::version () + '\0' + kind + '\0' + options;
+      output_hash (hash, header.c_str (), header.size () + 1);
+
+      #define OUTPUT_KEY_BUFFER_SIZE (64 * 1024)
+      std::vector < uint8_t > buffer (OUTPUT_KEY_BUFFER_SIZE);
+
+      for (auto obj : objects)
+      {
+        const std::string& name = obj->name ().full ();
+        output_hash (hash, name.c_str (), name.size () + 1);
+
+        obj->open ();
+
+        try
+        {
+          obj->seek (0);
+
+          size_t in_size = obj->name ().size ();
+
+          while (in_size)
+          {
+            size_t reading =
+              in_size < buffer.size () ? in_size : buffer.size ();
+            ssize_t r = obj->read (buffer.data (), reading);
+            if (r <= 0)
+              throw rld::error ("input too short", "output-cache: " + name);
+            output_hash (hash, buffer.data (), r);
+            in_size -= r;
+          }
+        }
+        catch (...)
+        {
+          obj->close ();
+          throw;
+        }
+
+        obj->close ();
+      }
+
+      std::ostringstream oss;
+      oss << std::hex << std::setfill ('0') << std::setw (16) << hash
+          << '.' << kind;
+      return oss.str ();
+    }
+
+    static bool
+    output_copy (const std::string& from, const std::string& to)
+    {
+      std::ifstream in (from, std::ios::in | std::ios::binary);
+      if (!in.is_open ())
+        return false;
+      std::ofstream out (to, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!out.is_open ())
+        return false;
+      out << in.rdbuf ();
+      out.close ();
+      if (!out)
+      {
+        ::unlink (to.c_str ());
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * Copy the output with the key from the cache. The output is copied and
+     * not linked because the outputs are truncated and rewritten in place.
+     */
+    static bool
+    output_cache_get (const std::string& key, const std::string& name)
+    {
+      if (output_cache.empty ())
+        return false;
+      std::string entry;
+      path::path_join (output_cache, key, entry);
+      if (!path::check_file (entry))
+        return false;
+      if (!output_copy (entry, name))
+        return false;
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "outputter:cache: " << name << " from " << entry
+                  << std::endl;
+      return true;
+    }
+
+    /**
+     * Add the output to the cache. The copy is renamed into place so a
+     * reader never sees a partial entry.
+     */
+    static void
+    output_cache_put (const std::string& key, const std::string& name)
+    {
+      if (output_cache.empty ())
+        return;
+      std::string entry;
+      path::path_join (output_cache, key, entry);
+      std::ostringstream temp;
+      temp << entry << '.' << ::getpid ();
+      if (output_copy (name, temp.str ()))
+      {
+        if (::rename (temp.str ().c_str (), entry.c_str ()) != 0)
+          ::unlink (temp.str ().c_str ());
+      }
+      else
+        std::cerr << "warning: cannot write output cache: " << entry
+                  << std::endl;
+    }
+
     const std::string
     script_text (const std::string&        entry,
                  const std::string&        exit,
@@ -192,20 +369,35 @@ namespace rld
       std::string mdname =
         name.substr (0, name.length () - ext.length ()) + "-metadata.o";
 
-      files::object metadata (mdname);
-
-      metadata_object (metadata, entry, exit, dependents, cache);
-
       files::object_list dep_copy (dependents);
       files::object_list objects;
 
       cache.get_objects (objects);
       objects.merge (dep_copy);
+      objects.unique ();
+
+      std::string key;
+      if (!output_cache.empty ())
+      {
+        key = output_key ("a",
+                          entry + '\0' + exit + '\0' + path::basename (mdname),
+                          objects);
+        if (output_cache_get (key, name))
+          return;
+      }
+
+      files::object metadata (mdname);
+
+      metadata_object (metadata, entry, exit, dependents, cache);
+
       objects.push_front (&metadata);
       objects.unique ();
 
       files::archive arch (name);
       arch.create (objects);
+
+      if (!key.empty ())
+        output_cache_put (key, name);
     }
 
     void
@@ -213,7 +405,8 @@ namespace rld
                const files::object_list& dependents,
                files::cache&             cache,
                bool                      ra_exist,
-               bool                      ra_rap)
+               bool                      ra_rap,
+               bool                      ra_update)
     {
       files::object_list dep_copy (dependents);
       files::object_list objects;
@@ -275,6 +468,16 @@ namespace rld
 
       if (objects.size ())
       {
+        if (ra_exist && ra_update)
+        {
+          files::archive arch (name);
+          if (arch.update (objects))
+            return;
+          if (rld::verbose () >= RLD_VERBOSE_INFO)
+            std::cout << "outputter:archivera: " << name
+                      << ": cannot update in place" << std::endl;
+        }
+
         if (ra_exist)
         {
           std::string    new_name = "rld_XXXXXX";
@@ -363,18 +566,22 @@ namespace rld
       cache.get_objects (objects);
       objects.merge (dep_copy);
       objects.unique ();
+      rap::order_objects (objects);
+
+      std::string key;
+      if (!output_cache.empty ())
+      {
+        key = output_key ("relf", entry + '\0' + exit + '\0' +
+                          symbol_order_key (), objects);
+        if (output_cache_get (key, name))
+          return;
+      }
 
       app.open (true);
       app.write (header.c_str (), header.size ());
 
-      #define APP_BUFFER_SIZE  (128 * 1024)
-
-      uint8_t* buffer = 0;
-
       try
       {
-        buffer = new uint8_t[APP_BUFFER_SIZE];
-
         for (files::object_list::iterator oi = objects.begin ();
              oi != objects.end ();
              ++oi)
@@ -386,18 +593,7 @@ namespace rld
           try
           {
             obj.seek (0);
-
-            size_t in_size = obj.name ().size ();
-
-            while (in_size)
-            {
-              size_t reading =
-                in_size < APP_BUFFER_SIZE ? in_size : APP_BUFFER_SIZE;
-
-              app.write (buffer, obj.read (buffer, reading));
-
-              in_size -= reading;
-            }
+            files::copy_file (obj, app);
           }
           catch (...)
           {
@@ -410,15 +606,15 @@ namespace rld
       }
       catch (...)
       {
-        delete [] buffer;
         app.remove_on_close ();
         app.close ();
         throw;
       }
 
-      delete [] buffer;
-
       app.close ();
+
+      if (!key.empty ())
+        output_cache_put (key, name);
     }
 
     bool in_archive (files::object* object)
@@ -435,7 +631,9 @@ namespace rld
                      const files::object_list& dependents,
                      const files::cache&       cache,
                      const symbols::table&     symbols,
-                     bool                      one_file)
+                     bool                      one_file,
+                     unsigned int              jobs,
+                     compress::codec           method)
     {
       if (rld::verbose () >= RLD_VERBOSE_INFO)
         std::cout << "outputter:application: " << name << std::endl;
@@ -452,11 +650,31 @@ namespace rld
       objects.sort ();
       objects.unique ();
 
+      std::string key;
+      if (!output_cache.empty ())
+      {
+        key = output_key ("rap",
+                          entry + '\0' + exit + '\0' +
+                          compress::rap_header_name (method) + '\0' +
+                          std::to_string (method) + '\0' +
+                          (rap::add_obj_details ? "details" : "") + '\0' +
+                          rap::rpath + '\0' +
+                          (rap::merge_strings ? "merge-strings" : "") + '\0' +
+                          (rap::gc_sections ? "gc-sections" : "") + '\0' +
+                          (rap::compact_relocs ? "compact-relocs" : "") + '\0' +
+                          load_address_key () + '\0' +
+                          rld::to_string (rap::direct_page_size) + '\0' +
+                          symbol_order_key (),
+                          objects);
+        if (output_cache_get (key, name))
+          return;
+      }
+
       app.open (true);
 
       try
       {
-        rap::write (app, entry, exit, objects, symbols);
+        rap::write (app, entry, exit, objects, symbols, jobs, method);
       }
       catch (...)
       {
@@ -466,6 +684,9 @@ namespace rld
       }
 
       app.close ();
+
+      if (!key.empty ())
+        output_cache_put (key, name);
     }
 
   }
@@ -25,12 +25,23 @@
 #if !defined (_RLD_OUTPUTTER_H_)
 #define _RLD_OUTPUTTER_H_
 
+#include <rld-compression.h>
 #include <rld-files.h>
 
 namespace rld
 {
   namespace outputter
   {
+    /**
+     * Set the output cache directory. An archive, ELF application or RAP
+     * application is cached using a hash of its options and the contents of
+     * its object files. An output found in the cache is copied rather than
+     * generated. An empty path disables the cache.
+     *
+     * @param path The output cache directory.
+     */
+    void set_output_cache (const std::string& path);
+
     /**
      * Output the object file list as a string.
      *
@@ -62,11 +73,22 @@ namespace rld
                   const files::object_list& dependents,
                   const files::cache&       cache);
 
+    /**
+     * Output the object files as an RA file.
+     *
+     * @param name The name of the RA file.
+     * @param dependents The list of dependent object files.
+     * @param cache The file cache for the link.
+     * @param ra_exist The RA file exists and is written again.
+     * @param ra_rap The objects are RAP files.
+     * @param ra_update Update an existing RA file in place if it can be.
+     */
     void archivera (const std::string&        name,
                     const files::object_list& dependents,
                     files::cache&             cache,
                     bool                      ra_exist,
-                    bool                      ra_rap);
+                    bool                      ra_rap,
+                    bool                      ra_update = false);
 
     /**
      * Output the object file list as a script.
@@ -110,6 +132,8 @@ namespace rld
      * @param cache The file cache for the link. Includes the object list
      *              the user requested.
      * @param symbols The symbol table used to resolve the application.
+     * @param jobs The number of threads used to compress the image.
+     * @param method The codec used to compress the image.
      */
     void rap_application (const std::string&        name,
                           const std::string&        entry,
@@ -117,7 +141,10 @@ namespace rld
                           const files::object_list& dependents,
                           const files::cache&       cache,
                           const symbols::table&     symbols,
-                          bool                      one_file);
+                          bool                      one_file,
+                          unsigned int              jobs = 1,
+                          compress::codec           method =
+                            compress::codec_lz77);
 
   }
 }
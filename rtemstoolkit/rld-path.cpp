@@ -18,17 +18,40 @@
 #include "config.h"
 #endif
 
+#include <dirent.h>
 #include <errno.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
 #include <rld.h>
 
 namespace rld
 {
   namespace path
   {
+    /**
+     * The listing of a directory in the directory cache.
+     */
+    struct directory_listing
+    {
+      bool                              listed; //< The directory was read.
+      std::unordered_set < std::string > names; //< The entries.
+
+      directory_listing ()
+        : listed (false) {
+      }
+    };
+
+    typedef std::map < std::string, directory_listing > directory_listings;
+
+    static directory_listings directory_cache;
+    static std::mutex         directory_cache_lock;
+
     const std::string
     basename (const std::string& name)
     {
@@ -172,6 +195,62 @@ namespace rld
       return false;
     }
 
+    bool
+    check_directory_file (const std::string& dir, const std::string& name)
+    {
+      std::string path;
+      path_join (dir, name, path);
+
+      /*
+       * Only the names in the directory are held, anything else is checked
+       * on the file system.
+       */
+      if (name.find (RLD_PATH_SEPARATOR) != std::string::npos)
+        return check_file (path);
+
+      bool listed;
+      bool found;
+
+      {
+        std::lock_guard < std::mutex > guard (directory_cache_lock);
+
+        directory_listings::iterator dli = directory_cache.find (dir);
+        if (dli == directory_cache.end ())
+        {
+          dli = directory_cache.insert (
+            std::make_pair (dir, directory_listing ())).first;
+          DIR* d = ::opendir (dir.c_str ());
+          if (d != 0)
+          {
+            struct dirent* de;
+            while ((de = ::readdir (d)) != 0)
+              dli->second.names.insert (de->d_name);
+            ::closedir (d);
+            dli->second.listed = true;
+          }
+        }
+
+        const directory_listing& dl = dli->second;
+        listed = dl.listed;
+        found = dl.names.find (name) != dl.names.end ();
+      }
+
+      /*
+       * A listed entry may not be a regular file.
+       */
+      if (!listed || found)
+        return check_file (path);
+
+      return false;
+    }
+
+    void
+    flush_directory_cache ()
+    {
+      std::lock_guard < std::mutex > guard (directory_cache_lock);
+      directory_cache.clear ();
+    }
+
     void
     find_file (std::string& path, const std::string& name, paths& search_paths)
     {
@@ -179,9 +258,11 @@ namespace rld
            pi != search_paths.end ();
            ++pi)
       {
-        path_join (*pi, name, path);
-        if (check_file (path))
+        if (check_directory_file (*pi, name))
+        {
+          path_join (*pi, name, path);
           return;
+        }
       }
       path.clear ();
     }
@@ -127,7 +127,28 @@ namespace rld
     bool check_directory (const std::string& path);
 
     /**
-     * Find the file given a container of paths and file names.
+     * Check if the directory has an entry of the name using the directory
+     * cache. A directory is read once the first time it is checked and the
+     * lookups are made in the listing until the cache is flushed. A directory
+     * that cannot be read is checked with a stat call. It can be called from
+     * more than one thread.
+     *
+     * @param dir The directory to check.
+     * @param name The name of the entry to check for.
+     * @retval true The directory has a file of the name.
+     * @retval false The directory does not have a file of the name.
+     */
+    bool check_directory_file (const std::string& dir, const std::string& name);
+
+    /**
+     * Flush the directory cache. Call this if files are added to or removed
+     * from the directories searched.
+     */
+    void flush_directory_cache ();
+
+    /**
+     * Find the file given a container of paths and file names. The search
+     * paths are checked with the directory cache.
      *
      * @param path The path of the file if found else empty.
      * @param name The name of the file to search for.
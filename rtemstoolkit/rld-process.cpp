@@ -29,6 +29,17 @@
 #include <sys/wait.h>
 #endif
 
+#if HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
+
+#if HAVE_POSIX_SPAWN
+#include <poll.h>
+#include <spawn.h>
+
+extern char** environ;
+#endif
+
 #ifndef WIFEXITED
 #define WIFEXITED(S) (((S) & 0xff) == 0)
 #endif
@@ -95,6 +106,7 @@ namespace rld
     const std::string
     temporary_files::get (const std::string& suffix, bool keep)
     {
+      std::lock_guard < std::mutex > guard (lock);
       char* temp = ::make_temp_file (suffix.c_str ());
 
       if (!temp)
@@ -121,6 +133,7 @@ namespace rld
     void
     temporary_files::erase (const std::string& name)
     {
+      std::lock_guard < std::mutex > guard (lock);
       for (tempfile_container::iterator tfi = tempfiles.begin ();
            tfi != tempfiles.end ();
            ++tfi)
@@ -137,6 +150,7 @@ namespace rld
     void
     temporary_files::keep (const std::string& name)
     {
+      std::lock_guard < std::mutex > guard (lock);
       for (tempfile_container::iterator tfi = tempfiles.begin ();
            tfi != tempfiles.end ();
            ++tfi)
@@ -160,12 +174,29 @@ namespace rld
       }
     }
 
-    tempfile::tempfile (const std::string& suffix, bool _keep)
+    tempfile::tempfile (const std::string& suffix, bool _keep, bool memory)
       : suffix (suffix),
         overridden (false),
         fd (-1),
+        memfd (-1),
         level (0)
     {
+#if HAVE_MEMFD_CREATE
+      if (memory && !_keep && !keep_temporary_files)
+      {
+        /*
+         * The descriptor is closed on exec, a process writes the file by
+         * opening the descriptor's path.
+         */
+        memfd = ::memfd_create (("rld" + suffix).c_str (), MFD_CLOEXEC);
+        if (memfd >= 0)
+        {
+          _name = "/proc/" + std::to_string (::getpid ()) +
+            "/fd/" + std::to_string (memfd);
+          return;
+        }
+      }
+#endif
       _name = temporaries.get (suffix, _keep);
     }
 
@@ -174,7 +205,10 @@ namespace rld
       try
       {
         close ();
-        temporaries.erase (_name);
+        if (memfd >= 0)
+          ::close (memfd);
+        else
+          temporaries.erase (_name);
       }
       catch (...)
       {
@@ -223,7 +257,13 @@ namespace rld
     {
       if (fd >= 0)
         throw rld::error ("Already open", "tempfile override");
-      rld::path::unlink (_name);
+      if (memfd >= 0)
+      {
+        ::close (memfd);
+        memfd = -1;
+      }
+      else
+        rld::path::unlink (_name);
       overridden = true;
       _name = name_ + suffix;
     }
@@ -231,7 +271,14 @@ namespace rld
     void
     tempfile::keep ()
     {
-      temporaries.keep (_name);
+      if (memfd < 0)
+        temporaries.keep (_name);
+    }
+
+    bool
+    tempfile::in_memory () const
+    {
+      return memfd >= 0;
     }
 
     const std::string&
@@ -256,22 +303,42 @@ namespace rld
     void
     tempfile::read (std::string& all)
     {
+      /*
+       * Read directly into the string, the first read is sized to the file
+       * so it is normally read in one call.
+       */
+      const size_t block = 64 * 1024;
+
       all.clear ();
       if (fd != -1)
       {
+        size_t      chunk = block;
+        struct stat sb;
+        if ((::fstat (fd, &sb) == 0) && (sb.st_size > 0))
+          chunk = sb.st_size + 1;
         if (level)
           all.append (buf, level);
         level = 0;
+        size_t length = all.size ();
         while (true)
         {
-          int read = ::read (fd, buf, sizeof (buf) );
+          if (all.size () == length)
+          {
+            all.resize (length + chunk);
+            chunk = block;
+          }
+          ssize_t read = ::read (fd, &all[length], all.size () - length);
           if (read < 0)
+          {
+            all.resize (length);
             throw rld::error (::strerror (errno), "tempfile get read:" + _name);
+          }
           else if (read == 0)
             break;
           else
-            all.append (buf, read);
+            length += read;
         }
+        all.resize (length);
       }
     }
 
@@ -313,6 +380,14 @@ namespace rld
       }
     }
 
+    void
+    tempfile::view (rld::files::view& contents)
+    {
+      if (fd < 0)
+        open ();
+      contents.open (fd, _name, rld::files::view::sequential);
+    }
+
     void
     tempfile::write (const std::string& s)
     {
@@ -416,19 +491,103 @@ namespace rld
       return execute (pname, args, outname, errname);
     }
 
-    status
-    execute (const std::string&   pname,
-             const arg_container& args,
-             const std::string&   outname,
-             const std::string&   errname)
+    /*
+     * Convert the wait status of a process to a status.
+     */
+    static status
+    make_status (const std::string& name, int s)
+    {
+      status _status;
+
+      if (rld::verbose (RLD_VERBOSE_TRACE))
+        std::cout << "execute: status: ";
+
+      if (WIFEXITED (s))
+      {
+        _status.type = status::normal;
+        _status.code = WEXITSTATUS (s);
+        if (rld::verbose (RLD_VERBOSE_TRACE))
+          std::cout << _status.code << std::endl;
+      }
+      else if (WIFSIGNALED (s))
+      {
+        _status.type = status::signal;
+        _status.code = WTERMSIG (s);
+        if (rld::verbose (RLD_VERBOSE_TRACE))
+          std::cout << "signal: " << _status.code << std::endl;
+      }
+      else if (WIFSTOPPED (s))
+      {
+        _status.type = status::stopped;
+        _status.code = WSTOPSIG (s);
+        if (rld::verbose (RLD_VERBOSE_TRACE))
+          std::cout << "stopped: " << _status.code << std::endl;
+      }
+      else
+        throw rld::error ("execute: " + name, "unknown status returned");
+
+      return _status;
+    }
+
+#if HAVE_POSIX_SPAWN
+    /*
+     * Wait for a child process and return the wait status.
+     */
+    static int
+    wait_child (const std::string& name, pid_t pid)
+    {
+      int s = 0;
+      while (::waitpid (pid, &s, 0) < 0)
+      {
+        if (errno != EINTR)
+          throw rld::error (::strerror (errno), "execute: wait: " + name);
+      }
+      return s;
+    }
+
+    /*
+     * Create a pipe that is closed in the child processes so a process does
+     * not hold open the pipe of another process spawned at the same time.
+     */
+    static void
+    make_pipe (int fds[2], const std::string& name)
+    {
+#if HAVE_PIPE2
+      if (::pipe2 (fds, O_CLOEXEC) < 0)
+        throw rld::error (::strerror (errno), "execute: pipe: " + name);
+#else
+      if (::pipe (fds) < 0)
+        throw rld::error (::strerror (errno), "execute: pipe: " + name);
+      ::fcntl (fds[0], F_SETFD, FD_CLOEXEC);
+      ::fcntl (fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+    }
+#endif
+
+    /*
+     * Trace the arguments of a process being executed.
+     */
+    static void
+    trace_args (const char* label, const arg_container& args)
     {
       if (rld::verbose (RLD_VERBOSE_TRACE))
       {
-        std::cout << "execute: ";
+        std::cout << label;
         for (size_t a = 0; a < args.size (); ++a)
           std::cout << args[a] << ' ';
         std::cout << std::endl;
       }
+    }
+
+    status
+    execute (const std::string&   pname,
+             const arg_container& args,
+             const std::string&   outname,
+             const std::string&   errname)
+    {
+      trace_args ("execute: ", args);
+
+      rld::span span (rld::path::basename (args[0]), "process");
 
       const char** cargs = new const char* [args.size () + 1];
 
@@ -436,6 +595,43 @@ namespace rld
         cargs[a] = args[a].c_str ();
       cargs[args.size ()] = 0;
 
+#if HAVE_POSIX_SPAWN
+      /*
+       * The child is spawned without copying the page tables of the parent
+       * which can be large when linking or analysing big executables.
+       */
+      posix_spawn_file_actions_t actions;
+      ::posix_spawn_file_actions_init (&actions);
+
+      if (!outname.empty ())
+        ::posix_spawn_file_actions_addopen (&actions,
+                                            STDOUT_FILENO,
+                                            outname.c_str (),
+                                            O_WRONLY | O_CREAT | O_TRUNC | OPEN_FLAGS,
+                                            CREATE_MODE);
+      if (!errname.empty ())
+        ::posix_spawn_file_actions_addopen (&actions,
+                                            STDERR_FILENO,
+                                            errname.c_str (),
+                                            O_WRONLY | O_CREAT | O_TRUNC | OPEN_FLAGS,
+                                            CREATE_MODE);
+
+      pid_t pid = 0;
+      int   err = ::posix_spawnp (&pid,
+                                  args[0].c_str (),
+                                  &actions,
+                                  0,
+                                  (char* const*) cargs,
+                                  environ);
+
+      ::posix_spawn_file_actions_destroy (&actions);
+      delete [] cargs;
+
+      if (err)
+        throw rld::error (::strerror (err), pname + ": execute: " + args[0]);
+
+      return make_status (args[0], wait_child (args[0], pid));
+#else
       int err = 0;
       int s = 0;
 
@@ -455,36 +651,391 @@ namespace rld
       else if (err)
         throw rld::error ("execute: " + args[0], ::strerror (err));
 
-      status _status;
+      return make_status (args[0], s);
+#endif
+    }
 
-      if (rld::verbose (RLD_VERBOSE_TRACE))
-        std::cout << "execute: status: ";
+    status
+    execute (const arg_container& args,
+             std::string&         out,
+             std::string&         err)
+    {
+      spawner s;
+      s.run (args);
+      s.wait ();
+      out = s.get_out (0);
+      err = s.get_err (0);
+      return s.get_status (0);
+    }
 
-      if (WIFEXITED (s))
+    spawner::spawner (unsigned int jobs)
+      : jobs (jobs == 0 ? 1 : jobs),
+        buffer (64 * 1024)
+    {
+    }
+
+    spawner::~spawner ()
+    {
+      try
       {
-        _status.type = status::normal;
-        _status.code = WEXITSTATUS (s);
-        if (rld::verbose (RLD_VERBOSE_TRACE))
-          std::cout << _status.code << std::endl;
+        wait ();
       }
-      else if (WIFSIGNALED (s))
+      catch (...)
       {
-        _status.type = status::signal;
-        _status.code = WTERMSIG (s);
-        if (rld::verbose (RLD_VERBOSE_TRACE))
-          std::cout << "signal: " << _status.code << std::endl;
       }
-      else if (WIFSTOPPED (s))
+#if HAVE_POSIX_SPAWN
+      for (auto r : running)
       {
-        _status.type = status::stopped;
-        _status.code = WSTOPSIG (s);
-        if (rld::verbose (RLD_VERBOSE_TRACE))
-          std::cout << "stopped: " << _status.code << std::endl;
+        child& c = children[r];
+        for (auto& fd : c.fds)
+        {
+          if (fd >= 0)
+            ::close (fd);
+          fd = -1;
+        }
+        int s;
+        if (c.pid > 0)
+          ::waitpid (c.pid, &s, 0);
       }
-      else
-        throw rld::error ("execute: " + args[0], "unknown status returned");
+#endif
+    }
 
-      return _status;
+    size_t
+    spawner::run (const arg_container& args)
+    {
+      if (args.empty ())
+        throw rld::error ("no program", "spawner");
+
+      while (running.size () >= jobs)
+        service ();
+
+      child c;
+      c.args = args;
+      c.result.type = status::normal;
+      c.result.code = 0;
+      c.pid = -1;
+      c.fds[0] = -1;
+      c.fds[1] = -1;
+      c.finished = false;
+      c.started = rld::trace_clock ();
+
+      children.push_back (c);
+
+      const size_t index = children.size () - 1;
+
+      start (children[index]);
+
+      if (!children[index].finished)
+        running.push_back (index);
+
+      return index;
+    }
+
+    void
+    spawner::wait ()
+    {
+      while (!running.empty ())
+        service ();
+    }
+
+    size_t
+    spawner::size () const
+    {
+      return children.size ();
+    }
+
+    const status&
+    spawner::get_status (size_t index) const
+    {
+      return get (index).result;
+    }
+
+    const std::string&
+    spawner::get_out (size_t index) const
+    {
+      return get (index).out;
+    }
+
+    const std::string&
+    spawner::get_err (size_t index) const
+    {
+      return get (index).err;
+    }
+
+    const spawner::child&
+    spawner::get (size_t index) const
+    {
+      if (index >= children.size ())
+        throw rld::error ("invalid index", "spawner");
+      if (!children[index].finished)
+        throw rld::error ("not finished", "spawner: " + children[index].args[0]);
+      return children[index];
+    }
+
+#if HAVE_POSIX_SPAWN
+    void
+    spawner::start (child& c)
+    {
+      trace_args ("execute: spawn: ", c.args);
+
+      int out[2];
+      int err[2];
+
+      make_pipe (out, c.args[0]);
+      try
+      {
+        make_pipe (err, c.args[0]);
+      }
+      catch (...)
+      {
+        ::close (out[0]);
+        ::close (out[1]);
+        throw;
+      }
+
+      posix_spawn_file_actions_t actions;
+      ::posix_spawn_file_actions_init (&actions);
+      ::posix_spawn_file_actions_adddup2 (&actions, out[1], STDOUT_FILENO);
+      ::posix_spawn_file_actions_adddup2 (&actions, err[1], STDERR_FILENO);
+
+      const char** cargs = new const char* [c.args.size () + 1];
+
+      for (size_t a = 0; a < c.args.size (); ++a)
+        cargs[a] = c.args[a].c_str ();
+      cargs[c.args.size ()] = 0;
+
+      pid_t pid = 0;
+      int   serr = ::posix_spawnp (&pid,
+                                   c.args[0].c_str (),
+                                   &actions,
+                                   0,
+                                   (char* const*) cargs,
+                                   environ);
+
+      ::posix_spawn_file_actions_destroy (&actions);
+      delete [] cargs;
+
+      ::close (out[1]);
+      ::close (err[1]);
+
+      if (serr)
+      {
+        ::close (out[0]);
+        ::close (err[0]);
+        throw rld::error (::strerror (serr), "execute: " + c.args[0]);
+      }
+
+      c.pid = pid;
+      c.fds[0] = out[0];
+      c.fds[1] = err[0];
+    }
+
+    void
+    spawner::service ()
+    {
+      std::vector < struct pollfd > fds;
+      std::vector < size_t >        owners;
+
+      for (auto r : running)
+      {
+        for (int f = 0; f < 2; ++f)
+        {
+          if (children[r].fds[f] >= 0)
+          {
+            struct pollfd pfd;
+            pfd.fd = children[r].fds[f];
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            fds.push_back (pfd);
+            owners.push_back (r * 2 + f);
+          }
+        }
+      }
+
+      if (!fds.empty ())
+      {
+        if (::poll (fds.data (), fds.size (), -1) < 0)
+        {
+          if (errno == EINTR)
+            return;
+          throw rld::error (::strerror (errno), "execute: poll");
+        }
+
+        for (size_t p = 0; p < fds.size (); ++p)
+        {
+          if (fds[p].revents != 0)
+          {
+            child&       c = children[owners[p] / 2];
+            int&         fd = c.fds[owners[p] % 2];
+            std::string& capture = (owners[p] % 2) == 0 ? c.out : c.err;
+            ssize_t      r = ::read (fd, buffer.data (), buffer.size ());
+            if (r > 0)
+              capture.append (buffer.data (), r);
+            else if (r == 0)
+            {
+              ::close (fd);
+              fd = -1;
+            }
+            else if (errno != EINTR)
+              throw rld::error (::strerror (errno), "execute: read: " + c.args[0]);
+          }
+        }
+      }
+
+      /*
+       * A child is reaped once both of its pipes are closed.
+       */
+      for (auto ri = running.begin (); ri != running.end (); )
+      {
+        child& c = children[*ri];
+        if ((c.fds[0] < 0) && (c.fds[1] < 0))
+        {
+          c.result = make_status (c.args[0], wait_child (c.args[0], c.pid));
+          if (rld::trace_events_enabled ())
+            rld::trace_event (rld::path::basename (c.args[0]), "process",
+                              c.started, rld::trace_clock (),
+                              rld::join (c.args, " "), c.pid);
+          c.pid = -1;
+          c.finished = true;
+          ri = running.erase (ri);
+        }
+        else
+          ++ri;
+      }
+    }
+#else
+    void
+    spawner::start (child& c)
+    {
+      /*
+       * Without posix_spawn the process is run to completion with its output
+       * captured in temporary files.
+       */
+      tempfile out;
+      tempfile err;
+
+      c.result = execute (c.args[0], c.args, out.name (), err.name ());
+
+      out.open ();
+      out.read (c.out);
+      out.close ();
+      err.open ();
+      err.read (c.err);
+      err.close ();
+
+      c.finished = true;
+    }
+
+    void
+    spawner::service ()
+    {
+    }
+#endif
+
+    pipe::pipe ()
+      : pex (0),
+        out (0)
+    {
+    }
+
+    pipe::~pipe ()
+    {
+      if (pex)
+        ::pex_free (pex);
+    }
+
+    void
+    pipe::open (const std::string&   pname,
+                const arg_container& args,
+                const std::string&   errname)
+    {
+      if (pex)
+        throw rld::error ("already open", "pipe: " + program);
+
+      trace_args ("execute: pipe: ", args);
+
+      program = args[0];
+
+      pex = ::pex_init (PEX_USE_PIPES, pname.c_str (), 0);
+      if (!pex)
+        throw rld::error ("pex_init failed", "pipe: " + program);
+
+      const char** cargs = new const char* [args.size () + 1];
+
+      for (size_t a = 0; a < args.size (); ++a)
+        cargs[a] = args[a].c_str ();
+      cargs[args.size ()] = 0;
+
+      int err = 0;
+
+      const char* serr = ::pex_run (pex,
+                                    PEX_SEARCH,
+                                    args[0].c_str (),
+                                    (char* const*) cargs,
+                                    0,
+                                    errname.c_str (),
+                                    &err);
+
+      delete [] cargs;
+
+      if (!serr)
+      {
+        out = ::pex_read_output (pex, 0);
+        if (!out)
+        {
+          serr = "pex_read_output";
+          err = errno;
+        }
+      }
+
+      if (serr)
+      {
+        ::pex_free (pex);
+        pex = 0;
+        out = 0;
+        if (err)
+          throw rld::error (::strerror (err), std::string (serr) + ": " + program);
+        throw rld::error ("execute: " + program, serr);
+      }
+    }
+
+    void
+    pipe::read_line (std::string& line)
+    {
+      line.clear ();
+      if (out)
+      {
+        while (::fgets (buf, sizeof (buf), out))
+        {
+          line.append (buf);
+          if (line[line.size () - 1] == '\n')
+            break;
+        }
+        if (::ferror (out))
+          throw rld::error (::strerror (errno), "pipe read: " + program);
+      }
+    }
+
+    status
+    pipe::close ()
+    {
+      if (!pex)
+        throw rld::error ("not open", "pipe: " + program);
+
+      while (::fgets (buf, sizeof (buf), out))
+        ;
+
+      int s = 0;
+      int ok = ::pex_get_status (pex, 1, &s);
+
+      ::pex_free (pex);
+      pex = 0;
+      out = 0;
+
+      if (!ok)
+        throw rld::error (::strerror (errno), "pipe status: " + program);
+
+      return make_status (program, s);
     }
 
     /*
@@ -26,10 +26,14 @@
 #define _RLD_PEX_H_
 
 #include <list>
+#include <mutex>
+#include <stdio.h>
 #include <string>
 #include <vector>
 #include "rld.h"
 
+struct pex_obj;
+
 namespace rld
 {
   namespace process
@@ -99,6 +103,7 @@ namespace rld
       void unlink (const tempfile_ref& ref);
 
       tempfile_container tempfiles; //< The temporary files.
+      std::mutex         lock;      //< Tempfiles can be created on threads.
 
     };
 
@@ -110,9 +115,16 @@ namespace rld
     public:
 
       /**
-       * Get a temporary file name given a suffix.
+       * Get a temporary file name given a suffix. A temporary file in memory
+       * is an anonymous memory file if the host has memfd_create and its name
+       * is the path of its file descriptor in /proc so a process can write
+       * it by name. A file in memory has no suffix and cannot be kept so it
+       * is a file in the temporary directory if it is kept or the host has no
+       * memory files.
        */
-      tempfile (const std::string& suffix = ".rldxx", bool keep = false);
+      tempfile (const std::string& suffix = ".rldxx",
+                bool               keep = false,
+                bool               memory = false);
 
       /**
        * Clean up the temporary file.
@@ -136,10 +148,16 @@ namespace rld
       void override (const std::string& name);
 
       /**
-       * Set the temp file keep state to true so it is not deleted.
+       * Set the temp file keep state to true so it is not deleted. A file in
+       * memory is not kept.
        */
       void keep ();
 
+      /**
+       * Is the temp file in memory?
+       */
+      bool in_memory () const;
+
       /**
        * The name of the temp file.
        */
@@ -160,6 +178,13 @@ namespace rld
        */
       void read_line (std::string& line);
 
+      /**
+       * View the file's contents mapped into memory if the host can map the
+       * file. The file is opened if it is not open. The view is valid until
+       * the file is written or closed.
+       */
+      void view (rld::files::view& contents);
+
       /**
        * Write the string to the file.
        */
@@ -193,7 +218,8 @@ namespace rld
       const std::string suffix;     //< The temp file's suffix.
       bool              overridden; //< The name is overridden; may no exist.
       int               fd;         //< The file descriptor
-      char              buf[256];   //< The read buffer.
+      int               memfd;      //< The memory file or -1.
+      char              buf[256];   //< The line read buffer.
       size_t            level;      //< The level of data in the buffer.
     };
 
@@ -251,6 +277,163 @@ namespace rld
                     const std::string& outname,
                     const std::string& errname);
 
+    /**
+     * Execute a process and capture stdout and stderr in memory. The first
+     * element is the program name to run. Return an error code.
+     */
+    status execute (const arg_container& args,
+                    std::string&         out,
+                    std::string&         err);
+
+    /**
+     * Spawn processes and capture their stdout and stderr in memory through
+     * pipes. Up to the job limit of processes run at once and a process run
+     * when the limit is reached is started when a running process
+     * finishes. The processes are referenced by the index returned when run.
+     * A spawner is used by one thread.
+     */
+    class spawner
+    {
+    public:
+
+      /**
+       * Construct a spawner that runs up to the jobs number of processes.
+       */
+      spawner (unsigned int jobs = 1);
+
+      /**
+       * Wait for any process still running.
+       */
+      ~spawner ();
+
+      /**
+       * Run the process. The first element of the arguments is the program
+       * name to run. The call blocks while the job limit of processes are
+       * running. Return the process's index.
+       */
+      size_t run (const arg_container& args);
+
+      /**
+       * Wait for all the processes to finish.
+       */
+      void wait ();
+
+      /**
+       * The number of processes run.
+       */
+      size_t size () const;
+
+      /**
+       * The status of a finished process.
+       */
+      const status& get_status (size_t index) const;
+
+      /**
+       * The stdout of a finished process.
+       */
+      const std::string& get_out (size_t index) const;
+
+      /**
+       * The stderr of a finished process.
+       */
+      const std::string& get_err (size_t index) const;
+
+    private:
+
+      /*
+       * A process.
+       */
+      struct child
+      {
+        arg_container args;     //< The process's arguments.
+        status        result;   //< The status once finished.
+        std::string   out;      //< The captured stdout.
+        std::string   err;      //< The captured stderr.
+        int           pid;      //< The process id while running.
+        int           fds[2];   //< The stdout and stderr pipes while running.
+        bool          finished; //< The process has finished.
+        uint64_t      started;  //< The trace clock when started.
+      };
+
+      /*
+       * The spawner cannot be copied.
+       */
+      spawner (const spawner&);
+      spawner& operator= (const spawner&);
+
+      /*
+       * Start a child.
+       */
+      void start (child& c);
+
+      /*
+       * Wait for output from the running children and reap any that have
+       * finished.
+       */
+      void service ();
+
+      /*
+       * Check the index references a finished child.
+       */
+      const child& get (size_t index) const;
+
+      const unsigned int     jobs;     //< The number of processes at once.
+      std::vector < child >  children; //< The processes run.
+      std::vector < size_t > running;  //< The indexes of the running children.
+      std::vector < char >   buffer;   //< The pipe read buffer.
+    };
+
+    /**
+     * Execute a process and read its stdout through a pipe while it runs. The
+     * stderr is captured in a file.
+     */
+    class pipe
+    {
+    public:
+
+      /**
+       * Construct a pipe with no process.
+       */
+      pipe ();
+
+      /**
+       * Close the pipe waiting for the process if it has not been closed.
+       */
+      ~pipe ();
+
+      /**
+       * Execute the process. The first element of the arguments is the
+       * program name to run.
+       */
+      void open (const std::string&   pname,
+                 const arg_container& args,
+                 const std::string&   errname);
+
+      /**
+       * Read a line at a time. The line is empty at the end of the output.
+       */
+      void read_line (std::string& line);
+
+      /**
+       * Wait for the process to finish and return its status. Any output not
+       * read is discarded.
+       */
+      status close ();
+
+    private:
+
+      /*
+       * The pipe cannot be copied.
+       */
+      pipe (const pipe&);
+      pipe& operator= (const pipe&);
+
+      std::string program; //< The program name.
+      pex_obj*    pex;     //< The process executing.
+      FILE*       out;     //< The process's stdout.
+      char        buf[256]; //< The read buffer.
+    };
+
     /**
      * Parse a command line into arguments. It support quoting.
      */
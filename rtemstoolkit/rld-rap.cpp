@@ -30,12 +30,19 @@
 #include <string.h>
 
 #include <algorithm>
+#include <fstream>
 #include <list>
 #include <iomanip>
+#include <sstream>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 #include <rld.h>
 #include <rld-compression.h>
 #include <rld-rap.h>
+#include <rld-tasks.h>
 
 namespace rld
 {
@@ -52,6 +59,36 @@ namespace rld
      */
     std::string rpath;
 
+    /**
+     * Merge the tails of the string table's strings.
+     */
+    bool merge_strings = false;
+
+    /**
+     * Remove the unreferenced split sections.
+     */
+    bool gc_sections = false;
+
+    /**
+     * The symbol order.
+     */
+    rld::strings symbol_order;
+
+    /**
+     * Write the compact relocation encoding.
+     */
+    bool compact_relocs = false;
+
+    /**
+     * The fixed load addresses.
+     */
+    std::map < int, uint32_t > load_addresses;
+
+    /**
+     * The page size of the directly mapped sections.
+     */
+    uint32_t direct_page_size = 0;
+
     /**
      * The names of the RAP sections.
      */
@@ -78,6 +115,7 @@ namespace rld
       int         symsect;   //< The symbol's RAP section.
       uint32_t    symvalue;  //< The symbol's default value.
       uint32_t    symbinding;//< The symbol's binding.
+      bool        fixed;     //< Applied at the fixed load addresses.
 
       /**
        * Construct the relocation using the file relocation, the offset of the
@@ -294,11 +332,30 @@ namespace rld
        */
       object (const object& orig);
 
+      /**
+       * Merge the object file's sections into the RAP sections.
+       */
+      void merge ();
+
       /**
        * Find the section type that matches the section index.
        */
       sections find (const uint32_t index) const;
 
+      /**
+       * Is the section index one of the sections that goes into the RAP
+       * sections?
+       */
+      bool contains (const uint32_t index) const;
+
+      /**
+       * Remove the split sections that are not live.
+       *
+       * @param live The indexes of the live sections.
+       * @return size_t The size of the sections removed.
+       */
+      size_t remove_unreferenced (const std::set < int >& live);
+
       /**
        * The total number of relocations in the object file.
        */
@@ -327,6 +384,8 @@ namespace rld
      */
     typedef std::list < object > objects;
 
+    class reloc_buffer;
+
     /**
      * The RAP image.
      */
@@ -349,6 +408,27 @@ namespace rld
                    const std::string&        init,
                    const std::string&        fini);
 
+      /**
+       * Remove the split sections that cannot be reached from the roots
+       * through the relocations.
+       *
+       * @param init The initialisation entry point label.
+       * @param fini The finish entry point label.
+       */
+      void collect_garbage (const std::string& init, const std::string& fini);
+
+      /**
+       * Order the code sections of the object files and the object files by
+       * the symbol order.
+       */
+      void order_code ();
+
+      /**
+       * Apply the relocations between the RAP sections with a fixed load
+       * address. The applied relocations are not written.
+       */
+      void fix_relocations ();
+
       /**
        * Collection the symbols from the object file.
        *
@@ -361,8 +441,9 @@ namespace rld
        * interface.
        *
        * @param comp The compressor.
+       * @param jobs The number of threads used to encode the relocations.
        */
-      void write (compress::compressor& comp);
+      void write (compress::compressor& comp, unsigned int jobs = 1);
 
       /**
        * Write the RAP section to the compressed output file given the object files.
@@ -381,13 +462,26 @@ namespace rld
        * @param comp The compressor.
        * @param obj The object file the sections are part of.
        * @param secs The container of file sections to write.
+       * @param sec The RAP section the file sections are part of.
        * @param offset The current offset in the RAP section.
        */
       void write (compress::compressor&  comp,
                   files::object&         obj,
                   const files::sections& secs,
+                  sections               sec,
                   uint32_t&              offset);
 
+      /**
+       * Write the directly mapped sections uncompressed after the compressed
+       * image. The first section is on the first page after the compressed
+       * image.
+       *
+       * @param app The application image positioned after the compressed
+       *            image.
+       * @param length The length of the header and compressed image.
+       */
+      void write_direct (files::image& app, uint32_t length);
+
       /**
        * Write the external symbols.
        */
@@ -395,8 +489,19 @@ namespace rld
 
       /**
        * Write the relocation records for all the object files.
+       *
+       * @param comp The compressor.
+       * @param jobs The number of RAP sections encoded in parallel.
        */
-      void write_relocations (compress::compressor& comp);
+      void write_relocations (compress::compressor& comp, unsigned int jobs);
+
+      /**
+       * Encode the relocation records of a RAP section.
+       *
+       * @param sec The RAP section.
+       * @param out The buffer the records are encoded into.
+       */
+      void encode_relocations (int sec, reloc_buffer& out) const;
 
       /**
        * Write the details of the files.
@@ -420,12 +525,60 @@ namespace rld
       uint32_t section_size (sections sec) const;
 
       /**
-       * Find a symbol name in the string table.
+       * Find a symbol name in the string table. The name can be a string in
+       * the table or the tail of one.
+       */
+      std::size_t find_in_strtab (const std::string& symname) const;
+
+      /**
+       * Find a string with its hash in the string table.
+       */
+      std::size_t find_in_strtab (const char* name,
+                                  size_t      size,
+                                  uint64_t    hash) const;
+
+      /**
+       * Add a string to the end of the string table and index it and its
+       * tails.
+       *
+       * @param name The string to add.
+       * @return uint32_t The offset of the string.
+       */
+      uint32_t add_to_strtab (const std::string& name);
+
+      /**
+       * Add the strings to the string table ordered so a string that is the
+       * tail of another string is found in the other string.
+       *
+       * @param names The strings to add.
        */
-      std::size_t find_in_strtab (const std::string& symname);
+      void merge_into_strtab (rld::strings& names);
 
     private:
 
+      /**
+       * The index of the strings and the tails of the strings in the string
+       * table. The key is a hash of the string and the value is the offset
+       * of the first place the string is in the table.
+       */
+      typedef std::unordered_multimap < uint64_t, uint32_t > strtab_index;
+
+      /**
+       * A relocation applied at the fixed load addresses. The value is
+       * added to the data in the section when the relocation records do
+       * not have addends.
+       */
+      struct fixup
+      {
+        uint32_t value;  //< The value written to the section.
+        bool     add;    //< Add the value to the section's data.
+      };
+
+      /**
+       * The fixups of a RAP section keyed by the offset in the section.
+       */
+      typedef std::map < uint32_t, fixup > fixups;
+
       objects     objs;                //< The RAP objects
       uint32_t    sec_size[rap_secs];  //< The sections of interest.
       uint32_t    sec_align[rap_secs]; //< The sections of interest.
@@ -433,11 +586,45 @@ namespace rld
       externals   externs;             //< The symbols in the image
       uint32_t    symtab_size;         //< The size of the symbols.
       std::string strtab;              //< The strings table.
+      strtab_index strtab_offsets;     //< The strings in the string table.
       uint32_t    relocs_size;         //< The relocations size.
       uint32_t    init_off;            //< The strtab offset to the init label.
       uint32_t    fini_off;            //< The strtab offset to the fini label.
+      fixups      sec_fixups[rap_secs];//< The relocations applied.
+      uint32_t    sec_file_off[rap_secs]; //< The directly mapped offsets.
     };
 
+    /**
+     * The string table hash of a string. The hash of a tail can be found from
+     * the hash of a shorter tail so the hashes of all the tails of a string
+     * are found in one pass.
+     */
+    static const uint64_t strtab_hash_prime = 1099511628211ULL;
+
+    static uint64_t
+    strtab_hash (const std::string& name)
+    {
+      uint64_t hash = 0;
+      for (size_t c = 0; c < name.size (); ++c)
+        hash = (hash * strtab_hash_prime) + (uint8_t) name[c];
+      return hash;
+    }
+
+    /**
+     * Is the RAP section directly mapped?
+     */
+    static bool
+    direct_section (int sec)
+    {
+      return (direct_page_size != 0) && ((sec == rap_text) || (sec == rap_const));
+    }
+
+    static uint32_t
+    page_align (uint32_t offset)
+    {
+      return (offset + direct_page_size - 1) & ~(direct_page_size - 1);
+    }
+
     /*
      * Per machine specific special handling.
      */
@@ -461,6 +648,25 @@ namespace rld
       return true;
     }
 
+    /**
+     * Is the symbol an external symbol of the RAP image?
+     */
+    static bool
+    external_symbol (const symbols::symbol& sym)
+    {
+      if ((sym.type () == STT_OBJECT) || (sym.type () == STT_FUNC) || (sym.type () == STT_NOTYPE))
+      {
+        if ((sym.binding () == STB_GLOBAL) || (sym.binding () == STB_WEAK))
+        {
+          /*
+           * Do not noting if the symbol is reject at the machine level.
+           */
+          return machine_symbol_check (sym);
+        }
+      }
+      return false;
+    }
+
     bool
     machine_relocation_check (const files::relocation& reloc)
     {
@@ -524,7 +730,8 @@ namespace rld
         symtype (reloc.symtype),
         symsect (reloc.symsect),
         symvalue (reloc.symvalue),
-        symbinding (reloc.symbinding)
+        symbinding (reloc.symbinding),
+        fixed (false)
     {
     }
 
@@ -794,6 +1001,16 @@ namespace rld
                     << " reloc.symsect=" << freloc.symsect
                     << " reloc.symbinding=" << freloc.symbinding
                     << std::endl;
+        /*
+         * An unwind table entry for removed code has nothing to relocate
+         * against. The entry describes no code that can run.
+         */
+        if (merge_reloc && gc_sections && (freloc.symsect != 0) &&
+            ((freloc.symtype == STT_SECTION) ||
+             (freloc.symbinding == STB_LOCAL)) &&
+            !obj.contains (freloc.symsect))
+          merge_reloc = false;
+
         if (merge_reloc)
           sec.relocs.push_back (relocation (freloc, offset));
       }
@@ -865,7 +1082,11 @@ namespace rld
       obj.get_sections (bss,    SHT_NOBITS,   SHF_ALLOC | SHF_WRITE);
       obj.get_sections (symtab, SHT_SYMTAB);
       obj.get_sections (strtab, ".strtab");
+    }
 
+    void
+    object::merge ()
+    {
       std::for_each (text.begin (), text.end (),
                      section_merge (*this, secs[rap_text]));
       std::for_each (const_.begin (), const_.end (),
@@ -928,6 +1149,60 @@ namespace rld
                         "' not found: " + obj.name ().full (), "rap::object");
     }
 
+    bool
+    object::contains (const uint32_t index) const
+    {
+      return
+        files::find (text, index) || files::find (const_, index) ||
+        files::find (ctor, index) || files::find (dtor, index) ||
+        files::find (data, index) || files::find (bss, index);
+    }
+
+    /**
+     * A split section has the name of the section it is split from followed
+     * by the name of the function or data. Only these can be removed.
+     */
+    static bool
+    split_section (const files::section& sec)
+    {
+      static const char* prefixes[] = {
+        ".text.", ".rodata.", ".data.", ".bss.", ".sdata.", ".sbss.", 0
+      };
+      for (const char** p = prefixes; *p; ++p)
+        if (sec.name.compare (0, ::strlen (*p), *p) == 0)
+          return true;
+      return false;
+    }
+
+    static size_t
+    remove_sections (files::sections& secs, const std::set < int >& live)
+    {
+      size_t removed = 0;
+      for (files::sections::iterator si = secs.begin (); si != secs.end ();)
+      {
+        const files::section& sec = *si;
+        if (split_section (sec) && live.find (sec.index) == live.end ())
+        {
+          if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+            std::cout << "rap:gc-sections: remove: " << sec.name
+                      << " size=" << sec.size << std::endl;
+          removed += sec.size;
+          si = secs.erase (si);
+        }
+        else
+          ++si;
+      }
+      return removed;
+    }
+
+    size_t
+    object::remove_unreferenced (const std::set < int >& live)
+    {
+      return
+        remove_sections (text, live) + remove_sections (const_, live) +
+        remove_sections (data, live) + remove_sections (bss, live);
+    }
+
     uint32_t
     object::get_relocations () const
     {
@@ -987,6 +1262,40 @@ namespace rld
         objs.push_back (object (app_obj));
       }
 
+      if (gc_sections)
+        collect_garbage (init, fini);
+
+      if (!symbol_order.empty ())
+        order_code ();
+
+      for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+        (*oi).merge ();
+
+      /*
+       * Merging the strings adds all the strings before the symbols are
+       * collected.
+       */
+      if (merge_strings)
+      {
+        rld::strings names;
+        for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+        {
+          symbols::pointers& esyms = (*oi).obj.external_symbols ();
+          for (symbols::pointers::const_iterator ei = esyms.begin ();
+               ei != esyms.end ();
+               ++ei)
+          {
+            const symbols::symbol& sym = *(*ei);
+            if (external_symbol (sym) &&
+                (!gc_sections || (*oi).contains (sym.section_index ())))
+              names.push_back (sym.name ());
+          }
+        }
+        names.push_back (init);
+        names.push_back (fini);
+        merge_into_strtab (names);
+      }
+
       for (objects::iterator oi = objs.begin (), poi = objs.begin ();
            oi != objs.end ();
            ++oi)
@@ -1030,13 +1339,16 @@ namespace rld
           obj.output ();
       }
 
-      init_off = strtab.size () + 1;
-      strtab += '\0';
-      strtab += init;
-
-      fini_off = strtab.size () + 1;
-      strtab += '\0';
-      strtab += fini;
+      if (merge_strings)
+      {
+        init_off = find_in_strtab (init);
+        fini_off = find_in_strtab (fini);
+      }
+      else
+      {
+        init_off = add_to_strtab (init);
+        fini_off = add_to_strtab (fini);
+      }
 
       if (rld::verbose () >= RLD_VERBOSE_INFO)
       {
@@ -1058,139 +1370,601 @@ namespace rld
     }
 
     void
-    image::collect_symbols (object& obj)
+    image::collect_garbage (const std::string& init, const std::string& fini)
     {
-      symbols::pointers& esyms = obj.obj.external_symbols ();
-      for (symbols::pointers::const_iterator ei = esyms.begin ();
-           ei != esyms.end ();
-           ++ei)
-      {
-        const symbols::symbol& sym = *(*ei);
+      typedef std::pair < object*, int >                         osec_ref;
+      typedef std::unordered_multimap < std::string, osec_ref > definitions;
+
+      /*
+       * A reference by name can be to any definition of the name because
+       * the loader resolves it so all the definitions are kept.
+       */
+      definitions defs;
 
-        if ((sym.type () == STT_OBJECT) || (sym.type () == STT_FUNC) || (sym.type () == STT_NOTYPE))
+      for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+      {
+        object&            obj = *oi;
+        symbols::pointers& esyms = obj.obj.external_symbols ();
+        for (symbols::pointers::const_iterator ei = esyms.begin ();
+             ei != esyms.end ();
+             ++ei)
         {
-          if ((sym.binding () == STB_GLOBAL) || (sym.binding () == STB_WEAK))
-          {
-            int symsec = sym.section_index ();
+          const symbols::symbol& sym = *(*ei);
+          if (obj.contains (sym.section_index ()))
+            defs.insert (std::make_pair (sym.name (),
+                                         osec_ref (&obj, sym.section_index ())));
+        }
+      }
 
-            /*
-             * Do not noting if the symbol is reject at the machine level.
-             */
-            if (!machine_symbol_check (sym))
-              continue;
+      std::map < object*, std::set < int > > live;
+      std::vector < osec_ref >               pending;
+
+      /*
+       * The unwind tables reference all the code so a reference from them
+       * does not keep code. They keep the data they reference.
+       */
+      auto mark = [&] (object* obj, int index, bool code) {
+        if (obj->contains (index) &&
+            (code || !files::find (obj->text, index)) &&
+            live[obj].insert (index).second)
+          pending.push_back (osec_ref (obj, index));
+      };
+
+      auto mark_name = [&] (const std::string& name, bool code) {
+        std::pair < definitions::iterator, definitions::iterator > range =
+          defs.equal_range (name);
+        for (definitions::iterator di = range.first; di != range.second; ++di)
+          mark ((*di).second.first, (*di).second.second, code);
+      };
 
-            sections    rap_sec = obj.find (symsec);
-            section&    sec = obj.secs[rap_sec];
-            std::size_t name;
+      /*
+       * The roots are the sections that are not split, the constructors and
+       * destructors, and the entry and exit labels.
+       */
+      for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+      {
+        object& obj = *oi;
+        const files::sections* lists[] = {
+          &obj.text, &obj.const_, &obj.ctor, &obj.dtor, &obj.data, &obj.bss
+        };
+        for (size_t l = 0; l < sizeof (lists) / sizeof (lists[0]); ++l)
+        {
+          for (files::sections::const_iterator si = lists[l]->begin ();
+               si != lists[l]->end ();
+               ++si)
+          {
+            if (lists[l] == &obj.ctor || lists[l] == &obj.dtor ||
+                !split_section (*si))
+              mark (&obj, (*si).index, true);
+          }
+        }
+      }
 
-            /*
-             * See if the name is already in the string table.
-             */
-            name = find_in_strtab (sym.name ());
+      mark_name (init, true);
+      mark_name (fini, true);
 
-            if (name == std::string::npos)
-            {
-              name = strtab.size () + 1;
-              strtab += '\0';
-              strtab += sym.name ();
-            }
+      while (!pending.empty ())
+      {
+        osec_ref ref = pending.back ();
+        pending.pop_back ();
 
-            /*
-             * The symbol's value is the symbols value plus the offset of the
-             * object file's section offset in the RAP section.
-             */
-            externs.push_back (external (name,
-                                         rap_sec,
-                                         sec.offset + sec.osecs[symsec].offset +
-                                         sym.value (),
-                                         sym.info ()));
+        object&               obj = *ref.first;
+        const files::section& sec = obj.obj.get_section (ref.second);
+        bool                  code = sec.name != ".eh_frame";
 
-            symtab_size += external::rap_size;
-          }
+        for (files::relocations::const_iterator ri = sec.relocs.begin ();
+             ri != sec.relocs.end ();
+             ++ri)
+        {
+          const files::relocation& reloc = *ri;
+          if (reloc.symsect != 0)
+            mark (&obj, reloc.symsect, code);
+          if ((reloc.symtype != STT_SECTION) && (reloc.symbinding != STB_LOCAL))
+            mark_name (reloc.symname, code);
         }
       }
-    }
 
-    void
-    image::write (compress::compressor& comp)
-    {
-      /*
-       * Start with the machine type so the target can check the applicatiion
-       * is ok and can be loaded. Add the init and fini labels to the string
-       * table and add the references to the string table next. Follow this
-       * with the section details then the string table and symbol table then
-       * finally the relocation records.
-       */
+      size_t removed = 0;
+      for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+        removed += (*oi).remove_unreferenced (live[&(*oi)]);
 
       if (rld::verbose () >= RLD_VERBOSE_INFO)
-        std::cout << "rap:output: machine=" << comp.transferred () << std::endl;
+        std::cout << "rap:gc-sections: removed: " << removed << std::endl;
+    }
 
-      comp << elf::object_machine_type ()
-           << elf::object_datatype ()
-           << elf::object_class ();
+    /**
+     * The position of each symbol in the symbol order.
+     */
+    typedef std::unordered_map < std::string, size_t > symbol_ranks;
 
-      /*
-       * The init and fini label offsets. Then the symbol table and string
-       * table sizes.
-       */
+    static const size_t unranked = static_cast < size_t > (-1);
 
-      if (rld::verbose () >= RLD_VERBOSE_INFO)
-        std::cout << "rap:output: header=" << comp.transferred () << std::endl;
+    static void
+    make_ranks (symbol_ranks& ranks)
+    {
+      for (size_t s = 0; s < symbol_order.size (); ++s)
+        ranks.insert (std::make_pair (symbol_order[s], s));
+    }
 
-      comp << init_off
-           << fini_off
-           << symtab_size
-           << (uint32_t) strtab.size () + 1
-           << (uint32_t) 0;
+    static size_t
+    find_rank (const symbol_ranks& ranks, const std::string& name)
+    {
+      symbol_ranks::const_iterator ri = ranks.find (name);
+      if (ri == ranks.end ())
+        return unranked;
+      return (*ri).second;
+    }
 
-      /*
-       * Output file details
-       */
-      if (add_obj_details)
+    /**
+     * The rank of a code section is the rank of the first of its symbols in
+     * the order. A split code section's name has the name of its function
+     * which can be a local symbol, for example '.text.name' or
+     * '.text.hot.name'.
+     */
+    static void
+    section_ranks (const symbol_ranks&      ranks,
+                   files::object&           obj,
+                   const files::sections&   text,
+                   std::map < int, size_t >& secranks)
+    {
+      for (files::sections::const_iterator si = text.begin ();
+           si != text.end ();
+           ++si)
       {
-        write_details (comp);
+        const files::section& sec = *si;
+        size_t                rank = unranked;
+        if (sec.name.compare (0, 6, ".text.") == 0)
+        {
+          std::string func = sec.name.substr (6);
+          rank = find_rank (ranks, func);
+          size_t dot = func.find ('.');
+          if ((rank == unranked) && (dot != std::string::npos))
+            rank = find_rank (ranks, func.substr (dot + 1));
+        }
+        secranks[sec.index] = rank;
       }
-      else
+
+      symbols::pointers& esyms = obj.external_symbols ();
+      for (symbols::pointers::const_iterator ei = esyms.begin ();
+           ei != esyms.end ();
+           ++ei)
       {
-        comp << (uint32_t)0; /* No file details */
+        const symbols::symbol& sym = *(*ei);
+        std::map < int, size_t >::iterator sri =
+          secranks.find (sym.section_index ());
+        if (sri != secranks.end ())
+          (*sri).second = std::min ((*sri).second, find_rank (ranks, sym.name ()));
       }
+    }
 
-      /*
-       * The sections.
-       */
-      for (int s = 0; s < rap_secs; ++s)
-        comp << sec_size[s]
-             << sec_align[s];
+    void
+    image::order_code ()
+    {
+      symbol_ranks ranks;
+      make_ranks (ranks);
 
-      /*
-       * Output the sections from each object file.
-       */
-      write (comp, rap_text);
-      write (comp, rap_const);
-      write (comp, rap_ctor);
-      write (comp, rap_dtor);
-      write (comp, rap_data);
+      std::map < const object*, size_t > obj_ranks;
 
-      if (rld::verbose () >= RLD_VERBOSE_INFO)
-        std::cout << "rap:output: strtab=" << comp.transferred () << std::endl;
+      for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+      {
+        object&                  obj = *oi;
+        std::map < int, size_t > secranks;
+        size_t                   rank = unranked;
 
-      strtab += '\0';
-      comp << strtab;
+        section_ranks (ranks, obj.obj, obj.text, secranks);
 
-      if (rld::verbose () >= RLD_VERBOSE_INFO)
-        std::cout << "rap:output: symbols=" << comp.transferred () << std::endl;
+        obj.text.sort ([&secranks] (const files::section& lhs,
+                                    const files::section& rhs) {
+          return secranks.at (lhs.index) < secranks.at (rhs.index);
+        });
 
-      write_externals (comp);
+        for (std::map < int, size_t >::const_iterator sri = secranks.begin ();
+             sri != secranks.end ();
+             ++sri)
+          rank = std::min (rank, (*sri).second);
 
-      if (rld::verbose () >= RLD_VERBOSE_INFO)
-        std::cout << "rap:output: relocs=" << comp.transferred () << std::endl;
+        obj_ranks[&obj] = rank;
+      }
 
-      write_relocations (comp);
+      objs.sort ([&obj_ranks] (const object& lhs, const object& rhs) {
+        return obj_ranks.at (&lhs) < obj_ranks.at (&rhs);
+      });
+
+      if (rld::verbose () >= RLD_VERBOSE_DETAILS)
+      {
+        for (objects::const_iterator oi = objs.begin (); oi != objs.end (); ++oi)
+        {
+          const object& obj = *oi;
+          std::cout << "rap:order: " << obj.obj.name ().full () << ':';
+          for (files::sections::const_iterator si = obj.text.begin ();
+               si != obj.text.end ();
+               ++si)
+            std::cout << ' ' << (*si).name;
+          std::cout << std::endl;
+        }
+      }
+    }
+
+    void
+    load_symbol_order (const std::string& path)
+    {
+      std::ifstream in (path.c_str ());
+      if (!in.is_open ())
+        throw rld::error ("Cannot open: " + path, "rap:symbol-order");
+
+      symbol_order.clear ();
+
+      std::string line;
+      while (std::getline (in, line))
+      {
+        std::istringstream iss (line);
+        std::string        name;
+        if ((iss >> name) && (name[0] != '#'))
+          symbol_order.push_back (name);
+      }
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:symbol-order: " << path
+                  << ": symbols: " << symbol_order.size () << std::endl;
+    }
+
+    void
+    load_address_map (const std::string& path)
+    {
+      std::ifstream in (path.c_str ());
+      if (!in.is_open ())
+        throw rld::error ("Cannot open: " + path, "rap:load-address");
+
+      load_addresses.clear ();
+
+      std::string line;
+      while (std::getline (in, line))
+      {
+        std::istringstream iss (line);
+        std::string        name;
+        std::string        address;
+        if (!(iss >> name) || (name[0] == '#'))
+          continue;
+        int s;
+        for (s = 0; s < rap_secs; ++s)
+          if (name == section_names[s])
+            break;
+        if (s == rap_secs)
+          throw rld::error ("Invalid section: " + name, "rap:load-address");
+        char*         end = 0;
+        unsigned long value = 0;
+        if (iss >> address)
+          value = ::strtoul (address.c_str (), &end, 0);
+        if ((end == 0) || (*end != '\0') || (value >= RAP_ADDRESS_NONE))
+          throw rld::error ("Invalid address: " + name, "rap:load-address");
+        load_addresses[s] = value;
+      }
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:load-address: " << path
+                  << ": sections: " << load_addresses.size () << std::endl;
+    }
+
+    void
+    order_objects (files::object_list& objects)
+    {
+      if (symbol_order.empty ())
+        return;
+
+      symbol_ranks                       ranks;
+      std::map < files::object*, size_t > obj_ranks;
+
+      make_ranks (ranks);
+
+      for (files::object_list::iterator oi = objects.begin ();
+           oi != objects.end ();
+           ++oi)
+      {
+        files::object&     obj = *(*oi);
+        symbols::pointers& esyms = obj.external_symbols ();
+        size_t             rank = unranked;
+        for (symbols::pointers::const_iterator ei = esyms.begin ();
+             ei != esyms.end ();
+             ++ei)
+          rank = std::min (rank, find_rank (ranks, (*ei)->name ()));
+        obj_ranks[&obj] = rank;
+      }
+
+      objects.sort ([&obj_ranks] (files::object* lhs, files::object* rhs) {
+        return obj_ranks.at (lhs) < obj_ranks.at (rhs);
+      });
+    }
+
+    void
+    image::collect_symbols (object& obj)
+    {
+      symbols::pointers& esyms = obj.obj.external_symbols ();
+      for (symbols::pointers::const_iterator ei = esyms.begin ();
+           ei != esyms.end ();
+           ++ei)
+      {
+        const symbols::symbol& sym = *(*ei);
+
+        if (gc_sections && !obj.contains (sym.section_index ()))
+          continue;
+
+        if (external_symbol (sym))
+        {
+          int         symsec = sym.section_index ();
+          sections    rap_sec = obj.find (symsec);
+          section&    sec = obj.secs[rap_sec];
+          std::size_t name;
+
+          /*
+           * See if the name is already in the string table.
+           */
+          name = find_in_strtab (sym.name ());
+
+          if (name == std::string::npos)
+            name = add_to_strtab (sym.name ());
+
+          /*
+           * The symbol's value is the symbols value plus the offset of the
+           * object file's section offset in the RAP section.
+           */
+          externs.push_back (external (name,
+                                       rap_sec,
+                                       sec.offset + sec.osecs[symsec].offset +
+                                       sym.value (),
+                                       sym.info ()));
+
+          symtab_size += external::rap_size;
+        }
+      }
+    }
+
+    void
+    image::write (compress::compressor& comp, unsigned int jobs)
+    {
+      /*
+       * Start with the machine type so the target can check the applicatiion
+       * is ok and can be loaded. Add the init and fini labels to the string
+       * table and add the references to the string table next. Follow this
+       * with the section details then the string table and symbol table then
+       * finally the relocation records.
+       */
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:output: machine=" << comp.transferred () << std::endl;
+
+      if (!load_addresses.empty ())
+        fix_relocations ();
+
+      comp << elf::object_machine_type ()
+           << elf::object_datatype ()
+           << elf::object_class ();
+
+      /*
+       * The init and fini label offsets. Then the symbol table and string
+       * table sizes.
+       */
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:output: header=" << comp.transferred () << std::endl;
+
+      comp << init_off
+           << fini_off
+           << symtab_size
+           << (uint32_t) strtab.size () + 1
+           << (uint32_t) 0;
+
+      /*
+       * Output file details
+       */
+      if (add_obj_details)
+      {
+        write_details (comp);
+      }
+      else
+      {
+        comp << (uint32_t)0; /* No file details */
+      }
+
+      /*
+       * The sections.
+       */
+      for (int s = 0; s < rap_secs; ++s)
+        comp << sec_size[s]
+             << sec_align[s];
+
+      /*
+       * The fixed load addresses, a section without an address is placed by
+       * the loader.
+       */
+      if (!load_addresses.empty () || (direct_page_size != 0))
+      {
+        for (int s = 0; s < rap_secs; ++s)
+        {
+          std::map < int, uint32_t >::const_iterator lai = load_addresses.find (s);
+          if (lai == load_addresses.end ())
+            comp << (uint32_t) RAP_ADDRESS_NONE;
+          else
+            comp << lai->second;
+        }
+      }
+
+      /*
+       * The page size and the offsets of the directly mapped sections from
+       * the first page after the compressed image.
+       */
+      if (direct_page_size != 0)
+      {
+        uint32_t offset = 0;
+
+        comp << direct_page_size;
+
+        for (int s = 0; s < rap_secs; ++s)
+        {
+          if (direct_section (s))
+          {
+            if (sec_align[s] > direct_page_size)
+              throw rld::error ("Section alignment larger than the page size: " +
+                                std::string (section_names[s]),
+                                "rap::write");
+            sec_file_off[s] = offset;
+            offset = page_align (offset + sec_size[s]);
+          }
+          comp << sec_file_off[s];
+        }
+      }
+
+      /*
+       * Output the sections from each object file.
+       */
+      if (!direct_section (rap_text))
+        write (comp, rap_text);
+      if (!direct_section (rap_const))
+        write (comp, rap_const);
+      write (comp, rap_ctor);
+      write (comp, rap_dtor);
+      write (comp, rap_data);
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:output: strtab=" << comp.transferred () << std::endl;
+
+      strtab += '\0';
+      comp << strtab;
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:output: symbols=" << comp.transferred () << std::endl;
+
+      write_externals (comp);
+
+      if (rld::verbose () >= RLD_VERBOSE_INFO)
+        std::cout << "rap:output: relocs=" << comp.transferred () << std::endl;
+
+      write_relocations (comp, jobs);
     }
 
     /**
      * Helper for for_each to write out the various sections.
      */
+    /**
+     * The relocations applied at the fixed load addresses. The relocation
+     * writes a 32bit word with the symbol's address or with its address
+     * less the address of the word.
+     */
+    struct fixed_reloc
+    {
+      unsigned int machinetype; //< The machine type.
+      unsigned int type;        //< The relocation type.
+      bool         pcrel;       //< Relative to the relocation's address.
+    };
+
+    static const fixed_reloc fixed_relocs[] =
+    {
+      { EM_386,   R_386_32,       false },
+      { EM_386,   R_386_PC32,     true  },
+      { EM_ARM,   R_ARM_ABS32,    false },
+      { EM_ARM,   R_ARM_REL32,    true  },
+      { EM_SPARC, R_SPARC_32,     false },
+      { EM_SPARC, R_SPARC_DISP32, true  },
+      { EM_PPC,   R_PPC_ADDR32,   false },
+      { EM_PPC,   R_PPC_REL32,    true  },
+      { EM_MIPS,  R_MIPS_32,      false },
+      { EM_RISCV, R_RISCV_32,     false },
+      { EM_NONE,  0,              false }
+    };
+
+    static const fixed_reloc*
+    find_fixed_reloc (unsigned int type)
+    {
+      const unsigned int machinetype = elf::object_machine_type ();
+      for (const fixed_reloc* fr = fixed_relocs; fr->machinetype != EM_NONE; ++fr)
+        if ((fr->machinetype == machinetype) && (fr->type == type))
+          return fr;
+      return 0;
+    }
+
+    static uint32_t
+    read_word (const uint8_t* where, bool msb)
+    {
+      uint32_t value = 0;
+      for (int b = 0; b < 4; ++b)
+        value |= ((uint32_t) where[msb ? 3 - b : b]) << (b * 8);
+      return value;
+    }
+
+    static void
+    write_word (uint8_t* where, uint32_t value, bool msb)
+    {
+      for (int b = 0; b < 4; ++b)
+        where[msb ? 3 - b : b] = (value >> (b * 8)) & 0xff;
+    }
+
+    void
+    image::fix_relocations ()
+    {
+      for (int s = 0; s < rap_secs; ++s)
+      {
+        if (load_addresses.find (s) == load_addresses.end ())
+          continue;
+
+        uint32_t address = load_addresses[s];
+
+        if ((sec_align[s] != 0) && ((address % sec_align[s]) != 0))
+          throw rld::error ("Load address not aligned: " +
+                            std::string (section_names[s]),
+                            "rap::fix-relocations");
+
+        for (objects::iterator oi = objs.begin (); oi != objs.end (); ++oi)
+        {
+          object&      obj = *oi;
+          section&     sec = obj.secs[s];
+          relocations& relocs = sec.relocs;
+
+          for (relocations::iterator ri = relocs.begin ();
+               ri != relocs.end ();
+               ++ri)
+          {
+            relocation& reloc = *ri;
+
+            if ((reloc.symsect == 0) ||
+                ((reloc.symtype != STT_SECTION) &&
+                 (reloc.symbinding != STB_LOCAL)))
+              continue;
+
+            const fixed_reloc* fr = find_fixed_reloc (GELF_R_TYPE (reloc.info));
+            if (fr == 0)
+              continue;
+
+            int rap_symsect = obj.find (reloc.symsect);
+
+            if (load_addresses.find (rap_symsect) == load_addresses.end ())
+              continue;
+
+            uint32_t offset = sec.offset + reloc.offset;
+            fixup    fix;
+
+            fix.value = (load_addresses[rap_symsect] +
+                         obj.secs[rap_symsect].offset +
+                         obj.secs[rap_symsect].osecs[reloc.symsect].offset +
+                         reloc.symvalue + reloc.addend);
+            if (fr->pcrel)
+              fix.value -= address + offset;
+            fix.add = !sec.rela;
+
+            if (rld::verbose () >= RLD_VERBOSE_TRACE)
+              std::cout << "rap:fixup: " << section_names[s]
+                        << " offset=" << offset
+                        << std::hex
+                        << " value=0x" << fix.value
+                        << std::dec
+                        << " add=" << (char*) (fix.add ? "yes" : "no")
+                        << std::endl;
+
+            sec_fixups[s][offset] = fix;
+            reloc.fixed = true;
+          }
+        }
+      }
+    }
+
     class section_writer:
       public std::unary_function < object, void >
     {
@@ -1233,19 +2007,19 @@ namespace rld
       switch (sec)
       {
         case rap_text:
-          img.write (comp, obj.obj, obj.text, offset);
+          img.write (comp, obj.obj, obj.text, sec, offset);
           break;
         case rap_const:
-          img.write (comp, obj.obj, obj.const_, offset);
+          img.write (comp, obj.obj, obj.const_, sec, offset);
           break;
         case rap_ctor:
-          img.write (comp, obj.obj, obj.ctor, offset);
+          img.write (comp, obj.obj, obj.ctor, sec, offset);
           break;
         case rap_dtor:
-          img.write (comp, obj.obj, obj.dtor, offset);
+          img.write (comp, obj.obj, obj.dtor, sec, offset);
           break;
         case rap_data:
-          img.write (comp, obj.obj, obj.data, offset);
+          img.write (comp, obj.obj, obj.data, sec, offset);
           break;
         default:
           break;
@@ -1276,6 +2050,7 @@ namespace rld
     image::write (compress::compressor&  comp,
                   files::object&         obj,
                   const files::sections& secs,
+                  sections               rap_sec,
                   uint32_t&              offset)
     {
       uint32_t size = 0;
@@ -1305,7 +2080,36 @@ namespace rld
               comp.write (&ee, 1);
           }
 
-          comp.write (obj, sec.offset, sec.size);
+          fixups&          fixes = sec_fixups[rap_sec];
+          fixups::iterator fi = fixes.lower_bound (offset);
+
+          if ((fi == fixes.end ()) || (fi->first >= (offset + sec.size)))
+          {
+            comp.write (obj, sec.offset, sec.size);
+          }
+          else
+          {
+            std::vector < uint8_t > data (sec.size);
+            bool msb = elf::object_datatype () == ELFDATA2MSB;
+
+            if (!obj.seek_read (sec.offset, data.data (), sec.size))
+              throw rld::error ("Reading section failed: " + sec.name,
+                                "rap::write");
+
+            for (; (fi != fixes.end ()) && (fi->first < (offset + sec.size));
+                 ++fi)
+            {
+              uint8_t* where = &data[fi->first - offset];
+              uint32_t value = fi->second.value;
+
+              if (fi->second.add)
+                value += read_word (where, msb);
+
+              write_word (where, value, msb);
+            }
+
+            comp.write (data.data (), sec.size);
+          }
 
           if (rld::verbose () >= RLD_VERBOSE_FULL_DEBUG)
             std::cout << " sec: " << sec.index << ' ' << sec.name
@@ -1333,6 +2137,36 @@ namespace rld
       obj.close ();
     }
 
+    void
+    image::write_direct (files::image& app, uint32_t length)
+    {
+      uint32_t base = page_align (length);
+      uint32_t position = length;
+
+      for (int s = 0; s < rap_secs; ++s)
+      {
+        if (!direct_section (s))
+          continue;
+
+        uint32_t offset = base + sec_file_off[s];
+
+        if (rld::verbose () >= RLD_VERBOSE_INFO)
+          std::cout << "rap:output: direct: " << section_names[s]
+                    << ": offset=" << offset
+                    << " size=" << sec_size[s] << std::endl;
+
+        std::vector < uint8_t > padding (offset - position, 0);
+        if (!padding.empty ())
+          app.write (padding.data (), padding.size ());
+
+        compress::compressor direct (app, 2 * 1024, true, compress::codec_none);
+        write (direct, static_cast < sections > (s));
+        direct.flush ();
+
+        position = offset + sec_size[s];
+      }
+    }
+
     void
     image::write_externals (compress::compressor& comp)
     {
@@ -1361,150 +2195,322 @@ namespace rld
       }
     }
 
-    void
-    image::write_relocations (compress::compressor& comp)
+    /**
+     * A RAP section's relocation records encoded in memory. The sections are
+     * encoded in parallel and written to the compressor in order. The
+     * values are written the same way the compressor writes them.
+     */
+    class reloc_buffer
     {
-      uint32_t rr = 0;
+    public:
+      reloc_buffer& operator<< (const uint32_t value)
+      {
+        for (int b = 3; b >= 0; --b)
+          data += (char) (value >> (b * 8));
+        return *this;
+      }
 
-      for (int s = 0; s < rap_secs; ++s)
+      reloc_buffer& operator<< (const std::string& str)
       {
-        uint32_t count = get_relocations (s);
-        uint32_t sr = 0;
-        uint32_t header;
+        data += str;
+        return *this;
+      }
 
-        if (rld::verbose () >= RLD_VERBOSE_TRACE)
-          std::cout << "rap:relocation: section:" << section_names[s]
-                    << " relocs=" << count
-                    << " rela=" << (char*) (sec_rela[s] ? "yes" : "no")
-                    << std::endl;
+      void write (compress::compressor& comp) const
+      {
+        comp.write (data.data (), data.size ());
+      }
+
+    private:
+      std::string data;
+    };
+
+    /**
+     * A relocation record as written to the RAP file.
+     */
+    struct reloc_record
+    {
+      uint32_t    info;
+      uint32_t    offset;
+      uint32_t    addend;
+      bool        write_addend;
+      bool        write_symname;
+      std::string symname;
+    };
+
+    typedef std::vector < reloc_record > reloc_records;
+
+    /**
+     * The words covered by a RELR bitmap less the address bit.
+     */
+    static const uint32_t reloc_bitmap_words = 31;
+
+    /**
+     * Can the group of records be held in a bitmap? The offsets have to be
+     * word aligned and ascending and the records have no addend.
+     */
+    static bool
+    reloc_bitmap (const reloc_records& records, size_t first, size_t last)
+    {
+      if (records[first].write_addend)
+        return false;
+      for (size_t r = first; r < last; ++r)
+      {
+        if ((records[r].offset & 3) != 0)
+          return false;
+        if ((r > first) && (records[r].offset <= records[r - 1].offset))
+          return false;
+      }
+      return true;
+    }
+
+    /**
+     * Write the records in the compact encoding. A group is:
+     *
+     *  uint32_t: info, the same as a record's info
+     *  uint32_t: group, the number of records and the group flags
+     *  uint8_t*: the appended symbol name if the info has a string size
+     *
+     * followed by the records' offsets. Bitmap groups hold RELR style
+     * words, a word with bit 0 clear is an offset and a word with bit 0 set
+     * is a bitmap of the 31 words that follow the last offset or bitmap.
+     * The other groups hold the delta from the last offset in the group and
+     * if the group has addends the record's addend.
+     */
+    static void
+    write_compact_relocs (reloc_buffer&        comp,
+                          const reloc_records& records)
+    {
+      size_t r = 0;
+
+      while (r < records.size ())
+      {
+        const reloc_record& first = records[r];
+        size_t              last = r + 1;
+
+        while ((last < records.size ()) &&
+               ((last - r) < RAP_RELOC_GROUP_COUNT) &&
+               (records[last].info == first.info) &&
+               (records[last].write_addend == first.write_addend) &&
+               (records[last].symname == first.symname))
+          ++last;
 
+        uint32_t group = last - r;
+        bool     bitmap = reloc_bitmap (records, r, last);
+
+        if (first.write_addend)
+          group |= RAP_RELOC_GROUP_ADDEND;
+        if (bitmap)
+          group |= RAP_RELOC_GROUP_BITMAP;
+
+        comp << first.info << group;
+
+        if (first.write_symname)
+          comp << first.symname;
+
+        if (bitmap)
+        {
+          while (r < last)
+          {
+            uint32_t base = records[r].offset;
+            comp << base;
+            base += sizeof (uint32_t);
+            ++r;
+            while (r < last)
+            {
+              uint32_t words = 0;
+              while ((r < last) &&
+                     ((records[r].offset - base) <
+                      (reloc_bitmap_words * sizeof (uint32_t))))
+              {
+                words |= 1UL << (((records[r].offset - base) /
+                                  sizeof (uint32_t)) + 1);
+                ++r;
+              }
+              if (words == 0)
+                break;
+              comp << (words | 1);
+              base += reloc_bitmap_words * sizeof (uint32_t);
+            }
+          }
+        }
+        else
+        {
+          uint32_t offset = 0;
+          for (; r < last; ++r)
+          {
+            comp << (records[r].offset - offset);
+            offset = records[r].offset;
+            if (records[r].write_addend)
+              comp << records[r].addend;
+          }
+        }
+      }
+    }
+
+    void
+    image::encode_relocations (int s, reloc_buffer& comp) const
+    {
+      const bool compact = (compact_relocs || !load_addresses.empty () ||
+                            (direct_page_size != 0));
+
+      uint32_t count = get_relocations (s);
+      uint32_t sr = 0;
+      uint32_t header;
+
+      if (rld::verbose () >= RLD_VERBOSE_TRACE)
+        std::cout << "rap:relocation: section:" << section_names[s]
+                  << " relocs=" << count
+                  << " rela=" << (char*) (sec_rela[s] ? "yes" : "no")
+                  << std::endl;
+
+      reloc_records records;
+
+      if (!compact)
+      {
         header = count;
         header |= sec_rela[s] ? RAP_RELOC_RELA : 0;
 
         comp << header;
+      }
+
+      for (objects::const_iterator oi = objs.begin ();
+           oi != objs.end ();
+           ++oi)
+      {
+        const object&      obj = *oi;
+        const section&     sec = obj.secs[s];
+        const relocations& relocs = sec.relocs;
+        uint32_t     rc = 0;
 
-        for (objects::iterator oi = objs.begin ();
-             oi != objs.end ();
-             ++oi)
+        if (rld::verbose () >= RLD_VERBOSE_TRACE)
+          std::cout << " relocs=" << sec.relocs.size ()
+                    << " sec.offset=" << sec.offset
+                    << " sec.size=" << sec.size ()
+                    << " sec.align=" << sec.alignment ()
+                    << "  " << obj.obj.name ().full ()  << std::endl;
+
+        for (relocations::const_iterator ri = relocs.begin ();
+             ri != relocs.end ();
+             ++ri)
         {
-          object&      obj = *oi;
-          section&     sec = obj.secs[s];
-          relocations& relocs = sec.relocs;
-          uint32_t     rc = 0;
+          const relocation& reloc = *ri;
+          uint32_t          info = GELF_R_TYPE (reloc.info);
+          uint32_t          offset;
+          uint32_t          addend = reloc.addend;
+          bool              write_addend = sec.rela;
+          bool              write_symname = false;
 
-          if (rld::verbose () >= RLD_VERBOSE_TRACE)
-            std::cout << " relocs=" << sec.relocs.size ()
-                      << " sec.offset=" << sec.offset
-                      << " sec.size=" << sec.size ()
-                      << " sec.align=" << sec.alignment ()
-                      << "  " << obj.obj.name ().full ()  << std::endl;
+          if ((reloc.symsect == 0) || reloc.fixed)
+            continue;
 
-          for (relocations::const_iterator ri = relocs.begin ();
-               ri != relocs.end ();
-               ++ri)
+          offset = sec.offset + reloc.offset;
+
+          if (rld::verbose () >= RLD_VERBOSE_TRACE)
+            std::cout << "  " << std::setw (2) << sr
+                      << '/' << std::setw (2) << rc << ':'
+                      << std::hex
+                      << " reloc.info=0x" << reloc.info
+                      << std::dec
+                      << " reloc.offset=" << reloc.offset
+                      << " reloc.addend=" << reloc.addend
+                      << " reloc.symtype=" << reloc.symtype
+                      << " reloc.symsect=" << reloc.symsect
+                      << " (" << obj.obj.get_section (reloc.symsect).name << ')'
+                      << " reloc.symvalue=" << reloc.symvalue
+                      << " reloc.symbinding=" << reloc.symbinding
+                      << std::endl;
+
+          if ((reloc.symtype == STT_SECTION) || (reloc.symbinding == STB_LOCAL))
           {
-            const relocation& reloc = *ri;
-            uint32_t          info = GELF_R_TYPE (reloc.info);
-            uint32_t          offset;
-            uint32_t          addend = reloc.addend;
-            bool              write_addend = sec.rela;
-            bool              write_symname = false;
-
-            if (reloc.symsect == 0)
-              continue;
+            int rap_symsect = obj.find (reloc.symsect);
+
+            /*
+             * Bit 31 clear, bits 30:8 RAP section index.
+             */
+            info |= rap_symsect << 8;
+
+            const section& symsec = obj.secs[rap_symsect];
+            const osection& symosec = symsec.osecs.find (reloc.symsect)->second;
+
+            addend += (symsec.offset + symosec.offset + reloc.symvalue);
 
-            offset = sec.offset + reloc.offset;
+            write_addend = true;
 
             if (rld::verbose () >= RLD_VERBOSE_TRACE)
               std::cout << "  " << std::setw (2) << sr
                         << '/' << std::setw (2) << rc << ':'
-                        << std::hex
-                        << " reloc.info=0x" << reloc.info
-                        << std::dec
-                        << " reloc.offset=" << reloc.offset
-                        << " reloc.addend=" << reloc.addend
-                        << " reloc.symtype=" << reloc.symtype
-                        << " reloc.symsect=" << reloc.symsect
-                        << " (" << obj.obj.get_section (reloc.symsect).name << ')'
-                        << " reloc.symvalue=" << reloc.symvalue
-                        << " reloc.symbinding=" << reloc.symbinding
+                        << " rsym: sect=" << section_names[rap_symsect]
+                        << " rap_symsect=" << rap_symsect
+                        << " sec.offset=" << symsec.offset
+                        << " sec.osecs=" << symosec.offset
+                        << " addend=" << addend
                         << std::endl;
+          }
+          else
+          {
+            /*
+             * Bit 31 must be set. Bit 30 determines the type of string and
+             * bits 29:8 the strtab offset or the size of the appended
+             * string.
+             */
 
-            if ((reloc.symtype == STT_SECTION) || (reloc.symbinding == STB_LOCAL))
-            {
-              int rap_symsect = obj.find (reloc.symsect);
+            info |= RAP_RELOC_STRING;
 
+            std::size_t size = find_in_strtab (reloc.symname);
+
+            if (size == std::string::npos)
+            {
               /*
-               * Bit 31 clear, bits 30:8 RAP section index.
+               * Bit 30 clear, the size of the symbol name.
                */
-              info |= rap_symsect << 8;
-
-              addend += (obj.secs[rap_symsect].offset +
-                         obj.secs[rap_symsect].osecs[reloc.symsect].offset +
-                         reloc.symvalue);
-
-              write_addend = true;
-
-              if (rld::verbose () >= RLD_VERBOSE_TRACE)
-                std::cout << "  " << std::setw (2) << sr
-                          << '/' << std::setw (2) << rc << ':'
-                          << " rsym: sect=" << section_names[rap_symsect]
-                          << " rap_symsect=" << rap_symsect
-                          << " sec.offset=" << obj.secs[rap_symsect].offset
-                          << " sec.osecs=" << obj.secs[rap_symsect].osecs[reloc.symsect].offset
-                          << " addend=" << addend
-                          << std::endl;
+              info |= reloc.symname.size () << 8;
+              write_symname = true;
             }
             else
             {
               /*
-               * Bit 31 must be set. Bit 30 determines the type of string and
-               * bits 29:8 the strtab offset or the size of the appended
-               * string.
+               * Bit 30 set, the offset in the strtab.
                */
-
-              info |= RAP_RELOC_STRING;
-
-              std::size_t size = find_in_strtab (reloc.symname);
-
-              if (size == std::string::npos)
-              {
-                /*
-                 * Bit 30 clear, the size of the symbol name.
-                 */
-                info |= reloc.symname.size () << 8;
-                write_symname = true;
-              }
-              else
-              {
-                /*
-                 * Bit 30 set, the offset in the strtab.
-                 */
-                info |= RAP_RELOC_STRING_EMBED | (size << 8);
-              }
+              info |= RAP_RELOC_STRING_EMBED | (size << 8);
             }
+          }
 
-            if (rld::verbose () >= RLD_VERBOSE_TRACE)
+          if (rld::verbose () >= RLD_VERBOSE_TRACE)
+          {
+            std::cout << "  " << std::setw (2) << sr << '/'
+                      << std::setw (2) << rc
+                      << std::hex << ": reloc: info=0x" << info << std::dec
+                      << " offset=" << offset;
+            if (write_addend)
+              std::cout << " addend=" << addend;
+            if ((info & RAP_RELOC_STRING) != 0)
             {
-              std::cout << "  " << std::setw (2) << sr << '/'
-                        << std::setw (2) << rc
-                        << std::hex << ": reloc: info=0x" << info << std::dec
-                        << " offset=" << offset;
-              if (write_addend)
-                std::cout << " addend=" << addend;
-              if ((info & RAP_RELOC_STRING) != 0)
-              {
-                std::cout << " symname=" << reloc.symname;
-                if (write_symname)
-                  std::cout << " (appended)";
-              }
-              std::cout << std::hex
-                        << " reloc.info=0x" << reloc.info << std::dec
-                        << " reloc.offset=" << reloc.offset
-                        << " reloc.symtype=" << reloc.symtype
-                        << std::endl;
+              std::cout << " symname=" << reloc.symname;
+              if (write_symname)
+                std::cout << " (appended)";
             }
+            std::cout << std::hex
+                      << " reloc.info=0x" << reloc.info << std::dec
+                      << " reloc.offset=" << reloc.offset
+                      << " reloc.symtype=" << reloc.symtype
+                      << std::endl;
+          }
 
+          if (compact)
+          {
+            reloc_record record;
+            record.info = info;
+            record.offset = offset;
+            record.addend = addend;
+            record.write_addend = write_addend;
+            record.write_symname = write_symname;
+            if ((info & RAP_RELOC_STRING) != 0)
+              record.symname = reloc.symname;
+            records.push_back (record);
+          }
+          else
+          {
             comp << info << offset;
 
             if (write_addend)
@@ -1512,13 +2518,42 @@ namespace rld
 
             if (write_symname)
               comp << reloc.symname;
-
-            ++rc;
-            ++sr;
-            ++rr;
           }
+
+          ++rc;
+          ++sr;
         }
       }
+
+      if (compact)
+      {
+        header = records.size ();
+        header |= sec_rela[s] ? RAP_RELOC_RELA : 0;
+
+        comp << header;
+
+        write_compact_relocs (comp, records);
+      }
+    }
+
+    void
+    image::write_relocations (compress::compressor& comp, unsigned int jobs)
+    {
+      reloc_buffer buffers[rap_secs];
+
+      /*
+       * The sections are independent so encode them in parallel and write
+       * them in order. The trace output is serial.
+       */
+      if (rld::verbose () >= RLD_VERBOSE_TRACE)
+        jobs = 1;
+
+      rld::tasks::parallel_for (rap_secs, jobs, [&] (size_t s) {
+        encode_relocations (s, buffers[s]);
+      });
+
+      for (int s = 0; s < rap_secs; ++s)
+        buffers[s].write (comp);
     }
 
     void image::write_details (compress::compressor& comp)
@@ -1664,9 +2699,12 @@ namespace rld
         sec_size[s] = 0;
         sec_align[s] = 0;
         sec_rela[s] = false;
+        sec_fixups[s].clear ();
+        sec_file_off[s] = RAP_OFFSET_NONE;
       }
       symtab_size = 0;
       strtab.clear ();
+      strtab_offsets.clear ();
       relocs_size = 0;
       init_off = 0;
       fini_off = 0;
@@ -1682,42 +2720,131 @@ namespace rld
     }
 
     std::size_t
-    image::find_in_strtab (const std::string& symname)
+    image::find_in_strtab (const std::string& symname) const
+    {
+      return find_in_strtab (symname.c_str (), symname.size (),
+                             strtab_hash (symname));
+    }
+
+    std::size_t
+    image::find_in_strtab (const char* name, size_t size, uint64_t hash) const
     {
-      std::size_t pos = 0;
-      while (pos < strtab.size ())
+      typedef std::pair < strtab_index::const_iterator,
+                          strtab_index::const_iterator > strtab_range;
+      strtab_range range = strtab_offsets.equal_range (hash);
+      for (strtab_index::const_iterator si = range.first;
+           si != range.second;
+           ++si)
       {
-        std::size_t off = strtab.find (symname, pos);
-        if (off == std::string::npos)
-          break;
-        if (::strlen (strtab.c_str () + off) == symname.size ())
+        std::size_t off = (*si).second;
+        std::size_t end = off + size;
+        if ((end <= strtab.size ()) &&
+            ((end == strtab.size ()) || (strtab[end] == '\0')) &&
+            (strtab.compare (off, size, name, size) == 0))
           return off;
-        pos = off + 1;
       }
       return std::string::npos;
     }
 
+    uint32_t
+    image::add_to_strtab (const std::string& name)
+    {
+      /*
+       * The table starts with a nul so the empty string is at offset 0.
+       */
+      if (strtab.empty ())
+        strtab_offsets.insert (std::make_pair (0, 0));
+
+      uint32_t offset = strtab.size () + 1;
+
+      strtab += '\0';
+      strtab += name;
+
+      /*
+       * Index the string and its tails from the longest. The first tail
+       * already in the table was indexed with its own tails when it was
+       * added so there are no more tails to index.
+       */
+      std::vector < uint64_t > hashes (name.size () + 1);
+      uint64_t                 scale = 1;
+      hashes[name.size ()] = 0;
+      for (size_t c = name.size (); c > 0; --c)
+      {
+        hashes[c - 1] = ((uint8_t) name[c - 1] * scale) + hashes[c];
+        scale *= strtab_hash_prime;
+      }
+
+      for (size_t c = 0; c < name.size (); ++c)
+      {
+        if (find_in_strtab (name.c_str () + c, name.size () - c,
+                            hashes[c]) != std::string::npos)
+          break;
+        strtab_offsets.insert (std::make_pair (hashes[c], offset + c));
+      }
+
+      return offset;
+    }
+
+    /**
+     * Order strings by their reversed characters so a string follows the
+     * strings it is the tail of.
+     */
+    static bool
+    strtab_tail_order (const std::string& lhs, const std::string& rhs)
+    {
+      return std::lexicographical_compare (rhs.rbegin (), rhs.rend (),
+                                           lhs.rbegin (), lhs.rend ());
+    }
+
+    void
+    image::merge_into_strtab (rld::strings& names)
+    {
+      std::sort (names.begin (), names.end (), strtab_tail_order);
+      names.erase (std::unique (names.begin (), names.end ()), names.end ());
+      for (rld::strings::const_iterator ni = names.begin ();
+           ni != names.end ();
+           ++ni)
+      {
+        if (find_in_strtab (*ni) == std::string::npos)
+          add_to_strtab (*ni);
+      }
+    }
+
     void
     write (files::image&             app,
            const std::string&        init,
            const std::string&        fini,
            const files::object_list& app_objects,
-           const symbols::table&     /* symbols */) /* Add back for incremental
-                                                     * linking */
+           const symbols::table&     /* symbols */, /* Add back for incremental
+                                                      * linking */
+           unsigned int              jobs,
+           compress::codec           method)
     {
       std::string header;
 
-      header = "RAP,00000000,0002,LZ77,00000000\n";
+      if (direct_page_size != 0)
+        header = "RAP,00000000,0005,";
+      else if (!load_addresses.empty ())
+        header = "RAP,00000000,0004,";
+      else if (compact_relocs)
+        header = "RAP,00000000,0003,";
+      else
+        header = "RAP,00000000,0002,";
+      header += compress::rap_header_name (method);
+      header += ",00000000\n";
       app.write (header.c_str (), header.size ());
 
-      compress::compressor compressor (app, 2 * 1024);
+      compress::compressor compressor (app, 2 * 1024, true, method, jobs);
       image                rap;
 
       rap.layout (app_objects, init, fini);
-      rap.write (compressor);
+      rap.write (compressor, jobs);
 
       compressor.flush ();
 
+      if (direct_page_size != 0)
+        rap.write_direct (app, header.size () + compressor.compressed ());
+
       std::ostringstream length;
 
       length << std::setfill ('0') << std::setw (8)
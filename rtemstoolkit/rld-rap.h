@@ -25,6 +25,9 @@
 #if !defined (_RLD_RAP_H_)
 #define _RLD_RAP_H_
 
+#include <map>
+
+#include <rld-compression.h>
 #include <rld-files.h>
 
 namespace rld
@@ -41,6 +44,56 @@ namespace rld
       */
      extern std::string rpath;
 
+     /**
+      * Merge a string that is the tail of another string into the other
+      * string in the string table. The strings are ordered by their tails
+      * rather than the order the symbols are found.
+      */
+     extern bool merge_strings;
+
+     /**
+      * Remove the split sections, for example '.text.name', that cannot be
+      * reached through the relocations from the entry and exit labels, the
+      * constructors, the destructors and the sections that are not split.
+      * The symbols in a removed section are not exported.
+      */
+     extern bool gc_sections;
+
+     /**
+      * The symbols in the order their code is placed with the hottest
+      * first. The code sections with a symbol in the order are placed in
+      * the order and the object files are ordered by their first section.
+      */
+     extern rld::strings symbol_order;
+
+     /**
+      * Write the relocation records in the compact encoding. Consecutive
+      * records with the same type and symbol form a group with the info
+      * written once, offsets are delta encoded and word aligned records
+      * without an addend are held in a RELR style bitmap. The RAP header
+      * version is 3 when set.
+      */
+     extern bool compact_relocs;
+
+     /**
+      * The fixed load addresses of the RAP sections keyed by the RAP
+      * section. The loader places a section with an address at the address
+      * and the relocations between the sections with an address are applied
+      * when the image is written. The relocations that remain depend on
+      * symbols. The RAP header version is 4 and the relocation records use
+      * the compact encoding when there are addresses.
+      */
+     extern std::map < int, uint32_t > load_addresses;
+
+     /**
+      * The page size of the directly mapped sections or 0 to compress all
+      * sections. The text and const sections are written uncompressed after
+      * the compressed image at offsets aligned to the page size so a loader
+      * can map them or execute them in place. The RAP header version is 5
+      * when set.
+      */
+     extern uint32_t direct_page_size;
+
     /**
      * The RAP relocation bit masks.
      */
@@ -48,6 +101,24 @@ namespace rld
     #define RAP_RELOC_STRING       (1UL << 31)
     #define RAP_RELOC_STRING_EMBED (1UL << 30)
 
+    /**
+     * The compact relocation group bit masks. The group word follows the
+     * group's info word and the low bits are the number of records.
+     */
+    #define RAP_RELOC_GROUP_ADDEND (1UL << 31)
+    #define RAP_RELOC_GROUP_BITMAP (1UL << 30)
+    #define RAP_RELOC_GROUP_COUNT  ((1UL << 30) - 1)
+
+    /**
+     * The load address of a RAP section the loader places.
+     */
+    #define RAP_ADDRESS_NONE       (0xffffffffUL)
+
+    /**
+     * The file offset of a RAP section in the compressed image.
+     */
+    #define RAP_OFFSET_NONE        (0xffffffffUL)
+
     /**
      * The sections of interest in a RAP file.
      */
@@ -67,6 +138,32 @@ namespace rld
      */
     const char* section_name (int sec);
 
+    /**
+     * Load the symbol order from a file. Each line has a symbol name as its
+     * first field. Empty lines and lines starting with '#' are ignored.
+     *
+     * @param path The path of the symbol order file.
+     */
+    void load_symbol_order (const std::string& path);
+
+    /**
+     * Load the fixed load addresses of the RAP sections from a file. Each
+     * line has a RAP section name, for example '.text', and the address.
+     * Empty lines and lines starting with '#' are ignored.
+     *
+     * @param path The path of the load address map file.
+     */
+    void load_address_map (const std::string& path);
+
+    /**
+     * Order the object files by the first of their symbols in the symbol
+     * order. The object files with no symbol in the order are last and
+     * keep their order.
+     *
+     * @param objects The object files to order.
+     */
+    void order_objects (files::object_list& objects);
+
     /**
      * Write a RAP format file.
      *
@@ -85,12 +182,16 @@ namespace rld
      * @param fini The application's finish entry point .
      * @param objects The list of object files in the application.
      * @param symbols The symbol table used to create the application.
+     * @param jobs The number of blocks compressed in parallel.
+     * @param method The codec used to compress the image.
      */
     void write (files::image&             app,
                 const std::string&        init,
                 const std::string&        fini,
                 const files::object_list& objects,
-                const symbols::table&     symbols);
+                const symbols::table&     symbols,
+                unsigned int              jobs = 1,
+                compress::codec           method = compress::codec_lz77);
   }
 }
 
@@ -28,6 +28,7 @@
 
 #include <iomanip>
 #include <iostream>
+#include <list>
 
 #include <sys/stat.h>
 
@@ -49,31 +50,50 @@ namespace rld
       return (*oi).second;
     }
 
-    static void
-    resolve_symbols (files::object_list& dependents,
-                     files::cache&       cache,
-                     symbols::table&     base_symbols,
-                     symbols::table&     symbols,
-                     symbols::symtab&    unresolved,
-                     const std::string&  fullname)
+    /**
+     * A object file being resolved. The objects are the object files it
+     * references that need to be resolved and next is the next of them to
+     * resolve.
+     */
+    struct resolving
     {
-      const std::string name = path::basename (fullname);
-
-      static int nesting = 0;
+      files::object*               object;   //< The object, 0 if undefines.
+      std::string                  name;     //< The name of the object.
+      files::object_list           objects;  //< The referenced objects.
+      files::object_list::iterator next;     //< The next object to resolve.
+    };
+
+    /**
+     * A stack of object files being resolved.
+     */
+    typedef std::list < resolving > resolve_stack;
+
+    static bool
+    find_symbols (resolving&         r,
+                  files::cache&      cache,
+                  symbols::table&    base_symbols,
+                  symbols::table&    symbols,
+                  symbols::symtab&   unresolved,
+                  const std::string& fullname,
+                  int                nesting)
+    {
+      r.name = path::basename (fullname);
 
-      ++nesting;
+      const std::string& name = r.name;
 
       /*
        * Find each unresolved symbol in the symbol table pointing the
        * unresolved symbol's object file to the file that resolves the
-       * symbol. Record each object file that is found and when all unresolved
-       * symbols in this object file have been found iterate over the found
-       * object files resolving them. The 'urs' is the unresolved symbol and
-       * 'es' is the exported symbol.
+       * symbol. Record each object file that is found so they can be
+       * resolved once all unresolved symbols in this object file have been
+       * found. The 'urs' is the unresolved symbol and 'es' is the exported
+       * symbol.
        */
 
       files::object* object = get_object (cache, fullname);
 
+      r.object = object;
+
       if (object)
       {
         if (object->resolved () || object->resolving ())
@@ -84,7 +104,7 @@ namespace rld
                       << name
                       << " is resolved or resolving"
                       << std::endl;
-          return;
+          return false;
         }
         object->resolve_set ();
       }
@@ -97,7 +117,7 @@ namespace rld
                   << unresolved.size ()
                   << std::endl;
 
-      files::object_list objects;
+      files::object_list& objects = r.objects;
 
       for (symbols::symtab::iterator ursi = unresolved.begin ();
            ursi != unresolved.end ();
@@ -120,7 +140,13 @@ namespace rld
 
         if (!es)
         {
+          /*
+           * A symbol not in the symbol table can be defined by an archive
+           * member whose symbols have not been loaded.
+           */
           es = symbols.find_global (urs.name ());
+          if (!es && cache.load_armap_symbol (urs.name (), symbols))
+            es = symbols.find_global (urs.name ());
           if (!es)
           {
             es = symbols.find_weak (urs.name ());
@@ -174,35 +200,65 @@ namespace rld
         object->resolved_set ();
       }
 
-      /*
-       * Recurse into any references object files.
-       */
-
       if (rld::verbose () >= RLD_VERBOSE_INFO)
         std::cout << "resolver:resolved : "
                   << std::setw (nesting + 1) << ' '
                   << " +-- referenced objects: " << objects.size ()
                   << std::endl;
 
-      for (files::object_list::iterator oli = objects.begin ();
-           oli != objects.end ();
-           ++oli)
-      {
-        files::object& obj = *(*oli);
-        if (rld::verbose () >= RLD_VERBOSE_INFO)
-          std::cout << "resolver:resolving: "
-                    << std::setw (nesting) << ' '
-                    << "] " << name << " ==> "
-                    << obj.name ().basename () << std::endl;
-        resolve_symbols (dependents, cache, base_symbols, symbols,
-                         obj.unresolved_symbols (),
-                         obj.name ().full ());
-      }
+      r.next = objects.begin ();
 
-      --nesting;
+      return true;
+    }
 
-      dependents.merge (objects);
-      dependents.unique ();
+    static void
+    resolve_symbols (files::object_list& dependents,
+                     files::cache&       cache,
+                     symbols::table&     base_symbols,
+                     symbols::table&     symbols,
+                     symbols::symtab&    unresolved,
+                     const std::string&  fullname)
+    {
+      /*
+       * Resolve the object files depth first using a stack rather than
+       * recursion so deep dependency chains cannot exhaust the process
+       * stack. An object's referenced objects are resolved in the order
+       * found and an object's referenced objects are merged into the
+       * dependents once they have been resolved.
+       */
+      resolve_stack stack;
+
+      stack.push_back (resolving ());
+      if (!find_symbols (stack.back (), cache, base_symbols, symbols,
+                         unresolved, fullname, 1))
+        return;
+
+      while (!stack.empty ())
+      {
+        resolving& r = stack.back ();
+
+        if (r.next != r.objects.end ())
+        {
+          files::object& obj = *(*r.next);
+          ++r.next;
+          if (rld::verbose () >= RLD_VERBOSE_INFO)
+            std::cout << "resolver:resolving: "
+                      << std::setw (stack.size ()) << ' '
+                      << "] " << r.name << " ==> "
+                      << obj.name ().basename () << std::endl;
+          stack.push_back (resolving ());
+          if (!find_symbols (stack.back (), cache, base_symbols, symbols,
+                             obj.unresolved_symbols (), obj.name ().full (),
+                             stack.size ()))
+            stack.pop_back ();
+        }
+        else
+        {
+          dependents.merge (r.objects);
+          dependents.unique ();
+          stack.pop_back ();
+        }
+      }
     }
 
     void
@@ -24,9 +24,13 @@
 
 #include <string.h>
 
+#include <functional>
 #include <iomanip>
+#include <mutex>
+#include <unordered_map>
 
 #include <rld.h>
+#include <rld-tasks.h>
 
 #include <libiberty/demangle.h>
 
@@ -35,15 +39,23 @@ namespace rld
   namespace symbols
   {
     /**
-     * Get the demangled name.
+     * The demangled names keyed by the interned name. The value is the
+     * interned demangled name or 0 if the name is not a C++ name.
      */
-    bool
-    demangle_name (const std::string& name, std::string& demangled)
+    typedef std::unordered_map < const std::string*,
+                                 const std::string* > demangled_names;
+
+    static demangled_names demangled_cache;
+    static std::mutex      demangled_lock;
+
+    /**
+     * Demangle a name with libiberty.
+     */
+    static const std::string*
+    demangle_uncached (const std::string& name)
     {
-      bool yes = false;
-      if (name.length() == 0)
-        demangled = name;
-      else
+      const std::string* demangled = 0;
+      if (name.length () != 0)
       {
         std::string wrapper = "_GLOBAL__sub_I_";
         size_t      offset = 0;
@@ -54,23 +66,98 @@ namespace rld
                                                  DMGL_RET_POSTFIX);
         if (demangled_name)
         {
-          demangled = demangled_name;
+          demangled = &rld::intern (demangled_name);
           ::free (demangled_name);
-          yes = true;
         }
       }
-      return yes;
+      return demangled;
+    }
+
+    const std::string*
+    demangle (const std::string& name)
+    {
+      const std::string* key = &rld::intern (name);
+      {
+        std::lock_guard < std::mutex > guard (demangled_lock);
+        demangled_names::const_iterator di = demangled_cache.find (key);
+        if (di != demangled_cache.end ())
+          return (*di).second;
+      }
+      /*
+       * Demangle without the lock held. If another thread demangles the same
+       * name the result is the same interned string.
+       */
+      const std::string* demangled = demangle_uncached (*key);
+      std::lock_guard < std::mutex > guard (demangled_lock);
+      demangled_cache[key] = demangled;
+      return demangled;
+    }
+
+    void
+    demangle (const std::vector < std::string >&  names,
+              std::vector < const std::string* >& demangled,
+              unsigned int                        jobs)
+    {
+      std::vector < const std::string* > keys;
+      std::vector < size_t >             misses;
+
+      keys.reserve (names.size ());
+      for (auto& name : names)
+        keys.push_back (&rld::intern (name));
+
+      demangled.assign (names.size (), 0);
+
+      {
+        std::lock_guard < std::mutex > guard (demangled_lock);
+        for (size_t n = 0; n < keys.size (); ++n)
+        {
+          demangled_names::const_iterator di = demangled_cache.find (keys[n]);
+          if (di != demangled_cache.end ())
+            demangled[n] = (*di).second;
+          else
+            misses.push_back (n);
+        }
+      }
+
+      if (misses.empty ())
+        return;
+
+      rld::tasks::parallel_for (misses.size (), jobs, [&] (size_t m) {
+        demangled[misses[m]] = demangle_uncached (*keys[misses[m]]);
+      });
+
+      std::lock_guard < std::mutex > guard (demangled_lock);
+      for (auto m : misses)
+        demangled_cache[keys[m]] = demangled[m];
+    }
+
+    /**
+     * Get the demangled name.
+     */
+    bool
+    demangle_name (const std::string& name, std::string& demangled)
+    {
+      const std::string* dn = demangle (name);
+      if (dn == 0)
+      {
+        if (name.length () == 0)
+          demangled = name;
+        return false;
+      }
+      demangled = *dn;
+      return true;
     }
 
     bool
     is_cplusplus (const std::string& name)
     {
-      std::string demangled;
-      return symbols::demangle_name (name, demangled);
+      return demangle (name) != 0;
     }
 
     symbol::symbol ()
       : index_ (-1),
+        name_ (&rld::intern ("")),
+        demangled_ (name_),
         object_ (0),
         references_ (0)
     {
@@ -82,34 +169,39 @@ namespace rld
                     files::object&      object,
                     const elf::elf_sym& esym)
       : index_ (index),
-        name_ (name),
+        name_ (&rld::intern (name)),
+        demangled_ (name_),
         object_ (&object),
         esym_ (esym),
         references_ (0)
     {
       if (!object_)
         throw rld_error_at ("object pointer is 0");
-      if (!demangle_name (name_, demangled_))
-        demangled_ = name_;
+      const std::string* demangled = demangle (*name_);
+      if (demangled)
+        demangled_ = demangled;
     }
 
     symbol::symbol (int                 index,
                     const std::string&  name,
                     const elf::elf_sym& esym)
       : index_ (index),
-        name_ (name),
+        name_ (&rld::intern (name)),
+        demangled_ (name_),
         object_ (0),
         esym_ (esym),
         references_ (0)
     {
-      if (!demangle_name (name_, demangled_))
-        demangled_ = name_;
+      const std::string* demangled = demangle (*name_);
+      if (demangled)
+        demangled_ = demangled;
     }
 
     symbol::symbol (const std::string&  name,
                     const elf::elf_addr value)
       : index_ (-1),
-        name_ (name),
+        name_ (&rld::intern (name)),
+        demangled_ (&rld::intern ("")),
         object_ (0),
         references_ (0)
     {
@@ -120,7 +212,8 @@ namespace rld
     symbol::symbol (const char*         name,
                     const elf::elf_addr value)
       : index_ (-1),
-        name_ (name),
+        name_ (&rld::intern (name)),
+        demangled_ (&rld::intern ("")),
         object_ (0),
         references_ (0)
     {
@@ -137,19 +230,19 @@ namespace rld
     const std::string&
     symbol::name () const
     {
-      return name_;
+      return *name_;
     }
 
     const std::string&
     symbol::demangled () const
     {
-      return demangled_;
+      return *demangled_;
     }
 
     bool
     symbol::is_cplusplus () const
     {
-      return symbols::is_cplusplus (name_);
+      return symbols::is_cplusplus (*name_);
     }
 
     bool
@@ -229,7 +322,7 @@ namespace rld
     bool
     symbol::operator< (const symbol& rhs) const
     {
-      return name_ < rhs.name_;
+      return *name_ < *rhs.name_;
     }
 
     void
@@ -307,6 +400,78 @@ namespace rld
         out << "   (" << object ()->name ().basename () << ')';
     }
 
+    name_index::slot::slot ()
+      : hash (0),
+        sym (0)
+    {
+    }
+
+    name_index::name_index ()
+      : slots_ (16),
+        count (0)
+    {
+    }
+
+    void
+    name_index::add (symbol& sym)
+    {
+      size_t hash = std::hash < std::string > () (sym.name ());
+      size_t s = lookup (sym.name (), hash);
+      if (slots_[s].sym == 0)
+      {
+        /*
+         * Keep the index no more than half full so probe sequences are short.
+         */
+        if ((count + 1) * 2 > slots_.size ())
+        {
+          grow ();
+          s = lookup (sym.name (), hash);
+        }
+        ++count;
+      }
+      slots_[s].hash = hash;
+      slots_[s].sym = &sym;
+    }
+
+    symbol*
+    name_index::find (const std::string& name) const
+    {
+      size_t hash = std::hash < std::string > () (name);
+      return slots_[lookup (name, hash)].sym;
+    }
+
+    size_t
+    name_index::lookup (const std::string& name, size_t hash) const
+    {
+      const size_t mask = slots_.size () - 1;
+      size_t       s = hash & mask;
+      while (slots_[s].sym != 0)
+      {
+        if (slots_[s].hash == hash && slots_[s].sym->name () == name)
+          break;
+        s = (s + 1) & mask;
+      }
+      return s;
+    }
+
+    void
+    name_index::grow ()
+    {
+      slots old (slots_.size () * 2);
+      old.swap (slots_);
+      const size_t mask = slots_.size () - 1;
+      for (auto& o : old)
+      {
+        if (o.sym != 0)
+        {
+          size_t s = o.hash & mask;
+          while (slots_[s].sym != 0)
+            s = (s + 1) & mask;
+          slots_[s] = o;
+        }
+      }
+    }
+
     table::table ()
     {
     }
@@ -319,45 +484,39 @@ namespace rld
     table::add_global (symbol& sym)
     {
       globals_[sym.name ()] = &sym;
+      globals_index.add (sym);
     }
 
     void
     table::add_weak (symbol& sym)
     {
       weaks_[sym.name ()] = &sym;
+      weaks_index.add (sym);
     }
 
     void
     table::add_local (symbol& sym)
     {
       locals_[sym.name ()] = &sym;
+      locals_index.add (sym);
     }
 
     symbol*
     table::find_global (const std::string& name)
     {
-      symtab::iterator sti = globals_.find (name);
-      if (sti == globals_.end ())
-        return 0;
-      return (*sti).second;
+      return globals_index.find (name);
     }
 
     symbol*
     table::find_weak (const std::string& name)
     {
-      symtab::iterator sti = weaks_.find (name);
-      if (sti == weaks_.end ())
-        return 0;
-      return (*sti).second;
+      return weaks_index.find (name);
     }
 
     symbol*
     table::find_local (const std::string& name)
     {
-      symtab::iterator sti = locals_.find (name);
-      if (sti == locals_.end ())
-        return 0;
-      return (*sti).second;
+      return locals_index.find (name);
     }
 
     size_t
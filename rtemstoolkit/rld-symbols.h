@@ -29,6 +29,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <rld-elf-types.h>
 
@@ -45,11 +46,27 @@ namespace rld
   namespace symbols
   {
     /**
-     * C++ demangler.
+     * C++ demangler. The demangled names are cached so a name is only
+     * demangled once. The cache can be used from more than one thread.
      */
     bool is_cplusplus (const std::string& name);
     bool demangle_name (const std::string& name, std::string& demangled);
 
+    /**
+     * Demangle a name returning the interned demangled name or 0 if the name
+     * is not a C++ name.
+     */
+    const std::string* demangle (const std::string& name);
+
+    /**
+     * Demangle a batch of names. The names not in the cache are demangled on
+     * the number of jobs. The demangled container holds the result of
+     * demangle for each name.
+     */
+    void demangle (const std::vector < std::string >&  names,
+                   std::vector < const std::string* >& demangled,
+                   unsigned int                        jobs = 1);
+
     /**
      * Use a local type for the address.
      */
@@ -213,8 +230,9 @@ namespace rld
     private:
 
       int            index_;      //< The symbol's index in the ELF file.
-      std::string    name_;       //< The name of the symbol.
-      std::string    demangled_;  //< If a C++ symbol the demangled name.
+      const std::string* name_;      //< The interned name of the symbol.
+      const std::string* demangled_; //< If a C++ symbol the interned
+                                     //  demangled name.
       files::object* object_;     //< The object file containing the symbol.
       elf::elf_sym   esym_;       //< The ELF symbol.
       int            references_; //< The number of times if it referenced.
@@ -242,6 +260,60 @@ namespace rld
      */
     typedef std::map < address, symbol* > addrtab;
 
+    /**
+     * A hash index of symbols keyed by name. The index uses open addressing
+     * and holds the hash of each symbol's name so a probe only compares the
+     * strings when the hashes match. The names are not copied and the
+     * symbols should always be held in a bucket.
+     */
+    class name_index
+    {
+    public:
+      /**
+       * Construct an empty index.
+       */
+      name_index ();
+
+      /**
+       * Add a symbol replacing any symbol with the same name.
+       */
+      void add (symbol& sym);
+
+      /**
+       * Find a symbol given a name. Returns 0 if not found.
+       */
+      symbol* find (const std::string& name) const;
+
+    private:
+
+      /**
+       * A slot in the index. An empty slot has no symbol.
+       */
+      struct slot
+      {
+        size_t  hash;
+        symbol* sym;
+
+        slot ();
+      };
+
+      typedef std::vector < slot > slots;
+
+      /**
+       * Find the slot for a name. The slot is empty if the name is not
+       * present.
+       */
+      size_t lookup (const std::string& name, size_t hash) const;
+
+      /**
+       * Double the number of slots.
+       */
+      void grow ();
+
+      slots  slots_;  //< The slots, always a power of 2.
+      size_t count;   //< The number of symbols in the index.
+    };
+
     /**
      * A symbols contains a symbol table of global, weak and local symbols.
      */
@@ -344,6 +416,14 @@ namespace rld
        * A table of local symbols.
        */
       symtab locals_;
+
+      /**
+       * The name indexes of the global, weak and local symbols used to find
+       * a symbol.
+       */
+      name_index globals_index;
+      name_index weaks_index;
+      name_index locals_index;
     };
 
     /**
@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2026, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems-ld
+ *
+ * @brief A work stealing task scheduler shared by the tools.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <rld.h>
+#include <rld-tasks.h>
+
+namespace rld
+{
+  namespace tasks
+  {
+    /**
+     * A queued task and the group it is part of.
+     */
+    struct task
+    {
+      std::function < void () > run;
+      group*                    owner;
+    };
+
+    /**
+     * A thread's queue of tasks. The owner pushes and pops the back and
+     * other threads steal from the front.
+     */
+    struct queue
+    {
+      std::mutex          lock;
+      std::deque < task > tasks;
+    };
+
+    /**
+     * The scheduler. There is a queue for each pool thread and one for the
+     * threads that are not in the pool.
+     */
+    class scheduler
+    {
+    public:
+      scheduler ();
+      ~scheduler ();
+
+      /**
+       * Queue a task, starting the pool if needed.
+       */
+      void push (const task& t);
+
+      /**
+       * Run a queued task in the calling thread.
+       *
+       * @retval true A task was run.
+       * @retval false There are no queued tasks.
+       */
+      bool run_one ();
+
+      /**
+       * Set the number of jobs if the pool has not started.
+       */
+      void set_jobs (unsigned int jobs);
+
+      /**
+       * The number of jobs.
+       */
+      unsigned int jobs () const;
+
+    private:
+      /**
+       * Start the pool.
+       */
+      void start ();
+
+      /**
+       * Take a task, the calling thread's queue first.
+       */
+      bool pop (task& t);
+
+      /**
+       * Run a task catching its exception for the group.
+       */
+      void execute (task& t);
+
+      /**
+       * A pool thread.
+       */
+      void worker (size_t index);
+
+      std::vector < std::unique_ptr < queue > > queues;
+      std::vector < std::thread >               workers;
+      std::mutex                                lock;
+      std::condition_variable                   ready;
+      std::atomic < size_t >                    queued;
+      std::atomic < size_t >                    next_queue;
+      unsigned int                              jobs_;
+      bool                                      started;
+      bool                                      stopping;
+    };
+
+    /**
+     * The index of the calling thread's queue. A thread not in the pool
+     * uses the shared queue.
+     */
+    static thread_local size_t self = static_cast < size_t > (-1);
+
+    static scheduler&
+    the_scheduler ()
+    {
+      static scheduler sched;
+      return sched;
+    }
+
+    scheduler::scheduler ()
+      : queued (0),
+        next_queue (0),
+        jobs_ (default_jobs ()),
+        started (false),
+        stopping (false)
+    {
+    }
+
+    scheduler::~scheduler ()
+    {
+      {
+        std::lock_guard < std::mutex > guard (lock);
+        stopping = true;
+        ready.notify_all ();
+      }
+      for (auto& w : workers)
+        w.join ();
+    }
+
+    void
+    scheduler::set_jobs (unsigned int jobs)
+    {
+      std::lock_guard < std::mutex > guard (lock);
+      if (!started)
+        jobs_ = jobs < 1 ? 1 : jobs;
+    }
+
+    unsigned int
+    scheduler::jobs () const
+    {
+      return jobs_;
+    }
+
+    void
+    scheduler::start ()
+    {
+      /*
+       * Called with the lock held.
+       */
+      started = true;
+      size_t threads = jobs_ > 1 ? jobs_ - 1 : 1;
+      for (size_t q = 0; q <= threads; ++q)
+        queues.push_back (std::unique_ptr < queue > (new queue));
+      for (size_t w = 0; w < threads; ++w)
+        workers.push_back (std::thread (&scheduler::worker, this, w));
+    }
+
+    void
+    scheduler::push (const task& t)
+    {
+      {
+        std::lock_guard < std::mutex > guard (lock);
+        if (!started)
+          start ();
+      }
+
+      size_t q = self < queues.size () ? self : queues.size () - 1;
+
+      {
+        std::lock_guard < std::mutex > guard (queues[q]->lock);
+        queues[q]->tasks.push_back (t);
+      }
+
+      {
+        std::lock_guard < std::mutex > guard (lock);
+        ++queued;
+        ready.notify_one ();
+      }
+    }
+
+    bool
+    scheduler::pop (task& t)
+    {
+      if (queued == 0)
+        return false;
+
+      const size_t count = queues.size ();
+
+      if (self < count)
+      {
+        queue& own = *queues[self];
+        std::lock_guard < std::mutex > guard (own.lock);
+        if (!own.tasks.empty ())
+        {
+          t = own.tasks.back ();
+          own.tasks.pop_back ();
+          --queued;
+          return true;
+        }
+      }
+
+      size_t start = next_queue++;
+      for (size_t s = 0; s < count; ++s)
+      {
+        queue& other = *queues[(start + s) % count];
+        std::lock_guard < std::mutex > guard (other.lock);
+        if (!other.tasks.empty ())
+        {
+          t = other.tasks.front ();
+          other.tasks.pop_front ();
+          --queued;
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    bool
+    scheduler::run_one ()
+    {
+      {
+        std::lock_guard < std::mutex > guard (lock);
+        if (!started)
+          return false;
+      }
+      task t;
+      if (!pop (t))
+        return false;
+      execute (t);
+      return true;
+    }
+
+    void
+    scheduler::execute (task& t)
+    {
+      if (!t.owner->cancelled ())
+        t.owner->execute (t.run);
+      t.owner->finished ();
+    }
+
+    void
+    scheduler::worker (size_t index)
+    {
+      self = index;
+      while (true)
+      {
+        task t;
+        if (pop (t))
+        {
+          execute (t);
+          continue;
+        }
+        std::unique_lock < std::mutex > guard (lock);
+        ready.wait (guard, [this] { return stopping || (queued != 0); });
+        if (stopping && (queued == 0))
+          break;
+      }
+    }
+
+    unsigned int
+    default_jobs (unsigned int jobs)
+    {
+      const char* env = ::getenv (RLD_TASKS_JOBS_ENV);
+      if (env != 0)
+      {
+        char* end = 0;
+        unsigned long value = ::strtoul (env, &end, 10);
+        if ((end != env) && (*end == '\0'))
+        {
+          if (value == 0)
+            value = std::thread::hardware_concurrency ();
+          if (value > 0)
+            return value;
+        }
+      }
+      return jobs;
+    }
+
+    unsigned int
+    parse_jobs (const char* value)
+    {
+      char* end = 0;
+      long  jobs = ::strtol (value, &end, 0);
+      if ((end == value) || (*end != '\0') || (jobs < 0))
+        throw rld::error ("invalid jobs: " + std::string (value), "options");
+      if (jobs == 0)
+        jobs = std::thread::hardware_concurrency ();
+      return jobs < 1 ? 1 : jobs;
+    }
+
+    void
+    set_jobs (unsigned int jobs)
+    {
+      the_scheduler ().set_jobs (jobs);
+    }
+
+    unsigned int
+    jobs ()
+    {
+      return the_scheduler ().jobs ();
+    }
+
+    group::group ()
+      : pending (0),
+        cancelled_ (false)
+    {
+    }
+
+    group::~group ()
+    {
+      try
+      {
+        wait ();
+      }
+      catch (...)
+      {
+      }
+    }
+
+    void
+    group::run (const std::function < void () >& task_)
+    {
+      task t;
+      t.run = task_;
+      t.owner = this;
+      ++pending;
+      the_scheduler ().push (t);
+    }
+
+    void
+    group::wait ()
+    {
+      scheduler& sched = the_scheduler ();
+
+      while (pending != 0)
+      {
+        if (sched.run_one ())
+          continue;
+        std::unique_lock < std::mutex > guard (lock);
+        done.wait_for (guard, std::chrono::milliseconds (1),
+                       [this] { return pending == 0; });
+      }
+
+      std::exception_ptr e;
+      {
+        std::lock_guard < std::mutex > guard (lock);
+        e = error;
+        error = nullptr;
+      }
+      if (e)
+        std::rethrow_exception (e);
+    }
+
+    void
+    group::cancel ()
+    {
+      cancelled_ = true;
+    }
+
+    bool
+    group::cancelled () const
+    {
+      return cancelled_;
+    }
+
+    void
+    group::execute (const std::function < void () >& task_)
+    {
+      std::exception_ptr e;
+
+      try
+      {
+        task_ ();
+      }
+      catch (rld::error&)
+      {
+        e = std::current_exception ();
+      }
+      catch (std::exception& ex)
+      {
+        e = std::make_exception_ptr (rld::error (ex.what (), "tasks"));
+      }
+      catch (...)
+      {
+        e = std::current_exception ();
+      }
+
+      if (e)
+      {
+        std::lock_guard < std::mutex > guard (lock);
+        if (!error)
+          error = e;
+        cancelled_ = true;
+      }
+    }
+
+    void
+    group::finished ()
+    {
+      std::lock_guard < std::mutex > guard (lock);
+      --pending;
+      done.notify_all ();
+    }
+
+    void
+    parallel_for (size_t                                count,
+                  unsigned int                          jobs_,
+                  const std::function < void (size_t) >& body)
+    {
+      if (jobs_ == 0)
+        jobs_ = jobs ();
+
+      if ((jobs_ <= 1) || (count <= 1))
+      {
+        for (size_t i = 0; i < count; ++i)
+          body (i);
+        return;
+      }
+
+      size_t                 runners = count < jobs_ ? count : jobs_;
+      std::atomic < size_t > next (0);
+      group                  g;
+
+      auto runner = [&] () {
+        while (!g.cancelled ())
+        {
+          size_t i = next++;
+          if (i >= count)
+            break;
+          body (i);
+        }
+      };
+
+      for (size_t r = 1; r < runners; ++r)
+        g.run (runner);
+
+      g.execute (runner);
+      g.wait ();
+    }
+  }
+}
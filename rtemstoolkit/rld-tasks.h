@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026, Chris Johns <chrisj@rtems.org>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+/**
+ * @file
+ *
+ * @ingroup rtems-ld
+ *
+ * @brief A work stealing task scheduler shared by the tools.
+ *
+ * The scheduler has a pool of threads created when the first task is run.
+ * Each thread has a queue of tasks. A thread runs the tasks it queues last
+ * first and takes the oldest task from another thread's queue when its own
+ * queue is empty. A thread waiting for a group of tasks runs queued tasks
+ * while it waits so groups can be nested.
+ */
+
+#if !defined (_RLD_TASKS_H_)
+#define _RLD_TASKS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace rld
+{
+  namespace tasks
+  {
+    /**
+     * The environment variable holding the default number of jobs.
+     */
+    #define RLD_TASKS_JOBS_ENV "RTEMS_TOOLS_JOBS"
+
+    /**
+     * The default number of jobs. It is the value of RTEMS_TOOLS_JOBS if set
+     * and valid else the jobs passed.
+     *
+     * @param jobs The jobs if the environment variable is not set.
+     * @return unsigned int The number of jobs.
+     */
+    unsigned int default_jobs (unsigned int jobs = 1);
+
+    /**
+     * Parse a jobs option value. A value of 0 is the number of hardware
+     * threads.
+     *
+     * @param value The option's value.
+     * @return unsigned int The number of jobs.
+     * @throw rld::error The value is not a number.
+     */
+    unsigned int parse_jobs (const char* value);
+
+    /**
+     * Set the number of jobs the scheduler runs at once. The calling thread
+     * runs tasks while it waits so the pool has one less thread. The number
+     * is fixed once the first task is run.
+     *
+     * @param jobs The number of jobs.
+     */
+    void set_jobs (unsigned int jobs);
+
+    /**
+     * The number of jobs the scheduler runs at once.
+     */
+    unsigned int jobs ();
+
+    class scheduler;
+
+    /**
+     * A group of tasks. The first task to throw cancels the group, tasks not
+     * started are not run and the exception is rethrown by wait. An
+     * exception that is not a rld::error is rethrown as one.
+     */
+    class group
+    {
+    public:
+      group ();
+
+      /**
+       * Wait for the tasks. An exception from a task is lost.
+       */
+      ~group ();
+
+      /**
+       * Queue a task on the scheduler.
+       *
+       * @param task The task to run.
+       */
+      void run (const std::function < void () >& task);
+
+      /**
+       * Wait for the tasks to finish running the queued tasks while
+       * waiting.
+       *
+       * @throw rld::error The first error a task threw.
+       */
+      void wait ();
+
+      /**
+       * Cancel the tasks not started.
+       */
+      void cancel ();
+
+      /**
+       * Is the group cancelled? A long running task can check and return.
+       */
+      bool cancelled () const;
+
+      /**
+       * Run a task in the calling thread as part of the group. An exception
+       * is held and cancels the group.
+       *
+       * @param task The task to run.
+       */
+      void execute (const std::function < void () >& task);
+
+    private:
+      friend class scheduler;
+
+      /**
+       * Record a task has finished.
+       */
+      void finished ();
+
+      std::atomic < size_t > pending;      //< The tasks not finished.
+      std::atomic < bool >   cancelled_;   //< The group is cancelled.
+      std::mutex             lock;         //< Protect the error.
+      std::condition_variable done;        //< Signalled when a task finishes.
+      std::exception_ptr     error;        //< The first error.
+
+      /*
+       * Cannot copy a group.
+       */
+      group (const group& orig) = delete;
+      group& operator= (const group& rhs) = delete;
+    };
+
+    /**
+     * Run the body for each index from 0 to count less 1 using up to jobs
+     * tasks. The calling thread runs one of the tasks and the indexes are
+     * handed out in order. With one job or one index the body is called in
+     * the calling thread. The first exception stops the indexes not started
+     * and is rethrown.
+     *
+     * @param count The number of indexes.
+     * @param jobs The most tasks to run, 0 is the scheduler's jobs.
+     * @param body The body called with each index.
+     */
+    void parallel_for (size_t                                count,
+                       unsigned int                          jobs,
+                       const std::function < void (size_t) >& body);
+  }
+}
+
+#endif
@@ -26,7 +26,13 @@
 #include "config.h"
 #endif
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 #include <cxxabi.h>
 #include <sys/stat.h>
@@ -47,6 +53,37 @@ namespace rld
    */
   static std::string progname;
 
+  /**
+   * The interned strings. The elements of an unordered set do not move when
+   * it grows so references to them stay valid.
+   */
+  static std::unordered_set < std::string > interned;
+  static std::mutex                         interned_lock;
+
+  /**
+   * A trace event.
+   */
+  struct trace_record
+  {
+    std::string name;
+    std::string category;
+    std::string detail;
+    uint64_t    begin;
+    uint64_t    end;
+    int         lane;
+  };
+
+  /**
+   * The trace events. The threads are given lanes in the order they record
+   * their first event.
+   */
+  static bool                                  trace_enabled = false;
+  static std::string                           trace_path;
+  static std::chrono::steady_clock::time_point trace_start;
+  static std::vector < trace_record >          trace_records;
+  static std::map < std::thread::id, int >     trace_lanes;
+  static std::mutex                            trace_lock;
+
   /**
    * The option container.
    */
@@ -208,6 +245,13 @@ namespace rld
     return s;
   }
 
+  const std::string&
+  intern (const std::string& s)
+  {
+    std::lock_guard < std::mutex > guard (interned_lock);
+    return *interned.insert (s).first;
+  }
+
   void
   version_parse (const std::string& str,
                  uint64_t&          major,
@@ -258,6 +302,130 @@ namespace rld
     return verbose_level && (verbose_level >= level) ? verbose_level : 0;
   }
 
+  void
+  trace_events_enable (const std::string& path)
+  {
+    trace_path = path;
+    trace_start = std::chrono::steady_clock::now ();
+    trace_enabled = true;
+  }
+
+  bool
+  trace_events_enabled ()
+  {
+    return trace_enabled;
+  }
+
+  uint64_t
+  trace_clock ()
+  {
+    if (!trace_enabled)
+      return 0;
+    return std::chrono::duration_cast < std::chrono::microseconds > (
+      std::chrono::steady_clock::now () - trace_start).count ();
+  }
+
+  void
+  trace_event (const std::string& name,
+               const std::string& category,
+               uint64_t           begin,
+               uint64_t           end,
+               const std::string& detail,
+               int                lane)
+  {
+    if (!trace_enabled)
+      return;
+    std::lock_guard < std::mutex > guard (trace_lock);
+    if (lane == 0)
+    {
+      auto tl = trace_lanes.find (std::this_thread::get_id ());
+      if (tl == trace_lanes.end ())
+        tl = trace_lanes.insert (
+          std::make_pair (std::this_thread::get_id (),
+                          (int) trace_lanes.size () + 1)).first;
+      lane = tl->second;
+    }
+    trace_record tr = { name, category, detail, begin, end, lane };
+    trace_records.push_back (tr);
+  }
+
+  static const std::string
+  json_string (const std::string& s)
+  {
+    std::string js = "\"";
+    for (auto c : s)
+    {
+      if (c == '"' || c == '\\')
+      {
+        js += '\\';
+        js += c;
+      }
+      else if ((unsigned char) c < ' ')
+        js += ' ';
+      else
+        js += c;
+    }
+    return js + '"';
+  }
+
+  void
+  trace_events_write ()
+  {
+    if (!trace_enabled)
+      return;
+
+    std::lock_guard < std::mutex > guard (trace_lock);
+    std::ofstream                  out (trace_path.c_str (),
+                                        std::ios::out | std::ios::trunc);
+
+    if (!out.is_open ())
+      throw rld::error ("cannot open: " + trace_path, "trace-events");
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+        << "\"args\":{\"name\":" << json_string (get_program_name ()) << "}}";
+
+    for (auto& tr : trace_records)
+    {
+      out << ',' << std::endl
+          << "{\"name\":" << json_string (tr.name)
+          << ",\"cat\":" << json_string (tr.category)
+          << ",\"ph\":\"X\",\"ts\":" << tr.begin
+          << ",\"dur\":" << tr.end - tr.begin
+          << ",\"pid\":1,\"tid\":" << tr.lane;
+      if (!tr.detail.empty ())
+        out << ",\"args\":{\"detail\":" << json_string (tr.detail) << '}';
+      out << '}';
+    }
+
+    out << std::endl << "]}" << std::endl;
+
+    if (!out)
+      throw rld::error ("cannot write: " + trace_path, "trace-events");
+  }
+
+  span::span (const std::string& name, const char* category)
+    : category (category),
+      begin (0),
+      active (trace_enabled),
+      profiling (alloc::enabled ())
+  {
+    if (active || profiling)
+      this->name = name;
+    if (active)
+      begin = trace_clock ();
+    if (profiling)
+      alloc::get (allocs);
+  }
+
+  span::~span ()
+  {
+    if (active)
+      trace_event (name, category, begin, trace_clock ());
+    if (profiling)
+      alloc::phase (name, allocs);
+  }
+
   const std::string
   version ()
   {
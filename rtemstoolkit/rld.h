@@ -69,6 +69,7 @@ namespace rld
   }
 }
 
+#include <rld-alloc.h>
 #include <rld-elf-types.h>
 #include <rld-symbols.h>
 #include <rld-elf.h>
@@ -186,6 +187,15 @@ namespace rld
    */
   const std::string tolower (const std::string& sin);
 
+  /**
+   * Intern a string. The same reference is returned for strings with the
+   * same text and it is valid until the program exits. Names read from the
+   * ELF string tables are interned so each name is only held once no matter
+   * how many symbols, sections and relocations refer to it. It can be called
+   * from more than one thread.
+   */
+  const std::string& intern (const std::string& s);
+
   /**
    * Parse version string of format major.minor.revision where revieion can be
    * a git hash.
@@ -206,6 +216,66 @@ namespace rld
    */
   int verbose (int level = 0);
 
+  /**
+   * Enable the trace events and write them to the file when
+   * trace_events_write is called. The events are Chrome trace event JSON
+   * that can be loaded into chrome://tracing or Perfetto to see where the
+   * time of a tool goes.
+   */
+  void trace_events_enable (const std::string& path);
+
+  /**
+   * Are the trace events enabled ?
+   */
+  bool trace_events_enabled ();
+
+  /**
+   * The time in microseconds since the trace events were enabled.
+   */
+  uint64_t trace_clock ();
+
+  /**
+   * Record a trace event that began and ended at the trace clock times. The
+   * lane is the thread the event is shown on, 0 is the calling thread. It
+   * can be called from more than one thread and does nothing if the trace
+   * events are not enabled.
+   */
+  void trace_event (const std::string& name,
+                    const std::string& category,
+                    uint64_t           begin,
+                    uint64_t           end,
+                    const std::string& detail = "",
+                    int                lane = 0);
+
+  /**
+   * Write the trace events to the file if enabled.
+   */
+  void trace_events_write ();
+
+  /**
+   * A span records a trace event from its construction to its
+   * destruction. It is cheap when the trace events are not enabled. The
+   * allocations made while it is active are recorded as a phase if the
+   * allocation profiling is enabled.
+   */
+  class span
+  {
+  public:
+    span (const std::string& name, const char* category = "rld");
+    ~span ();
+
+  private:
+    span (const span&);
+    span& operator= (const span&);
+
+    std::string     name;      //< The name of the span if enabled.
+    const char*     category;  //< The category of the span.
+    uint64_t        begin;     //< The trace clock at the start.
+    bool            active;    //< The trace events are enabled.
+    bool            profiling; //< The allocation profiling is enabled.
+    alloc::counters allocs;    //< The allocation counters at the start.
+  };
+
   /**
    * The version string.
    */
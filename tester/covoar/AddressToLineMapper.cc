@@ -5,6 +5,8 @@
  *  of the AddressToLineMapper class.
  */
 
+#include <algorithm>
+
 #include "AddressToLineMapper.h"
 
 namespace Coverage {
@@ -19,13 +21,9 @@ namespace Coverage {
     return is_end_sequence;
   }
 
-  const std::string SourceLine::path() const
+  uint32_t SourceLine::file() const
   {
-    if (!path_) {
-      return "unknown";
-    } else {
-      return *path_;
-    }
+    return file_id;
   }
 
   int SourceLine::line() const
@@ -33,15 +31,18 @@ namespace Coverage {
     return line_num;
   }
 
-  void AddressLineRange::addSourceLine(const rld::dwarf::address& address)
+  void AddressLineRange::addSourceLine(
+    const rld::dwarf::address& address,
+    uint32_t file
+  )
   {
-    auto insertResult = sourcePaths.insert(
-      std::make_shared<std::string>(address.path()));
+    if (!sourceLines.empty() && address.location() < sourceLines.back().location())
+      sorted = false;
 
     sourceLines.emplace_back(
       SourceLine (
         address.location(),
-        *insertResult.first,
+        file,
         address.line(),
         address.is_an_end_sequence()
       )
@@ -50,10 +51,39 @@ namespace Coverage {
 
   const SourceLine& AddressLineRange::getSourceLine(uint32_t address) const
   {
-    if (address < lowAddress || address > highAddress) {
+    const SourceLine* line = findSourceLine(address);
+
+    if (line == nullptr) {
       throw SourceNotFoundError(std::to_string(address));
     }
 
+    return *line;
+  }
+
+  const SourceLine* AddressLineRange::findSourceLine(uint32_t address) const
+  {
+    if (address < lowAddress || address > highAddress) {
+      return nullptr;
+    }
+
+    if (sorted) {
+      // The first line at or above the address, otherwise the line before.
+      auto line = std::lower_bound(
+        sourceLines.begin(),
+        sourceLines.end(),
+        address,
+        [](const SourceLine& l, uint32_t a) { return l.location() < a; }
+      );
+
+      if (line != sourceLines.end() && line->location() == address)
+        return &*line;
+
+      if (line == sourceLines.begin())
+        return nullptr;
+
+      return &*(line - 1);
+    }
+
     const SourceLine* last_line = nullptr;
     for (const auto &line : sourceLines) {
       if (address <= line.location())
@@ -65,11 +95,7 @@ namespace Coverage {
       last_line = &line;
     }
 
-    if (last_line == nullptr) {
-      throw SourceNotFoundError(std::to_string(address));
-    }
-
-    return *last_line;
+    return last_line;
   }
 
   void AddressToLineMapper::getSource(
@@ -77,21 +103,119 @@ namespace Coverage {
     std::string& sourceFile,
     int& sourceLine
   ) const {
-    const SourceLine default_sourceline = SourceLine();
-    const SourceLine* match = &default_sourceline;
+    if (!lineTable.empty()) {
+      auto entry = std::upper_bound(
+        lineTable.begin(),
+        lineTable.end(),
+        address,
+        [](uint32_t a, const lineTableEntry_t& e) { return a < e.address; }
+      );
+
+      if (entry == lineTable.begin()) {
+        sourceFile = paths[0];
+        sourceLine = -1;
+      } else {
+        --entry;
+        sourceFile = paths[entry->file];
+        sourceLine = entry->line;
+      }
+      return;
+    }
+
+    const SourceLine* match = findSource(address);
+
+    if (match == nullptr) {
+      sourceFile = paths[0];
+      sourceLine = -1;
+    } else {
+      sourceFile = paths[match->file()];
+      sourceLine = match->line();
+    }
+  }
+
+  void AddressToLineMapper::getSources(
+    const std::vector<uint32_t>& addresses,
+    std::vector<std::string>& sourceFiles,
+    std::vector<int>& sourceLines
+  ) const {
+    sourceFiles.resize(addresses.size());
+    sourceLines.resize(addresses.size());
+
+    if (lineTable.empty()) {
+      for (size_t a = 0; a < addresses.size(); ++a)
+        getSource(addresses[a], sourceFiles[a], sourceLines[a]);
+      return;
+    }
+
+    // Merge the addresses with the line table.  The position in the table
+    // only moves back if the addresses are not sorted.
+    size_t entry = 0;
+
+    for (size_t a = 0; a < addresses.size(); ++a) {
+      uint32_t address = addresses[a];
+
+      if (entry > 0 && lineTable[entry - 1].address > address)
+        entry = 0;
+
+      while (entry < lineTable.size() && lineTable[entry].address <= address)
+        ++entry;
+
+      if (entry == 0) {
+        sourceFiles[a] = paths[0];
+        sourceLines[a] = -1;
+      } else {
+        sourceFiles[a] = paths[lineTable[entry - 1].file];
+        sourceLines[a] = lineTable[entry - 1].line;
+      }
+    }
+  }
+
+  const SourceLine* AddressToLineMapper::findSource(uint32_t address) const
+  {
+    const SourceLine* match = nullptr;
+
+    auto consider = [&](const AddressLineRange& range) {
+      const SourceLine* potential_match = range.findSourceLine(address);
+
+      if (
+        potential_match != nullptr &&
+        (
+          match == nullptr ||
+          match->is_an_end_sequence() ||
+          !potential_match->is_an_end_sequence()
+        )
+      ) {
+        match = potential_match;
+      }
+    };
+
+    if (rangeIndex.size() == addressLineRanges.size()) {
+      // The ranges which may contain the address are below the first entry
+      // with a higher low address.  Visit them in their original order.
+      std::vector<size_t> candidates;
+      auto entry = std::upper_bound(
+        rangeIndex.begin(),
+        rangeIndex.end(),
+        address,
+        [](uint32_t a, const rangeIndexEntry_t& e) { return a < e.low; }
+      );
 
-    for (const auto &range : addressLineRanges) {
-      try {
-        const SourceLine& potential_match = range.getSourceLine(address);
+      while (entry != rangeIndex.begin() && (entry - 1)->maxHigh >= address) {
+        --entry;
+        if (addressLineRanges[entry->range].high() >= address)
+          candidates.push_back(entry->range);
+      }
 
-        if (match->is_an_end_sequence() || !potential_match.is_an_end_sequence()) {
-          match = &potential_match;
-        }
-      } catch (const AddressLineRange::SourceNotFoundError&) {}
+      std::sort(candidates.begin(), candidates.end());
+
+      for (size_t r : candidates)
+        consider(addressLineRanges[r]);
+    } else {
+      for (const auto &range : addressLineRanges)
+        consider(range);
     }
 
-    sourceFile = match->path();
-    sourceLine = match->line();
+    return match;
   }
 
   AddressLineRange& AddressToLineMapper::makeRange(
@@ -106,4 +230,96 @@ namespace Coverage {
     return addressLineRanges.back();
   }
 
+  void AddressToLineMapper::addSourceLine(
+    AddressLineRange& range,
+    const rld::dwarf::address& address
+  )
+  {
+    range.addSourceLine(address, internPath(address.path()));
+  }
+
+  uint32_t AddressToLineMapper::internPath(const std::string& path)
+  {
+    auto id = pathIds.find(path);
+
+    if (id != pathIds.end())
+      return id->second;
+
+    uint32_t file = paths.size();
+    paths.push_back(path);
+    pathIds.emplace(path, file);
+
+    return file;
+  }
+
+  void AddressToLineMapper::indexRanges()
+  {
+    rangeIndex.clear();
+    rangeIndex.reserve(addressLineRanges.size());
+
+    for (size_t r = 0; r < addressLineRanges.size(); ++r) {
+      const AddressLineRange& range = addressLineRanges[r];
+      rangeIndex.push_back({ range.low(), range.high(), r });
+    }
+
+    std::stable_sort(
+      rangeIndex.begin(),
+      rangeIndex.end(),
+      [](const rangeIndexEntry_t& a, const rangeIndexEntry_t& b) {
+        return a.low < b.low;
+      }
+    );
+
+    uint32_t maxHigh = 0;
+    for (auto& entry : rangeIndex) {
+      maxHigh = std::max(maxHigh, entry.maxHigh);
+      entry.maxHigh = maxHigh;
+    }
+
+    // The source of an address only changes where a range starts or ends
+    // and at and after the address of a line, an exact match of a line's
+    // address picks the first of lines with the same address.  Look up the
+    // source at each of these addresses once and the line table holds the
+    // changes.
+    std::vector<uint32_t> boundaries;
+
+    for (const auto& range : addressLineRanges) {
+      boundaries.push_back(range.low());
+      if (range.high() != UINT32_MAX)
+        boundaries.push_back(range.high() + 1);
+      for (const auto& line : range.lines()) {
+        uint32_t location = line.location();
+        boundaries.push_back(location);
+        if (location != UINT32_MAX)
+          boundaries.push_back(location + 1);
+      }
+    }
+
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(
+      std::unique(boundaries.begin(), boundaries.end()),
+      boundaries.end()
+    );
+
+    lineTable.clear();
+
+    for (uint32_t address : boundaries) {
+      const SourceLine* match = findSource(address);
+      lineTableEntry_t entry = { address, 0, -1 };
+
+      if (match != nullptr) {
+        entry.file = match->file();
+        entry.line = match->line();
+      }
+
+      if (
+        lineTable.empty() ||
+        lineTable.back().file != entry.file ||
+        lineTable.back().line != entry.line
+      ) {
+        lineTable.push_back(entry);
+      }
+    }
+  }
+
 }
@@ -8,9 +8,8 @@
 #define __ADDRESS_TO_LINE_MAPPER_H__
 
 #include <cstdint>
-#include <memory>
-#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <rld-dwarf.h>
@@ -27,7 +26,7 @@ namespace Coverage {
 
     SourceLine()
     : address(0),
-      path_(nullptr),
+      file_id(0),
       line_num(-1),
       is_end_sequence(true)
     {
@@ -35,11 +34,11 @@ namespace Coverage {
 
     SourceLine(
       uint64_t addr,
-      const std::shared_ptr<std::string>& src,
+      uint32_t file,
       int line,
       bool end_sequence
     ) : address(addr),
-        path_(src),
+        file_id(file),
         line_num(line),
         is_end_sequence(end_sequence)
     {
@@ -61,11 +60,13 @@ namespace Coverage {
     bool is_an_end_sequence() const;
 
     /*!
-     *  This method gets the source file path of this address.
+     *  This method gets the identifier of the source file path of this
+     *  address. The AddressToLineMapper holding the line maps it to the
+     *  path.
      *
-     *  @return Returns the source file path of this address
+     *  @return Returns the source file path identifier of this address
      */
-    const std::string path() const;
+    uint32_t file() const;
 
     /*!
      *  This method gets the source line number of this address.
@@ -82,10 +83,9 @@ namespace Coverage {
     uint64_t address;
 
     /*!
-     *  An iterator pointing to the location in the set that contains the
-     *  source file path of the address.
+     *  The identifier of the source file path of the address.
      */
-    const std::shared_ptr<std::string> path_;
+    uint32_t file_id;
 
     /*!
      *  The source line number of the address.
@@ -101,18 +101,6 @@ namespace Coverage {
 
   typedef std::vector<SourceLine> SourceLines;
 
-  /* This allows comparison of strings owned by shared_ptrs. */
-  struct SharedStringCmp {
-    bool operator()(
-      const std::shared_ptr<std::string>& lhs,
-      const std::shared_ptr<std::string>& rhs
-    ) const {
-      return *lhs < *rhs;
-    }
-  };
-
-  typedef std::set<std::shared_ptr<std::string>, SharedStringCmp> SourcePaths;
-
   /*! @class AddressLineRange
    *
    *  This class stores source information for an address range.
@@ -137,8 +125,9 @@ namespace Coverage {
      *  This method adds source and line information for a specified address.
      *
      *  @param[in] address specifies the DWARF address information
+     *  @param[in] file specifies the identifier of the source file path
      */
-    void addSourceLine(const rld::dwarf::address& address);
+    void addSourceLine(const rld::dwarf::address& address, uint32_t file);
 
     /*!
      *  This method gets the source file name and line number for a given
@@ -150,6 +139,32 @@ namespace Coverage {
      */
     const SourceLine& getSourceLine(uint32_t address) const;
 
+    /*!
+     *  This method gets the source file name and line number for a given
+     *  address without throwing an exception.
+     *
+     *  @param[in] address specifies the address to look up
+     *
+     *  @return Returns the source information for the specified address or
+     *          NULL if this range has none.
+     */
+    const SourceLine* findSourceLine(uint32_t address) const;
+
+    /*!
+     *  This method gets the low address of this range.
+     */
+    uint32_t low() const { return lowAddress; }
+
+    /*!
+     *  This method gets the high address of this range.
+     */
+    uint32_t high() const { return highAddress; }
+
+    /*!
+     *  This method gets the source information of this range.
+     */
+    const SourceLines& lines() const { return sourceLines; }
+
   private:
 
     /*!
@@ -168,9 +183,10 @@ namespace Coverage {
     SourceLines sourceLines;
 
     /*!
-     *  The set of source file names for this range.
+     *  Whether the source information is sorted by address so that it can
+     *  be searched by bisection.
      */
-    SourcePaths sourcePaths;
+    bool sorted = true;
 
   };
 
@@ -198,6 +214,21 @@ namespace Coverage {
       int& sourceLine
     ) const;
 
+    /*!
+     *  This method gets the source file names and line numbers for a list
+     *  of addresses. The line table is walked once when the addresses are
+     *  sorted.
+     *
+     *  @param[in] addresses specifies the addresses to look up
+     *  @param[out] sourceFiles specifies the names of the source files
+     *  @param[out] sourceLines specifies the line numbers in the source files
+     */
+    void getSources(
+      const std::vector<uint32_t>& addresses,
+      std::vector<std::string>& sourceFiles,
+      std::vector<int>& sourceLines
+    ) const;
+
     /*!
      *  This method creates a new range with the specified addresses.
      *
@@ -208,13 +239,87 @@ namespace Coverage {
      */
     AddressLineRange& makeRange(uint32_t low, uint32_t high);
 
+    /*!
+     *  This method adds source and line information to a range.
+     *
+     *  @param[in] range specifies the range made by this mapper
+     *  @param[in] address specifies the DWARF address information
+     */
+    void addSourceLine(
+      AddressLineRange& range,
+      const rld::dwarf::address& address
+    );
+
+    /*!
+     *  This method indexes the ranges by address and builds the line table.
+     *  It is called once all ranges are made.  Without the index, a look up
+     *  visits every range.
+     */
+    void indexRanges();
+
   private:
 
+    /*!
+     *  This method finds the source information for an address in the
+     *  ranges.
+     *
+     *  @param[in] address specifies the address to look up
+     *
+     *  @return Returns the source information or NULL if there is none.
+     */
+    const SourceLine* findSource(uint32_t address) const;
+
+    /*!
+     *  This method returns the identifier of a source file path, adding
+     *  the path if it is new.
+     */
+    uint32_t internPath(const std::string& path);
+
+    /*!
+     *  This type is an entry of the line table.  The source file and line
+     *  of an entry hold from its address to the address of the next entry.
+     */
+    struct lineTableEntry_t {
+      uint32_t address;  // the first address of the entry
+      uint32_t file;     // the identifier of the source file path
+      int      line;     // the source line number
+    };
+
+    /*!
+     *  This type is an entry of the range index.
+     */
+    struct rangeIndexEntry_t {
+      uint32_t low;      // the low address of the range
+      uint32_t maxHigh;  // the high address of all entries up to this one
+      size_t   range;    // the position of the range
+    };
+
     /*!
      *  The address and line information ranges.
      */
     AddressLineRanges addressLineRanges;
 
+    /*!
+     *  The ranges sorted by the low address.
+     */
+    std::vector<rangeIndexEntry_t> rangeIndex;
+
+    /*!
+     *  The line table sorted by address.  It spans all ranges.
+     */
+    std::vector<lineTableEntry_t> lineTable;
+
+    /*!
+     *  The source file paths.  The identifier of a path is its position and
+     *  the first path is used for addresses with no source information.
+     */
+    std::vector<std::string> paths = { "unknown" };
+
+    /*!
+     *  The identifiers of the source file paths.
+     */
+    std::unordered_map<std::string, uint32_t> pathIds;
+
   };
 
 }
@@ -0,0 +1,805 @@
+/*! @file CoverageDatabase.cc
+ *  @brief CoverageDatabase Implementation
+ *
+ *  This file contains the implementation of the database of the unified
+ *  coverage of the desired symbols.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <rld.h>
+#include <rld-tasks.h>
+
+#include "CoverageDatabase.h"
+#include "CoverageMap.h"
+#include "CoverageReaderBase.h"
+
+namespace Coverage {
+
+  /*
+   * The database header. Change the version if the format changes.
+   */
+  static const char     databaseMagic[8] = { 'C', 'O', 'V', 'D', 'B', 0, 0, 0 };
+  static const uint32_t databaseVersion = 1;
+
+  /*
+   * The database flags.
+   */
+  static const uint32_t databaseBranchInfo = 1 << 0;
+
+  static bool testBit( const std::vector<uint64_t>& bits, size_t slot )
+  {
+    return ( bits[ slot / 64 ] & ( 1ULL << ( slot % 64 ) ) ) != 0;
+  }
+
+  static void setBit( std::vector<uint64_t>& bits, size_t slot )
+  {
+    bits[ slot / 64 ] |= 1ULL << ( slot % 64 );
+  }
+
+  /*
+   * Count the bits set in a word.
+   */
+  static inline size_t popcount( uint64_t word )
+  {
+#if defined(__GNUC__)
+    return __builtin_popcountll( word );
+#else
+    size_t count = 0;
+    while ( word ) {
+      word &= word - 1;
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+  /*
+   * Return the index of the lowest bit set in a word that is not zero.
+   */
+  static inline size_t ctz( uint64_t word )
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll( word );
+#else
+    size_t index = 0;
+    while ( ( word & 1 ) == 0 ) {
+      word >>= 1;
+      ++index;
+    }
+    return index;
+#endif
+  }
+
+  /*
+   * Return the bitmap of the slots with a count that is not zero.
+   */
+  static std::vector<uint64_t> countBits(
+    const std::vector<uint32_t>& counts,
+    size_t                       words
+  )
+  {
+    std::vector<uint64_t> bits( words );
+
+    for ( size_t slot = 0; slot < counts.size(); ++slot ) {
+      if ( counts[ slot ] != 0 ) {
+        setBit( bits, slot );
+      }
+    }
+
+    return bits;
+  }
+
+  /*
+   * Call the function with the first and last slot of each run of set
+   * bits.
+   */
+  static void forEachRange(
+    const std::vector<uint64_t>&                  bits,
+    size_t                                        size,
+    const std::function<void( size_t, size_t )>& range
+  )
+  {
+    size_t words = bits.size();
+    size_t slot = 0;
+
+    while ( slot < size ) {
+      size_t   w = slot / 64;
+      uint64_t word = bits[ w ] & ( ~0ULL << ( slot % 64 ) );
+
+      while ( word == 0 && ++w < words ) {
+        word = bits[ w ];
+      }
+
+      if ( w >= words ) {
+        break;
+      }
+
+      size_t low = w * 64 + ctz( word );
+
+      word = ~bits[ w ] & ( ~0ULL << ( low % 64 ) );
+
+      while ( word == 0 && ++w < words ) {
+        word = ~bits[ w ];
+      }
+
+      size_t high = w >= words ? size : std::min( size, w * 64 + ctz( word ) );
+
+      range( low, high - 1 );
+      slot = high;
+    }
+  }
+
+  /*
+   * Return the number of bits set from the first to the last slot.
+   */
+  static size_t countRange(
+    const std::vector<uint64_t>& bits,
+    size_t                       first,
+    size_t                       last
+  )
+  {
+    size_t count = 0;
+
+    for ( size_t w = first / 64; w <= last / 64; ++w ) {
+      uint64_t word = bits[ w ];
+
+      if ( w == first / 64 ) {
+        word &= ~0ULL << ( first % 64 );
+      }
+      if ( w == last / 64 && last % 64 != 63 ) {
+        word &= ( 1ULL << ( last % 64 + 1 ) ) - 1;
+      }
+
+      count += popcount( word );
+    }
+
+    return count;
+  }
+
+  /*
+   * Runs the task for each index up to count as up to jobs tasks on the
+   * shared scheduler. The first exception thrown by a task is rethrown.
+   */
+  static void runTasks(
+    size_t                               count,
+    int                                  jobs,
+    const std::function<void( size_t )>& task
+  )
+  {
+    rld::tasks::parallel_for( count, std::max( jobs, 1 ), task );
+  }
+
+  static void writeU32( std::vector<char>& out, uint32_t value )
+  {
+    for ( int b = 0; b < 4; ++b ) {
+      out.push_back( static_cast<char>( value >> ( 8 * b ) ) );
+    }
+  }
+
+  static void writeCount( std::vector<char>& out, uint32_t value )
+  {
+    while ( value >= 0x80 ) {
+      out.push_back( static_cast<char>( ( value & 0x7f ) | 0x80 ) );
+      value >>= 7;
+    }
+    out.push_back( static_cast<char>( value ) );
+  }
+
+  static void writeString( std::vector<char>& out, const std::string& s )
+  {
+    writeU32( out, s.size() );
+    out.insert( out.end(), s.begin(), s.end() );
+  }
+
+  static void writeBitmap(
+    std::vector<char>&           out,
+    const std::vector<uint32_t>& counts
+  )
+  {
+    for ( size_t slot = 0; slot < counts.size(); slot += 8 ) {
+      uint8_t byte = 0;
+
+      for ( size_t b = 0; b < 8 && slot + b < counts.size(); ++b ) {
+        if ( counts[ slot + b ] != 0 ) {
+          byte |= 1 << b;
+        }
+      }
+
+      out.push_back( static_cast<char>( byte ) );
+    }
+  }
+
+  static void writeCounts(
+    std::vector<char>&           out,
+    const std::vector<uint32_t>& counts
+  )
+  {
+    for ( auto count : counts ) {
+      if ( count != 0 ) {
+        writeCount( out, count );
+      }
+    }
+  }
+
+  /*
+   * The read position in the contents of a database file.
+   */
+  class DatabaseReader {
+
+  public:
+
+    DatabaseReader( const std::string& fileName, const CoverageFile& file )
+      : fileName_m( fileName ),
+        data_m( file.data() ),
+        size_m( file.size() ),
+        offset_m( 0 )
+    {
+    }
+
+    const uint8_t* bytes( size_t length )
+    {
+      if ( length > size_m - offset_m ) {
+        throw rld::error(
+          "Invalid coverage database: " + fileName_m,
+          "CoverageDatabase::load"
+        );
+      }
+
+      const uint8_t* b = data_m + offset_m;
+      offset_m += length;
+      return b;
+    }
+
+    uint32_t u32()
+    {
+      const uint8_t* b = bytes( 4 );
+      return b[0] | ( b[1] << 8 ) | ( b[2] << 16 ) |
+        ( static_cast<uint32_t>( b[3] ) << 24 );
+    }
+
+    uint32_t count()
+    {
+      uint32_t value = 0;
+
+      for ( int shift = 0; shift < 35; shift += 7 ) {
+        uint8_t b = *bytes( 1 );
+        value |= static_cast<uint32_t>( b & 0x7f ) << shift;
+        if ( ( b & 0x80 ) == 0 ) {
+          return value;
+        }
+      }
+
+      throw rld::error(
+        "Invalid count in coverage database: " + fileName_m,
+        "CoverageDatabase::load"
+      );
+    }
+
+    std::string string()
+    {
+      uint32_t       length = u32();
+      const uint8_t* b = bytes( length );
+      return std::string( reinterpret_cast<const char*>( b ), length );
+    }
+
+  private:
+
+    const std::string& fileName_m;
+    const uint8_t*     data_m;
+    size_t             size_m;
+    size_t             offset_m;
+  };
+
+  CoverageDatabase::CoverageDatabase()
+    : branchInfoAvailable_m( false )
+  {
+  }
+
+  CoverageDatabase::~CoverageDatabase()
+  {
+  }
+
+  void CoverageDatabase::load( const std::string& fileName )
+  {
+    CoverageFile     file( fileName, "CoverageDatabase::load" );
+
+    file.wait( file.size() );
+
+    DatabaseReader   in( fileName, file );
+    CoverageDatabase loaded;
+
+    if (
+      ::memcmp( in.bytes( sizeof( databaseMagic ) ),
+                databaseMagic,
+                sizeof( databaseMagic ) ) != 0 ||
+      in.u32() != databaseVersion
+    ) {
+      throw rld::error(
+        "Not a coverage database: " + fileName,
+        "CoverageDatabase::load"
+      );
+    }
+
+    loaded.branchInfoAvailable_m = ( in.u32() & databaseBranchInfo ) != 0;
+
+    uint32_t buildCount = in.u32();
+
+    for ( uint32_t b = 0; b < buildCount; ++b ) {
+      loaded.builds_m.insert( loaded.builds_m.end(), in.string() );
+    }
+
+    uint32_t symbolCount = in.u32();
+
+    for ( uint32_t s = 0; s < symbolCount; ++s ) {
+      std::string      symbolName = in.string();
+      symbolCoverage_t coverage;
+
+      coverage.size = in.u32();
+
+      size_t         bitmapSize = ( coverage.size + 7 ) / 8;
+      const uint8_t* start = in.bytes( bitmapSize );
+      const uint8_t* executed = in.bytes( bitmapSize );
+      const uint8_t* taken = in.bytes( bitmapSize );
+      const uint8_t* notTaken = in.bytes( bitmapSize );
+
+      auto test = []( const uint8_t* bitmap, size_t slot ) {
+        return ( bitmap[ slot / 8 ] & ( 1 << ( slot % 8 ) ) ) != 0;
+      };
+
+      coverage.startOfInstruction.resize( ( coverage.size + 63 ) / 64 );
+      for ( size_t byte = 0; byte < bitmapSize; ++byte ) {
+        coverage.startOfInstruction[ byte / 8 ] |=
+          static_cast<uint64_t>( start[ byte ] ) << ( 8 * ( byte % 8 ) );
+      }
+
+      auto counts = [&]( const uint8_t* bitmap, std::vector<uint32_t>& to ) {
+        to.resize( coverage.size );
+        for ( size_t slot = 0; slot < coverage.size; ++slot ) {
+          if ( test( bitmap, slot ) ) {
+            to[ slot ] = in.count();
+          }
+        }
+      };
+
+      counts( executed, coverage.executed );
+      counts( taken, coverage.taken );
+      counts( notTaken, coverage.notTaken );
+
+      loaded.symbols_m.insert(
+        loaded.symbols_m.end(),
+        std::make_pair( std::move( symbolName ), std::move( coverage ) )
+      );
+    }
+
+    merge( loaded );
+  }
+
+  void CoverageDatabase::reduce(
+    const std::vector<std::string>& fileNames,
+    int                             jobs
+  )
+  {
+    std::vector<CoverageDatabase> parts( fileNames.size() );
+
+    runTasks(
+      parts.size(),
+      jobs,
+      [&]( size_t p ) { parts[ p ].load( fileNames[ p ] ); }
+    );
+
+    // Merge each part into the part to its left, doubling the distance
+    // between the parts at each level. The left most occurrence of a
+    // symbol is kept if the sizes differ, as when loading in order.
+    for ( size_t stride = 1; stride < parts.size(); stride *= 2 ) {
+      size_t pairs = ( parts.size() + stride - 1 ) / ( 2 * stride );
+
+      runTasks(
+        pairs,
+        jobs,
+        [&]( size_t p ) {
+          size_t left = p * 2 * stride;
+          parts[ left ].merge( parts[ left + stride ] );
+          parts[ left + stride ] = CoverageDatabase();
+        }
+      );
+    }
+
+    if ( !parts.empty() ) {
+      merge( parts.front() );
+    }
+  }
+
+  void CoverageDatabase::write( const std::string& fileName ) const
+  {
+    std::vector<char> out;
+    std::ofstream     file;
+
+    out.insert( out.end(), databaseMagic, databaseMagic + sizeof( databaseMagic ) );
+    writeU32( out, databaseVersion );
+    writeU32( out, branchInfoAvailable_m ? databaseBranchInfo : 0 );
+
+    writeU32( out, builds_m.size() );
+    for ( const auto& build : builds_m ) {
+      writeString( out, build );
+    }
+
+    writeU32( out, symbols_m.size() );
+    for ( const auto& s : symbols_m ) {
+      const symbolCoverage_t& coverage = s.second;
+
+      writeString( out, s.first );
+      writeU32( out, coverage.size );
+
+      for ( size_t byte = 0; byte < ( coverage.size + 7 ) / 8; ++byte ) {
+        out.push_back(
+          static_cast<char>(
+            coverage.startOfInstruction[ byte / 8 ] >> ( 8 * ( byte % 8 ) )
+          )
+        );
+      }
+
+      writeBitmap( out, coverage.executed );
+      writeBitmap( out, coverage.taken );
+      writeBitmap( out, coverage.notTaken );
+      writeCounts( out, coverage.executed );
+      writeCounts( out, coverage.taken );
+      writeCounts( out, coverage.notTaken );
+    }
+
+    file.open( fileName, std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( !file.is_open() ) {
+      throw rld::error(
+        "Unable to create " + fileName,
+        "CoverageDatabase::write"
+      );
+    }
+
+    file.write( out.data(), out.size() );
+    file.close();
+    if ( file.fail() ) {
+      throw rld::error(
+        "Unable to write " + fileName,
+        "CoverageDatabase::write"
+      );
+    }
+  }
+
+  void CoverageDatabase::merge( const CoverageDatabase& other )
+  {
+    // Both maps are ordered by the symbol names so a single pass over
+    // each merges them.
+    symbols_t::iterator       d = symbols_m.begin();
+    symbols_t::const_iterator s = other.symbols_m.begin();
+
+    while ( s != other.symbols_m.end() ) {
+      while ( d != symbols_m.end() && d->first < s->first ) {
+        ++d;
+      }
+
+      if ( d != symbols_m.end() && d->first == s->first ) {
+        sum( s->first, d->second, s->second );
+        ++d;
+      } else {
+        symbols_m.insert( d, *s );
+      }
+
+      ++s;
+    }
+
+    builds_m.insert( other.builds_m.begin(), other.builds_m.end() );
+
+    if ( other.branchInfoAvailable_m ) {
+      branchInfoAvailable_m = true;
+    }
+  }
+
+  void CoverageDatabase::sum(
+    const std::string&      symbolName,
+    symbolCoverage_t&       destination,
+    const symbolCoverage_t& source
+  )
+  {
+    if ( destination.size != source.size ) {
+      std::cerr << "INFO: CoverageDatabase::merge - Unable to merge "
+                << "coverage for " << symbolName
+                << " because the sizes are different ("
+                << "size: " << destination.size
+                << ", source: " << source.size << ')'
+                << std::endl;
+      return;
+    }
+
+    // Keep the loops simple so that they are vectorized.
+    uint64_t*       dBits = destination.startOfInstruction.data();
+    const uint64_t* sBits = source.startOfInstruction.data();
+    size_t          words = source.startOfInstruction.size();
+
+    for ( size_t w = 0; w < words; ++w ) {
+      dBits[ w ] |= sBits[ w ];
+    }
+
+    auto add = []( std::vector<uint32_t>& d, const std::vector<uint32_t>& s ) {
+      uint32_t*       dCounts = d.data();
+      const uint32_t* sCounts = s.data();
+      size_t          n = s.size();
+
+      for ( size_t slot = 0; slot < n; ++slot ) {
+        dCounts[ slot ] += sCounts[ slot ];
+      }
+    };
+
+    add( destination.executed, source.executed );
+    add( destination.taken, source.taken );
+    add( destination.notTaken, source.notTaken );
+  }
+
+  void CoverageDatabase::addBuild( const std::string& buildKey )
+  {
+    builds_m.insert( buildKey );
+  }
+
+  void CoverageDatabase::mergeInto( DesiredSymbols& symbolsToAnalyze ) const
+  {
+    for ( const auto& s : symbols_m ) {
+      SymbolInformation* sinfo = symbolsToAnalyze.find( s.first );
+
+      if ( sinfo == nullptr || sinfo->unifiedCoverageMap == nullptr ) {
+        continue;
+      }
+
+      CoverageMapBase*        map = sinfo->unifiedCoverageMap;
+      const symbolCoverage_t& coverage = s.second;
+
+      if ( map->getSize() != coverage.size ) {
+        std::cerr << "INFO: CoverageDatabase::mergeInto - Unable to merge "
+                  << "coverage for " << s.first
+                  << " because the sizes are different ("
+                  << "size: " << map->getSize()
+                  << ", database: " << coverage.size << ')'
+                  << std::endl;
+        continue;
+      }
+
+      for ( uint32_t slot = 0; slot < coverage.size; ++slot ) {
+        if ( testBit( coverage.startOfInstruction, slot ) ) {
+          map->setIsStartOfInstruction( slot );
+        }
+
+        if ( coverage.executed[ slot ] != 0 ) {
+          map->sumWasExecuted( slot, coverage.executed[ slot ] );
+        }
+
+        if ( coverage.taken[ slot ] != 0 ) {
+          map->sumWasTaken( slot, coverage.taken[ slot ] );
+        }
+
+        if ( coverage.notTaken[ slot ] != 0 ) {
+          map->sumWasNotTaken( slot, coverage.notTaken[ slot ] );
+        }
+      }
+    }
+  }
+
+  void CoverageDatabase::update(
+    const DesiredSymbols& symbolsToAnalyze,
+    const ExecutableInfo* executable
+  )
+  {
+    typedef DesiredSymbols::symbolSet_t::value_type symbol_t;
+
+    symbols_t::iterator          d = symbols_m.begin();
+    std::vector<const symbol_t*>  symbols;
+
+    // Visit the symbols in name order to merge them with the database.
+    for ( const auto& s : symbolsToAnalyze.allSymbols() ) {
+      if ( s.second.unifiedCoverageMap != nullptr ) {
+        symbols.push_back( &s );
+      }
+    }
+
+    std::sort(
+      symbols.begin(),
+      symbols.end(),
+      []( const symbol_t* a, const symbol_t* b ) { return a->first < b->first; }
+    );
+
+    for ( const auto sp : symbols ) {
+      const symbol_t&        s = *sp;
+      const CoverageMapBase* map = s.second.unifiedCoverageMap;
+
+      symbolCoverage_t coverage;
+
+      if ( executable == nullptr ) {
+        capture( *map, coverage );
+      } else {
+        const CoverageMapBase* source = executable->getCoverageMap( s.first );
+
+        if ( source == nullptr || !source->wasHit() ) {
+          continue;
+        }
+
+        // Merge the executable's map into an empty map the size of the
+        // unified map as DesiredSymbols::mergeCoverageMap does.
+        uint32_t size = s.second.stats.sizeInBytesWithoutNops;
+
+        if ( size != 0 && size != source->getSize() ) {
+          continue;
+        }
+
+        CoverageMap empty( executable->getFileName(), 0, map->getSize() - 1 );
+
+        empty.merge( *source, source->getFirstLowAddress(), 0, size );
+        capture( empty, coverage );
+      }
+
+      while ( d != symbols_m.end() && d->first < s.first ) {
+        ++d;
+      }
+
+      if ( d != symbols_m.end() && d->first == s.first ) {
+        d->second = std::move( coverage );
+        ++d;
+      } else {
+        symbols_m.insert( d, std::make_pair( s.first, std::move( coverage ) ) );
+      }
+    }
+  }
+
+  void CoverageDatabase::capture(
+    const CoverageMapBase& map,
+    symbolCoverage_t&      coverage
+  )
+  {
+    coverage.size = map.getSize();
+    coverage.startOfInstruction.resize( ( coverage.size + 63 ) / 64 );
+    coverage.executed.resize( coverage.size );
+    coverage.taken.resize( coverage.size );
+    coverage.notTaken.resize( coverage.size );
+
+    for ( uint32_t slot = 0; slot < coverage.size; ++slot ) {
+      if ( map.isStartOfInstruction( slot ) ) {
+        setBit( coverage.startOfInstruction, slot );
+      }
+      coverage.executed[ slot ] = map.getWasExecuted( slot );
+      coverage.taken[ slot ] = map.getWasTaken( slot );
+      coverage.notTaken[ slot ] = map.getWasNotTaken( slot );
+    }
+  }
+
+  uint64_t CoverageDatabase::diff(
+    const CoverageDatabase& after,
+    const std::string&      fileName
+  ) const
+  {
+    static const symbolCoverage_t none = { 0, {}, {}, {}, {} };
+
+    std::ofstream             out;
+    symbols_t::const_iterator b = symbols_m.begin();
+    symbols_t::const_iterator a = after.symbols_m.begin();
+    uint64_t                  covered = 0;
+    uint64_t                  uncovered = 0;
+    size_t                    changed = 0;
+
+    out.open( fileName, std::ios::out | std::ios::trunc );
+    if ( !out.is_open() ) {
+      throw rld::error(
+        "Unable to create " + fileName,
+        "CoverageDatabase::diff"
+      );
+    }
+
+    //
+    // Walk both databases in name order.
+    //
+    while ( b != symbols_m.end() || a != after.symbols_m.end() ) {
+      const std::string*      name;
+      const symbolCoverage_t* before = &none;
+      const symbolCoverage_t* now = &none;
+
+      if (
+        a == after.symbols_m.end() ||
+        ( b != symbols_m.end() && b->first < a->first )
+      ) {
+        name = &b->first;
+        before = &( b++ )->second;
+      } else if (
+        b == symbols_m.end() || a->first < b->first
+      ) {
+        name = &a->first;
+        now = &( a++ )->second;
+      } else {
+        name = &b->first;
+        before = &( b++ )->second;
+        now = &( a++ )->second;
+      }
+
+      if ( before != &none && now != &none && before->size != now->size ) {
+        out << *name << '\n'
+            << "  changed size " << before->size << " to " << now->size
+            << '\n';
+        ++changed;
+        continue;
+      }
+
+      const symbolCoverage_t& sized = before != &none ? *before : *now;
+      size_t                  size = sized.size;
+      size_t                  words = ( size + 63 ) / 64;
+      std::vector<uint64_t>   was = countBits( before->executed, words );
+      std::vector<uint64_t>   is = countBits( now->executed, words );
+      std::vector<uint64_t>   gained( words );
+      std::vector<uint64_t>   lost( words );
+      bool                    differs = false;
+
+      for ( size_t w = 0; w < words; ++w ) {
+        gained[ w ] = is[ w ] & ~was[ w ];
+        lost[ w ] = was[ w ] & ~is[ w ];
+        differs = differs || ( gained[ w ] | lost[ w ] ) != 0;
+      }
+
+      if ( !differs ) {
+        continue;
+      }
+
+      out << *name << '\n';
+      ++changed;
+
+      auto put = [&]( const char* what, size_t low, size_t high ) {
+        out << "  " << what << " 0x" << std::hex << std::setfill( '0' )
+            << std::setw( 8 ) << low << "-0x" << std::setw( 8 ) << high
+            << std::dec << std::setfill( ' ' ) << " ("
+            << high - low + 1 << " bytes, "
+            << countRange( sized.startOfInstruction, low, high )
+            << " instructions)" << '\n';
+      };
+
+      forEachRange( gained, size, [&]( size_t low, size_t high ) {
+        put( "covered  ", low, high );
+        covered += high - low + 1;
+      } );
+
+      forEachRange( lost, size, [&]( size_t low, size_t high ) {
+        put( "uncovered", low, high );
+        uncovered += high - low + 1;
+      } );
+    }
+
+    out << '\n'
+        << "Symbols changed                  : " << changed << '\n'
+        << "Bytes newly covered              : " << covered << '\n'
+        << "Bytes newly uncovered            : " << uncovered << '\n';
+
+    out.close();
+    if ( out.fail() ) {
+      throw rld::error(
+        "Unable to write " + fileName,
+        "CoverageDatabase::diff"
+      );
+    }
+
+    return uncovered;
+  }
+
+  bool CoverageDatabase::getBranchInfoAvailable() const
+  {
+    return branchInfoAvailable_m;
+  }
+
+  void CoverageDatabase::setBranchInfoAvailable( bool available )
+  {
+    branchInfoAvailable_m = available;
+  }
+
+  size_t CoverageDatabase::size() const
+  {
+    return symbols_m.size();
+  }
+
+}
@@ -0,0 +1,209 @@
+/*! @file CoverageDatabase.h
+ *  @brief CoverageDatabase Specification
+ *
+ *  This file contains the specification of the CoverageDatabase class.
+ */
+
+#ifndef __COVERAGE_DATABASE_H__
+#define __COVERAGE_DATABASE_H__
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "DesiredSymbols.h"
+
+namespace Coverage {
+
+  /*! @class CoverageDatabase
+   *
+   *  This class implements a database of the unified coverage of the
+   *  desired symbols. A database holds the coverage of each symbol it
+   *  was made with and the keys of the builds of the executables the
+   *  coverage came from. The databases of separate runs can be merged
+   *  without the traces they were made from.
+   *
+   *  In a file each symbol is stored as packed start of instruction,
+   *  executed, taken and not taken bitmaps followed by the counts of the
+   *  addresses set in the executed, taken and not taken bitmaps. The
+   *  symbols are stored ordered by name so the databases merge in
+   *  linear time. The file is written in little endian byte order.
+   */
+  class CoverageDatabase {
+
+  public:
+
+    /*!
+     *  This method constructs a CoverageDatabase instance.
+     */
+    CoverageDatabase();
+
+    /*!
+     *  This method destructs a CoverageDatabase instance.
+     */
+    ~CoverageDatabase();
+
+    /*!
+     *  This method loads the database in the specified file and merges it
+     *  into this database.
+     *
+     *  @param[in] fileName specifies the database file
+     */
+    void load( const std::string& fileName );
+
+    /*!
+     *  This method loads the databases in the specified files and merges
+     *  them into this database. The files are loaded on @a jobs threads
+     *  and reduced in a tree of pairwise merges, the pairs of each level
+     *  of the tree are merged in parallel. The result is the same as
+     *  loading the files one after the other.
+     *
+     *  @param[in] fileNames specifies the database files
+     *  @param[in] jobs specifies the number of threads to use
+     */
+    void reduce( const std::vector<std::string>& fileNames, int jobs );
+
+    /*!
+     *  This method writes this database to the specified file.
+     *
+     *  @param[in] fileName specifies the database file
+     */
+    void write( const std::string& fileName ) const;
+
+    /*!
+     *  This method merges the specified database into this database. The
+     *  counts of a symbol in both databases are summed if the sizes of the
+     *  symbol are the same.
+     *
+     *  @param[in] other specifies the database to merge
+     */
+    void merge( const CoverageDatabase& other );
+
+    /*!
+     *  This method adds the key of the build of an executable the
+     *  coverage came from.
+     *
+     *  @param[in] buildKey specifies the key of the build
+     */
+    void addBuild( const std::string& buildKey );
+
+    /*!
+     *  This method merges the coverage of this database into the unified
+     *  coverage maps of the desired symbols. A symbol is merged if it has
+     *  the same size in the database and the unified coverage map.
+     *
+     *  @param[in] symbolsToAnalyze specifies the desired symbols
+     */
+    void mergeInto( DesiredSymbols& symbolsToAnalyze ) const;
+
+    /*!
+     *  This method replaces the coverage of each symbol in this database
+     *  with the unified coverage map of the desired symbol. The symbols
+     *  not analyzed are kept. If an executable is given the coverage is
+     *  taken from the executable's coverage maps instead, as it would be
+     *  merged into the unified coverage maps, and the symbols the
+     *  executable does not have or never hit are kept.
+     *
+     *  @param[in] symbolsToAnalyze specifies the desired symbols
+     *  @param[in] executable specifies the executable or NULL
+     */
+    void update(
+      const DesiredSymbols& symbolsToAnalyze,
+      const ExecutableInfo* executable = nullptr
+    );
+
+    /*!
+     *  This method writes the coverage gained and lost from this database
+     *  to the specified database. For each symbol the ranges of the bytes
+     *  executed only in the other database are newly covered and the
+     *  ranges of the bytes executed only in this database are newly
+     *  uncovered. A symbol only in one database is compared with nothing
+     *  executed and a symbol with different sizes is reported as changed.
+     *  The unchanged symbols are skipped with a word wise compare of their
+     *  executed bitmaps.
+     *
+     *  @param[in] after specifies the database to compare with
+     *  @param[in] fileName specifies the file written
+     *
+     *  @return Returns the number of bytes newly uncovered.
+     */
+    uint64_t diff(
+      const CoverageDatabase& after,
+      const std::string&      fileName
+    ) const;
+
+    /*!
+     *  This method returns true if branch information was available for
+     *  the coverage in the database.
+     */
+    bool getBranchInfoAvailable() const;
+
+    /*!
+     *  This method sets if branch information was available for the
+     *  coverage in the database.
+     */
+    void setBranchInfoAvailable( bool available );
+
+    /*!
+     *  This method returns the number of symbols in the database.
+     */
+    size_t size() const;
+
+  private:
+
+    /*!
+     *  This type holds the coverage of a symbol. The start of instruction
+     *  bitmap is packed in words and the counters are indexed by the
+     *  offset of the address in the symbol so a merge is a word wise OR
+     *  and element wise sums.
+     */
+    struct symbolCoverage_t {
+      uint32_t              size;
+      std::vector<uint64_t> startOfInstruction;
+      std::vector<uint32_t> executed;
+      std::vector<uint32_t> taken;
+      std::vector<uint32_t> notTaken;
+    };
+
+    /*!
+     *  This type maps the symbol names to their coverage.
+     */
+    typedef std::map<std::string, symbolCoverage_t> symbols_t;
+
+    /*!
+     *  This method copies the coverage of a map into a symbol's coverage.
+     */
+    static void capture(
+      const CoverageMapBase& map,
+      symbolCoverage_t&      coverage
+    );
+
+    /*!
+     *  This method sums the coverage of the source into the destination.
+     */
+    static void sum(
+      const std::string&      symbolName,
+      symbolCoverage_t&       destination,
+      const symbolCoverage_t& source
+    );
+
+    /*!
+     *  This member variable contains the keys of the builds.
+     */
+    std::set<std::string> builds_m;
+
+    /*!
+     *  This member variable contains the coverage of the symbols.
+     */
+    symbols_t symbols_m;
+
+    /*!
+     *  This member variable is true if branch information was available.
+     */
+    bool branchInfoAvailable_m;
+  };
+
+}
+#endif
@@ -14,7 +14,9 @@
 
 #include "CoverageFactory.h"
 #include "CoverageReaderQEMU.h"
+#include "CoverageReaderQEMUPlugin.h"
 #include "CoverageReaderRTEMS.h"
+#include "CoverageReaderRTEMSStream.h"
 #include "CoverageWriterRTEMS.h"
 #include "CoverageReaderSkyeye.h"
 #include "CoverageWriterSkyeye.h"
@@ -29,10 +31,18 @@ Coverage::CoverageFormats_t Coverage::CoverageFormatToEnum(
     return COVERAGE_FORMAT_QEMU;
   }
 
+  if ( format == "QEMUPlugin" ) {
+    return COVERAGE_FORMAT_QEMU_PLUGIN;
+  }
+
   if ( format == "RTEMS" ) {
     return COVERAGE_FORMAT_RTEMS;
   }
 
+  if ( format == "RTEMSStream" ) {
+    return COVERAGE_FORMAT_RTEMS_STREAM;
+  }
+
   if (format == "Skyeye") {
     return COVERAGE_FORMAT_SKYEYE;
   }
@@ -43,7 +53,8 @@ Coverage::CoverageFormats_t Coverage::CoverageFormatToEnum(
 
   std::ostringstream what;
   what << format << " is an unknown coverage format "
-       << "(supported formats - QEMU, RTEMS, Skyeye and TSIM)";
+       << "(supported formats - QEMU, QEMUPlugin, RTEMS, RTEMSStream, "
+       << "Skyeye and TSIM)";
   throw rld::error( what, "Coverage" );
 }
 
@@ -54,8 +65,12 @@ Coverage::CoverageReaderBase* Coverage::CreateCoverageReader(
   switch ( format ) {
     case COVERAGE_FORMAT_QEMU:
       return new Coverage::CoverageReaderQEMU();
+    case COVERAGE_FORMAT_QEMU_PLUGIN:
+      return new Coverage::CoverageReaderQEMUPlugin();
     case COVERAGE_FORMAT_RTEMS:
       return new Coverage::CoverageReaderRTEMS();
+    case COVERAGE_FORMAT_RTEMS_STREAM:
+      return new Coverage::CoverageReaderRTEMSStream();
     case COVERAGE_FORMAT_SKYEYE:
       return new Coverage::CoverageReaderSkyeye();
     case COVERAGE_FORMAT_TSIM:
@@ -19,7 +19,9 @@ namespace Coverage {
    */
   typedef enum {
     COVERAGE_FORMAT_QEMU,
+    COVERAGE_FORMAT_QEMU_PLUGIN,
     COVERAGE_FORMAT_RTEMS,
+    COVERAGE_FORMAT_RTEMS_STREAM,
     COVERAGE_FORMAT_SKYEYE,
     COVERAGE_FORMAT_TSIM
   } CoverageFormats_t;
@@ -10,10 +10,11 @@
 namespace Coverage {
 
   CoverageMap::CoverageMap(
-    const std::string& exefileName,
-    uint32_t           low,
-    uint32_t           high
-  ) : CoverageMapBase( exefileName, low, high )
+    const std::string&         exefileName,
+    uint32_t                   low,
+    uint32_t                   high,
+    AddressInfos::CounterWidth width
+  ) : CoverageMapBase( exefileName, low, high, width )
   {
   }
 
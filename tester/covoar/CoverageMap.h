@@ -25,11 +25,13 @@ namespace Coverage {
      *
      *  @param[in] low specifies the lowest address of the coverage map.
      *  @param[in] high specifies the highest address of the coverage map.
+     *  @param[in] width specifies the width of the counters.
      */
     CoverageMap(
-      const std::string& exefileName,
-      uint32_t           low,
-      uint32_t           high
+      const std::string&         exefileName,
+      uint32_t                   low,
+      uint32_t                   high,
+      AddressInfos::CounterWidth width = AddressInfos::COUNTERS_32
     );
 
     /* Inherit documentation from base class. */
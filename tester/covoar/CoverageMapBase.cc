@@ -7,7 +7,9 @@
  */
 
 #include <limits.h>
+#include <stdint.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
@@ -18,71 +20,545 @@
 
 namespace Coverage {
 
-  AddressInfo::AddressInfo()
-    : isStartOfInstruction( false ),
-      wasExecuted( false ),
-      isBranch( false ),
-      isNop( false ),
-      wasTaken( false ),
-      wasNotTaken( false )
+  /*
+   * Count the bits set in a word.
+   */
+  static inline size_t popcount( uint64_t word )
   {
+#if defined(__GNUC__)
+    return __builtin_popcountll( word );
+#else
+    size_t count = 0;
+    while ( word ) {
+      word &= word - 1;
+      ++count;
+    }
+    return count;
+#endif
   }
 
-  AddressRange::AddressRange()
-    : lowAddress( 0 ),
-      highAddress( 0 )
+  /*
+   * Return the index of the lowest bit set in a word that is not zero.
+   */
+  static inline size_t ctz( uint64_t word )
   {
+#if defined(__GNUC__)
+    return __builtin_ctzll( word );
+#else
+    size_t index = 0;
+    while ( ( word & 1 ) == 0 ) {
+      word >>= 1;
+      ++index;
+    }
+    return index;
+#endif
   }
 
-  AddressRange::AddressRange(
-    const std::string& name,
-    uint32_t           lowAddress,
-    uint32_t           highAddress)
-    : fileName( name ),
-      lowAddress( lowAddress ),
-      highAddress( highAddress )
+  AddressInfos::AddressInfos( CounterWidth width )
+    : width_m( width ),
+      size_m( 0 )
   {
-    info.resize( size() );
   }
 
-  size_t AddressRange::size() const
+  AddressInfos::CounterWidth AddressInfos::getCounterWidth() const
   {
-    return highAddress - lowAddress + 1;
+    return width_m;
   }
 
-  bool AddressRange::inside( uint32_t address ) const
+  void AddressInfos::resize( size_t size )
   {
-    return address >= lowAddress && address <= highAddress;
+    size_t words = ( size + 63 ) / 64;
+
+    size_m = size;
+    startOfInstruction.resize( words );
+    branch.resize( words );
+    nop.resize( words );
+    executed.resize( words );
+
+    // Only the counters of the width are used.
+    for ( int c = 0; c < COUNTER_COUNT; ++c ) {
+      switch ( width_m ) {
+        case COUNTERS_NONE:
+          countBits[ c ].resize( words );
+          break;
+        case COUNTERS_8:
+          counts8[ c ].resize( size );
+          break;
+        case COUNTERS_32:
+          counts32[ c ].resize( size );
+          break;
+      }
+    }
+  }
+
+  size_t AddressInfos::size() const
+  {
+    return size_m;
+  }
+
+  bool AddressInfos::test( const Bits& bits, size_t slot )
+  {
+    return ( bits.get( slot / 64 ) & ( 1ULL << ( slot % 64 ) ) ) != 0;
+  }
+
+  void AddressInfos::set( Bits& bits, size_t slot )
+  {
+    bits.at( slot / 64 ) |= 1ULL << ( slot % 64 );
   }
 
-  AddressInfo& AddressRange::get( uint32_t address )
+  uint32_t AddressInfos::get( Counter counter, size_t slot ) const
   {
-    if ( !inside( address ) ) {
-      throw rld::error( "address outside range", "AddressRange::get" );
+    switch ( width_m ) {
+      case COUNTERS_NONE:
+        return test( countBits[ counter ], slot ) ? 1 : 0;
+      case COUNTERS_8:
+        return counts8[ counter ].get( slot );
+      case COUNTERS_32:
+      default:
+        return counts32[ counter ].get( slot );
     }
+  }
 
-    size_t slot = address - lowAddress;
+  void AddressInfos::add( Counter counter, size_t slot, uint32_t addition )
+  {
+    if ( addition == 0 ) {
+      return;
+    }
 
-    if ( slot >= info.size () ) {
-      throw rld::error( "address slot not found", "AddressRange::get" );
+    switch ( width_m ) {
+      case COUNTERS_NONE:
+        set( countBits[ counter ], slot );
+        break;
+      case COUNTERS_8: {
+        uint8_t& count = counts8[ counter ].at( slot );
+        count = addition > uint32_t( UINT8_MAX - count ) ?
+          UINT8_MAX : count + addition;
+        break;
+      }
+      case COUNTERS_32:
+      default: {
+        uint32_t& count = counts32[ counter ].at( slot );
+        count = addition > UINT32_MAX - count ? UINT32_MAX : count + addition;
+        break;
+      }
+    }
+  }
+
+  bool AddressInfos::isStartOfInstruction( size_t slot ) const
+  {
+    return test( startOfInstruction, slot );
+  }
+
+  void AddressInfos::setIsStartOfInstruction( size_t slot )
+  {
+    set( startOfInstruction, slot );
+  }
+
+  bool AddressInfos::isBranch( size_t slot ) const
+  {
+    return test( branch, slot );
+  }
+
+  void AddressInfos::setIsBranch( size_t slot )
+  {
+    set( branch, slot );
+  }
+
+  bool AddressInfos::isNop( size_t slot ) const
+  {
+    return test( nop, slot );
+  }
+
+  void AddressInfos::setIsNop( size_t slot )
+  {
+    set( nop, slot );
+  }
+
+  uint32_t AddressInfos::getWasExecuted( size_t slot ) const
+  {
+    // Without counters the executed flag is the count.
+    if ( width_m == COUNTERS_NONE ) {
+      return test( executed, slot ) ? 1 : 0;
+    }
+
+    return get( EXECUTED_COUNT, slot );
+  }
+
+  void AddressInfos::addWasExecuted( size_t slot, uint32_t addition )
+  {
+    if ( addition == 0 ) {
+      return;
+    }
+
+    if ( width_m != COUNTERS_NONE ) {
+      add( EXECUTED_COUNT, slot, addition );
+    }
+    set( executed, slot );
+  }
+
+  void AddressInfos::addWasExecuted(
+    size_t   slot,
+    size_t   count,
+    uint32_t addition
+  )
+  {
+    if ( addition == 0 || slot >= size_m ) {
+      return;
+    }
+
+    count = std::min( count, size_m - slot );
+
+    switch ( width_m ) {
+      case COUNTERS_NONE:
+        break;
+      case COUNTERS_8:
+        sum( counts8[ EXECUTED_COUNT ], slot, count, addition );
+        break;
+      case COUNTERS_32:
+        sum( counts32[ EXECUTED_COUNT ], slot, count, addition );
+        break;
+    }
+
+    set( executed, slot, count );
+  }
+
+  uint32_t AddressInfos::getWasTaken( size_t slot ) const
+  {
+    return get( TAKEN_COUNT, slot );
+  }
+
+  void AddressInfos::addWasTaken( size_t slot, uint32_t addition )
+  {
+    add( TAKEN_COUNT, slot, addition );
+  }
+
+  uint32_t AddressInfos::getWasNotTaken( size_t slot ) const
+  {
+    return get( NOT_TAKEN_COUNT, slot );
+  }
+
+  void AddressInfos::addWasNotTaken( size_t slot, uint32_t addition )
+  {
+    add( NOT_TAKEN_COUNT, slot, addition );
+  }
+
+  const AddressInfos::Bits& AddressInfos::bits( Flag flag ) const
+  {
+    switch ( flag ) {
+      case START_OF_INSTRUCTION:
+        return startOfInstruction;
+      case BRANCH:
+        return branch;
+      case NOP:
+        return nop;
+      case EXECUTED:
+      default:
+        return executed;
+    }
+  }
+
+  size_t AddressInfos::find(
+    Flag   flag,
+    size_t slot,
+    size_t end,
+    bool   value
+  ) const
+  {
+    const Bits& b = bits( flag );
+
+    if ( end > size_m ) {
+      end = size_m;
+    }
+
+    while ( slot < end ) {
+      // A page that is not allocated has no flags set.
+      if ( value && !b.lookup( slot / 64 ) ) {
+        slot = ( slot / ( Bits::pageSize * 64 ) + 1 ) * Bits::pageSize * 64;
+        continue;
+      }
+
+      size_t   bit = slot % 64;
+      uint64_t word = b.get( slot / 64 );
+
+      if ( !value ) {
+        word = ~word;
+      }
+
+      word >>= bit;
+
+      if ( word != 0 ) {
+        size_t found = slot + ctz( word );
+        return found < end ? found : end;
+      }
+
+      slot += 64 - bit;
+    }
+
+    return end;
+  }
+
+  size_t AddressInfos::count( Flag flag, size_t slot, size_t end ) const
+  {
+    const Bits& b = bits( flag );
+    size_t      total = 0;
+
+    if ( end > size_m ) {
+      end = size_m;
+    }
+
+    while ( slot < end ) {
+      // A page that is not allocated has no flags set.
+      if ( !b.lookup( slot / 64 ) ) {
+        slot = ( slot / ( Bits::pageSize * 64 ) + 1 ) * Bits::pageSize * 64;
+        continue;
+      }
+
+      size_t   bit = slot % 64;
+      size_t   n = std::min( static_cast<size_t>( 64 ) - bit, end - slot );
+      uint64_t word = b.get( slot / 64 ) >> bit;
+
+      if ( n < 64 ) {
+        word &= ( 1ULL << n ) - 1;
+      }
+
+      total += popcount( word );
+      slot += n;
+    }
+
+    return total;
+  }
+
+  uint64_t AddressInfos::extract( const Bits& bits, size_t slot, size_t count )
+  {
+    size_t   word = slot / 64;
+    size_t   bit = slot % 64;
+    uint64_t value = bits.get( word ) >> bit;
+
+    if ( bit != 0 && bit + count > 64 ) {
+      value |= bits.get( word + 1 ) << ( 64 - bit );
+    }
+
+    if ( count < 64 ) {
+      value &= ( 1ULL << count ) - 1;
+    }
+
+    return value;
+  }
+
+  void AddressInfos::set( Bits& bits, size_t slot, size_t count )
+  {
+    while ( count > 0 ) {
+      size_t   bit = slot % 64;
+      size_t   n = std::min( static_cast<size_t>( 64 ) - bit, count );
+      uint64_t mask = n < 64 ? ( ( 1ULL << n ) - 1 ) << bit : ~0ULL;
+
+      bits.at( slot / 64 ) |= mask;
+      slot += n;
+      count -= n;
+    }
+  }
+
+  template <typename T>
+  void AddressInfos::sum(
+    PagedArray<T, 4096>& counters,
+    size_t               slot,
+    size_t               count,
+    uint32_t             addition
+  )
+  {
+    typedef PagedArray<T, 4096> Counters;
+
+    const T limit = static_cast<T>( ~T( 0 ) );
+    const T value = addition > limit ? limit : static_cast<T>( addition );
+
+    while ( count > 0 ) {
+      size_t n = std::min(
+        count, Counters::pageSize - ( slot % Counters::pageSize )
+      );
+
+      // Keep the loop simple so that it is vectorized. The sum saturates
+      // at the largest count.
+      T* to = counters.allocate( slot );
+
+      for ( size_t i = 0; i < n; ++i ) {
+        T s = to[ i ] + value;
+        to[ i ] = s < to[ i ] ? limit : s;
+      }
+
+      slot += n;
+      count -= n;
+    }
+  }
+
+  void AddressInfos::merge(
+    Bits&       bits,
+    size_t      slot,
+    const Bits& source,
+    size_t      sourceSlot,
+    size_t      count
+  )
+  {
+    while ( count > 0 ) {
+      size_t   bit = slot % 64;
+      size_t   n = std::min( static_cast<size_t>( 64 ) - bit, count );
+      uint64_t value = extract( source, sourceSlot, n );
+
+      if ( value != 0 ) {
+        bits.at( slot / 64 ) |= value << bit;
+      }
+      slot += n;
+      sourceSlot += n;
+      count -= n;
     }
+  }
 
-    return info[slot];
+  template <typename T>
+  void AddressInfos::merge(
+    PagedArray<T, 4096>&       counters,
+    size_t                     slot,
+    const PagedArray<T, 4096>& source,
+    size_t                     sourceSlot,
+    size_t                     count
+  )
+  {
+    typedef PagedArray<T, 4096> Counters;
+
+    while ( count > 0 ) {
+      size_t n = std::min(
+        count,
+        std::min(
+          Counters::pageSize - ( slot % Counters::pageSize ),
+          Counters::pageSize - ( sourceSlot % Counters::pageSize )
+        )
+      );
+
+      const T* from = source.lookup( sourceSlot );
+
+      if ( from ) {
+        // Keep the loop simple so that it is vectorized. The sum saturates
+        // at the largest count.
+        T* to = counters.allocate( slot );
+
+        for ( size_t i = 0; i < n; ++i ) {
+          T sum = to[ i ] + from[ i ];
+          to[ i ] = sum < to[ i ] ? static_cast<T>( ~T( 0 ) ) : sum;
+        }
+      }
+
+      slot += n;
+      sourceSlot += n;
+      count -= n;
+    }
   }
 
-  const AddressInfo& AddressRange::get( uint32_t address ) const
+  void AddressInfos::merge(
+    const AddressInfos& source,
+    size_t              sourceSlot,
+    size_t              slot,
+    size_t              count
+  )
   {
-    if ( !inside( address ) ) {
-      throw rld::error( "address outside range", "AddressRange::get" );
+    if ( sourceSlot >= source.size_m || slot >= size_m ) {
+      return;
     }
 
-    size_t slot = address - lowAddress;
+    count = std::min( count, source.size_m - sourceSlot );
+    count = std::min( count, size_m - slot );
+
+    merge( startOfInstruction, slot, source.startOfInstruction, sourceSlot, count );
+    merge( executed, slot, source.executed, sourceSlot, count );
+
+    // The information of a run has one width, a source of another width
+    // is added a slot at a time.
+    if ( source.width_m != width_m ) {
+      for ( size_t i = 0; i < count; ++i ) {
+        for ( int c = 0; c < COUNTER_COUNT; ++c ) {
+          Counter counter = static_cast<Counter>( c );
+          uint32_t value = counter == EXECUTED_COUNT ?
+            source.getWasExecuted( sourceSlot + i ) :
+            source.get( counter, sourceSlot + i );
+
+          if ( counter != EXECUTED_COUNT || width_m != COUNTERS_NONE ) {
+            add( counter, slot + i, value );
+          }
+        }
+      }
+      return;
+    }
 
-    if ( slot >= info.size() ) {
-      throw rld::error( "address slot not found", "AddressRange::get" );
+    for ( int c = 0; c < COUNTER_COUNT; ++c ) {
+      switch ( width_m ) {
+        case COUNTERS_NONE:
+          merge( countBits[ c ], slot, source.countBits[ c ], sourceSlot, count );
+          break;
+        case COUNTERS_8:
+          merge( counts8[ c ], slot, source.counts8[ c ], sourceSlot, count );
+          break;
+        case COUNTERS_32:
+          merge( counts32[ c ], slot, source.counts32[ c ], sourceSlot, count );
+          break;
+      }
     }
+  }
+
+  void AddressInfos::clearCoverage()
+  {
+    size_t words = ( size_m + 63 ) / 64;
+
+    // Release the pages and size the arrays again.
+    executed.resize( 0 );
+    executed.resize( words );
+
+    for ( int c = 0; c < COUNTER_COUNT; ++c ) {
+      countBits[ c ].resize( 0 );
+      counts8[ c ].resize( 0 );
+      counts32[ c ].resize( 0 );
+    }
+
+    resize( size_m );
+  }
+
+  void AddressInfos::dump( std::ostream& out, size_t slot ) const
+  {
+    out << "- isStartOfInstruction:"
+        << (char*) ( isStartOfInstruction( slot ) ? "yes" : "no" )
+        << " wasExecuted:"
+        << (char*) ( getWasExecuted( slot ) ? "yes" : "no" )
+        << "\n           isBranch:"
+        << (char*) ( isBranch( slot ) ? "yes" : "no" )
+        << " wasTaken:"
+        << (char*) ( getWasTaken( slot ) ? "yes" : "no" )
+        << " wasNotTaken:"
+        << (char*) ( getWasNotTaken( slot ) ? "yes" : "no" );
+  }
 
-    return info[slot];
+  AddressRange::AddressRange()
+    : lowAddress( 0 ),
+      highAddress( 0 )
+  {
+  }
+
+  AddressRange::AddressRange(
+    const std::string&         name,
+    uint32_t                   lowAddress,
+    uint32_t                   highAddress,
+    AddressInfos::CounterWidth width)
+    : fileName( name ),
+      lowAddress( lowAddress ),
+      highAddress( highAddress ),
+      info( width )
+  {
+    info.resize( size() );
+  }
+
+  size_t AddressRange::size() const
+  {
+    return highAddress - lowAddress + 1;
+  }
+
+  bool AddressRange::inside( uint32_t address ) const
+  {
+    return address >= lowAddress && address <= highAddress;
   }
 
   void AddressRange::dump( std::ostream& out, bool show_slots ) const
@@ -95,34 +571,26 @@ namespace Coverage {
         << std::endl;
 
     if (show_slots) {
-      size_t slot = 0;
-
-      for ( auto& i : info ) {
+      for ( size_t slot = 0; slot < info.size(); ++slot ) {
         out << std::hex << std::setfill( '0' )
-            << "0x" << std::setw( 8 ) << slot++ + lowAddress
-            << "- isStartOfInstruction:"
-            << (char*) ( i.isStartOfInstruction ? "yes" : "no" )
-            << " wasExecuted:"
-            << (char*) ( i.wasExecuted ? "yes" : "no" )
-            << "\n           isBranch:"
-            << (char*) ( i.isBranch ? "yes" : "no" )
-            << " wasTaken:"
-            << (char*) ( i.wasTaken ? "yes" : "no" )
-            << " wasNotTaken:"
-            << (char*) ( i.wasNotTaken ? "yes" : "no" )
-            << std::dec << std::setfill( ' ' )
+            << "0x" << std::setw( 8 ) << slot + lowAddress;
+        info.dump( out, slot );
+        out << std::dec << std::setfill( ' ' )
             << std::endl;
       }
     }
   }
 
   CoverageMapBase::CoverageMapBase(
-    const std::string& exefileName,
-    uint32_t           low,
-    uint32_t           high
-  ) : exefileName( exefileName )
+    const std::string&         exefileName,
+    uint32_t                   low,
+    uint32_t                   high,
+    AddressInfos::CounterWidth width
+  ) : exefileName( exefileName ),
+      hit( false ),
+      width_m( width )
   {
-    Ranges.push_back( AddressRange( exefileName, low, high ) );
+    Ranges.push_back( AddressRange( exefileName, low, high, width_m ) );
   }
 
   CoverageMapBase::~CoverageMapBase()
@@ -131,7 +599,63 @@ namespace Coverage {
 
   void CoverageMapBase::Add( uint32_t low, uint32_t high )
   {
-    Ranges.push_back( AddressRange( exefileName, low, high ) );
+    Ranges.push_back( AddressRange( exefileName, low, high, width_m ) );
+  }
+
+  uint64_t CoverageMapBase::segment( uint64_t address ) const
+  {
+    uint64_t n = UINT64_MAX;
+
+    for ( auto& r : Ranges ) {
+      if ( address < r.lowAddress ) {
+        n = std::min( n, r.lowAddress - address );
+      } else if ( address <= r.highAddress ) {
+        n = std::min( n, r.highAddress - address + 1 );
+      }
+    }
+
+    return n;
+  }
+
+  void CoverageMapBase::merge(
+    const CoverageMapBase& source,
+    uint32_t               sourceAddress,
+    uint32_t               address,
+    uint32_t               size
+  )
+  {
+    uint64_t offset = 0;
+
+    // Merge the segments of addresses held by the same source and
+    // destination ranges.
+    while ( offset < size ) {
+      uint64_t sAddress = sourceAddress + offset;
+      uint64_t dAddress = address + offset;
+
+      if ( sAddress > UINT32_MAX || dAddress > UINT32_MAX ) {
+        break;
+      }
+
+      uint64_t n = size - offset;
+
+      n = std::min( n, source.segment( sAddress ) );
+      n = std::min( n, segment( dAddress ) );
+
+      const AddressRange* s = source.findRange( sAddress );
+      AddressRange*       d = findRange( dAddress );
+
+      if ( s && d ) {
+        d->info.merge(
+          s->info,
+          sAddress - s->lowAddress,
+          dAddress - d->lowAddress,
+          n
+        );
+        hit = hit || source.hit;
+      }
+
+      offset += n;
+    }
   }
 
   bool CoverageMapBase::validAddress( const uint32_t address ) const
@@ -145,6 +669,15 @@ namespace Coverage {
     return false;
   }
 
+  void CoverageMapBase::clearCoverage()
+  {
+    for ( auto& r : Ranges ) {
+      r.info.clearCoverage();
+    }
+
+    hit = false;
+  }
+
   void CoverageMapBase::dump() const
   {
     std::cerr << "Coverage Map Contents\n";
@@ -212,9 +745,14 @@ namespace Coverage {
     return Ranges.at( index ).lowAddress;
   }
 
+  size_t CoverageMapBase::getNumberOfRanges() const
+  {
+    return Ranges.size();
+  }
+
   bool CoverageMapBase::getRange( uint32_t address, AddressRange& range ) const
   {
-    for ( auto r : Ranges ) {
+    for ( const auto& r : Ranges ) {
       if ( r.inside( address ) ) {
         range.lowAddress  = r.lowAddress;
         range.highAddress = r.highAddress;
@@ -226,209 +764,325 @@ namespace Coverage {
     return false;
   }
 
-  AddressInfo& CoverageMapBase::getInfo( uint32_t address )
+  AddressRange* CoverageMapBase::findRange( uint32_t address )
   {
     for ( auto& r : Ranges ) {
       if ( r.inside( address ) ) {
-        return r.get( address );
+        return &r;
       }
     }
 
-    throw rld::error( "address out of bounds", "CoverageMapBase::getInfo" );
+    return NULL;
   }
 
-  const AddressInfo& CoverageMapBase::getInfo( uint32_t address ) const
+  const AddressRange* CoverageMapBase::findRange( uint32_t address ) const
   {
     for ( auto& r : Ranges ) {
       if ( r.inside( address ) ) {
-        return r.get( address );
+        return &r;
       }
     }
 
-    throw rld::error( "address out of bounds", "CoverageMapBase::getInfo" );
+    return NULL;
   }
 
   void CoverageMapBase::setIsStartOfInstruction( uint32_t  address )
   {
-    if ( validAddress( address ) ) {
-      getInfo( address ).isStartOfInstruction = true;
+    AddressRange* r = findRange( address );
+    if ( r ) {
+      r->info.setIsStartOfInstruction( address - r->lowAddress );
     }
   }
 
   bool CoverageMapBase::isStartOfInstruction( uint32_t address ) const
   {
-    if ( !validAddress( address ) ) {
+    const AddressRange* r = findRange( address );
+    if ( !r ) {
       return false;
     }
 
-    return getInfo( address ).isStartOfInstruction;
+    return r->info.isStartOfInstruction( address - r->lowAddress );
   }
 
   void CoverageMapBase::setWasExecuted( uint32_t address )
   {
-    if ( validAddress( address ) ) {
-      getInfo( address ).wasExecuted += 1;
-    }
+    sumWasExecuted( address, 1 );
   }
 
   void CoverageMapBase::sumWasExecuted( uint32_t address, uint32_t addition )
   {
-    if ( validAddress( address ) ) {
-      getInfo( address ).wasExecuted += addition;
+    AddressRange* r = findRange( address );
+    if ( r ) {
+      r->info.addWasExecuted( address - r->lowAddress, addition );
+      hit = hit || addition != 0;
     }
   }
 
-  bool CoverageMapBase::wasExecuted( uint32_t address ) const
+  void CoverageMapBase::sumWasExecuted(
+    uint32_t address,
+    uint32_t size,
+    uint32_t addition
+  )
   {
-    bool result = false;
+    uint64_t a = address;
+    uint64_t end = a + size;
+
+    while ( a < end ) {
+      AddressRange* r = findRange( a );
+
+      if ( !r ) {
+        ++a;
+        continue;
+      }
+
+      uint64_t last =
+        std::min( end, static_cast<uint64_t>( r->highAddress ) + 1 );
 
-    if ( validAddress( address ) && ( getInfo( address ).wasExecuted > 0 ) ) {
-      result = true;
+      r->info.addWasExecuted( a - r->lowAddress, last - a, addition );
+      hit = hit || addition != 0;
+      a = last;
     }
+  }
 
-    return result;
+  bool CoverageMapBase::wasExecuted( uint32_t address ) const
+  {
+    return getWasExecuted( address ) > 0;
   }
 
   uint32_t CoverageMapBase::getWasExecuted( uint32_t address ) const
   {
-    if ( !validAddress( address ) ) {
+    const AddressRange* r = findRange( address );
+    if ( !r ) {
       return 0;
     }
 
-    return getInfo( address ).wasExecuted;
+    return r->info.getWasExecuted( address - r->lowAddress );
   }
 
-  void CoverageMapBase::setIsBranch( uint32_t address )
+  uint32_t CoverageMapBase::find(
+    AddressInfos::Flag flag,
+    uint32_t           address,
+    uint32_t           highAddress,
+    bool               value
+  ) const
   {
-    if ( validAddress( address ) ) {
-      getInfo( address ).isBranch = true;
+    uint64_t a = address;
+    uint64_t high = highAddress;
+
+    while ( a <= high ) {
+      const AddressRange* r = findRange( a );
+
+      if ( !r ) {
+        // No flags are set outside the ranges.
+        if ( !value ) {
+          return a;
+        }
+
+        // Move to the next range after the address.
+        uint64_t next = high + 1;
+        for ( const auto& range : Ranges ) {
+          if ( range.lowAddress > a && range.lowAddress < next ) {
+            next = range.lowAddress;
+          }
+        }
+
+        a = next;
+        continue;
+      }
+
+      uint64_t end = std::min( high, static_cast<uint64_t>( r->highAddress ) );
+      size_t   slot = a - r->lowAddress;
+      size_t   last = end - r->lowAddress + 1;
+      size_t   found = r->info.find( flag, slot, last, value );
+
+      if ( found < last ) {
+        return r->lowAddress + found;
+      }
+
+      a = end + 1;
     }
+
+    return highAddress + 1;
   }
 
-  bool CoverageMapBase::isNop( uint32_t address ) const
+  uint32_t CoverageMapBase::count(
+    AddressInfos::Flag flag,
+    uint32_t           address,
+    uint32_t           highAddress
+  ) const
   {
-    if ( !validAddress( address ) ) {
-      return false;
+    uint64_t low = address;
+    uint64_t high = static_cast<uint64_t>( highAddress ) + 1;
+    uint32_t total = 0;
+
+    for ( const auto& r : Ranges ) {
+      uint64_t rlow = std::max( low, static_cast<uint64_t>( r.lowAddress ) );
+      uint64_t rhigh =
+        std::min( high, static_cast<uint64_t>( r.highAddress ) + 1 );
+
+      if ( rlow < rhigh ) {
+        total += r.info.count(
+          flag,
+          rlow - r.lowAddress,
+          rhigh - r.lowAddress
+        );
+      }
     }
 
-    return getInfo( address ).isNop;
+    return total;
   }
 
-  void CoverageMapBase::setIsNop( uint32_t address )
+  uint32_t CoverageMapBase::getNotExecuted(
+    uint32_t address,
+    uint32_t size
+  ) const
   {
-    if ( !validAddress( address ) ) {
-      return;
+    if ( size == 0 ) {
+      return 0;
     }
 
-    getInfo( address ).isNop = true;
+    return size - count( AddressInfos::EXECUTED, address, address + size - 1 );
   }
 
-  bool CoverageMapBase::isBranch( uint32_t address ) const
+  uint32_t CoverageMapBase::findExecuted(
+    uint32_t address,
+    uint32_t highAddress,
+    bool     executed
+  ) const
   {
-    if ( !validAddress( address ) ) {
-      return false;
-    }
+    return find( AddressInfos::EXECUTED, address, highAddress, executed );
+  }
 
-    return getInfo( address ).isBranch;
+  uint32_t CoverageMapBase::findStartOfInstruction(
+    uint32_t address,
+    uint32_t highAddress
+  ) const
+  {
+    return find( AddressInfos::START_OF_INSTRUCTION, address, highAddress, true );
   }
 
-  void CoverageMapBase::setWasTaken( uint32_t address )
+  uint32_t CoverageMapBase::findBranch(
+    uint32_t address,
+    uint32_t highAddress
+  ) const
   {
-    if ( !validAddress( address ) ) {
-      return;
-    }
+    return find( AddressInfos::BRANCH, address, highAddress, true );
+  }
 
-    getInfo( address ).wasTaken += 1;
+  uint32_t CoverageMapBase::getNumberOfInstructions(
+    uint32_t address,
+    uint32_t highAddress
+  ) const
+  {
+    return count( AddressInfos::START_OF_INSTRUCTION, address, highAddress );
   }
 
-  void CoverageMapBase::setWasNotTaken( uint32_t address )
+  void CoverageMapBase::setIsBranch( uint32_t address )
   {
-    if ( !validAddress( address ) ) {
-      return;
+    AddressRange* r = findRange( address );
+    if ( r ) {
+      r->info.setIsBranch( address - r->lowAddress );
     }
-
-    getInfo( address ).wasNotTaken += 1;
   }
 
-  bool CoverageMapBase::wasAlwaysTaken( uint32_t address ) const
+  bool CoverageMapBase::isNop( uint32_t address ) const
   {
-    if ( !validAddress( address ) ) {
+    const AddressRange* r = findRange( address );
+    if ( !r ) {
       return false;
     }
 
-    const AddressInfo& info = getInfo( address );
+    return r->info.isNop( address - r->lowAddress );
+  }
 
-    return info.wasTaken && !info.wasNotTaken;
+  void CoverageMapBase::setIsNop( uint32_t address )
+  {
+    AddressRange* r = findRange( address );
+    if ( r ) {
+      r->info.setIsNop( address - r->lowAddress );
+    }
   }
 
-  bool CoverageMapBase::wasNeverTaken( uint32_t address ) const
+  bool CoverageMapBase::isBranch( uint32_t address ) const
   {
-    if ( !validAddress( address ) ) {
+    const AddressRange* r = findRange( address );
+    if ( !r ) {
       return false;
     }
 
-    const AddressInfo& info = getInfo( address );
+    return r->info.isBranch( address - r->lowAddress );
+  }
 
-    return !info.wasTaken && info.wasNotTaken;
+  void CoverageMapBase::setWasTaken( uint32_t address )
+  {
+    sumWasTaken( address, 1 );
   }
 
-  bool CoverageMapBase::wasNotTaken( uint32_t address ) const
+  void CoverageMapBase::setWasNotTaken( uint32_t address )
   {
-    bool result = true;
+    sumWasNotTaken( address, 1 );
+  }
 
-    if ( !validAddress( address ) ) {
-      result = false;
-    } else if ( getInfo( address ).wasNotTaken <= 0 ) {
-      result = false;
-    }
+  bool CoverageMapBase::wasAlwaysTaken( uint32_t address ) const
+  {
+    return getWasTaken( address ) && !getWasNotTaken( address );
+  }
 
-    return result;
+  bool CoverageMapBase::wasNeverTaken( uint32_t address ) const
+  {
+    return !getWasTaken( address ) && getWasNotTaken( address );
+  }
+
+  bool CoverageMapBase::wasNotTaken( uint32_t address ) const
+  {
+    return getWasNotTaken( address ) > 0;
   }
 
   void CoverageMapBase::sumWasNotTaken( uint32_t address, uint32_t addition )
   {
-    if ( validAddress( address ) ) {
-      getInfo( address ).wasNotTaken += addition;
+    AddressRange* r = findRange( address );
+    if ( r ) {
+      r->info.addWasNotTaken( address - r->lowAddress, addition );
+      hit = hit || addition != 0;
     }
   }
 
   uint32_t CoverageMapBase::getWasNotTaken( uint32_t address ) const
   {
-    if ( !validAddress( address ) ) {
+    const AddressRange* r = findRange( address );
+    if ( !r ) {
       return 0;
     }
 
-    return getInfo( address ).wasNotTaken;
+    return r->info.getWasNotTaken( address - r->lowAddress );
   }
 
   bool CoverageMapBase::wasTaken( uint32_t address ) const
   {
-    bool result = true;
-
-    if ( !validAddress( address ) ) {
-      result = false;
-    } else if ( getInfo( address ).wasTaken <= 0 ) {
-      result = false;
-    }
-
-    return result;
+    return getWasTaken( address ) > 0;
   }
 
   void CoverageMapBase::sumWasTaken( uint32_t address, uint32_t addition )
   {
-    if ( !validAddress( address ) ) {
-      return;
+    AddressRange* r = findRange( address );
+    if ( r ) {
+      r->info.addWasTaken( address - r->lowAddress, addition );
+      hit = hit || addition != 0;
     }
-
-    getInfo( address ).wasTaken += addition;
   }
 
   uint32_t CoverageMapBase::getWasTaken( uint32_t address ) const
   {
-    if ( !validAddress( address ) ) {
+    const AddressRange* r = findRange( address );
+    if ( !r ) {
       return 0;
     }
 
-    return getInfo( address ).wasTaken;
+    return r->info.getWasTaken( address - r->lowAddress );
+  }
+
+  bool CoverageMapBase::wasHit() const
+  {
+    return hit;
   }
 }
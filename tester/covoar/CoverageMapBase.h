@@ -8,6 +8,9 @@
 #define __COVERAGE_MAP_BASE_H__
 
 #include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <list>
@@ -15,49 +18,313 @@
 namespace Coverage {
 
   /*!
-   *  This structure defines the information that is gathered and
-   *  tracked per address.
+   *  This class is an array whose elements are stored in pages of
+   *  PageSize elements. A page is only allocated when an element in it
+   *  is written and the elements of a page that is not allocated are
+   *  zero so a large array with few elements written is small.
    */
-  struct AddressInfo {
+  template <typename T, size_t PageSize>
+  class PagedArray {
 
-    AddressInfo ();
+  public:
+
+    static const size_t pageSize = PageSize;
+
+    PagedArray()
+      : size_m( 0 )
+    {
+    }
+
+    PagedArray( const PagedArray& other )
+      : size_m( 0 )
+    {
+      *this = other;
+    }
+
+    PagedArray& operator=( const PagedArray& other )
+    {
+      if ( this != &other ) {
+        pages_m.clear();
+        pages_m.resize( other.pages_m.size() );
+        size_m = other.size_m;
+        for ( size_t p = 0; p < pages_m.size(); ++p ) {
+          if ( other.pages_m[ p ] ) {
+            pages_m[ p ].reset( new T[ PageSize ] );
+            ::memcpy(
+              pages_m[ p ].get(), other.pages_m[ p ].get(), PageSize * sizeof( T )
+            );
+          }
+        }
+      }
+      return *this;
+    }
 
     /*!
-     *  This member indicates that the address is the start of
-     *  an instruction.
+     *  This method sets the number of elements. Pages past the end are
+     *  released.
      */
-    bool isStartOfInstruction;
+    void resize( size_t size )
+    {
+      pages_m.resize( ( size + PageSize - 1 ) / PageSize );
+      size_m = size;
+    }
 
     /*!
-     *  This member indicates how many times the address was executed.
+     *  This method returns the number of elements.
      */
-    uint32_t wasExecuted;
+    size_t size() const
+    {
+      return size_m;
+    }
 
     /*!
-     *  This member indicates that the address is a branch instruction.
+     *  This method returns the element at the index.
      */
-    bool isBranch;
+    T get( size_t index ) const
+    {
+      const T* page = pages_m[ index / PageSize ].get();
+      return page ? page[ index % PageSize ] : 0;
+    }
 
     /*!
-     *  This member indicates that the address is a NOP instruction.
+     *  This method returns the element at the index for writing. Its
+     *  page is allocated if it is not.
      */
-    bool isNop;
+    T& at( size_t index )
+    {
+      return *allocate( index );
+    }
 
     /*!
-     *  When isBranch is TRUE, this member indicates that the branch
-     *  instruction at the address was taken.
+     *  This method returns a pointer to the element at the index or NULL
+     *  if the page of the element is not allocated. The pointer is valid
+     *  to the end of the page.
      */
-    uint32_t wasTaken;
+    const T* lookup( size_t index ) const
+    {
+      const T* page = pages_m[ index / PageSize ].get();
+      return page ? page + ( index % PageSize ) : NULL;
+    }
 
     /*!
-     *  When isBranch is TRUE, this member indicates that the branch
-     *  instruction at the address was NOT taken.
+     *  This method returns a pointer to the element at the index and
+     *  allocates its page if it is not. The pointer is valid to the end
+     *  of the page.
      */
-    uint32_t wasNotTaken;
+    T* allocate( size_t index )
+    {
+      Page& page = pages_m[ index / PageSize ];
+      if ( !page ) {
+        page.reset( new T[ PageSize ]() );
+      }
+      return page.get() + ( index % PageSize );
+    }
 
+  private:
+
+    typedef std::unique_ptr<T[]> Page;
+
+    std::vector<Page> pages_m;
+    size_t            size_m;
   };
 
-  typedef std::vector<AddressInfo> AddressInfos;
+  /*!
+   *  This class holds the information that is gathered and tracked per
+   *  address of a range. The flags are packed into bitsets and the flags
+   *  and counters are stored in pages that are only allocated when they
+   *  are first written, so a range with large gaps with no instructions
+   *  or no coverage only holds the pages it uses.
+   *
+   *  The execution, taken and not taken counters have the width given
+   *  when the information is constructed. Without counters only if an
+   *  address was executed, taken or not taken is held and the counters
+   *  read as one or zero. The counters of 8 and 32 bits saturate.
+   */
+  class AddressInfos {
+
+  public:
+
+    /*!
+     *  The flags held for each address.
+     */
+    enum Flag {
+      START_OF_INSTRUCTION,
+      BRANCH,
+      NOP,
+      EXECUTED
+    };
+
+    /*!
+     *  The widths of the counters.
+     */
+    enum CounterWidth {
+      COUNTERS_NONE = 0,
+      COUNTERS_8 = 8,
+      COUNTERS_32 = 32
+    };
+
+    AddressInfos( CounterWidth width = COUNTERS_32 );
+
+    /*!
+     *  This method returns the width of the counters.
+     */
+    CounterWidth getCounterWidth() const;
+
+    /*!
+     *  This method sets the number of addresses.
+     */
+    void resize( size_t size );
+
+    /*!
+     *  This method returns the number of addresses.
+     */
+    size_t size() const;
+
+    /*!
+     *  These methods access the indication that the address is the start
+     *  of an instruction.
+     */
+    bool isStartOfInstruction( size_t slot ) const;
+    void setIsStartOfInstruction( size_t slot );
+
+    /*!
+     *  These methods access the indication that the address is a branch
+     *  instruction.
+     */
+    bool isBranch( size_t slot ) const;
+    void setIsBranch( size_t slot );
+
+    /*!
+     *  These methods access the indication that the address is a NOP
+     *  instruction.
+     */
+    bool isNop( size_t slot ) const;
+    void setIsNop( size_t slot );
+
+    /*!
+     *  These methods access how many times the address was executed.
+     */
+    uint32_t getWasExecuted( size_t slot ) const;
+    void addWasExecuted( size_t slot, uint32_t addition );
+
+    /*!
+     *  This method adds @p addition to the execution counts of @p count
+     *  slots from @p slot. The flags are set a word at a time and the
+     *  counters are summed a page at a time.
+     */
+    void addWasExecuted( size_t slot, size_t count, uint32_t addition );
+
+    /*!
+     *  These methods access how many times the branch instruction at the
+     *  address was taken.
+     */
+    uint32_t getWasTaken( size_t slot ) const;
+    void addWasTaken( size_t slot, uint32_t addition );
+
+    /*!
+     *  These methods access how many times the branch instruction at the
+     *  address was NOT taken.
+     */
+    uint32_t getWasNotTaken( size_t slot ) const;
+    void addWasNotTaken( size_t slot, uint32_t addition );
+
+    /*!
+     *  This method returns the first slot from @p slot to before @p end
+     *  where the flag is @p value. The flags are scanned a word at a
+     *  time.
+     *
+     *  @return Returns the slot found or @p end if there is none.
+     */
+    size_t find( Flag flag, size_t slot, size_t end, bool value ) const;
+
+    /*!
+     *  This method returns the number of slots from @p slot to before
+     *  @p end where the flag is set.
+     */
+    size_t count( Flag flag, size_t slot, size_t end ) const;
+
+    /*!
+     *  This method merges @p count slots of the source from @p sourceSlot
+     *  into the slots from @p slot. The start of instruction and executed
+     *  flags are ORed a word at a time and the counters are summed.
+     */
+    void merge(
+      const AddressInfos& source,
+      size_t              sourceSlot,
+      size_t              slot,
+      size_t              count
+    );
+
+    /*!
+     *  This method clears the executed flags and the counters. The start
+     *  of instruction, branch and NOP flags are kept.
+     */
+    void clearCoverage();
+
+    /*!
+     *  This method prints the information at the slot.
+     */
+    void dump( std::ostream& out, size_t slot ) const;
+
+  private:
+
+    /*
+     * The counters held for each address.
+     */
+    enum Counter {
+      EXECUTED_COUNT,
+      TAKEN_COUNT,
+      NOT_TAKEN_COUNT,
+      COUNTER_COUNT
+    };
+
+    /*
+     * A page of flags is 4096 slots as is a page of counters.
+     */
+    typedef PagedArray<uint64_t, 64>   Bits;
+    typedef PagedArray<uint8_t, 4096>  Counters8;
+    typedef PagedArray<uint32_t, 4096> Counters32;
+
+    const Bits& bits( Flag flag ) const;
+    static bool test( const Bits& bits, size_t slot );
+    static void set( Bits& bits, size_t slot );
+    uint32_t get( Counter counter, size_t slot ) const;
+    void add( Counter counter, size_t slot, uint32_t addition );
+    static uint64_t extract( const Bits& bits, size_t slot, size_t count );
+    static void set( Bits& bits, size_t slot, size_t count );
+    template <typename T>
+    static void sum(
+      PagedArray<T, 4096>& counters,
+      size_t               slot,
+      size_t               count,
+      uint32_t             addition
+    );
+    static void merge(
+      Bits&       bits,
+      size_t      slot,
+      const Bits& source,
+      size_t      sourceSlot,
+      size_t      count
+    );
+    template <typename T>
+    static void merge(
+      PagedArray<T, 4096>&       counters,
+      size_t                     slot,
+      const PagedArray<T, 4096>& source,
+      size_t                     sourceSlot,
+      size_t                     count
+    );
+
+    CounterWidth width_m;
+    size_t       size_m;
+    Bits         startOfInstruction;
+    Bits         branch;
+    Bits         nop;
+    Bits         executed;
+    Bits         countBits[ COUNTER_COUNT ];
+    Counters8    counts8[ COUNTER_COUNT ];
+    Counters32   counts32[ COUNTER_COUNT ];
+  };
 
   /*!
    *  This structure identifies the low and high addresses
@@ -68,19 +335,16 @@ namespace Coverage {
 
     AddressRange();
     AddressRange(
-      const std::string& name,
-      uint32_t           lowAddress,
-      uint32_t           highAddress
+      const std::string&         name,
+      uint32_t                   lowAddress,
+      uint32_t                   highAddress,
+      AddressInfos::CounterWidth width = AddressInfos::COUNTERS_32
     );
 
     size_t size() const;
 
     bool inside( uint32_t address ) const;
 
-    AddressInfo& get( uint32_t address );
-
-    const AddressInfo& get( uint32_t address ) const;
-
     void dump( std::ostream& out, bool show_slots = false ) const;
 
     /*!
@@ -124,11 +388,13 @@ namespace Coverage {
      *  @param[in] exefileName specifies the executable this originated in
      *  @param[in] low specifies the lowest address of the coverage map
      *  @param[in] high specifies the highest address of the coverage map
+     *  @param[in] width specifies the width of the counters
      */
     CoverageMapBase(
-      const std::string& exefileName,
-      uint32_t           low,
-      uint32_t           high
+      const std::string&         exefileName,
+      uint32_t                   low,
+      uint32_t                   high,
+      AddressInfos::CounterWidth width = AddressInfos::COUNTERS_32
     );
 
     /*!
@@ -145,6 +411,31 @@ namespace Coverage {
      */
     void Add( uint32_t low, uint32_t high );
 
+    /*!
+     *  This method merges the coverage of @p size addresses of the source
+     *  map from @p sourceAddress into this map from @p address. The start
+     *  of instruction indications are merged and the execution, taken and
+     *  not taken counts are summed a range at a time. An address outside
+     *  the ranges of either map is skipped.
+     *
+     *  @param[in] source specifies the coverage map to merge
+     *  @param[in] sourceAddress specifies the first address of the source
+     *  @param[in] address specifies the first address of this map
+     *  @param[in] size specifies the number of addresses to merge
+     */
+    void merge(
+      const CoverageMapBase& source,
+      uint32_t               sourceAddress,
+      uint32_t               address,
+      uint32_t               size
+    );
+
+    /*!
+     *  This method clears the coverage of the map so it holds the coverage
+     *  added from now on. The instructions, branches and NOPs are kept.
+     */
+    void clearCoverage();
+
     /*!
      *  This method prints the contents of the coverage map to stdout.
      */
@@ -178,6 +469,13 @@ namespace Coverage {
      */
     uint32_t getLowAddressOfRange( size_t index ) const;
 
+    /*!
+     *  This method returns the number of ranges in the RangeList.
+     *
+     *  @return Returns the number of address ranges.
+     */
+    size_t getNumberOfRanges() const;
+
     /*!
      *  This method returns true and sets the address range if
      *  the address falls with the bounds of an address range
@@ -287,6 +585,19 @@ namespace Coverage {
      */
     virtual void sumWasExecuted( uint32_t address, uint32_t addition );
 
+    /*!
+     *  This method increases the execution counters of @p size addresses
+     *  from @p address by @p addition. The range holding the addresses is
+     *  found once and its counters are summed a page at a time. An
+     *  address outside the ranges of the coverage map is skipped.
+     *
+     *  @param[in] address specifies the first address which was executed
+     *  @param[in] size specifies the number of addresses
+     *  @param[in] addition specifies the execution count that should be
+     *             added
+     */
+    void sumWasExecuted( uint32_t address, uint32_t size, uint32_t addition );
+
     /*!
      *  This method returns an unsigned integer which indicates how often
      *  the instruction at the specified address was executed.
@@ -297,6 +608,67 @@ namespace Coverage {
      */
     uint32_t getWasExecuted( uint32_t address ) const;
 
+    /*!
+     *  This method returns the number of addresses that were NOT executed
+     *  from @p address for @p size addresses. An address outside the
+     *  ranges of the coverage map was not executed.
+     *
+     *  @param[in] address specifies the first address
+     *  @param[in] size specifies the number of addresses
+     *
+     *  @return Returns the number of addresses NOT executed.
+     */
+    uint32_t getNotExecuted( uint32_t address, uint32_t size ) const;
+
+    /*!
+     *  This method returns the first address from @p address up to and
+     *  including @p highAddress whose executed state is @p executed.
+     *
+     *  @param[in] address specifies the address to search from
+     *  @param[in] highAddress specifies the last address to search
+     *  @param[in] executed specifies the executed state to find
+     *
+     *  @return Returns the address found or @p highAddress + 1 if there
+     *  is none.
+     */
+    uint32_t findExecuted(
+      uint32_t address,
+      uint32_t highAddress,
+      bool     executed
+    ) const;
+
+    /*!
+     *  This method returns the first address from @p address up to and
+     *  including @p highAddress that is the start of an instruction.
+     *
+     *  @return Returns the address found or @p highAddress + 1 if there
+     *  is none.
+     */
+    uint32_t findStartOfInstruction(
+      uint32_t address,
+      uint32_t highAddress
+    ) const;
+
+    /*!
+     *  This method returns the first address from @p address up to and
+     *  including @p highAddress that is a branch instruction.
+     *
+     *  @return Returns the address found or @p highAddress + 1 if there
+     *  is none.
+     */
+    uint32_t findBranch( uint32_t address, uint32_t highAddress ) const;
+
+    /*!
+     *  This method returns the number of instructions that start from
+     *  @p address up to and including @p highAddress.
+     *
+     *  @return Returns the number of instructions.
+     */
+    uint32_t getNumberOfInstructions(
+      uint32_t address,
+      uint32_t highAddress
+    ) const;
+
     /*!
      *  This method sets the boolean which indicates if the specified
      *  address is the starting address of a branch instruction.
@@ -437,6 +809,16 @@ namespace Coverage {
      */
     bool wasTaken( uint32_t address ) const;
 
+    /*!
+     *  This method returns a boolean which indicates if any address of
+     *  the coverage map was executed, taken or not taken. A map that was
+     *  never hit holds no coverage and does not need to be merged.
+     *
+     *  @return Returns TRUE if the coverage map was hit and FALSE
+     *   otherwise.
+     */
+    bool wasHit() const;
+
   private:
 
     /*!
@@ -444,6 +826,17 @@ namespace Coverage {
      */
     std::string exefileName;
 
+    /*!
+     * This member variable is true once an address was executed, taken or
+     * not taken.
+     */
+    bool hit;
+
+    /*!
+     * The width of the counters of the ranges.
+     */
+    AddressInfos::CounterWidth width_m;
+
     /*!
      *
      *  This is a list of address ranges for this symbolic address.
@@ -451,14 +844,42 @@ namespace Coverage {
     AddressRanges Ranges;
 
     /*!
-     * Range checked access to the info.
+     * Find the range holding the address or NULL if no range does.
+     */
+    AddressRange* findRange( uint32_t address );
+
+    /*!
+     * Find the range holding the address or NULL if no range does.
      */
-    AddressInfo& getInfo( uint32_t offset );
+    const AddressRange* findRange( uint32_t address ) const;
 
     /*!
-     * Constant range checked access to the info.
+     * Return the number of addresses from the address on which are held
+     * by the same ranges.
      */
-    const AddressInfo& getInfo( uint32_t offset ) const;
+    uint64_t segment( uint64_t address ) const;
+
+    /*!
+     * Find the first address from the address up to and including the
+     * high address where the flag is the value. An address outside the
+     * ranges has no flags set.
+     */
+    uint32_t find(
+      AddressInfos::Flag flag,
+      uint32_t           address,
+      uint32_t           highAddress,
+      bool               value
+    ) const;
+
+    /*!
+     * Count the addresses from the address up to and including the high
+     * address where the flag is set.
+     */
+    uint32_t count(
+      AddressInfos::Flag flag,
+      uint32_t           address,
+      uint32_t           highAddress
+    ) const;
 
   };
 
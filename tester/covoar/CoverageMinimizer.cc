@@ -0,0 +1,303 @@
+/*! @file CoverageMinimizer.cc
+ *  @brief CoverageMinimizer Implementation
+ *
+ *  This file contains the implementation of the selection of the
+ *  executables reaching the coverage of a test suite.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <sstream>
+
+#include <rld.h>
+#include <rld-tasks.h>
+
+#include "CoverageMinimizer.h"
+#include "CoverageMapBase.h"
+
+namespace Coverage {
+
+  /*
+   * Count the bits set in a word.
+   */
+  static inline uint64_t popcount( uint64_t word )
+  {
+#if defined(__GNUC__)
+    return __builtin_popcountll( word );
+#else
+    uint64_t count = 0;
+    while ( word ) {
+      word &= word - 1;
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+  /*
+   * The instructions of a symbol in the bitmaps. An instruction has a bit
+   * for executed and a branch has two more for taken and not taken.
+   */
+  struct symbolPoints_t {
+    const std::string*    name;
+    uint32_t              size;
+    uint64_t              first;
+    std::vector<uint32_t> offsets;
+    std::vector<bool>     branches;
+  };
+
+  CoverageMinimizer::CoverageMinimizer()
+    : points_m( 0 )
+  {
+  }
+
+  CoverageMinimizer::~CoverageMinimizer()
+  {
+  }
+
+  void CoverageMinimizer::add(
+    const DesiredSymbols&               symbolsToAnalyze,
+    const std::vector<ExecutableInfo*>& executables,
+    int                                 jobs
+  )
+  {
+    if ( names_m.empty() ) {
+      for ( const auto& exe : executables ) {
+        names_m.push_back( exe->getFileName() );
+      }
+      coverage_m.resize( names_m.size() );
+    } else if ( names_m.size() != executables.size() ) {
+      throw rld::error(
+        "Batch executables do not match", "CoverageMinimizer::add"
+      );
+    }
+
+    //
+    // Lay out the instructions of the symbols in the order of their names
+    // so the bitmaps do not depend on the order of the symbol table.
+    //
+    std::vector<symbolPoints_t> symbols;
+
+    for ( const auto& s : symbolsToAnalyze.allSymbols() ) {
+      if ( s.second.unifiedCoverageMap ) {
+        symbolPoints_t points;
+        points.name = &s.first;
+        symbols.push_back( points );
+      }
+    }
+
+    std::sort(
+      symbols.begin(),
+      symbols.end(),
+      []( const symbolPoints_t& lhs, const symbolPoints_t& rhs ) {
+        return *lhs.name < *rhs.name;
+      }
+    );
+
+    uint64_t points = points_m;
+
+    for ( auto& symbol : symbols ) {
+      const SymbolInformation& info =
+        symbolsToAnalyze.allSymbols().at( *symbol.name );
+
+      symbol.size = info.stats.sizeInBytesWithoutNops;
+      symbol.first = points;
+
+      for ( const auto& instruction : info.instructions ) {
+        if ( instruction.isInstruction && !instruction.isNop ) {
+          symbol.offsets.push_back( instruction.address - info.baseAddress );
+          symbol.branches.push_back( instruction.isBranch );
+          points += instruction.isBranch ? 3 : 1;
+        }
+      }
+    }
+
+    size_t words = ( points + 63 ) / 64;
+
+    covered_m.resize( words );
+
+    //
+    // Set the bits of each executable as its coverage maps would be merged
+    // into the unified coverage maps.
+    //
+    rld::tasks::parallel_for(
+      executables.size(),
+      std::max( jobs, 1 ),
+      [&]( size_t e ) {
+        const ExecutableInfo* exe = executables[ e ];
+        bitmap_t&             bits = coverage_m[ e ];
+
+        bits.resize( words );
+
+        auto set = [&bits]( uint64_t bit ) {
+          bits[ bit / 64 ] |= 1ULL << ( bit % 64 );
+        };
+
+        for ( const auto& symbol : symbols ) {
+          const CoverageMapBase* map = exe->getCoverageMap( *symbol.name );
+
+          if (
+            !map ||
+            !map->wasHit() ||
+            ( symbol.size != 0 && symbol.size != map->getSize() )
+          ) {
+            continue;
+          }
+
+          uint32_t base = map->getFirstLowAddress();
+          uint64_t bit = symbol.first;
+
+          for ( size_t i = 0; i < symbol.offsets.size(); ++i ) {
+            uint32_t address = base + symbol.offsets[ i ];
+
+            if ( map->wasExecuted( address ) ) {
+              set( bit );
+            }
+            ++bit;
+
+            if ( symbol.branches[ i ] ) {
+              if ( map->wasTaken( address ) ) {
+                set( bit );
+              }
+              if ( map->wasNotTaken( address ) ) {
+                set( bit + 1 );
+              }
+              bit += 2;
+            }
+          }
+        }
+      }
+    );
+
+    points_m = points;
+  }
+
+  uint64_t CoverageMinimizer::gain( size_t executable ) const
+  {
+    const bitmap_t& bits = coverage_m[ executable ];
+    uint64_t        count = 0;
+
+    for ( size_t w = 0; w < bits.size(); ++w ) {
+      count += popcount( bits[ w ] & ~covered_m[ w ] );
+    }
+
+    return count;
+  }
+
+  void CoverageMinimizer::minimize( int jobs )
+  {
+    typedef std::pair<uint64_t, size_t> candidate_t;
+
+    std::fill( covered_m.begin(), covered_m.end(), 0 );
+    selected_m.clear();
+
+    std::vector<uint64_t> gains( coverage_m.size() );
+
+    rld::tasks::parallel_for(
+      coverage_m.size(),
+      std::max( jobs, 1 ),
+      [&]( size_t e ) {
+        gains[ e ] = gain( e );
+      }
+    );
+
+    // The largest gain is at the top and an equal gain is taken in the
+    // order the executables were given.
+    auto lower = []( const candidate_t& lhs, const candidate_t& rhs ) {
+      if ( lhs.first != rhs.first ) {
+        return lhs.first < rhs.first;
+      }
+      return lhs.second > rhs.second;
+    };
+
+    std::priority_queue<
+      candidate_t, std::vector<candidate_t>, decltype( lower )
+    > candidates( lower );
+
+    for ( size_t e = 0; e < gains.size(); ++e ) {
+      if ( gains[ e ] != 0 ) {
+        candidates.push( candidate_t( gains[ e ], e ) );
+      }
+    }
+
+    while ( !candidates.empty() ) {
+      candidate_t candidate = candidates.top();
+      uint64_t    gained;
+
+      candidates.pop();
+
+      gained = gain( candidate.second );
+
+      // A gain counted before another executable was selected can only
+      // be too large. Count it again and put it back.
+      if ( gained != candidate.first ) {
+        if ( gained != 0 ) {
+          candidates.push( candidate_t( gained, candidate.second ) );
+        }
+        continue;
+      }
+
+      const bitmap_t& bits = coverage_m[ candidate.second ];
+
+      for ( size_t w = 0; w < bits.size(); ++w ) {
+        covered_m[ w ] |= bits[ w ];
+      }
+
+      selection_t selection;
+      selection.executable = candidate.second;
+      selection.gained = gained;
+      selected_m.push_back( selection );
+    }
+  }
+
+  void CoverageMinimizer::write( const std::string& fileName ) const
+  {
+    std::ofstream out( fileName, std::ios::out | std::ios::trunc );
+
+    if ( !out.is_open() ) {
+      throw rld::error(
+        "Unable to open " + fileName, "CoverageMinimizer::write"
+      );
+    }
+
+    uint64_t total = 0;
+
+    out << "# " << selected_m.size() << " of " << names_m.size()
+        << " executables cover " << getCovered() << " of " << points_m
+        << " instructions and branch directions" << std::endl
+        << "# The executables are listed in the order they were selected"
+        << std::endl
+        << "# with the coverage each adds and the coverage so far."
+        << std::endl;
+
+    for ( const auto& selection : selected_m ) {
+      total += selection.gained;
+      out << names_m[ selection.executable ]
+          << " # +" << selection.gained << ' ' << total << std::endl;
+    }
+
+    if ( out.fail() ) {
+      throw rld::error(
+        "Unable to write " + fileName, "CoverageMinimizer::write"
+      );
+    }
+  }
+
+  size_t CoverageMinimizer::getSelected() const
+  {
+    return selected_m.size();
+  }
+
+  uint64_t CoverageMinimizer::getCovered() const
+  {
+    uint64_t count = 0;
+
+    for ( auto word : covered_m ) {
+      count += popcount( word );
+    }
+
+    return count;
+  }
+
+}
@@ -0,0 +1,141 @@
+/*! @file CoverageMinimizer.h
+ *  @brief CoverageMinimizer Specification
+ *
+ *  This file contains the specification of the CoverageMinimizer class.
+ */
+
+#ifndef __COVERAGE_MINIMIZER_H__
+#define __COVERAGE_MINIMIZER_H__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "DesiredSymbols.h"
+#include "ExecutableInfo.h"
+
+namespace Coverage {
+
+  /*! @class CoverageMinimizer
+   *
+   *  This class selects the executables of a test suite that reach the
+   *  coverage of all of them. The coverage of each executable is a bitmap
+   *  of the instructions executed and the branch directions taken in the
+   *  desired symbols. A greedy set cover picks the executable adding the
+   *  most to the coverage of the executables picked before until nothing
+   *  is added, so the first executables listed add the most.
+   *
+   *  The gain of an executable only shrinks as executables are picked, so
+   *  the gains are held in a heap and only the gain at the top is counted
+   *  again. A gain is counted with word wise AND NOT and population count
+   *  operations on the bitmaps.
+   */
+  class CoverageMinimizer {
+
+  public:
+
+    /*!
+     *  This method constructs a CoverageMinimizer instance.
+     */
+    CoverageMinimizer();
+
+    /*!
+     *  This method destructs a CoverageMinimizer instance.
+     */
+    ~CoverageMinimizer();
+
+    /*!
+     *  This method adds the coverage of the executables in the desired
+     *  symbols with a unified coverage map. Each batch of symbols is added
+     *  with the executables in the same order. The executables are added
+     *  on @a jobs threads.
+     *
+     *  @param[in] symbolsToAnalyze specifies the desired symbols
+     *  @param[in] executables specifies the executables
+     *  @param[in] jobs specifies the number of threads to use
+     */
+    void add(
+      const DesiredSymbols&               symbolsToAnalyze,
+      const std::vector<ExecutableInfo*>& executables,
+      int                                 jobs
+    );
+
+    /*!
+     *  This method selects the executables. The first gains are counted on
+     *  @a jobs threads.
+     *
+     *  @param[in] jobs specifies the number of threads to use
+     */
+    void minimize( int jobs );
+
+    /*!
+     *  This method writes the executables selected, one per line in the
+     *  order they were selected, to the specified file.
+     *
+     *  @param[in] fileName specifies the file written
+     */
+    void write( const std::string& fileName ) const;
+
+    /*!
+     *  This method returns the number of executables selected.
+     */
+    size_t getSelected() const;
+
+    /*!
+     *  This method returns the number of instructions and branch
+     *  directions covered by the executables.
+     */
+    uint64_t getCovered() const;
+
+  private:
+
+    /*!
+     *  This type is a bitmap packed in words.
+     */
+    typedef std::vector<uint64_t> bitmap_t;
+
+    /*!
+     *  This type is an executable selected and the coverage it adds.
+     */
+    struct selection_t {
+      size_t   executable;
+      uint64_t gained;
+    };
+
+    /*!
+     *  This method returns the number of bits set in the coverage of the
+     *  executable and not in the coverage selected.
+     *
+     *  @param[in] executable specifies the executable
+     */
+    uint64_t gain( size_t executable ) const;
+
+    /*!
+     *  The names of the executables.
+     */
+    std::vector<std::string> names_m;
+
+    /*!
+     *  The coverage of each executable.
+     */
+    std::vector<bitmap_t> coverage_m;
+
+    /*!
+     *  The coverage of the executables selected.
+     */
+    bitmap_t covered_m;
+
+    /*!
+     *  The number of instructions and branch directions added.
+     */
+    uint64_t points_m;
+
+    /*!
+     *  The executables selected.
+     */
+    std::vector<selection_t> selected_m;
+  };
+
+}
+#endif
@@ -8,12 +8,9 @@
 #include "CoverageRanges.h"
 #include <stdio.h>
 
-namespace Coverage {
+#include <algorithm>
 
-  /*!
-   *  This member variable tracks a unique index for the ranges_t block.
-   */
-  uint32_t id_m = 0;
+namespace Coverage {
 
   CoverageRanges::CoverageRanges()
   {
@@ -27,24 +24,47 @@ namespace Coverage {
     uint32_t          lowAddressArg,
     uint32_t          highAddressArg,
     uncoveredReason_t why,
-    uint32_t          numInstructions
+    uint32_t          numInstructions,
+    uint32_t          id
   )
   {
     coverageRange_t c;
 
-    id_m++;
-    c.id               = id_m;
+    c.id               = id;
     c.lowAddress       = lowAddressArg;
     c.highAddress      = highAddressArg;
     c.reason           = why;
     c.instructionCount = numInstructions;
+
+    if ( !set.empty() && set.back().lowAddress > lowAddressArg ) {
+      sorted = false;
+    }
+
     set.push_back(c);
   }
 
-  uint32_t CoverageRanges::getId( uint32_t lowAddress )
+  uint32_t CoverageRanges::getId( uint32_t lowAddress ) const
   {
-    Coverage::CoverageRanges::ranges_t::iterator ritr;
-    uint32_t                                     result = 0;
+    Coverage::CoverageRanges::ranges_t::const_iterator ritr;
+    uint32_t                                           result = 0;
+
+    if ( sorted ) {
+      // The first range with the low address.
+      ritr = std::lower_bound(
+        set.begin(),
+        set.end(),
+        lowAddress,
+        [] ( const coverageRange_t& r, uint32_t a ) {
+          return r.lowAddress < a;
+        }
+      );
+
+      if ( ritr != set.end() && ritr->lowAddress == lowAddress ) {
+        result = ritr->id;
+      }
+
+      return result;
+    }
 
     for ( ritr =  set.begin() ; ritr != set.end() ; ritr++ ) {
       if ( ritr->lowAddress == lowAddress ) {
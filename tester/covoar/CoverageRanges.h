@@ -8,8 +8,8 @@
 #define __COVERAGE_RANGES_H__
 
 #include <stdint.h>
-#include <list>
 #include <string>
+#include <vector>
 
 namespace Coverage {
 
@@ -79,12 +79,13 @@ namespace Coverage {
     } coverageRange_t;
 
     /*!
-     *  This type contains a list of CoverageRange instances.
+     *  This type contains a vector of CoverageRange instances.
      */
-    typedef std::list<coverageRange_t> ranges_t;
+    typedef std::vector<coverageRange_t> ranges_t;
 
     /*!
-     *  This member contains a list of the CoverageRange instances.
+     *  This member contains the CoverageRange instances in the order
+     *  they were added.
      */
     ranges_t set;
 
@@ -105,13 +106,15 @@ namespace Coverage {
      *  @param[in] highAddressArg specifies the highest address of the range
      *  @param[in] why specifies the reason that the range was added
      *  @param[in] numInstructions specifies the number of instructions
+     *  @param[in] id specifies the unique index of the range
      *
      */
     void add(
       uint32_t          lowAddressArg,
       uint32_t          highAddressArg,
       uncoveredReason_t why,
-      uint32_t          numInstructions
+      uint32_t          numInstructions,
+      uint32_t          id
     );
 
 
@@ -119,10 +122,15 @@ namespace Coverage {
      *  This method returns the index of a range given the low address.
      *  Upon failure on finding the adress 0 is returned.
      */
-    uint32_t getId( uint32_t lowAddress );
+    uint32_t getId( uint32_t lowAddress ) const;
 
     protected:
 
+    /*!
+     *  This member is set if the ranges were added in ascending order of
+     *  their low addresses, so that getId() can use a binary search.
+     */
+    bool sorted = true;
 
   };
 
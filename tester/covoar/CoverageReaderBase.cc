@@ -5,10 +5,353 @@
  *  All CoverageReader implementations inherit from this.
  */
 
+#include "covoar-config.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#if HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+
+#include <rld.h>
+#include <rld-path.h>
+
 #include "CoverageReaderBase.h"
 
 namespace Coverage {
 
+  /*
+   * The size of the reads used when the file cannot be mapped.
+   */
+  static const size_t readChunkSize = 1024 * 1024;
+
+  const size_t CoverageFile::blockSize;
+
+  CoverageFile::CoverageFile(
+    const std::string& file,
+    const std::string& where
+  ) : data_m( nullptr ),
+      size_m( 0 ),
+      file_m( file ),
+      where_m( where ),
+      ready_m( 0 ),
+      stop_m( false )
+  {
+    try {
+      view_m.open( file, rld::files::view::sequential );
+    } catch ( rld::error& re ) {
+      std::ostringstream what;
+      what << "Unable to open " << file << ": " << re.what;
+      throw rld::error( what, where );
+    }
+
+    size_m = view_m.size();
+
+    if ( size_m == 0 ) {
+      view_m.close();
+      return;
+    }
+
+    if ( view_m.mapped() ) {
+      data_m = view_m.data();
+      decompress( file, where );
+      return;
+    }
+
+    buffer_m.resize( size_m );
+
+    size_t have = 0;
+    while ( have < size_m ) {
+      size_t chunk = std::min( size_m - have, readChunkSize );
+      size_t r;
+      try {
+        r = view_m.read( have, buffer_m.data() + have, chunk );
+      } catch ( rld::error& re ) {
+        std::ostringstream what;
+        what << "Unable to read " << file << ": " << re.what;
+        throw rld::error( what, where );
+      }
+      if ( r == 0 ) {
+        break;
+      }
+      have += r;
+    }
+
+    view_m.close();
+
+    size_m = have;
+    buffer_m.resize( size_m );
+    data_m = buffer_m.data();
+
+    decompress( file, where );
+  }
+
+  void CoverageFile::decompress(
+    const std::string& file,
+    const std::string& where
+  )
+  {
+    ready_m = size_m;
+
+    bool gzip = size_m >= 2 && data_m[0] == 0x1f && data_m[1] == 0x8b;
+    bool zstd =
+      size_m >= 4 &&
+      data_m[0] == 0x28 && data_m[1] == 0xb5 &&
+      data_m[2] == 0x2f && data_m[3] == 0xfd;
+
+    if ( !gzip && !zstd ) {
+      return;
+    }
+
+    if ( zstd ) {
+#if HAVE_ZSTD_H
+      std::vector<uint8_t> contents;
+      ZSTD_DStream*        stream = ::ZSTD_createDStream();
+      ZSTD_inBuffer        in = { data_m, size_m, 0 };
+      size_t               have = 0;
+      size_t               status;
+
+      if ( stream == nullptr ) {
+        throw rld::error( "Unable to initialise zstd reading " + file, where );
+      }
+
+      ::ZSTD_initDStream( stream );
+
+      contents.resize( std::max( size_m * 4, readChunkSize ) );
+
+      while ( true ) {
+        if ( have == contents.size() ) {
+          contents.resize( contents.size() * 2 );
+        }
+
+        ZSTD_outBuffer out = {
+          contents.data() + have, contents.size() - have, 0
+        };
+
+        status = ::ZSTD_decompressStream( stream, &out, &in );
+        if ( ::ZSTD_isError( status ) ) {
+          break;
+        }
+
+        have += out.pos;
+
+        // A frame is done when nothing is left to flush, the input is
+        // short if the decoder wants more with room to write.
+        if ( in.pos == in.size && ( status == 0 || out.pos < out.size ) ) {
+          break;
+        }
+      }
+
+      ::ZSTD_freeDStream( stream );
+
+      if ( status != 0 ) {
+        throw rld::error( "Invalid compressed coverage file " + file, where );
+      }
+
+      contents.resize( have );
+      view_m.close();
+
+      buffer_m.swap( contents );
+      data_m = buffer_m.data();
+      size_m = buffer_m.size();
+      ready_m = size_m;
+      return;
+#else
+      throw rld::error(
+        "Compressed coverage files are not supported reading " + file,
+        where
+      );
+#endif
+    }
+
+#if HAVE_ZLIB_H
+    // The gzip trailer holds the size of the contents modulo 4 GiB. A
+    // deflate stream expands at most 1032 times so the size is exact for
+    // a file that cannot expand to 4 GiB. A large file is decompressed
+    // into a buffer of that size by a thread while it is parsed.
+    if ( size_m >= readChunkSize && size_m < UINT32_MAX / 1032 ) {
+      const uint8_t* trailer = data_m + size_m - 4;
+      size_t         contentsSize =
+        static_cast<size_t>( trailer[0] ) |
+        ( static_cast<size_t>( trailer[1] ) << 8 ) |
+        ( static_cast<size_t>( trailer[2] ) << 16 ) |
+        ( static_cast<size_t>( trailer[3] ) << 24 );
+
+      if ( contentsSize != 0 ) {
+        const uint8_t* compressed = data_m;
+        size_t         compressedSize = size_m;
+
+        // The mapped contents stay in the view.
+        if ( !view_m.mapped() ) {
+          compressed_m.swap( buffer_m );
+        }
+
+        buffer_m.resize( contentsSize );
+        data_m = buffer_m.data();
+        size_m = contentsSize;
+        ready_m = 0;
+
+        inflater_m = std::thread(
+          [this, compressed, compressedSize]() {
+            inflateContents( compressed, compressedSize );
+          }
+        );
+        return;
+      }
+    }
+
+    std::vector<uint8_t> contents;
+    z_stream             stream;
+
+    ::memset( &stream, 0, sizeof( stream ) );
+
+    // Add 16 to the window bits to decode the gzip wrapper.
+    if ( ::inflateInit2( &stream, 16 + MAX_WBITS ) != Z_OK ) {
+      throw rld::error( "Unable to initialise zlib reading " + file, where );
+    }
+
+    stream.next_in = const_cast<Bytef*>( data_m );
+    stream.avail_in = size_m;
+
+    contents.resize( std::max( size_m * 4, readChunkSize ) );
+
+    int status;
+    do {
+      if ( stream.total_out == contents.size() ) {
+        contents.resize( contents.size() * 2 );
+      }
+      stream.next_out = contents.data() + stream.total_out;
+      stream.avail_out = contents.size() - stream.total_out;
+      status = ::inflate( &stream, Z_NO_FLUSH );
+    } while ( status == Z_OK );
+
+    contents.resize( stream.total_out );
+    ::inflateEnd( &stream );
+
+    if ( status != Z_STREAM_END ) {
+      throw rld::error( "Invalid compressed coverage file " + file, where );
+    }
+
+    view_m.close();
+
+    buffer_m.swap( contents );
+    data_m = buffer_m.data();
+    size_m = buffer_m.size();
+    ready_m = size_m;
+#else
+    throw rld::error(
+      "Compressed coverage files are not supported reading " + file,
+      where
+    );
+#endif
+  }
+
+  void CoverageFile::inflateContents(
+    const uint8_t* compressed,
+    size_t         compressedSize
+  )
+  {
+#if HAVE_ZLIB_H
+    z_stream stream;
+    int      status;
+    uint8_t  extra;
+
+    ::memset( &stream, 0, sizeof( stream ) );
+
+    status = ::inflateInit2( &stream, 16 + MAX_WBITS );
+    if ( status == Z_OK ) {
+      stream.next_in = const_cast<Bytef*>( compressed );
+      stream.avail_in = compressedSize;
+
+      // Publish the contents a block at a time. Once the buffer is full a
+      // byte more is asked for to check the stream ends there.
+      while ( status == Z_OK && !stop_m ) {
+        size_t have = stream.total_out;
+
+        if ( have < buffer_m.size() ) {
+          stream.next_out = buffer_m.data() + have;
+          stream.avail_out = std::min( blockSize, buffer_m.size() - have );
+        } else {
+          stream.next_out = &extra;
+          stream.avail_out = 1;
+        }
+
+        status = ::inflate( &stream, Z_NO_FLUSH );
+
+        if ( stream.total_out > buffer_m.size() ) {
+          status = Z_DATA_ERROR;
+          break;
+        }
+
+        {
+          std::lock_guard<std::mutex> guard( lock_m );
+          ready_m = stream.total_out;
+        }
+
+        progress_m.notify_all();
+      }
+
+      if ( status == Z_STREAM_END && stream.total_out != buffer_m.size() ) {
+        status = Z_DATA_ERROR;
+      }
+
+      ::inflateEnd( &stream );
+    }
+
+    if ( status != Z_STREAM_END && !stop_m ) {
+      std::lock_guard<std::mutex> guard( lock_m );
+      error_m = "Invalid compressed coverage file " + file_m;
+    }
+
+    progress_m.notify_all();
+#endif
+  }
+
+  void CoverageFile::wait( size_t end )
+  {
+    end = std::min( end, size_m );
+
+    if ( ready_m >= end ) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> guard( lock_m );
+
+    progress_m.wait(
+      guard,
+      [&]() { return ready_m >= end || !error_m.empty(); }
+    );
+
+    if ( ready_m < end ) {
+      throw rld::error( error_m, where_m );
+    }
+  }
+
+  CoverageFile::~CoverageFile()
+  {
+    stop_m = true;
+    if ( inflater_m.joinable() ) {
+      inflater_m.join();
+    }
+  }
+
+  const uint8_t* CoverageFile::data() const
+  {
+    return data_m;
+  }
+
+  size_t CoverageFile::size() const
+  {
+    return size_m;
+  }
+
   CoverageReaderBase::CoverageReaderBase()
   {
   }
@@ -21,4 +364,31 @@ namespace Coverage {
   {
     return branchInfoAvailable_m;
   }
+
+  std::string CoverageReaderBase::cpuFileName(
+    const std::string& file,
+    int                cpu
+  )
+  {
+    return file + ".cpu" + std::to_string( cpu );
+  }
+
+  std::vector<std::string> CoverageReaderBase::cpuFileNames(
+    const std::string& file
+  )
+  {
+    std::vector<std::string> files;
+
+    while ( true ) {
+      std::string name = cpuFileName( file, files.size() );
+
+      if ( !rld::path::check_file( name ) ) {
+        break;
+      }
+
+      files.push_back( name );
+    }
+
+    return files;
+  }
 }
@@ -7,10 +7,152 @@
 #ifndef __COVERAGE_READER_BASE_H__
 #define __COVERAGE_READER_BASE_H__
 
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rld-files.h>
+
 #include "ExecutableInfo.h"
 
 namespace Coverage {
 
+  class Timings;
+
+  /*! @class CoverageFile
+   *
+   *  This class provides read only access to the contents of a coverage
+   *  file as a single span of bytes. The file is viewed in place where the
+   *  host can map it, otherwise it is read into memory in chunks. A gzip
+   *  or zstd compressed file is decompressed into memory. A large gzip
+   *  file is decompressed by a thread while the reader parses the
+   *  contents decompressed so far, the reader waits for the contents it
+   *  parses next. The coverage file
+   *  formats are fixed size binary records and the readers parse the
+   *  records in place.
+   */
+  class CoverageFile {
+
+  public:
+
+    /*!
+     *  This method constructs a CoverageFile instance and opens the file.
+     *
+     *  @param[in] file is the coverage file to open
+     *  @param[in] where is the name of the caller used in errors
+     */
+    CoverageFile( const std::string& file, const std::string& where );
+
+    /*!
+     *  This method destructs a CoverageFile instance releasing the mapping
+     *  or buffer.
+     */
+    ~CoverageFile();
+
+    /*!
+     *  This method returns the first byte of the file's contents.
+     */
+    const uint8_t* data() const;
+
+    /*!
+     *  This method returns the size of the file's contents in bytes.
+     */
+    size_t size() const;
+
+    /*!
+     *  This method waits until the contents up to the specified offset
+     *  are available. A reader waits before it parses the contents.
+     *
+     *  @param[in] end is the offset after the contents to wait for
+     */
+    void wait( size_t end );
+
+    /*!
+     *  The size of the blocks of contents a reader parses between waits.
+     */
+    static const size_t blockSize = 256 * 1024;
+
+  private:
+
+    /*
+     * No copying.
+     */
+    CoverageFile( const CoverageFile& ) = delete;
+    CoverageFile& operator=( const CoverageFile& ) = delete;
+
+    /*!
+     *  This method replaces gzip or zstd compressed contents with the
+     *  decompressed contents.
+     */
+    void decompress( const std::string& file, const std::string& where );
+
+    /*!
+     *  This method decompresses the gzip compressed contents into the
+     *  buffer on the decompression thread.
+     */
+    void inflateContents( const uint8_t* compressed, size_t compressedSize );
+
+    /*!
+     *  The contents of the file.
+     */
+    const uint8_t* data_m;
+
+    /*!
+     *  The size of the contents.
+     */
+    size_t size_m;
+
+    /*!
+     *  The view of the file.
+     */
+    rld::files::view view_m;
+
+    /*!
+     *  The buffer holding the contents if the file is not mapped or is
+     *  decompressed.
+     */
+    std::vector<uint8_t> buffer_m;
+
+    /*!
+     *  The buffer holding the compressed contents while the decompression
+     *  thread reads them if the file is not mapped.
+     */
+    std::vector<uint8_t> compressed_m;
+
+    /*!
+     *  The name of the file and the caller used in errors.
+     */
+    std::string file_m;
+    std::string where_m;
+
+    /*!
+     *  The size of the contents decompressed so far.
+     */
+    std::atomic<size_t> ready_m;
+
+    /*!
+     *  The error of the decompression thread or empty.
+     */
+    std::string error_m;
+
+    /*!
+     *  This member variable is set to stop the decompression thread.
+     */
+    std::atomic<bool> stop_m;
+
+    /*!
+     *  The decompression thread and its protection.
+     */
+    std::thread             inflater_m;
+    std::mutex              lock_m;
+    std::condition_variable progress_m;
+  };
+
   /*! @class CoverageReaderBase
    *
    *  This is the specification of the CoverageReader base class.
@@ -43,6 +185,24 @@ namespace Coverage {
       ExecutableInfo* const executableInformation
     ) = 0;
 
+    /*!
+     *  This method returns the name of the coverage file of a CPU. A run
+     *  on an SMP target can write a coverage file for each CPU in place
+     *  of the one coverage @a file. The CPUs are numbered from 0.
+     *
+     *  @param[in] file is the name of the coverage file
+     *  @param[in] cpu is the CPU
+     */
+    static std::string cpuFileName( const std::string& file, int cpu );
+
+    /*!
+     *  This method returns the coverage files of the CPUs for a coverage
+     *  @a file. The list is empty if the CPU 0 file does not exist.
+     *
+     *  @param[in] file is the name of the coverage file
+     */
+    static std::vector<std::string> cpuFileNames( const std::string& file );
+
   /*!
    *  This method retrieves the branchInfoAvailable_m variable
    */
@@ -57,6 +217,30 @@ namespace Coverage {
    * This member variable points to the target's info
    */
   std::shared_ptr<Target::TargetBase> targetInfo_m = nullptr;
+
+  /*!
+   * This member variable is the number of threads a reader can use to
+   * process a file.
+   */
+  int jobs_m = 1;
+
+  /*!
+   * This member variable points to the timings the reader's counters are
+   * added to or is NULL.
+   */
+  Timings* timings_m = nullptr;
+
+  /*!
+   * This member variable is called by a streaming reader with the
+   * executable between the deltas it merges once the snapshot period has
+   * passed, or is empty.
+   */
+  std::function<void( ExecutableInfo* )> snapshot_m;
+
+  /*!
+   * This member variable is the number of seconds between the snapshots.
+   */
+  unsigned int snapshotSeconds_m = 0;
   };
 
 }
@@ -9,14 +9,20 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+
 #include <rld.h>
+#include <rld-path.h>
+#include <rld-tasks.h>
 
 #include "CoverageReaderQEMU.h"
 #include "CoverageMap.h"
 #include "ExecutableInfo.h"
+#include "Timings.h"
+#include "TraceChunksQEMU.h"
 
 #include "qemu-traces.h"
 
@@ -31,94 +37,431 @@ namespace Coverage {
   {
   }
 
-  void CoverageReaderQEMU::processFile(
+  TraceEntryProcessor::TraceEntryProcessor(
     const std::string&    file,
-    ExecutableInfo* const executableInformation
-  )
+    ExecutableInfo* const executableInformation,
+    uint8_t               taken,
+    uint8_t               notTaken,
+    Timings*              timings
+  ) : file_m( file ),
+      executableInformation_m( executableInformation ),
+      taken_m( taken ),
+      notTaken_m( notTaken ),
+      map_m( NULL ),
+      mapLow_m( 1 ),
+      mapHigh_m( 0 ),
+      timings_m( timings ),
+      entries_m( 0 ),
+      lookups_m( 0 ),
+      applied_m( 0 )
   {
-    struct trace_header header;
-    uintptr_t           i;
-    std::ifstream       traceFile;
-    uint8_t             taken;
-    uint8_t             notTaken;
-    uint8_t             branchInfo;
+    table_m.resize( tableSize );
 
-    taken      = targetInfo_m->qemuTakenBit();
-    notTaken   = targetInfo_m->qemuNotTakenBit();
-    branchInfo = taken | notTaken;
+    // The targets use one of two layouts of the branch bits.
+    if ( taken == TRACE_OP_BR0 && notTaken == TRACE_OP_BR1 ) {
+      apply_m = &TraceEntryProcessor::apply<TRACE_OP_BR0, TRACE_OP_BR1>;
+    } else if ( taken == TRACE_OP_BR1 && notTaken == TRACE_OP_BR0 ) {
+      apply_m = &TraceEntryProcessor::apply<TRACE_OP_BR1, TRACE_OP_BR0>;
+    } else {
+      apply_m = &TraceEntryProcessor::apply<0, 0>;
+    }
+  }
 
-    //
-    // Open the coverage file and read the header.
-    //
-    traceFile.open( file );
-    if ( !traceFile.is_open() ) {
-      std::ostringstream what;
-      what << "Unable to open " << file;
-      throw rld::error( what, "CoverageReaderQEMU::processFile" );
+  TraceEntryProcessor::~TraceEntryProcessor()
+  {
+    if ( timings_m ) {
+      timings_m->count( "trace entries", entries_m );
+      timings_m->count( "coverage map lookups", lookups_m );
+      timings_m->count( "trace entries applied", applied_m );
+    }
+  }
+
+  void TraceEntryProcessor::process( const trace_entry& entry )
+  {
+    ++entries_m;
+
+    uint32_t hash =
+      ( entry.pc ^ ( (uint32_t) entry.size << 16 ) ^ entry.op ) * 0x9e3779b1u;
+    size_t   home = hash >> ( 32 - tableBits );
+
+    // Count the entry if it is in the table or take a free slot.
+    for ( size_t p = 0; p < tableProbes; ++p ) {
+      aggregate_t& slot = table_m[ ( home + p ) & ( tableSize - 1 ) ];
+
+      if ( !slot.used ) {
+        slot.pc = entry.pc;
+        slot.size = entry.size;
+        slot.op = entry.op;
+        slot.used = true;
+        slot.count = 1;
+        return;
+      }
+
+      if (
+        slot.pc == entry.pc && slot.size == entry.size && slot.op == entry.op
+      ) {
+        if ( slot.count == UINT32_MAX ) {
+          ( this->*apply_m )( slot );
+          slot.count = 0;
+        }
+        ++slot.count;
+        return;
+      }
+    }
+
+    // Evict the entry at the home slot.
+    aggregate_t& slot = table_m[ home ];
+
+    ( this->*apply_m )( slot );
+    slot.pc = entry.pc;
+    slot.size = entry.size;
+    slot.op = entry.op;
+    slot.count = 1;
+  }
+
+  void TraceEntryProcessor::process( const trace_entry& entry, uint64_t count )
+  {
+    aggregate_t slot;
+
+    slot.pc = entry.pc;
+    slot.size = entry.size;
+    slot.op = entry.op;
+    slot.used = true;
+
+    entries_m += count;
+
+    while ( count > 0 ) {
+      slot.count = std::min( count, (uint64_t) UINT32_MAX );
+      ( this->*apply_m )( slot );
+      count -= slot.count;
+    }
+  }
+
+  void TraceEntryProcessor::flush()
+  {
+    for ( auto& slot : table_m ) {
+      if ( slot.used ) {
+        ( this->*apply_m )( slot );
+        slot.used = false;
+      }
+    }
+  }
+
+  template <uint8_t Taken, uint8_t NotTaken>
+  void TraceEntryProcessor::apply( const aggregate_t& entry )
+  {
+    const uint8_t taken = Taken != 0 ? Taken : taken_m;
+    const uint8_t notTaken = NotTaken != 0 ? NotTaken : notTaken_m;
+
+    ++applied_m;
+
+    // Obtain the coverage map containing the specified address.
+    if ( entry.pc < mapLow_m || entry.pc > mapHigh_m ) {
+      ++lookups_m;
+      map_m = executableInformation_m->getCoverageMap(
+        entry.pc, mapLow_m, mapHigh_m
+      );
+      if ( !map_m ) {
+        mapLow_m = 1;
+        mapHigh_m = 0;
+      }
+    }
+
+    // Ensure that coverage map exists.
+    if ( !map_m )
+      return;
+
+    // Set was executed for each TRACE_OP_BLOCK
+    if ( entry.op & TRACE_OP_BLOCK ) {
+      map_m->sumWasExecuted( entry.pc, entry.size, entry.count );
+    }
+
+    // Determine if additional branch information is available.
+    if ( ( entry.op & ( taken | notTaken ) ) != 0 ) {
+      uint32_t  a = entry.pc + entry.size - 1;
+      while ( a > entry.pc && !map_m->isStartOfInstruction( a ) )
+        a--;
+      if ( a == entry.pc && !map_m->isStartOfInstruction( a ) ) {
+        // Something went wrong parsing the objdump.
+        std::ostringstream what;
+        what << "Reached beginning of range in " << file_m
+          << " at " << entry.pc << " with no start of instruction.";
+        throw rld::error( what, "CoverageReaderQEMU::processFile" );
+      }
+      // The entry of a trace union can have both.
+      if ( entry.op & taken ) {
+        map_m->sumWasTaken( a, entry.count );
+      }
+      if ( entry.op & notTaken ) {
+        map_m->sumWasNotTaken( a, entry.count );
+      }
+    }
+  }
+
+  TraceBlockCounts::TraceBlockCounts()
+    : entries_m( 0 )
+  {
+  }
+
+  void TraceBlockCounts::add( const trace_entry& entry )
+  {
+    if ( ( entry.op & TRACE_OP_SPECIAL ) != 0 ) {
+      return;
+    }
+
+    uint64_t key =
+      ( (uint64_t) entry.pc << 24 ) | ( (uint64_t) entry.size << 8 ) | entry.op;
+
+    ++counts_m[ key ];
+    ++entries_m;
+  }
+
+  void TraceBlockCounts::merge( const TraceBlockCounts& other )
+  {
+    for ( const auto& count : other.counts_m ) {
+      counts_m[ count.first ] += count.second;
+    }
+
+    entries_m += other.entries_m;
+  }
+
+  void TraceBlockCounts::apply( TraceEntryProcessor& processor ) const
+  {
+    std::vector<std::pair<uint64_t, uint64_t>> counts(
+      counts_m.begin(), counts_m.end()
+    );
+
+    // The address order keeps the runs of entries in a function together.
+    std::sort( counts.begin(), counts.end() );
+
+    for ( const auto& count : counts ) {
+      trace_entry entry;
+
+      entry.pc = count.first >> 24;
+      entry.size = ( count.first >> 8 ) & 0xffff;
+      entry.op = count.first & 0xff;
+
+      processor.process( entry, count.second );
     }
+  }
+
+  uint64_t TraceBlockCounts::getEntries() const
+  {
+    return entries_m;
+  }
+
+  size_t TraceBlockCounts::getBlocks() const
+  {
+    return counts_m.size();
+  }
+
+  /*
+   * The most CPUs a tag can name. A larger CPU is a corrupt trace.
+   */
+  static const uint32_t maxCPUs = 4096;
 
-    traceFile.read( (char *) &header, sizeof( trace_header ) );
-    if ( traceFile.fail() || traceFile.gcount() != sizeof( trace_header ) ) {
+  /*
+   * Wait for the header of a trace file.
+   */
+  static void waitForHeader( CoverageFile& traceFile, const std::string& file )
+  {
+    if ( traceFile.size() < sizeof( trace_header ) ) {
       std::ostringstream what;
       what << "Unable to read header from " << file;
       throw rld::error( what, "CoverageReaderQEMU::processFile" );
     }
 
+    traceFile.wait( sizeof( trace_header ) );
+  }
+
+  /*
+   * Pass the entries of a trace file to the consumer. A chunked trace is
+   * decoded a chunk at a time, otherwise the trace entries are walked in
+   * place.
+   */
+  template <typename Consume>
+  static void walkTrace(
+    CoverageFile&      traceFile,
+    const std::string& file,
+    int                jobs,
+    Consume            consume
+  )
+  {
+    if ( Trace::isChunkedTrace( traceFile.data(), traceFile.size() ) ) {
+      traceFile.wait( traceFile.size() );
+      Trace::readTraceChunks(
+        file,
+        traceFile.data(),
+        traceFile.size(),
+        jobs,
+        [&]( const std::vector<trace_entry>& entries ) {
+          for ( const auto& entry : entries ) {
+            consume( entry );
+          }
+        }
+      );
+      return;
+    }
+
+    const uint8_t* entries = traceFile.data() + sizeof( trace_header );
+    size_t         count =
+      ( traceFile.size() - sizeof( trace_header ) ) / sizeof( trace_entry );
+
+    // Walk the entries a block at a time as they are decompressed.
+    size_t block = CoverageFile::blockSize / sizeof( trace_entry );
+
+    for ( size_t first = 0; first < count; first += block ) {
+      size_t last = std::min( first + block, count );
+
+      traceFile.wait( sizeof( trace_header ) + last * sizeof( trace_entry ) );
+
+      for ( size_t e = first; e < last; e++ ) {
+        struct trace_entry entry;
+
+        ::memcpy(
+          &entry, entries + ( e * sizeof( trace_entry ) ), sizeof( trace_entry )
+        );
+
+        consume( entry );
+      }
+    }
+  }
+
+  /*
+   * Add the coverage of the CPUs and apply it to the coverage maps. The
+   * entries and blocks of each CPU are counted in the timings.
+   */
+  static void applyCPUs(
+    const std::vector<TraceBlockCounts>& cpus,
+    TraceEntryProcessor&                 processor,
+    Timings*                             timings
+  )
+  {
+    if ( cpus.empty() ) {
+      return;
+    }
+
+    TraceBlockCounts all;
+
+    for ( size_t c = 0; c < cpus.size(); ++c ) {
+      if ( timings ) {
+        std::string cpu = "cpu " + std::to_string( c );
+        timings->count( cpu + " trace entries", cpus[ c ].getEntries() );
+        timings->count( cpu + " trace blocks", cpus[ c ].getBlocks() );
+      }
+
+      all.merge( cpus[ c ] );
+    }
+
+    all.apply( processor );
+  }
+
+  void CoverageReaderQEMU::processFile(
+    const std::string&    file,
+    ExecutableInfo* const executableInformation
+  )
+  {
+    TraceEntryProcessor processor(
+      file,
+      executableInformation,
+      targetInfo_m->qemuTakenBit(),
+      targetInfo_m->qemuNotTakenBit(),
+      timings_m
+    );
+
     //
-    // Read ENTRIES number of trace entries.
+    // A run on an SMP target can have a trace file for each CPU. The
+    // files are read in parallel.
     //
-#define ENTRIES 1024
-    while ( true ) {
-      CoverageMapBase*    aCoverageMap = NULL;
-      struct trace_entry  entries[ENTRIES];
-      struct trace_entry* entry;
-
-      // Read and process each line of the coverage file.
-      traceFile.read( (char *) entries, sizeof( struct trace_entry ) );
-      if ( traceFile.gcount() == 0 ) {
-        break;
-      }
+    std::vector<std::string> cpuFiles;
 
-      // Get the coverage map for each entry.  Note that the map is
-      // the same for each entry in the coverage map
-      for ( int count = 0; count < traceFile.gcount(); count++ ) {
+    if ( !rld::path::check_file( file ) ) {
+      cpuFiles = cpuFileNames( file );
+    }
 
-        entry = &entries[count];
+    if ( !cpuFiles.empty() ) {
+      std::vector<TraceBlockCounts> cpus( cpuFiles.size() );
+      std::vector<uint64_t>         sizes( cpuFiles.size() );
 
-        // Mark block as fully executed.
-        // Obtain the coverage map containing the specified address.
-        aCoverageMap = executableInformation->getCoverageMap( entry->pc );
+      // The chunks of a file are decoded on the thread reading the file
+      // when there are other files to read.
+      int chunkJobs = cpuFiles.size() > 1 ? 1 : jobs_m;
 
-        // Ensure that coverage map exists.
-        if ( !aCoverageMap )
-          continue;
+      rld::tasks::parallel_for(
+        cpuFiles.size(),
+        jobs_m,
+        [&]( size_t c ) {
+          CoverageFile traceFile(
+            cpuFiles[ c ], "CoverageReaderQEMU::processFile"
+          );
 
-        // Set was executed for each TRACE_OP_BLOCK
-        if ( entry->op & TRACE_OP_BLOCK ) {
-         for ( i = 0; i < entry->size; i++ ) {
-            aCoverageMap->setWasExecuted( entry->pc + i );
-          }
-        }
+          waitForHeader( traceFile, cpuFiles[ c ] );
+          sizes[ c ] = traceFile.size();
 
-        // Determine if additional branch information is available.
-        if ( ( entry->op & branchInfo ) != 0 ) {
-          uint32_t  a = entry->pc + entry->size - 1;
-            while ( a > entry->pc && !aCoverageMap->isStartOfInstruction( a ) )
-              a--;
-            if ( a == entry->pc && !aCoverageMap->isStartOfInstruction( a ) ) {
-              // Something went wrong parsing the objdump.
-              std::ostringstream what;
-              what << "Reached beginning of range in " << file
-                << " at " << entry->pc << " with no start of instruction.";
-              throw rld::error( what, "CoverageReaderQEMU::processFile" );
-            }
-            if ( entry->op & taken ) {
-              aCoverageMap->setWasTaken( a );
-            } else if ( entry->op & notTaken ) {
-              aCoverageMap->setWasNotTaken( a );
+          walkTrace(
+            traceFile,
+            cpuFiles[ c ],
+            chunkJobs,
+            [&]( const trace_entry& entry ) {
+              cpus[ c ].add( entry );
             }
+          );
+        }
+      );
+
+      if ( timings_m ) {
+        for ( auto size : sizes ) {
+          timings_m->count( "coverage bytes", size );
         }
       }
+
+      applyCPUs( cpus, processor, timings_m );
+      return;
     }
+
+    //
+    // Open the coverage file and read the header.
+    //
+    CoverageFile traceFile( file, "CoverageReaderQEMU::processFile" );
+
+    waitForHeader( traceFile, file );
+
+    if ( timings_m ) {
+      timings_m->count( "coverage bytes", traceFile.size() );
+    }
+
+    //
+    // The entries after a CPU tag are counted for the CPU and the entries
+    // of a trace without tags are applied as they are read.
+    //
+    std::vector<TraceBlockCounts> cpus;
+    size_t                        cpu = 0;
+
+    walkTrace(
+      traceFile,
+      file,
+      jobs_m,
+      [&]( const trace_entry& entry ) {
+        if ( entry.op == TRACE_OP_SPECIAL && entry.size == TRACE_SPECIAL_CPU ) {
+          if ( entry.pc >= maxCPUs ) {
+            std::ostringstream what;
+            what << "Invalid CPU " << entry.pc << " tagged in " << file;
+            throw rld::error( what, "CoverageReaderQEMU::processFile" );
+          }
+          if ( entry.pc >= cpus.size() ) {
+            cpus.resize( entry.pc + 1 );
+          }
+          cpu = entry.pc;
+        } else if ( !cpus.empty() ) {
+          cpus[ cpu ].add( entry );
+        } else {
+          processor.process( entry );
+        }
+      }
+    );
+
+    processor.flush();
+
+    applyCPUs( cpus, processor, timings_m );
   }
 }
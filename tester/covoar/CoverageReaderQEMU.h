@@ -7,13 +7,200 @@
 #ifndef __COVERAGE_READER_QEMU_H__
 #define __COVERAGE_READER_QEMU_H__
 
-#include <fstream>
+#include <stdint.h>
 
 #include "CoverageReaderBase.h"
 #include "ExecutableInfo.h"
 
+#include <unordered_map>
+#include <vector>
+
+#include "qemu-traces.h"
+
+/*!
+ *  The special operation of an entry tagging the entries after it with
+ *  the CPU in its pc. A trace of an SMP target holding the entries of all
+ *  of its CPUs starts with a tag.
+ */
+#define TRACE_SPECIAL_CPU 0x100
+
 namespace Coverage {
 
+  /*! @class TraceEntryProcessor
+   *
+   *  This class applies QEMU trace entries to the coverage maps of an
+   *  executable. The coverage map of the last entry is held with the
+   *  bounds of its symbol so runs of entries in the same function do not
+   *  repeat the symbol table lookup.
+   *
+   *  Loops repeat the same entries many times. The entries are counted
+   *  in a small open addressing hash table and an entry is applied once
+   *  with its count when it is evicted or the table is flushed, so a
+   *  repeated entry costs a probe and not a coverage map lookup and a
+   *  pass over its addresses.
+   *
+   *  The method applying an entry is specialized for the branch bits of
+   *  the target and selected once when the processor is constructed.
+   */
+  class TraceEntryProcessor {
+
+  public:
+
+    /*!
+     *  This method constructs a TraceEntryProcessor instance.
+     *
+     *  @param[in] file specifies the name of the coverage file
+     *  @param[in] executableInformation specifies the executable
+     *  @param[in] taken specifies the target's branch taken bit
+     *  @param[in] notTaken specifies the target's branch not taken bit
+     *  @param[in] timings points to the timings the counts are added to
+     */
+    TraceEntryProcessor(
+      const std::string&    file,
+      ExecutableInfo* const executableInformation,
+      uint8_t               taken,
+      uint8_t               notTaken,
+      Timings*              timings = NULL
+    );
+
+    /*!
+     *  This method destructs a TraceEntryProcessor instance adding the
+     *  entries processed and the coverage map lookups to the timings.
+     */
+    ~TraceEntryProcessor();
+
+    /*!
+     *  This method applies the trace entry to the coverage maps.
+     *
+     *  @param[in] entry specifies the trace entry
+     */
+    void process( const trace_entry& entry );
+
+    /*!
+     *  This method applies the trace entry @a count times to the coverage
+     *  maps without holding it in the table.
+     *
+     *  @param[in] entry specifies the trace entry
+     *  @param[in] count specifies the number of times it was traced
+     */
+    void process( const trace_entry& entry, uint64_t count );
+
+    /*!
+     *  This method applies the entries held in the table to the coverage
+     *  maps. Call it after the last entry.
+     */
+    void flush();
+
+  private:
+
+    /*!
+     *  This type is an entry of the table and its count.
+     */
+    struct aggregate_t {
+      uint32_t pc;
+      uint16_t size;
+      uint8_t  op;
+      bool     used;
+      uint32_t count;
+    };
+
+    /*!
+     *  The number of slots of the table, a power of two, and the slots
+     *  probed for an entry before the entry at its home slot is evicted.
+     */
+    static const int    tableBits = 12;
+    static const size_t tableSize = 1 << tableBits;
+    static const size_t tableProbes = 4;
+
+    /*!
+     *  This type is a method applying an entry.
+     */
+    typedef void ( TraceEntryProcessor::*apply_t )( const aggregate_t& );
+
+    /*!
+     *  This method applies the entry to the coverage maps count times.
+     *  A zero bit is taken from the processor's bits.
+     */
+    template <uint8_t Taken, uint8_t NotTaken>
+    void apply( const aggregate_t& entry );
+
+    std::vector<aggregate_t> table_m;
+    apply_t                  apply_m;
+
+    const std::string&    file_m;
+    ExecutableInfo* const executableInformation_m;
+    const uint8_t         taken_m;
+    const uint8_t         notTaken_m;
+    CoverageMapBase*      map_m;
+    uint32_t              mapLow_m;
+    uint32_t              mapHigh_m;
+    Timings*              timings_m;
+    uint64_t              entries_m;
+    uint64_t              lookups_m;
+    uint64_t              applied_m;
+  };
+
+  /*! @class TraceBlockCounts
+   *
+   *  This class is the partial coverage of a CPU. It counts the entries
+   *  of the CPU's trace by block and op so the CPUs can be read in
+   *  parallel without sharing the coverage maps. The counts of the CPUs
+   *  are added and then applied to the coverage maps once.
+   */
+  class TraceBlockCounts {
+
+  public:
+
+    /*!
+     *  This method constructs an empty TraceBlockCounts instance.
+     */
+    TraceBlockCounts();
+
+    /*!
+     *  This method counts the trace entry. Special entries are ignored.
+     *
+     *  @param[in] entry specifies the trace entry
+     */
+    void add( const trace_entry& entry );
+
+    /*!
+     *  This method adds the counts of another CPU.
+     *
+     *  @param[in] other specifies the counts to add
+     */
+    void merge( const TraceBlockCounts& other );
+
+    /*!
+     *  This method applies the counts to the coverage maps in address
+     *  order.
+     *
+     *  @param[in] processor specifies the processor applying the entries
+     */
+    void apply( TraceEntryProcessor& processor ) const;
+
+    /*!
+     *  This method returns the number of entries counted.
+     */
+    uint64_t getEntries() const;
+
+    /*!
+     *  This method returns the number of different blocks and ops counted.
+     */
+    size_t getBlocks() const;
+
+  private:
+
+    /*!
+     *  The counts keyed by the pc, size and op of an entry.
+     */
+    std::unordered_map<uint64_t, uint64_t> counts_m;
+
+    /*!
+     *  The number of entries counted.
+     */
+    uint64_t entries_m;
+  };
+
   /*! @class CoverageReaderQEMU
    *
    *  This class implements the functionality which reads a coverage map
@@ -23,6 +210,10 @@ namespace Coverage {
    *  was executed.  QEMU also supports reporting branch information.
    *  Several bits are set to indicate whether a branch was taken and
    *  NOT taken.
+   *
+   *  The coverage of an SMP target can be in a file for each CPU or in
+   *  one file with the entries tagged with their CPU. The CPUs are read
+   *  in parallel into partial coverage which is added.
 @verbatim
 TBD
 @endverbatim
@@ -0,0 +1,249 @@
+/*! @file CoverageReaderQEMUPlugin.cc
+ *  @brief CoverageReaderQEMUPlugin Implementation
+ *
+ *  This file contains the implementation of the functions supporting
+ *  reading the stream of the covoar QEMU TCG plugin.
+ */
+
+#include "covoar-config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if HAVE_SYS_UN_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include <vector>
+
+#include <rld.h>
+
+#include "CoverageReaderQEMU.h"
+#include "CoverageReaderQEMUPlugin.h"
+
+#include "qemu-plugin-stream.h"
+
+namespace Coverage {
+
+  /*
+   * The size of the stream read buffer.
+   */
+  static const size_t streamBufferSize = 64 * 1024;
+
+  static uint32_t getWord( const uint8_t* in )
+  {
+    return in[0] | ( in[1] << 8 ) | ( in[2] << 16 ) | ( (uint32_t) in[3] << 24 );
+  }
+
+  /*
+   * Open the stream. A socket is created at the path when it is not a
+   * regular file or FIFO and the call blocks until the plugin connects.
+   */
+  static int openStream( const std::string& file )
+  {
+    struct stat sb;
+    int         fd;
+
+    if ( ::stat( file.c_str(), &sb ) == 0 &&
+         ( S_ISREG( sb.st_mode ) || S_ISFIFO( sb.st_mode ) ) ) {
+      fd = ::open( file.c_str(), O_RDONLY );
+      if ( fd < 0 ) {
+        throw rld::error(
+          ::strerror( errno ),
+          "CoverageReaderQEMUPlugin::processFile: open: " + file
+        );
+      }
+      return fd;
+    }
+
+#if HAVE_SYS_UN_H
+    struct sockaddr_un addr;
+
+    if ( file.size() >= sizeof( addr.sun_path ) ) {
+      throw rld::error(
+        "Socket path too long: " + file,
+        "CoverageReaderQEMUPlugin::processFile"
+      );
+    }
+
+    ::memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    ::strncpy( addr.sun_path, file.c_str(), sizeof( addr.sun_path ) - 1 );
+
+    int listener = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( listener < 0 ) {
+      throw rld::error(
+        ::strerror( errno ),
+        "CoverageReaderQEMUPlugin::processFile: socket"
+      );
+    }
+
+    ::unlink( file.c_str() );
+
+    if ( ::bind( listener, (struct sockaddr*) &addr, sizeof( addr ) ) < 0 ||
+         ::listen( listener, 1 ) < 0 ) {
+      int err = errno;
+      ::close( listener );
+      throw rld::error(
+        ::strerror( err ),
+        "CoverageReaderQEMUPlugin::processFile: bind: " + file
+      );
+    }
+
+    do {
+      fd = ::accept( listener, NULL, NULL );
+    } while ( fd < 0 && errno == EINTR );
+
+    int err = errno;
+
+    ::close( listener );
+    ::unlink( file.c_str() );
+
+    if ( fd < 0 ) {
+      throw rld::error(
+        ::strerror( err ),
+        "CoverageReaderQEMUPlugin::processFile: accept: " + file
+      );
+    }
+
+    return fd;
+#else
+    throw rld::error(
+      "Not a file or FIFO and sockets are not supported: " + file,
+      "CoverageReaderQEMUPlugin::processFile"
+    );
+#endif
+  }
+
+  CoverageReaderQEMUPlugin::CoverageReaderQEMUPlugin()
+  {
+    branchInfoAvailable_m = true;
+  }
+
+  CoverageReaderQEMUPlugin::~CoverageReaderQEMUPlugin()
+  {
+  }
+
+  void CoverageReaderQEMUPlugin::processFile(
+    const std::string&    file,
+    ExecutableInfo* const executableInformation
+  )
+  {
+    const uint8_t taken = targetInfo_m->qemuTakenBit();
+    const uint8_t notTaken = targetInfo_m->qemuNotTakenBit();
+
+    TraceEntryProcessor processor(
+      file, executableInformation, taken, notTaken, timings_m
+    );
+
+    std::vector<uint8_t> buffer( streamBufferSize );
+    size_t               level = 0;
+    size_t               recordSize = 0;
+    bool                 header = false;
+
+    int fd = openStream( file );
+
+    try {
+      while ( true ) {
+        ssize_t r = ::read( fd, buffer.data() + level, buffer.size() - level );
+
+        if ( r < 0 ) {
+          if ( errno == EINTR )
+            continue;
+          throw rld::error(
+            ::strerror( errno ),
+            "CoverageReaderQEMUPlugin::processFile: read: " + file
+          );
+        }
+
+        if ( r == 0 )
+          break;
+
+        level += r;
+
+        const uint8_t* in = buffer.data();
+        const uint8_t* end = buffer.data() + level;
+
+        //
+        // Check the header before the first record.
+        //
+        if ( !header ) {
+          if ( level < sizeof( qemu_plugin_stream_header ) )
+            continue;
+
+          if ( ::memcmp(
+                 in, QEMU_PLUGIN_STREAM_MAGIC, ::strlen( QEMU_PLUGIN_STREAM_MAGIC )
+               ) != 0 ||
+               getWord( in + 8 ) != QEMU_PLUGIN_STREAM_VERSION ) {
+            throw rld::error(
+              "Invalid plugin stream header in " + file,
+              "CoverageReaderQEMUPlugin::processFile"
+            );
+          }
+
+          recordSize = getWord( in + 12 );
+          if ( recordSize < sizeof( qemu_plugin_stream_record ) ||
+               recordSize > buffer.size() / 2 ) {
+            throw rld::error(
+              "Invalid plugin stream record size in " + file,
+              "CoverageReaderQEMUPlugin::processFile"
+            );
+          }
+
+          in += sizeof( qemu_plugin_stream_header );
+          header = true;
+        }
+
+        //
+        // Process the whole records and keep a partial record for the
+        // next read.
+        //
+        while ( (size_t) ( end - in ) >= recordSize ) {
+          struct trace_entry entry;
+          uint8_t            direction = in[12];
+
+          entry.pc = getWord( in );
+          entry.size = getWord( in + 8 );
+          entry.op = TRACE_OP_BLOCK;
+
+          if ( direction == QEMU_PLUGIN_STREAM_FALL_THROUGH )
+            entry.op |= notTaken;
+          else if ( direction == QEMU_PLUGIN_STREAM_JUMP )
+            entry.op |= taken;
+
+          processor.process( entry );
+
+          in += recordSize;
+        }
+
+        level = end - in;
+        ::memmove( buffer.data(), in, level );
+      }
+    } catch ( ... ) {
+      ::close( fd );
+      throw;
+    }
+
+    ::close( fd );
+
+    processor.flush();
+
+    if ( !header ) {
+      throw rld::error(
+        "Unable to read header from " + file,
+        "CoverageReaderQEMUPlugin::processFile"
+      );
+    }
+
+    if ( level != 0 ) {
+      throw rld::error(
+        "Truncated plugin stream record in " + file,
+        "CoverageReaderQEMUPlugin::processFile"
+      );
+    }
+  }
+}
@@ -0,0 +1,45 @@
+/*! @file CoverageReaderQEMUPlugin.h
+ *  @brief CoverageReaderQEMUPlugin Specification
+ *
+ *  This file contains the specification of the CoverageReaderQEMUPlugin
+ *  class.
+ */
+
+#ifndef __COVERAGE_READER_QEMU_PLUGIN_H__
+#define __COVERAGE_READER_QEMU_PLUGIN_H__
+
+#include "CoverageReaderBase.h"
+#include "ExecutableInfo.h"
+
+namespace Coverage {
+
+  /*! @class CoverageReaderQEMUPlugin
+   *
+   *  This class implements the functionality which reads the stream of
+   *  executed translation blocks sent by the covoar QEMU TCG plugin. The
+   *  stream is read as it is produced so a run does not write a QEMU log
+   *  or trace file. The stream is specified in qemu-plugin-stream.h.
+   *
+   *  The coverage file is the path of the stream. A regular file or a
+   *  FIFO is read, otherwise a UNIX socket is created at the path and
+   *  the stream of the first plugin to connect is read.
+   */
+  class CoverageReaderQEMUPlugin : public CoverageReaderBase {
+
+  public:
+
+    /* Inherit documentation from base class. */
+    CoverageReaderQEMUPlugin();
+
+    /* Inherit documentation from base class. */
+    virtual ~CoverageReaderQEMUPlugin();
+
+    /* Inherit documentation from base class. */
+    void processFile(
+      const std::string&    file,
+      ExecutableInfo* const executableInformation
+    );
+  };
+
+}
+#endif
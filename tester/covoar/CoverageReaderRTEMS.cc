@@ -7,10 +7,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 
 #include <iostream>
-#include <fstream>
 #include <iomanip>
 
 #include <rld.h>
@@ -18,6 +18,7 @@
 #include "CoverageReaderRTEMS.h"
 #include "CoverageMap.h"
 #include "ExecutableInfo.h"
+#include "Timings.h"
 #include "rtemscov_header.h"
 
 namespace Coverage {
@@ -37,8 +38,6 @@ namespace Coverage {
   {
     CoverageMapBase*            aCoverageMap = NULL;
     uintptr_t                   baseAddress;
-    uint8_t                     cover;
-    std::ifstream               coverageFile;
     rtems_coverage_map_header_t header;
     uintptr_t                   i;
     uintptr_t                   length;
@@ -46,48 +45,58 @@ namespace Coverage {
     //
     // Open the coverage file and read the header.
     //
-    coverageFile.open( file );
-    if ( !coverageFile.is_open() ) {
-      std::ostringstream what;
-      what << "Unable to open " << file;
-      throw rld::error( what, "CoverageReaderRTEMS::processFile" );
-    }
+    CoverageFile coverageFile( file, "CoverageReaderRTEMS::processFile" );
 
-    coverageFile.read( (char *) &header, sizeof( header ) );
-    if ( coverageFile.fail() ) {
+    if ( coverageFile.size() < sizeof( header ) ) {
       std::ostringstream what;
       what << "Unable to read header from " << file;
       throw rld::error( what, "CoverageReaderRTEMS::processFile" );
     }
 
+    coverageFile.wait( sizeof( header ) );
+    ::memcpy( &header, coverageFile.data(), sizeof( header ) );
+
     baseAddress = header.start;
     length      = header.end - header.start;
 
+    const uint8_t* cover = coverageFile.data() + sizeof( header );
+    uint64_t       lookups = 0;
+    uintptr_t      available = coverageFile.size() - sizeof( header );
+
+    if ( available < length ) {
+      std::cerr << "breaking after 0x"
+                << std::hex << std::setfill( '0' )
+                << std::setw( 8 ) << available
+                << std::setfill( ' ' ) << std::dec
+                << " in " << file
+                << std::endl;
+      length = available;
+    }
+
     //
-    // Read and process each line of the coverage file.
+    // Process each byte of the coverage file.
     //
     for ( i = 0; i < length; i++ ) {
-      coverageFile.read( (char *) &cover, sizeof( uint8_t ) );
-      if ( coverageFile.fail() ) {
-        std::cerr << "breaking after 0x"
-                  << std::hex << std::setfill( '0' )
-                  << std::setw( 8 ) << i
-                  << std::setfill( ' ' ) << std::dec
-                  << " in " << file
-                  << std::endl;
-        break;
+      // Wait for each block as it is decompressed.
+      if ( ( i % CoverageFile::blockSize ) == 0 ) {
+        coverageFile.wait( sizeof( header ) + i + CoverageFile::blockSize );
       }
 
       //
       // Obtain the coverage map containing the address and
       // mark the address as executed.
       //
-      if ( cover ) {
+      if ( cover[i] ) {
+        ++lookups;
         aCoverageMap = executableInformation->getCoverageMap( baseAddress + i );
         if ( aCoverageMap )
           aCoverageMap->setWasExecuted( baseAddress + i );
       }
     }
 
+    if ( timings_m ) {
+      timings_m->count( "coverage bytes", coverageFile.size() );
+      timings_m->count( "coverage map lookups", lookups );
+    }
   }
 }
@@ -0,0 +1,298 @@
+/*! @file CoverageReaderRTEMSStream.cc
+ *  @brief CoverageReaderRTEMSStream Implementation
+ *
+ *  This file contains the implementation of the functions supporting
+ *  reading the stream of coverage deltas sent by a target running RTEMS.
+ */
+
+#include "covoar-config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if HAVE_NETDB_H
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <rld.h>
+
+#include "CoverageReaderRTEMSStream.h"
+#include "CoverageMap.h"
+#include "Timings.h"
+
+#include "rtems-coverage-stream.h"
+
+namespace Coverage {
+
+  /*
+   * The size of the stream read buffer.
+   */
+  static const size_t streamBufferSize = 64 * 1024;
+
+  static uint32_t getWord( const uint8_t* in )
+  {
+    return
+      in[0] | ( in[1] << 8 ) | ( in[2] << 16 ) | ( (uint32_t) in[3] << 24 );
+  }
+
+  /*
+   * Open the stream. A regular file or FIFO is opened, otherwise the file
+   * is HOST:PORT and the call connects to the target.
+   */
+  static int openStream( const std::string& file )
+  {
+    struct stat sb;
+    int         fd;
+
+    if ( ::stat( file.c_str(), &sb ) == 0 &&
+         ( S_ISREG( sb.st_mode ) || S_ISFIFO( sb.st_mode ) ) ) {
+      fd = ::open( file.c_str(), O_RDONLY );
+      if ( fd < 0 ) {
+        throw rld::error(
+          ::strerror( errno ),
+          "CoverageReaderRTEMSStream::processFile: open: " + file
+        );
+      }
+      return fd;
+    }
+
+    size_t colon = file.rfind( ':' );
+
+    if ( colon == std::string::npos || colon == 0 ||
+         colon + 1 == file.size() ) {
+      throw rld::error(
+        "Not a file, FIFO or HOST:PORT: " + file,
+        "CoverageReaderRTEMSStream::processFile"
+      );
+    }
+
+#if HAVE_NETDB_H
+    std::string      host = file.substr( 0, colon );
+    std::string      port = file.substr( colon + 1 );
+    struct addrinfo  hints;
+    struct addrinfo* addresses;
+
+    ::memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int r = ::getaddrinfo( host.c_str(), port.c_str(), &hints, &addresses );
+    if ( r != 0 ) {
+      throw rld::error(
+        ::gai_strerror( r ),
+        "CoverageReaderRTEMSStream::processFile: address: " + file
+      );
+    }
+
+    int err = 0;
+
+    fd = -1;
+    for ( struct addrinfo* a = addresses; a != NULL; a = a->ai_next ) {
+      fd = ::socket( a->ai_family, a->ai_socktype, a->ai_protocol );
+      if ( fd < 0 ) {
+        err = errno;
+        continue;
+      }
+
+      if ( ::connect( fd, a->ai_addr, a->ai_addrlen ) == 0 ) {
+        break;
+      }
+
+      err = errno;
+      ::close( fd );
+      fd = -1;
+    }
+
+    ::freeaddrinfo( addresses );
+
+    if ( fd < 0 ) {
+      throw rld::error(
+        ::strerror( err ),
+        "CoverageReaderRTEMSStream::processFile: connect: " + file
+      );
+    }
+
+    return fd;
+#else
+    throw rld::error(
+      "Not a file or FIFO and sockets are not supported: " + file,
+      "CoverageReaderRTEMSStream::processFile"
+    );
+#endif
+  }
+
+  CoverageReaderRTEMSStream::CoverageReaderRTEMSStream()
+  {
+  }
+
+  CoverageReaderRTEMSStream::~CoverageReaderRTEMSStream()
+  {
+  }
+
+  void CoverageReaderRTEMSStream::processFile(
+    const std::string&    file,
+    ExecutableInfo* const executableInformation
+  )
+  {
+    typedef std::chrono::steady_clock clock;
+
+    std::vector<uint8_t> buffer( streamBufferSize );
+    size_t               level = 0;
+    bool                 header = false;
+    uint32_t             start = 0;
+    uint32_t             offset = 0;
+    uint32_t             remaining = 0;
+    bool                 inDelta = false;
+    uint64_t             bytes = 0;
+    uint64_t             deltas = 0;
+    uint64_t             lookups = 0;
+    CoverageMapBase*     map = NULL;
+    uint32_t             mapLow = 1;
+    uint32_t             mapHigh = 0;
+    clock::time_point    snapshotTime = clock::now();
+
+    int fd = openStream( file );
+
+    try {
+      while ( true ) {
+        ssize_t r = ::read( fd, buffer.data() + level, buffer.size() - level );
+
+        if ( r < 0 ) {
+          if ( errno == EINTR )
+            continue;
+          throw rld::error(
+            ::strerror( errno ),
+            "CoverageReaderRTEMSStream::processFile: read: " + file
+          );
+        }
+
+        if ( r == 0 )
+          break;
+
+        level += r;
+        bytes += r;
+
+        const uint8_t* in = buffer.data();
+        const uint8_t* end = buffer.data() + level;
+
+        //
+        // Check the header before the first delta.
+        //
+        if ( !header ) {
+          if ( level < sizeof( rtems_coverage_stream_header ) )
+            continue;
+
+          if ( ::memcmp(
+                 in,
+                 RTEMS_COVERAGE_STREAM_MAGIC,
+                 ::strlen( RTEMS_COVERAGE_STREAM_MAGIC )
+               ) != 0 ||
+               getWord( in + 8 ) != RTEMS_COVERAGE_STREAM_VERSION ) {
+            throw rld::error(
+              "Invalid coverage stream header in " + file,
+              "CoverageReaderRTEMSStream::processFile"
+            );
+          }
+
+          in += sizeof( rtems_coverage_stream_header );
+          header = true;
+        }
+
+        //
+        // Merge the bytes of the deltas as they arrive and keep a partial
+        // delta header for the next read.
+        //
+        while ( in < end ) {
+          if ( !inDelta ) {
+            if ( (size_t) ( end - in ) < sizeof( rtems_coverage_stream_delta ) )
+              break;
+
+            start = getWord( in );
+            remaining = getWord( in + 4 );
+            offset = 0;
+            inDelta = true;
+            in += sizeof( rtems_coverage_stream_delta );
+          }
+
+          uint32_t count =
+            std::min( remaining, static_cast<uint32_t>( end - in ) );
+
+          for ( uint32_t i = 0; i < count; i++ ) {
+            uint32_t a = start + offset + i;
+
+            if ( in[i] == 0 )
+              continue;
+
+            if ( a < mapLow || a > mapHigh ) {
+              ++lookups;
+              map = executableInformation->getCoverageMap( a, mapLow, mapHigh );
+              if ( !map ) {
+                mapLow = 1;
+                mapHigh = 0;
+              }
+            }
+
+            // An address sent again is not executed again.
+            if ( map && !map->wasExecuted( a ) )
+              map->setWasExecuted( a );
+          }
+
+          in += count;
+          offset += count;
+          remaining -= count;
+
+          if ( remaining != 0 )
+            continue;
+
+          inDelta = false;
+          ++deltas;
+
+          if (
+            snapshot_m &&
+            clock::now() - snapshotTime >=
+              std::chrono::seconds( snapshotSeconds_m )
+          ) {
+            snapshot_m( executableInformation );
+            snapshotTime = clock::now();
+          }
+        }
+
+        level = end - in;
+        ::memmove( buffer.data(), in, level );
+      }
+    } catch ( ... ) {
+      ::close( fd );
+      throw;
+    }
+
+    ::close( fd );
+
+    if ( timings_m ) {
+      timings_m->count( "coverage bytes", bytes );
+      timings_m->count( "coverage deltas", deltas );
+      timings_m->count( "coverage map lookups", lookups );
+    }
+
+    if ( !header ) {
+      throw rld::error(
+        "Unable to read header from " + file,
+        "CoverageReaderRTEMSStream::processFile"
+      );
+    }
+
+    if ( inDelta || level != 0 ) {
+      throw rld::error(
+        "Truncated coverage stream delta in " + file,
+        "CoverageReaderRTEMSStream::processFile"
+      );
+    }
+  }
+}
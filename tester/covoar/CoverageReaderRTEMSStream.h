@@ -0,0 +1,46 @@
+/*! @file CoverageReaderRTEMSStream.h
+ *  @brief CoverageReaderRTEMSStream Specification
+ *
+ *  This file contains the specification of the CoverageReaderRTEMSStream
+ *  class.
+ */
+
+#ifndef __COVERAGE_READER_RTEMS_STREAM_H__
+#define __COVERAGE_READER_RTEMS_STREAM_H__
+
+#include "CoverageReaderBase.h"
+#include "ExecutableInfo.h"
+
+namespace Coverage {
+
+  /*! @class CoverageReaderRTEMSStream
+   *
+   *  This class implements the functionality which reads the stream of
+   *  coverage deltas a target running RTEMS sends while a test runs. The
+   *  deltas are merged into the executable's coverage maps as they arrive
+   *  so a run does not dump its coverage map to a file at the end. The
+   *  stream is specified in rtems-coverage-stream.h.
+   *
+   *  The coverage file is a regular file or a FIFO, or HOST:PORT to
+   *  connect to the target over TCP. If a snapshot is set it is called
+   *  between deltas once the snapshot period has passed.
+   */
+  class CoverageReaderRTEMSStream : public CoverageReaderBase {
+
+  public:
+
+    /* Inherit documentation from base class. */
+    CoverageReaderRTEMSStream();
+
+    /* Inherit documentation from base class. */
+    virtual ~CoverageReaderRTEMSStream();
+
+    /* Inherit documentation from base class. */
+    void processFile(
+      const std::string&    file,
+      ExecutableInfo* const executableInformation
+    );
+  };
+
+}
+#endif
@@ -7,15 +7,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 
 #include <iostream>
-#include <fstream>
 #include <iomanip>
 
+#include <rld.h>
+
 #include "CoverageReaderSkyeye.h"
 #include "CoverageMap.h"
 #include "ExecutableInfo.h"
+#include "Timings.h"
 #include "skyeye_header.h"
 
 namespace Coverage {
@@ -36,7 +39,6 @@ namespace Coverage {
     CoverageMapBase* aCoverageMap = NULL;
     uintptr_t        baseAddress;
     uint8_t          cover;
-    std::ifstream    coverageFile;
     prof_header_t    header;
     uintptr_t        i;
     uintptr_t        length;
@@ -44,29 +46,30 @@ namespace Coverage {
     //
     // Open the coverage file and read the header.
     //
-    coverageFile.open( file );
-    if ( !coverageFile ) {
-      std::ostringstream what;
-      what << "Unable to open " << file;
-      throw rld::error( what, "CoverageReaderSkyeye::processFile" );
-    }
+    CoverageFile coverageFile( file, "CoverageReaderSkyeye::processFile" );
 
-    coverageFile.read( (char *) &header, sizeof( header ) );
-    if ( coverageFile.fail() ) {
+    if ( coverageFile.size() < sizeof( header ) ) {
       std::ostringstream what;
       what << "Unable to read header from " << file;
       throw rld::error( what, "CoverageReaderSkyeye::processFile" );
     }
 
+    coverageFile.wait( sizeof( header ) );
+    ::memcpy( &header, coverageFile.data(), sizeof( header ) );
+
     baseAddress = header.prof_start;
     length      = header.prof_end - header.prof_start;
 
+    const uint8_t* data = coverageFile.data() + sizeof( header );
+    uintptr_t      available = coverageFile.size() - sizeof( header );
+    uint64_t       lookups = 0;
+
     //
-    // Read and process each line of the coverage file.
+    // Process each byte of the coverage file. Each byte covers 8 bytes
+    // of addresses.
     //
     for ( i = 0; i < length; i += 8 ) {
-      coverageFile.read( (char *) &cover, sizeof( uint8_t ) );
-      if ( coverageFile.gcount() != sizeof( uint8_t ) ) {
+      if ( ( i / 8 ) >= available ) {
         std::cerr << "CoverageReaderSkyeye::ProcessFile - breaking after 0x"
                   << std::hex << std::setfill( '0' )
                   << std::setw( 8 ) << i
@@ -76,6 +79,13 @@ namespace Coverage {
         break;
       }
 
+      // Wait for each block as it is decompressed.
+      if ( ( ( i / 8 ) % CoverageFile::blockSize ) == 0 ) {
+        coverageFile.wait( sizeof( header ) + i / 8 + CoverageFile::blockSize );
+      }
+
+      cover = data[i / 8];
+
       //
       // Obtain the coverage map containing the address and
       // mark the address as executed.
@@ -83,6 +93,7 @@ namespace Coverage {
       // NOTE: This method ONLY works for Skyeye in 32-bit mode.
       //
       if ( cover & 0x01 ) {
+        ++lookups;
         aCoverageMap = executableInformation->getCoverageMap(
           baseAddress + i
         );
@@ -96,6 +107,7 @@ namespace Coverage {
       }
 
       if ( cover & 0x10 ) {
+        ++lookups;
         aCoverageMap = executableInformation->getCoverageMap(
           baseAddress + i + 4
         );
@@ -108,5 +120,9 @@ namespace Coverage {
       }
     }
 
+    if ( timings_m ) {
+      timings_m->count( "coverage bytes", coverageFile.size() );
+      timings_m->count( "coverage map lookups", lookups );
+    }
   }
 }
@@ -5,12 +5,12 @@
  *  for the coverage files written by the SPARC simulator TSIM.
  */
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 
 #include <iostream>
-#include <fstream>
 #include <iomanip>
 
 #include <rld.h>
@@ -18,9 +18,48 @@
 #include "CoverageReaderTSIM.h"
 #include "CoverageMap.h"
 #include "ExecutableInfo.h"
+#include "Timings.h"
 
 namespace Coverage {
 
+  /*
+   * Skip white space and scan a hex number from the coverage file's
+   * contents. Returns false if there is no number at the cursor.
+   */
+  static bool scanHex(
+    const uint8_t*&      cursor,
+    const uint8_t* const end,
+    uint32_t&            value
+  )
+  {
+    while ( cursor < end && ::isspace( *cursor ) )
+      ++cursor;
+
+    if (
+      ( ( end - cursor ) > 2 ) &&
+      ( cursor[0] == '0' ) &&
+      ( ( cursor[1] == 'x' ) || ( cursor[1] == 'X' ) ) &&
+      ::isxdigit( cursor[2] )
+    ) {
+      cursor += 2;
+    }
+
+    if ( cursor >= end || !::isxdigit( *cursor ) )
+      return false;
+
+    value = 0;
+    while ( cursor < end && ::isxdigit( *cursor ) ) {
+      int c = *cursor++;
+      value <<= 4;
+      if ( c <= '9' )
+        value |= c - '0';
+      else
+        value |= ( ::tolower( c ) - 'a' ) + 10;
+    }
+
+    return true;
+  }
+
   CoverageReaderTSIM::CoverageReaderTSIM()
   {
 
@@ -36,36 +75,41 @@ namespace Coverage {
   )
   {
     CoverageMapBase* aCoverageMap = NULL;
-    int              baseAddress;
-    int              cover;
-    std::ifstream    coverageFile;
+    uint32_t         baseAddress;
+    uint32_t         cover;
     int              i;
-    char             ignore;
 
     //
     // Open the coverage file.
     //
-    coverageFile.open( file );
-    if ( !coverageFile.is_open() ) {
-      std::ostringstream what;
-      what << "Unable to open " << file;
-      throw rld::error( what, "CoverageReaderTSIM::processFile" );
-    }
+    CoverageFile coverageFile( file, "CoverageReaderTSIM::processFile" );
+
+    coverageFile.wait( coverageFile.size() );
+
+    const uint8_t*       cursor = coverageFile.data();
+    const uint8_t* const end = cursor + coverageFile.size();
+    uint64_t             lookups = 0;
 
     //
-    // Read and process each line of the coverage file.
+    // Read and process each line of the coverage file. A line is the base
+    // address, a separator and a word of coverage bits for each 32-bit word.
     //
     while ( true ) {
-      coverageFile >> std::hex >> baseAddress >> ignore >> std::dec;
-      if ( coverageFile.gcount() == 0 || coverageFile.fail() ) {
+      if ( !scanHex( cursor, end, baseAddress ) ) {
         break;
       }
 
+      while ( cursor < end && ::isspace( *cursor ) )
+        ++cursor;
+      if ( cursor >= end ) {
+        break;
+      }
+      ++cursor;
+
       for ( i = 0; i < 0x80; i += 4 ) {
         unsigned int a;
 
-        coverageFile >> std::hex >> cover >> std::dec;
-        if ( coverageFile.fail() || coverageFile.gcount() == 0 ) {
+        if ( !scanHex( cursor, end, cover ) ) {
           std::cerr << "CoverageReaderTSIM: WARNING! Short line in "
                     << file
                     << " at address 0x"
@@ -81,6 +125,7 @@ namespace Coverage {
         // mark the address as executed.
         //
         a = baseAddress + i;
+        ++lookups;
         aCoverageMap = executableInformation->getCoverageMap( a );
         if ( !aCoverageMap ) {
           continue;
@@ -103,5 +148,9 @@ namespace Coverage {
       }
     }
 
+    if ( timings_m ) {
+      timings_m->count( "coverage bytes", coverageFile.size() );
+      timings_m->count( "coverage map lookups", lookups );
+    }
   }
 }
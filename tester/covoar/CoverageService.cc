@@ -0,0 +1,269 @@
+/*! @file CoverageService.cc
+ *  @brief CoverageService Implementation
+ *
+ *  This file contains the implementation of the functions supporting
+ *  the requests of the covoar service mode.
+ */
+
+#include "covoar-config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#if HAVE_SYS_UN_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+#include <rld.h>
+
+#include "CoverageService.h"
+
+#if !defined( MSG_NOSIGNAL )
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace Coverage {
+
+  /*
+   * The size of the request read buffer.
+   */
+  static const size_t requestBufferSize = 4096;
+
+  /*
+   * Send all of the reply. A client that went away is not an error of the
+   * service.
+   */
+  static bool sendAll( int fd, const std::string& reply )
+  {
+#if HAVE_SYS_UN_H
+    const char* data = reply.data();
+    size_t      size = reply.size();
+
+    while ( size > 0 ) {
+      ssize_t sent = ::send( fd, data, size, MSG_NOSIGNAL );
+
+      if ( sent < 0 ) {
+        if ( errno == EINTR ) {
+          continue;
+        }
+        return false;
+      }
+
+      data += sent;
+      size -= sent;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  CoverageService::CoverageService( const std::string& socketPath )
+    : socketPath_m( socketPath ),
+      listener_m( -1 )
+  {
+  }
+
+  CoverageService::~CoverageService()
+  {
+    if ( listener_m >= 0 ) {
+      ::close( listener_m );
+      ::unlink( socketPath_m.c_str() );
+    }
+  }
+
+  void CoverageService::addCommand(
+    const std::string& command,
+    const std::string& usage,
+    handler_t          handler
+  )
+  {
+    command_t& c = commands_m[ command ];
+
+    c.usage = usage;
+    c.handler = handler;
+  }
+
+  bool CoverageService::request(
+    const std::string& line,
+    std::string&       reply,
+    bool               verbose
+  )
+  {
+    std::istringstream       words( line );
+    std::string              command;
+    std::vector<std::string> arguments;
+    std::string              word;
+
+    words >> command;
+
+    while ( words >> word ) {
+      arguments.push_back( word );
+    }
+
+    if ( command.empty() ) {
+      reply = "error: no command";
+      return true;
+    }
+
+    if ( verbose ) {
+      std::cerr << "Request: " << line << std::endl;
+    }
+
+    if ( command == "quit" ) {
+      reply = "ok";
+      return false;
+    }
+
+    if ( command == "help" ) {
+      reply = "ok help quit";
+      for ( const auto& c : commands_m ) {
+        reply += ", " + c.first;
+        if ( !c.second.usage.empty() ) {
+          reply += ' ' + c.second.usage;
+        }
+      }
+      return true;
+    }
+
+    auto c = commands_m.find( command );
+
+    if ( c == commands_m.end() ) {
+      reply = "error: unknown command: " + command;
+      return true;
+    }
+
+    try {
+      std::string result = c->second.handler( arguments );
+
+      reply = result.empty() ? "ok" : "ok " + result;
+    } catch ( rld::error& re ) {
+      reply = "error: " + re.where + ": " + re.what;
+    } catch ( std::exception& e ) {
+      reply = std::string( "error: " ) + e.what();
+    }
+
+    // The reply is one line.
+    for ( auto& ch : reply ) {
+      if ( ch == '\n' ) {
+        ch = ' ';
+      }
+    }
+
+    return true;
+  }
+
+  bool CoverageService::serve( int fd, bool verbose )
+  {
+    std::string pending;
+    char        buffer[ requestBufferSize ];
+
+    while ( true ) {
+      ssize_t in = ::read( fd, buffer, sizeof( buffer ) );
+
+      if ( in < 0 && errno == EINTR ) {
+        continue;
+      }
+
+      if ( in <= 0 ) {
+        return true;
+      }
+
+      pending.append( buffer, in );
+
+      size_t eol;
+
+      while ( ( eol = pending.find( '\n' ) ) != std::string::npos ) {
+        std::string line = pending.substr( 0, eol );
+        std::string reply;
+
+        pending.erase( 0, eol + 1 );
+
+        if ( !line.empty() && line[ line.size() - 1 ] == '\r' ) {
+          line.erase( line.size() - 1 );
+        }
+
+        bool more = request( line, reply, verbose );
+
+        if ( !sendAll( fd, reply + '\n' ) || !more ) {
+          return more;
+        }
+      }
+    }
+  }
+
+  void CoverageService::run( bool verbose )
+  {
+#if HAVE_SYS_UN_H
+    struct sockaddr_un addr;
+
+    if ( socketPath_m.size() >= sizeof( addr.sun_path ) ) {
+      throw rld::error(
+        "Socket path too long: " + socketPath_m,
+        "CoverageService::run"
+      );
+    }
+
+    ::memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    ::strncpy( addr.sun_path, socketPath_m.c_str(), sizeof( addr.sun_path ) - 1 );
+
+    listener_m = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( listener_m < 0 ) {
+      throw rld::error( ::strerror( errno ), "CoverageService::run: socket" );
+    }
+
+    ::unlink( socketPath_m.c_str() );
+
+    if (
+      ::bind( listener_m, (struct sockaddr*) &addr, sizeof( addr ) ) < 0 ||
+      ::listen( listener_m, 8 ) < 0
+    ) {
+      int err = errno;
+      ::close( listener_m );
+      listener_m = -1;
+      throw rld::error(
+        ::strerror( err ),
+        "CoverageService::run: bind: " + socketPath_m
+      );
+    }
+
+    if ( verbose ) {
+      std::cerr << "Serving requests on " << socketPath_m << std::endl;
+    }
+
+    bool more = true;
+
+    while ( more ) {
+      int fd = ::accept( listener_m, NULL, NULL );
+
+      if ( fd < 0 ) {
+        if ( errno == EINTR ) {
+          continue;
+        }
+        throw rld::error(
+          ::strerror( errno ),
+          "CoverageService::run: accept: " + socketPath_m
+        );
+      }
+
+      more = serve( fd, verbose );
+
+      ::close( fd );
+    }
+#else
+    throw rld::error(
+      "Sockets are not supported on this host",
+      "CoverageService::run"
+    );
+#endif
+  }
+
+}
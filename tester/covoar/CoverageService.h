@@ -0,0 +1,118 @@
+/*! @file CoverageService.h
+ *  @brief CoverageService Specification
+ *
+ *  This file contains the specification of the CoverageService class.
+ */
+
+#ifndef __COVERAGE_SERVICE_H__
+#define __COVERAGE_SERVICE_H__
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Coverage {
+
+  /*! @class CoverageService
+   *
+   *  This class implements the requests of the covoar service mode. The
+   *  service listens on a UNIX socket and reads one request per line. The
+   *  first word of a request is its command and the other words are its
+   *  arguments. Each request is answered with one line starting with "ok"
+   *  or "error" followed by the handler's reply or the error. A client may
+   *  send many requests on a connection and the connections are served
+   *  one after the other so the requests never run at the same time.
+   *
+   *  The commands "help" and "quit" are built in, "quit" stops the
+   *  service once it is answered.
+   */
+  class CoverageService {
+
+  public:
+
+    /*!
+     *  This type is the handler of a command. It is given the arguments
+     *  of the request and returns the reply. It throws an rld::error to
+     *  answer the request with an error.
+     */
+    typedef std::function<
+      std::string ( const std::vector<std::string>& arguments )
+    > handler_t;
+
+    /*!
+     *  This method constructs a CoverageService instance.
+     *
+     *  @param[in] socketPath specifies the path of the socket
+     */
+    CoverageService( const std::string& socketPath );
+
+    /*!
+     *  This method destructs a CoverageService instance. The socket is
+     *  removed.
+     */
+    ~CoverageService();
+
+    /*!
+     *  This method adds a command.
+     *
+     *  @param[in] command specifies the command
+     *  @param[in] usage specifies the arguments shown by help
+     *  @param[in] handler specifies the handler of the command
+     */
+    void addCommand(
+      const std::string& command,
+      const std::string& usage,
+      handler_t          handler
+    );
+
+    /*!
+     *  This method serves the requests until the quit command. The socket
+     *  is created before the first connection is accepted.
+     *
+     *  @param[in] verbose specifies whether to print the requests
+     */
+    void run( bool verbose );
+
+  private:
+
+    /*
+     * A command and the arguments it takes.
+     */
+    struct command_t {
+      std::string usage;
+      handler_t   handler;
+    };
+
+    /*
+     * Answer a request. Returns false if the service is to stop.
+     */
+    bool request( const std::string& line, std::string& reply, bool verbose );
+
+    /*
+     * Serve the requests of a connection. Returns false if the service is
+     * to stop.
+     */
+    bool serve( int fd, bool verbose );
+
+    /*!
+     *  This member variable contains the path of the socket.
+     */
+    std::string socketPath_m;
+
+    /*!
+     *  This member variable contains the socket listening for the clients
+     *  or -1.
+     */
+    int listener_m;
+
+    /*!
+     *  This member variable contains the commands by their name.
+     */
+    std::map<std::string, command_t> commands_m;
+
+  };
+
+}
+
+#endif
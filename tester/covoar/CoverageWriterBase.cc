@@ -5,11 +5,23 @@
  *  All CoverageWriter implementations inherit from this.
  */
 
+#include "covoar-config.h"
+
+#include <algorithm>
+#include <fstream>
+
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#include <rld.h>
+
 #include "CoverageWriterBase.h"
 
 namespace Coverage {
 
   CoverageWriterBase::CoverageWriterBase()
+    : compressed_m( false )
   {
   }
 
@@ -17,4 +29,69 @@ namespace Coverage {
   {
   }
 
+  void CoverageWriterBase::setCompressed( bool compressed )
+  {
+    compressed_m = compressed;
+  }
+
+  void CoverageWriterBase::writeContents(
+    const std::string& file,
+    const std::string& contents,
+    const std::string& where
+  ) const
+  {
+    if ( compressed_m ) {
+#if HAVE_ZLIB_H
+      gzFile gz = ::gzopen( file.c_str(), "wb" );
+      if ( gz == NULL ) {
+        std::ostringstream what;
+        what << "Unable to open " << file;
+        throw rld::error( what, where );
+      }
+
+      size_t done = 0;
+      while ( done < contents.size() ) {
+        unsigned int n =
+          std::min( contents.size() - done, static_cast<size_t>( 1 << 30 ) );
+        int w = ::gzwrite( gz, contents.data() + done, n );
+        if ( w <= 0 ) {
+          ::gzclose( gz );
+          std::ostringstream what;
+          what << "Unable to write " << file;
+          throw rld::error( what, where );
+        }
+        done += w;
+      }
+
+      if ( ::gzclose( gz ) != Z_OK ) {
+        std::ostringstream what;
+        what << "Unable to write " << file;
+        throw rld::error( what, where );
+      }
+      return;
+#else
+      throw rld::error(
+        "Compressed coverage files are not supported writing " + file,
+        where
+      );
+#endif
+    }
+
+    std::ofstream coverageFile( file, std::ios::out | std::ios::binary );
+    if ( !coverageFile.is_open() ) {
+      std::ostringstream what;
+      what << "Unable to open " << file;
+      throw rld::error( what, where );
+    }
+
+    coverageFile.write( contents.data(), contents.size() );
+    coverageFile.close();
+
+    if ( coverageFile.fail() ) {
+      std::ostringstream what;
+      what << "Unable to write " << file;
+      throw rld::error( what, where );
+    }
+  }
+
 }
@@ -53,6 +53,38 @@ namespace Coverage {
       uint32_t           lowAddress,
       uint32_t           highAddress
     ) = 0;
+
+    /*!
+     *  This method sets if the coverage file is written gzip compressed.
+     *  The coverage readers read a compressed file as they read the
+     *  file it was compressed from.
+     *
+     *  @param[in] compressed specifies if the file is compressed
+     */
+    void setCompressed( bool compressed );
+
+  protected:
+
+    /*!
+     *  This method writes the contents of a coverage file in a single
+     *  write, compressed if set.
+     *
+     *  @param[in] file specifies the name of the file to write
+     *  @param[in] contents specifies the contents of the file
+     *  @param[in] where is the name of the caller used in errors
+     */
+    void writeContents(
+      const std::string& file,
+      const std::string& contents,
+      const std::string& where
+    ) const;
+
+  private:
+
+    /*!
+     *  This member is true if the file is written compressed.
+     */
+    bool compressed_m;
   };
 
 }
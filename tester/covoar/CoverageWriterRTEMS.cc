@@ -35,21 +35,9 @@ namespace Coverage {
     uint32_t           highAddress
   )
   {
-    std::ofstream               coverageFile;
     uint32_t                    a;
-    uint8_t                     cover;
     rtems_coverage_map_header_t header;
-    std::ofstream::pos_type     bytes_before;
-
-    /*
-     *  read the file and update the coverage map passed in
-     */
-    coverageFile.open( file );
-    if ( !coverageFile.is_open() ) {
-      std::ostringstream what;
-      what << "Unable to open " << file;
-      throw rld::error( what, "CoverageWriterRTEMS::writeFile" );
-    }
+    std::string                 contents;
 
     /* clear out the header and fill it in */
     memset( &header, 0, sizeof( header ) );
@@ -59,31 +47,16 @@ namespace Coverage {
     header.end           = highAddress;
     strcpy( header.desc, "RTEMS Coverage Data" );
 
-    bytes_before = coverageFile.tellp();
-
-    coverageFile.write( (char *) &header, sizeof( header ) );
-    if ( coverageFile.tellp() - bytes_before != sizeof( header ) ) {
-      std::ostringstream what;
-      what << "Unable to write header to " << file;
-      throw rld::error( what, "CoverageWriterRTEMS::writeFile" );
-    }
+    /*
+     *  build the contents in memory and write them at once
+     */
+    contents.reserve( sizeof( header ) + ( highAddress - lowAddress ) );
+    contents.append( (char *) &header, sizeof( header ) );
 
     for ( a = lowAddress; a < highAddress; a++ ) {
-      cover  = ( ( coverage->wasExecuted( a ) ) ? 0x01 : 0 );
-
-      bytes_before = coverageFile.tellp();
-
-      coverageFile.write( (char *) &cover, sizeof( cover ) );
-      if ( coverageFile.tellp() - bytes_before != sizeof( cover ) ) {
-        std::cerr << "CoverageWriterRTEMS::writeFile - write to "
-                  << file
-                  << " at address 0x%"
-                  << std::hex << std::setfill( '0' )
-                  << std::setw( 8 ) << a
-                  << std::setfill( ' ' ) << std::dec
-                  << " failed\n";
-      }
+      contents.push_back( coverage->wasExecuted( a ) ? 0x01 : 0 );
     }
 
+    writeContents( file, contents, "CoverageWriterRTEMS::writeFile" );
   }
 }
@@ -37,21 +37,10 @@ namespace Coverage {
     uint32_t            highAddress
   )
   {
-    uint32_t                a;
-    uint8_t                 cover;
-    std::ofstream           coverageFile;
-    prof_header_t           header;
-    std::ofstream::pos_type bytes_before;
-
-    /*
-     *  read the file and update the coverage map passed in
-     */
-    coverageFile.open( file );
-    if ( !coverageFile.is_open() ) {
-      std::ostringstream what;
-      what << "Unable to open " << file;
-      throw rld::error( what, "CoverageWriterSkyeye::writeFile" );
-    }
+    uint32_t      a;
+    uint8_t       cover;
+    prof_header_t header;
+    std::string   contents;
 
     /* clear out the header and fill it in */
     memset( &header, 0, sizeof( header ) );
@@ -61,33 +50,18 @@ namespace Coverage {
     header.prof_end      = highAddress;
     strcpy( header.desc, "Skyeye Coverage Data" );
 
-    bytes_before = coverageFile.tellp();
-
-    coverageFile.write( (char *) &header, sizeof( header ) );
-    if ( coverageFile.tellp() - bytes_before != sizeof( header ) ) {
-      std::ostringstream what;
-      what << "Unable to write header to " << file;
-      throw rld::error( what, "CoverageWriterSkyeye::writeFile" );
-    }
+    /*
+     *  build the contents in memory and write them at once
+     */
+    contents.reserve( sizeof( header ) + ( highAddress - lowAddress ) / 8 + 1 );
+    contents.append( (char *) &header, sizeof( header ) );
 
     for ( a = lowAddress; a < highAddress; a += 8 ) {
       cover  = ((coverage->wasExecuted( a ))     ? 0x01 : 0);
       cover |= ((coverage->wasExecuted( a + 4 )) ? 0x10 : 0);
-
-      bytes_before = coverageFile.tellp();
-
-      coverageFile.write( (char *) &cover, sizeof( cover ) );
-      if ( coverageFile.tellp() - bytes_before != sizeof( cover ) ) {
-        std::ostringstream what;
-        what << "write to " << file
-             << " at address 0x"
-             << std::hex << std::setfill( '0' )
-             << std::setw( 8 ) << a
-             << std::setfill( ' ' ) << std::dec
-             << "failed";
-        throw rld::error( what, "CoverageWriterSkyeye::writeFile" );
-      }
+      contents.push_back( cover );
     }
 
+    writeContents( file, contents, "CoverageWriterSkyeye::writeFile" );
   }
 }
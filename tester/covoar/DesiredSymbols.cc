@@ -15,24 +15,200 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 
 #include "rld.h"
 #include <rld-config.h>
 #include "rld-symbols.h"
 #include "rld-files.h"
+#include "rld-path.h"
+#include "rld-tasks.h"
 
 #include "DesiredSymbols.h"
 #include "CoverageMap.h"
 
 namespace Coverage {
 
+  /*
+   * The symbol set cache entry header. Change the version if the format
+   * changes.
+   */
+  static const char     symbolsCacheMagic[8] = { 'C', 'O', 'V', 'S', 'Y', 'M', 'S', 0 };
+  static const uint32_t symbolsCacheVersion = 1;
+
+  static void writeU32( std::ostream& out, uint32_t value )
+  {
+    out.write( reinterpret_cast<const char*>( &value ), sizeof( value ) );
+  }
+
+  static bool readU32( std::istream& in, uint32_t& value )
+  {
+    in.read( reinterpret_cast<char*>( &value ), sizeof( value ) );
+    return in.good();
+  }
+
+  static void writeString( std::ostream& out, const std::string& s )
+  {
+    writeU32( out, s.size() );
+    out.write( s.data(), s.size() );
+  }
+
+  static bool readString( std::istream& in, std::string& s )
+  {
+    uint32_t size;
+
+    if ( !readU32( in, size ) ) {
+      return false;
+    }
+
+    s.resize( size );
+    if ( size != 0 ) {
+      in.read( &s[0], size );
+    }
+
+    return in.good();
+  }
+
+  /*
+   * Get the cache key of a symbol set. It is an FNV-1a hash of the set's
+   * name and its libraries' names and contents. An empty key is returned
+   * if a library cannot be read so the set is loaded without the cache
+   * and reports the error.
+   */
+  static std::string symbolSetKey(
+    const std::string&  setName,
+    const rld::strings& libs
+  )
+  {
+    std::vector<char> buffer( 1024 * 1024 );
+    uint64_t          hash = 14695981039346656037ULL;
+
+    auto add = [&hash]( const char* data, size_t size ) {
+      for ( size_t b = 0; b < size; ++b ) {
+        hash ^= static_cast<uint8_t>( data[b] );
+        hash *= 1099511628211ULL;
+      }
+    };
+
+    add( setName.c_str(), setName.size() + 1 );
+
+    for ( const auto& lib : libs ) {
+      std::ifstream in( lib, std::ios::in | std::ios::binary );
+      if ( !in.is_open() ) {
+        return "";
+      }
+
+      add( lib.c_str(), lib.size() + 1 );
+
+      while ( in ) {
+        in.read( buffer.data(), buffer.size() );
+        add( buffer.data(), in.gcount() );
+      }
+    }
+
+    std::ostringstream key;
+    key << "s-" << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hash;
+    return key.str();
+  }
+
+  static bool loadSymbolSetCache(
+    const std::string& path,
+    const std::string& key,
+    rld::strings&      names
+  )
+  {
+    std::ifstream in( path, std::ios::in | std::ios::binary );
+    if ( !in.is_open() ) {
+      return false;
+    }
+
+    char        magic[ sizeof( symbolsCacheMagic ) ];
+    uint32_t    version;
+    std::string entryKey;
+    uint32_t    count;
+
+    in.read( magic, sizeof( magic ) );
+    if (
+      !in.good() ||
+      ::memcmp( magic, symbolsCacheMagic, sizeof( magic ) ) != 0 ||
+      !readU32( in, version ) || version != symbolsCacheVersion ||
+      !readString( in, entryKey ) || entryKey != key ||
+      !readU32( in, count )
+    ) {
+      return false;
+    }
+
+    rld::strings cached( count );
+
+    for ( auto& name : cached ) {
+      if ( !readString( in, name ) ) {
+        return false;
+      }
+    }
+
+    names.swap( cached );
+
+    return true;
+  }
+
+  static void saveSymbolSetCache(
+    const std::string&  path,
+    const std::string&  key,
+    const rld::strings& names
+  )
+  {
+    // Write to a file of our own and rename it so a reader never sees a
+    // partial entry.
+    std::ostringstream temp;
+    temp << path << '.' << ::getpid();
+
+    {
+      std::ofstream out(
+        temp.str(),
+        std::ios::out | std::ios::binary | std::ios::trunc
+      );
+
+      if ( !out.is_open() ) {
+        return;
+      }
+
+      out.write( symbolsCacheMagic, sizeof( symbolsCacheMagic ) );
+      writeU32( out, symbolsCacheVersion );
+      writeString( out, key );
+      writeU32( out, names.size() );
+
+      for ( const auto& name : names ) {
+        writeString( out, name );
+      }
+
+      out.close();
+
+      if ( out.fail() ) {
+        ::unlink( temp.str().c_str() );
+        return;
+      }
+    }
+
+    if ( ::rename( temp.str().c_str(), path.c_str() ) != 0 ) {
+      ::unlink( temp.str().c_str() );
+    }
+  }
+
   DesiredSymbols::DesiredSymbols()
+    : counterWidth( AddressInfos::COUNTERS_32 )
   {
   }
 
   DesiredSymbols::~DesiredSymbols()
   {
+    for (auto& s : set) {
+      delete s.second.unifiedCoverageMap;
+      delete s.second.uncoveredRanges;
+      delete s.second.uncoveredBranches;
+    }
   }
 
   const DesiredSymbols::symbolSet_t& DesiredSymbols::allSymbols() const
@@ -44,7 +220,8 @@ namespace Coverage {
     const std::string& symbolsSet,
     const std::string& buildTarget,
     const std::string& buildBSP,
-    bool               verbose
+    bool               verbose,
+    const std::string& cacheDirectory
   )
   {
     //
@@ -75,41 +252,94 @@ namespace Coverage {
 
     // Load the symbols for each set specified in the config file.
     for (const auto& setName : sets) {
-      rld::files::cache cache;
-      cache.open();
-
       if (verbose)
         std::cerr << "Loading symbols for set: " << setName << std::endl;
       const rld::config::section& set_section = config.get_section(setName);
       rld::strings libs;
       rld::config::parse_items (set_section, "libraries", libs, true);
-      for (std::string lib : libs) {
+      for (std::string& lib : libs) {
         lib = rld::find_replace(lib, "@BUILD-TARGET@", buildTarget);
         lib = rld::find_replace(lib, "@BSP@", buildBSP);
-        if (verbose)
-          std::cerr << " Loading library: " << lib << std::endl;
-        cache.add(lib);
       }
 
-      rld::symbols::table symbols;
+      // The function symbols of the set's libraries, from the cache if the
+      // libraries have not changed.
+      rld::strings names;
+      std::string  key;
+      std::string  cachePath;
+
+      if (!cacheDirectory.empty()) {
+        key = symbolSetKey(setName, libs);
+        if (!key.empty())
+          rld::path::path_join(cacheDirectory, key + ".symbols", cachePath);
+      }
 
-      cache.load_symbols (symbols, true);
+      if (cachePath.empty() || !loadSymbolSetCache(cachePath, key, names)) {
+        rld::files::cache cache;
+        cache.open();
 
-      // Populate the symbol maps with all global symbols.
-      for (auto& kv : symbols.globals()) {
-        const rld::symbols::symbol& sym = *(kv.second);
-        if (sym.type() == sym.st_func) {
-          set[sym.name()] = SymbolInformation();
-          setNamesToSymbols[setName].push_back(sym.name());
+        for (const auto& lib : libs) {
+          if (verbose)
+            std::cerr << " Loading library: " << lib << std::endl;
+          cache.add(lib);
         }
-      }
-      // Populate the symbol maps with all weak symbols.
-      for (auto& kv : symbols.weaks()) {
-        const rld::symbols::symbol& sym = *(kv.second);
-        if (sym.type() == sym.st_func) {
-          set[sym.name()] = SymbolInformation();
-          setNamesToSymbols[setName].push_back(sym.name());
+
+        rld::symbols::table symbols;
+
+        cache.load_symbols (symbols, true);
+
+        // Add all global symbols then all weak symbols.
+        for (auto& kv : symbols.globals()) {
+          const rld::symbols::symbol& sym = *(kv.second);
+          if (sym.type() == sym.st_func)
+            names.push_back(sym.name());
         }
+        for (auto& kv : symbols.weaks()) {
+          const rld::symbols::symbol& sym = *(kv.second);
+          if (sym.type() == sym.st_func)
+            names.push_back(sym.name());
+        }
+
+        if (!cachePath.empty())
+          saveSymbolSetCache(cachePath, key, names);
+      } else if (verbose) {
+        std::cerr << " Loaded " << names.size() << " symbols from the cache"
+                  << std::endl;
+      }
+
+      // Populate the symbol maps.
+      std::vector<std::string>& setSymbols = setNamesToSymbols[setName];
+      set.reserve(set.size() + names.size());
+      for (auto& name : names) {
+        set[name] = SymbolInformation();
+        setSymbols.push_back(std::move(name));
+      }
+    }
+  }
+
+  void DesiredSymbols::setCounterWidth( AddressInfos::CounterWidth width )
+  {
+    counterWidth = width;
+  }
+
+  AddressInfos::CounterWidth DesiredSymbols::getCounterWidth() const
+  {
+    return counterWidth;
+  }
+
+  void DesiredSymbols::select(
+    const DesiredSymbols&           symbols,
+    const std::vector<std::string>& setNames
+  )
+  {
+    for (const auto& setName : setNames) {
+      const std::vector<std::string>& names = symbols.getSymbolsForSet(setName);
+      std::vector<std::string>&       setSymbols = setNamesToSymbols[setName];
+
+      set.reserve(set.size() + names.size());
+      for (const auto& name : names) {
+        set[name] = SymbolInformation();
+        setSymbols.push_back(name);
       }
     }
   }
@@ -134,211 +364,311 @@ namespace Coverage {
     }
   }
 
-  void DesiredSymbols::calculateStatistics( void )
+  void DesiredSymbols::clearAnalysis()
   {
-    // Look at each symbol set.
-    for (const auto& kv : setNamesToSymbols) {
-      // Look at each symbol.
-      for (const auto& symbol : kv.second) {
-        SymbolInformation& info = set.at(symbol);
+    for (auto& s : set) {
+      SymbolInformation& info = s.second;
+      Statistics         cleared;
+
+      // The sizes are of the symbol and not of the analysis.
+      cleared.sizeInBytes = info.stats.sizeInBytes;
+      cleared.sizeInBytesWithoutNops = info.stats.sizeInBytesWithoutNops;
+      info.stats = cleared;
+
+      delete info.uncoveredRanges;
+      info.uncoveredRanges = NULL;
+      delete info.uncoveredBranches;
+      info.uncoveredBranches = NULL;
+    }
 
-        // If the unified coverage map does not exist, the symbol was
-        // never referenced by any executable.  Just skip it.
-        CoverageMapBase* theCoverageMap = info.unifiedCoverageMap;
-        if (theCoverageMap) {
-          // Increment the total sizeInBytes by the bytes in the symbol
-          stats[kv.first].sizeInBytes += info.stats.sizeInBytes;
-
-          // Now scan through the coverage map of this symbol.
-          uint32_t endAddress = info.stats.sizeInBytes - 1;
-
-          for (uint32_t a = 0; a <= endAddress; ++a) {
-            // If we are at the start of instruction increment
-            // instruction type counters as needed.
-            if ( theCoverageMap->isStartOfInstruction( a ) ) {
-
-              stats[kv.first].sizeInInstructions++;
-              info.stats.sizeInInstructions++;
-
-              if (!theCoverageMap->wasExecuted( a ) ) {
-                stats[kv.first].uncoveredInstructions++;
-                info.stats.uncoveredInstructions++;
-
-                if ( theCoverageMap->isBranch( a )) {
-                  stats[kv.first].branchesNotExecuted++;
-                  info.stats.branchesNotExecuted++;
-                }
-              } else if (theCoverageMap->isBranch( a )) {
-                stats[kv.first].branchesExecuted++;
-                info.stats.branchesExecuted++;
-              }
-            }
+    stats.clear();
+  }
 
-            if (!theCoverageMap->wasExecuted( a )) {
-              stats[kv.first].uncoveredBytes++;
-              info.stats.uncoveredBytes++;
-            }
+  /*
+   * Count the instructions, branches and bytes executed and not executed
+   * in the coverage map of a symbol.
+   */
+  static void calculateSymbolStatistics( SymbolInformation& info )
+  {
+    CoverageMapBase* theCoverageMap = info.unifiedCoverageMap;
+
+    // Now scan through the coverage map of this symbol.
+    uint32_t endAddress = info.stats.sizeInBytes - 1;
+
+    for (uint32_t a = 0; a <= endAddress; ++a) {
+      // If we are at the start of instruction increment
+      // instruction type counters as needed.
+      if ( theCoverageMap->isStartOfInstruction( a ) ) {
+
+        info.stats.sizeInInstructions++;
+
+        if (!theCoverageMap->wasExecuted( a ) ) {
+          info.stats.uncoveredInstructions++;
+
+          if ( theCoverageMap->isBranch( a )) {
+            info.stats.branchesNotExecuted++;
           }
-        } else {
-          stats[kv.first].unreferencedSymbols++;
+        } else if (theCoverageMap->isBranch( a )) {
+          info.stats.branchesExecuted++;
         }
       }
     }
+
+    // Count the bytes not executed.
+    info.stats.uncoveredBytes +=
+      theCoverageMap->getNotExecuted( 0, info.stats.sizeInBytes );
   }
 
+  std::vector<SymbolInformation*> DesiredSymbols::referencedSymbols( void )
+  {
+    std::vector<SymbolInformation*> symbols;
 
-  void DesiredSymbols::computeUncovered( bool verbose )
+    for (auto& s : set) {
+      if (s.second.unifiedCoverageMap)
+        symbols.push_back(&s.second);
+    }
+
+    return symbols;
+  }
+
+  void DesiredSymbols::calculateStatistics( int jobs )
   {
-    // Look at each symbol set.
+    std::vector<SymbolInformation*> symbols = referencedSymbols();
+
+    // The symbols are independent, each is counted by one task.
+    rld::tasks::parallel_for(
+      symbols.size(),
+      std::max(jobs, 1),
+      [&](size_t i) {
+        calculateSymbolStatistics(*symbols[i]);
+      }
+    );
+
+    // Sum the statistics of the symbols of each symbol set.
     for (const auto& kv : setNamesToSymbols) {
-      // Look at each symbol.
       for (const auto& symbol : kv.second) {
-        SymbolInformation& info = set.at(symbol);
+        const SymbolInformation& info = set.at(symbol);
+        Statistics&              setStats = stats[kv.first];
+
         // If the unified coverage map does not exist, the symbol was
-        // never referenced by any executable.  Just skip it.
-        CoverageMapBase* theCoverageMap = info.unifiedCoverageMap;
-        if (theCoverageMap) {
-          // Create containers for the symbol's uncovered ranges and branches.
-          CoverageRanges* theRanges = new CoverageRanges();
-          info.uncoveredRanges = theRanges;
-          CoverageRanges* theBranches = new CoverageRanges();
-          info.uncoveredBranches = theBranches;
-
-          uint32_t a;
-          uint32_t la;
-          uint32_t ha;
-          uint32_t endAddress;
-          uint32_t count;
-
-          // Mark NOPs as executed
-          a = info.stats.sizeInBytes - 1;
-          count = 0;
-          while (a > 0) {
-            if (theCoverageMap->isStartOfInstruction( a )) {
-              break;
-            }
+        // never referenced by any executable.
+        if (info.unifiedCoverageMap) {
+          setStats.sizeInBytes += info.stats.sizeInBytes;
+          setStats.sizeInInstructions += info.stats.sizeInInstructions;
+          setStats.uncoveredInstructions += info.stats.uncoveredInstructions;
+          setStats.branchesNotExecuted += info.stats.branchesNotExecuted;
+          setStats.branchesExecuted += info.stats.branchesExecuted;
+          setStats.uncoveredBytes += info.stats.uncoveredBytes;
+        } else {
+          setStats.unreferencedSymbols++;
+        }
+      }
+    }
+  }
 
-            count++;
+  /*
+   * Find the uncovered ranges and branches in the coverage map of a
+   * symbol. The ranges get their indexes later in the order of the
+   * symbol sets.
+   */
+  static void computeSymbolUncovered( SymbolInformation& info )
+  {
+    CoverageMapBase* theCoverageMap = info.unifiedCoverageMap;
+
+    // Create containers for the symbol's uncovered ranges and branches.
+    CoverageRanges* theRanges = new CoverageRanges();
+    info.uncoveredRanges = theRanges;
+    CoverageRanges* theBranches = new CoverageRanges();
+    info.uncoveredBranches = theBranches;
+
+    uint32_t a;
+    uint32_t la;
+    uint32_t ha;
+    uint32_t endAddress;
+    uint32_t count;
+
+    // Mark NOPs as executed
+    a = info.stats.sizeInBytes - 1;
+    count = 0;
+    while (a > 0) {
+      if (theCoverageMap->isStartOfInstruction( a )) {
+        break;
+      }
 
-            if (theCoverageMap->isNop( a )) {
-              for (la = a; la < (a + count); la++) {
-                theCoverageMap->setWasExecuted( la );
-              }
+      count++;
 
-              count = 0;
-            }
+      if (theCoverageMap->isNop( a )) {
+        for (la = a; la < (a + count); la++) {
+          theCoverageMap->setWasExecuted( la );
+        }
 
-            a--;
-          }
+        count = 0;
+      }
 
-          endAddress = info.stats.sizeInBytes - 1;
-          a = 0;
-          while (a < endAddress) {
-            if (!theCoverageMap->wasExecuted( a )) {
-              a++;
-              continue;
-            }
+      a--;
+    }
 
-            for (ha=a+1;
-                ha <= endAddress && !theCoverageMap->isStartOfInstruction( ha );
-                ha++)
-              ;
-            if ( ha >= endAddress )
-              break;
-
-            if (theCoverageMap->isNop( ha ))
-              do {
-                theCoverageMap->setWasExecuted( ha );
-                ha++;
-                if ( ha > endAddress )
-                  break;
-              } while ( !theCoverageMap->isStartOfInstruction( ha ) ||
-                        theCoverageMap->isNop( ha ) );
-            a = ha;
-          }
+    endAddress = info.stats.sizeInBytes - 1;
+    a = 0;
+    while (a < endAddress) {
+      // Skip to the next executed address.
+      a = theCoverageMap->findExecuted( a, endAddress - 1, true );
+      if ( a >= endAddress )
+        break;
+
+      ha = theCoverageMap->findStartOfInstruction( a + 1, endAddress );
+      if ( ha >= endAddress )
+        break;
+
+      if (theCoverageMap->isNop( ha ))
+        do {
+          theCoverageMap->setWasExecuted( ha );
+          ha++;
+          if ( ha > endAddress )
+            break;
+        } while ( !theCoverageMap->isStartOfInstruction( ha ) ||
+                  theCoverageMap->isNop( ha ) );
+      a = ha;
+    }
+
+    // Now scan through the coverage map of this symbol.
+    endAddress = info.stats.sizeInBytesWithoutNops - 1;
+    a = 0;
+    while (a <= endAddress) {
+      // If an address was NOT executed, find consecutive unexecuted
+      // addresses and add them to the uncovered ranges.
+      if (!theCoverageMap->wasExecuted( a )) {
+
+        la = a;
+        ha = theCoverageMap->findExecuted( a + 1, endAddress, true );
+        ha--;
+        count = 1;
+        if ( ha > la )
+          count += theCoverageMap->getNumberOfInstructions( la + 1, ha );
+
+        info.stats.uncoveredRanges++;
+        theRanges->add(
+          info.baseAddress + la,
+          info.baseAddress + ha,
+          CoverageRanges::UNCOVERED_REASON_NOT_EXECUTED,
+          count,
+          0
+        );
+        a = ha + 1;
+      }
 
-          // Now scan through the coverage map of this symbol.
-          endAddress = info.stats.sizeInBytesWithoutNops - 1;
-          a = 0;
-          while (a <= endAddress) {
-            // If an address was NOT executed, find consecutive unexecuted
-            // addresses and add them to the uncovered ranges.
-            if (!theCoverageMap->wasExecuted( a )) {
-
-              la = a;
-              count = 1;
-              for (ha = a + 1;
-                  ha <= endAddress && !theCoverageMap->wasExecuted( ha );
-                  ha++)
-              {
-                if ( theCoverageMap->isStartOfInstruction( ha ) )
-                  count++;
-              }
-              ha--;
-
-              stats[kv.first].uncoveredRanges++;
-              info.stats.uncoveredRanges++;
-              theRanges->add(
-                info.baseAddress + la,
-                info.baseAddress + ha,
-                CoverageRanges::UNCOVERED_REASON_NOT_EXECUTED,
-                count
-              );
-              a = ha + 1;
+      // If an address is a branch instruction, add any uncovered branches
+      // to the uncoverd branches.
+      else if (theCoverageMap->isBranch( a )) {
+        la = a;
+        ha = theCoverageMap->findStartOfInstruction( a + 1, endAddress );
+        ha--;
+
+        if (theCoverageMap->wasAlwaysTaken( la )) {
+          info.stats.branchesAlwaysTaken++;
+          theBranches->add(
+            info.baseAddress + la,
+            info.baseAddress + ha,
+            CoverageRanges::UNCOVERED_REASON_BRANCH_ALWAYS_TAKEN,
+            1,
+            0
+          );
+        }
+        else if (theCoverageMap->wasNeverTaken( la )) {
+          info.stats.branchesNeverTaken++;
+          theBranches->add(
+            info.baseAddress + la,
+            info.baseAddress + ha,
+            CoverageRanges::UNCOVERED_REASON_BRANCH_NEVER_TAKEN,
+            1,
+            0
+          );
+        }
+        a = ha + 1;
+      }
+
+      // Skip the executed addresses up to the next one not executed
+      // or the next branch.
+      else
+        a = std::min(
+          theCoverageMap->findExecuted( a + 1, endAddress, false ),
+          theCoverageMap->findBranch( a + 1, endAddress )
+        );
+    }
+  }
+
+  void DesiredSymbols::computeUncovered(
+    bool      verbose,
+    uint32_t& lastRangeId,
+    int       jobs
+  )
+  {
+    std::vector<SymbolInformation*> symbols = referencedSymbols();
+
+    // The symbols are independent, each is scanned by one task.
+    rld::tasks::parallel_for(
+      symbols.size(),
+      std::max(jobs, 1),
+      [&](size_t i) {
+        computeSymbolUncovered(*symbols[i]);
+      }
+    );
+
+    // Index the ranges and branches in the order the symbol sets and the
+    // addresses of each symbol are scanned and sum the statistics of each
+    // symbol set.
+    for (const auto& kv : setNamesToSymbols) {
+      for (const auto& symbol : kv.second) {
+        SymbolInformation& info = set.at(symbol);
+
+        if (!info.unifiedCoverageMap)
+          continue;
+
+        CoverageRanges::ranges_t& ranges = info.uncoveredRanges->set;
+        CoverageRanges::ranges_t& branches = info.uncoveredBranches->set;
+        bool                      indexed =
+          (!ranges.empty() && ranges.front().id != 0) ||
+          (!branches.empty() && branches.front().id != 0);
+
+        if (!indexed) {
+          auto r = ranges.begin();
+          auto b = branches.begin();
+
+          while (r != ranges.end() || b != branches.end()) {
+            if (
+              b == branches.end() ||
+              (r != ranges.end() && r->lowAddress < b->lowAddress)
+            ) {
+              r->id = ++lastRangeId;
+              ++r;
+              continue;
             }
 
-            // If an address is a branch instruction, add any uncovered branches
-            // to the uncoverd branches.
-            else if (theCoverageMap->isBranch( a )) {
-              la = a;
-              for (ha = a + 1;
-                ha <= endAddress && !theCoverageMap->isStartOfInstruction( ha );
-                  ha++)
-                ;
-              ha--;
-
-              if (theCoverageMap->wasAlwaysTaken( la )) {
-                stats[kv.first].branchesAlwaysTaken++;
-                info.stats.branchesAlwaysTaken++;
-                theBranches->add(
-                  info.baseAddress + la,
-                  info.baseAddress + ha,
-                  CoverageRanges::UNCOVERED_REASON_BRANCH_ALWAYS_TAKEN,
-                  1
-                );
-                if (verbose)
-                  std::cerr << "Branch always taken found in" << symbol
-                            << std::hex
-                            << " (0x" << info.baseAddress + la
-                            << " - 0x" << info.baseAddress + ha
-                            << ")"
-                            << std::dec
-                            << std::endl;
-              }
-              else if (theCoverageMap->wasNeverTaken( la )) {
-                stats[kv.first].branchesNeverTaken++;
-                info.stats.branchesNeverTaken++;
-                theBranches->add(
-                  info.baseAddress + la,
-                  info.baseAddress + ha,
-                  CoverageRanges::UNCOVERED_REASON_BRANCH_NEVER_TAKEN,
-                  1
-                  );
-                if (verbose)
-                  std::cerr << "Branch never taken found in " << symbol
-                            << std::hex
-                            << " (0x" << info.baseAddress + la
-                            << " - 0x" << info.baseAddress + ha
-                            << ")"
-                            << std::dec
-                            << std::endl;
-              }
-              a = ha + 1;
+            b->id = ++lastRangeId;
+
+            if (verbose) {
+              if (b->reason ==
+                  CoverageRanges::UNCOVERED_REASON_BRANCH_ALWAYS_TAKEN)
+                std::cerr << "Branch always taken found in" << symbol;
+              else
+                std::cerr << "Branch never taken found in " << symbol;
+              std::cerr << std::hex
+                        << " (0x" << b->lowAddress
+                        << " - 0x" << b->highAddress
+                        << ")"
+                        << std::dec
+                        << std::endl;
             }
-            else
-              a++;
+
+            ++b;
           }
         }
+
+        Statistics& setStats = stats[kv.first];
+
+        setStats.uncoveredRanges += info.stats.uncoveredRanges;
+        setStats.branchesAlwaysTaken += info.stats.branchesAlwaysTaken;
+        setStats.branchesNeverTaken += info.stats.branchesNeverTaken;
       }
     }
   }
@@ -400,7 +730,8 @@ namespace Coverage {
 
       highAddress = size - 1;
 
-      aCoverageMap = new CoverageMap( exefileName, 0, highAddress );
+      aCoverageMap =
+        new CoverageMap( exefileName, 0, highAddress, counterWidth );
 
       if ( verbose )
         fprintf(
@@ -420,12 +751,38 @@ namespace Coverage {
 
   )
   {
+    // Look up all the addresses in one sorted pass of the line table.
+    std::vector<uint32_t>    addresses;
+    std::vector<std::string> locations;
+
+    addresses.reserve( theRanges->set.size() * 2 );
+    for (const auto& r : theRanges->set) {
+      addresses.push_back( r.lowAddress );
+      addresses.push_back( r.highAddress );
+    }
+
+    std::sort( addresses.begin(), addresses.end() );
+    addresses.erase(
+      std::unique( addresses.begin(), addresses.end() ),
+      addresses.end()
+    );
+
+    theExecutable->getSourceAndLines( addresses, locations );
+
+    for (auto& l : locations) {
+      l = rld::path::basename( l );
+    }
+
+    auto location = [&]( uint32_t address ) -> const std::string& {
+      size_t a = std::lower_bound(
+        addresses.begin(), addresses.end(), address
+      ) - addresses.begin();
+      return locations[ a ];
+    };
+
     for (auto& r : theRanges->set) {
-      std::string location;
-      theExecutable->getSourceAndLine(r.lowAddress, location);
-      r.lowSourceLine = rld::path::basename (location);
-      theExecutable->getSourceAndLine(r.highAddress, location);
-      r.highSourceLine = rld::path::basename (location);
+      r.lowSourceLine = location( r.lowAddress );
+      r.highSourceLine = location( r.highAddress );
     }
   }
 
@@ -568,27 +925,93 @@ namespace Coverage {
       return;
     }
 
-    // Merge the data for each address.
+    // Merge the data of the addresses a range at a time.
     CoverageMapBase* destinationCoverageMap = sinfo.unifiedCoverageMap;
 
-    for (uint32_t dAddress = 0; dAddress < dMapSize; dAddress++) {
+    destinationCoverageMap->merge(
+      *sourceCoverageMap,
+      sBaseAddress,
+      0,
+      dMapSize
+    );
+  }
+
+  void DesiredSymbols::mergeCoverageMaps(
+    const std::vector<ExecutableInfo*>& executables,
+    int                                 jobs
+  )
+  {
+    std::vector<const std::string*> symbols;
+
+    // Only symbols with a unified coverage map can be merged.
+    for (const auto& s : set) {
+      if (s.second.unifiedCoverageMap)
+        symbols.push_back(&s.first);
+    }
+
+    rld::tasks::parallel_for(
+      symbols.size(),
+      std::max(jobs, 1),
+      [&](size_t i) {
+        const std::string& symbolName = *symbols[i];
+        for (const auto& exe : executables) {
+          // A map never hit only holds the start of the instructions
+          // which the unified map has from the symbol's instructions.
+          const CoverageMapBase* map = exe->getCoverageMap(symbolName);
+          if (map && map->wasHit())
+            mergeCoverageMap(symbolName, map);
+        }
+      }
+    );
+  }
+
+  void DesiredSymbols::writeSymbolOrder( const std::string& fileName ) const
+  {
+    std::vector<std::pair<uint64_t, const std::string*>> hits;
 
-      uint32_t sAddress = dAddress + sBaseAddress;
+    for (const auto& s : set) {
+      const SymbolInformation& info = s.second;
+      CoverageMapBase*         theCoverageMap = info.unifiedCoverageMap;
 
-      // Merge start of instruction indication.
-      if (sourceCoverageMap->isStartOfInstruction( sAddress ))
-        destinationCoverageMap->setIsStartOfInstruction( dAddress );
+      if (theCoverageMap) {
+        uint64_t count = 0;
+        for (uint32_t a = 0; a < info.stats.sizeInBytes; ++a) {
+          if ( theCoverageMap->isStartOfInstruction( a ) )
+            count += theCoverageMap->getWasExecuted( a );
+        }
+        if (count)
+          hits.push_back( std::make_pair( count, &s.first ) );
+      }
+    }
 
-      // Merge the execution data.
-      uint32_t executionCount = sourceCoverageMap->getWasExecuted( sAddress );
-      destinationCoverageMap->sumWasExecuted( dAddress, executionCount );
+    std::sort(
+      hits.begin(),
+      hits.end(),
+      []( const std::pair<uint64_t, const std::string*>& lhs,
+          const std::pair<uint64_t, const std::string*>& rhs ) {
+        if ( lhs.first != rhs.first )
+          return lhs.first > rhs.first;
+        return *lhs.second < *rhs.second;
+      }
+    );
+
+    std::ofstream out( fileName, std::ios::out | std::ios::trunc );
+    if ( !out.is_open() ) {
+      throw rld::error(
+        "Unable to open " + fileName,
+        "DesiredSymbols::writeSymbolOrder"
+      );
+    }
 
-      // Merge the branch data.
-      executionCount = sourceCoverageMap->getWasTaken( sAddress );
-      destinationCoverageMap->sumWasTaken( dAddress, executionCount );
+    out << "# Executed symbols, most executed instructions first" << std::endl;
+    for (const auto& h : hits)
+      out << *h.second << std::endl;
 
-      executionCount = sourceCoverageMap->getWasNotTaken( sAddress );
-      destinationCoverageMap->sumWasNotTaken( dAddress, executionCount );
+    if ( !out ) {
+      throw rld::error(
+        "Unable to write " + fileName,
+        "DesiredSymbols::writeSymbolOrder"
+      );
     }
   }
 }
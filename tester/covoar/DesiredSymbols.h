@@ -11,6 +11,8 @@
 #include <map>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "CoverageMapBase.h"
 #include "CoverageRanges.h"
@@ -143,7 +145,7 @@ namespace Coverage {
     /*!
      *  This member contains the disassembly associated with a symbol.
      */
-    std::list<objdumpLine_t> instructions;
+    std::vector<objdumpLine_t> instructions;
 
     /*!
      *  This member contains the executable that was used to
@@ -198,9 +200,10 @@ namespace Coverage {
   public:
 
     /*!
-     *  This map associates each symbol with its symbol information.
+     *  This map associates each symbol with its symbol information. It is
+     *  hashed so it is not in the order of the symbol names.
      */
-    typedef std::map<std::string, SymbolInformation> symbolSet_t;
+    typedef std::unordered_map<std::string, SymbolInformation> symbolSet_t;
 
     /*!
      *  This method constructs a DesiredSymbols instance.
@@ -208,7 +211,8 @@ namespace Coverage {
     DesiredSymbols();
 
     /*!
-     *  This method destructs a DesiredSymbols instance.
+     *  This method destructs a DesiredSymbols instance. The coverage maps
+     *  and ranges of the symbols are deleted.
      */
     ~DesiredSymbols();
 
@@ -220,17 +224,29 @@ namespace Coverage {
     /*!
      *  This method loops through the coverage map and
      *  calculates the statistics that have not already
-     *  been filled in.
+     *  been filled in. The symbols are counted by @a jobs
+     *  threads and summed for each symbol set.
+     *
+     *  @param[in] jobs specifies the number of threads to use
      */
-    void calculateStatistics( void );
+    void calculateStatistics( int jobs = 1 );
 
     /*!
      *  This method analyzes each symbols coverage map to determine any
-     *  uncovered ranges or branches.
+     *  uncovered ranges or branches. The symbols are analyzed by @a jobs
+     *  threads, the ranges are indexed in the order of the symbol sets
+     *  as if they were analyzed one after the other.
      *
      *  @param[in] verbose specifies whether to be verbose with output
-     */
-    void computeUncovered( bool verbose );
+     *  @param[in,out] lastRangeId specifies the index of the last range
+     *                 added, the ranges get the following indexes
+     *  @param[in] jobs specifies the number of threads to use
+     */
+    void computeUncovered(
+      bool      verbose,
+      uint32_t& lastRangeId,
+      int       jobs = 1
+    );
 
     /*!
      *  This method creates a coverage map for the specified symbol
@@ -380,15 +396,47 @@ namespace Coverage {
      *  This method creates the set of symbols to analyze from the symbols
      *  listed in the specified file.
      *
+     *  The function symbols of a set's libraries are cached in the cache
+     *  directory if one is given. The cache entry is keyed by the set's
+     *  name and the names and contents of its libraries.
+     *
      *  @param[in] symbolsSet An INI format file of the symbols to be loaded.
      *  @param[in] buildTarget The build target
      *  @param[in] buildBSP The BSP
+     *  @param[in] cacheDirectory The cache directory or empty for no cache
      */
     void load(
       const std::string& symbolsSet,
       const std::string& buildTarget,
       const std::string& buildBSP,
-      bool               verbose
+      bool               verbose,
+      const std::string& cacheDirectory = ""
+    );
+
+    /*!
+     *  This method sets the width of the counters of the coverage maps
+     *  created for the symbols and their executables.
+     *
+     *  @param[in] width specifies the width of the counters
+     */
+    void setCounterWidth( AddressInfos::CounterWidth width );
+
+    /*!
+     *  This method returns the width of the counters of the coverage maps.
+     */
+    AddressInfos::CounterWidth getCounterWidth() const;
+
+    /*!
+     *  This method creates the set of symbols to analyze from the
+     *  specified sets of another set of desired symbols. Only the names
+     *  are copied so a batch of sets can be analyzed at a time.
+     *
+     *  @param[in] symbols specifies the desired symbols to select from
+     *  @param[in] setNames specifies the names of the sets to select
+     */
+    void select(
+      const DesiredSymbols&           symbols,
+      const std::vector<std::string>& setNames
     );
 
     /*!
@@ -404,6 +452,21 @@ namespace Coverage {
       const CoverageMapBase* const sourceCoverageMap
     );
 
+    /*!
+     *  This method merges the coverage maps of the executables into the
+     *  unified coverage maps. The symbols are shared between @a jobs
+     *  threads and each thread merges all the executables' maps for a
+     *  symbol in the order of the executables. No unified coverage map
+     *  is written by more than one thread.
+     *
+     *  @param[in] executables specifies the executables to merge
+     *  @param[in] jobs specifies the number of threads to use
+     */
+    void mergeCoverageMaps(
+      const std::vector<ExecutableInfo*>& executables,
+      int                                 jobs
+    );
+
     /*!
      *  This method preprocesses each symbol's coverage map to mark nop
      *  and branch information.
@@ -412,8 +475,30 @@ namespace Coverage {
      */
     void preprocess( const DesiredSymbols& symbolsToAnalyze );
 
+    /*!
+     *  This method clears the uncovered ranges and branches and the
+     *  statistics of the symbols and symbol sets so the unified coverage
+     *  maps can be analyzed again once more coverage was merged into
+     *  them.
+     */
+    void clearAnalysis();
+
+    /*!
+     *  This method writes the executed symbols with the most executed
+     *  instructions first, one name per line. The file is a symbol order
+     *  for rtems-ld.
+     *
+     *  @param[in] fileName specifies the name of the file to write
+     */
+    void writeSymbolOrder( const std::string& fileName ) const;
+
   private:
 
+    /*!
+     *  This method returns the symbols with a unified coverage map.
+     */
+    std::vector<SymbolInformation*> referencedSymbols( void );
+
     /*!
      *  This method uses the specified executable file to determine the
      *  source lines for the elements in the specified ranges.
@@ -439,6 +524,11 @@ namespace Coverage {
      */
     std::map<std::string, Statistics> stats;
 
+    /*!
+     *  This member contains the width of the counters of the coverage maps.
+     */
+    AddressInfos::CounterWidth counterWidth;
+
   };
 }
 
@@ -7,6 +7,8 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
 #include <rld.h>
 
 #include "ExecutableInfo.h"
@@ -23,6 +25,7 @@ namespace Coverage {
     DesiredSymbols&    symbolsToAnalyze
     ) : fileName( theExecutableName ),
         loadAddress( 0 ),
+        lastCoverageMapRange( 0 ),
         symbolsToAnalyze_m( symbolsToAnalyze )
   {
     if ( !theLibraryName.empty() ) {
@@ -38,26 +41,26 @@ namespace Coverage {
       std::cerr << std::endl;
     }
 
-    rld::files::object executable( theExecutableName );
+    // Each executable has its own ELF type so executables of different
+    // architectures can be loaded at the same time.
+    rld::elf::object_type types;
+    rld::files::object    executable( theExecutableName );
 
+    executable.set_object_type( types );
     executable.open();
     executable.begin();
     executable.load_symbols( symbols );
 
+    // Only the functions are needed to create the coverage maps. A lazy
+    // load does not read the line tables, they are loaded when a source
+    // line is first looked up.
     rld::dwarf::file debug;
 
     debug.begin( executable.elf() );
-    debug.load_debug();
+    debug.load_debug( true );
     debug.load_functions();
 
     for ( auto& cu : debug.get_cus() ) {
-      AddressLineRange& range = mapper.makeRange( cu.pc_low(), cu.pc_high() );
-      // Does not filter on desired symbols under the assumption that the test
-      // code and any support code is small relative to what is being tested.
-      for ( const auto &address : cu.get_addresses() ) {
-        range.addSourceLine( address );
-      }
-
       for ( auto& func : cu.get_functions() ) {
         if ( !func.has_machine_code() ) {
           continue;
@@ -102,6 +105,9 @@ namespace Coverage {
 
   ExecutableInfo::~ExecutableInfo()
   {
+    for ( auto& cm : coverageMaps ) {
+      delete cm.second;
+    }
   }
 
   void ExecutableInfo::dumpCoverageMaps()
@@ -126,17 +132,64 @@ namespace Coverage {
 
   CoverageMapBase* ExecutableInfo::getCoverageMap( uint32_t address )
   {
-    CoverageMapBase*       aCoverageMap = NULL;
-    CoverageMaps::iterator it;
-    std::string            itsSymbol;
+    uint32_t low;
+    uint32_t high;
+
+    return getCoverageMap( address, low, high );
+  }
+
+  CoverageMapBase* ExecutableInfo::getCoverageMap(
+    uint32_t  address,
+    uint32_t& low,
+    uint32_t& high
+  )
+  {
+    // Check the range found by the last lookup first.
+    if ( lastCoverageMapRange < coverageMapIndex.size() ) {
+      const coverageMapRange_t& last = coverageMapIndex[ lastCoverageMapRange ];
+      if ( last.low <= address && address <= last.high ) {
+        low = last.low;
+        high = last.high;
+        return last.map;
+      }
+    }
 
-    // Obtain the coverage map containing the specified address.
-    itsSymbol = theSymbolTable.getSymbol( address );
-    if ( itsSymbol != "" ) {
-      aCoverageMap = &findCoverageMap( itsSymbol );
+    // Find the first range whose high address is not less than the
+    // specified address.
+    auto range = std::lower_bound(
+      coverageMapIndex.begin(),
+      coverageMapIndex.end(),
+      address,
+      [] ( const coverageMapRange_t& r, uint32_t a ) { return r.high < a; }
+    );
+
+    if ( range == coverageMapIndex.end() || range->low > address ) {
+      return NULL;
     }
 
-    return aCoverageMap;
+    lastCoverageMapRange = range - coverageMapIndex.begin();
+    low = range->low;
+    high = range->high;
+
+    return range->map;
+  }
+
+  void ExecutableInfo::indexCoverageMaps()
+  {
+    const SymbolTable::contents_t& ranges = theSymbolTable.getRanges();
+
+    coverageMapIndex.clear();
+    coverageMapIndex.reserve( ranges.size() );
+    lastCoverageMapRange = 0;
+
+    // The symbol table is ordered by the high address of the ranges.
+    for ( const auto& r : ranges ) {
+      coverageMapRange_t range;
+      range.low = r.low;
+      range.high = r.high;
+      range.map = &findCoverageMap( r.symbol );
+      coverageMapIndex.push_back( range );
+    }
   }
 
   const std::string& ExecutableInfo::getFileName() const
@@ -171,6 +224,18 @@ namespace Coverage {
     return *(cmi->second);
   }
 
+  const CoverageMapBase* ExecutableInfo::getCoverageMap(
+    const std::string& symbolName
+  ) const
+  {
+    CoverageMaps::const_iterator cmi = coverageMaps.find( symbolName );
+    if ( cmi == coverageMaps.end() ) {
+      return NULL;
+    }
+
+    return cmi->second;
+  }
+
   void ExecutableInfo::createCoverageMap (
     const std::string& fileName,
     const std::string& symbolName,
@@ -193,7 +258,12 @@ namespace Coverage {
 
     itr = coverageMaps.find( symbolName );
     if ( itr == coverageMaps.end() ) {
-      theMap = new CoverageMap( fileName, lowAddress, highAddress );
+      theMap = new CoverageMap(
+        fileName,
+        lowAddress,
+        highAddress,
+        symbolsToAnalyze_m.getCounterWidth()
+      );
       coverageMaps[ symbolName ] = theMap;
     } else {
       theMap = itr->second;
@@ -201,18 +271,60 @@ namespace Coverage {
     }
   }
 
+  void ExecutableInfo::loadSourceLines()
+  {
+    rld::elf::object_type types;
+    rld::files::object    executable( fileName );
+
+    executable.set_object_type( types );
+    executable.open();
+    executable.begin();
+
+    rld::dwarf::file debug;
+
+    debug.begin( executable.elf() );
+    debug.load_debug( true );
+
+    for ( auto& cu : debug.get_cus() ) {
+      AddressLineRange& range = mapper.makeRange( cu.pc_low(), cu.pc_high() );
+      // Does not filter on desired symbols under the assumption that the test
+      // code and any support code is small relative to what is being tested.
+      for ( const auto &address : cu.get_addresses() ) {
+        mapper.addSourceLine( range, address );
+      }
+    }
+
+    mapper.indexRanges();
+  }
+
   void ExecutableInfo::getSourceAndLine(
     const unsigned int address,
     std::string&       line
   )
   {
-    std::string        file;
-    int                lno;
-    std::ostringstream ss;
+    std::string file;
+    int         lno;
 
+    std::call_once( sourceLinesLoaded, &ExecutableInfo::loadSourceLines, this );
     mapper.getSource( address, file, lno );
-    ss << file << ':' << lno;
-    line = ss.str ();
+    line = file + ':' + std::to_string( lno );
+  }
+
+  void ExecutableInfo::getSourceAndLines(
+    const std::vector<uint32_t>& addresses,
+    std::vector<std::string>&    locations
+  )
+  {
+    std::vector<std::string> files;
+    std::vector<int>         lnos;
+
+    std::call_once( sourceLinesLoaded, &ExecutableInfo::loadSourceLines, this );
+    mapper.getSources( addresses, files, lnos );
+
+    locations.resize( addresses.size() );
+    for ( size_t a = 0; a < addresses.size(); ++a ) {
+      locations[ a ] = files[ a ] + ':' + std::to_string( lnos[ a ] );
+    }
   }
 
   bool ExecutableInfo::hasDynamicLibrary()
@@ -228,6 +340,13 @@ namespace Coverage {
     }
   }
 
+  void ExecutableInfo::clearCoverage()
+  {
+    for ( auto& cm : coverageMaps ) {
+      cm.second->clearCoverage();
+    }
+  }
+
   void ExecutableInfo::setLoadAddress( uint32_t address )
   {
     loadAddress = address;
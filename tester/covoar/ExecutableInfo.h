@@ -8,8 +8,10 @@
 #define __EXECUTABLEINFO_H__
 
 #include <map>
+#include <mutex>
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include <rld-dwarf.h>
 #include <rld-files.h>
@@ -79,6 +81,33 @@ class DesiredSymbols;
      */
     CoverageMapBase* getCoverageMap( uint32_t address );
 
+    /*!
+     *  This method returns a pointer to the executable's coverage map
+     *  that contains the specified address and the bounds of the symbol
+     *  range the address was found in. Readers can use the bounds to
+     *  reuse the map for following addresses without another lookup.
+     *
+     *  @param[in] address specifies the desired address
+     *  @param[out] low is set to the low address of the symbol's range
+     *  @param[out] high is set to the high address of the symbol's range
+     *
+     *  @return Returns a pointer to the coverage map
+     */
+    CoverageMapBase* getCoverageMap(
+      uint32_t  address,
+      uint32_t& low,
+      uint32_t& high
+    );
+
+    /*!
+     *  This method builds the index used to find the coverage map that
+     *  contains an address. The index is a flat array of the symbol
+     *  table's ranges sorted by address. Call it once the symbol table
+     *  has been loaded from the object dump and before any address is
+     *  looked up.
+     */
+    void indexCoverageMaps();
+
     /*!
      *  This method returns the file name of the executable.
      *
@@ -116,6 +145,18 @@ class DesiredSymbols;
      */
     CoverageMapBase& findCoverageMap( const std::string& symbolName );
 
+    /*!
+     *  This method returns the coverage map for the specified symbol if
+     *  the executable has one.
+     *
+     *  @param[in] symbolName specifies the name of the symbol
+     *
+     *  @return Returns a pointer to the coverage map or NULL
+     */
+    const CoverageMapBase* getCoverageMap(
+      const std::string& symbolName
+    ) const;
+
     /*!
      *  This method gets the source location, the file and line number given an
      *  address.
@@ -125,6 +166,15 @@ class DesiredSymbols;
       std::string&       location
     );
 
+    /*!
+     *  This method gets the source locations given a list of addresses.
+     *  The lookup is a single pass when the addresses are sorted.
+     */
+    void getSourceAndLines(
+      const std::vector<uint32_t>& addresses,
+      std::vector<std::string>&    locations
+    );
+
     /*!
      *  This method indicates whether a dynamic library has been
      *  associated with the executable.
@@ -139,6 +189,12 @@ class DesiredSymbols;
      */
     void mergeCoverage();
 
+    /*!
+     *  This method clears the coverage of the executable's coverage maps,
+     *  for example once it is merged into the unified coverage maps.
+     */
+    void clearCoverage();
+
     /*!
      *  This method sets the load address of the dynamic library
      *
@@ -175,10 +231,22 @@ class DesiredSymbols;
     rld::symbols::table symbols;
 
     /*!
-     *  The address-to-line mapper for this executable.
+     *  This method loads the line tables of the executable's debug
+     *  information into the address-to-line mapper.
+     */
+    void loadSourceLines();
+
+    /*!
+     *  The address-to-line mapper for this executable. It is loaded when
+     *  a source line is first looked up.
      */
     AddressToLineMapper mapper;
 
+    /*!
+     *  This member variable loads the address-to-line mapper once.
+     */
+    std::once_flag sourceLinesLoaded;
+
     /*!
      *  This map associates a symbol with its coverage map.
      */
@@ -203,6 +271,28 @@ class DesiredSymbols;
      */
     SymbolTable theSymbolTable;
 
+    /*!
+     *  This structure defines an entry of the coverage map index.
+     */
+    typedef struct {
+      uint32_t         low;
+      uint32_t         high;
+      CoverageMapBase* map;
+    } coverageMapRange_t;
+
+    /*!
+     *  This member variable contains the coverage map index ordered by
+     *  address. The ranges do not overlap.
+     */
+    std::vector<coverageMapRange_t> coverageMapIndex;
+
+    /*!
+     *  This member variable contains the entry of the coverage map index
+     *  found by the last address lookup. Trace addresses are mostly
+     *  local so it is checked before searching the index.
+     */
+    size_t lastCoverageMapRange;
+
     /*!
      * This member variable contains the symbols to be analyzed.
      */
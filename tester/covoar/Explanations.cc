@@ -10,10 +10,12 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
 
 #include <rld.h>
 
+#include "CoverageReaderBase.h"
 #include "Explanations.h"
 
 namespace Coverage {
@@ -26,30 +28,55 @@ namespace Coverage {
   {
   }
 
+  /*
+   * Get the next line of the file. The line does not include the new line.
+   */
+  static bool nextLine(
+    const char*& cursor,
+    const char*  end,
+    std::string& line
+  )
+  {
+    if ( cursor >= end ) {
+      return false;
+    }
+
+    const char* lineEnd =
+      static_cast<const char*>( ::memchr( cursor, '\n', end - cursor ) );
+    if ( lineEnd == nullptr ) {
+      lineEnd = end;
+    }
+
+    line.assign( cursor, lineEnd - cursor );
+    cursor = lineEnd < end ? lineEnd + 1 : end;
+
+    return true;
+  }
+
   void Explanations::load( const std::string& explanations )
   {
-    std::ifstream explain;
-    Explanation   e;
-    int           line = 1;
+    int line = 1;
 
     if ( explanations.empty() ) {
       return;
     }
 
-    explain.open( explanations );
-    if ( !explain ) {
-      std::ostringstream what;
-      what << "Unable to open " << explanations;
-      throw rld::error( what, "Explanations::load" );
-    }
+    CoverageFile explain( explanations, "Explanations::load" );
+
+    explain.wait( explain.size() );
+
+    const char* cursor = reinterpret_cast<const char*>( explain.data() );
+    const char* end = cursor + explain.size();
 
     std::string input_line;
     while ( 1 ) {
+      Explanation e;
+
       // Read the starting line of this explanation and
       // skip blank lines between
       do {
-        std::getline( explain, input_line );
-        if ( explain.fail() ) {
+        if ( !nextLine( cursor, end, input_line ) ) {
+          found.assign( ( set.size() + 63 ) / 64, 0 );
           return;
         }
 
@@ -57,67 +84,71 @@ namespace Coverage {
       } while ( input_line.empty() );
 
       // Have we already seen this one?
-      if ( set.find( input_line ) != set.end() ) {
+      if ( index.find( input_line ) != index.end() ) {
         std::ostringstream what;
         what << "line " << line
-             << "contains a duplicate explanation ("
+             << " contains a duplicate explanation ("
              << input_line << ")";
         throw rld::error( what, "Explanations::load" );
       }
 
       // Add the starting line and file
       e.startingPoint = input_line;
-      e.found = false;
 
       // Get the classification
-      std::getline( explain, input_line );
-      if ( explain.fail() ) {
+      if ( !nextLine( cursor, end, input_line ) ) {
         std::ostringstream what;
         what << "line " << line
-             << "out of sync at the classification";
+             << " out of sync at the classification";
         throw rld::error( what, "Explanations::load" );
       }
       e.classification = input_line;
       line++;
 
       // Get the explanation
-      while ( std::getline( explain, input_line ) ) {
+      bool delimited = false;
+      while ( nextLine( cursor, end, input_line ) ) {
         line++;
 
-        const std::string delimiter = "+++";
-        if ( input_line.compare( delimiter ) == 0 ) {
+        if ( input_line == "+++" ) {
+          delimited = true;
           break;
         }
-        // XXX only taking last line.  Needs to be a vector
         e.explanation.push_back( input_line );
       }
 
-      if ( explain.fail() ) {
+      if ( !delimited ) {
         std::ostringstream what;
         what << "line " << line
-              << "out of sync at the explanation";
+              << " out of sync at the explanation";
         throw rld::error( what, "Explanations::load" );
       }
 
       // Add this to the set of Explanations
-      set[ e.startingPoint ] = e;
+      index.emplace( e.startingPoint, set.size() );
+      set.push_back( std::move( e ) );
     }
-
   }
 
   const Explanation *Explanations::lookupExplanation(
     const std::string& start
   )
   {
-    if ( set.find( start ) == set.end() ) {
+    auto itr = index.find( start );
+
+    if ( itr == index.end() ) {
       #if 0
         std::cerr << "Warning: Unable to find explanation for "
                   << start << std::endl;
       #endif
       return NULL;
     }
-    set[ start ].found = true;
-    return &set[ start ];
+
+    size_t e = itr->second;
+
+    std::lock_guard<std::mutex> guard( lookupMutex );
+    found[ e / 64 ] |= 1ULL << ( e % 64 );
+    return &set[ e ];
   }
 
   void Explanations::writeNotFound( const std::string& fileName )
@@ -137,20 +168,26 @@ namespace Coverage {
       throw rld::error( what, "Explanations::writeNotFound" );
     }
 
-    for (
-      std::map<std::string, Explanation>::iterator itr = set.begin();
-      itr != set.end();
-      itr++
-    ) {
-      Explanation e = (*itr).second;
-      std::string key = (*itr).first;
-
-      if ( !e.found ) {
-        notFoundOccurred = true;
-        notFoundFile << e.startingPoint << std::endl;
+    // Write the explanations not found sorted by their starting point.
+    std::vector<const std::string*> notFound;
+
+    for ( size_t e = 0; e < set.size(); ++e ) {
+      if ( ( found[ e / 64 ] & ( 1ULL << ( e % 64 ) ) ) == 0 ) {
+        notFound.push_back( &set[ e ].startingPoint );
       }
     }
 
+    std::sort(
+      notFound.begin(),
+      notFound.end(),
+      []( const std::string* a, const std::string* b ) { return *a < *b; }
+    );
+
+    for ( const auto start : notFound ) {
+      notFoundOccurred = true;
+      notFoundFile << *start << '\n';
+    }
+
     if ( !notFoundOccurred ) {
       if ( !unlink( fileName.c_str() ) ) {
         std::cerr << "Warning: Unable to unlink " << fileName
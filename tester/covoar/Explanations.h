@@ -7,9 +7,10 @@
 #ifndef __EXPLANATIONS_H__
 #define __EXPLANATIONS_H__
 
-#include <map>
+#include <mutex>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Coverage {
@@ -40,16 +41,10 @@ namespace Coverage {
      */
     std::vector<std::string> explanation;
 
-    /*!
-     *  This member variable indicates whether this explanation was
-     *  used during analysis.
-     */
-    bool found;
-
     /*!
      *  This method constructs an Explanation instance.
      */
-    Explanation() { found = false; }
+    Explanation() {}
 
     /*!
      *  This method destructs an Explanation instance.
@@ -66,9 +61,10 @@ namespace Coverage {
   public:
 
     /*!
-     *  This member variable contains a list of Explanation instances.
+     *  This member variable contains the Explanation instances in the
+     *  order of the explanations file.
      */
-    std::map<std::string, Explanation> set;
+    std::vector<Explanation> set;
 
     /*!
      *  This method constructs an Explanations instance.
@@ -82,7 +78,7 @@ namespace Coverage {
 
     /*!
      *  This methods loads the explanation information from the
-     *  specified file.
+     *  specified file. The file is parsed in place in a single pass.
      *
      *  @param[in] explanations specifies the file name containing
      *             the explanation information
@@ -91,7 +87,8 @@ namespace Coverage {
 
     /*!
      *  This method returns the explanation associated with the
-     *  specified starting line number.
+     *  specified starting line number.  It may be called by
+     *  several threads at the same time.
      *
      *  @param[in] start specifies the starting line number for
      *             which to search
@@ -106,6 +103,25 @@ namespace Coverage {
      */
     void writeNotFound( const std::string& fileName );
 
+  private:
+
+    /*!
+     *  This member variable indexes the explanations by their starting
+     *  point.
+     */
+    std::unordered_map<std::string, size_t> index;
+
+    /*!
+     *  This member variable is a bitmap with a bit set for each
+     *  explanation that was looked up.
+     */
+    std::vector<uint64_t> found;
+
+    /*!
+     *  This member variable protects the found bitmap.
+     */
+    std::mutex lookupMutex;
+
   };
 
 }
@@ -8,10 +8,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+
+#include <sstream>
 //#include <sys/stat.h>
 
 //#include "app_common.h"
 #include "GcovData.h"
+#include "CoverageReaderBase.h"
 //#include "ExecutableInfo.h"
 //#include "CoverageMap.h"
 //#include "qemu-traces.h"
@@ -20,6 +23,41 @@
 
 namespace Gcov {
 
+  /*
+   * Takes up to length bytes from the notes file. Returns the number of
+   * bytes taken, a short count means the end of the file was reached.
+   */
+  static size_t readBytes(
+    gcov_cursor& gcovFile,
+    size_t       length,
+    const char*& bytes
+  )
+  {
+    size_t available = gcovFile.size - gcovFile.offset;
+
+    if ( length > available ) {
+      length = available;
+    }
+
+    bytes = gcovFile.data + gcovFile.offset;
+    gcovFile.offset += length;
+
+    return length;
+  }
+
+  /*
+   * Appends the bytes of an object to the data file image.
+   */
+  static void writeBytes(
+    std::vector<char>& gcdaImage,
+    const void*        bytes,
+    size_t             length
+  )
+  {
+    const char* b = static_cast<const char*>( bytes );
+    gcdaImage.insert( gcdaImage.end(), b, b + length );
+  }
+
   GcovData::GcovData( Coverage::DesiredSymbols& symbolsToAnalyze ):
     numberOfFunctions( 0 ),
     gcnoPreamble(),
@@ -34,7 +72,7 @@ namespace Gcov {
   bool GcovData::readGcnoFile( const std::string& fileName )
   {
     int           status;
-    std::ifstream gcovFile;
+    gcov_cursor   gcovFile;
     std::string   tempString;
     std::string   tempString2;
     std::string   tempString3;
@@ -72,23 +110,31 @@ namespace Gcov {
     // Debug message
     // std::cerr << "Reading file: " << gcnoFileName << std::endl;
 
-    // Open the notes file.
-    gcovFile.open( gcnoFileName );
-    if ( !gcovFile ) {
-      std::cerr << "Unable to open " << gcnoFileName << std::endl;
-      return false;
-    }
+    // Map the notes file.
+    try {
+      Coverage::CoverageFile notes( gcnoFileName, "GcovData::readGcnoFile" );
 
-    // Read and validate the gcnoPreamble (magic, version, timestamp) from the file
-    status = readFilePreamble( &gcnoPreamble, gcovFile, GCNO_MAGIC );
-    if ( status <= 0 ) {
-      std::cerr << "Unable to read " << gcnoFileName << std::endl;
+      notes.wait( notes.size() );
+
+      gcovFile.data   = reinterpret_cast<const char*>( notes.data() );
+      gcovFile.size   = notes.size();
+      gcovFile.offset = 0;
+
+      // Read and validate the gcnoPreamble (magic, version, timestamp) from
+      // the file
+      status = readFilePreamble( &gcnoPreamble, gcovFile, GCNO_MAGIC );
+      if ( status <= 0 ) {
+        std::cerr << "Unable to read " << gcnoFileName << std::endl;
+        return false;
+      }
+
+      //Read all remaining frames from file
+      while( readFrame( gcovFile ) ) {}
+    } catch ( rld::error& err ) {
+      std::cerr << "Unable to open " << gcnoFileName << std::endl;
       return false;
     }
 
-    //Read all remaining frames from file
-    while( readFrame( gcovFile ) ) {}
-
     return true;
   }
 
@@ -98,8 +144,8 @@ namespace Gcov {
     gcov_preamble           preamble;
     gcov_frame_header       header;
     std::ofstream           gcdaFile;
+    std::vector<char>       gcdaImage;
     functions_iterator_t    currentFunction;
-    arcs_iterator_t         currentArc;
     uint32_t                buffer;
     uint32_t                countersFound;
     uint32_t                countersFoundSum;
@@ -108,7 +154,6 @@ namespace Gcov {
     uint64_t                llBuffer[4096];    // TODO: Use common buffer
     gcov_statistics         objectStats;
     gcov_statistics         programStats;
-    std::ofstream::pos_type bytes_before;
 
     // Debug message
     //std::cerr << "Writing file: " <<  gcdaFileName << std::endl;
@@ -119,7 +164,7 @@ namespace Gcov {
     countersFoundSum = 0;
 
     // Open the data file.
-    gcdaFile.open( gcdaFileName );
+    gcdaFile.open( gcdaFileName, std::ios::out | std::ios::binary );
     if ( !gcdaFile ) {
       std::cerr << "Unable to create " << gcdaFileName << std::endl;
       return false;
@@ -131,11 +176,7 @@ namespace Gcov {
     preamble.timestamp = gcnoPreamble.timestamp;
 
     //Write preamble
-    gcdaFile.write( (char *) &preamble , sizeof( preamble ) );
-    if ( gcdaFile.fail() ) {
-      std::cerr << "Error while writing gcda preamble to a file "
-                << gcdaFileName << std::endl;
-    }
+    writeBytes( gcdaImage, &preamble, sizeof( preamble ) );
 
     //Write function info and counter counts
     for (
@@ -146,27 +187,15 @@ namespace Gcov {
       //Write function announcement frame header (length always equals 2)
       header.tag = GCOV_TAG_FUNCTION;
       header.length = 2;
-      gcdaFile.write( (char *) &header, sizeof( header ) );
-      if ( gcdaFile.fail() ) {
-        std::cerr << "Error while writing function announcement to a file "
-                  << gcdaFileName << std::endl;
-      }
+      writeBytes( gcdaImage, &header, sizeof( header ) );
 
       //Write function id
       buffer = (*currentFunction).getId();
-      gcdaFile.write( (char *) &buffer, sizeof( buffer ) );
-      if ( gcdaFile.fail() ) {
-        std::cerr << "Error while writing function id to a file "
-                  << gcdaFileName << std::endl;
-      }
+      writeBytes( gcdaImage, &buffer, sizeof( buffer ) );
 
       //Write function checksum
       buffer = (*currentFunction).getChecksum();
-      gcdaFile.write( (char *) &buffer, sizeof( buffer ) );
-      if ( gcdaFile.fail() ) {
-        std::cerr << "Error while writing function checksum to a file "
-                  << gcdaFileName << std::endl;
-      }
+      writeBytes( gcdaImage, &buffer, sizeof( buffer ) );
 
       // Determine how many counters there are
       // and store their counts in buffer
@@ -182,19 +211,8 @@ namespace Gcov {
       //Write info about counters
       header.tag = GCOV_TAG_COUNTER;
       header.length = countersFound * 2;
-      gcdaFile.write( (char *) &header, sizeof( header ) );
-      if ( gcdaFile.fail() ) {
-        std::cerr << "Error while writing counter header to a file "
-                  << gcdaFileName << std::endl;
-      }
-
-      bytes_before = gcdaFile.tellp();
-
-      gcdaFile.write( (char *) llBuffer, sizeof( uint64_t ) * countersFound );
-      if ( gcdaFile.tellp() - bytes_before != countersFound ) {
-        std::cerr << "Error while writing counter data to a file "
-                  << gcdaFileName << std::endl;
-      }
+      writeBytes( gcdaImage, &header, sizeof( header ) );
+      writeBytes( gcdaImage, llBuffer, sizeof( uint64_t ) * countersFound );
     }
 
     // Prepare frame with object file statistics
@@ -208,18 +226,8 @@ namespace Gcov {
     objectStats.sumMax = countersMax;    // we have no clue
 
     // Write data
-    gcdaFile.write( (char *) &header, sizeof( header ) );
-    if ( gcdaFile.fail() ) {
-      std::cerr << "Error while writing stats header to a file "
-                << gcdaFileName << std::endl;
-    }
-
-    gcdaFile.write( (char *) &objectStats, sizeof( objectStats ) );
-    if ( gcdaFile.fail() ) {
-      std::cerr << "Error while writing object stats to a file "
-                << gcdaFileName << std::endl;
-    }
-
+    writeBytes( gcdaImage, &header, sizeof( header ) );
+    writeBytes( gcdaImage, &objectStats, sizeof( objectStats ) );
 
     // Prepare frame with program statistics
     header.tag = GCOV_TAG_PROGRAM_SUMMARY;
@@ -232,26 +240,25 @@ namespace Gcov {
     programStats.sumMax = countersMax;    // we have no clue
 
     // Write data
-    gcdaFile.write( (char *) &header, sizeof( header ) );
-    if ( gcdaFile.fail() ) {
-      std::cerr << "Error while writing stats header to a file "
-                << gcdaFileName << std::endl;
-    }
+    writeBytes( gcdaImage, &header, sizeof( header ) );
+    writeBytes( gcdaImage, &programStats, sizeof( programStats ) );
 
-    gcdaFile.write( (char *) &programStats, sizeof( programStats ) );
+    gcdaFile.write( gcdaImage.data(), gcdaImage.size() );
+    gcdaFile.close();
     if ( gcdaFile.fail() ) {
-      std::cerr << "Error while writing program stats to a file "
+      std::cerr << "Error while writing to a file "
                 << gcdaFileName << std::endl;
+      return false;
     }
 
     return true;
   }
 
-  bool GcovData::readFrame( std::ifstream& gcovFile )
+  bool GcovData::readFrame( gcov_cursor& gcovFile )
   {
     gcov_frame_header header;
-    char              buffer[512];
-    char              intBuffer[16384];
+    std::string       buffer;
+    const char*       intBuffer;
     uint32_t          tempBlockId;
     blocks_iterator_t tempBlockIterator;
     int               status;
@@ -277,21 +284,23 @@ namespace Gcov {
             return false;
           }
 
-          functions.push_back( newFunction );
+          functions.push_back( std::move( newFunction ) );
         }
 
         break;
 
       case GCOV_TAG_BLOCKS:
 
-        gcovFile.read( intBuffer, header.length );
-        if ( gcovFile.gcount() != (int) header.length ) {
-          std::cerr << "Error while reading BLOCKS from gcov file..."
-                    << std::endl
-                    << "Header length is " << header.length
-                    << " instead of " << gcovFile.gcount()
-                    << std::endl;
-          return false;
+        {
+          size_t got = readBytes( gcovFile, header.length, intBuffer );
+          if ( got != header.length ) {
+            std::cerr << "Error while reading BLOCKS from gcov file..."
+                      << std::endl
+                      << "Header length is " << header.length
+                      << " instead of " << got
+                      << std::endl;
+            return false;
+          }
         }
 
         for( uint32_t i = 0; i < header.length; i++ ) {
@@ -302,8 +311,7 @@ namespace Gcov {
 
       case GCOV_TAG_ARCS:
 
-        gcovFile.read( intBuffer, header.length );
-        if ( gcovFile.gcount() != (int) header.length ) {
+        if ( readBytes( gcovFile, header.length, intBuffer ) != header.length ) {
           return false;
         }
 
@@ -315,8 +323,7 @@ namespace Gcov {
 
       case GCOV_TAG_LINES:
 
-        gcovFile.read( intBuffer, 2 );
-        if ( gcovFile.gcount() != 2 || intBuffer[1] != 0 ) {
+        if ( readBytes( gcovFile, 2, intBuffer ) != 2 || intBuffer[1] != 0 ) {
           std::cerr << "Error while reading block id for LINES from gcov "
                     << "file..." << std::endl;
           return false;
@@ -325,13 +332,14 @@ namespace Gcov {
         header.length -= 2;
 
         // Find the right block
-        tempBlockIterator =functions.back().findBlockById( tempBlockId );
+        if ( !functions.back().findBlockById( tempBlockId, tempBlockIterator ) ) {
+          return false;
+        }
 
         header.length -= readString( buffer, gcovFile );
         functions.back().setBlockFileName( tempBlockIterator, buffer );
 
-        gcovFile.read( intBuffer, header.length );
-        if ( gcovFile.gcount() != (int) header.length ) {
+        if ( readBytes( gcovFile, header.length, intBuffer ) != header.length ) {
           std::cerr << "Error while reading LINES from gcov file..."
                     << std::endl;
           return false;
@@ -345,76 +353,99 @@ namespace Gcov {
 
       default:
 
-        std::cerr << std::endl << std::endl
-                  << "ERROR - encountered unknown *.gcno tag : 0x"
-                  << std::hex << header.tag << std::dec << std::endl;
+        {
+          // Do not change the formatting of std::cerr, the notes files
+          // are read in parallel.
+          std::ostringstream what;
+          what << std::endl << std::endl
+               << "ERROR - encountered unknown *.gcno tag : 0x"
+               << std::hex << header.tag << std::endl;
+          std::cerr << what.str();
+        }
         break;
       }
 
       return true;
   }
 
-  int GcovData::readString( char* buffer, std::ifstream& gcovFile )
+  int GcovData::readString( std::string& buffer, gcov_cursor& gcovFile )
   {
-    int length;
+    const char* bytes;
+    int         length;
 
-    gcovFile.read( (char *) &length, sizeof( int ) );
-    if ( gcovFile.gcount() != sizeof( int ) ) {
+    if ( readBytes( gcovFile, sizeof( int ), bytes ) != sizeof( int ) ) {
       std::cerr << "ERROR: Unable to read string length from gcov file"
                 << std::endl;
       return -1;
     }
 
-    gcovFile.read( buffer, length * 4 );
-    if ( gcovFile.gcount() != length * 4 ) {
+    ::memcpy( &length, bytes, sizeof( int ) );
+
+    if (
+      length < 0 ||
+      readBytes( gcovFile, length * 4, bytes ) != (size_t) length * 4
+    ) {
       std::cerr << "ERROR: Unable to read string from gcov file"
                 << std::endl;
       return -1;
     }
 
-    buffer[length * 4] = '\0';
+    // The string is padded with nuls to a whole number of words.
+    buffer.assign( bytes, ::strnlen( bytes, length * 4 ) );
 
     return length +1;
   }
 
   int GcovData::readFrameHeader(
     gcov_frame_header* header,
-    std::ifstream&     gcovFile
+    gcov_cursor&       gcovFile
   )
   {
-    int length;
+    const char* bytes;
+    size_t      length;
+
+    length = readBytes( gcovFile, sizeof( gcov_frame_header ), bytes );
+    if ( length == 0 ) {
+      return 0;
+    }
 
-    length = sizeof( gcov_frame_header );
-    gcovFile.read( (char *) header, length );
-    if ( gcovFile.gcount() != length ) {
+    if ( length != sizeof( gcov_frame_header ) ) {
       std::cerr << "ERROR: Unable to read frame header from gcov file"
                 << std::endl;
       return -1;
     }
 
-      return length / 4;
+    ::memcpy( header, bytes, length );
+
+    return length / 4;
   }
 
   int GcovData::readFilePreamble(
      gcov_preamble* preamble,
-     std::ifstream& gcovFile,
+     gcov_cursor&   gcovFile,
      uint32_t       desiredMagic
   )
   {
-    rtems::utils::ostream_guard old_state( std::cerr );
+    const char* bytes;
 
     // Read the gcov preamble and make sure it is the right length and has the
     // magic number
-    gcovFile.read( (char *) preamble, sizeof( gcov_preamble ) );
-    if ( gcovFile.gcount() != sizeof( gcov_preamble ) ) {
+    if (
+      readBytes( gcovFile, sizeof( gcov_preamble ), bytes ) !=
+        sizeof( gcov_preamble )
+    ) {
       std::cerr << "Error while reading file preamble" << std::endl;
       return -1;
     }
 
+    ::memcpy( preamble, bytes, sizeof( gcov_preamble ) );
+
     if ( preamble->magic != GCNO_MAGIC ) {
-      std::cerr << "File is not a valid *.gcno output (magic: 0x"
-                << std::hex << std::setw( 4 ) << preamble->magic
-                << ")" << std::endl;
+      std::ostringstream what;
+      what << "File is not a valid *.gcno output (magic: 0x"
+           << std::hex << std::setw( 4 ) << preamble->magic
+           << ")" << std::endl;
+      std::cerr << what.str();
       return -1;
     }
 
@@ -423,15 +454,14 @@ namespace Gcov {
 
   bool GcovData::readFunctionFrame(
     gcov_frame_header header,
-    std::ifstream&    gcovFile,
+    gcov_cursor&      gcovFile,
     GcovFunctionData* function
   )
   {
-    char buffer[512];
-    char intBuffer[16384];
+    std::string buffer;
+    const char* intBuffer;
 
-    gcovFile.read( (char *) intBuffer, 8 );
-    if ( gcovFile.gcount() != 8 ) {
+    if ( readBytes( gcovFile, 8, intBuffer ) != 8 ) {
       std::cerr << "ERROR: Unable to read Function ID & checksum" << std::endl;
       return false;
     }
@@ -444,8 +474,8 @@ namespace Gcov {
     function->setFunctionName( buffer, symbolsToAnalyze_m );
     header.length -= readString( buffer, gcovFile );
     function->setFileName( buffer );
-    gcovFile.read( (char*) intBuffer, 4 * header.length );
-    if (gcovFile.gcount() != 4 * header.length ) {
+    if ( readBytes( gcovFile, 4 * header.length, intBuffer ) !=
+         4 * header.length ) {
       std::cerr << "ERROR: Unable to read Function starting line number"
                 << std::endl;
       return false;
@@ -49,6 +49,17 @@ struct gcov_frame_header
   uint32_t length;
 };
 
+/*
+ * The read position in the contents of a notes file. The frames are
+ * decoded in place from the contents.
+ */
+struct gcov_cursor
+{
+  const char* data;
+  size_t      size;
+  size_t      offset;
+};
+
 struct gcov_statistics
 {
   uint32_t checksum;          // checksum
@@ -82,7 +93,8 @@ class DesiredSymbols;
     virtual ~GcovData();
 
     /*!
-     *  This method reads the *.gcno file
+     *  This method reads the *.gcno file. The file is mapped or read
+     *  into memory and the frames are decoded in place.
      *
      *  @param[in] fileName name of the file to read
      *
@@ -92,7 +104,8 @@ class DesiredSymbols;
 
     /*!
      *  This method writes the *.gcda file. It also produces and stores
-     *  gcda and txt file names for future outputs.
+     *  gcda and txt file names for future outputs. The file is formed
+     *  in memory and written with a single write.
      *
      *  @return Returns TRUE if the method succeeded and FALSE if it failed.
      */
@@ -130,39 +143,39 @@ class DesiredSymbols;
     /*!
      *  This method reads a frame from *.gcno file
      *
-     *  @param[in] file points to a file to read
+     *  @param[in] gcovFile is the read position in the file
      *
      *  @return true if read was succesfull, false otherwise
      */
-    bool readFrame( std::ifstream& gcovFile );
+    bool readFrame( gcov_cursor& gcovFile );
 
     /*!
      *  This method reads a string from gcov file
      *
      *  @param[in] buffer stores the string
-     *  @param[in] file specifies the name of the file to read
+     *  @param[in] gcovFile is the read position in the file
      *
      *  @return Returns length of words read (word = 32bit) or -1 if error
      *  ocurred
      */
-    int readString( char* buffer, std::ifstream& gcovFile );
+    int readString( std::string& buffer, gcov_cursor& gcovFile );
 
     /*!
      *  This method reads a frame header from gcov file
      *
      *  @param[in] header stores the header
-     *  @param[in] file specifies the name of the file to read
+     *  @param[in] gcovFile is the read position in the file
      *
-     *  @return Returns length of words read (word = 32bit)
-     *  or -1 if error ocurred
+     *  @return Returns length of words read (word = 32bit), 0 at the end
+     *  of the file or -1 if error ocurred
      */
-    int readFrameHeader( gcov_frame_header* header, std::ifstream& gcovFile );
+    int readFrameHeader( gcov_frame_header* header, gcov_cursor& gcovFile );
 
     /*!
      *  This method reads a frame header from gcov file
      *
      *  @param[in] preamble stores the preamble
-     *  @param[in] gcovFile specifies the name of the file to read
+     *  @param[in] gcovFile is the read position in the file
      *  @param[in] desiredMagic stores the expected magic of a file
      *
      *  @return Returns length of words read (word = 32bit)
@@ -170,7 +183,7 @@ class DesiredSymbols;
      */
     int readFilePreamble(
       gcov_preamble* preamble,
-      std::ifstream& gcovFile,
+      gcov_cursor&   gcovFile,
       const uint32_t desiredMagic
     );
 
@@ -178,14 +191,14 @@ class DesiredSymbols;
      *  This method reads a function frame from gcov file
      *
      *  @param[in] header passes frame header
-     *  @param[in] gcovFile specifies the name of the file to read
+     *  @param[in] gcovFile is the read position in the file
      *  @param[in] function stores the expected magic of a file
      *
      *  @return Returns true if operation was succesfull
      */
     bool readFunctionFrame(
       gcov_frame_header header,
-      std::ifstream&    gcovFile,
+      gcov_cursor&      gcovFile,
       GcovFunctionData* function
     );
 
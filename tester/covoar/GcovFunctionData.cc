@@ -8,6 +8,7 @@
 #include <cstdio>
 #include <cstring>
 #include <cinttypes>
+#include <sstream>
 
 #include "GcovFunctionData.h"
 #include "ObjdumpProcessor.h"
@@ -228,7 +229,7 @@ namespace Gcov {
     uint32_t baseAddress = 0;
     uint32_t baseSize;
     uint32_t currentAddress;
-    std::list<Coverage::objdumpLine_t>::iterator instruction;
+    std::vector<Coverage::objdumpLine_t>::iterator instruction;
 
     if ( coverageMap != NULL ) {
 
@@ -305,25 +306,30 @@ namespace Gcov {
     (block->numberOfLines)++;
   }
 
-  blocks_iterator_t GcovFunctionData::findBlockById( const uint32_t id )
+  bool GcovFunctionData::findBlockById(
+    const uint32_t     id,
+    blocks_iterator_t& block
+  )
   {
-    blocks_iterator_t blockIterator;
+    if ( blocks.empty() ) {
+      std::cerr << "ERROR: GcovFunctionData::findBlockById() failed"
+                << ", no blocks present" << std::endl;
+      return false;
+    }
 
-    if ( !blocks.empty() ) {
-      blockIterator = blocks.begin();
-      while ( blockIterator != blocks.end() ) {
-        if ( blockIterator->id == id) {
-          break;
-        }
+    // The notes file numbers the blocks by their position.
+    if ( id < blocks.size() && blocks[ id ].id == id ) {
+      block = blocks.begin() + id;
+      return true;
+    }
 
-        blockIterator++;
+    for ( block = blocks.begin(); block != blocks.end(); block++ ) {
+      if ( block->id == id ) {
+        return true;
       }
-    } else {
-      std::cerr << "ERROR: GcovFunctionData::findBlockById() failed"
-                << ", no blocks present" << std::endl;
     }
 
-    return blockIterator;
+    return false;
   }
 
   void GcovFunctionData::printArcInfo(
@@ -355,10 +361,13 @@ namespace Gcov {
         textFile << "( FALLTHROUGH ____ ON_TREE )";
         break;
       default:
-        textFile  << "( =======FLAGS_ERROR====== )";
-        std::cerr << " ERROR: Unknown arc flag: 0x"
-                  << std::hex << arcs.back().flags << std::endl
-                  << std::dec;
+        {
+          std::ostringstream what;
+          what << " ERROR: Unknown arc flag: 0x"
+               << std::hex << arcs.back().flags << std::endl;
+          textFile  << "( =======FLAGS_ERROR====== )";
+          std::cerr << what.str();
+        }
         break;
     }
 
@@ -370,7 +379,7 @@ namespace Gcov {
     blocks_iterator_t block
   )
   {
-    std::list<uint32_t>::iterator line;
+    std::vector<uint32_t>::iterator line;
 
     rtems::utils::ostream_guard old_state( textFile );
 
@@ -389,17 +398,59 @@ namespace Gcov {
     textFile << std::endl;
   }
 
+  bool GcovFunctionData::buildGraph()
+  {
+    const uint32_t noBlock = UINT32_MAX;
+    uint32_t       maxId = 0;
+
+    for ( const auto& block : blocks ) {
+      if ( block.id > maxId ) {
+        maxId = block.id;
+      }
+    }
+
+    blockPosition.assign( maxId + 1, noBlock );
+    for ( uint32_t b = 0; b < blocks.size(); b++ ) {
+      if ( blockPosition[ blocks[ b ].id ] == noBlock ) {
+        blockPosition[ blocks[ b ].id ] = b;
+      }
+    }
+
+    // Count the arcs leaving each block then place them in file order.
+    arcStart.assign( blocks.size() + 1, 0 );
+    for ( const auto& arc : arcs ) {
+      if (
+        arc.sourceBlock > maxId ||
+        arc.destinationBlock > maxId ||
+        blockPosition[ arc.sourceBlock ] == noBlock ||
+        blockPosition[ arc.destinationBlock ] == noBlock
+      ) {
+        return false;
+      }
+      arcStart[ blockPosition[ arc.sourceBlock ] + 1 ]++;
+    }
+
+    for ( uint32_t b = 0; b < blocks.size(); b++ ) {
+      arcStart[ b + 1 ] += arcStart[ b ];
+    }
+
+    std::vector<uint32_t> next( arcStart.begin(), arcStart.end() - 1 );
+
+    arcIndex.resize( arcs.size() );
+    for ( uint32_t a = 0; a < arcs.size(); a++ ) {
+      arcIndex[ next[ blockPosition[ arcs[ a ].sourceBlock ] ]++ ] = a;
+    }
+
+    return true;
+  }
+
   bool GcovFunctionData::processFunctionCounters() {
 
-    uint32_t            baseAddress = 0;
-    uint32_t            currentAddress = 0;
-    blocks_iterator_t   blockIterator;
-    blocks_iterator_t   blockIterator2;
-    arcs_iterator_t     arcIterator;
-    arcs_iterator_t     arcIterator2;
-    std::list<uint64_t> taken;       // List of taken counts for branches
-    std::list<uint64_t> notTaken;    // List of not taken counts for branches
-    std::list<Coverage::objdumpLine_t>::iterator instruction;
+    uint32_t              baseAddress = 0;
+    std::vector<uint64_t> taken;       // Taken counts for branches
+    std::vector<uint64_t> notTaken;    // Not taken counts for branches
+    size_t                branch = 0;  // Next taken/not taken counts to use
+    uint32_t              lastArc;
 
     //std::cerr << "DEBUG: Processing counters for file: " << sourceFileName
     //          << std::endl;
@@ -415,14 +466,12 @@ namespace Gcov {
       return false;
     }
 
-    // Reset iterators and variables
-    blockIterator  = blocks.begin();
-    arcIterator    = arcs.begin();
-    arcIterator2   = arcIterator;
-    arcIterator2++;
-    instruction    = symbolInfo->instructions.begin();
-    baseAddress    = coverageMap->getFirstLowAddress();      //symbolInfo->baseAddress;
-    currentAddress = baseAddress;
+    if ( !buildGraph() ) {
+      return false;
+    }
+
+    lastArc     = arcs.size() - 1;
+    baseAddress = coverageMap->getFirstLowAddress();      //symbolInfo->baseAddress;
 
     // Find taken/not taken values for branches
     if ( !processBranches( &taken , &notTaken ) )
@@ -433,160 +482,98 @@ namespace Gcov {
       return false;
     };
 
-    // Process the branching arcs
-    while ( blockIterator != blocks.end() ) {
-      //std::cerr << "DEBUG: Processing branches" << std::endl;
-      while ( arcIterator->sourceBlock != blockIterator->id ) {
-        if ( arcIterator == arcs.end() ) {
-          //std::cerr << "ERROR: Unexpectedly runned out of arcs to analyze"
-          //          << std::endl;
-          return false;
-        }
+    // Process the branching arcs. The blocks are visited once in the order
+    // of the notes file and the branch counts are used in that order.
+    for ( uint32_t b = 0; b < blocks.size(); b++ ) {
+      const uint32_t first = arcStart[ b ];
+      const uint32_t count = arcStart[ b + 1 ] - first;
 
-        arcIterator++;
-        arcIterator2++;
+      if ( count == 0 ) {
+        //std::cerr << "ERROR: Unexpectedly runned out of arcs to analyze"
+        //          << std::endl;
+        return false;
       }
 
       // If no more branches break;
-      if ( arcIterator2 == arcs.end() ) {
+      if ( arcIndex[ first ] == lastArc ) {
         break;
       }
 
+      if ( count < 2 ) {
+        continue;
+      }
+
+      gcov_arc_info& arc = arcs[ arcIndex[ first ] ];
+      gcov_arc_info& arc2 = arcs[ arcIndex[ first + 1 ] ];
+
       // If this is a branch without FAKE arcs process it
-      if (
-         ( arcIterator->sourceBlock == arcIterator2->sourceBlock ) &&
-        !( arcIterator->flags & FAKE_ARC_FLAG ) &&
-        !( arcIterator2->flags & FAKE_ARC_FLAG )
-      ) {
-        if ( taken.empty() || notTaken.empty() ) {
+      if ( !( arc.flags & FAKE_ARC_FLAG ) && !( arc2.flags & FAKE_ARC_FLAG ) ) {
+        if ( branch >= taken.size() || branch >= notTaken.size() ) {
           std::cerr << "ERROR: Branches missing for function: "
                     << functionName << " from file: " << sourceFileName
                     << std::endl;
           return false;
         }
 
-        //std::cerr << "DEBUG: Found true branching arc "
-        //          << std::setw( 3 ) << arcIterator->sourceBlock << " -> "
-        //          << std::setw( 3 ) << arcIteratior->destinationBlock
-        //          << std::endl;
-        if ( arcIterator->flags & FALLTHROUGH_ARC_FLAG ) {
-          arcIterator->counter = notTaken.front();
-          notTaken.pop_front();
-          arcIterator2->counter = taken.front();
-          taken.pop_front();
+        if ( arc.flags & FALLTHROUGH_ARC_FLAG ) {
+          arc.counter = notTaken[ branch ];
+          arc2.counter = taken[ branch ];
         } else {
-          arcIterator2->counter = notTaken.front();
-          notTaken.pop_front();
-          arcIterator->counter = taken.front();
-          taken.pop_front();
-        }
-
-        blockIterator2 = blocks.begin();
-        //TODO: ADD FAILSAFE
-        while ( arcIterator->destinationBlock != blockIterator2->id ) {
-          blockIterator2++;
+          arc2.counter = notTaken[ branch ];
+          arc.counter = taken[ branch ];
         }
 
-        blockIterator2->counter += arcIterator->counter;
+        branch++;
 
-        blockIterator2 = blocks.begin();
-        //TODO: ADD FAILSAFE
-        while ( arcIterator2->destinationBlock != blockIterator2->id ) {
-            blockIterator2++;
-        }
-
-         blockIterator2->counter += arcIterator2->counter;
+        blocks[ blockPosition[ arc.destinationBlock ] ].counter += arc.counter;
+        blocks[ blockPosition[ arc2.destinationBlock ] ].counter +=
+          arc2.counter;
       }
-
-      blockIterator++;
     }
 
-    // Reset iterators and variables
-    blockIterator = blocks.begin();
-    arcIterator   = arcs.begin();
-    arcIterator2  = arcIterator;
-    arcIterator2++;
-
     // Set the first block
-    blockIterator->counter = coverageMap->getWasExecuted( currentAddress );
+    blocks.front().counter = coverageMap->getWasExecuted( baseAddress );
 
-    // Analyze remaining arcs and blocks
-    while ( blockIterator != blocks.end() ) {
-      while ( arcIterator->sourceBlock != blockIterator->id ) {
-        if ( arcIterator == arcs.end() ) {
-          std::cerr << "ERROR: Unexpectedly runned out of arcs to analyze"
-                    << std::endl;
-          return false;
-        }
-
-        arcIterator++;
-        arcIterator2++;
-      }
+    // Propagate the block counters along the remaining arcs
+    for ( uint32_t b = 0; b < blocks.size(); b++ ) {
+      const uint32_t first = arcStart[ b ];
+      const uint32_t count = arcStart[ b + 1 ] - first;
 
-      // If this is the last arc, propagate counter and exit
-      if ( arcIterator2 == arcs.end() ) {
-        //std::cerr << "DEBUG: Found last arc " << std::setw( 3 )
-        //          << arcIterator->sourceBlock << " -> " << std::setw( 3 )
-        //          << arcIterator->destinationBlock << std::endl;
-        arcIterator->counter = blockIterator->counter;
-        blockIterator2       =  blocks.begin();
-        while ( arcIterator->destinationBlock != blockIterator2->id ) {  //TODO: ADD FAILSAFE
-          blockIterator2++;
-        }
-
-        blockIterator2->counter += arcIterator->counter;
-
-        return true;
+      if ( count == 0 ) {
+        std::cerr << "ERROR: Unexpectedly runned out of arcs to analyze"
+                  << std::endl;
+        return false;
       }
 
-      // If this is not a branch, propagate counter and continue
-      if ( arcIterator->sourceBlock != arcIterator2->sourceBlock ) {
-        //std::cerr << "DEBUG: Found simple arc " << std::setw( 3 )
-        //          << arcIterator->sourceBlock << " -> " << std::setw( 3 )
-        //          << arcIterator->destinationBlock << std::endl;
-        arcIterator->counter = blockIterator->counter;
-        blockIterator2       =  blocks.begin();
+      gcov_arc_info& arc = arcs[ arcIndex[ first ] ];
 
-        while ( arcIterator->destinationBlock != blockIterator2->id ) { //TODO: ADD FAILSAFE
-          blockIterator2++;
-        }
-
-        blockIterator2->counter += arcIterator->counter;
-      }
-
-      // If this is  a branch with FAKE arc
-      else if (
-        ( arcIterator->sourceBlock == arcIterator2->sourceBlock ) &&
-        ( arcIterator2->flags & FAKE_ARC_FLAG )
+      // If this is the last arc, propagate counter and exit. If this is not
+      // a branch or a branch with a FAKE arc, propagate counter and continue.
+      if (
+        arcIndex[ first ] == lastArc ||
+        count < 2 ||
+        ( arcs[ arcIndex[ first + 1 ] ].flags & FAKE_ARC_FLAG )
       ) {
-        //std::cerr << "DEBUG: Found fake branching arc " << std::setw( 3 )
-        //          << arcIterator->sourceBlock << " -> " << std::setw( 3 )
-        //          << arcIterator->destinationBlock << std::endl;
-        arcIterator->counter = blockIterator->counter;
-        blockIterator2       = blocks.begin();
-
-        while ( arcIterator->destinationBlock != blockIterator2->id ) { //TODO: ADD FAILSAFE
-          blockIterator2++;
-        }
-
-        blockIterator2->counter += arcIterator->counter;
+        arc.counter = blocks[ b ].counter;
+        blocks[ blockPosition[ arc.destinationBlock ] ].counter += arc.counter;
       }
 
-      // If this is a legitimate branch
-      blockIterator++;
+      if ( arcIndex[ first ] == lastArc ) {
+        return true;
+      }
     }
 
     return true;
   }
 
   bool GcovFunctionData::processBranches(
-    std::list<uint64_t>* taken ,
-    std::list<uint64_t>* notTaken
+    std::vector<uint64_t>* taken ,
+    std::vector<uint64_t>* notTaken
   )
   {
     uint32_t baseAddress = 0;
     uint32_t currentAddress;
-    std::list<Coverage::objdumpLine_t>::iterator instruction;
+    std::vector<Coverage::objdumpLine_t>::iterator instruction;
 
     if ( coverageMap == NULL ) {
       return false;
@@ -8,9 +8,9 @@
 #define __GCOV_FUNCTION_DATA_H__
 
 #include <stdint.h>
-#include <list>
 #include <fstream>
 #include <iomanip>
+#include <vector>
 #include "CoverageMapBase.h"
 #include "DesiredSymbols.h"
 
@@ -33,18 +33,18 @@ struct gcov_arc_info
 
 struct gcov_block_info
 {
-  uint32_t            id;
-  uint32_t            flags;
-  uint32_t            numberOfLines;
-  uint64_t            counter;
-  std::string         sourceFileName;
-  std::list<uint32_t> lines;
+  uint32_t              id;
+  uint32_t              flags;
+  uint32_t              numberOfLines;
+  uint64_t              counter;
+  std::string           sourceFileName;
+  std::vector<uint32_t> lines;
 };
 
-typedef std::list<gcov_arc_info>             arcs_t;
-typedef std::list<gcov_arc_info>::iterator   arcs_iterator_t;
-typedef std::list<gcov_block_info>           blocks_t;
-typedef std::list<gcov_block_info>::iterator blocks_iterator_t;
+typedef std::vector<gcov_arc_info>             arcs_t;
+typedef std::vector<gcov_arc_info>::iterator   arcs_iterator_t;
+typedef std::vector<gcov_block_info>           blocks_t;
+typedef std::vector<gcov_block_info>::iterator blocks_iterator_t;
 
 class DesiredSymbols;
 
@@ -178,10 +178,11 @@ class DesiredSymbols;
      *  This method finds block by its ID
      *
      *  @param[in] id passes block id number
+     *  @param[out] block is set to the matching block
      *
-     *  @return Returns iterator to a matching block or NULL for error.
+     *  @return Returns TRUE if the block was found and FALSE otherwise.
      */
-    blocks_iterator_t findBlockById( const uint32_t id );
+    bool findBlockById( const uint32_t id, blocks_iterator_t& block );
 
     /*!
      *  This method adds new block to block list
@@ -244,6 +245,20 @@ class DesiredSymbols;
     std::string functionName;
     std::string sourceFileName;
 
+    /*!
+     *  These members hold the flow graph in compressed sparse row form.
+     *  The arcs leaving the block at position b are the arcs indexed by
+     *  arcIndex[ arcStart[ b ] ] up to arcIndex[ arcStart[ b + 1 ] ] in
+     *  the order of the notes file.
+     */
+    std::vector<uint32_t> arcStart;
+    std::vector<uint32_t> arcIndex;
+
+    /*!
+     *  This member maps a block id to the position of the block.
+     */
+    std::vector<uint32_t> blockPosition;
+
     /*!
      *  This member contains the unified or merged coverage map
      *  and symbol info for the symbol.
@@ -259,9 +274,18 @@ class DesiredSymbols;
      *  @param[in] notTaken   used to return not taken counts list
      */
     bool processBranches(
-      std::list<uint64_t>* taken,
-      std::list<uint64_t>* notTaken
+      std::vector<uint64_t>* taken,
+      std::vector<uint64_t>* notTaken
     );
+
+    /*!
+     *  This method builds the compressed sparse row form of the flow graph
+     *  from the arcs and blocks.
+     *
+     *  @return Returns TRUE if every arc connects blocks of the function
+     *  and FALSE otherwise.
+     */
+    bool buildGraph();
   };
 
 }
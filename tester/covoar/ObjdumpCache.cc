@@ -0,0 +1,303 @@
+/*! @file ObjdumpCache.cc
+ *  @brief ObjdumpCache Implementation
+ *
+ *  This file contains the implementation of the on-disk cache of
+ *  object dumps.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <rld.h>
+#include <rld-elf.h>
+#include <rld-files.h>
+#include <rld-hash.h>
+#include <rld-path.h>
+
+#include "ObjdumpCache.h"
+
+namespace Coverage {
+
+  /*
+   * The cache entry header. Change the version if the format changes.
+   */
+  static const char     cacheMagic[8] = { 'C', 'O', 'V', 'O', 'D', 'M', 'P', 0 };
+  static const uint32_t cacheVersion = 1;
+
+  /*
+   * The line flags.
+   */
+  static const uint8_t lineIsInstruction = 1 << 0;
+  static const uint8_t lineIsNop         = 1 << 1;
+  static const uint8_t lineIsBranch      = 1 << 2;
+
+  static void writeU32( std::ostream& out, uint32_t value )
+  {
+    out.write( reinterpret_cast<const char*>( &value ), sizeof( value ) );
+  }
+
+  static void writeString( std::ostream& out, const std::string& s )
+  {
+    writeU32( out, s.size() );
+    out.write( s.data(), s.size() );
+  }
+
+  static bool readU32( std::istream& in, uint32_t& value )
+  {
+    in.read( reinterpret_cast<char*>( &value ), sizeof( value ) );
+    return in.good();
+  }
+
+  static bool readU8( std::istream& in, uint8_t& value )
+  {
+    in.read( reinterpret_cast<char*>( &value ), sizeof( value ) );
+    return in.good();
+  }
+
+  static bool readString( std::istream& in, std::string& s )
+  {
+    uint32_t size;
+
+    if ( !readU32( in, size ) ) {
+      return false;
+    }
+
+    s.resize( size );
+    if ( size != 0 ) {
+      in.read( &s[0], size );
+    }
+
+    return in.good();
+  }
+
+  ObjdumpCache::ObjdumpCache(
+    const std::string& directory,
+    const std::string& objdump
+  ) : directory_m( directory ),
+      objdump_m( objdump )
+  {
+  }
+
+  ObjdumpCache::~ObjdumpCache()
+  {
+  }
+
+  std::string ObjdumpCache::getKey( const std::string& fileName )
+  {
+    std::ostringstream key;
+
+    key << std::hex << std::setfill( '0' );
+
+    // Use the build-id note if there is one.
+    {
+      rld::elf::object_type types;
+      rld::files::object    object( fileName );
+      std::vector<uint8_t>  id;
+
+      object.set_object_type( types );
+      object.open();
+      object.begin();
+
+      if ( rld::hash::build_id( object.elf(), id ) ) {
+        key << "b-";
+        for ( auto b : id ) {
+          key << std::setw( 2 ) << static_cast<unsigned>( b );
+        }
+
+        return key.str();
+      }
+    }
+
+    return getHash( fileName );
+  }
+
+  std::string ObjdumpCache::getHash( const std::string& fileName )
+  {
+    std::ostringstream key;
+
+    key << std::hex << std::setfill( '0' );
+
+    // Hash the contents of the file with FNV-1a.
+    std::ifstream in( fileName, std::ios::in | std::ios::binary );
+    if ( !in.is_open() ) {
+      throw rld::error( "Unable to open " + fileName, "ObjdumpCache::getHash" );
+    }
+
+    std::vector<char> buffer( 1024 * 1024 );
+    uint64_t          hash = 14695981039346656037ULL;
+    uint64_t          size = 0;
+
+    while ( in ) {
+      in.read( buffer.data(), buffer.size() );
+      std::streamsize got = in.gcount();
+      for ( std::streamsize b = 0; b < got; ++b ) {
+        hash ^= static_cast<uint8_t>( buffer[b] );
+        hash *= 1099511628211ULL;
+      }
+      size += got;
+    }
+
+    key << "h-" << std::setw( 16 ) << hash << '-' << size;
+
+    return key.str();
+  }
+
+  bool ObjdumpCache::load(
+    const std::string&                  fileName,
+    ObjdumpProcessor::objdumpListing_t& listing
+  )
+  {
+    std::string key = getKey( fileName );
+    std::string path;
+
+    rld::path::path_join( directory_m, key + ".objdump", path );
+
+    std::ifstream in( path, std::ios::in | std::ios::binary );
+    if ( !in.is_open() ) {
+      return false;
+    }
+
+    char        magic[ sizeof( cacheMagic ) ];
+    uint32_t    version;
+    std::string objdump;
+    std::string entryKey;
+    uint32_t    symbolCount;
+
+    in.read( magic, sizeof( magic ) );
+    if (
+      !in.good() ||
+      ::memcmp( magic, cacheMagic, sizeof( magic ) ) != 0 ||
+      !readU32( in, version ) || version != cacheVersion ||
+      !readString( in, objdump ) || objdump != objdump_m ||
+      !readString( in, entryKey ) || entryKey != key ||
+      !readU32( in, symbolCount )
+    ) {
+      return false;
+    }
+
+    ObjdumpProcessor::objdumpListing_t cached;
+
+    for ( uint32_t s = 0; s < symbolCount; ++s ) {
+      uint8_t  lastInFile;
+      uint32_t lineCount;
+
+      cached.emplace_back();
+      objdumpSymbolLines_t& listed = cached.back();
+
+      if (
+        !readString( in, listed.symbolName ) ||
+        !readU8( in, lastInFile ) ||
+        !readU32( in, lineCount )
+      ) {
+        return false;
+      }
+
+      listed.lastInFile = lastInFile != 0;
+
+      for ( uint32_t l = 0; l < lineCount; ++l ) {
+        uint8_t  flags;
+        uint32_t nopSize;
+
+        listed.lines.emplace_back();
+        objdumpLine_t& line = listed.lines.back();
+
+        if (
+          !readU32( in, line.address ) ||
+          !readU8( in, flags ) ||
+          !readU32( in, nopSize ) ||
+          !readString( in, line.line )
+        ) {
+          return false;
+        }
+
+        line.isInstruction = ( flags & lineIsInstruction ) != 0;
+        line.isNop         = ( flags & lineIsNop ) != 0;
+        line.isBranch      = ( flags & lineIsBranch ) != 0;
+        line.nopSize       = nopSize;
+      }
+    }
+
+    listing.swap( cached );
+
+    return true;
+  }
+
+  void ObjdumpCache::save(
+    const std::string&                        fileName,
+    const ObjdumpProcessor::objdumpListing_t& listing
+  )
+  {
+    std::string key = getKey( fileName );
+    std::string path;
+
+    rld::path::path_join( directory_m, key + ".objdump", path );
+
+    // Write to a file of our own and rename it so a reader never sees a
+    // partial entry.
+    std::ostringstream temp;
+    temp << path << '.' << ::getpid() << '.'
+         << std::hash<std::thread::id>()( std::this_thread::get_id() );
+
+    {
+      std::ofstream out(
+        temp.str(),
+        std::ios::out | std::ios::binary | std::ios::trunc
+      );
+
+      if ( out.is_open() ) {
+        out.write( cacheMagic, sizeof( cacheMagic ) );
+        writeU32( out, cacheVersion );
+        writeString( out, objdump_m );
+        writeString( out, key );
+        writeU32( out, listing.size() );
+
+        for ( const auto& listed : listing ) {
+          writeString( out, listed.symbolName );
+          out.put( listed.lastInFile ? 1 : 0 );
+          writeU32( out, listed.lines.size() );
+
+          for ( const auto& line : listed.lines ) {
+            uint8_t flags = 0;
+
+            if ( line.isInstruction ) {
+              flags |= lineIsInstruction;
+            }
+            if ( line.isNop ) {
+              flags |= lineIsNop;
+            }
+            if ( line.isBranch ) {
+              flags |= lineIsBranch;
+            }
+
+            writeU32( out, line.address );
+            out.put( flags );
+            writeU32( out, line.nopSize );
+            writeString( out, line.line );
+          }
+        }
+
+        out.close();
+      }
+
+      if ( !out ) {
+        std::cerr << "WARNING: Unable to write the objdump cache " << path
+                  << std::endl;
+        ::remove( temp.str().c_str() );
+        return;
+      }
+    }
+
+    if ( ::rename( temp.str().c_str(), path.c_str() ) != 0 ) {
+      ::remove( temp.str().c_str() );
+    }
+  }
+
+}
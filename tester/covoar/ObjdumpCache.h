@@ -0,0 +1,104 @@
+/*! @file ObjdumpCache.h
+ *  @brief ObjdumpCache Specification
+ *
+ *  This file contains the specification of the ObjdumpCache class.
+ */
+
+#ifndef __OBJDUMP_CACHE_H__
+#define __OBJDUMP_CACHE_H__
+
+#include <string>
+
+#include "ObjdumpProcessor.h"
+
+namespace Coverage {
+
+  /*! @class ObjdumpCache
+   *
+   *  This class implements an on-disk cache of the parsed object dumps
+   *  of executables. An object dump is cached with all its symbols so it
+   *  can be used with any set of desired symbols. The cache entry of an
+   *  executable is keyed by the ELF build-id or, if the executable does
+   *  not have one, a hash of the executable's contents. The entries are
+   *  written in the host's byte order.
+   */
+  class ObjdumpCache {
+
+  public:
+
+    /*!
+     *  This method constructs an ObjdumpCache instance.
+     *
+     *  @param[in] directory specifies the directory holding the cache
+     *  @param[in] objdump specifies the objdump program whose output is
+     *             cached
+     */
+    ObjdumpCache(
+      const std::string& directory,
+      const std::string& objdump
+    );
+
+    /*!
+     *  This method destructs an ObjdumpCache instance.
+     */
+    virtual ~ObjdumpCache();
+
+    /*!
+     *  This method loads the cached object dump of the specified file.
+     *
+     *  @param[in] fileName specifies the executable
+     *  @param[out] listing is filled with the cached object dump
+     *
+     *  @return Returns TRUE if the object dump is cached, FALSE otherwise.
+     */
+    bool load(
+      const std::string&                  fileName,
+      ObjdumpProcessor::objdumpListing_t& listing
+    );
+
+    /*!
+     *  This method saves the object dump of the specified file in the
+     *  cache. A failure to write the cache is reported and ignored.
+     *
+     *  @param[in] fileName specifies the executable
+     *  @param[in] listing specifies the object dump to cache
+     */
+    void save(
+      const std::string&                        fileName,
+      const ObjdumpProcessor::objdumpListing_t& listing
+    );
+
+    /*!
+     *  This method returns the key of the specified file. The key
+     *  identifies the build of the executable.
+     *
+     *  @param[in] fileName specifies the executable
+     *
+     *  @return Returns the key used to name the cache entry.
+     */
+    static std::string getKey( const std::string& fileName );
+
+    /*!
+     *  This method returns a hash of the contents of the specified file.
+     *
+     *  @param[in] fileName specifies the file
+     *
+     *  @return Returns the hash and size of the file as a string.
+     */
+    static std::string getHash( const std::string& fileName );
+
+  private:
+
+    /*!
+     *  This member variable contains the directory holding the cache.
+     */
+    std::string directory_m;
+
+    /*!
+     *  This member variable contains the objdump program.
+     */
+    std::string objdump_m;
+  };
+
+}
+#endif
@@ -17,24 +17,41 @@
 #include <iomanip>
 
 #include "ObjdumpProcessor.h"
+#include "ObjdumpCache.h"
 #include "CoverageMap.h"
 #include "ExecutableInfo.h"
 #include "SymbolTable.h"
 #include "TargetFactory.h"
+#include "Timings.h"
 
 #include "rld.h"
+#include "rld-elf.h"
+#include "rld-files.h"
 #include "rld-process.h"
+#include "rld-symbols.h"
+#include "rld-tasks.h"
 
 #define MAX_LINE_LENGTH 512
 
+/*
+ *  The minimum size of the .text address range dumped by one objdump when
+ *  the section is split.
+ */
+#define OBJDUMP_SHARD_SIZE ( 1024 * 1024 )
+
+/*
+ *  The number of address ranges of the desired symbols' code is joined
+ *  down to when only their code is dumped.
+ */
+#define OBJDUMP_MAXIMUM_RANGES 8
+
 namespace Coverage {
 
   void finalizeSymbol(
-    ExecutableInfo* const            executableInfo,
-    std::string&                     symbolName,
-    ObjdumpProcessor::objdumpLines_t instructions,
-    bool                             verbose,
-    DesiredSymbols&                  symbolsToAnalyze
+    ExecutableInfo* const               executableInfo,
+    std::string&                        symbolName,
+    ObjdumpProcessor::objdumpLines_t&   instructions,
+    ObjdumpProcessor::objdumpSymbols_t& symbols
   ) {
     // Find the symbol's coverage map.
     try {
@@ -95,14 +112,6 @@ namespace Coverage {
         size = computedHighAddress - lowAddress;
       }
 
-      // If there are NOT already saved instructions, save them.
-      SymbolInformation* symbolInfo = symbolsToAnalyze.find( symbolName );
-      if ( symbolInfo->instructions.empty() ) {
-        symbolInfo->sourceFile   = executableInfo;
-        symbolInfo->baseAddress  = lowAddress;
-        symbolInfo->instructions = instructions;
-      }
-
       // Add the symbol to this executable's symbol table.
       SymbolTable* theSymbolTable = executableInfo->getSymbolTable();
       theSymbolTable->addSymbol(
@@ -116,14 +125,15 @@ namespace Coverage {
         coverageMap.setIsStartOfInstruction( instruction.address );
       }
 
-      // Create a unified coverage map for the symbol.
-      symbolsToAnalyze.createCoverageMap(
-        executableInfo->getFileName().c_str(),
-        symbolName,
-        size,
-        sizeWithoutNops,
-        verbose
-      );
+      // Hold the symbol until it is added to the desired symbols.
+      symbols.emplace_back();
+      objdumpSymbol_t& symbol = symbols.back();
+      symbol.symbolName      = symbolName;
+      symbol.lowAddress      = lowAddress;
+      symbol.size            = size;
+      symbol.sizeWithoutNops = sizeWithoutNops;
+      symbol.instructions.swap( instructions );
+      symbol.instructions.shrink_to_fit();
     } catch ( const ExecutableInfo::CoverageMapNotFoundError& e ) {
       // Allow execution to continue even if a coverage map could not be
       // found.
@@ -136,7 +146,10 @@ namespace Coverage {
     DesiredSymbols&                      symbolsToAnalyze,
     std::shared_ptr<Target::TargetBase>& targetInfo
   ): symbolsToAnalyze_m( symbolsToAnalyze ),
-     targetInfo_m( targetInfo )
+     targetInfo_m( targetInfo ),
+     useDecoder_m( false ),
+     cache_m( NULL ),
+     timings_m( NULL )
   {
   }
 
@@ -149,9 +162,6 @@ namespace Coverage {
   )
   {
     #define METHOD "ERROR: ObjdumpProcessor::determineLoadAddress - "
-    std::ifstream loadAddressFile;
-    uint32_t      offset;
-    char          inputBuffer[ MAX_LINE_LENGTH ];
 
     // This method should only be call for a dynamic library.
     if ( !theExecutable->hasDynamicLibrary() ) {
@@ -159,44 +169,50 @@ namespace Coverage {
     }
 
     std::string dlinfoName = theExecutable->getFileName();
-    uint32_t address;
-    char inLibName[128];
     std::string Library = theExecutable->getLibraryName();
 
     dlinfoName += ".dlinfo";
-    // Read load address.
-    loadAddressFile.open( dlinfoName );
-    if ( !loadAddressFile.is_open() ) {
-      std::ostringstream what;
-      what << "Unable to open " << dlinfoName;
-      throw rld::error( what, METHOD );
-    }
 
-    // Process the dlinfo file.
-    while ( 1 ) {
+    std::lock_guard<std::mutex> lock( dynamicLibraryLock_m );
+
+    auto entries = loadAddresses_m.find( dlinfoName );
+    if ( entries == loadAddresses_m.end() ) {
+      std::ifstream   loadAddressFile;
+      loadAddresses_t addresses;
+      std::string     line;
 
-      // Get a line.
-      loadAddressFile.getline( inputBuffer, MAX_LINE_LENGTH );
-      if ( loadAddressFile.fail() && loadAddressFile.is_open() ) {
-        loadAddressFile.close();
+      // Read load address.
+      loadAddressFile.open( dlinfoName );
+      if ( !loadAddressFile.is_open() ) {
         std::ostringstream what;
-        what << "library " << Library << " not found in " << dlinfoName;
+        what << "Unable to open " << dlinfoName;
         throw rld::error( what, METHOD );
       }
 
-      sscanf( inputBuffer, "%s %x", inLibName, &offset );
-      std::string tmp = inLibName;
-      if ( tmp.find( Library ) != tmp.npos ) {
-        // std::cerr << inLibName << " - 0x"
-        //           << std::setfill( '0' ) << std::setw( 8 ) << std::hex
-        //           << offset << std::endl
-        //           << std::dec << std::setfill( ' ' );
-        address = offset;
-        break;
+      // Process the dlinfo file.
+      while ( std::getline( loadAddressFile, line ) ) {
+        std::istringstream entry( line );
+        std::string        inLibName;
+        uint32_t           offset = 0;
+
+        if ( entry >> inLibName ) {
+          entry >> std::hex >> offset;
+          addresses.push_back( std::make_pair( inLibName, offset ) );
+        }
+      }
+
+      entries = loadAddresses_m.emplace( dlinfoName, addresses ).first;
+    }
+
+    for ( const auto& entry : entries->second ) {
+      if ( entry.first.find( Library ) != std::string::npos ) {
+        return entry.second;
       }
     }
 
-    return address;
+    std::ostringstream what;
+    what << "library " << Library << " not found in " << dlinfoName;
+    throw rld::error( what, METHOD );
 
     #undef METHOD
   }
@@ -246,29 +262,56 @@ namespace Coverage {
     return targetInfo_m->isNopLine( line, size );
   }
 
-  void ObjdumpProcessor::getFile(
+  bool ObjdumpProcessor::getFile(
     std::string             fileName,
-    rld::process::tempfile& objdumpFile,
-    rld::process::tempfile& err
+    rld::process::pipe&     objdumpFile,
+    rld::process::tempfile& err,
+    uint32_t                startAddress,
+    uint32_t                stopAddress
   )
   {
-    rld::process::status        status;
     rld::process::arg_container args = {
       targetInfo_m->getObjdump(),
       "-Cda",
       "--section=.text",
-      "--source",
-      fileName
+      "--source"
     };
 
+    if ( stopAddress != 0 ) {
+      std::ostringstream start;
+      std::ostringstream stop;
+      start << "--start-address=0x" << std::hex << startAddress;
+      stop << "--stop-address=0x" << std::hex << stopAddress;
+      args.push_back( start.str() );
+      args.push_back( stop.str() );
+    }
+
+    args.push_back( fileName );
+
     try
     {
-      status = rld::process::execute(
-        targetInfo_m->getObjdump(),
-        args,
-        objdumpFile.name(),
-        err.name()
-      );
+      objdumpFile.open( targetInfo_m->getObjdump(), args, err.name() );
+    } catch( rld::error& err )
+      {
+        std::cout << "Error while running " << targetInfo_m->getObjdump()
+                  << " on " << fileName << std::endl;
+        std::cout << err.what << " in " << err.where << std::endl;
+        return false;
+      }
+
+    return true;
+  }
+
+  bool ObjdumpProcessor::closeFile(
+    const std::string&  fileName,
+    rld::process::pipe& objdumpFile
+  )
+  {
+    rld::process::status status;
+
+    try
+    {
+      status = objdumpFile.close();
       if (
         ( status.type != rld::process::status::normal ) ||
         ( status.code != 0 )
@@ -280,46 +323,43 @@ namespace Coverage {
         std::cout << "Error while running " << targetInfo_m->getObjdump()
                   << " on " << fileName << std::endl;
         std::cout << err.what << " in " << err.where << std::endl;
-        return;
+        return false;
       }
 
-    objdumpFile.open( true );
+    return true;
   }
 
   uint32_t ObjdumpProcessor::getAddressAfter( uint32_t address )
   {
-    objdumpFile_t::iterator itr;
-
-    itr = find ( objdumpList.begin(), objdumpList.end(), address );
-    if ( itr == objdumpList.end() ) {
-      return 0;
-    }
-
-    itr++;
-    if ( itr == objdumpList.end() ) {
+    auto itr = addressAfter_m.find( address );
+    if ( itr == addressAfter_m.end() ) {
       return 0;
     }
 
-    return (*itr);
-
+    return itr->second;
   }
 
   void ObjdumpProcessor::loadAddressTable (
     ExecutableInfo* const   executableInformation,
-    rld::process::tempfile& objdumpFile,
     rld::process::tempfile& err
   )
   {
-    int         items;
-    uint32_t    offset;
-    char        terminator;
-    std::string line;
+    int                items;
+    uint32_t           offset;
+    char               terminator;
+    std::string        line;
+    std::string        fileName;
+    rld::process::pipe objdumpFile;
 
     // Obtain the objdump file.
     if ( !executableInformation->hasDynamicLibrary() ) {
-      getFile( executableInformation->getFileName(), objdumpFile, err );
+      fileName = executableInformation->getFileName();
     } else {
-      getFile( executableInformation->getLibraryName(), objdumpFile, err );
+      fileName = executableInformation->getLibraryName();
+    }
+
+    if ( !getFile( fileName, objdumpFile, err ) ) {
+      return;
     }
 
     // Process all lines from the objdump file.
@@ -341,64 +381,549 @@ namespace Coverage {
         );
       }
     }
+
+    closeFile( fileName, objdumpFile );
+
+    // Index the address after each address. The first instance of an
+    // address in the list is used.
+    addressAfter_m.clear();
+    addressAfter_m.reserve( objdumpList.size() );
+    for ( auto itr = objdumpList.begin(); itr != objdumpList.end(); ) {
+      uint32_t address = *itr;
+      if ( ++itr == objdumpList.end() ) {
+        break;
+      }
+      addressAfter_m.emplace( address, *itr );
+    }
   }
 
   void ObjdumpProcessor::load(
     ExecutableInfo* const   executableInformation,
-    rld::process::tempfile& objdumpFile,
     rld::process::tempfile& err,
     bool                    verbose
   )
   {
-    std::string    currentSymbol = "";
-    uint32_t       instructionOffset;
-    int            items;
-    int            found;
-    objdumpLine_t  lineInfo;
-    uint32_t       offset;
-    bool           processSymbol = false;
-    char           symbol[ MAX_LINE_LENGTH ];
-    char           terminator1;
-    char           terminatorOne;
-    char           terminator2;
-    objdumpLines_t theInstructions;
-    char           instruction[ MAX_LINE_LENGTH ];
-    char           ID[ MAX_LINE_LENGTH ];
-    std::string    call = "";
-    std::string    jumpTableID = "";
-    std::string    line = "";
+    objdumpSymbols_t symbols;
+
+    loadSymbols( executableInformation, err, verbose, symbols );
+    addSymbols( executableInformation, symbols, verbose );
+  }
+
+  void ObjdumpProcessor::addSymbols(
+    ExecutableInfo* const executableInformation,
+    objdumpSymbols_t&     symbols,
+    bool                  verbose
+  )
+  {
+    Timings::Scope timing( timings_m, "ObjdumpProcessor::addSymbols" );
+
+    for ( auto& symbol : symbols ) {
+      SymbolInformation* symbolInfo =
+        symbolsToAnalyze_m.find( symbol.symbolName );
+
+      // Create a unified coverage map for the symbol.
+      symbolsToAnalyze_m.createCoverageMap(
+        executableInformation->getFileName().c_str(),
+        symbol.symbolName,
+        symbol.size,
+        symbol.sizeWithoutNops,
+        verbose
+      );
+
+      // Mark the start of each instruction in the unified coverage map so
+      // the maps of executables that never ran the symbol need not be
+      // merged.
+      CoverageMapBase* unifiedMap = symbolInfo->unifiedCoverageMap;
+      for ( const auto& instruction : symbol.instructions ) {
+        uint32_t slot = instruction.address - symbol.lowAddress;
+        if (
+          instruction.address >= symbol.lowAddress &&
+          slot < symbol.sizeWithoutNops
+        ) {
+          unifiedMap->setIsStartOfInstruction( slot );
+        }
+      }
+
+      // If there are NOT already saved instructions, save them.
+      if ( symbolInfo->instructions.empty() ) {
+        symbolInfo->sourceFile   = executableInformation;
+        symbolInfo->baseAddress  = symbol.lowAddress;
+        symbolInfo->instructions.swap( symbol.instructions );
+      }
+    }
+
+    symbols.clear();
+  }
+
+  void ObjdumpProcessor::loadSymbols(
+    ExecutableInfo* const   executableInformation,
+    rld::process::tempfile& err,
+    bool                    verbose,
+    objdumpSymbols_t&       symbols
+  )
+  {
+    std::string      fileName;
+    objdumpListing_t listing;
+
+    // Decode the instructions if the target can.
+    if ( useDecoder_m && targetInfo_m->hasInstructionDecoder() ) {
+      Timings::Scope timing( timings_m, "ObjdumpProcessor::decodeSymbols" );
+      decodeSymbols( executableInformation, symbols );
+      executableInformation->indexCoverageMaps();
+      if ( timings_m ) {
+        timings_m->count( "symbols finalized", symbols.size() );
+      }
+      return;
+    }
 
-    // Obtain the objdump file.
     if ( !executableInformation->hasDynamicLibrary() ) {
-      getFile( executableInformation->getFileName(), objdumpFile, err );
+      fileName = executableInformation->getFileName();
     } else {
-      getFile( executableInformation->getLibraryName(), objdumpFile, err );
+      fileName = executableInformation->getLibraryName();
     }
 
-    while ( true ) {
-      // Get the line.
-      objdumpFile.read_line( line );
-      if ( line.empty() ) {
-        // If we are currently processing a symbol, finalize it.
-        if ( processSymbol ) {
-          finalizeSymbol(
-            executableInformation,
-            currentSymbol,
-            theInstructions,
-            verbose,
-            symbolsToAnalyze_m
+    // A dynamic library loaded by more than one executable is dumped once
+    // and the listing is rebased for each executable.
+    std::string libraryKey;
+    bool        haveListing = false;
+
+    if ( executableInformation->hasDynamicLibrary() ) {
+      libraryKey = ObjdumpCache::getKey( fileName );
+
+      std::lock_guard<std::mutex> lock( dynamicLibraryLock_m );
+
+      auto cached = libraryListings_m.find( libraryKey );
+      if ( cached != libraryListings_m.end() ) {
+        listing = cached->second;
+        haveListing = true;
+        if ( timings_m ) {
+          timings_m->count( "library listings reused" );
+        }
+      }
+    }
+
+    if ( !haveListing ) {
+      Timings::Scope timing( timings_m, "objdump" );
+      bool           parsed = true;
+
+      // A cached listing holds all the symbols so it can be used with any
+      // set of desired symbols.
+      if ( cache_m ) {
+        if ( !cache_m->load( fileName, listing ) ) {
+          if ( timings_m ) {
+            timings_m->count( "objdump cache misses" );
+          }
+          parsed = parseFile( fileName, err, true, listing );
+          if ( parsed ) {
+            cache_m->save( fileName, listing );
+          }
+        } else {
+          if ( timings_m ) {
+            timings_m->count( "objdump cache hits" );
+          }
+          if ( verbose ) {
+            std::cerr << "Using the cached objdump of " << fileName
+                      << std::endl;
+          }
+        }
+      } else {
+        parsed = parseFile( fileName, err, false, listing );
+      }
+
+      if ( parsed && !libraryKey.empty() ) {
+        std::lock_guard<std::mutex> lock( dynamicLibraryLock_m );
+        libraryListings_m.emplace( libraryKey, listing );
+      }
+    }
+
+    Timings::Scope timing( timings_m, "ObjdumpProcessor::load" );
+
+    for ( auto& listed : listing ) {
+      if ( !symbolsToAnalyze_m.isDesired( listed.symbolName ) ) {
+        continue;
+      }
+
+      for ( auto& line : listed.lines ) {
+        if ( line.isInstruction ) {
+          line.address += executableInformation->getLoadAddress();
+        }
+      }
+
+      finalizeSymbol(
+        executableInformation,
+        listed.symbolName,
+        listed.lines,
+        symbols
+      );
+
+      if ( listed.lastInFile ) {
+        std::cerr << "WARNING: ObjdumpProcessor::load - analysis of symbol "
+                  << listed.symbolName << std::endl
+                  << "         may be incorrect.  It was the last symbol in "
+                  << executableInformation->getFileName() << std::endl
+                  << "         and the length of its last instruction"
+                  << " is assumed          to be one."
+                  << std::endl;
+      }
+    }
+
+    executableInformation->indexCoverageMaps();
+
+    if ( timings_m ) {
+      timings_m->count( "symbols finalized", symbols.size() );
+    }
+  }
+
+  bool ObjdumpProcessor::parseFile(
+    const std::string&      fileName,
+    rld::process::tempfile& err,
+    bool                    allSymbols,
+    objdumpListing_t&       listing
+  )
+  {
+    uint32_t        low = 0;
+    uint32_t        high = 0;
+    textSymbols_t   symbols;
+    objdumpShards_t ranges;
+    bool            restricted = false;
+
+    // Only dump the desired symbols' code unless all symbols are wanted,
+    // else split large sections over the jobs.
+    if (
+      ( !allSymbols || rld::tasks::jobs() > 1 ) &&
+      getText( fileName, low, high, symbols )
+    ) {
+      if ( !allSymbols ) {
+        restricted = getDesiredRanges( low, high, symbols, ranges );
+      }
+      if ( !restricted ) {
+        getShards( low, high, symbols, rld::tasks::jobs(), ranges );
+      }
+    }
+
+    // Dump and parse the whole section in one go if it is not split.
+    if ( !restricted && ranges.size() <= 1 ) {
+      rld::process::pipe objdumpFile;
+
+      if ( !getFile( fileName, objdumpFile, err ) ) {
+        return false;
+      }
+
+      // If we are processing a symbol at the end, it is the last one.
+      if ( parseObjdump( objdumpFile, allSymbols, listing ) ) {
+        listing.back().lastInFile = true;
+      }
+
+      return closeFile( fileName, objdumpFile );
+    }
+
+    // Dump and parse each range in its own objdump and join the symbols
+    // in address order. A range ends at the start of a symbol so only the
+    // last symbol of a range ending the section is the last one in the
+    // file.
+    std::vector<objdumpListing_t> listings( ranges.size() );
+    std::vector<char>             processing( ranges.size(), 0 );
+    std::vector<char>             ok( ranges.size(), 0 );
+
+    if ( timings_m ) {
+      timings_m->count( "objdump ranges", ranges.size() );
+    }
+
+    rld::tasks::parallel_for(
+      ranges.size(),
+      0,
+      [&]( size_t n ) {
+        rld::process::tempfile rangeErr( ".err", false, true );
+        rld::process::pipe     objdumpFile;
+
+        if (
+          getFile(
+            fileName,
+            objdumpFile,
+            n == 0 ? err : rangeErr,
+            ranges[ n ].first,
+            ranges[ n ].second
+          )
+        ) {
+          processing[ n ] =
+            parseObjdump( objdumpFile, allSymbols, listings[ n ] );
+          ok[ n ] = closeFile( fileName, objdumpFile );
+        }
+      }
+    );
+
+    for ( size_t n = 0; n < ranges.size(); ++n ) {
+      if ( !ok[ n ] ) {
+        return false;
+      }
+
+      for ( auto& listed : listings[ n ] ) {
+        listing.push_back( std::move( listed ) );
+      }
+    }
+
+    if (
+      !ranges.empty() &&
+      ranges.back().second == high &&
+      processing.back() &&
+      !listings.back().empty()
+    ) {
+      listing.back().lastInFile = true;
+    }
+
+    return true;
+  }
+
+  bool ObjdumpProcessor::getText(
+    const std::string& fileName,
+    uint32_t&          low,
+    uint32_t&          high,
+    textSymbols_t&     symbols
+  )
+  {
+    rld::elf::object_type types;
+    rld::files::object    object( fileName );
+    bool                  found = false;
+
+    symbols.clear();
+
+    object.set_object_type( types );
+    object.open();
+    object.begin();
+
+    rld::elf::file&    elf = object.elf();
+    rld::elf::sections secs;
+
+    elf.get_sections( secs, SHT_PROGBITS );
+
+    for ( auto& sec : secs ) {
+      if ( sec->name() != ".text" ) {
+        continue;
+      }
+
+      low = sec->address();
+      high = low + sec->size();
+
+      rld::symbols::pointers elfSymbols;
+
+      elf.get_symbols( elfSymbols, false, true, true, true );
+
+      // The symbols objdump labels the code with. The mapping symbols of
+      // some architectures start with a '$' and are not labels.
+      for ( const auto sym : elfSymbols ) {
+        uint32_t value = sym->value();
+        int      type = sym->type();
+
+        if (
+          ( type == rld::symbols::symbol::st_func ||
+            type == rld::symbols::symbol::st_notype ||
+            type == rld::symbols::symbol::st_object ) &&
+          value >= low && value < high &&
+          !sym->name().empty() && sym->name()[ 0 ] != '$'
+        ) {
+          symbols.push_back(
+            { value, sym->demangled(), sym->is_cplusplus() }
           );
+        }
+      }
+
+      std::stable_sort(
+        symbols.begin(),
+        symbols.end(),
+        []( const textSymbol_t& a, const textSymbol_t& b ) {
+          return a.address < b.address;
+        }
+      );
+
+      found = !symbols.empty();
+      break;
+    }
+
+    object.end();
+    object.close();
+
+    return found;
+  }
+
+  void ObjdumpProcessor::getShards(
+    uint32_t             low,
+    uint32_t             high,
+    const textSymbols_t& symbols,
+    size_t               count,
+    objdumpShards_t&     shards
+  )
+  {
+    shards.clear();
+
+    // Each range has at least the minimum size.
+    count = std::min(
+      count,
+      static_cast<size_t>( ( high - low ) / OBJDUMP_SHARD_SIZE )
+    );
+    if ( count <= 1 ) {
+      return;
+    }
+
+    uint32_t start = low;
+    for ( size_t n = 1; n < count; ++n ) {
+      uint32_t target = low + ( high - low ) / count * n;
+      auto     split = std::lower_bound(
+        symbols.begin(),
+        symbols.end(),
+        target,
+        []( const textSymbol_t& symbol, uint32_t address ) {
+          return symbol.address < address;
+        }
+      );
+
+      if ( split == symbols.end() ) {
+        break;
+      }
+
+      if ( split->address > start ) {
+        shards.push_back( std::make_pair( start, split->address ) );
+        start = split->address;
+      }
+    }
+
+    shards.push_back( std::make_pair( start, high ) );
+  }
+
+  bool ObjdumpProcessor::getDesiredRanges(
+    uint32_t             low,
+    uint32_t             high,
+    const textSymbols_t& symbols,
+    objdumpShards_t&     ranges
+  )
+  {
+    std::vector<char> desired( symbols.size(), 0 );
+
+    ranges.clear();
+
+    // A symbol is desired if any name at its address is desired. The
+    // names are compared as the object dump's labels are, without the
+    // suffix of a function part. The demangler used by objdump may name
+    // C++ symbols differently so they are always dumped.
+    for ( size_t n = 0; n < symbols.size(); ) {
+      size_t next = n;
+      bool   any = false;
+
+      while (
+        next < symbols.size() &&
+        symbols[ next ].address == symbols[ n ].address
+      ) {
+        std::string name = symbols[ next ].name;
+        size_t      period = name.find( '.' );
+
+        if ( period != std::string::npos ) {
+          name.erase( period );
+        }
+
+        if (
+          symbols[ next ].isCPlusPlus ||
+          symbolsToAnalyze_m.isDesired( name )
+        ) {
+          any = true;
+        }
+
+        ++next;
+      }
+
+      std::fill( desired.begin() + n, desired.begin() + next, any );
+      n = next;
+    }
+
+    // Each run of desired symbols is a range up to the next symbol.
+    for ( size_t n = 0; n < symbols.size(); ++n ) {
+      if ( !desired[ n ] ) {
+        continue;
+      }
+
+      uint32_t start = symbols[ n ].address;
+
+      while ( n < symbols.size() && desired[ n ] ) {
+        ++n;
+      }
+
+      uint32_t stop = n < symbols.size() ? symbols[ n ].address : high;
+
+      ranges.push_back( std::make_pair( start, stop ) );
+    }
+
+    // Join the ranges over the smallest gaps.
+    size_t maximum = std::max(
+      static_cast<size_t>( OBJDUMP_MAXIMUM_RANGES ),
+      static_cast<size_t>( rld::tasks::jobs() )
+    );
 
-          std::cerr << "WARNING: ObjdumpProcessor::load - analysis of symbol "
-                    << currentSymbol << std::endl
-                    << "         may be incorrect.  It was the last symbol in "
-                    << executableInformation->getFileName() << std::endl
-                    << "         and the length of its last instruction"
-                    << " is assumed          to be one."
-                    << std::endl;
+    if ( ranges.size() > maximum ) {
+      std::vector<size_t> gaps( ranges.size() - 1 );
+      std::vector<char>   joined( ranges.size() - 1, 0 );
+      objdumpShards_t     joinedRanges;
+
+      for ( size_t n = 0; n < gaps.size(); ++n ) {
+        gaps[ n ] = n;
+      }
+
+      std::nth_element(
+        gaps.begin(),
+        gaps.begin() + ( ranges.size() - maximum ),
+        gaps.end(),
+        [&]( size_t a, size_t b ) {
+          uint32_t gapA = ranges[ a + 1 ].first - ranges[ a ].second;
+          uint32_t gapB = ranges[ b + 1 ].first - ranges[ b ].second;
+          return gapA < gapB || ( gapA == gapB && a < b );
+        }
+      );
+
+      for ( size_t n = 0; n < ranges.size() - maximum; ++n ) {
+        joined[ gaps[ n ] ] = 1;
+      }
+
+      joinedRanges.push_back( ranges.front() );
+      for ( size_t n = 1; n < ranges.size(); ++n ) {
+        if ( joined[ n - 1 ] ) {
+          joinedRanges.back().second = ranges[ n ].second;
+        } else {
+          joinedRanges.push_back( ranges[ n ] );
         }
+      }
+
+      ranges.swap( joinedRanges );
+    }
+
+    return
+      ranges.size() != 1 ||
+      ranges.front().first != symbols.front().address ||
+      ranges.front().second != high;
+  }
+
+  bool ObjdumpProcessor::parseObjdump(
+    rld::process::pipe& objdumpFile,
+    bool                allSymbols,
+    objdumpListing_t&   listing
+  )
+  {
+    uint32_t           instructionOffset;
+    int                items;
+    int                found;
+    objdumpLine_t      lineInfo;
+    uint32_t           offset;
+    bool               processSymbol = false;
+    char               symbol[ MAX_LINE_LENGTH ];
+    char               terminator1;
+    char               terminatorOne;
+    char               terminator2;
+    char               instruction[ MAX_LINE_LENGTH ];
+    char               ID[ MAX_LINE_LENGTH ];
+    std::string        call = "";
+    std::string        jumpTableID = "";
+    std::string        line = "";
 
-        objdumpFile.close();
+    while ( true ) {
+      // Get the line.
+      objdumpFile.read_line( line );
+      if ( line.empty() ) {
         break;
       }
 
@@ -442,21 +967,8 @@ namespace Coverage {
 
       // If all items found, we are at the beginning of a symbol's objdump.
       if ( ( items == 3 ) && ( terminator1 == ':' ) ) {
-        // If we are currently processing a symbol, finalize it.
-        if ( processSymbol ) {
-          finalizeSymbol(
-            executableInformation,
-            currentSymbol,
-            theInstructions,
-            verbose,
-            symbolsToAnalyze_m
-          );
-        }
-
         // Start processing of a new symbol.
-        currentSymbol = "";
         processSymbol = false;
-        theInstructions.clear();
 
         // Look for a '.' character and strip everything after it.
         // There is a chance that the compiler splits function bodies to improve
@@ -474,13 +986,15 @@ namespace Coverage {
         }
 
         // See if the new symbol is one that we care about.
-        if ( symbolsToAnalyze_m.isDesired( symbol ) ) {
-          currentSymbol = symbol;
+        if ( allSymbols || symbolsToAnalyze_m.isDesired( symbol ) ) {
           processSymbol = true;
-          theInstructions.push_back( lineInfo );
+          listing.emplace_back();
+          listing.back().symbolName = symbol;
+          listing.back().lastInFile = false;
+          listing.back().lines.push_back( std::move( lineInfo ) );
         }
       }
-      // If it looks like a jump table, finalize the symbol.
+      // If it looks like a jump table, finish the symbol.
       else if (
         ( found == 5 ) &&
         ( terminatorOne == ':' ) &&
@@ -489,17 +1003,6 @@ namespace Coverage {
         ( jumpTableID.find( "+0x" ) != std::string::npos ) &&
         processSymbol
       ) {
-        // If we are currently processing a symbol, finalize it.
-        if ( processSymbol ) {
-          finalizeSymbol(
-            executableInformation,
-            currentSymbol,
-            theInstructions,
-            verbose,
-            symbolsToAnalyze_m
-          );
-        }
-
         processSymbol = false;
       }
       else if ( processSymbol ) {
@@ -520,17 +1023,18 @@ namespace Coverage {
           ( terminator2 == '\t' )
         ) {
           // update the line's information, save it and ...
-          lineInfo.address =
-           executableInformation->getLoadAddress() + instructionOffset;
+          lineInfo.address       = instructionOffset;
           lineInfo.isInstruction = true;
           lineInfo.isNop         = isNop( line.c_str(), lineInfo.nopSize );
           lineInfo.isBranch      = isBranchLine( line.c_str() );
         }
 
         // Always save the line.
-        theInstructions.push_back( lineInfo );
+        listing.back().lines.push_back( std::move( lineInfo ) );
       }
     }
+
+    return processSymbol;
   }
 
   void ObjdumpProcessor::setTargetInfo(
@@ -539,4 +1043,257 @@ namespace Coverage {
   {
     targetInfo_m = targetInfo;
   }
+
+  void ObjdumpProcessor::setUseDecoder( bool useDecoder )
+  {
+    useDecoder_m = useDecoder;
+  }
+
+  void ObjdumpProcessor::setCache( ObjdumpCache* cache )
+  {
+    cache_m = cache;
+  }
+
+  void ObjdumpProcessor::setTimings( Timings* timings )
+  {
+    timings_m = timings;
+  }
+
+  bool ObjdumpProcessor::decodeInstruction(
+    const uint8_t*        insn,
+    uint32_t              offset,
+    uint32_t              size,
+    bool                  bigEndian,
+    decodedInstruction_t& decoded
+  )
+  {
+    std::string mnemonic;
+
+    if (
+      !targetInfo_m->decodeInstruction(
+        insn,
+        size,
+        bigEndian,
+        decoded.length,
+        mnemonic,
+        decoded.isNop
+      )
+    ) {
+      return false;
+    }
+
+    std::ostringstream text;
+    text << ":\t" << std::hex << std::setfill( '0' );
+    for ( int b = 0; b < decoded.length; ++b ) {
+      text << std::setw( 2 ) << static_cast<unsigned>( insn[b] ) << ' ';
+    }
+    text << '\t' << mnemonic;
+
+    decoded.offset   = offset;
+    decoded.isBranch = !mnemonic.empty() && IsBranch( mnemonic );
+    decoded.text     = text.str();
+
+    return true;
+  }
+
+  void ObjdumpProcessor::decodeSymbols(
+    ExecutableInfo* const executableInformation,
+    objdumpSymbols_t&     symbols
+  )
+  {
+    std::string fileName;
+
+    if ( !executableInformation->hasDynamicLibrary() ) {
+      fileName = executableInformation->getFileName();
+    } else {
+      fileName = executableInformation->getLibraryName();
+    }
+
+    rld::elf::object_type types;
+    rld::files::object    object( fileName );
+
+    object.set_object_type( types );
+    object.open();
+    object.begin();
+
+    rld::elf::file&    elf = object.elf();
+    rld::elf::sections secs;
+    rld::elf::sections code;
+
+    elf.get_sections( secs, SHT_PROGBITS );
+    for ( auto& sec : secs ) {
+      if ( ( sec->flags() & SHF_EXECINSTR ) != 0 && sec->data() != NULL ) {
+        code.push_back( sec );
+      }
+    }
+
+    bool     bigEndian = !elf.is_little_endian();
+    uint32_t loadAddress = executableInformation->getLoadAddress();
+
+    for ( const auto& s : symbolsToAnalyze_m.allSymbols() ) {
+      const std::string&     symbolName = s.first;
+      const CoverageMapBase* coverageMap =
+        executableInformation->getCoverageMap( symbolName );
+
+      if ( coverageMap == NULL ) {
+        continue;
+      }
+
+      for ( size_t r = 0; r < coverageMap->getNumberOfRanges(); ++r ) {
+        uint32_t low  = coverageMap->getLowAddressOfRange( r ) - loadAddress;
+        uint32_t high = low + coverageMap->getSizeOfRange( r );
+
+        rld::elf::section* sec = NULL;
+        for ( auto& c : code ) {
+          if ( low >= c->address() && low < c->address() + c->size() ) {
+            sec = c;
+            break;
+          }
+        }
+
+        if ( sec == NULL ) {
+          std::cerr << "Code not found for symbol " << symbolName
+                    << " in " << fileName << std::endl;
+          continue;
+        }
+
+        const uint8_t* data =
+          static_cast<const uint8_t*>( sec->data()->d_buf );
+        uint32_t       end = sec->address() + sec->data()->d_size;
+        objdumpLines_t theInstructions;
+        objdumpLine_t  lineInfo;
+        char           buffer[ MAX_LINE_LENGTH ];
+
+        ::snprintf(
+          buffer,
+          sizeof( buffer ),
+          "%08x <%s>:",
+          loadAddress + low,
+          symbolName.c_str()
+        );
+
+        lineInfo.line          = buffer;
+        lineInfo.address       = 0xffffffff;
+        lineInfo.isInstruction = false;
+        lineInfo.isNop         = false;
+        lineInfo.nopSize       = 0;
+        lineInfo.isBranch      = false;
+        theInstructions.push_back( std::move( lineInfo ) );
+
+        // Decode the code of the range unless the same code was decoded
+        // before. The last instruction can end after the range so the
+        // bytes after the range it was decoded from have to match as well.
+        const char*   code =
+          reinterpret_cast<const char*>( data + ( low - sec->address() ) );
+        uint32_t      size = std::min( high, end ) - low;
+        std::string   bytes( code, size );
+        decodedCode_t decoded;
+        bool          found = false;
+
+        {
+          std::lock_guard<std::mutex> guard( decodedLock_m );
+          auto d = decoded_m.find( bytes );
+          if (
+            d != decoded_m.end() &&
+            low + d->second.end <= end &&
+            d->second.tail.compare(
+              0, std::string::npos, code + size, d->second.end - size
+            ) == 0
+          ) {
+            decoded = d->second;
+            found = true;
+          }
+        }
+
+        if ( found ) {
+          if ( timings_m ) {
+            timings_m->count( "decoded code reused" );
+          }
+        } else {
+          uint32_t offset = 0;
+
+          decoded.failed = false;
+
+          while ( low + offset < high && low + offset < end ) {
+            decodedInstruction_t instruction;
+
+            if (
+              !decodeInstruction(
+                data + ( low + offset - sec->address() ),
+                offset,
+                end - ( low + offset ),
+                bigEndian,
+                instruction
+              )
+            ) {
+              decoded.failed = true;
+              break;
+            }
+
+            offset += instruction.length;
+            decoded.instructions.push_back( std::move( instruction ) );
+          }
+
+          decoded.end = offset;
+
+          // A failed decode depends on the end of the section.
+          if ( !decoded.failed ) {
+            decoded.tail.assign( code + size, offset - size );
+
+            std::lock_guard<std::mutex> guard( decodedLock_m );
+            decoded_m[ bytes ] = decoded;
+          }
+        }
+
+        for ( const auto& instruction : decoded.instructions ) {
+          uint32_t address = loadAddress + low + instruction.offset;
+
+          ::snprintf( buffer, sizeof( buffer ), "%8x", address );
+
+          lineInfo.line          = buffer + instruction.text;
+          lineInfo.address       = address;
+          lineInfo.isInstruction = true;
+          lineInfo.isNop         = instruction.isNop;
+          lineInfo.nopSize       = instruction.isNop ? instruction.length : 0;
+          lineInfo.isBranch      = instruction.isBranch;
+          theInstructions.push_back( std::move( lineInfo ) );
+        }
+
+        // Decode any trailing nops so the nops get marked as executed
+        // later.
+        uint32_t address = low + decoded.end;
+        while ( !decoded.failed && address < end ) {
+          decodedInstruction_t instruction;
+
+          if (
+            !decodeInstruction(
+              data + ( address - sec->address() ),
+              address - low,
+              end - address,
+              bigEndian,
+              instruction
+            ) ||
+            !instruction.isNop
+          ) {
+            break;
+          }
+
+          ::snprintf( buffer, sizeof( buffer ), "%8x", loadAddress + address );
+
+          lineInfo.line          = buffer + instruction.text;
+          lineInfo.address       = loadAddress + address;
+          lineInfo.isInstruction = true;
+          lineInfo.isNop         = true;
+          lineInfo.nopSize       = instruction.length;
+          lineInfo.isBranch      = instruction.isBranch;
+          theInstructions.push_back( std::move( lineInfo ) );
+
+          address += instruction.length;
+        }
+
+        std::string name = symbolName;
+        finalizeSymbol( executableInformation, name, theInstructions, symbols );
+      }
+    }
+  }
 }
@@ -8,7 +8,10 @@
 #define __OBJDUMP_PROCESSOR_H__
 
 #include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "ExecutableInfo.h"
 #include "TargetBase.h"
@@ -60,6 +63,64 @@ namespace Coverage {
 
   };
 
+  /*!
+   *  This type defines the disassembly of a desired symbol found in an
+   *  executable. It is held until it is added to the desired symbols.
+   */
+  struct objdumpSymbol_t {
+    /*!
+     *  This member variable contains the name of the symbol.
+     */
+    std::string symbolName;
+
+    /*!
+     *  This member variable contains the low address of the symbol.
+     */
+    uint32_t lowAddress;
+
+    /*!
+     *  This member variable contains the size of the symbol including
+     *  any trailing nops.
+     */
+    uint32_t size;
+
+    /*!
+     *  This member variable contains the size of the symbol without
+     *  trailing nops.
+     */
+    uint32_t sizeWithoutNops;
+
+    /*!
+     *  This member variable contains the disassembly of the symbol.
+     */
+    std::vector<objdumpLine_t> instructions;
+  };
+
+  /*!
+   *  This type defines the lines of a symbol in an object dump. The
+   *  addresses of the instructions are the offsets in the object dump.
+   */
+  struct objdumpSymbolLines_t {
+    /*!
+     *  This member variable contains the name of the symbol.
+     */
+    std::string symbolName;
+
+    /*!
+     *  This member variable contains the lines of the symbol.
+     */
+    std::vector<objdumpLine_t> lines;
+
+    /*!
+     *  This member variable is TRUE if the lines of the symbol end at
+     *  the end of the object dump.
+     */
+    bool lastInFile;
+  };
+
+  class ObjdumpCache;
+  class Timings;
+
   /*! @class ObjdumpProcessor
    *
    *  This class implements the functionality which reads the output of
@@ -78,7 +139,19 @@ namespace Coverage {
      *  This object defines a list of object dump lines
      *  for a file.
      */
-    typedef std::list<objdumpLine_t> objdumpLines_t;
+    typedef std::vector<objdumpLine_t> objdumpLines_t;
+
+    /*!
+     *  This object defines a list of the symbols found in an
+     *  object dump.
+     */
+    typedef std::list<objdumpSymbol_t> objdumpSymbols_t;
+
+    /*!
+     *  This object defines the list of the symbols' lines in an
+     *  object dump.
+     */
+    typedef std::list<objdumpSymbolLines_t> objdumpListing_t;
 
 
     /*!
@@ -100,16 +173,27 @@ namespace Coverage {
      */
     virtual ~ObjdumpProcessor();
 
+    /*!
+     *  This method returns the load address of the dynamic library of the
+     *  given executable from the executable's dlinfo file. The entries of
+     *  a dlinfo file are read once.
+     */
     uint32_t determineLoadAddress( ExecutableInfo* theExecutable );
 
     /*!
-     *  This method fills a tempfile with the .text section of objdump
-     *  for the given file name.
+     *  This method starts an objdump of the .text section of the given
+     *  file. The object dump is read from the pipe as it is generated.
+     *  If a stop address is given only the addresses from the start
+     *  address to before the stop address are dumped.
+     *
+     *  @return Returns TRUE if objdump is running, FALSE otherwise.
      */
-    void getFile(
+    bool getFile(
       std::string             fileName,
-      rld::process::tempfile& dmp,
-      rld::process::tempfile& err
+      rld::process::pipe&     dmp,
+      rld::process::tempfile& err,
+      uint32_t                startAddress = 0,
+      uint32_t                stopAddress = 0
     );
 
     /*!
@@ -118,7 +202,6 @@ namespace Coverage {
      */
     void loadAddressTable (
       ExecutableInfo* const   executableInformation,
-      rld::process::tempfile& dmp,
       rld::process::tempfile& err
     );
 
@@ -128,13 +211,37 @@ namespace Coverage {
      */
     void load(
       ExecutableInfo* const   executableInformation,
-      rld::process::tempfile& dmp,
       rld::process::tempfile& err,
       bool                    verbose
     );
 
     /*!
-     *  This method returns the next address in the objdumpList.
+     *  This method generates and processes an object dump for the
+     *  specified executable returning the desired symbols found. The
+     *  desired symbols are not changed so executables can be loaded in
+     *  parallel.
+     */
+    void loadSymbols(
+      ExecutableInfo* const   executableInformation,
+      rld::process::tempfile& err,
+      bool                    verbose,
+      objdumpSymbols_t&       symbols
+    );
+
+    /*!
+     *  This method adds the symbols found in an object dump of the
+     *  specified executable to the desired symbols. The symbols are
+     *  moved out of the list.
+     */
+    void addSymbols(
+      ExecutableInfo* const executableInformation,
+      objdumpSymbols_t&     symbols,
+      bool                  verbose
+    );
+
+    /*!
+     *  This method returns the next address in the objdumpList or 0 if
+     *  the address is not in the list or is the last address.
      */
     uint32_t getAddressAfter( uint32_t address );
 
@@ -159,14 +266,205 @@ namespace Coverage {
      */
     void setTargetInfo( std::shared_ptr<Target::TargetBase>& targetInfo );
 
+    /*!
+     *  This method sets if the target's instruction decoder is used to
+     *  load the symbols instead of an object dump. The decoder is only
+     *  used if the target has one.
+     *
+     *  @param[in] useDecoder specifies if the decoder is used
+     */
+    void setUseDecoder( bool useDecoder );
+
+    /*!
+     *  This method sets the cache of object dumps. The object dump of an
+     *  executable found in the cache is used and objdump is not run.
+     *
+     *  @param[in] cache points to the cache or is NULL for no cache
+     */
+    void setCache( ObjdumpCache* cache );
+
+    /*!
+     *  This method sets the timings the phases of loading the symbols are
+     *  added to.
+     *
+     *  @param[in] timings points to the timings or is NULL for no timings
+     */
+    void setTimings( Timings* timings );
+
   private:
 
+    /*!
+     *  This method generates the object dump of the given file and
+     *  parses the lines of the symbols. Only the desired symbols are
+     *  kept unless all symbols are requested.
+     *
+     *  @return Returns TRUE if objdump succeeded, FALSE otherwise.
+     */
+    bool parseFile(
+      const std::string&      fileName,
+      rld::process::tempfile& err,
+      bool                    allSymbols,
+      objdumpListing_t&       listing
+    );
+
+    /*!
+     *  This method parses the lines of the symbols read from the object
+     *  dump in the pipe.
+     *
+     *  @return Returns TRUE if a symbol was being parsed when the object
+     *  dump ended, FALSE otherwise.
+     */
+    bool parseObjdump(
+      rld::process::pipe& objdumpFile,
+      bool                allSymbols,
+      objdumpListing_t&   listing
+    );
+
+    /*!
+     *  This type defines the address ranges of the .text section an
+     *  object dump is split into.
+     */
+    typedef std::vector<std::pair<uint32_t, uint32_t>> objdumpShards_t;
+
+    /*!
+     *  This type defines a symbol the object dump of the .text section
+     *  labels.
+     */
+    struct textSymbol_t {
+      uint32_t    address;
+      std::string name;
+      bool        isCPlusPlus;
+    };
+
+    /*!
+     *  This type defines the symbols of the .text section ordered by
+     *  address.
+     */
+    typedef std::vector<textSymbol_t> textSymbols_t;
+
+    /*!
+     *  This method reads the address range of the .text section of the
+     *  given file and the symbols in it.
+     *
+     *  @return Returns TRUE if the file has a .text section with symbols,
+     *  FALSE otherwise.
+     */
+    bool getText(
+      const std::string& fileName,
+      uint32_t&          low,
+      uint32_t&          high,
+      textSymbols_t&     symbols
+    );
+
+    /*!
+     *  This method splits the .text section into up to the specified
+     *  number of address ranges of about the same size. The ranges start
+     *  at symbols so a symbol's object dump is not split. A section too
+     *  small to split is one range.
+     */
+    void getShards(
+      uint32_t             low,
+      uint32_t             high,
+      const textSymbols_t& symbols,
+      size_t               count,
+      objdumpShards_t&     shards
+    );
+
+    /*!
+     *  This method finds the address ranges of the .text section holding
+     *  the desired symbols. A range runs from a desired symbol to the next
+     *  symbol that is not desired so its object dump has the same lines
+     *  as the dump of the whole section. The ranges are joined over the
+     *  smallest gaps to bound the number of object dumps.
+     *
+     *  @return Returns TRUE if the ranges do not cover the section,
+     *  FALSE otherwise.
+     */
+    bool getDesiredRanges(
+      uint32_t             low,
+      uint32_t             high,
+      const textSymbols_t& symbols,
+      objdumpShards_t&     ranges
+    );
+
+    /*!
+     *  This method waits for the objdump of the given file to finish
+     *  and reports an error if it failed.
+     *
+     *  @return Returns TRUE if objdump succeeded, FALSE otherwise.
+     */
+    bool closeFile(
+      const std::string&  fileName,
+      rld::process::pipe& dmp
+    );
+
+    /*!
+     *  This type defines an instruction decoded from the code of a symbol.
+     *  The offset is from the start of the code and the text is the line
+     *  of the instruction without its address.
+     */
+    struct decodedInstruction_t {
+      uint32_t    offset;
+      int         length;
+      bool        isNop;
+      bool        isBranch;
+      std::string text;
+    };
+
+    /*!
+     *  This type defines the instructions decoded from the code of a
+     *  symbol's range. The decode stops at the end of the range, the
+     *  offset after the last instruction is held so the trailing nops
+     *  can be decoded from there with the bytes of the last instruction
+     *  after the range. If the decoder failed on the code the
+     *  instructions after it are not decoded.
+     */
+    struct decodedCode_t {
+      std::vector<decodedInstruction_t> instructions;
+      uint32_t                          end;
+      std::string                       tail;
+      bool                              failed;
+    };
+
+    /*!
+     *  This method decodes the instructions of the desired symbols from
+     *  the code in the executable with the target's instruction decoder.
+     *  The instruction lines hold the address, the encoding and the
+     *  mnemonic of the instruction as no disassembly is available. The
+     *  code of a range is only decoded the first time it is seen, the
+     *  same code in a later range or executable reuses the instructions
+     *  at the range's address.
+     */
+    void decodeSymbols(
+      ExecutableInfo* const executableInformation,
+      objdumpSymbols_t&     symbols
+    );
+
+    /*!
+     *  This method decodes an instruction and returns FALSE if the
+     *  decoder could not.
+     */
+    bool decodeInstruction(
+      const uint8_t*        insn,
+      uint32_t              offset,
+      uint32_t              size,
+      bool                  bigEndian,
+      decodedInstruction_t& decoded
+    );
+
     /*!
      *  This variable consists of a list of all instruction addresses
      *  extracted from the obj dump file.
      */
     objdumpFile_t objdumpList;
 
+    /*!
+     *  This variable maps each instruction address in the objdumpList to
+     *  the address after it. It is built once the list is loaded so the
+     *  lookups are constant time and can be made on threads.
+     */
+    std::unordered_map<uint32_t, uint32_t> addressAfter_m;
+
     /*!
      *  This method determines whether the specified line is a
      *  nop instruction.
@@ -190,6 +488,58 @@ namespace Coverage {
      * This member variable points to the target's info
      */
     std::shared_ptr<Target::TargetBase>& targetInfo_m;
+
+    /*!
+     * This member variable is TRUE if the target's decoder is used.
+     */
+    bool useDecoder_m;
+
+    /*!
+     * This member variable points to the cache of object dumps.
+     */
+    ObjdumpCache* cache_m;
+
+    /*!
+     * This member variable points to the timings of the phases.
+     */
+    Timings* timings_m;
+
+    /*!
+     * This member variable contains the decoded code keyed by the bytes
+     * of the code.
+     */
+    std::unordered_map<std::string, decodedCode_t> decoded_m;
+
+    /*!
+     * This member variable protects the decoded code.
+     */
+    std::mutex decodedLock_m;
+
+    /*!
+     *  This type defines the library names and load addresses of a
+     *  dlinfo file.
+     */
+    typedef std::vector<std::pair<std::string, uint32_t>> loadAddresses_t;
+
+    /*!
+     * This member variable contains the entries of the dlinfo files
+     * keyed by the file name.
+     */
+    std::unordered_map<std::string, loadAddresses_t> loadAddresses_m;
+
+    /*!
+     * This member variable contains the listings of the dynamic libraries
+     * keyed by the build of the library. The addresses of a listing are
+     * relative to the library so it is rebased for each executable the
+     * library is loaded by.
+     */
+    std::unordered_map<std::string, objdumpListing_t> libraryListings_m;
+
+    /*!
+     * This member variable protects the load addresses and the library
+     * listings.
+     */
+    std::mutex dynamicLibraryLock_m;
   };
 }
 #endif
@@ -5,17 +5,24 @@
 #include <sys/types.h>
 #include <assert.h>
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 
+#include <rld-tasks.h>
+
 #include "ReportsBase.h"
 #include "CoverageRanges.h"
 #include "DesiredSymbols.h"
 #include "Explanations.h"
 #include "ObjdumpProcessor.h"
+#include "Timings.h"
 
 #include "ReportsText.h"
 #include "ReportsHtml.h"
+#include "ReportsJson.h"
 
 #ifdef _WIN32
 #include <direct.h>
@@ -199,7 +206,7 @@ std::string expand_tabs( const std::string& in ) {
  */
 void ReportsBase::WriteAnnotatedReport( const std::string& fileName )
 {
-  std::ofstream              aFile;
+  ReportFile                 aFile;
   Coverage::CoverageRanges*  theBranches;
   Coverage::CoverageRanges*  theRanges;
   Coverage::CoverageMapBase* theCoverageMap = NULL;
@@ -310,7 +317,7 @@ void ReportsBase::WriteAnnotatedReport( const std::string& fileName )
  */
 void ReportsBase::WriteBranchReport( const std::string& fileName )
 {
-  std::ofstream             report;
+  ReportFile                report;
   Coverage::CoverageRanges* theBranches;
   unsigned int              count;
   bool                      hasBranches = true;
@@ -361,10 +368,10 @@ void ReportsBase::WriteBranchReport( const std::string& fileName )
  */
 void ReportsBase::WriteCoverageReport( const std::string& fileName )
 {
-  std::ofstream             report;
+  ReportFile                report;
   Coverage::CoverageRanges* theRanges;
   unsigned int              count;
-  std::ofstream             NoRangeFile;
+  ReportFile                NoRangeFile;
   std::string               NoRangeName;
 
   // Open special file that captures NoRange informaiton
@@ -416,7 +423,7 @@ void ReportsBase::WriteCoverageReport( const std::string& fileName )
  */
 void ReportsBase::WriteSizeReport( const std::string& fileName )
 {
-  std::ofstream             report;
+  ReportFile                report;
   Coverage::CoverageRanges* theRanges;
   unsigned int              count;
 
@@ -453,7 +460,7 @@ void ReportsBase::WriteSymbolSummaryReport(
   const DesiredSymbols& symbolsToAnalyze
 )
 {
-  std::ofstream report;
+  ReportFile report;
   unsigned int  count;
 
   // Open the report file.
@@ -494,7 +501,7 @@ void  ReportsBase::WriteSummaryReport(
   double                     percentageBranches;
   Coverage::CoverageMapBase* theCoverageMap;
   uint32_t                   totalBytes = 0;
-  std::ofstream              report;
+  ReportFile                 report;
 
   // Open the report file.
   OpenFile( fileName, symbolSetName, report, outputDirectory );
@@ -539,136 +546,662 @@ void  ReportsBase::WriteSummaryReport(
     (double) symbolsToAnalyze.getNumberBranchesFound( symbolSetName ) * 2;
   percentageBranches *= 100.0;
 
-  report << "Bytes Analyzed                   : " << totalBytes << std::endl
-         << "Bytes Not Executed               : " << notExecuted << std::endl
+  report << "Bytes Analyzed                   : " << totalBytes << '\n'
+         << "Bytes Not Executed               : " << notExecuted << '\n'
          << "Percentage Executed              : "
          << std::fixed << std::setprecision( 2 ) << std::setw( 5 )
-         << 100.0 - percentage << std::endl
-         << "Percentage Not Executed          : " << percentage << std::endl
+         << 100.0 - percentage << '\n'
+         << "Percentage Not Executed          : " << percentage << '\n'
          << "Unreferenced Symbols             : "
          << symbolsToAnalyze.getNumberUnreferencedSymbols( symbolSetName )
-         << std::endl << "Uncovered ranges found           : "
+         << '\n' << "Uncovered ranges found           : "
          << symbolsToAnalyze.getNumberUncoveredRanges( symbolSetName )
-         << std::endl << std::endl;
+         << '\n' << '\n';
 
   if (
     ( symbolsToAnalyze.getNumberBranchesFound( symbolSetName ) == 0 ) ||
     ( branchInfoAvailable == false )
   ) {
-    report << "No branch information available" << std::endl;
+    report << "No branch information available" << '\n';
   } else {
     report << "Total conditional branches found : "
            << symbolsToAnalyze.getNumberBranchesFound( symbolSetName )
-           << std::endl << "Total branch paths found         : "
+           << '\n' << "Total branch paths found         : "
            << symbolsToAnalyze.getNumberBranchesFound( symbolSetName ) * 2
-           << std::endl << "Uncovered branch paths found     : "
+           << '\n' << "Uncovered branch paths found     : "
            << symbolsToAnalyze.getNumberBranchesAlwaysTaken( symbolSetName ) +
               symbolsToAnalyze.getNumberBranchesNeverTaken( symbolSetName ) +
             ( symbolsToAnalyze.getNumberBranchesNotExecuted( symbolSetName ) * 2 )
-           << std::endl << "   "
+           << '\n' << "   "
            << symbolsToAnalyze.getNumberBranchesAlwaysTaken( symbolSetName )
-           << " branches always taken" << std::endl << "   "
+           << " branches always taken" << '\n' << "   "
            << symbolsToAnalyze.getNumberBranchesNeverTaken( symbolSetName )
-           << " branches never taken" << std::endl << "   "
+           << " branches never taken" << '\n' << "   "
            << symbolsToAnalyze.getNumberBranchesNotExecuted( symbolSetName ) * 2
-           << " branch paths not executed" << std::endl
+           << " branch paths not executed" << '\n'
            << "Percentage branch paths covered  : "
            << std::fixed << std::setprecision( 2 ) << std::setw( 4 )
-           << 100.0 - percentageBranches << std::endl;
+           << 100.0 - percentageBranches << '\n';
 
   }
 
   CloseFile( report );
 }
 
-void GenerateReports(
+/*
+ * The number of entries in each table of the profile report and the width
+ * of the bars of the symbols.
+ */
+static const size_t profileEntries = 25;
+static const size_t profileBarWidth = 40;
+
+void  ReportsBase::WriteProfileReport(
+  const std::string&              fileName,
+  const std::string&              symbolSetName,
+  const std::string&              outputDirectory,
+  const Coverage::DesiredSymbols& symbolsToAnalyze,
+  bool                            branchInfoAvailable
+)
+{
+  struct symbolProfile_t {
+    const std::string* name;
+    uint64_t           executed;
+    uint32_t           instructions;
+  };
+
+  struct blockProfile_t {
+    const std::string* name;
+    uint32_t           offset;
+    uint32_t           size;
+    uint32_t           count;
+  };
+
+  struct branchProfile_t {
+    const std::string* name;
+    uint32_t           offset;
+    uint32_t           taken;
+    uint32_t           notTaken;
+  };
+
+  std::vector<symbolProfile_t> symbols;
+  std::vector<blockProfile_t>  blocks;
+  std::vector<branchProfile_t> branches;
+  uint64_t                     total = 0;
+  ReportFile                   report;
+
+  // Open the report file.
+  OpenFile( fileName, symbolSetName, report, outputDirectory );
+  if ( !report.is_open() ) {
+    return;
+  }
+
+  //
+  // Sum the execution counts of the instructions of each symbol and split
+  // the symbol into its basic blocks.
+  //
+  const std::vector<std::string>& setSymbols =
+    symbolsToAnalyze.getSymbolsForSet( symbolSetName );
+
+  for ( const auto& symbol : setSymbols ) {
+    const SymbolInformation& info = symbolsToAnalyze.allSymbols().at( symbol );
+    CoverageMapBase*         theCoverageMap = info.unifiedCoverageMap;
+
+    if ( !theCoverageMap ) {
+      continue;
+    }
+
+    symbolProfile_t profile = { &symbol, 0, 0 };
+    blockProfile_t  block = { &symbol, 0, 0, 0 };
+
+    for ( uint32_t a = 0; a < info.stats.sizeInBytes; ++a ) {
+      if ( !theCoverageMap->isStartOfInstruction( a ) ) {
+        continue;
+      }
+
+      uint32_t count = theCoverageMap->getWasExecuted( a );
+
+      profile.executed += count;
+      ++profile.instructions;
+
+      if ( block.size != 0 && count != block.count ) {
+        if ( block.count != 0 ) {
+          blocks.push_back( block );
+        }
+        block.size = 0;
+      }
+
+      if ( block.size == 0 ) {
+        block.offset = a;
+        block.count = count;
+      }
+
+      ++block.size;
+
+      if ( theCoverageMap->isBranch( a ) ) {
+        uint32_t taken = theCoverageMap->getWasTaken( a );
+        uint32_t notTaken = theCoverageMap->getWasNotTaken( a );
+
+        if ( taken != 0 || notTaken != 0 ) {
+          branches.push_back( { &symbol, a, taken, notTaken } );
+        }
+
+        if ( block.count != 0 ) {
+          blocks.push_back( block );
+        }
+        block.size = 0;
+      }
+    }
+
+    if ( block.size != 0 && block.count != 0 ) {
+      blocks.push_back( block );
+    }
+
+    if ( profile.executed != 0 ) {
+      symbols.push_back( profile );
+      total += profile.executed;
+    }
+  }
+
+  //
+  // The most executed first and in name and address order if the same.
+  //
+  std::sort(
+    symbols.begin(),
+    symbols.end(),
+    []( const symbolProfile_t& lhs, const symbolProfile_t& rhs ) {
+      if ( lhs.executed != rhs.executed ) {
+        return lhs.executed > rhs.executed;
+      }
+      return *lhs.name < *rhs.name;
+    }
+  );
+
+  std::sort(
+    blocks.begin(),
+    blocks.end(),
+    []( const blockProfile_t& lhs, const blockProfile_t& rhs ) {
+      uint64_t l = (uint64_t) lhs.count * lhs.size;
+      uint64_t r = (uint64_t) rhs.count * rhs.size;
+      if ( l != r ) {
+        return l > r;
+      }
+      if ( *lhs.name != *rhs.name ) {
+        return *lhs.name < *rhs.name;
+      }
+      return lhs.offset < rhs.offset;
+    }
+  );
+
+  std::sort(
+    branches.begin(),
+    branches.end(),
+    []( const branchProfile_t& lhs, const branchProfile_t& rhs ) {
+      uint64_t l = (uint64_t) lhs.taken + lhs.notTaken;
+      uint64_t r = (uint64_t) rhs.taken + rhs.notTaken;
+      if ( l != r ) {
+        return l > r;
+      }
+      if ( *lhs.name != *rhs.name ) {
+        return *lhs.name < *rhs.name;
+      }
+      return lhs.offset < rhs.offset;
+    }
+  );
+
+  report << "Executed Instructions            : " << total << '\n'
+         << "Executed Symbols                 : " << symbols.size() << '\n'
+         << "Executed Basic Blocks            : " << blocks.size() << '\n'
+         << '\n';
+
+  report << "Most executed symbols" << '\n'
+         << "  Executed   Share   Instructions  Symbol" << '\n';
+
+  for ( size_t i = 0; i < symbols.size() && i < profileEntries; ++i ) {
+    const symbolProfile_t& profile = symbols[ i ];
+    double                 share = 100.0 * profile.executed / total;
+    size_t                 bar = (size_t) ( share * profileBarWidth / 100.0 );
+
+    report << std::setw( 10 ) << profile.executed << ' '
+           << std::fixed << std::setprecision( 2 ) << std::setw( 6 )
+           << share << "% " << std::setw( 14 ) << profile.instructions
+           << "  " << *profile.name << '\n'
+           << "                    |" << std::string( bar, '#' )
+           << std::string( profileBarWidth - bar, ' ' ) << "|" << '\n';
+  }
+
+  report << '\n' << "Most executed basic blocks" << '\n'
+         << "  Executed  Instructions  Block" << '\n';
+
+  for ( size_t i = 0; i < blocks.size() && i < profileEntries; ++i ) {
+    const blockProfile_t& block = blocks[ i ];
+
+    report << std::setw( 10 ) << block.count << ' '
+           << std::setw( 13 ) << block.size << "  " << *block.name
+           << "+0x" << std::hex << block.offset << std::dec << '\n';
+  }
+
+  report << '\n';
+
+  if ( !branchInfoAvailable ) {
+    report << "No branch information available" << '\n';
+  } else {
+    report << "Most executed branches" << '\n'
+           << "     Taken   Not Taken    Bias  Branch" << '\n';
+
+    for ( size_t i = 0; i < branches.size() && i < profileEntries; ++i ) {
+      const branchProfile_t& branch = branches[ i ];
+      double                 bias =
+        100.0 * branch.taken / ( (double) branch.taken + branch.notTaken );
+
+      report << std::setw( 10 ) << branch.taken << ' '
+             << std::setw( 11 ) << branch.notTaken << ' '
+             << std::fixed << std::setprecision( 2 ) << std::setw( 6 )
+             << bias << "%  " << *branch.name
+             << "+0x" << std::hex << branch.offset << std::dec << '\n';
+    }
+  }
+
+  CloseFile( report );
+}
+
+/*
+ * Add the size of a report file written to the report bytes counter.
+ */
+static void countReportBytes(
+  Coverage::Timings* timings,
+  const std::string& outputDirectory,
+  const std::string& symbolSetName,
+  const std::string& fileName
+)
+{
+  if ( timings ) {
+    std::string file;
+    struct stat sb;
+
+    rld::path::path_join( outputDirectory, symbolSetName, file );
+    rld::path::path_join( file, fileName, file );
+
+    if ( ::stat( file.c_str(), &sb ) == 0 ) {
+      timings->count( "report bytes", sb.st_size );
+    }
+  }
+}
+
+/*
+ * Name of the manifest of the reports of a symbol set.
+ */
+static const char* const reportManifest = "reports.manifest";
+
+/*
+ * Get the hash of the inputs of the reports of a symbol set. It is an
+ * FNV-1a hash of the report options, the statistics, ranges and
+ * explanations of the set's symbols, and the listing and coverage state
+ * of each instruction. The execution counts are only hashed if the
+ * profile or the HTML branch report, which shows the taken and not taken
+ * counts, is written. The explanations are looked up as the reports do
+ * so the explanations used are found even if the reports are skipped.
+ */
+static std::string reportInputsKey(
   const std::string&              symbolSetName,
   Coverage::Explanations&         allExplanations,
+  const std::string&              projectName,
+  const Coverage::DesiredSymbols& symbolsToAnalyze,
+  bool                            branchInfoAvailable,
+  bool                            profile,
+  bool                            json
+)
+{
+  uint64_t hash = 14695981039346656037ULL;
+
+  auto add = [&hash]( const void* data, size_t size ) {
+    const uint8_t* bytes = static_cast<const uint8_t*>( data );
+    for ( size_t b = 0; b < size; ++b ) {
+      hash ^= bytes[b];
+      hash *= 1099511628211ULL;
+    }
+  };
+  auto addString = [&add]( const std::string& text ) {
+    add( text.c_str(), text.size() + 1 );
+  };
+  auto addValue = [&add]( uint64_t value ) {
+    add( &value, sizeof( value ) );
+  };
+  auto addRanges = [&]( const CoverageRanges* ranges ) {
+    if ( ranges == NULL ) {
+      addValue( UINT64_MAX );
+      return;
+    }
+
+    addValue( ranges->set.size() );
+    for ( const auto& range : ranges->set ) {
+      addValue( range.id );
+      addValue( range.lowAddress );
+      addValue( range.highAddress );
+      addValue( range.instructionCount );
+      addValue( range.reason );
+      addString( range.lowSourceLine );
+      addString( range.highSourceLine );
+
+      const Explanation* explanation =
+        allExplanations.lookupExplanation( range.lowSourceLine );
+
+      if ( explanation == NULL ) {
+        addValue( 0 );
+      } else {
+        addValue( 1 );
+        addString( explanation->classification );
+        for ( const auto& line : explanation->explanation ) {
+          addString( line );
+        }
+        addValue( explanation->explanation.size() );
+      }
+    }
+  };
+
+  addString( symbolSetName );
+  addString( projectName );
+  addValue( branchInfoAvailable );
+  addValue( profile );
+  addValue( json );
+
+  const std::vector<std::string>& symbols =
+    symbolsToAnalyze.getSymbolsForSet( symbolSetName );
+
+  addValue( symbols.size() );
+  for ( const auto& symbol : symbols ) {
+    const SymbolInformation& info = symbolsToAnalyze.allSymbols().at( symbol );
+    const Statistics&        stats = info.stats;
+
+    addString( symbol );
+    addValue( info.baseAddress );
+    addValue( stats.branchesAlwaysTaken );
+    addValue( stats.branchesExecuted );
+    addValue( stats.branchesNeverTaken );
+    addValue( stats.branchesNotExecuted );
+    addValue( stats.sizeInBytes );
+    addValue( stats.sizeInBytesWithoutNops );
+    addValue( stats.sizeInInstructions );
+    addValue( stats.uncoveredBytes );
+    addValue( stats.uncoveredInstructions );
+    addValue( stats.uncoveredRanges );
+    addValue( stats.unreferencedSymbols );
+    addRanges( info.uncoveredRanges );
+    addRanges( info.uncoveredBranches );
+
+    const CoverageMapBase* theCoverageMap = info.unifiedCoverageMap;
+
+    addValue( info.instructions.size() );
+    for ( const auto& instruction : info.instructions ) {
+      addString( instruction.line );
+      addValue( instruction.address );
+      addValue( instruction.isInstruction );
+
+      if ( !instruction.isInstruction || theCoverageMap == NULL ) {
+        continue;
+      }
+
+      uint32_t a = instruction.address - info.baseAddress;
+
+      addValue( theCoverageMap->wasExecuted( a ) );
+      addValue( theCoverageMap->isBranch( a ) );
+      addValue( theCoverageMap->wasAlwaysTaken( a ) );
+      addValue( theCoverageMap->wasNeverTaken( a ) );
+
+      if ( profile || !json ) {
+        addValue( theCoverageMap->getWasExecuted( a ) );
+        addValue( theCoverageMap->getWasTaken( a ) );
+        addValue( theCoverageMap->getWasNotTaken( a ) );
+      }
+    }
+  }
+
+  std::ostringstream key;
+  key << "r-" << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hash;
+  return key.str();
+}
+
+/*
+ * Get the path of a file of the reports of a symbol set.
+ */
+static std::string reportPath(
+  const std::string& outputDirectory,
+  const std::string& symbolSetName,
+  const std::string& fileName
+)
+{
+  std::string file;
+
+  rld::path::path_join( outputDirectory, symbolSetName, file );
+  rld::path::path_join( file, fileName, file );
+  return file;
+}
+
+/*
+ * The reports of a symbol set are up to date if its manifest has the key
+ * and the index and summary it lists were written.
+ */
+static bool reportsUpToDate(
+  const std::string& outputDirectory,
+  const std::string& symbolSetName,
+  const std::string& key,
+  const std::string& indexName
+)
+{
+  std::ifstream manifest(
+    reportPath( outputDirectory, symbolSetName, reportManifest )
+  );
+  std::string   previous;
+
+  if ( !std::getline( manifest, previous ) || previous != key ) {
+    return false;
+  }
+
+  struct stat sb;
+
+  return
+    ::stat(
+      reportPath( outputDirectory, symbolSetName, indexName ).c_str(), &sb
+    ) == 0 &&
+    ::stat(
+      reportPath( outputDirectory, symbolSetName, "summary.txt" ).c_str(), &sb
+    ) == 0;
+}
+
+void GenerateReports(
+  const std::vector<std::string>& symbolSetNames,
+  Coverage::Explanations&         allExplanations,
   bool                            verbose,
   const std::string&              projectName,
   const std::string&              outputDirectory,
   const Coverage::DesiredSymbols& symbolsToAnalyze,
-  bool                            branchInfoAvailable
+  bool                            branchInfoAvailable,
+  int                             jobs,
+  Coverage::Timings*              timings,
+  bool                            profile,
+  bool                            json
 )
 {
   using reportList_ptr = std::unique_ptr<ReportsBase>;
   using reportList = std::vector<reportList_ptr>;
 
-  reportList             reports;
-  std::string            reportName;
-  time_t                 timestamp;
+  reportList               reports;
+  std::vector<std::string> reportSets;
+  time_t                   timestamp;
 
 
   timestamp = time( NULL ); /* get current cal time */
-  reports.emplace_back(
-    new ReportsText(
-      timestamp,
-      symbolSetName,
-      allExplanations,
-      projectName,
-      outputDirectory,
-      symbolsToAnalyze,
-      branchInfoAvailable
-    )
-  );
-  reports.emplace_back(
-    new ReportsHtml(
-      timestamp,
+
+  // The manifest of a set with changed inputs is removed before its
+  // reports are written so an interrupted run does not look up to date.
+  std::vector<std::string> setsToGenerate;
+  std::vector<std::string> setKeys;
+
+  for ( const auto& symbolSetName : symbolSetNames ) {
+    std::string key = reportInputsKey(
       symbolSetName,
       allExplanations,
       projectName,
-      outputDirectory,
       symbolsToAnalyze,
-      branchInfoAvailable
-    )
-  );
-
-  for ( auto& report: reports ) {
+      branchInfoAvailable,
+      profile,
+      json
+    );
+    std::string indexName = json ? "index.json" : "index.html";
 
-    reportName = "index" + report->ReportExtension();
-    if ( verbose ) {
-      std::cerr << "Generate " << reportName << std::endl;
+    if ( reportsUpToDate( outputDirectory, symbolSetName, key, indexName ) ) {
+      if ( verbose ) {
+        std::cerr << "Reports of " << symbolSetName << " are up to date"
+                  << std::endl;
+      }
+      if ( timings ) {
+        timings->count( "report sets up to date" );
+      }
+      continue;
     }
-    report->WriteIndex( reportName );
 
-    reportName = "annotated" + report->ReportExtension();
-    if ( verbose ) {
-      std::cerr << "Generate " << reportName << std::endl;
-    }
-    report->WriteAnnotatedReport( reportName );
+    ::remove(
+      reportPath( outputDirectory, symbolSetName, reportManifest ).c_str()
+    );
+    setsToGenerate.push_back( symbolSetName );
+    setKeys.push_back( key );
+  }
 
-    reportName = "branch" + report->ReportExtension();
-    if ( verbose ) {
-      std::cerr << "Generate " << reportName << std::endl;
+  // The reports are constructed here and not by the threads since the
+  // constructors are not reentrant.
+  for ( const auto& symbolSetName : setsToGenerate ) {
+    reportSets.push_back( symbolSetName );
+    reportSets.push_back( symbolSetName );
+    reports.emplace_back(
+      new ReportsText(
+        timestamp,
+        symbolSetName,
+        allExplanations,
+        projectName,
+        outputDirectory,
+        symbolsToAnalyze,
+        branchInfoAvailable
+      )
+    );
+    if ( json ) {
+      reports.emplace_back(
+        new ReportsJson(
+          timestamp,
+          symbolSetName,
+          allExplanations,
+          projectName,
+          outputDirectory,
+          symbolsToAnalyze,
+          branchInfoAvailable
+        )
+      );
+    } else {
+      reports.emplace_back(
+        new ReportsHtml(
+          timestamp,
+          symbolSetName,
+          allExplanations,
+          projectName,
+          outputDirectory,
+          symbolsToAnalyze,
+          branchInfoAvailable
+        )
+      );
     }
-    report->WriteBranchReport( reportName );
+  }
 
-    reportName = "uncovered" + report->ReportExtension();
-    if ( verbose ) {
-      std::cerr << "Generate " << reportName << std::endl;
-    }
-    report->WriteCoverageReport( reportName );
+  // Each report and each summary report is a task of its own. Every task
+  // writes only its own files and reads the shared symbols.
+  size_t     taskCount = reports.size() + setsToGenerate.size();
+  std::mutex outputLock;
+
+  rld::tasks::parallel_for(
+    taskCount,
+    std::max( jobs, 1 ),
+    [&]( size_t t ) {
+      if ( t >= reports.size() ) {
+        const std::string& symbolSetName =
+          setsToGenerate[ t - reports.size() ];
+        {
+          Timings::Scope timing( timings, "report summary.txt" );
+          ReportsBase::WriteSummaryReport(
+            "summary.txt",
+            symbolSetName,
+            outputDirectory,
+            symbolsToAnalyze,
+            branchInfoAvailable
+          );
+        }
+        countReportBytes(
+          timings, outputDirectory, symbolSetName, "summary.txt"
+        );
+        if ( profile ) {
+          {
+            Timings::Scope timing( timings, "report profile.txt" );
+            ReportsBase::WriteProfileReport(
+              "profile.txt",
+              symbolSetName,
+              outputDirectory,
+              symbolsToAnalyze,
+              branchInfoAvailable
+            );
+          }
+          countReportBytes(
+            timings, outputDirectory, symbolSetName, "profile.txt"
+          );
+        }
+        return;
+      }
 
-    reportName = "sizes" + report->ReportExtension();
-    if ( verbose ) {
-      std::cerr << "Generate " << reportName << std::endl;
-    }
-    report->WriteSizeReport( reportName );
+      ReportsBase& report = *reports[ t ];
 
-    reportName = "symbolSummary" + report->ReportExtension();
-    if ( verbose ) {
-      std::cerr << "Generate " << reportName << std::endl;
-    }
-    report->WriteSymbolSummaryReport( reportName, symbolsToAnalyze );
-  }
+      auto generate = [&](
+        const std::string&                                name,
+        const std::function<void ( const std::string& )>& write
+      ) {
+        std::string reportName = name + report.ReportExtension();
 
-  ReportsBase::WriteSummaryReport(
-    "summary.txt",
-    symbolSetName,
-    outputDirectory,
-    symbolsToAnalyze,
-    branchInfoAvailable
+        if ( verbose ) {
+          std::lock_guard<std::mutex> guard( outputLock );
+          std::cerr << "Generate " << reportName << std::endl;
+        }
+
+        {
+          Timings::Scope timing( timings, "report " + reportName );
+          write( reportName );
+        }
+        countReportBytes(
+          timings, outputDirectory, reportSets[ t ], reportName
+        );
+      };
+
+      generate( "index", [&]( const std::string& n ) {
+        report.WriteIndex( n );
+      } );
+      generate( "annotated", [&]( const std::string& n ) {
+        report.WriteAnnotatedReport( n );
+      } );
+      generate( "branch", [&]( const std::string& n ) {
+        report.WriteBranchReport( n );
+      } );
+      generate( "uncovered", [&]( const std::string& n ) {
+        report.WriteCoverageReport( n );
+      } );
+      generate( "sizes", [&]( const std::string& n ) {
+        report.WriteSizeReport( n );
+      } );
+      generate( "symbolSummary", [&]( const std::string& n ) {
+        report.WriteSymbolSummaryReport( n, symbolsToAnalyze );
+      } );
+    }
   );
+
+  for ( size_t s = 0; s < setsToGenerate.size(); ++s ) {
+    std::ofstream manifest(
+      reportPath( outputDirectory, setsToGenerate[ s ], reportManifest )
+    );
+
+    manifest << setKeys[ s ] << '\n';
+  }
 }
 
 }
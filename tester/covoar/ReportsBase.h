@@ -14,11 +14,43 @@
 #include <iostream>
 #include <fstream>
 #include <time.h>
+#include <vector>
 #include "DesiredSymbols.h"
 #include "Explanations.h"
 
 namespace Coverage {
 
+class Timings;
+
+/*!
+ *   This class is the output file stream of a report.  The reports
+ *   are written line by line, so the stream has a large buffer of its
+ *   own to write the file in big pieces.
+ */
+class ReportFile : public std::ofstream {
+
+  public:
+    ReportFile() : buffer( bufferSize )
+    {
+      // The buffer must be set before the file is opened.
+      rdbuf()->pubsetbuf( buffer.data(), buffer.size() );
+    }
+
+    /*!
+     *  The file is closed here since the buffer is destroyed before the
+     *  base class.
+     */
+    ~ReportFile()
+    {
+      close();
+    }
+
+  private:
+    static const size_t bufferSize = 1024 * 1024;
+
+    std::vector<char> buffer;
+};
+
 /*!
  *   This class contains the base information to create a report
  *   set.  The report set may be text based, html based or some
@@ -100,6 +132,22 @@ class ReportsBase {
       bool                            branchInfoAvailable
     );
 
+    /*!
+     *  This method produces a profile report of the execution counts of
+     *  the overall test run. It lists the most executed symbols with a
+     *  flame style bar of their share of the executed instructions, the
+     *  most executed basic blocks and the bias of the most executed
+     *  branches. A basic block is a run of instructions executed the
+     *  same number of times ending at a branch.
+     */
+    static void  WriteProfileReport(
+      const std::string&              fileName,
+      const std::string&              symbolSetName,
+      const std::string&              outputDirectory,
+      const Coverage::DesiredSymbols& symbolsToAnalyze,
+      bool                            branchInfoAvailable
+    );
+
     /*!
      *  This method returns the unique extension for the Report
      *  type.  If the extension is ".txt" files will be
@@ -288,7 +336,7 @@ class ReportsBase {
      *
      *  @param[in] aFile identifies the file to close
      */
-    void  CloseNoRangeFile( std::ofstream& aFile );
+    virtual void CloseNoRangeFile( std::ofstream& aFile );
 
     /*!
      *  This method puts any necessary footer information into
@@ -429,24 +477,35 @@ class ReportsBase {
 
 /*!
  *  This method iterates over all report set types and generates
- *  all reports.
+ *  all reports of the symbol sets. The reports are generated by
+ *  @a jobs threads. The reports of a symbol set are skipped if the hash
+ *  of their inputs is the one in the set's manifest of the previous run.
  *
- *  @param[in] symbolSetName is the name of the symbol set to report on.
+ *  @param[in] symbolSetNames are the names of the symbol sets to report on.
  *  @param[in] allExplanations is the explanations to report on.
  *  @param[in] verbose specifies whether to be verbose with output
  *  @param[in] projectName specifies the name of the project
  *  @param[in] outputDirectory specifies the directory for the output
  *  @param[in] symbolsToAnalyze the symbols to be analyzed
  *  @param[in] branchInfoAvailable tells if branch info is available
+ *  @param[in] jobs specifies the number of threads to use
+ *  @param[in] timings points to the timings of the reports or is NULL
+ *  @param[in] profile specifies if the profile report is generated
+ *  @param[in] json specifies if the JSON reports are generated instead of
+ *             the HTML reports
  */
 void GenerateReports(
-  const std::string&              symbolSetName,
+  const std::vector<std::string>& symbolSetNames,
   Coverage::Explanations&         allExplanations,
   bool                            verbose,
   const std::string&              projectName,
   const std::string&              outputDirectory,
   const Coverage::DesiredSymbols& symbolsToAnalyze,
-  bool                            branchInfoAvailable
+  bool                            branchInfoAvailable,
+  int                             jobs,
+  Coverage::Timings*              timings = NULL,
+  bool                            profile = false,
+  bool                            json = false
 );
 
 }
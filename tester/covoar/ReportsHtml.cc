@@ -51,7 +51,8 @@ namespace Coverage {
        symbolsToAnalyze,
        branchInfoAvailable
      ),
-     lastState_m( A_SOURCE )
+     lastState_m( A_SOURCE ),
+     dateTime_m( asctime( localtime( &timestamp ) ) )
   {
     reportExtension_m = ".html";
   }
@@ -62,32 +63,32 @@ namespace Coverage {
 
   void ReportsHtml::WriteIndex( const std::string& fileName )
   {
-    std::ofstream aFile;
+    ReportFile aFile;
     #define PRINT_ITEM( _t, _n ) \
        aFile << "<li>" \
              << _t << " (<a href=\"" \
              << _n << ".html\">html</a> or <a href=\"" \
-             << _n << ".txt\">text</a>)</li>" << std::endl;
+             << _n << ".txt\">text</a>)</li>" << '\n';
     #define PRINT_TEXT_ITEM( _t, _n ) \
        aFile << "<li>" \
              << _t << " (<a href=\"" \
-             << _n << "\">text</a>)</li>" << std::endl;
+             << _n << "\">text</a>)</li>" << '\n';
 
 
     // Open the file
     OpenFile( fileName, aFile );
 
-    aFile << "<title>Index</title>" << std::endl
+    aFile << "<title>Index</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "Coverage Analysis Reports</div>" << std::endl
+    aFile << "Coverage Analysis Reports</div>" << '\n'
           << "<div class =\"datetime\">"
-          <<  asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<ul>" << std::endl;
+          <<  dateTime_m << "</div>" << '\n'
+          << "<ul>" << '\n';
 
     PRINT_TEXT_ITEM( "Summary",                     "summary.txt" );
     PRINT_ITEM(      "Coverage Report",             "uncovered" );
@@ -97,9 +98,9 @@ namespace Coverage {
     PRINT_ITEM(      "Uncovered Range Size Report", "sizes" );
     PRINT_TEXT_ITEM( "Explanations Not Found",      "ExplanationsNotFound.txt" );
 
-    aFile << "</ul>" << std::endl
-          << "<!-- INSERT PROJECT SPECIFIC ITEMS HERE -->" << std::endl
-          << "</html>" << std::endl;
+    aFile << "</ul>" << '\n'
+          << "<!-- INSERT PROJECT SPECIFIC ITEMS HERE -->" << '\n'
+          << "</html>" << '\n';
 
     CloseFile( aFile );
 
@@ -121,15 +122,15 @@ namespace Coverage {
     );
 
     // Put Header information on the file
-    aFile << "<html>" << std::endl
+    aFile << "<html>" << '\n'
           << "<meta http-equiv=\"Content-Language\" content=\"English\" >"
-          << std::endl
+          << '\n'
           << "<meta http-equiv=\"Content-Type\" content=\"text/html; charset=us-ascii\" >"
-          << std::endl
+          << '\n'
           << "<link rel=\"stylesheet\" type=\"text/css\" href=\"../covoar.css\" media=\"screen\" >"
-          << std::endl
+          << '\n'
           << "<script type=\"text/javascript\" src=\"../table.js\"></script>"
-          << std::endl;
+          << '\n';
   }
 
   void ReportsHtml::OpenAnnotatedFile(
@@ -140,18 +141,18 @@ namespace Coverage {
     // Open the file
     OpenFile( fileName, aFile );
 
-    aFile << "<title>Annotated Report</title>" << std::endl
+    aFile << "<title>Annotated Report</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "Annotated Report</div>" << std::endl
+    aFile << "Annotated Report</div>" << '\n'
           << "<div class =\"datetime\">"
-          << asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<body>" << std::endl
-          << "<pre class=\"code\">" << std::endl;
+          << dateTime_m << "</div>" << '\n'
+          << "<body>" << '\n'
+          << "<pre class=\"code\">" << '\n';
   }
 
   void ReportsHtml::OpenBranchFile(
@@ -164,41 +165,41 @@ namespace Coverage {
     OpenFile( fileName, aFile );
 
     // Put header information into the file
-    aFile << "<title>Branch Report</title>" << std::endl
+    aFile << "<title>Branch Report</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "Branch Report</div>" << std::endl
+    aFile << "Branch Report</div>" << '\n'
           << "<div class =\"datetime\">"
-          << asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<body>" << std::endl
+          << dateTime_m << "</div>" << '\n'
+          << "<body>" << '\n'
           << "<table class=\"covoar table-autosort:0 table-autofilter table-stripeclass:covoar-tr-odd"
-          << TABLE_HEADER_CLASS << "\">" << std::endl
-          << "<thead>" << std::endl
-          << "<tr>" << std::endl
-          << "<th class=\"table-sortable:default\" align=\"left\">Symbol</th>" << std::endl
+          << TABLE_HEADER_CLASS << "\">" << '\n'
+          << "<thead>" << '\n'
+          << "<tr>" << '\n'
+          << "<th class=\"table-sortable:default\" align=\"left\">Symbol</th>" << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Line</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">File</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"left\">Size <br>Bytes</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Reason</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">Taken</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">Not Taken</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">Classification</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Explanation</th>"
-          << std::endl
-          << "</tr>" << std::endl
-          << "</thead>" << std::endl
-          << "<tbody>" << std::endl;
+          << '\n'
+          << "</tr>" << '\n'
+          << "</thead>" << '\n'
+          << "<tbody>" << '\n';
   }
 
   void  ReportsHtml::OpenCoverageFile(
@@ -210,38 +211,38 @@ namespace Coverage {
     OpenFile( fileName, aFile );
 
     // Put header information into the file
-    aFile << "<title>Coverage Report</title>" << std::endl
+    aFile << "<title>Coverage Report</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "Coverage Report</div>" << std::endl
+    aFile << "Coverage Report</div>" << '\n'
           << "<div class =\"datetime\">"
-          << asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<body>" << std::endl
+          << dateTime_m << "</div>" << '\n'
+          << "<body>" << '\n'
           << "<table class=\"covoar table-autosort:0 table-autofilter table-stripeclass:covoar-tr-odd"
-          << TABLE_HEADER_CLASS << "\">" << std::endl
-          << "<thead>" << std::endl
-          << "<tr>" << std::endl
+          << TABLE_HEADER_CLASS << "\">" << '\n'
+          << "<thead>" << '\n'
+          << "<tr>" << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Symbol</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Range</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">File</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"left\">Size <br>Bytes</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"left\">Size <br>Instructions</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">Classification</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Explanation</th>"
-          << std::endl
-          << "</tr>" << std::endl
-          << "</thead>" << std::endl
-          << "<tbody>" << std::endl;
+          << '\n'
+          << "</tr>" << '\n'
+          << "</thead>" << '\n'
+          << "<tbody>" << '\n';
   }
 
   void ReportsHtml::OpenNoRangeFile(
@@ -253,26 +254,26 @@ namespace Coverage {
     OpenFile( fileName, aFile );
 
     // Put header information into the file
-    aFile << "<title> Report</title>" << std::endl
+    aFile << "<title> Report</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "No Range Report</div>" << std::endl
+    aFile << "No Range Report</div>" << '\n'
           << "<div class =\"datetime\">"
-          << asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<body>" << std::endl
+          << dateTime_m << "</div>" << '\n'
+          << "<body>" << '\n'
           << "<table class=\"covoar table-autosort:0 table-autofilter table-stripeclass:covoar-tr-odd"
-          << TABLE_HEADER_CLASS << "\">" << std::endl
-          << "<thead>" << std::endl
-          << "<tr>" << std::endl
+          << TABLE_HEADER_CLASS << "\">" << '\n'
+          << "<thead>" << '\n'
+          << "<tr>" << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Symbol</th>"
-          << std::endl
-          << "</tr>" << std::endl
-          << "</thead>" << std::endl
-          << "<tbody>" << std::endl;
+          << '\n'
+          << "</tr>" << '\n'
+          << "</thead>" << '\n'
+          << "<tbody>" << '\n';
    }
 
 
@@ -286,32 +287,32 @@ namespace Coverage {
     OpenFile( fileName, aFile );
 
     // Put header information into the file
-    aFile << "<title>Uncovered Range Size Report</title>" << std::endl
+    aFile << "<title>Uncovered Range Size Report</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "Uncovered Range Size Report</div>" << std::endl
+    aFile << "Uncovered Range Size Report</div>" << '\n'
           << "<div class =\"datetime\">"
-          << asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<body>" << std::endl
+          << dateTime_m << "</div>" << '\n'
+          << "<body>" << '\n'
           << "<table class=\"covoar table-autosort:0 table-autofilter table-stripeclass:covoar-tr-odd"
-          << TABLE_HEADER_CLASS << "\">" << std::endl
-          << "<thead>" << std::endl
-          << "<tr>" << std::endl
+          << TABLE_HEADER_CLASS << "\">" << '\n'
+          << "<thead>" << '\n'
+          << "<tr>" << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"left\">Size</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Symbol</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:default\" align=\"left\">Line</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-filterable table-sortable:default\" align=\"left\">File</th>"
-          << std::endl
-          << "</tr>" << std::endl
-          << "</thead>" << std::endl
-          << "<tbody>" << std::endl;
+          << '\n'
+          << "</tr>" << '\n'
+          << "</thead>" << '\n'
+          << "<tbody>" << '\n';
   }
 
   void ReportsHtml::OpenSymbolSummaryFile(
@@ -323,51 +324,51 @@ namespace Coverage {
     OpenFile( fileName, aFile );
 
     // Put header information into the file
-    aFile << "<title>Symbol Summary Report</title>" << std::endl
+    aFile << "<title>Symbol Summary Report</title>" << '\n'
           << "<div class=\"heading-title\">";
 
     if ( !projectName_m.empty() ) {
       aFile << projectName_m << "<br>";
     }
 
-    aFile << "Symbol Summary Report</div>" << std::endl
+    aFile << "Symbol Summary Report</div>" << '\n'
           << "<div class =\"datetime\">"
-          << asctime( localtime( &timestamp_m ) ) << "</div>" << std::endl
-          << "<body>" << std::endl
+          << dateTime_m << "</div>" << '\n'
+          << "<body>" << '\n'
           << "<table class=\"covoar table-autosort:0 table-autofilter table-stripeclass:covoar-tr-odd"
-          << TABLE_HEADER_CLASS << "\">" << std::endl
-          << "<thead>" << std::endl
-          << "<tr>" << std::endl
+          << TABLE_HEADER_CLASS << "\">" << '\n'
+          << "<thead>" << '\n'
+          << "<tr>" << '\n'
           << "<th class=\"table-sortable:default\" align=\"center\">Symbol</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">Total<br>Size<br>Bytes</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">Total<br>Size<br>Instr</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">#<br>Ranges</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">Uncovered<br>Size<br>Bytes</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">Uncovered<br>Size<br>Instr</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">#<br>Branches</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">#<br>Always<br>Taken</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">#<br>Never<br>Taken</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">Percent<br>Uncovered<br>Instructions</th>"
-          << std::endl
+          << '\n'
           << "<th class=\"table-sortable:numeric\" align=\"center\">Percent<br>Uncovered<br>Bytes</th>"
-          << std::endl
-          << "</tr>" << std::endl
-          << "</thead>" << std::endl
-          << "<tbody>" << std::endl;
+          << '\n'
+          << "</tr>" << '\n'
+          << "</thead>" << '\n'
+          << "<tbody>" << '\n';
   }
 
   void ReportsHtml::AnnotatedStart( std::ofstream& aFile )
   {
-    aFile << "<hr>" << std::endl;
+    aFile << "<hr>" << '\n';
   }
 
   void ReportsHtml::AnnotatedEnd( std::ofstream& aFile )
@@ -435,7 +436,7 @@ namespace Coverage {
         aFile << line[i];
       }
     }
-    aFile << std::endl;
+    aFile << '\n';
   }
 
   bool ReportsHtml::PutNoBranchInfo( std::ofstream& report )
@@ -444,9 +445,9 @@ namespace Coverage {
       branchInfoAvailable_m &&
       symbolsToAnalyze_m.getNumberBranchesFound( symbolSetName_m ) != 0
     ) {
-      report << "All branch paths taken." << std::endl;
+      report << "All branch paths taken." << '\n';
     } else {
-      report << "No branch information found." << std::endl;
+      report << "No branch information found." << '\n';
     }
 
     return true;
@@ -471,27 +472,27 @@ namespace Coverage {
     if ( ( count % 2 ) != 0 ) {
       report << "<tr class=\"covoar-tr-odd\">\n";
     } else {
-      report << "<tr>" << std::endl;
+      report << "<tr>" << '\n';
     }
 
     // symbol
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << symbolName << "</td>" << std::endl;
+           << symbolName << "</td>" << '\n';
 
     // line
     report << "<td class=\"covoar-td\" align=\"center\"><a href =\"annotated.html#range"
            << range.id << "\">"
-           << range.lowSourceLine << "</td>" << std::endl;
+           << range.lowSourceLine << "</td>" << '\n';
 
     // File
     i = range.lowSourceLine.find( ":" );
     temp = range.lowSourceLine.substr( 0, i );
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << temp << "</td>" << std::endl;
+           << temp << "</td>" << '\n';
 
     // Size in bytes
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << range.highAddress - range.lowAddress + 1 << "</td>" << std::endl;
+           << range.highAddress - range.lowAddress + 1 << "</td>" << '\n';
 
     // Reason Branch was uncovered
     if (
@@ -499,13 +500,13 @@ namespace Coverage {
       Coverage::CoverageRanges::UNCOVERED_REASON_BRANCH_ALWAYS_TAKEN
     ) {
       report << "<td class=\"covoar-td\" align=\"center\">Always Taken</td>"
-             << std::endl;
+             << '\n';
     } else if (
       range.reason ==
       Coverage::CoverageRanges::UNCOVERED_REASON_BRANCH_NEVER_TAKEN
     ) {
       report << "<td class=\"covoar-td\" align=\"center\">Never Taken</td>"
-             << std::endl;
+             << '\n';
     }
 
     // Taken / Not taken counts
@@ -515,10 +516,10 @@ namespace Coverage {
 
     report << "<td class=\"covoar-td\" align=\"center\">"
            << theCoverageMap->getWasTaken( lowAddress - bAddress )
-           << "</td>" << std::endl
+           << "</td>" << '\n'
            << "<td class=\"covoar-td\" align=\"center\">"
            << theCoverageMap->getWasNotTaken( lowAddress - bAddress )
-           << "</td>" << std::endl;
+           << "</td>" << '\n';
 
     // See if an explanation is available and write the Classification and
     // the Explination Columns.
@@ -526,23 +527,23 @@ namespace Coverage {
     if ( !explanation ) {
       // Write Classificationditr->second.baseAddress
       report << "<td class=\"covoar-td\" align=\"center\">NONE</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">No Explanation</td>"
-             << std::endl;
+             << '\n';
     } else {
       std::stringstream explanationFile( "explanation" );
       explanationFile << range.id << ".html";
 
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << explanation->classification << "</td>" << std::endl
+             << explanation->classification << "</td>" << '\n'
              << "<td class=\"covoar-td\" align=\"center\">"
              << "<a href=\"" << explanationFile.str()
-             << "\">Explanation</a></td>" << std::endl;
+             << "\">Explanation</a></td>" << '\n';
 
       WriteExplanationFile( explanationFile.str(), explanation );
     }
 
-    report << "</tr>" << std::endl;
+    report << "</tr>" << '\n';
 
     return true;
   }
@@ -552,12 +553,12 @@ namespace Coverage {
     const Coverage::Explanation* explanation
   )
   {
-    std::ofstream report;
+    ReportFile report;
 
     OpenFile( fileName, report );
 
     for ( unsigned int i=0 ; i < explanation->explanation.size(); i++ ) {
-      report << explanation->explanation[i] << std::endl;
+      report << explanation->explanation[i] << '\n';
     }
     CloseFile( report );
     return true;
@@ -583,46 +584,46 @@ namespace Coverage {
 
     // Mark the background color different for odd and even lines.
     if ( ( count % 2 ) != 0 ) {
-      report << "<tr class=\"covoar-tr-odd\">" << std::endl;
-      noRangeFile << "<tr class=\"covoar-tr-odd\">" << std::endl;
+      report << "<tr class=\"covoar-tr-odd\">" << '\n';
+      noRangeFile << "<tr class=\"covoar-tr-odd\">" << '\n';
     } else {
-      report << "<tr>" << std::endl;
-      noRangeFile << "<tr>" << std::endl;
+      report << "<tr>" << '\n';
+      noRangeFile << "<tr>" << '\n';
     }
 
     // symbol
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << symbol << "</td>" << std::endl;
+           << symbol << "</td>" << '\n';
     noRangeFile << "<td class=\"covoar-td\" align=\"center\">"
-                << symbol << "</td>" << std::endl;
+                << symbol << "</td>" << '\n';
 
     // starting line
     report << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-           << std::endl;
+           << '\n';
 
     // file
     report << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-           << std::endl;
+           << '\n';
 
      // Size in bytes
     report << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-           << std::endl;
+           << '\n';
 
     // Size in instructions
     report << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-           << std::endl;
+           << '\n';
 
     // See if an explanation is available
     report << "<td class=\"covoar-td\" align=\"center\">Unknown</td>"
-           << std::endl
+           << '\n'
            << "<td class=\"covoar-td\" align=\"center\">"
            << "<a href=\"NotReferenced.html\">No data</a></td>"
-           << std::endl;
+           << '\n';
 
     WriteExplanationFile( "NotReferenced.html", &explanation );
 
-    report << "</tr>" << std::endl;
-    noRangeFile << "</tr>" << std::endl;
+    report << "</tr>" << '\n';
+    noRangeFile << "</tr>" << '\n';
   }
 
   bool ReportsHtml::PutCoverageLine(
@@ -639,59 +640,59 @@ namespace Coverage {
 
     // Mark the background color different for odd and even lines.
     if ( ( count % 2) != 0 ) {
-      report << "<tr class=\"covoar-tr-odd\">" << std::endl;
+      report << "<tr class=\"covoar-tr-odd\">" << '\n';
     } else {
-      report << "<tr>" << std::endl;
+      report << "<tr>" << '\n';
     }
 
     // symbol
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << symbolName << "</td>" << std::endl;
+           << symbolName << "</td>" << '\n';
 
     // Range
     report << "<td class=\"covoar-td\" align=\"center\"><a href =\"annotated.html#range"
            << range.id << "\">"
            << range.lowSourceLine << " <br>"
-           << range.highSourceLine << "</td>" << std::endl;
+           << range.highSourceLine << "</td>" << '\n';
 
     // File
     i = range.lowSourceLine.find( ":" );
     temp = range.lowSourceLine.substr( 0, i );
 
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << temp << "</td>" << std::endl;
+           << temp << "</td>" << '\n';
 
     // Size in bytes
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << range.highAddress - range.lowAddress + 1 << "</td>" << std::endl;
+           << range.highAddress - range.lowAddress + 1 << "</td>" << '\n';
 
     // Size in instructions
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << range.instructionCount << "</td>" << std::endl;
+           << range.instructionCount << "</td>" << '\n';
 
     // See if an explanation is available
     explanation = allExplanations_m.lookupExplanation( range.lowSourceLine );
     if ( !explanation ) {
       report << "<td class=\"covoar-td\" align=\"center\">NONE</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">No Explanation</td>"
-             << std::endl;
+             << '\n';
     } else {
       std::stringstream explanationFile( "explanation" );
 
       explanationFile << range.id << ".html";
 
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << explanation->classification << "</td>" << std::endl
+             << explanation->classification << "</td>" << '\n'
              << "<td class=\"covoar-td\" align=\"center\">"
              << "<a href=\""
              << explanationFile.str() << "\">Explanation</a></td>"
-             << std::endl;
+             << '\n';
 
       WriteExplanationFile( explanationFile.str(), explanation );
     }
 
-    report << "</tr>" << std::endl;
+    report << "</tr>" << '\n';
 
     return true;
   }
@@ -708,30 +709,30 @@ namespace Coverage {
 
     // Mark the background color different for odd and even lines.
     if ( ( count % 2 ) != 0 ) {
-      report << "<tr class=\"covoar-tr-odd\">" << std::endl;
+      report << "<tr class=\"covoar-tr-odd\">" << '\n';
     } else {
-      report << "<tr>" << std::endl;
+      report << "<tr>" << '\n';
     }
 
     // size
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << range.highAddress - range.lowAddress + 1 << "</td>" << std::endl;
+           << range.highAddress - range.lowAddress + 1 << "</td>" << '\n';
 
     // symbol
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << symbolName << "</td>" << std::endl;
+           << symbolName << "</td>" << '\n';
 
     // line
     report << "<td class=\"covoar-td\" align=\"center\"><a href =\"annotated.html#range"
            << range.id << "\">"
-           << range.lowSourceLine << "</td>" << std::endl;
+           << range.lowSourceLine << "</td>" << '\n';
 
     // File
     i = range.lowSourceLine.find( ":" );
     temp =  range.lowSourceLine.substr( 0, i );
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << temp << "</td>" << std::endl
-           << "</tr>" << std::endl;
+           << temp << "</td>" << '\n'
+           << "</tr>" << '\n';
 
     return true;
   }
@@ -747,106 +748,106 @@ namespace Coverage {
 
     // Mark the background color different for odd and even lines.
     if ( ( count % 2 ) != 0 ) {
-      report << "<tr class=\"covoar-tr-odd\">" << std::endl;
+      report << "<tr class=\"covoar-tr-odd\">" << '\n';
     } else {
-      report << "<tr>" << std::endl;
+      report << "<tr>" << '\n';
     }
 
     // symbol
     report << "<td class=\"covoar-td\" align=\"center\">"
-           << symbolName << "</td>" << std::endl;
+           << symbolName << "</td>" << '\n';
 
     if ( symbolInfo.stats.sizeInBytes == 0 ) {
       // The symbol has never been seen. Write "unknown" for all columns.
       report << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl
+             << '\n'
              << "<td class=\"covoar-td\" align=\"center\">unknown</td>"
-             << std::endl;
+             << '\n';
     } else {
       // Total Size in Bytes
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.sizeInBytes << "</td>" << std::endl;
+             << symbolInfo.stats.sizeInBytes << "</td>" << '\n';
 
       // Total Size in Instructions
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.sizeInInstructions << "</td>" << std::endl;
+             << symbolInfo.stats.sizeInInstructions << "</td>" << '\n';
 
       // Total Uncovered Ranges
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.uncoveredRanges << "</td>" << std::endl;
+             << symbolInfo.stats.uncoveredRanges << "</td>" << '\n';
 
       // Uncovered Size in Bytes
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.uncoveredBytes << "</td>" << std::endl;
+             << symbolInfo.stats.uncoveredBytes << "</td>" << '\n';
 
       // Uncovered Size in Instructions
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.uncoveredInstructions << "</td>" << std::endl;
+             << symbolInfo.stats.uncoveredInstructions << "</td>" << '\n';
 
       // Total number of branches
       report << "<td class=\"covoar-td\" align=\"center\">"
              << symbolInfo.stats.branchesNotExecuted +
                 symbolInfo.stats.branchesExecuted
-             << "</td>" << std::endl;
+             << "</td>" << '\n';
 
       // Total Always Taken
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.branchesAlwaysTaken << "</td>" << std::endl;
+             << symbolInfo.stats.branchesAlwaysTaken << "</td>" << '\n';
 
       // Total Never Taken
       report << "<td class=\"covoar-td\" align=\"center\">"
-             << symbolInfo.stats.branchesNeverTaken << "</td>" << std::endl;
+             << symbolInfo.stats.branchesNeverTaken << "</td>" << '\n';
 
       // % Uncovered Instructions
       if ( symbolInfo.stats.sizeInInstructions == 0 ) {
         report << "<td class=\"covoar-td\" align=\"center\">100.00</td>"
-               << std::endl;
+               << '\n';
       } else {
         report << "<td class=\"covoar-td\" align=\"center\">"
                << std::fixed << std::setprecision( 2 )
                << ( symbolInfo.stats.uncoveredInstructions * 100.0 ) /
                     symbolInfo.stats.sizeInInstructions
-               << "</td>" << std::endl;
+               << "</td>" << '\n';
       }
 
       // % Uncovered Bytes
       if ( symbolInfo.stats.sizeInBytes == 0 ) {
         report << "<td class=\"covoar-td\" align=\"center\">100.00</td>"
-               << std::endl;
+               << '\n';
       } else {
         report << "<td class=\"covoar-td\" align=\"center\">"
                << ( symbolInfo.stats.uncoveredBytes * 100.0 ) /
                     symbolInfo.stats.sizeInBytes
-               << "</td>" << std::endl;
+               << "</td>" << '\n';
       }
     }
 
-    report << "</tr>" << std::endl;
+    report << "</tr>" << '\n';
 
     return true;
   }
 
   void ReportsHtml::CloseAnnotatedFile( std::ofstream& aFile )
   {
-    aFile << "</pre>"  << std::endl
-          << "</body>" << std::endl
-          << "</html>" << std::endl;
+    aFile << "</pre>"  << '\n'
+          << "</body>" << '\n'
+          << "</html>" << '\n';
 
     CloseFile( aFile );
   }
@@ -854,8 +855,8 @@ namespace Coverage {
   void ReportsHtml::CloseBranchFile( std::ofstream& aFile, bool hasBranches )
   {
     aFile << TABLE_FOOTER
-          << "</tbody>" << std::endl
-          << "</table>" << std::endl;
+          << "</tbody>" << '\n'
+          << "</table>" << '\n';
 
     CloseFile( aFile );
   }
@@ -863,10 +864,10 @@ namespace Coverage {
   void ReportsHtml::CloseCoverageFile( std::ofstream& aFile )
   {
     aFile << TABLE_FOOTER
-          << "</tbody>" << std::endl
-          << "</table>" << std::endl
-          << "</pre>"   << std::endl
-          << "</body>"  << std::endl
+          << "</tbody>" << '\n'
+          << "</table>" << '\n'
+          << "</pre>"   << '\n'
+          << "</body>"  << '\n'
           << "</html>";
 
     CloseFile( aFile );
@@ -875,10 +876,10 @@ namespace Coverage {
   void ReportsHtml::CloseNoRangeFile( std::ofstream& aFile )
   {
     aFile << TABLE_FOOTER
-          << "</tbody>" << std::endl
-          << "</table>" << std::endl
-          << "</pre>"   << std::endl
-          << "</body>"  << std::endl
+          << "</tbody>" << '\n'
+          << "</table>" << '\n'
+          << "</pre>"   << '\n'
+          << "</body>"  << '\n'
           << "</html>";
 
     CloseFile( aFile );
@@ -888,10 +889,10 @@ namespace Coverage {
   void ReportsHtml::CloseSizeFile( std::ofstream& aFile )
   {
     aFile << TABLE_FOOTER
-          << "</tbody>" << std::endl
-          << "</table>" << std::endl
-          << "</pre>"   << std::endl
-          << "</body>"  << std::endl
+          << "</tbody>" << '\n'
+          << "</table>" << '\n'
+          << "</pre>"   << '\n'
+          << "</body>"  << '\n'
           << "</html>";
 
     CloseFile( aFile );
@@ -900,10 +901,10 @@ namespace Coverage {
   void ReportsHtml::CloseSymbolSummaryFile( std::ofstream& aFile )
   {
     aFile << TABLE_FOOTER
-          << "</tbody>" << std::endl
-          << "</table>" << std::endl
-          << "</pre>"   << std::endl
-          << "</body>"  << std::endl
+          << "</tbody>" << '\n'
+          << "</table>" << '\n'
+          << "</pre>"   << '\n'
+          << "</body>"  << '\n'
           << "</html>";
 
      CloseFile( aFile );
@@ -77,6 +77,13 @@ class ReportsHtml: public ReportsBase {
      */
     AnnotatedLineState_t lastState_m;
 
+    /*!
+     *  This variable contains the formatted time stamp of the reports.
+     *  It is formatted once by the constructor since asctime() and
+     *  localtime() are not reentrant.
+     */
+    std::string dateTime_m;
+
     /* Inherit documentation from base class. */
     virtual void  OpenAnnotatedFile(
       const std::string& fileName,
@@ -0,0 +1,488 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <iomanip>
+#include <sstream>
+
+#include "ReportsJson.h"
+#include "CoverageRanges.h"
+#include "DesiredSymbols.h"
+#include "Explanations.h"
+#include "ObjdumpProcessor.h"
+
+#include <rld.h>
+#include <rtems-utils.h>
+
+namespace Coverage {
+
+ReportsJson::ReportsJson(
+  time_t                  timestamp,
+  const std::string&      symbolSetName,
+  Coverage::Explanations& allExplanations,
+  const std::string&      projectName,
+  const std::string&      outputDirectory,
+  const DesiredSymbols&   symbolsToAnalyze,
+  bool                    branchInfoAvailable
+): ReportsBase(
+     timestamp,
+     symbolSetName,
+     allExplanations,
+     projectName,
+     outputDirectory,
+     symbolsToAnalyze,
+     branchInfoAvailable
+   ),
+   firstRow_m( true ),
+   firstNoRange_m( true ),
+   shardNumber_m( 0 ),
+   shardLines_m( 0 )
+{
+  reportExtension_m = ".json";
+}
+
+ReportsJson::~ReportsJson()
+{
+}
+
+void ReportsJson::PutString( std::ostream& aFile, const std::string& text )
+{
+  rtems::utils::ostream_guard oldState( aFile );
+
+  aFile << '"';
+
+  for ( char c : text ) {
+    switch ( c ) {
+      case '"':
+        aFile << "\\\"";
+        break;
+      case '\\':
+        aFile << "\\\\";
+        break;
+      case '\n':
+        aFile << "\\n";
+        break;
+      case '\t':
+        aFile << "\\t";
+        break;
+      default:
+        if ( static_cast<unsigned char>( c ) < 0x20 ) {
+          aFile << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' )
+                << static_cast<int>( c ) << std::dec << std::setfill( ' ' );
+        } else {
+          aFile << c;
+        }
+        break;
+    }
+  }
+
+  aFile << '"';
+}
+
+void ReportsJson::PutRowStart( std::ofstream& aFile, bool& first )
+{
+  aFile << ( first ? "\n" : ",\n" );
+  first = false;
+}
+
+void ReportsJson::WriteIndex( const std::string& fileName )
+{
+  #define PRINT_ITEM( _t, _n ) \
+     aFile << ( first ? "\n" : ",\n" ) << "  { \"title\": \"" << _t \
+           << "\", \"file\": \"" << _n << reportExtension_m << "\" }"; \
+     first = false
+
+  ReportFile aFile;
+  ReportFile page;
+  char       timeBuffer[ 64 ];
+  bool       first = true;
+
+  ::strftime(
+    timeBuffer,
+    sizeof( timeBuffer ),
+    "%Y-%m-%d %H:%M:%S",
+    ::localtime( &timestamp_m )
+  );
+
+  OpenFile( fileName, symbolSetName_m, aFile, outputDirectory_m );
+  if ( !aFile.is_open() ) {
+    return;
+  }
+
+  aFile << "{\n\"project\": ";
+  PutString( aFile, projectName_m );
+  aFile << ",\n\"symbolSet\": ";
+  PutString( aFile, symbolSetName_m );
+  aFile << ",\n\"datetime\": ";
+  PutString( aFile, timeBuffer );
+  aFile << ",\n\"branchInfo\": "
+        << ( branchInfoAvailable_m &&
+             symbolsToAnalyze_m.getNumberBranchesFound( symbolSetName_m ) != 0
+             ? "true" : "false" )
+        << ",\n\"reports\": [";
+
+  // The summary is only written as text.
+  aFile << "\n  { \"title\": \"Summary\", \"file\": \"summary.txt\" }";
+  first = false;
+
+  PRINT_ITEM( "Coverage Report",       "uncovered" );
+  PRINT_ITEM( "Branch Report",         "branch" );
+  PRINT_ITEM( "Annotated Assembly",    "annotated" );
+  PRINT_ITEM( "Symbol Summary",        "symbolSummary" );
+  PRINT_ITEM( "Uncovered Range Size",  "sizes" );
+
+  aFile << "\n]\n}\n";
+
+  CloseFile( aFile );
+
+  #undef PRINT_ITEM
+
+  //
+  // The page is static, the script loads the data.
+  //
+  OpenFile( "report.html", symbolSetName_m, page, outputDirectory_m );
+  if ( !page.is_open() ) {
+    return;
+  }
+
+  page << "<!DOCTYPE html>\n"
+       << "<html>\n"
+       << "<head>\n"
+       << "<meta charset=\"utf-8\">\n"
+       << "<title>Coverage Report</title>\n"
+       << "<link rel=\"stylesheet\" type=\"text/css\""
+       << " href=\"../covoar.css\" media=\"screen\">\n"
+       << "<script type=\"text/javascript\" src=\"../covoar-report.js\">"
+       << "</script>\n"
+       << "</head>\n"
+       << "<body onload=\"covoarReport( 'index" << reportExtension_m
+       << "' )\">\n"
+       << "<div id=\"covoar-report\"></div>\n"
+       << "</body>\n"
+       << "</html>\n";
+
+  CloseFile( page );
+}
+
+void ReportsJson::OpenAnnotatedFile(
+  const std::string& fileName,
+  std::ofstream&     aFile
+)
+{
+  ReportsBase::OpenAnnotatedFile( fileName, aFile );
+  aFile << '[';
+  firstRow_m = true;
+  shardNumber_m = 0;
+}
+
+void ReportsJson::OpenBranchFile(
+  const std::string& fileName,
+  bool               hasBranches,
+  std::ofstream&     aFile
+)
+{
+  ReportsBase::OpenBranchFile( fileName, hasBranches, aFile );
+  aFile << '[';
+  firstRow_m = true;
+}
+
+void ReportsJson::OpenCoverageFile(
+  const std::string& fileName,
+  std::ofstream&     aFile
+)
+{
+  ReportsBase::OpenCoverageFile( fileName, aFile );
+  aFile << '[';
+  firstRow_m = true;
+}
+
+void ReportsJson::OpenNoRangeFile(
+  const std::string& fileName,
+  std::ofstream&     aFile
+)
+{
+  ReportsBase::OpenNoRangeFile( fileName, aFile );
+  aFile << '[';
+  firstNoRange_m = true;
+}
+
+void ReportsJson::OpenSizeFile(
+  const std::string& fileName,
+  std::ofstream&     aFile
+)
+{
+  ReportsBase::OpenSizeFile( fileName, aFile );
+  aFile << '[';
+  firstRow_m = true;
+}
+
+void ReportsJson::OpenSymbolSummaryFile(
+  const std::string& fileName,
+  std::ofstream&     aFile
+)
+{
+  ReportsBase::OpenSymbolSummaryFile( fileName, aFile );
+  aFile << '[';
+  firstRow_m = true;
+}
+
+void ReportsJson::CloseAnnotatedFile( std::ofstream& aFile )
+{
+  aFile << "\n]\n";
+  CloseFile( aFile );
+}
+
+void ReportsJson::CloseBranchFile( std::ofstream& aFile, bool hasBranches )
+{
+  aFile << "\n]\n";
+  CloseFile( aFile );
+}
+
+void ReportsJson::CloseCoverageFile( std::ofstream& aFile )
+{
+  aFile << "\n]\n";
+  CloseFile( aFile );
+}
+
+void ReportsJson::CloseNoRangeFile( std::ofstream& aFile )
+{
+  aFile << "\n]\n";
+  CloseFile( aFile );
+}
+
+void ReportsJson::CloseSizeFile( std::ofstream& aFile )
+{
+  aFile << "\n]\n";
+  CloseFile( aFile );
+}
+
+void ReportsJson::CloseSymbolSummaryFile( std::ofstream& aFile )
+{
+  aFile << "\n]\n";
+  CloseFile( aFile );
+}
+
+void ReportsJson::AnnotatedStart( std::ofstream& aFile )
+{
+  std::ostringstream name;
+
+  name << "annotated-" << shardNumber_m << reportExtension_m;
+
+  OpenFile( name.str(), symbolSetName_m, shard_m, outputDirectory_m );
+  if ( !shard_m.is_open() ) {
+    throw rld::error(
+      "Unable to open " + name.str(),
+      "ReportsJson::AnnotatedStart"
+    );
+  }
+
+  shard_m << '[';
+  shardTitle_m.clear();
+  shardLines_m = 0;
+}
+
+void ReportsJson::AnnotatedEnd( std::ofstream& aFile )
+{
+  shard_m << "\n]\n";
+  CloseFile( shard_m );
+
+  // The index has the first line of the listing, the symbol's label.
+  PutRowStart( aFile, firstRow_m );
+  aFile << "{ \"title\": ";
+  PutString( aFile, shardTitle_m );
+  aFile << ", \"shard\": \"annotated-" << shardNumber_m << reportExtension_m
+        << "\", \"lines\": " << shardLines_m << " }";
+
+  ++shardNumber_m;
+}
+
+void ReportsJson::PutAnnotatedLine(
+  std::ofstream&       aFile,
+  AnnotatedLineState_t state,
+  const std::string&   line,
+  uint32_t             id
+)
+{
+  // The line is padded for the annotation of the text report.
+  size_t end = line.find_last_not_of( ' ' );
+  std::string text = end == std::string::npos ? "" : line.substr( 0, end + 1 );
+
+  if ( shardTitle_m.empty() ) {
+    shardTitle_m = text;
+  }
+
+  shard_m << ( shardLines_m == 0 ? "\n[" : ",\n[" )
+          << static_cast<int>( state ) << ',' << id << ',';
+  PutString( shard_m, text );
+  shard_m << ']';
+
+  ++shardLines_m;
+}
+
+bool ReportsJson::PutNoBranchInfo( std::ofstream& report )
+{
+  return true;
+}
+
+void ReportsJson::PutExplanation(
+  std::ofstream&                         report,
+  const CoverageRanges::coverageRange_t& range
+)
+{
+  const Coverage::Explanation* explanation;
+
+  explanation = allExplanations_m.lookupExplanation( range.lowSourceLine );
+
+  report << ", \"classification\": ";
+
+  if ( !explanation ) {
+    report << "\"NONE\", \"explanation\": \"No Explanation\"";
+  } else {
+    std::string text;
+
+    for ( unsigned int i = 0; i < explanation->explanation.size(); i++ ) {
+      text += explanation->explanation[i] + '\n';
+    }
+
+    PutString( report, explanation->classification );
+    report << ", \"explanation\": ";
+    PutString( report, text );
+  }
+}
+
+bool ReportsJson::PutBranchEntry(
+  std::ofstream&                         report,
+  unsigned int                           number,
+  const std::string&                     symbolName,
+  const SymbolInformation&               symbolInfo,
+  const CoverageRanges::coverageRange_t& range
+)
+{
+  const char* reason = "";
+
+  if (
+    range.reason ==
+    Coverage::CoverageRanges::UNCOVERED_REASON_BRANCH_ALWAYS_TAKEN
+  ) {
+    reason = "ALWAYS TAKEN";
+  } else if (
+    range.reason ==
+    Coverage::CoverageRanges::UNCOVERED_REASON_BRANCH_NEVER_TAKEN
+  ) {
+    reason = "NEVER TAKEN";
+  }
+
+  PutRowStart( report, firstRow_m );
+  report << "{ \"index\": " << range.id << ", \"symbol\": ";
+  PutString( report, symbolName );
+  report << ", \"line\": ";
+  PutString( report, range.lowSourceLine );
+  report << ", \"address\": " << range.lowAddress
+         << ", \"bytes\": " << range.highAddress - range.lowAddress + 1
+         << ", \"reason\": \"" << reason << '"';
+  PutExplanation( report, range );
+  report << " }";
+
+  return true;
+}
+
+void ReportsJson::putCoverageNoRange(
+  std::ofstream&     report,
+  std::ofstream&     noRangeFile,
+  unsigned int       number,
+  const std::string& symbol
+)
+{
+  PutRowStart( report, firstRow_m );
+  report << "{ \"symbol\": ";
+  PutString( report, symbol );
+  report << ", \"referenced\": false }";
+
+  PutRowStart( noRangeFile, firstNoRange_m );
+  PutString( noRangeFile, symbol );
+}
+
+bool ReportsJson::PutCoverageLine(
+  std::ofstream&                         report,
+  unsigned int                           number,
+  const std::string&                     symbolName,
+  const SymbolInformation&               symbolInfo,
+  const CoverageRanges::coverageRange_t& range
+)
+{
+  PutRowStart( report, firstRow_m );
+  report << "{ \"index\": " << range.id << ", \"symbol\": ";
+  PutString( report, symbolName );
+  report << ", \"lowLine\": ";
+  PutString( report, range.lowSourceLine );
+  report << ", \"lowAddress\": " << range.lowAddress << ", \"highLine\": ";
+  PutString( report, range.highSourceLine );
+  report << ", \"highAddress\": " << range.highAddress
+         << ", \"bytes\": " << range.highAddress - range.lowAddress + 1
+         << ", \"instructions\": " << range.instructionCount;
+  PutExplanation( report, range );
+  report << " }";
+
+  return true;
+}
+
+bool ReportsJson::PutSizeLine(
+  std::ofstream&                         report,
+  unsigned int                           number,
+  const std::string&                     symbolName,
+  const CoverageRanges::coverageRange_t& range
+)
+{
+  PutRowStart( report, firstRow_m );
+  report << "{ \"bytes\": " << range.highAddress - range.lowAddress + 1
+         << ", \"symbol\": ";
+  PutString( report, symbolName );
+  report << ", \"line\": ";
+  PutString( report, range.lowSourceLine );
+  report << " }";
+
+  return true;
+}
+
+bool ReportsJson::PutSymbolSummaryLine(
+  std::ofstream&           report,
+  unsigned int             number,
+  const std::string&       symbolName,
+  const SymbolInformation& symbolInfo
+)
+{
+  rtems::utils::ostream_guard oldState( report );
+
+  PutRowStart( report, firstRow_m );
+  report << "{ \"symbol\": ";
+  PutString( report, symbolName );
+
+  if ( symbolInfo.stats.sizeInBytes == 0 ) {
+    report << ", \"referenced\": false }";
+    return true;
+  }
+
+  double uncoveredInstructions = 0;
+  double uncoveredBytes =
+    ( symbolInfo.stats.uncoveredBytes * 100.0 ) / symbolInfo.stats.sizeInBytes;
+
+  if ( symbolInfo.stats.sizeInInstructions != 0 ) {
+    uncoveredInstructions =
+      ( symbolInfo.stats.uncoveredInstructions * 100.0 ) /
+      symbolInfo.stats.sizeInInstructions;
+  }
+
+  report << ", \"bytes\": " << symbolInfo.stats.sizeInBytes
+         << ", \"instructions\": " << symbolInfo.stats.sizeInInstructions
+         << ", \"branches\": "
+         << symbolInfo.stats.branchesNotExecuted +
+            symbolInfo.stats.branchesExecuted
+         << ", \"alwaysTaken\": " << symbolInfo.stats.branchesAlwaysTaken
+         << ", \"neverTaken\": " << symbolInfo.stats.branchesNeverTaken
+         << std::fixed << std::setprecision( 2 )
+         << ", \"uncoveredInstructions\": " << uncoveredInstructions
+         << ", \"uncoveredBytes\": " << uncoveredBytes << " }";
+
+  return true;
+}
+
+}
@@ -0,0 +1,209 @@
+/*! @file ReportsJson.h
+ *  @brief Reports JSON Format Write Specification
+ *
+ *  This file contains the specification of the Reports methods.  This
+ *  collection of methods is used to generate the various reports of
+ *  the analysis results as JSON data read by a small HTML page.
+ */
+
+#ifndef __REPORTSJSON_H__
+#define __REPORTSJSON_H__
+
+#include <stdint.h>
+#include "ReportsBase.h"
+
+namespace Coverage {
+
+/*!
+ *   This class contains all methods and data necessary to produce the
+ *   reports as JSON data.  Each report is an array of rows and the
+ *   annotated report is an index of the symbols with a shard of the
+ *   annotated lines of each symbol.  The index writes report.html, a
+ *   static page which loads covoar-report.js to fetch the data when a
+ *   report or symbol is opened and to render only the rows in view.
+ *   The page fetches the data so it is served by a web server.
+ */
+class ReportsJson: public ReportsBase {
+
+  public:
+    ReportsJson(
+      time_t                  timestamp,
+      const std::string&      symbolSetName,
+      Coverage::Explanations& allExplanations,
+      const std::string&      projectName,
+      const std::string&      outputDirectory,
+      const DesiredSymbols&   symbolsToAnalyze,
+      bool                    branchInfoAvailable
+    );
+    virtual ~ReportsJson();
+
+    /*!
+     *  This method writes the index of the reports and the HTML page
+     *  showing them.
+     *
+     *  @param[in] fileName identifies the index file name
+     */
+    virtual void WriteIndex( const std::string& fileName );
+
+  protected:
+
+    /*!
+     *  This method writes the string as a JSON string.
+     */
+    static void PutString( std::ostream& aFile, const std::string& text );
+
+    /*!
+     *  This method starts a row of a report.
+     */
+    void PutRowStart( std::ofstream& aFile, bool& first );
+
+    /* Inherit documentation from base class. */
+    virtual void OpenAnnotatedFile(
+      const std::string& fileName,
+      std::ofstream&     aFile
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void OpenBranchFile(
+      const std::string& fileName,
+      bool               hasBranches,
+      std::ofstream&     aFile
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void OpenCoverageFile(
+      const std::string& fileName,
+      std::ofstream&     aFile
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void OpenNoRangeFile(
+      const std::string& fileName,
+      std::ofstream&     aFile
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void OpenSizeFile(
+      const std::string& fileName,
+      std::ofstream&     aFile
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void OpenSymbolSummaryFile(
+      const std::string& fileName,
+      std::ofstream&     aFile
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void CloseAnnotatedFile( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual void CloseBranchFile( std::ofstream& aFile, bool hasBranches );
+
+    /* Inherit documentation from base class. */
+    virtual void CloseCoverageFile( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual void CloseNoRangeFile( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual void CloseSizeFile( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual void CloseSymbolSummaryFile( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual void PutAnnotatedLine(
+      std::ofstream&       aFile,
+      AnnotatedLineState_t state,
+      const std::string&   line,
+      uint32_t             id
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void AnnotatedStart( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual void AnnotatedEnd( std::ofstream& aFile );
+
+    /* Inherit documentation from base class. */
+    virtual bool PutNoBranchInfo( std::ofstream& report );
+
+    /* Inherit documentation from base class. */
+    virtual bool PutBranchEntry(
+      std::ofstream&                         report,
+      unsigned int                           number,
+      const std::string&                     symbolName,
+      const SymbolInformation&               symbolInfo,
+      const CoverageRanges::coverageRange_t& range
+    );
+
+    /* Inherit documentation from base class. */
+    virtual void putCoverageNoRange(
+      std::ofstream&     report,
+      std::ofstream&     noRangeFile,
+      unsigned int       number,
+      const std::string& symbol
+    );
+
+    /* Inherit documentation from base class. */
+    virtual bool PutCoverageLine(
+      std::ofstream&                         report,
+      unsigned int                           number,
+      const std::string&                     symbolName,
+      const SymbolInformation&               symbolInfo,
+      const CoverageRanges::coverageRange_t& range
+    );
+
+    /* Inherit documentation from base class. */
+    virtual bool PutSizeLine(
+      std::ofstream&                         report,
+      unsigned int                           number,
+      const std::string&                     symbolName,
+      const CoverageRanges::coverageRange_t& range
+    );
+
+    /* Inherit documentation from base class. */
+    virtual bool PutSymbolSummaryLine(
+      std::ofstream&           report,
+      unsigned int             number,
+      const std::string&       symbolName,
+      const SymbolInformation& symbolInfo
+    );
+
+  private:
+
+    /*!
+     *  This method writes the classification and explanation of a range.
+     */
+    void PutExplanation(
+      std::ofstream&                         report,
+      const CoverageRanges::coverageRange_t& range
+    );
+
+    /*!
+     *  This member variable is true until the first row of the report is
+     *  written.
+     */
+    bool firstRow_m;
+
+    /*!
+     *  This member variable is true until the first symbol of the list of
+     *  the symbols without ranges is written.
+     */
+    bool firstNoRange_m;
+
+    /*!
+     *  This member variable holds the shard of the annotated lines of the
+     *  symbol being written, its number, its first line and its number of
+     *  lines.
+     */
+    ReportFile  shard_m;
+    unsigned    shardNumber_m;
+    std::string shardTitle_m;
+    unsigned    shardLines_m;
+};
+
+}
+
+#endif
@@ -0,0 +1,424 @@
+/*! @file SqlExport.cc
+ *  @brief SqlExport Implementation
+ *
+ *  This file contains the implementation of the export of the coverage
+ *  results as an SQL script.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <rld.h>
+
+#include "SqlExport.h"
+#include "CoverageMapBase.h"
+#include "CoverageRanges.h"
+#include "ExecutableInfo.h"
+
+namespace Coverage {
+
+  /*
+   * The number of rows of each insert.
+   */
+  static const size_t sqlBatchSize = 500;
+
+  /*
+   * The schema of the export. Change the version if the schema changes.
+   */
+  static const int sqlSchemaVersion = 1;
+
+  static const char* const sqlSchema =
+    "CREATE TABLE IF NOT EXISTS covoar_schema (version INTEGER);\n"
+    "CREATE TABLE IF NOT EXISTS runs (\n"
+    "  run_id INTEGER PRIMARY KEY,\n"
+    "  project TEXT,\n"
+    "  datetime TEXT,\n"
+    "  branch_info INTEGER\n"
+    ");\n"
+    "CREATE TABLE IF NOT EXISTS symbols (\n"
+    "  run_id INTEGER REFERENCES runs(run_id),\n"
+    "  symbol_set TEXT,\n"
+    "  symbol TEXT,\n"
+    "  referenced INTEGER,\n"
+    "  size_bytes INTEGER,\n"
+    "  size_instructions INTEGER,\n"
+    "  uncovered_bytes INTEGER,\n"
+    "  uncovered_instructions INTEGER,\n"
+    "  uncovered_ranges INTEGER,\n"
+    "  branches INTEGER,\n"
+    "  branches_not_executed INTEGER,\n"
+    "  branches_always_taken INTEGER,\n"
+    "  branches_never_taken INTEGER\n"
+    ");\n"
+    "CREATE TABLE IF NOT EXISTS ranges (\n"
+    "  run_id INTEGER REFERENCES runs(run_id),\n"
+    "  symbol_set TEXT,\n"
+    "  symbol TEXT,\n"
+    "  range_id INTEGER,\n"
+    "  kind TEXT,\n"
+    "  reason TEXT,\n"
+    "  low_address INTEGER,\n"
+    "  high_address INTEGER,\n"
+    "  bytes INTEGER,\n"
+    "  instructions INTEGER,\n"
+    "  low_line TEXT,\n"
+    "  high_line TEXT\n"
+    ");\n"
+    "CREATE TABLE IF NOT EXISTS lines (\n"
+    "  run_id INTEGER REFERENCES runs(run_id),\n"
+    "  symbol_set TEXT,\n"
+    "  file TEXT,\n"
+    "  line INTEGER,\n"
+    "  instructions INTEGER,\n"
+    "  executed INTEGER,\n"
+    "  hits INTEGER\n"
+    ");\n"
+    "CREATE INDEX IF NOT EXISTS symbols_run ON symbols (run_id);\n"
+    "CREATE INDEX IF NOT EXISTS ranges_run ON ranges (run_id);\n"
+    "CREATE INDEX IF NOT EXISTS lines_run ON lines (run_id);\n";
+
+  /*
+   * Write a string as an SQL literal.
+   */
+  static void putString( std::ostream& out, const std::string& text )
+  {
+    out << '\'';
+    for ( char c : text ) {
+      if ( c == '\'' ) {
+        out << '\'';
+      }
+      out << c;
+    }
+    out << '\'';
+  }
+
+  /*
+   * This class writes the rows of a table as inserts of up to a batch of
+   * rows. The run identifier is prepended to each row by the insert.
+   */
+  class SqlInserter {
+
+  public:
+
+    SqlInserter(
+      std::ostream&      out,
+      const std::string& table,
+      const std::string& columns
+    ) : out_m( out ),
+        table_m( table ),
+        columns_m( columns ),
+        rows_m( 0 )
+    {
+    }
+
+    ~SqlInserter()
+    {
+      end();
+    }
+
+    /*
+     * Start a row and return the stream to write its values to. The row
+     * is closed by the next row or the end of the insert. A full batch is
+     * ended before the row is started.
+     */
+    std::ostream& row()
+    {
+      if ( rows_m == sqlBatchSize ) {
+        end();
+      }
+
+      if ( rows_m == 0 ) {
+        out_m << "INSERT INTO " << table_m << " (run_id, " << columns_m
+              << ")\n  SELECT current_run.run_id, v.* FROM current_run,"
+              << " (VALUES\n    (";
+      } else {
+        out_m << "),\n    (";
+      }
+
+      ++rows_m;
+      return out_m;
+    }
+
+    /*
+     * End the insert of the rows written.
+     */
+    void end()
+    {
+      if ( rows_m != 0 ) {
+        out_m << ")) AS v;\n";
+      }
+      rows_m = 0;
+    }
+
+  private:
+
+    std::ostream& out_m;
+    std::string   table_m;
+    std::string   columns_m;
+    size_t        rows_m;
+  };
+
+  /*
+   * The coverage of a source line.
+   */
+  struct lineCoverage_t {
+    uint32_t instructions;
+    uint32_t executed;
+    uint32_t hits;
+  };
+
+  /*
+   * An instruction of the symbols of a set looked up in its executable.
+   */
+  struct lineInstruction_t {
+    uint32_t address;
+    uint32_t count;
+  };
+
+  static const char* reasonText(
+    CoverageRanges::uncoveredReason_t reason
+  )
+  {
+    switch ( reason ) {
+      case CoverageRanges::UNCOVERED_REASON_BRANCH_ALWAYS_TAKEN:
+        return "ALWAYS TAKEN";
+      case CoverageRanges::UNCOVERED_REASON_BRANCH_NEVER_TAKEN:
+        return "NEVER TAKEN";
+      default:
+        return "NOT EXECUTED";
+    }
+  }
+
+  static void putRanges(
+    SqlInserter&          ranges,
+    const std::string&    symbolSetName,
+    const std::string&    symbol,
+    const CoverageRanges* theRanges,
+    const char*           kind
+  )
+  {
+    if ( theRanges == nullptr ) {
+      return;
+    }
+
+    for ( const auto& range : theRanges->set ) {
+      std::ostream& r = ranges.row();
+
+      putString( r, symbolSetName );
+      r << ", ";
+      putString( r, symbol );
+      r << ", " << range.id << ", '" << kind << "', '"
+        << reasonText( range.reason ) << "', " << range.lowAddress << ", "
+        << range.highAddress << ", "
+        << range.highAddress - range.lowAddress + 1 << ", "
+        << range.instructionCount << ", ";
+      putString( r, range.lowSourceLine );
+      r << ", ";
+      putString( r, range.highSourceLine );
+    }
+  }
+
+  /*
+   * Put the coverage of the source lines of the symbols of a set. The
+   * instructions of the symbols of an executable are looked up in one
+   * sorted pass of its line table.
+   */
+  static void putLines(
+    SqlInserter&                    lines,
+    const std::string&              symbolSetName,
+    const Coverage::DesiredSymbols& symbolsToAnalyze
+  )
+  {
+    std::map<ExecutableInfo*, std::vector<lineInstruction_t>> executables;
+
+    for ( const auto& symbol :
+            symbolsToAnalyze.getSymbolsForSet( symbolSetName ) ) {
+      const SymbolInformation& info =
+        symbolsToAnalyze.allSymbols().at( symbol );
+      const CoverageMapBase*   theCoverageMap = info.unifiedCoverageMap;
+
+      if ( info.sourceFile == nullptr || theCoverageMap == nullptr ) {
+        continue;
+      }
+
+      std::vector<lineInstruction_t>& instructions =
+        executables[ info.sourceFile ];
+
+      for ( const auto& instruction : info.instructions ) {
+        if ( instruction.isInstruction ) {
+          instructions.push_back( {
+            instruction.address,
+            theCoverageMap->getWasExecuted(
+              instruction.address - info.baseAddress
+            )
+          } );
+        }
+      }
+    }
+
+    std::map<std::string, std::map<int, lineCoverage_t>> files;
+
+    for ( auto& executable : executables ) {
+      std::vector<lineInstruction_t>& instructions = executable.second;
+      std::vector<uint32_t>           addresses;
+      std::vector<std::string>        locations;
+
+      std::sort(
+        instructions.begin(),
+        instructions.end(),
+        []( const lineInstruction_t& a, const lineInstruction_t& b ) {
+          return a.address < b.address;
+        }
+      );
+
+      addresses.reserve( instructions.size() );
+      for ( const auto& instruction : instructions ) {
+        addresses.push_back( instruction.address );
+      }
+
+      executable.first->getSourceAndLines( addresses, locations );
+
+      for ( size_t i = 0; i < instructions.size(); ++i ) {
+        const std::string& location = locations[ i ];
+        size_t             colon = location.rfind( ':' );
+        int                line = std::stoi( location.substr( colon + 1 ) );
+
+        if ( line < 0 ) {
+          continue;
+        }
+
+        lineCoverage_t& coverage =
+          files[ location.substr( 0, colon ) ][ line ];
+
+        ++coverage.instructions;
+        if ( instructions[ i ].count != 0 ) {
+          ++coverage.executed;
+          coverage.hits = std::max( coverage.hits, instructions[ i ].count );
+        }
+      }
+    }
+
+    for ( const auto& file : files ) {
+      for ( const auto& line : file.second ) {
+        std::ostream& r = lines.row();
+
+        putString( r, symbolSetName );
+        r << ", ";
+        putString( r, file.first );
+        r << ", " << line.first << ", " << line.second.instructions << ", "
+          << line.second.executed << ", " << line.second.hits;
+      }
+    }
+  }
+
+  void WriteSqlExport(
+    const std::string&              fileName,
+    const std::vector<std::string>& symbolSetNames,
+    const Coverage::DesiredSymbols& symbolsToAnalyze,
+    const std::string&              projectName,
+    bool                            branchInfoAvailable,
+    time_t                          timestamp
+  )
+  {
+    std::ofstream out( fileName );
+    char          datetime[ 32 ];
+
+    if ( !out.is_open() ) {
+      throw rld::error( "Unable to create " + fileName, "WriteSqlExport" );
+    }
+
+    strftime(
+      datetime,
+      sizeof( datetime ),
+      "%Y-%m-%d %H:%M:%S",
+      localtime( &timestamp )
+    );
+
+    out << "BEGIN TRANSACTION;\n" << sqlSchema
+        << "INSERT INTO covoar_schema (version) SELECT " << sqlSchemaVersion
+        << " WHERE NOT EXISTS (SELECT 1 FROM covoar_schema);\n"
+        << "INSERT INTO runs (project, datetime, branch_info) VALUES (";
+    putString( out, projectName );
+    out << ", '" << datetime << "', " << ( branchInfoAvailable ? 1 : 0 )
+        << ");\n"
+        << "CREATE TEMP TABLE current_run AS"
+        << " SELECT last_insert_rowid() AS run_id;\n";
+
+    {
+      SqlInserter symbols(
+        out,
+        "symbols",
+        "symbol_set, symbol, referenced, size_bytes, size_instructions, "
+        "uncovered_bytes, uncovered_instructions, uncovered_ranges, "
+        "branches, branches_not_executed, branches_always_taken, "
+        "branches_never_taken"
+      );
+
+      for ( const auto& symbolSetName : symbolSetNames ) {
+        for ( const auto& symbol :
+                symbolsToAnalyze.getSymbolsForSet( symbolSetName ) ) {
+          const Statistics& stats =
+            symbolsToAnalyze.allSymbols().at( symbol ).stats;
+          std::ostream&     r = symbols.row();
+
+          putString( r, symbolSetName );
+          r << ", ";
+          putString( r, symbol );
+          r << ", " << ( stats.sizeInBytes != 0 ? 1 : 0 ) << ", "
+            << stats.sizeInBytes << ", " << stats.sizeInInstructions << ", "
+            << stats.uncoveredBytes << ", " << stats.uncoveredInstructions
+            << ", " << stats.uncoveredRanges << ", "
+            << stats.branchesExecuted + stats.branchesNotExecuted << ", "
+            << stats.branchesNotExecuted << ", "
+            << stats.branchesAlwaysTaken << ", "
+            << stats.branchesNeverTaken;
+        }
+      }
+    }
+
+    {
+      SqlInserter ranges(
+        out,
+        "ranges",
+        "symbol_set, symbol, range_id, kind, reason, low_address, "
+        "high_address, bytes, instructions, low_line, high_line"
+      );
+
+      for ( const auto& symbolSetName : symbolSetNames ) {
+        for ( const auto& symbol :
+                symbolsToAnalyze.getSymbolsForSet( symbolSetName ) ) {
+          const SymbolInformation& info =
+            symbolsToAnalyze.allSymbols().at( symbol );
+
+          putRanges(
+            ranges, symbolSetName, symbol, info.uncoveredRanges, "uncovered"
+          );
+          putRanges(
+            ranges, symbolSetName, symbol, info.uncoveredBranches, "branch"
+          );
+        }
+      }
+    }
+
+    {
+      SqlInserter lines(
+        out,
+        "lines",
+        "symbol_set, file, line, instructions, executed, hits"
+      );
+
+      for ( const auto& symbolSetName : symbolSetNames ) {
+        putLines( lines, symbolSetName, symbolsToAnalyze );
+      }
+    }
+
+    out << "DROP TABLE current_run;\n" << "COMMIT;\n";
+
+    if ( !out.good() ) {
+      throw rld::error( "Unable to write " + fileName, "WriteSqlExport" );
+    }
+  }
+
+}
@@ -0,0 +1,51 @@
+/*! @file SqlExport.h
+ *  @brief SqlExport Specification
+ *
+ *  This file contains the specification of the export of the coverage
+ *  results as an SQL script.
+ */
+
+#ifndef __SQL_EXPORT_H__
+#define __SQL_EXPORT_H__
+
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "DesiredSymbols.h"
+
+namespace Coverage {
+
+/*!
+ *  This method writes the coverage results of the symbol sets as an SQL
+ *  script for SQLite. The script creates the tables if they do not exist
+ *  and adds a run with the statistics of the symbols, their uncovered
+ *  ranges and branches and the coverage of each source line. The rows
+ *  of a run reference it by its identifier so the scripts of many runs
+ *  can be loaded into one database, for example with
+ *  "sqlite3 coverage.db < coverage.sql". The rows are inserted in
+ *  batches of multi-row inserts in a single transaction.
+ *
+ *  A source line is covered if one of its instructions was executed and
+ *  its hits are the highest execution count of its instructions.
+ *
+ *  @param[in] fileName specifies the script to write
+ *  @param[in] symbolSetNames are the names of the symbol sets to export
+ *  @param[in] symbolsToAnalyze the symbols to be analyzed
+ *  @param[in] projectName specifies the name of the project
+ *  @param[in] branchInfoAvailable tells if branch info is available
+ *  @param[in] timestamp specifies the time of the run
+ */
+void WriteSqlExport(
+  const std::string&              fileName,
+  const std::vector<std::string>& symbolSetNames,
+  const Coverage::DesiredSymbols& symbolsToAnalyze,
+  const std::string&              projectName,
+  bool                            branchInfoAvailable,
+  time_t                          timestamp
+);
+
+}
+
+#endif
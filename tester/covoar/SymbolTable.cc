@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include <rld.h>
 
 #include "SymbolTable.h"
@@ -39,7 +41,10 @@ namespace Coverage {
     entry.low = start;
     entry.high = end;
     entry.symbol = symbol;
-    contents[ end ] = entry;
+    if ( !contents.empty() && contents.back().high >= end ) {
+      contentsSorted = false;
+    }
+    contents.push_back( entry );
 
     // Add an entry to the symbol information map.
     symbolData.startingAddress = start;
@@ -89,6 +94,18 @@ namespace Coverage {
   }
 
   std::string SymbolTable::getSymbol( uint32_t address )
+  {
+    uint32_t low;
+    uint32_t high;
+
+    return getSymbol( address, low, high );
+  }
+
+  std::string SymbolTable::getSymbol(
+    uint32_t  address,
+    uint32_t& low,
+    uint32_t& high
+  )
   {
     contents_t::iterator it;
 
@@ -97,19 +114,67 @@ namespace Coverage {
       return "";
     }
 
+    sortContents();
+
     // Find the first entry whose end address is greater
-    // than the specified address.
-    it = contents.lower_bound( address );
+    // than or equal to the specified address.
+    it = std::lower_bound(
+      contents.begin(),
+      contents.end(),
+      address,
+      [] ( const symbol_entry_t& e, uint32_t a ) { return e.high < a; }
+    );
 
     // If an entry was found and its low address is less than or
     // equal to the specified address, then return the symbol.
-    if ( ( it != contents.end() ) && ( ( it->second ).low <= address ) ) {
-      return (it->second).symbol;
+    if ( ( it != contents.end() ) && ( it->low <= address ) ) {
+      low = it->low;
+      high = it->high;
+      return it->symbol;
     }
 
     return "";
   }
 
+  const SymbolTable::contents_t& SymbolTable::getRanges( void ) const
+  {
+    sortContents();
+    return contents;
+  }
+
+  void SymbolTable::sortContents( void ) const
+  {
+    if ( contentsSorted ) {
+      return;
+    }
+
+    std::stable_sort(
+      contents.begin(),
+      contents.end(),
+      [] ( const symbol_entry_t& a, const symbol_entry_t& b ) {
+        return a.high < b.high;
+      }
+    );
+
+    // Keep the last added entry of each end address.
+    contents_t::iterator out = contents.begin();
+
+    for ( auto it = contents.begin(); it != contents.end(); ++it ) {
+      if ( it + 1 != contents.end() && ( it + 1 )->high == it->high ) {
+        continue;
+      }
+
+      if ( out != it ) {
+        *out = std::move( *it );
+      }
+
+      ++out;
+    }
+
+    contents.erase( out, contents.end() );
+    contentsSorted = true;
+  }
+
   void SymbolTable::dumpSymbolTable( void )
   {
     symbolInfo           symbolTable;
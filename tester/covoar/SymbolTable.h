@@ -10,7 +10,7 @@
 #include <stdint.h>
 #include <string>
 #include <map>
-#include <list>
+#include <vector>
 
 namespace Coverage {
 
@@ -32,8 +32,8 @@ namespace Coverage {
       uint32_t length;
     } symbolInfo_t;
 
-   typedef std::list< symbolInfo_t > symbolInfo;
-   typedef std::list< symbolInfo_t >::iterator  symbolInfoIterator_t;
+   typedef std::vector< symbolInfo_t > symbolInfo;
+   typedef std::vector< symbolInfo_t >::iterator  symbolInfoIterator_t;
 
     /*!
      *  This method constructs a SymbolTable instance.
@@ -93,25 +93,68 @@ namespace Coverage {
       uint32_t address
     );
 
+    /*!
+     *  This method returns the symbol that contains the specified address
+     *  and the bounds of the symbol's address range.
+     *
+     *  @param[in] address specifies the address for which to obtain the symbol
+     *  @param[out] low is set to the low address of the symbol's range
+     *  @param[out] high is set to the high address of the symbol's range
+     *
+     *  @return Returns the symbol containing the address
+     */
+    std::string getSymbol(
+      uint32_t  address,
+      uint32_t& low,
+      uint32_t& high
+    );
+
     /*!
      *  This method prints SymbolTable content to stdout
      *
      */
     void dumpSymbolTable( void );
 
-  private:
-
     /*!
-     *  This map associates the end address of a symbol's address
-     *  range with the symbol's address range definition.
+     *  This vector contains the symbols' address range definitions
+     *  sorted by the end address of the ranges.  The end addresses are
+     *  unique.
      */
     typedef struct {
        uint32_t    low;
        uint32_t    high;
        std::string symbol;
     } symbol_entry_t;
-    typedef std::map< uint32_t, symbol_entry_t > contents_t;
-    contents_t contents;
+    typedef std::vector< symbol_entry_t > contents_t;
+
+    /*!
+     *  This method returns the address ranges of the symbols ordered by
+     *  their end address.
+     *
+     *  @return Returns the address ranges of the symbols
+     */
+    const contents_t& getRanges( void ) const;
+
+  private:
+
+    /*!
+     *  This method sorts the address ranges added since the last sort.
+     *  Of the ranges with the same end address, the last one added is
+     *  kept.
+     */
+    void sortContents( void ) const;
+
+    /*!
+     *  This member variable contains the address ranges of the symbols.
+     *  The ranges are appended by addSymbol() and sorted by the first
+     *  look up.
+     */
+    mutable contents_t contents;
+
+    /*!
+     *  This member variable is set if the address ranges are sorted.
+     */
+    mutable bool contentsSorted = true;
 
     /*!
      *  This map associates each symbol from an executable with
@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -16,6 +17,77 @@
 
 namespace Target {
 
+  MnemonicSet::MnemonicSet():
+    seed_m( 0 ),
+    mask_m( 0 )
+  {
+  }
+
+  void MnemonicSet::push_back( const std::string& mnemonic )
+  {
+    if ( !table_m.empty() ) {
+      throw rld::error( "set is frozen: " + mnemonic, "MnemonicSet::push_back" );
+    }
+    if ( mnemonic.empty() || ( mnemonic.length() > maxLength ) ) {
+      throw rld::error( "invalid mnemonic: " + mnemonic, "MnemonicSet::push_back" );
+    }
+    mnemonics_m.push_back( mnemonic );
+  }
+
+  void MnemonicSet::freeze()
+  {
+    std::sort( mnemonics_m.begin(), mnemonics_m.end() );
+    mnemonics_m.erase(
+      std::unique( mnemonics_m.begin(), mnemonics_m.end() ),
+      mnemonics_m.end()
+    );
+
+    if ( mnemonics_m.empty() )
+      return;
+
+    // Start with a table at least twice the number of mnemonics and
+    // double it if no seed separates them. A set is a few dozen
+    // mnemonics so a seed is normally found in a few tries.
+    size_t size = 1;
+    while ( size < ( mnemonics_m.size() * 2 ) )
+      size *= 2;
+
+    while ( true ) {
+      for ( uint32_t seed = 1; seed < 4096; ++seed ) {
+        std::vector<entry_t> table( size );
+        bool                 perfect = true;
+
+        for ( size_t e = 0; e < size; ++e )
+          table[ e ].length = 0;
+
+        for ( const auto& mnemonic : mnemonics_m ) {
+          entry_t& entry = table[
+            hash( seed, mnemonic.c_str(), mnemonic.length() ) & ( size - 1 )
+          ];
+          if ( entry.length != 0 ) {
+            perfect = false;
+            break;
+          }
+          entry.length = mnemonic.length();
+          ::memcpy( entry.text, mnemonic.c_str(), mnemonic.length() );
+        }
+
+        if ( perfect ) {
+          table_m.swap( table );
+          seed_m = seed;
+          mask_m = size - 1;
+          return;
+        }
+      }
+      size *= 2;
+    }
+  }
+
+  bool MnemonicSet::empty() const
+  {
+    return mnemonics_m.empty();
+  }
+
   TargetBase::TargetBase(
     std::string targetName
   ):
@@ -62,8 +134,11 @@ namespace Target {
 
   bool TargetBase::isBranch( const std::string& instruction )
   {
-    std::list <std::string>::iterator i;
+    return isBranch( instruction.c_str(), instruction.length() );
+  }
 
+  bool TargetBase::isBranch( const char* instruction, size_t length ) const
+  {
     if (conditionalBranchInstructions.empty()) {
       throw rld::error(
         "DETERMINE BRANCH INSTRUCTIONS FOR THIS ARCHITECTURE! -- fix me",
@@ -71,15 +146,7 @@ namespace Target {
       );
     }
 
-    i = find(
-      conditionalBranchInstructions.begin(),
-      conditionalBranchInstructions.end(),
-      instruction.c_str()
-    );
-    if ( i  == conditionalBranchInstructions.end() )
-      return false;
-
-    return true;
+    return conditionalBranchInstructions.contains( instruction, length );
   }
 
   bool TargetBase::isBranchLine(
@@ -91,11 +158,10 @@ namespace Target {
     #define WARNING_PT2 \
         ") Unable to find instruction in: "
     const char *ch;
-    char instruction[120];
-    int  result;
+    const char *end;
 
 
-    ch = &(line[0]);
+    ch = line.c_str();
 
     // Increment to the first tab in the line
     while ((*ch != '\t') && (*ch != '\0')) {
@@ -116,15 +182,36 @@ namespace Target {
     }
     ch++;
 
-    // Grab the instruction which is the next word in the buffer
-    // after the second tab.
-    result = sscanf( ch, "%s", instruction );
-    if (result != 1) {
+    // The instruction is the next word in the line after the second
+    // tab. It is looked up in place.
+    while (isspace((unsigned char) *ch))
+      ch++;
+    end = ch;
+    while ((*end != '\0') && !isspace((unsigned char) *end))
+      end++;
+    if (end == ch) {
         std::cerr << WARNING_PT1 << 3 << WARNING_PT2 << line << std::endl;
         return false;
     }
 
-    return isBranch( instruction );
+    return isBranch( ch, end - ch );
+  }
+
+  bool TargetBase::hasInstructionDecoder() const
+  {
+    return false;
+  }
+
+  bool TargetBase::decodeInstruction(
+    const uint8_t* code,
+    size_t         size,
+    bool           bigEndian,
+    int&           length,
+    std::string&   mnemonic,
+    bool&          nop
+  )
+  {
+    return false;
   }
 
   uint8_t TargetBase::qemuTakenBit()
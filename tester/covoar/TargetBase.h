@@ -7,12 +7,114 @@
 #ifndef __TARGETBASE_H__
 #define __TARGETBASE_H__
 
-#include <list>
 #include <string>
+#include <vector>
 #include <stdint.h>
+#include <string.h>
 
 namespace Target {
 
+  /*! @class MnemonicSet
+   *
+   *  This class implements a frozen set of instruction mnemonics. The
+   *  mnemonics are added and the set is frozen into a table indexed by
+   *  a perfect hash of the mnemonic so a lookup hashes the characters
+   *  of the mnemonic and compares one entry. A lookup does not allocate
+   *  and takes the mnemonic as a slice of a line.
+   */
+  class MnemonicSet {
+
+  public:
+
+    /*!
+     *  This method constructs an empty MnemonicSet instance.
+     */
+    MnemonicSet();
+
+    /*!
+     *  This method adds a mnemonic to the set. A mnemonic cannot be added
+     *  once the set is frozen.
+     *
+     *  @param[in] mnemonic specifies the mnemonic to add
+     */
+    void push_back( const std::string& mnemonic );
+
+    /*!
+     *  This method freezes the set by finding a seed of the hash that
+     *  maps each mnemonic to a separate entry of the table.
+     */
+    void freeze();
+
+    /*!
+     *  This method returns TRUE if no mnemonics have been added.
+     */
+    bool empty() const;
+
+    /*!
+     *  This method returns TRUE if the mnemonic is in the frozen set.
+     *
+     *  @param[in] mnemonic points to the characters of the mnemonic
+     *  @param[in] length specifies the number of characters
+     */
+    bool contains( const char* mnemonic, size_t length ) const
+    {
+      if ( ( length == 0 ) || ( length > maxLength ) || table_m.empty() )
+        return false;
+      const entry_t& entry = table_m[ hash( seed_m, mnemonic, length ) & mask_m ];
+      return ( entry.length == length ) &&
+        ( ::memcmp( entry.text, mnemonic, length ) == 0 );
+    }
+
+  private:
+
+    /*!
+     *  This is the length of the longest mnemonic in a set.
+     */
+    static const size_t maxLength = 15;
+
+    /*!
+     *  This type is an entry of the table. An empty entry has a length
+     *  of 0.
+     */
+    struct entry_t {
+      uint8_t length;
+      char    text[ maxLength ];
+    };
+
+    /*!
+     *  This method returns the seeded FNV-1a hash of the characters.
+     */
+    static uint32_t hash( uint32_t seed, const char* text, size_t length )
+    {
+      uint32_t h = 2166136261u ^ seed;
+      for ( size_t c = 0; c < length; ++c ) {
+        h ^= (uint8_t) text[ c ];
+        h *= 16777619u;
+      }
+      return h ^ ( h >> 16 );
+    }
+
+    /*!
+     *  This member variable contains the mnemonics added to the set.
+     */
+    std::vector<std::string> mnemonics_m;
+
+    /*!
+     *  This member variable contains the table of the frozen set.
+     */
+    std::vector<entry_t> table_m;
+
+    /*!
+     *  This member variable contains the seed of the perfect hash.
+     */
+    uint32_t seed_m;
+
+    /*!
+     *  This member variable contains the mask of a hash to an entry.
+     */
+    uint32_t mask_m;
+  };
+
   /*! @class TargetBase
    *
    *  This class is the base class for all Target classes.  Each
@@ -100,6 +202,47 @@ namespace Target {
      */
     bool isBranch( const std::string& instruction );
 
+    /*!
+     *  This method determines if the mnemonic in the slice of a line is
+     *  a branch instruction.
+     *
+     *  @param[in] instruction points to the characters of the mnemonic
+     *  @param[in] length specifies the number of characters
+     */
+    bool isBranch( const char* instruction, size_t length ) const;
+
+    /*!
+     *  This method returns TRUE if the target can decode the instructions
+     *  in an executable's code without an object dump.
+     *
+     *  @return Returns TRUE if the target has an instruction decoder.
+     */
+    virtual bool hasInstructionDecoder() const;
+
+    /*!
+     *  This method decodes the instruction at the start of the code. The
+     *  decoder only determines the length of the instruction and the
+     *  mnemonic objdump would show for the branch and nop instructions.
+     *
+     *  @param[in] code points to the bytes of the instruction
+     *  @param[in] size specifies the number of bytes available
+     *  @param[in] bigEndian specifies the byte order of the code
+     *  @param[out] length is set to the size in bytes of the instruction
+     *  @param[out] mnemonic is set to the mnemonic of the instruction or
+     *              is empty if the decoder does not identify it
+     *  @param[out] nop is set to TRUE if the instruction is a nop
+     *
+     *  @return Returns TRUE if an instruction was decoded, FALSE otherwise.
+     */
+    virtual bool decodeInstruction(
+      const uint8_t* code,
+      size_t         size,
+      bool           bigEndian,
+      int&           length,
+      std::string&   mnemonic,
+      bool&          nop
+    );
+
     /*!
      *  This method returns the bit set by Qemu in the trace record
      *  when a branch is taken.
@@ -120,10 +263,10 @@ namespace Target {
     std::string    targetName_m;
 
     /*!
-     * This member variable is an array of all conditional branch instructions
-     * for this target.
+     * This member variable is the set of all conditional branch instructions
+     * for this target. A target freezes the set once it is constructed.
      */
-    std::list <std::string> conditionalBranchInstructions;
+    MnemonicSet conditionalBranchInstructions;
 
   private:
 
@@ -73,7 +73,7 @@ namespace Target {
     conditionalBranchInstructions.push_back("cbz");
     conditionalBranchInstructions.push_back("cbnz");
 
-    conditionalBranchInstructions.sort();
+    conditionalBranchInstructions.freeze();
 
   }
 
@@ -88,22 +88,22 @@ namespace Target {
   {
     size_t stringLen = line.length();
 
-    if ( line.substr( stringLen - 3 ) == "nop" ) {
+    if ( line.compare( stringLen - 3, std::string::npos, "nop" ) == 0 ) {
       size = 4;
       return true;
     }
 
     // On ARM, there are literal tables at the end of methods.
     // We need to avoid them.
-    if ( line.substr( stringLen - 10, 5 ) == ".byte" ) {
+    if ( line.compare( stringLen - 10, 5, ".byte" ) == 0 ) {
       size = 1;
       return true;
     }
-    if ( line.substr( stringLen - 13, 6 ) == ".short" ) {
+    if ( line.compare( stringLen - 13, 6, ".short" ) == 0 ) {
       size = 2;
       return true;
     }
-    if ( line.substr( stringLen - 16, 5 ) == ".word" ) {
+    if ( line.compare( stringLen - 16, 5, ".word" ) == 0 ) {
       size = 4;
       return true;
     }
@@ -48,7 +48,7 @@ namespace Target {
     conditionalBranchInstructions.push_back("jnle");
     conditionalBranchInstructions.push_back("jnge");
 
-    conditionalBranchInstructions.sort();
+    conditionalBranchInstructions.freeze();
 
   }
 
@@ -63,35 +63,35 @@ namespace Target {
   {
     size_t stringLen = line.length();
 
-    if ( line.substr( stringLen - 3 ) == "nop" ) {
+    if ( line.compare( stringLen - 3, std::string::npos, "nop" ) == 0 ) {
       size = 1;
       return true;
     }
 
     // i386 has some two and three byte nops
-    if ( line.substr( stringLen - 14 ) == "xchg   %ax,%ax" ) {
+    if ( line.compare( stringLen - 14, std::string::npos, "xchg   %ax,%ax" ) == 0 ) {
       size = 2;
       return true;
     }
-    if ( line.substr( stringLen - 16 ) == "xor    %eax,%eax" ) {
+    if ( line.compare( stringLen - 16, std::string::npos, "xor    %eax,%eax" ) == 0 ) {
       size = 2;
       return true;
     }
-    if ( line.substr( stringLen - 16 ) == "xor    %ebx,%ebx" ) {
+    if ( line.compare( stringLen - 16, std::string::npos, "xor    %ebx,%ebx" ) == 0 ) {
       size = 2;
       return true;
     }
-    if ( line.substr( stringLen - 16 ) == "xor    %esi,%esi" ) {
+    if ( line.compare( stringLen - 16, std::string::npos, "xor    %esi,%esi" ) == 0 ) {
       size = 2;
       return true;
     }
-    if ( line.substr( stringLen - 21 ) == "lea    0x0(%esi),%esi" ) {
+    if ( line.compare( stringLen - 21, std::string::npos, "lea    0x0(%esi),%esi" ) == 0 ) {
       size = 3;
       return true;
     }
-    if ( line.substr( stringLen - 28 ) == "lea    0x0(%esi,%eiz,1),%esi" ) {
+    if ( line.compare( stringLen - 28, std::string::npos, "lea    0x0(%esi,%eiz,1),%esi" ) == 0 ) {
       // Could be 4 or 7 bytes of padding.
-      if ( line.substr( stringLen - 32, 2 ) == "00" ) {
+      if ( line.compare( stringLen - 32, 2, "00" ) == 0 ) {
         size = 7;
       } else {
         size = 4;
@@ -34,7 +34,7 @@ namespace Target {
     int&               size
   )
   {
-    if ( line.substr( line.length() - 3 ) == "nop" ) {
+    if ( line.compare( line.length() - 3, std::string::npos, "nop" ) == 0 ) {
       size = 4;
       return true;
     }
@@ -68,7 +68,7 @@ namespace Target {
     conditionalBranchInstructions.push_back("bvss");
     conditionalBranchInstructions.push_back("bvsl");
 
-    conditionalBranchInstructions.sort();
+    conditionalBranchInstructions.freeze();
 
   }
 
@@ -83,7 +83,7 @@ namespace Target {
   {
     size_t stringLen = line.length();
 
-    if ( line.substr( stringLen - 3 ) == "nop" ) {
+    if ( line.compare( stringLen - 3, std::string::npos, "nop" ) == 0 ) {
       size = 2;
       return true;
     }
@@ -91,7 +91,7 @@ namespace Target {
     #define GNU_LD_FILLS_ALIGNMENT_WITH_RTS
     #if defined(GNU_LD_FILLS_ALIGNMENT_WITH_RTS)
       // Until binutils 2.20, binutils would fill with rts not nop
-      if ( line.substr( stringLen - 3 ) == "rts" ) {
+      if ( line.compare( stringLen - 3, std::string::npos, "rts" ) == 0 ) {
         size = 4;
         return true;
       }
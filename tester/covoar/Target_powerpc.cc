@@ -50,7 +50,7 @@ namespace Target {
     conditionalBranchInstructions.push_back("bclrl");
 
 
-    conditionalBranchInstructions.sort();
+    conditionalBranchInstructions.freeze();
   }
 
   Target_powerpc::~Target_powerpc()
@@ -62,7 +62,7 @@ namespace Target {
     int&               size
   )
   {
-    if ( line.substr( line.length() - 3 ) == "nop" ) {
+    if ( line.compare( line.length() - 3, std::string::npos, "nop" ) == 0 ) {
       size = 4;
       return true;
     }
@@ -54,7 +54,7 @@ namespace Target {
     conditionalBranchInstructions.push_back("bgtu");
     conditionalBranchInstructions.push_back("bleu");
 
-    conditionalBranchInstructions.sort();
+    conditionalBranchInstructions.freeze();
    }
 
   Target_riscv::~Target_riscv()
@@ -66,7 +66,7 @@ namespace Target {
     int&               size
     )
   {
-    if ( line.substr( line.length() - 3 ) == "nop" ) {
+    if ( line.compare( line.length() - 3, std::string::npos, "nop" ) == 0 ) {
         size = 4;
         return true;
     }
@@ -74,6 +74,107 @@ namespace Target {
   return false;
   }
 
+  bool Target_riscv::hasInstructionDecoder() const
+  {
+    return true;
+  }
+
+  bool Target_riscv::decodeInstruction(
+    const uint8_t* code,
+    size_t         size,
+    bool           bigEndian,
+    int&           length,
+    std::string&   mnemonic,
+    bool&          nop
+  )
+  {
+    // The branch names with the aliases objdump uses when a register
+    // is zero, indexed by funct3.
+    static const char* const branches[8] = {
+      "beq", "bne", NULL, NULL, "blt", "bge", "bltu", "bgeu"
+    };
+
+    if ( size < 2 ) {
+      return false;
+    }
+
+    uint32_t half = code[0] | ( code[1] << 8 );
+
+    mnemonic.clear();
+    nop = false;
+
+    // Compressed instructions do not have the two low bits set.
+    if ( ( half & 0x3 ) != 0x3 ) {
+      length = 2;
+
+      uint32_t quadrant = half & 0x3;
+      uint32_t funct3 = half >> 13;
+
+      if ( half == 0x0001 ) {
+        mnemonic = "nop";
+        nop = true;
+      } else if ( quadrant == 1 && funct3 == 5 ) {
+        mnemonic = "j";
+      } else if ( quadrant == 1 && funct3 == 6 ) {
+        mnemonic = "beqz";
+      } else if ( quadrant == 1 && funct3 == 7 ) {
+        mnemonic = "bnez";
+      }
+
+      return true;
+    }
+
+    if ( ( half & 0x1f ) != 0x1f ) {
+      length = 4;
+    } else if ( ( half & 0x3f ) == 0x1f ) {
+      length = 6;
+    } else if ( ( half & 0x7f ) == 0x3f ) {
+      length = 8;
+    } else {
+      return false;
+    }
+
+    if ( size < static_cast<size_t>( length ) ) {
+      return false;
+    }
+
+    if ( length != 4 ) {
+      return true;
+    }
+
+    uint32_t word =
+      half | ( code[2] << 16 ) | ( static_cast<uint32_t>( code[3] ) << 24 );
+    uint32_t opcode = word & 0x7f;
+    uint32_t rd = ( word >> 7 ) & 0x1f;
+    uint32_t funct3 = ( word >> 12 ) & 0x7;
+    uint32_t rs1 = ( word >> 15 ) & 0x1f;
+    uint32_t rs2 = ( word >> 20 ) & 0x1f;
+
+    if ( word == 0x00000013 ) {
+      mnemonic = "nop";
+      nop = true;
+    } else if ( opcode == 0x63 && branches[funct3] != NULL ) {
+      mnemonic = branches[funct3];
+      if ( funct3 <= 1 && rs2 == 0 ) {
+        mnemonic += 'z';
+      } else if ( funct3 == 4 && rs2 == 0 ) {
+        mnemonic = "bltz";
+      } else if ( funct3 == 4 && rs1 == 0 ) {
+        mnemonic = "bgtz";
+      } else if ( funct3 == 5 && rs2 == 0 ) {
+        mnemonic = "bgez";
+      } else if ( funct3 == 5 && rs1 == 0 ) {
+        mnemonic = "blez";
+      }
+    } else if ( opcode == 0x6f ) {
+      mnemonic = rd == 0 ? "j" : "jal";
+    } else if ( opcode == 0x67 ) {
+      mnemonic = rd == 0 ? "jr" : "jalr";
+    }
+
+    return true;
+  }
+
   TargetBase *Target_riscv_Constructor(
     std::string        targetName
     )
@@ -83,6 +83,33 @@ namespace Target {
     const std::string& instruction
   );
 
+  /*!
+   *  This method returns True as the riscv instructions can be decoded.
+   */
+  bool hasInstructionDecoder() const;
+
+  /*!
+   *  This method decodes the riscv instruction at the start of the code.
+   *
+   *  @param[in] code points to the bytes of the instruction
+   *  @param[in] size specifies the number of bytes available
+   *  @param[in] bigEndian is ignored as riscv instructions are always
+   *             little endian
+   *  @param[out] length is set to the size in bytes of the instruction
+   *  @param[out] mnemonic is set to the mnemonic of the instruction
+   *  @param[out] nop is set to True if the instruction is a nop
+   *
+   *  @return Returns True if an instruction was decoded, False otherwise.
+   */
+  bool decodeInstruction(
+    const uint8_t* code,
+    size_t         size,
+    bool           bigEndian,
+    int&           length,
+    std::string&   mnemonic,
+    bool&          nop
+  );
+
   private:
 
   };
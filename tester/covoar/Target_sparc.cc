@@ -48,7 +48,7 @@ namespace Target {
     conditionalBranchInstructions.push_back("bvc");
     conditionalBranchInstructions.push_back("bvc,a");
 
-    conditionalBranchInstructions.sort();
+    conditionalBranchInstructions.freeze();
   }
 
   Target_sparc::~Target_sparc()
@@ -62,19 +62,19 @@ namespace Target {
   {
     size_t stringLen = line.length();
 
-    if ( line.substr( stringLen - 3 ) == "nop" ) {
+    if ( line.compare( stringLen - 3, std::string::npos, "nop" ) == 0 ) {
       size = 4;
       return true;
     }
 
-    if ( line.substr( stringLen - 7 ) == "unknown" ) {
+    if ( line.compare( stringLen - 7, std::string::npos, "unknown" ) == 0 ) {
       size = 4;
       return true;
     }
     #define GNU_LD_FILLS_ALIGNMENT_WITH_RTS
     #if defined(GNU_LD_FILLS_ALIGNMENT_WITH_RTS)
       // Until binutils 2.20, binutils would fill with rts not nop
-    if ( line.substr( stringLen - 3 ) == "rts" ) {
+    if ( line.compare( stringLen - 3, std::string::npos, "rts" ) == 0 ) {
         size = 4;
         return true;
       }
@@ -84,6 +84,60 @@ namespace Target {
   }
 
 
+  bool Target_sparc::hasInstructionDecoder() const
+  {
+    return true;
+  }
+
+  bool Target_sparc::decodeInstruction(
+    const uint8_t* code,
+    size_t         size,
+    bool           bigEndian,
+    int&           length,
+    std::string&   mnemonic,
+    bool&          nop
+  )
+  {
+    // The Bicc names indexed by the condition field.
+    static const char* const branches[16] = {
+      "bn",  "be",  "ble", "bl",  "bleu", "bcs", "bneg", "bvs",
+      "ba",  "bne", "bg",  "bge", "bgu",  "bcc", "bpos", "bvc"
+    };
+
+    if ( size < 4 ) {
+      return false;
+    }
+
+    uint32_t word = 0;
+
+    for ( int i = 0; i < 4; ++i ) {
+      word = ( word << 8 ) | code[ bigEndian ? i : 3 - i ];
+    }
+
+    length = 4;
+    mnemonic.clear();
+    nop = false;
+
+    uint32_t op = word >> 30;
+    uint32_t op2 = ( word >> 22 ) & 0x7;
+
+    if ( word == 0x01000000 ) {
+      mnemonic = "nop";
+      nop = true;
+    } else if ( op == 0 && op2 == 2 ) {
+      mnemonic = branches[ ( word >> 25 ) & 0xf ];
+      if ( ( word & ( 1 << 29 ) ) != 0 ) {
+        mnemonic += ",a";
+      }
+    } else if ( op == 0 && op2 == 4 ) {
+      mnemonic = "sethi";
+    } else if ( op == 1 ) {
+      mnemonic = "call";
+    }
+
+    return true;
+  }
+
   TargetBase *Target_sparc_Constructor(
     std::string          targetName
   )
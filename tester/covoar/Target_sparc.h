@@ -55,6 +55,32 @@ namespace Target {
       const std::string& instruction
     );
 
+    /*!
+     *  This method returns TRUE as the sparc instructions can be decoded.
+     */
+    bool hasInstructionDecoder() const;
+
+    /*!
+     *  This method decodes the sparc instruction at the start of the code.
+     *
+     *  @param[in] code points to the bytes of the instruction
+     *  @param[in] size specifies the number of bytes available
+     *  @param[in] bigEndian specifies the byte order of the code
+     *  @param[out] length is set to the size in bytes of the instruction
+     *  @param[out] mnemonic is set to the mnemonic of the instruction
+     *  @param[out] nop is set to TRUE if the instruction is a nop
+     *
+     *  @return Returns TRUE if an instruction was decoded, FALSE otherwise.
+     */
+    bool decodeInstruction(
+      const uint8_t* code,
+      size_t         size,
+      bool           bigEndian,
+      int&           length,
+      std::string&   mnemonic,
+      bool&          nop
+    );
+
   private:
 
   };
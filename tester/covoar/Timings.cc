@@ -0,0 +1,192 @@
+/*! @file Timings.cc
+ *  @brief Timings Implementation
+ *
+ *  This file contains the implementation of the functions
+ *  which accumulate and write the time of each phase of an analysis.
+ */
+
+#include "covoar-config.h"
+
+#include <time.h>
+
+#if HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+#include <fstream>
+#include <iomanip>
+
+#include <rld.h>
+
+#include "Timings.h"
+
+namespace Coverage {
+
+  Timings::Scope::Scope( Timings* timings, const std::string& phase )
+    : timings_m( timings ),
+      cpu_m( 0 )
+  {
+    if ( timings_m ) {
+      phase_m = phase;
+      start_m = std::chrono::steady_clock::now();
+      cpu_m = cpuSeconds();
+    }
+  }
+
+  Timings::Scope::~Scope()
+  {
+    if ( timings_m ) {
+      std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_m;
+      timings_m->add( phase_m, elapsed.count(), cpuSeconds() - cpu_m );
+    }
+  }
+
+  Timings::Timings()
+    : start_m( std::chrono::steady_clock::now() )
+  {
+  }
+
+  void Timings::add( const std::string& phase, double seconds, double cpu )
+  {
+    uint64_t                    peak = peakResidentKBytes();
+    std::lock_guard<std::mutex> guard( lock_m );
+
+    auto p = phases_m.find( phase );
+    if ( p == phases_m.end() ) {
+      order_m.push_back( phase );
+      p = phases_m.insert(
+        std::make_pair( phase, phase_t{ 0, 0, 0, 0 } )
+      ).first;
+    }
+
+    p->second.seconds += seconds;
+    p->second.cpu += cpu;
+    p->second.count++;
+    p->second.peakResident = peak;
+  }
+
+  void Timings::count( const std::string& counter, uint64_t value )
+  {
+    std::lock_guard<std::mutex> guard( lock_m );
+
+    auto c = counters_m.find( counter );
+    if ( c == counters_m.end() ) {
+      counterOrder_m.push_back( counter );
+      c = counters_m.insert( std::make_pair( counter, 0 ) ).first;
+    }
+
+    c->second += value;
+  }
+
+  double Timings::cpuSeconds()
+  {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec now;
+
+    if ( ::clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now ) == 0 ) {
+      return now.tv_sec + now.tv_nsec / 1e9;
+    }
+#endif
+#if HAVE_SYS_RESOURCE_H
+    struct rusage usage;
+#ifdef RUSAGE_THREAD
+    int           who = RUSAGE_THREAD;
+#else
+    int           who = RUSAGE_SELF;
+#endif
+
+    if ( ::getrusage( who, &usage ) == 0 ) {
+      return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    }
+#endif
+    return (double) ::clock() / CLOCKS_PER_SEC;
+  }
+
+  uint64_t Timings::peakResidentKBytes()
+  {
+#if HAVE_SYS_RESOURCE_H
+    struct rusage usage;
+
+    if ( ::getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+#ifdef __APPLE__
+      // The peak is in bytes on macOS and in kilobytes elsewhere.
+      return usage.ru_maxrss / 1024;
+#else
+      return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+  }
+
+  static std::string jsonString( const std::string& s )
+  {
+    std::string out = "\"";
+
+    for ( char c : s ) {
+      if ( c == '"' || c == '\\' ) {
+        out += '\\';
+      }
+      out += c;
+    }
+
+    return out + '"';
+  }
+
+  void Timings::write( const std::string& fileName ) const
+  {
+    std::lock_guard<std::mutex> guard( lock_m );
+    std::ofstream               out( fileName, std::ios::out | std::ios::trunc );
+    std::chrono::duration<double> total =
+      std::chrono::steady_clock::now() - start_m;
+    double                      cpu = (double) ::clock() / CLOCKS_PER_SEC;
+
+    if ( !out.is_open() ) {
+      throw rld::error(
+        "Unable to open " + fileName,
+        "Timings::write"
+      );
+    }
+
+    out << std::setprecision( 9 )
+        << "{" << std::endl
+        << "  \"total\": " << total.count() << ',' << std::endl
+        << "  \"cpu\": " << cpu << ',' << std::endl
+        << "  \"peak_rss_kb\": " << peakResidentKBytes() << ',' << std::endl
+        << "  \"phases\": [";
+
+    for ( size_t i = 0; i < order_m.size(); ++i ) {
+      const phase_t& p = phases_m.at( order_m[ i ] );
+      out << ( i == 0 ? "" : "," ) << std::endl
+          << "    { \"name\": " << jsonString( order_m[ i ] )
+          << ", \"seconds\": " << p.seconds
+          << ", \"cpu\": " << p.cpu
+          << ", \"count\": " << p.count
+          << ", \"peak_rss_kb\": " << p.peakResident << " }";
+    }
+
+    out << std::endl
+        << "  ]," << std::endl
+        << "  \"counters\": [";
+
+    for ( size_t i = 0; i < counterOrder_m.size(); ++i ) {
+      out << ( i == 0 ? "" : "," ) << std::endl
+          << "    { \"name\": " << jsonString( counterOrder_m[ i ] )
+          << ", \"value\": " << counters_m.at( counterOrder_m[ i ] ) << " }";
+    }
+
+    out << std::endl
+        << "  ]" << std::endl
+        << "}" << std::endl;
+
+    if ( !out ) {
+      throw rld::error(
+        "Unable to write " + fileName,
+        "Timings::write"
+      );
+    }
+  }
+
+}
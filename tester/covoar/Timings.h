@@ -0,0 +1,157 @@
+/*! @file Timings.h
+ *  @brief Timings Specification
+ *
+ *  This file contains the specification of the Timings class.
+ */
+
+#ifndef __TIMINGS_H__
+#define __TIMINGS_H__
+
+#include <stdint.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Coverage {
+
+  /*! @class Timings
+   *
+   *  This class accumulates the time spent in each phase of an analysis
+   *  and counters of the work done. A phase may be timed many times and
+   *  on many threads, its wall and CPU times are the sums of the times.
+   *  The CPU time is the time of the thread timing the phase if the host
+   *  can measure it, otherwise it is the time of the process. The peak
+   *  memory of a phase is the process's peak resident set size when the
+   *  phase last finished. The phases and counters are written in the
+   *  order they were first added.
+   */
+  class Timings {
+
+  public:
+
+    /*! @class Scope
+     *
+     *  This class times a phase from its construction to its destruction.
+     *  A scope with no timings does nothing.
+     */
+    class Scope {
+
+    public:
+
+      /*!
+       *  This method constructs a Scope instance.
+       *
+       *  @param[in] timings points to the timings or is NULL
+       *  @param[in] phase specifies the name of the phase
+       */
+      Scope( Timings* timings, const std::string& phase );
+
+      /*!
+       *  This method destructs a Scope instance adding its time.
+       */
+      ~Scope();
+
+    private:
+
+      Scope( const Scope& );
+      Scope& operator=( const Scope& );
+
+      Timings*                              timings_m;
+      std::string                           phase_m;
+      std::chrono::steady_clock::time_point start_m;
+      double                                cpu_m;
+    };
+
+    /*!
+     *  This method constructs a Timings instance and starts its clock.
+     */
+    Timings();
+
+    /*!
+     *  This method adds a time to a phase.
+     *
+     *  @param[in] phase specifies the name of the phase
+     *  @param[in] seconds specifies the wall time in seconds
+     *  @param[in] cpu specifies the CPU time in seconds
+     */
+    void add( const std::string& phase, double seconds, double cpu = 0 );
+
+    /*!
+     *  This method adds to a counter. Callers count locally and add the
+     *  count once a unit of work is done.
+     *
+     *  @param[in] counter specifies the name of the counter
+     *  @param[in] value specifies the value to add
+     */
+    void count( const std::string& counter, uint64_t value = 1 );
+
+    /*!
+     *  This method writes the timings as JSON. The total is the time since
+     *  the timings were constructed.
+     *
+     *  @param[in] fileName specifies the name of the file to write
+     */
+    void write( const std::string& fileName ) const;
+
+    /*!
+     *  This method returns the CPU time of the calling thread in seconds,
+     *  or of the process if the host cannot measure a thread's time.
+     */
+    static double cpuSeconds();
+
+    /*!
+     *  This method returns the peak resident set size of the process in
+     *  kilobytes or 0 if the host cannot measure it.
+     */
+    static uint64_t peakResidentKBytes();
+
+  private:
+
+    /*!
+     *  This type is the time of a phase.
+     */
+    typedef struct {
+      double   seconds;
+      double   cpu;
+      uint64_t count;
+      uint64_t peakResident;
+    } phase_t;
+
+    /*!
+     *  This member variable is when the timings were constructed.
+     */
+    std::chrono::steady_clock::time_point start_m;
+
+    /*!
+     *  This member variable contains the phases in the order they were
+     *  first timed.
+     */
+    std::vector<std::string> order_m;
+
+    /*!
+     *  This member variable contains the time of each phase.
+     */
+    std::map<std::string, phase_t> phases_m;
+
+    /*!
+     *  This member variable contains the counters in the order they were
+     *  first added.
+     */
+    std::vector<std::string> counterOrder_m;
+
+    /*!
+     *  This member variable contains the value of each counter.
+     */
+    std::map<std::string, uint64_t> counters_m;
+
+    /*!
+     *  This member variable serializes the threads adding times.
+     */
+    mutable std::mutex lock_m;
+  };
+
+}
+#endif
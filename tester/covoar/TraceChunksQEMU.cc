@@ -0,0 +1,289 @@
+/*! @file TraceChunksQEMU.cc
+ *  @brief TraceChunksQEMU Implementation
+ *
+ *  This file contains the implementation of the functions writing and
+ *  reading the chunked QEMU trace container.
+ */
+
+#include "covoar-config.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#include <rld.h>
+#include <rld-tasks.h>
+
+#include "TraceChunksQEMU.h"
+
+namespace Trace {
+
+  /*
+   * The storage methods of a chunk.
+   */
+  const uint32_t chunkStored = 0;
+  const uint32_t chunkZlib = 1;
+
+  /*
+   * The size of a chunk header.
+   */
+  const size_t chunkHeaderSize = 4 * sizeof( uint32_t );
+
+  /*
+   * A chunk in the file.
+   */
+  struct chunk_t {
+    const uint8_t* data;
+    uint32_t       entries;
+    uint32_t       encodedSize;
+    uint32_t       storedSize;
+    uint32_t       method;
+  };
+
+  static void putWord( std::vector<uint8_t>& out, uint32_t value )
+  {
+    for ( int b = 0; b < 4; ++b ) {
+      out.push_back( ( value >> ( b * 8 ) ) & 0xff );
+    }
+  }
+
+  static uint32_t getWord( const uint8_t* in )
+  {
+    return in[0] | ( in[1] << 8 ) | ( in[2] << 16 ) | ( (uint32_t) in[3] << 24 );
+  }
+
+  static void putValue( std::vector<uint8_t>& out, uint64_t value )
+  {
+    while ( value >= 0x80 ) {
+      out.push_back( ( value & 0x7f ) | 0x80 );
+      value >>= 7;
+    }
+    out.push_back( value );
+  }
+
+  static bool getValue(
+    const uint8_t*& in,
+    const uint8_t*  end,
+    uint64_t&       value
+  )
+  {
+    value = 0;
+    for ( int shift = 0; shift < 64; shift += 7 ) {
+      if ( in >= end ) {
+        return false;
+      }
+      uint8_t b = *in++;
+      value |= (uint64_t) ( b & 0x7f ) << shift;
+      if ( ( b & 0x80 ) == 0 ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool isChunkedTrace( const uint8_t* data, size_t size )
+  {
+    return size >= sizeof( trace_header ) &&
+      ::memcmp(
+        data,
+        QEMU_TRACE_CHUNKED_MAGIC,
+        sizeof( ((trace_header*) 0)->magic )
+      ) == 0;
+  }
+
+  void writeTraceChunk(
+    std::ostream&                   out,
+    const std::vector<trace_entry>& entries
+  )
+  {
+    std::vector<uint8_t> encoded;
+    uint32_t             pc = 0;
+
+    encoded.reserve( entries.size() * 4 );
+
+    for ( const auto& entry : entries ) {
+      int64_t delta = (int64_t) entry.pc - (int64_t) pc;
+      putValue( encoded, ( (uint64_t) delta << 1 ) ^ (uint64_t) ( delta >> 63 ) );
+      putValue( encoded, entry.size );
+      encoded.push_back( entry.op );
+      pc = entry.pc;
+    }
+
+    std::vector<uint8_t> stored;
+    uint32_t             method = chunkStored;
+    const uint8_t*       storedData = encoded.data();
+    size_t               storedSize = encoded.size();
+
+#if HAVE_ZLIB_H
+    uLongf compressedSize = ::compressBound( encoded.size() );
+
+    stored.resize( compressedSize );
+    if ( ::compress2(
+           stored.data(),
+           &compressedSize,
+           encoded.data(),
+           encoded.size(),
+           Z_DEFAULT_COMPRESSION
+         ) == Z_OK && compressedSize < encoded.size() ) {
+      method = chunkZlib;
+      storedData = stored.data();
+      storedSize = compressedSize;
+    }
+#endif
+
+    std::vector<uint8_t> header;
+    putWord( header, entries.size() );
+    putWord( header, encoded.size() );
+    putWord( header, storedSize );
+    putWord( header, method );
+
+    out.write( (const char*) header.data(), header.size() );
+    out.write( (const char*) storedData, storedSize );
+  }
+
+  /*
+   * Decode a chunk into its entries.
+   */
+  static void decodeChunk(
+    const std::string&        file,
+    const chunk_t&            chunk,
+    std::vector<trace_entry>& entries
+  )
+  {
+    std::vector<uint8_t> encoded;
+    const uint8_t*       in = chunk.data;
+    const uint8_t*       end = chunk.data + chunk.storedSize;
+
+    if ( chunk.method == chunkZlib ) {
+#if HAVE_ZLIB_H
+      uLongf encodedSize = chunk.encodedSize;
+
+      encoded.resize( chunk.encodedSize );
+      if ( ::uncompress(
+             encoded.data(),
+             &encodedSize,
+             chunk.data,
+             chunk.storedSize
+           ) != Z_OK || encodedSize != chunk.encodedSize ) {
+        throw rld::error(
+          "Invalid compressed chunk in " + file,
+          "Trace::readTraceChunks"
+        );
+      }
+      in = encoded.data();
+      end = encoded.data() + encoded.size();
+#else
+      throw rld::error(
+        "Compressed chunks not supported reading " + file,
+        "Trace::readTraceChunks"
+      );
+#endif
+    } else if ( chunk.method != chunkStored ) {
+      throw rld::error(
+        "Unknown chunk storage method in " + file,
+        "Trace::readTraceChunks"
+      );
+    }
+
+    uint32_t pc = 0;
+
+    entries.resize( chunk.entries );
+
+    for ( auto& entry : entries ) {
+      uint64_t delta;
+      uint64_t size;
+
+      if ( !getValue( in, end, delta ) || !getValue( in, end, size ) ||
+           in >= end ) {
+        throw rld::error(
+          "Truncated chunk in " + file,
+          "Trace::readTraceChunks"
+        );
+      }
+
+      pc += (uint32_t) ( ( delta >> 1 ) ^ ( 0 - ( delta & 1 ) ) );
+
+      entry.pc = pc;
+      entry.size = size;
+      entry.op = *in++;
+    }
+  }
+
+  void readTraceChunks(
+    const std::string&     file,
+    const uint8_t*         data,
+    size_t                 size,
+    int                    jobs,
+    const chunkConsumer_t& consume
+  )
+  {
+    std::vector<chunk_t> chunks;
+    size_t               offset = sizeof( trace_header );
+
+    //
+    // Index the chunks. A chunk's header holds the size of its data so
+    // the chunks are found without decoding them.
+    //
+    while ( offset < size ) {
+      chunk_t chunk;
+
+      if ( ( size - offset ) < chunkHeaderSize ) {
+        throw rld::error(
+          "Truncated chunk header in " + file,
+          "Trace::readTraceChunks"
+        );
+      }
+
+      chunk.entries     = getWord( data + offset );
+      chunk.encodedSize = getWord( data + offset + 4 );
+      chunk.storedSize  = getWord( data + offset + 8 );
+      chunk.method      = getWord( data + offset + 12 );
+      chunk.data        = data + offset + chunkHeaderSize;
+
+      offset += chunkHeaderSize;
+
+      if ( ( size - offset ) < chunk.storedSize ) {
+        throw rld::error(
+          "Truncated chunk in " + file,
+          "Trace::readTraceChunks"
+        );
+      }
+
+      offset += chunk.storedSize;
+
+      chunks.push_back( chunk );
+    }
+
+    //
+    // Decode the chunks in batches so the decoded entries held at once
+    // are bounded, each batch is decoded in parallel and consumed in
+    // order.
+    //
+    const size_t workers = std::max( jobs, 1 );
+    const size_t batch = workers * 2;
+
+    std::vector<std::vector<trace_entry>> decoded( batch );
+
+    for ( size_t first = 0; first < chunks.size(); first += batch ) {
+      const size_t count = std::min( batch, chunks.size() - first );
+
+      rld::tasks::parallel_for(
+        count,
+        workers,
+        [&]( size_t c ) {
+          decodeChunk( file, chunks[ first + c ], decoded[ c ] );
+        }
+      );
+
+      for ( size_t c = 0; c < count; ++c ) {
+        consume( decoded[ c ] );
+      }
+    }
+  }
+
+}
@@ -0,0 +1,87 @@
+/*! @file TraceChunksQEMU.h
+ *  @brief TraceChunksQEMU Specification
+ *
+ *  This file contains the specification of the chunked QEMU trace
+ *  container.
+ */
+
+#ifndef __TRACE_CHUNKS_QEMU_H__
+#define __TRACE_CHUNKS_QEMU_H__
+
+#include <stdint.h>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "qemu-traces.h"
+
+/*!
+ *  The magic of a chunked trace file. The file has the header of a QEMU
+ *  trace file with this magic.
+ */
+#define QEMU_TRACE_CHUNKED_MAGIC "#QEMU-TraceZ"
+
+namespace Trace {
+
+  /*!
+   *  This is the number of trace entries in a full chunk.
+   */
+  const size_t chunkEntries = 64 * 1024;
+
+  /*!
+   *  This method returns TRUE if the data of a trace file is a chunked
+   *  trace.
+   *
+   *  @param[in] data points to the data of the trace file
+   *  @param[in] size specifies the size of the data
+   */
+  bool isChunkedTrace( const uint8_t* data, size_t size );
+
+  /*!
+   *  This method writes a chunk of trace entries. The entries are delta
+   *  encoded and the chunk is compressed with zlib when it is available.
+   *  A chunk is decoded without the chunks before it.
+   *
+   *  A chunk is a 16 byte header of the number of entries, the encoded
+   *  size, the stored size and the storage method as little endian 32 bit
+   *  words followed by the stored data. An encoded entry is the
+   *  difference of its pc to the pc of the previous entry as a zig-zag
+   *  variable length integer, the size as a variable length integer and
+   *  the op.
+   *
+   *  @param[in] out specifies the stream to write
+   *  @param[in] entries specifies the entries of the chunk
+   */
+  void writeTraceChunk(
+    std::ostream&                   out,
+    const std::vector<trace_entry>& entries
+  );
+
+  /*!
+   *  This type is the consumer of the decoded entries of a chunk.
+   */
+  typedef std::function<void ( const std::vector<trace_entry>& )>
+    chunkConsumer_t;
+
+  /*!
+   *  This method decodes the chunks of a chunked trace file. The chunks
+   *  are decoded on @a jobs threads and passed to the consumer in the
+   *  order of the file on the calling thread.
+   *
+   *  @param[in] file specifies the name of the trace file
+   *  @param[in] data points to the data of the trace file
+   *  @param[in] size specifies the size of the data
+   *  @param[in] jobs specifies the number of threads to use
+   *  @param[in] consume specifies the consumer of the entries
+   */
+  void readTraceChunks(
+    const std::string&     file,
+    const uint8_t*         data,
+    size_t                 size,
+    int                    jobs,
+    const chunkConsumer_t& consume
+  );
+
+}
+#endif
@@ -15,6 +15,7 @@
 
 #include <rld.h>
 #include <rld-process.h>
+#include <rld-tasks.h>
 
 #include "qemu-log.h"
 #include "TraceReaderLogQEMU.h"
@@ -33,7 +34,12 @@ void usage()
 {
   std::cerr << "Usage: "
             << progname
-            << " [-v] -c CPU -e executable -t tracefile [-E logfile]"
+            << " [-v] [-z] [-j JOBS] -c CPU -e executable -t tracefile [-E logfile]"
+            << std::endl
+            << "--OR--" << std::endl
+            << "Usage: "
+            << progname
+            << " [-v] [-z] [-j JOBS] -u [-n] -t tracefile trace1 ... traceN"
             << std::endl;
   exit( 1 );
 }
@@ -89,24 +95,15 @@ int main(
   Coverage::ExecutableInfo*           executableInfo;
   Coverage::DesiredSymbols            symbolsToAnalyze;
   bool                                verbose = false;
+  bool                                compressed = false;
+  bool                                traceUnion = false;
+  bool                                counts = false;
+  int                                 jobs = rld::tasks::default_jobs();
   std::string                         dynamicLibrary;
   int                                 ec = 0;
   std::shared_ptr<Target::TargetBase> targetInfo;
-  rld::process::tempfile              *objdumpFile;
   rld::process::tempfile              *err;
 
-  try
-  {
-    objdumpFile = new rld::process::tempfile( ".dmp" );
-  }
-  catch ( rld::error re )
-  {
-    std::cerr << "Failed to make .dmp tempfile " << std::endl;
-    ec = 10;
-
-    return ec;
-  }
-
   try
   {
     err = new rld::process::tempfile( ".err" );
@@ -126,18 +123,62 @@ int main(
    //
   progname = argv[0];
 
-  while ( (opt = getopt( argc, argv, "c:e:l:L:t:v" ) ) != -1 ) {
+  while ( (opt = getopt( argc, argv, "c:e:j:l:L:nt:uvz" ) ) != -1 ) {
     switch ( opt ) {
       case 'c': cpuname        = optarg; break;
       case 'e': executable     = optarg; break;
+      case 'j': jobs           = atoi( optarg ); break;
       case 'l': logname        = optarg; break;
       case 'L': dynamicLibrary = optarg; break;
+      case 'n': counts         = true;   break;
       case 't': tracefile      = optarg; break;
+      case 'u': traceUnion     = true;   break;
       case 'v': verbose        = true;   break;
+      case 'z': compressed     = true;   break;
       default: usage();
     }
   }
 
+  if ( jobs < 1 ) {
+    jobs = 1;
+  }
+
+  //
+  // Merge the traces into a single trace with each translation block
+  // once.
+  //
+  if ( traceUnion ) {
+    if ( tracefile.empty() || optind == argc ) {
+      std::cerr << "output trace file or traces not specified" << std::endl;
+      usage();
+    }
+
+    rld::tasks::set_jobs( jobs );
+
+    try
+    {
+      trace.setCompressed( compressed );
+      if ( !trace.writeUnion(
+             tracefile,
+             std::vector<std::string>( argv + optind, argv + argc ),
+             counts,
+             jobs,
+             verbose
+           ) ) {
+        ec = 10;
+      }
+    }
+    catch ( rld::error re )
+    {
+      std::cerr << "error: "
+                << re.where << ": " << re.what
+                << std::endl;
+      ec = 10;
+    }
+
+    return ec;
+  }
+
   // Make sure we have all the required parameters
   if ( cpuname.empty() ) {
     std::cerr << "cpuname not specified" << std::endl;
@@ -154,6 +195,7 @@ int main(
     usage();
   }
 
+  rld::tasks::set_jobs( jobs );
 
   // Create toolnames.
   try
@@ -219,8 +261,11 @@ int main(
 
   try
   {
-    objdumpProcessor.loadAddressTable( executableInfo, *objdumpFile, *err );
+    objdumpProcessor.loadAddressTable( executableInfo, *err );
+    log.jobs_m = jobs;
     log.processFile( logname.c_str(), objdumpProcessor );
+    trace.targetInfo_m = targetInfo;
+    trace.setCompressed( compressed );
     trace.writeFile( tracefile.c_str(), &log, verbose );
   }
   catch ( rld::error re )
@@ -20,6 +20,20 @@ namespace Trace {
     {
       traceRange_t t;
 
+      // A block that did not end in a branch and is followed by the block
+      // after it covers the same addresses as one range.
+      if ( !set.empty() ) {
+        traceRange_t& last = set.back();
+        uint32_t      lastEnd = last.lowAddress + last.length;
+        if ( last.exitReason == EXIT_REASON_OTHER &&
+             lastEnd == lowAddressArg &&
+             ( highAddressArg - last.lowAddress ) <= UINT16_MAX ) {
+          last.length     = highAddressArg - last.lowAddress;
+          last.exitReason = why;
+          return;
+        }
+      }
+
       t.lowAddress = lowAddressArg;
       t.length     = highAddressArg - lowAddressArg;
       t.exitReason = why;
@@ -27,6 +41,19 @@ namespace Trace {
       set.push_back( t );
     }
 
+    void TraceList::append( const TraceList& other )
+    {
+      auto ritr = other.set.begin();
+
+      if ( ritr == other.set.end() ) {
+        return;
+      }
+
+      add( ritr->lowAddress, ritr->lowAddress + ritr->length, ritr->exitReason );
+
+      set.insert( set.end(), ++ritr, other.set.end() );
+    }
+
     void TraceList::ShowTrace( traceRange_t *t)
     {
       std::cout << std::hex << "Start 0x" << t->lowAddress
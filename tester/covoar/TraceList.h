@@ -8,8 +8,8 @@
 #define __TRACE_LIST_H__
 
 #include <stdint.h>
-#include <list>
 #include <string>
+#include <vector>
 
 namespace Trace {
 
@@ -57,7 +57,7 @@ namespace Trace {
     /*!
      *  This member variable contains a list of CoverageRange instances.
      */
-    typedef std::list<traceRange_t> ranges_t;
+    typedef std::vector<traceRange_t> ranges_t;
 
     /*!
      *  This member variable contains a list of coverageRange
@@ -76,7 +76,9 @@ namespace Trace {
     ~TraceList();
 
     /*!
-     *  This method adds a range entry to the set of ranges.
+     *  This method adds a range entry to the set of ranges. A range that
+     *  starts where the last range ended is coalesced with the last range
+     *  if the last range did not end with a branch.
      *
      *  @param[in] lowAddressArg specifies the lowest address of the range
      *  @param[in] highAddressArg specifies the highest address of the range
@@ -89,6 +91,15 @@ namespace Trace {
       exitReason_t     why
     );
 
+    /*!
+     *  This method appends the ranges of another trace list to the set of
+     *  ranges. The first range is coalesced with the last range if it can
+     *  be.
+     *
+     *  @param[in] other specifies the trace list to append
+     */
+    void append( const TraceList& other );
+
     /*!
      *  This method displays the trace information in the variable t.
      */
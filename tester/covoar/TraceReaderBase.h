@@ -28,6 +28,11 @@ namespace Trace {
      */
     TraceList Trace;
 
+    /*!
+     *  This member variable is the number of threads a reader can use to
+     *  process a file.
+     */
+    int jobs_m = 1;
 
     /*!
      *  This method constructs a TraceReaderBase instance.
@@ -40,118 +40,222 @@
 #include <sys/stat.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
-#include <fstream>
+#include <vector>
 
 #include "qemu-log.h"
+#include "CoverageReaderBase.h"
 #include "TraceReaderBase.h"
 #include "TraceReaderLogQEMU.h"
 #include "TraceList.h"
 #include "qemu-traces.h"
 
 #include "rld-process.h"
+#include "rld-tasks.h"
 
-bool ReadUntilFound( std::ifstream& file, const char* line )
-{
-  char   discardBuff[100] = {};
-  size_t len = strlen( line );
-
-  if ( len > sizeof( discardBuff ) ) {
-    std::cerr << "ReadUntilFound(): parameter 'line' is too long" << std::endl;
-    return false;
-  }
+namespace Trace {
 
-  do {
-    file.read( discardBuff, sizeof( discardBuff ) - 2 );
-    if ( file.fail() ) {
+  /*
+   * Find the next line in the log. The cursor is moved to the start of the
+   * following line. Return false at the end of the log.
+   */
+  static bool nextLine(
+    const char*& cursor,
+    const char*  end,
+    const char*& line,
+    const char*& lineEnd
+  )
+  {
+    if ( cursor >= end ) {
       return false;
     }
 
-    if ( strncmp( discardBuff, line, len ) == 0 ) {
-      return true;
+    line = cursor;
+    lineEnd = static_cast<const char*>( ::memchr( cursor, '\n', end - cursor ) );
+    if ( lineEnd == nullptr ) {
+      lineEnd = end;
+      cursor = end;
+    } else {
+      cursor = lineEnd + 1;
     }
 
-  } while( true );
-}
+    return true;
+  }
 
-namespace Trace {
+  /*
+   * Return true if the line starts with the key.
+   */
+  static bool lineStartsWith(
+    const char* line,
+    const char* lineEnd,
+    const char* key
+  )
+  {
+    size_t length = ::strlen( key );
+    return ( size_t ) ( lineEnd - line ) >= length &&
+      ::memcmp( line, key, length ) == 0;
+  }
 
-  TraceReaderLogQEMU::TraceReaderLogQEMU()
+  /*
+   * Find the line after the next line starting with the key.
+   */
+  static bool findLine(
+    const char*& cursor,
+    const char*  end,
+    const char*  key
+  )
   {
+    const char* line;
+    const char* lineEnd;
+
+    while ( nextLine( cursor, end, line, lineEnd ) ) {
+      if ( lineStartsWith( line, lineEnd, key ) ) {
+        return true;
+      }
+    }
+
+    return false;
   }
 
-  TraceReaderLogQEMU::~TraceReaderLogQEMU()
+  static bool isSpace( char c )
   {
+    return c == ' ' || c == '\t' || c == '\r';
   }
 
-  bool TraceReaderLogQEMU::processFile(
-    const std::string&          file,
-    Coverage::ObjdumpProcessor& objdumpProcessor
+  static int hexDigit( char c )
+  {
+    if ( c >= '0' && c <= '9' ) {
+      return c - '0';
+    }
+    if ( c >= 'a' && c <= 'f' ) {
+      return c - 'a' + 10;
+    }
+    if ( c >= 'A' && c <= 'F' ) {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  /*
+   * Parse an instruction line of an IN block. The line is the address in
+   * hex, a colon, the instruction and its data. Return false if the line
+   * is not an instruction line.
+   */
+  static bool parseInstruction(
+    const char*          line,
+    const char*          lineEnd,
+    QEMU_LOG_IN_Block_t& block
   )
   {
-    bool                done          = false;
-    QEMU_LOG_IN_Block_t first         = { 0, "", "" };
-    QEMU_LOG_IN_Block_t last          = { 0, "", "" };
-    QEMU_LOG_IN_Block_t nextExecuted  = { 0, "", "" };
-    uint32_t            nextlogical;
-    int                 status;
-    std::ifstream       logFile;
-    int                 result;
-    int                 fileSize;
-    char                ignore;
+    const char*   c = line;
+    unsigned long address = 0;
+    int           digits = 0;
 
-    //
-    // Verify that the log file has a non-zero size.
-    //
-    logFile.open( file, std::ifstream::in | std::ifstream::binary );
-    if ( !logFile.is_open() ) {
-      std::cerr << "Unable to open " << file << std::endl;
-      return false;
+    while ( c < lineEnd && isSpace( *c ) ) {
+      c++;
     }
 
-    logFile.seekg( 0, std::ios::end );
-    fileSize = logFile.tellg();
+    if ( ( lineEnd - c ) > 2 && c[0] == '0' && ( c[1] == 'x' || c[1] == 'X' ) ) {
+      c += 2;
+    }
 
-    if ( fileSize == 0 ) {
-      std::cerr << file << " is 0 bytes long" << std::endl;
+    for ( ; c < lineEnd; c++, digits++ ) {
+      int d = hexDigit( *c );
+      if ( d < 0 ) {
+        break;
+      }
+      address = ( address << 4 ) | d;
+    }
+
+    if ( digits == 0 || c >= lineEnd || *c != ':' ) {
       return false;
     }
+    c++;
 
-    logFile.close();
+    while ( c < lineEnd && isSpace( *c ) ) {
+      c++;
+    }
 
-    //
-    // Open the coverage file and discard the header.
-    //
-    logFile.open( file );
+    const char* instruction = c;
+    while ( c < lineEnd && !isSpace( *c ) ) {
+      c++;
+    }
 
-    //
-    //  Discard Header section
-    //
-    if ( !ReadUntilFound( logFile, QEMU_LOG_SECTION_END ) ) {
-      std::cerr << "Unable to locate end of log file header" << std::endl;
+    if ( c == instruction ) {
       return false;
     }
 
-    //
-    //  Find first IN block
-    //
-    if ( !ReadUntilFound( logFile, QEMU_LOG_IN_KEY ) ) {
-      std::cerr << "Error: Unable to locate first IN: Block in Log file"
-                << std::endl;
-      return false;
+    block.address = address;
+    block.instruction.assign( instruction, c - instruction );
+
+    while ( c < lineEnd && isSpace( *c ) ) {
+      c++;
     }
 
-    //
-    //  Read First Start Address
-    //
-    logFile >> std::hex >> first.address >> std::dec
-            >> ignore
-            >> first.instruction
-            >> first.data;
+    const char* data = c;
+    while ( c < lineEnd && !isSpace( *c ) ) {
+      c++;
+    }
+
+    block.data.assign( data, c - data );
+
+    return true;
+  }
 
-    if ( logFile.fail() ) {
-      std::cerr << "Error Unable to Read Initial First Block" << std::endl;
-      done = true;
+  /*
+   * Find the next IN block and parse its first instruction. The start of
+   * the block's IN line is returned. Return false if there are no more
+   * blocks.
+   */
+  static bool findBlock(
+    const char*&         cursor,
+    const char*          end,
+    QEMU_LOG_IN_Block_t& block,
+    const char*&         blockStart
+  )
+  {
+    const char* line;
+    const char* lineEnd;
+
+    while ( nextLine( cursor, end, line, lineEnd ) ) {
+      if ( lineStartsWith( line, lineEnd, QEMU_LOG_IN_KEY ) ) {
+        blockStart = line;
+        if ( nextLine( cursor, end, line, lineEnd ) &&
+             parseInstruction( line, lineEnd, block ) ) {
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  /*
+   * Process the IN blocks that start in a chunk of the log into the trace
+   * list. The block executed after the last block of the chunk is found in
+   * the rest of the log so the chunks of a log are processed independently.
+   */
+  static void processChunk(
+    const char*                 cursor,
+    const char*                 chunkEnd,
+    const char*                 end,
+    Coverage::ObjdumpProcessor& objdumpProcessor,
+    TraceList&                  trace
+  )
+  {
+    bool                done          = false;
+    QEMU_LOG_IN_Block_t first         = { 0, "", "" };
+    QEMU_LOG_IN_Block_t last          = { 0, "", "" };
+    QEMU_LOG_IN_Block_t nextExecuted  = { 0, "", "" };
+    uint32_t            nextlogical;
+    const char*         blockStart;
+    const char*         line;
+    const char*         lineEnd;
+
+    if ( !findBlock( cursor, end, first, blockStart ) ||
+         blockStart >= chunkEnd ) {
+      return;
     }
 
     while ( !done ) {
@@ -159,27 +263,19 @@ namespace Trace {
       last = first;
 
       // Read until we get to the last instruction in the block.
-      do {
-        logFile >> std::hex >> last.address >> std::dec
-                >> ignore
-                >> last.instruction
-                >> last.data;
-      } while( !logFile.fail() );
+      const char* next = cursor;
+      while ( nextLine( next, end, line, lineEnd ) &&
+              parseInstruction( line, lineEnd, last ) ) {
+        cursor = next;
+      }
 
       nextlogical = objdumpProcessor.getAddressAfter( last.address );
 
-      if ( !ReadUntilFound( logFile, QEMU_LOG_IN_KEY ) ) {
+      if ( !findBlock( cursor, end, nextExecuted, blockStart ) ) {
         done = true;
         nextExecuted = last;
-      } else {
-        logFile >> std::hex >> nextExecuted.address >> std::dec
-                >> ignore
-                >> nextExecuted.instruction
-                >> nextExecuted.data;
-
-        if ( logFile.fail() ) {
-          std::cerr << "Error Unable to Read First Block" << std::endl;
-        }
+      } else if ( blockStart >= chunkEnd ) {
+        done = true;
       }
 
       // If the nextlogical was not found we are throwing away
@@ -194,10 +290,124 @@ namespace Trace {
             reason = TraceList::EXIT_REASON_BRANCH_TAKEN;
           }
         }
-        Trace.add( first.address, nextlogical, reason );
+        trace.add( first.address, nextlogical, reason );
       }
       first = nextExecuted;
     }
+  }
+
+  TraceReaderLogQEMU::TraceReaderLogQEMU()
+  {
+  }
+
+  TraceReaderLogQEMU::~TraceReaderLogQEMU()
+  {
+  }
+
+  bool TraceReaderLogQEMU::processFile(
+    const std::string&          file,
+    Coverage::ObjdumpProcessor& objdumpProcessor
+  )
+  {
+    QEMU_LOG_IN_Block_t first = { 0, "", "" };
+
+    //
+    // Map the log file. The log is scanned in place a line at a time.
+    //
+    Coverage::CoverageFile logFile( file, "TraceReaderLogQEMU::processFile" );
+
+    logFile.wait( logFile.size() );
+
+    //
+    // Verify that the log file has a non-zero size.
+    //
+    if ( logFile.size() == 0 ) {
+      std::cerr << file << " is 0 bytes long" << std::endl;
+      return false;
+    }
+
+    const char* cursor = reinterpret_cast<const char*>( logFile.data() );
+    const char* end = cursor + logFile.size();
+    const char* start;
+    const char* line;
+    const char* lineEnd;
+
+    //
+    //  Discard Header section
+    //
+    if ( !findLine( cursor, end, QEMU_LOG_SECTION_END ) ) {
+      std::cerr << "Unable to locate end of log file header" << std::endl;
+      return false;
+    }
+
+    //
+    //  Find first IN block
+    //
+    if ( !findBlock( cursor, end, first, start ) ) {
+      std::cerr << "Error: Unable to locate first IN: Block in Log file"
+                << std::endl;
+      return false;
+    }
+
+    //
+    // Split the log into chunks that start at an IN block. A block's
+    // successor is found in the following chunk so the chunks are
+    // processed in parallel and their trace lists appended in order.
+    //
+    const size_t             minChunkSize = 4 * 1024 * 1024;
+    const size_t             chunks = std::max<size_t>(
+      std::min<size_t>( std::max( jobs_m, 1 ), ( end - start ) / minChunkSize ),
+      1
+    );
+    std::vector<const char*> bounds;
+
+    bounds.push_back( start );
+
+    for ( size_t c = 1; c < chunks; ++c ) {
+      const char* p = start + ( ( end - start ) / chunks ) * c;
+      if ( p <= bounds.back() ) {
+        continue;
+      }
+      p = static_cast<const char*>( ::memchr( p, '\n', end - p ) );
+      if ( p == nullptr ) {
+        break;
+      }
+      ++p;
+      const char* bound = nullptr;
+      while ( nextLine( p, end, line, lineEnd ) ) {
+        if ( lineStartsWith( line, lineEnd, QEMU_LOG_IN_KEY ) ) {
+          bound = line;
+          break;
+        }
+      }
+      if ( bound == nullptr ) {
+        break;
+      }
+      bounds.push_back( bound );
+    }
+
+    bounds.push_back( end );
+
+    std::vector<TraceList> traces( bounds.size() - 1 );
+
+    if ( traces.size() == 1 ) {
+      processChunk( start, end, end, objdumpProcessor, Trace );
+      return true;
+    }
+
+    rld::tasks::parallel_for(
+      traces.size(),
+      traces.size(),
+      [&]( size_t c ) {
+        processChunk(
+          bounds[ c ], bounds[ c + 1 ], end, objdumpProcessor, traces[ c ]
+        );
+      }
+    );
+
+    for ( const auto& trace : traces ) {
+      Trace.append( trace );
+    }
 
     return true;
   }
@@ -41,17 +41,25 @@
 #include <fstream>
 #include <iomanip>
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
 #include <rld-process.h>
+#include <rld-tasks.h>
 
 #include "TraceWriterQEMU.h"
+#include "CoverageReaderBase.h"
 #include "ExecutableInfo.h"
 #include "CoverageMap.h"
+#include "TraceChunksQEMU.h"
 #include "qemu-traces.h"
 
 namespace Trace {
 
   TraceWriterQEMU::TraceWriterQEMU():
-    TraceWriterBase()
+    TraceWriterBase(),
+    compressed_m( false )
   {
   }
 
@@ -59,33 +67,23 @@ namespace Trace {
   {
   }
 
-  bool TraceWriterQEMU::writeFile(
-    const std::string&      file,
-    Trace::TraceReaderBase* log,
-    bool                    verbose
+  void TraceWriterQEMU::setCompressed( bool compressed )
+  {
+    compressed_m = compressed;
+  }
+
+  bool TraceWriterQEMU::writeHeader(
+    std::ofstream&     traceFile,
+    const std::string& file,
+    bool               verbose
   )
   {
     struct trace_header header;
-    int                 status;
-    std::ofstream       traceFile;
-    uint8_t             taken;
-    uint8_t             notTaken;
-
-    taken    = targetInfo_m->qemuTakenBit();
-    notTaken = targetInfo_m->qemuNotTakenBit();
-
-    //
-    // Verify that the TraceList has a non-zero size.
-    //
-    if ( log->Trace.set.empty() ) {
-      std::cerr << "ERROR: Empty TraceList" << std::endl;
-      return false;
-    }
 
     //
     // Open the trace file.
     //
-    traceFile.open( file );
+    traceFile.open( file, std::ios::out | std::ios::binary );
 
     if ( !traceFile.is_open() ) {
       std::ostringstream what;
@@ -98,7 +96,11 @@ namespace Trace {
     //
     // The header.magic field is actually 12 bytes, but QEMU_TRACE_MAGIC is
     // 13 bytes including the NULL.
-    memcpy( header.magic, QEMU_TRACE_MAGIC, sizeof(header.magic) );
+    memcpy(
+      header.magic,
+      compressed_m ? QEMU_TRACE_CHUNKED_MAGIC : QEMU_TRACE_MAGIC,
+      sizeof(header.magic)
+    );
     header.version          = QEMU_TRACE_VERSION;
     header.kind             = QEMU_TRACE_KIND_RAW;  // XXX ??
     header.sizeof_target_pc = 32;
@@ -126,10 +128,96 @@ namespace Trace {
                 << std::endl;
     }
 
+    if ( compressed_m ) {
+      chunk_m.clear();
+      chunk_m.reserve( chunkEntries );
+    }
+
+    return true;
+  }
+
+  bool TraceWriterQEMU::writeEntry(
+    std::ofstream&              traceFile,
+    const std::string&          file,
+    const struct trace_entry32& entry
+  )
+  {
     //
-    // Loop through log and write each entry.
+    // A chunked trace collects the entries and writes a chunk when it is
+    // full.
     //
+    if ( compressed_m ) {
+      struct trace_entry chunkEntry;
+
+      chunkEntry.pc   = entry.pc;
+      chunkEntry.size = entry.size;
+      chunkEntry.op   = entry.op;
+
+      chunk_m.push_back( chunkEntry );
+
+      if ( chunk_m.size() < chunkEntries ) {
+        return true;
+      }
+
+      writeTraceChunk( traceFile, chunk_m );
+      chunk_m.clear();
+    } else {
+      traceFile.write( (char *) &entry, sizeof( entry ) );
+    }
+
+    if ( traceFile.fail() ) {
+      std::cerr << "Unable to write entry to " << file << std::endl;
+      return false;
+    }
+
+    return true;
+  }
 
+  bool TraceWriterQEMU::writeEnd(
+    std::ofstream&     traceFile,
+    const std::string& file
+  )
+  {
+    if ( !chunk_m.empty() ) {
+      writeTraceChunk( traceFile, chunk_m );
+      chunk_m.clear();
+      if ( traceFile.fail() ) {
+        std::cerr << "Unable to write entry to " << file << std::endl;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool TraceWriterQEMU::writeFile(
+    const std::string&      file,
+    Trace::TraceReaderBase* log,
+    bool                    verbose
+  )
+  {
+    std::ofstream       traceFile;
+    uint8_t             taken;
+    uint8_t             notTaken;
+
+    taken    = targetInfo_m->qemuTakenBit();
+    notTaken = targetInfo_m->qemuNotTakenBit();
+
+    //
+    // Verify that the TraceList has a non-zero size.
+    //
+    if ( log->Trace.set.empty() ) {
+      std::cerr << "ERROR: Empty TraceList" << std::endl;
+      return false;
+    }
+
+    if ( !writeHeader( traceFile, file, verbose ) ) {
+      return false;
+    }
+
+    //
+    // Loop through log and write each entry.
+    //
     for ( const auto& itr : log->Trace.set ) {
       struct trace_entry32 entry;
 
@@ -162,13 +250,171 @@ namespace Trace {
                   << std::endl;
       }
 
-      traceFile.write( (char *) &entry, sizeof( entry ) );
-      if ( traceFile.fail() ) {
-        std::cerr << "Unable to write entry to " << file << std::endl;
+      if ( !writeEntry( traceFile, file, entry ) ) {
         return false;
       }
     }
 
-    return true;
+    return writeEnd( traceFile, file );
+  }
+
+  static void readTrace(
+    const std::string&                      file,
+    bool                                    counts,
+    int                                     jobs,
+    std::unordered_map<uint64_t, uint64_t>& entries
+  )
+  {
+    Coverage::CoverageFile traceFile( file, "TraceWriterQEMU::writeUnion" );
+
+    if (
+      traceFile.size() < sizeof( trace_header ) ||
+      (
+        ::memcmp(
+          traceFile.data(), QEMU_TRACE_MAGIC, sizeof( trace_header::magic )
+        ) != 0 &&
+        !isChunkedTrace( traceFile.data(), traceFile.size() )
+      )
+    ) {
+      throw rld::error(
+        "Not a QEMU trace: " + file, "TraceWriterQEMU::writeUnion"
+      );
+    }
+
+    //
+    // Without counts an entry is a TB and its ops are ORed, with counts
+    // an entry is a TB and its ops and is counted.
+    //
+    auto add = [&]( const trace_entry& entry ) {
+      uint64_t key = ( (uint64_t) entry.pc << 16 ) | entry.size;
+
+      if ( counts ) {
+        ++entries[ ( key << 8 ) | entry.op ];
+      } else {
+        entries[ key ] |= entry.op;
+      }
+    };
+
+    traceFile.wait( traceFile.size() );
+
+    if ( isChunkedTrace( traceFile.data(), traceFile.size() ) ) {
+      readTraceChunks(
+        file,
+        traceFile.data(),
+        traceFile.size(),
+        jobs,
+        [&]( const std::vector<trace_entry>& chunk ) {
+          for ( const auto& entry : chunk ) {
+            add( entry );
+          }
+        }
+      );
+      return;
+    }
+
+    const uint8_t* data = traceFile.data() + sizeof( trace_header );
+    size_t         count =
+      ( traceFile.size() - sizeof( trace_header ) ) / sizeof( trace_entry );
+
+    for ( size_t e = 0; e < count; e++ ) {
+      struct trace_entry entry;
+
+      ::memcpy(
+        &entry, data + ( e * sizeof( trace_entry ) ), sizeof( trace_entry )
+      );
+
+      add( entry );
+    }
+  }
+
+  bool TraceWriterQEMU::writeUnion(
+    const std::string&              file,
+    const std::vector<std::string>& traces,
+    bool                            counts,
+    int                             jobs,
+    bool                            verbose
+  )
+  {
+    std::unordered_map<uint64_t, uint64_t> entries;
+    std::mutex                             entriesLock;
+    std::ofstream                          traceFile;
+    uint64_t                               written = 0;
+
+    //
+    // Read the traces on the worker threads and merge the entries of each
+    // trace into the union.
+    //
+    rld::tasks::parallel_for(
+      traces.size(),
+      jobs,
+      [&]( size_t t ) {
+        std::unordered_map<uint64_t, uint64_t> traceEntries;
+
+        readTrace( traces[ t ], counts, jobs, traceEntries );
+
+        if ( verbose ) {
+          std::lock_guard<std::mutex> guard( entriesLock );
+          std::cerr << traces[ t ] << ": " << traceEntries.size()
+                    << " distinct entries" << std::endl;
+        }
+
+        std::lock_guard<std::mutex> guard( entriesLock );
+
+        for ( const auto& e : traceEntries ) {
+          if ( counts ) {
+            entries[ e.first ] += e.second;
+          } else {
+            entries[ e.first ] |= e.second;
+          }
+        }
+      }
+    );
+
+    if ( entries.empty() ) {
+      std::cerr << "ERROR: Empty traces" << std::endl;
+      return false;
+    }
+
+    //
+    // Write the entries in address order so the union is the same for any
+    // order of the traces.
+    //
+    std::vector<std::pair<uint64_t, uint64_t>> sorted(
+      entries.begin(), entries.end()
+    );
+
+    entries.clear();
+    std::sort( sorted.begin(), sorted.end() );
+
+    if ( !writeHeader( traceFile, file, false ) ) {
+      return false;
+    }
+
+    for ( const auto& e : sorted ) {
+      struct trace_entry32 entry;
+      uint64_t             key = counts ? e.first >> 8 : e.first;
+      uint64_t             repeat = counts ? e.second : 1;
+
+      entry._pad[0] = 0;
+      entry.pc      = (uint32_t) ( key >> 16 );
+      entry.size    = (uint16_t) key;
+      entry.op      = counts ? (uint8_t) e.first : (uint8_t) e.second;
+
+      // A trace entry has no count, the entry is repeated.
+      for ( uint64_t r = 0; r < repeat; r++ ) {
+        if ( !writeEntry( traceFile, file, entry ) ) {
+          return false;
+        }
+      }
+
+      written += repeat;
+    }
+
+    if ( verbose ) {
+      std::cerr << file << ": " << sorted.size() << " distinct entries, "
+                << written << " entries written" << std::endl;
+    }
+
+    return writeEnd( traceFile, file );
   }
 }
@@ -8,11 +8,15 @@
 #define __TRACE_WRITER_QEMU_H__
 
 #include <stdint.h>
+#include <fstream>
+#include <vector>
 #include "TraceReaderBase.h"
 #include "TraceWriterBase.h"
 
 #include "rld-process.h"
 
+#include "qemu-traces.h"
+
 namespace Trace {
 
   /*! @class TraceWriterQEMU
@@ -34,6 +38,14 @@ namespace Trace {
      */
     virtual ~TraceWriterQEMU();
 
+    /*!
+     *  This method sets if the trace is written as a chunked trace with
+     *  the delta encoded entries of each chunk compressed.
+     *
+     *  @param[in] compressed specifies if the trace is chunked
+     */
+    void setCompressed( bool compressed );
+
     /*!
      *  This method writes the specified @a trace file.
      *
@@ -48,6 +60,65 @@ namespace Trace {
        Trace::TraceReaderBase* log,
        bool                    verbose
      );
+
+    /*!
+     *  This method writes the union of the specified QEMU trace files. A
+     *  translation block is written once with the ops of all its entries
+     *  ORed so the union is analysed as all the traces are. With counts
+     *  the entries of a translation block and op are summed and the entry
+     *  is written as many times, a chunked trace stores the repeats in a
+     *  few bytes. The traces may be raw, chunked or compressed.
+     *
+     *  @param[in] file specifies the name of the file to write
+     *  @param[in] traces specifies the trace files to merge
+     *  @param[in] counts specifies if the execution counts are summed
+     *  @param[in] jobs specifies the number of traces read in parallel
+     *  @param[in] verbose specifies whether to be verbose with output
+     *
+     *  @return Returns TRUE if the method succeeded and FALSE if it failed.
+     */
+     bool writeUnion(
+       const std::string&              file,
+       const std::vector<std::string>& traces,
+       bool                            counts,
+       int                             jobs,
+       bool                            verbose
+     );
+
+  private:
+
+    /*!
+     *  This method opens the trace file and writes the header.
+     */
+    bool writeHeader(
+      std::ofstream&     traceFile,
+      const std::string& file,
+      bool               verbose
+    );
+
+    /*!
+     *  This method writes an entry to the trace file.
+     */
+    bool writeEntry(
+      std::ofstream&              traceFile,
+      const std::string&          file,
+      const struct trace_entry32& entry
+    );
+
+    /*!
+     *  This method writes the last chunk of a chunked trace.
+     */
+    bool writeEnd( std::ofstream& traceFile, const std::string& file );
+
+    /*!
+     *  This member variable holds the entries of the chunk being written.
+     */
+    std::vector<trace_entry> chunk_m;
+
+    /*!
+     *  This member variable is TRUE if the trace is chunked.
+     */
+    bool compressed_m;
   };
 
 }
@@ -69,12 +69,13 @@ void usage()
 {
   fprintf(
     stderr,
-    "Usage: %s [-v] -l ADDRESS -h ADDRESS coverage_in coverage_out\n"
+    "Usage: %s [-v] [-z] -l ADDRESS -h ADDRESS coverage_in coverage_out\n"
     "\n"
     "  -l low address   - low address of range to merge\n"
     "  -l high address  - high address of range to merge\n"
     "  -f format        - coverage files are in <format> (Qemu)\n"
     "  -v               - verbose at initialization\n"
+    "  -z               - write the coverage file compressed\n"
     "\n",
     progname
   );
@@ -92,15 +93,17 @@ int main(
   const char* coverageFile;
   const char* coverageIn;
   int         opt;
+  bool        compressed = false;
 
   //
   // Process command line options.
   //
   progname = argv[0];
 
-  while ((opt = getopt(argc, argv, "f:h:l:v")) != -1) {
+  while ((opt = getopt(argc, argv, "f:h:l:vz")) != -1) {
     switch (opt) {
       case 'v': Verbose = 1;       break;
+      case 'z': compressed = true; break;
       case 'f':
         inputFormat = Coverage::CoverageFormatToEnum(optarg);
         format = optarg;
@@ -192,6 +195,7 @@ int main(
     fprintf( stderr, "ERROR: Unable to create coverage file writer.\n\n" );
     exit(-1);
   }
+  coverageWriter->setCompressed( compressed );
 
   // Create coverage reader.
   coverageReader = CreateCoverageReader( inputFormat );
@@ -0,0 +1,296 @@
+/*
+ * covoar-report.js
+ *
+ * The viewer of the JSON coverage reports written by covoar -J. The page
+ * loads the index of a symbol set and fetches each report only when its
+ * tab is first shown. The rows of a report are rendered on demand as they
+ * are scrolled into view so the large reports stay responsive. The
+ * annotated assembly is split into one shard per symbol and a shard is
+ * fetched when the symbol is opened.
+ *
+ * The reports are fetched so the page has to be served over HTTP, for
+ * example with "python3 -m http.server" in the coverage directory.
+ */
+
+var covoarReport = (function() {
+  var rowHeight = 20;
+  var overscan = 20;
+
+  var annotatedClasses = [
+    'code',
+    'codeExecuted',
+    'codeNotExecuted',
+    'codeAlwaysTaken',
+    'codeNeverTaken'
+  ];
+
+  var columns = {
+    uncovered: [
+      [ 'Index', 'index' ],
+      [ 'Symbol', 'symbol' ],
+      [ 'Range', function( r ) {
+          return r.lowLine === undefined ?
+            'not referenced' : r.lowLine + ' .. ' + r.highLine;
+        } ],
+      [ 'Address', function( r ) {
+          return r.lowAddress === undefined ?
+            '' : hex( r.lowAddress ) + ' .. ' + hex( r.highAddress );
+        } ],
+      [ 'Bytes', 'bytes' ],
+      [ 'Instructions', 'instructions' ],
+      [ 'Classification', 'classification' ],
+      [ 'Explanation', 'explanation' ]
+    ],
+    branch: [
+      [ 'Index', 'index' ],
+      [ 'Symbol', 'symbol' ],
+      [ 'Line', 'line' ],
+      [ 'Address', function( r ) { return hex( r.address ); } ],
+      [ 'Bytes', 'bytes' ],
+      [ 'Reason', 'reason' ],
+      [ 'Classification', 'classification' ],
+      [ 'Explanation', 'explanation' ]
+    ],
+    symbolSummary: [
+      [ 'Symbol', 'symbol' ],
+      [ 'Bytes', 'bytes' ],
+      [ 'Instructions', 'instructions' ],
+      [ 'Branches', 'branches' ],
+      [ 'Always Taken', 'alwaysTaken' ],
+      [ 'Never Taken', 'neverTaken' ],
+      [ 'Uncovered Instructions %', 'uncoveredInstructions' ],
+      [ 'Uncovered Bytes %', 'uncoveredBytes' ]
+    ],
+    sizes: [
+      [ 'Bytes', 'bytes' ],
+      [ 'Symbol', 'symbol' ],
+      [ 'Line', 'line' ]
+    ],
+    annotated: [
+      [ 'Symbol', 'title' ],
+      [ 'Lines', 'lines' ]
+    ]
+  };
+
+  function hex( value ) {
+    return value === undefined ? '' : '0x' + value.toString( 16 );
+  }
+
+  function element( tag, className, text ) {
+    var e = document.createElement( tag );
+    if ( className )
+      e.className = className;
+    if ( text !== undefined )
+      e.textContent = text;
+    return e;
+  }
+
+  function fetchReport( file, json ) {
+    return fetch( file ).then( function( response ) {
+      if ( !response.ok )
+        throw new Error( file + ': ' + response.status );
+      return json ? response.json() : response.text();
+    } );
+  }
+
+  function cell( row, column ) {
+    var value = typeof column[1] === 'function' ?
+      column[1]( row ) : row[ column[1] ];
+    if ( value === undefined ) {
+      if ( column[1] === 'bytes' && row.referenced === false )
+        return 'not referenced';
+      return '';
+    }
+    return String( value );
+  }
+
+  /*
+   * A virtual table only holds the rows in view plus some overscan. The
+   * spacer gives the scroll area the height of all the rows.
+   */
+  function VirtualTable( container, cols, onOpen ) {
+    var self = this;
+    this.cols = cols;
+    this.rows = [];
+    this.view = [];
+    this.onOpen = onOpen;
+
+    var header = element( 'table', 'covoar-table' );
+    var tr = element( 'tr', 'covoar-tr-first' );
+    cols.forEach( function( c ) { tr.appendChild( element( 'th', 'covoar-th', c[0] ) ); } );
+    header.appendChild( tr );
+
+    this.scroller = element( 'div' );
+    this.scroller.style.height = '70vh';
+    this.scroller.style.overflowY = 'auto';
+    this.scroller.style.position = 'relative';
+    this.spacer = element( 'div' );
+    this.body = element( 'table', 'covoar-table' );
+    this.body.style.position = 'absolute';
+    this.body.style.top = '0';
+    this.scroller.appendChild( this.spacer );
+    this.scroller.appendChild( this.body );
+    this.scroller.addEventListener( 'scroll', function() { self.render(); } );
+
+    container.appendChild( header );
+    container.appendChild( this.scroller );
+  }
+
+  VirtualTable.prototype.setRows = function( rows ) {
+    this.rows = rows;
+    this.filter( '' );
+  };
+
+  VirtualTable.prototype.filter = function( text ) {
+    var needle = text.toLowerCase();
+    this.view = needle === '' ? this.rows : this.rows.filter( function( r ) {
+      var name = r.symbol !== undefined ? r.symbol : r.title;
+      return String( name ).toLowerCase().indexOf( needle ) >= 0;
+    } );
+    this.spacer.style.height = ( this.view.length * rowHeight ) + 'px';
+    this.scroller.scrollTop = 0;
+    this.render();
+  };
+
+  VirtualTable.prototype.render = function() {
+    var self = this;
+    var first = Math.max(
+      0, Math.floor( this.scroller.scrollTop / rowHeight ) - overscan
+    );
+    var last = Math.min(
+      this.view.length,
+      Math.ceil(
+        ( this.scroller.scrollTop + this.scroller.clientHeight ) / rowHeight
+      ) + overscan
+    );
+
+    this.body.style.top = ( first * rowHeight ) + 'px';
+    this.body.textContent = '';
+    for ( var i = first; i < last; ++i ) {
+      var row = this.view[ i ];
+      var tr = element( 'tr', i % 2 ? 'covoar-tr-odd' : 'covoar-tr-even' );
+      tr.style.height = rowHeight + 'px';
+      this.cols.forEach( function( c ) {
+        tr.appendChild( element( 'td', null, cell( row, c ) ) );
+      } );
+      if ( this.onOpen ) {
+        tr.style.cursor = 'pointer';
+        tr.addEventListener( 'click', ( function( r ) {
+          return function() { self.onOpen( r ); };
+        } )( row ) );
+      }
+      this.body.appendChild( tr );
+    }
+  };
+
+  function showListing( listing, shard ) {
+    listing.textContent = 'Loading ' + shard.shard + ' ...';
+    fetchReport( shard.shard, true ).then( function( lines ) {
+      listing.textContent = '';
+      var pre = null;
+      var state = -1;
+      lines.forEach( function( line ) {
+        if ( pre === null || line[0] !== state ) {
+          state = line[0];
+          pre = element( 'pre', annotatedClasses[ state ] || 'code' );
+          if ( line[1] )
+            pre.id = 'range' + line[1];
+          listing.appendChild( pre );
+        }
+        pre.appendChild( document.createTextNode( line[2] + '\n' ) );
+      } );
+    } ).catch( function( error ) {
+      listing.textContent = String( error );
+    } );
+  }
+
+  function showReport( pane, report ) {
+    if ( report.file.slice( -4 ) === '.txt' ) {
+      var pre = element( 'pre', 'code', 'Loading ...' );
+      pane.appendChild( pre );
+      fetchReport( report.file, false ).then( function( text ) {
+        pre.textContent = text;
+      } ).catch( function( error ) {
+        pre.textContent = String( error );
+      } );
+      return;
+    }
+
+    var name = report.file.replace( /\.json$/, '' );
+    var search = element( 'input' );
+    search.placeholder = 'Filter symbols';
+    pane.appendChild( search );
+
+    var listing = null;
+    var onOpen = null;
+    if ( name === 'annotated' ) {
+      listing = element( 'div' );
+      onOpen = function( shard ) { showListing( listing, shard ); };
+    }
+
+    var table = new VirtualTable( pane, columns[ name ] || [], onOpen );
+    if ( listing )
+      pane.appendChild( listing );
+
+    search.addEventListener( 'input', function() {
+      table.filter( search.value );
+    } );
+
+    var status = element( 'div', 'info', 'Loading ...' );
+    pane.insertBefore( status, search );
+    fetchReport( report.file, true ).then( function( rows ) {
+      status.textContent = rows.length + ' entries';
+      table.setRows( rows );
+    } ).catch( function( error ) {
+      status.textContent = String( error );
+    } );
+  }
+
+  return function( indexFile ) {
+    var root = document.getElementById( 'covoar-report' );
+
+    fetchReport( indexFile, true ).then( function( index ) {
+      var heading = element( 'div', 'heading' );
+      heading.appendChild(
+        element( 'div', 'heading-title', index.project + ' Coverage Report' )
+      );
+      heading.appendChild(
+        element( 'div', 'subheading-title', index.symbolSet )
+      );
+      heading.appendChild( element( 'div', 'datetime', index.datetime ) );
+      root.appendChild( heading );
+
+      var navbar = element( 'ul', 'navbar' );
+      root.appendChild( navbar );
+
+      var panes = [];
+      index.reports.forEach( function( report ) {
+        var pane = element( 'div' );
+        pane.style.display = 'none';
+        pane.loaded = false;
+        panes.push( pane );
+        root.appendChild( pane );
+
+        var tab = element( 'li' );
+        var link = element( 'a', null, report.title );
+        link.href = '#' + report.file;
+        link.addEventListener( 'click', function( event ) {
+          event.preventDefault();
+          panes.forEach( function( p ) { p.style.display = 'none'; } );
+          pane.style.display = 'block';
+          if ( !pane.loaded ) {
+            pane.loaded = true;
+            showReport( pane, report );
+          }
+        } );
+        tab.appendChild( link );
+        navbar.appendChild( tab );
+      } );
+
+      if ( navbar.firstChild )
+        navbar.firstChild.firstChild.click();
+    } ).catch( function( error ) {
+      root.textContent = String( error );
+    } );
+  };
+})();
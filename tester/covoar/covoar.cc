@@ -14,18 +14,33 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <exception>
+#include <fstream>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <rld.h>
+#include <rld-hash.h>
 #include <rld-process.h>
+#include <rld-tasks.h>
 
+#include "CoverageDatabase.h"
 #include "CoverageFactory.h"
 #include "CoverageMap.h"
+#include "CoverageMinimizer.h"
+#include "CoverageReaderBase.h"
+#include "CoverageService.h"
 #include "DesiredSymbols.h"
 #include "ExecutableInfo.h"
 #include "Explanations.h"
+#include "ObjdumpCache.h"
 #include "ObjdumpProcessor.h"
+#include "Timings.h"
 #include "ReportsBase.h"
+#include "SqlExport.h"
 #include "TargetFactory.h"
 #include "GcovData.h"
 
@@ -41,10 +56,39 @@
 
 #define MAX_LINE_LENGTH 512
 
+/*
+ * The command line options. The options of the groups of a multiple group
+ * run are parsed one group at a time as getopt is not reentrant.
+ */
+static const char* const covoarOptions =
+  "1:L:e:c:g:E:f:s:S:T:O:p:j:D:m:w:i:t:H:B:M:P:F:q:C:l:r:nvdxJ";
+static std::mutex        optionsLock;
+
 typedef std::list<std::string>               CoverageNames;
 typedef std::list<Coverage::ExecutableInfo*> Executables;
 typedef std::string                          OptionError;
 
+/*
+ * An executable to load and analyze with the coverage file for it. The
+ * symbols are held until the executable's turn to add them to the
+ * desired symbols. In an incremental run the coverage of an executable
+ * and coverage file seen before is reused from its database.
+ */
+struct ExecutableJob {
+  std::string                                  executableName;
+  std::string                                  libraryName;
+  std::string                                  coverageFileName;
+  Coverage::ExecutableInfo*                    executableInfo = nullptr;
+  Coverage::ObjdumpProcessor::objdumpSymbols_t symbols;
+  bool                                         loaded = false;
+  std::string                                  buildKey;
+  std::string                                  incrementalFileName;
+  Coverage::CoverageDatabase                   reusedCoverage;
+  bool                                         reused = false;
+};
+
+typedef std::vector<ExecutableJob> ExecutableJobs;
+
 bool FileIsReadable( const std::string& f1 )
 {
   struct STAT buf1;
@@ -61,6 +105,38 @@ bool FileIsReadable( const std::string& f1 )
   return true;
 }
 
+/*
+ * A coverage file is readable if it or the coverage file of the first CPU
+ * of an SMP target is readable.
+ */
+bool CoverageIsReadable( const std::string& coverage )
+{
+  return
+    FileIsReadable( coverage ) ||
+    FileIsReadable( Coverage::CoverageReaderBase::cpuFileName( coverage, 0 ) );
+}
+
+/*
+ * The hash of a coverage file or a hash of the hashes of the coverage files
+ * of its CPUs.
+ */
+std::string CoverageHash( const std::string& coverage )
+{
+  if ( FileIsReadable( coverage ) ) {
+    return Coverage::ObjdumpCache::getHash( coverage );
+  }
+
+  rld::hash::hasher hash;
+
+  for (
+    const auto& cpuFile : Coverage::CoverageReaderBase::cpuFileNames( coverage )
+  ) {
+    hash.update( Coverage::ObjdumpCache::getHash( cpuFile ) );
+  }
+
+  return "c-" + hash.hex();
+}
+
 /*
  * Create a build path from the executable paths. Also extract the build prefix
  * and BSP names.
@@ -169,7 +245,8 @@ void usage( const std::string& progname )
             << std::endl
             << "  -v                        - verbose at initialization" << std::endl
             << "  -T TARGET                 - target name" << std::endl
-            << "  -f FORMAT                 - coverage file format (RTEMS, QEMU, TSIM or Skyeye)" << std::endl
+            << "  -f FORMAT                 - coverage file format (RTEMS, RTEMSStream, QEMU, QEMUPlugin," << std::endl
+            << "                              TSIM or Skyeye)" << std::endl
             << "  -E EXPLANATIONS           - name of file with explanations" << std::endl
             << "  -S SYMBOL_SET_FILE        - path to the INI format symbol sets" << std::endl
             << "  -1 EXECUTABLE             - name of executable to get symbols from" << std::endl
@@ -180,28 +257,145 @@ void usage( const std::string& progname )
             << "  -C ConfigurationFileName  - name of configuration file" << std::endl
             << "  -O Output_Directory       - name of output directory (default=." << std::endl
             << "  -d debug                  - disable cleaning of tempfile" << std::endl
+            << "  -j JOBS                   - number of jobs to run in parallel" << std::endl
+            << "                              (default=$" RLD_TASKS_JOBS_ENV " or 1)" << std::endl
+            << "  -n                        - decode the instructions without objdump if the target can" << std::endl
+            << "  -D CACHE_DIRECTORY        - directory to cache the objdump output and symbol sets in" << std::endl
+            << "  -m DATABASE               - merge the coverage database (may be repeated)" << std::endl
+            << "  -w DATABASE               - write the coverage database" << std::endl
+            << "  -i INCREMENTAL_DIRECTORY  - reuse the coverage of the executables and" << std::endl
+            << "                              coverage files not changed since the last run" << std::endl
+            << "  -t TIMINGS                - write the time, memory and counters of each" << std::endl
+            << "                              phase as JSON" << std::endl
+            << "  -H SYMBOL_ORDER           - write the executed symbols most executed first" << std::endl
+            << "                              as an rtems-ld symbol order (-Y)" << std::endl
+            << "  -F DIFF                   - write the coverage gained and lost from the" << std::endl
+            << "                              first to the second database given by -m" << std::endl
+            << "  -x                        - write the execution count profile of each" << std::endl
+            << "                              symbol set (profile.txt)" << std::endl
+            << "  -J                        - write the reports as JSON with a report.html" << std::endl
+            << "                              page loading them instead of the HTML reports" << std::endl
+            << "  -q SQL                    - write the statistics, ranges and line coverage" << std::endl
+            << "                              as an SQL script for SQLite" << std::endl
+            << "  -C COUNTERS               - count the executions in none, 8 or 32 bits," << std::endl
+            << "                              auto counts in 32 bits if an output needs the" << std::endl
+            << "                              counts and else in none (default auto)" << std::endl
+            << "  -B SYMBOLS                - analyze the symbol sets in batches of at most" << std::endl
+            << "                              SYMBOLS symbols to bound the memory used" << std::endl
+            << "  -M GROUPS                 - analyze the groups of executables in the file" << std::endl
+            << "                              GROUPS in parallel" << std::endl
+            << "  -P SECONDS                - write the coverage database given by -w every" << std::endl
+            << "                              SECONDS while an RTEMSStream is read" << std::endl
+            << "  -l SOCKET                 - serve the requests on the UNIX socket SOCKET" << std::endl
+            << "                              with the executables kept loaded" << std::endl
+            << "  -r MINIMAL                - write the fewest executables reaching the" << std::endl
+            << "                              coverage of all of them to MINIMAL, the most" << std::endl
+            << "                              coverage first" << std::endl
+            << std::endl
+            << "Without executables the databases given by -m are merged into the one" << std::endl
+            << "given by -w." << std::endl
+            << std::endl
+            << "Each line of GROUPS holds the options and executables of a group, for" << std::endl
+            << "example a BSP. A group is analyzed with the other options given and its" << std::endl
+            << "own options, such as -T, -f and -O, override them." << std::endl
+            << std::endl
+            << "The service reports the coverage of the executables and coverage files" << std::endl
+            << "given and then answers one request per line. The request" << std::endl
+            << "\"coverage [EXECUTABLE] COVERAGE_FILE\" adds the coverage of a file or" << std::endl
+            << "stream, \"report\" writes the reports and \"quit\" stops the service." << std::endl
             << std::endl;
 }
 
+int covoar( int argc, char** argv );
+
+/*
+ * Analyze each group in the groups file with the common options. The
+ * groups are analyzed on the jobs sharing the one pool of threads.
+ */
+static int covoarGroups(
+  const std::string&              progname,
+  const std::vector<std::string>& commonArguments,
+  const std::string&              groupsFileName,
+  bool                            verbose
+)
+{
+  std::ifstream                         groupsFile( groupsFileName );
+  std::vector<std::vector<std::string>> groups;
+  std::string                           line;
+
+  if ( !groupsFile.is_open() ) {
+    throw rld::error( "Unable to open " + groupsFileName, "covoar" );
+  }
+
+  while ( std::getline( groupsFile, line ) ) {
+    std::istringstream       words( line );
+    std::vector<std::string> arguments;
+    std::string              word;
+
+    while ( words >> word ) {
+      arguments.push_back( word );
+    }
+
+    if ( arguments.empty() || arguments.front()[ 0 ] == '#' ) {
+      continue;
+    }
+
+    groups.push_back( arguments );
+  }
+
+  if ( groups.empty() ) {
+    throw rld::error( "No groups in " + groupsFileName, "covoar" );
+  }
+
+  rld::tasks::parallel_for(
+    groups.size(),
+    0,
+    [&]( size_t g ) {
+      std::vector<std::string> arguments;
+      std::vector<char*>       argv;
+
+      arguments.push_back( progname );
+      arguments.insert(
+        arguments.end(), commonArguments.begin(), commonArguments.end()
+      );
+      arguments.insert( arguments.end(), groups[ g ].begin(), groups[ g ].end() );
+
+      for ( auto& argument : arguments ) {
+        argv.push_back( &argument[ 0 ] );
+      }
+      argv.push_back( nullptr );
+
+      if ( verbose ) {
+        std::lock_guard<std::mutex> guard( optionsLock );
+        std::cerr << "Analyzing group " << g + 1 << ':';
+        for ( const auto& argument : groups[ g ] ) {
+          std::cerr << ' ' << argument;
+        }
+        std::cerr << std::endl;
+      }
+
+      covoar( static_cast<int>( arguments.size() ), argv.data() );
+    }
+  );
+
+  return 0;
+}
+
 int covoar( int argc, char** argv )
 {
   CoverageNames                 coverageFileNames;
   std::string                   coverageFileName;
   Executables                   executablesToAnalyze;
-  Coverage::ExecutableInfo*     executableInfo = NULL;
   std::string                   executableExtension = "exe";
   std::string                   coverageExtension = "cov";
   Coverage::CoverageFormats_t   coverageFormat = Coverage::COVERAGE_FORMAT_QEMU;
   Coverage::CoverageReaderBase* coverageReader = NULL;
   std::string                   explanations;
   std::string                   gcnosFileName;
-  std::string                   gcnoFileName;
   std::string                   target;
   std::string                   format = "QEMU";
   std::ifstream                 gcnosFile;
   std::string                   singleExecutable;
-  rld::process::tempfile        objdumpFile( ".dmp" );
-  rld::process::tempfile        err( ".err" );
   rld::process::tempfile        syms( ".syms" );
   bool                          debug = false;
   std::string                   symbolSet;
@@ -213,14 +407,41 @@ int covoar( int argc, char** argv )
   std::string                   dynamicLibrary;
   std::string                   projectName;
   std::string                   outputDirectory = ".";
-  Coverage::DesiredSymbols      symbolsToAnalyze;
+  Coverage::DesiredSymbols      symbolSets;
   bool                          branchInfoAvailable = false;
+  int                           jobCount = rld::tasks::default_jobs();
+  bool                          useDecoder = false;
+  std::string                   cacheDirectory;
+  std::vector<std::string>      databaseFileNames;
+  std::string                   databaseOutput;
+  Coverage::CoverageDatabase    database;
+  ExecutableJobs                allJobs;
+  int                           batchSymbols = 0;
+  std::string                   timingsFileName;
+  std::string                   symbolOrderFileName;
+  bool                          profile = false;
+  bool                          jsonReports = false;
+  std::string                   diffFileName;
+  std::string                   sqlFileName;
+  std::string                   counters = "auto";
+  std::string                   serviceSocket;
+  std::string                   incrementalDirectory;
+  std::string                   groupsFileName;
+  std::string                   minimalFileName;
+  int                           snapshotSeconds = 0;
+  std::mutex                    snapshotLock;
+  std::vector<std::string>      commonArguments;
+  std::unique_ptr<Coverage::Timings> timings;
 
   //
   // Process command line options.
   //
 
-  while ( (opt = getopt( argc, argv, "1:L:e:c:g:E:f:s:S:T:O:p:vd" )) != -1 ) {
+  std::unique_lock<std::mutex> optionsGuard( optionsLock );
+
+  optind = 1;
+
+  while ( (opt = getopt( argc, argv, covoarOptions )) != -1 ) {
     switch ( opt ) {
       case '1': singleExecutable    = optarg; break;
       case 'L': dynamicLibrary      = optarg; break;
@@ -236,9 +457,149 @@ int covoar( int argc, char** argv )
                 rld::verbose_inc ();          break;
       case 'p': projectName         = optarg; break;
       case 'd': debug               = true;   break;
+      case 'x': profile             = true;   break;
+      case 'J': jsonReports         = true;   break;
+      case 'j': jobCount            = ::atoi( optarg );
+                if ( jobCount < 1 )
+                  throw OptionError( "jobs -j must be 1 or more" );
+                break;
+      case 'n': useDecoder          = true;   break;
+      case 'D': cacheDirectory      = optarg; break;
+      case 'm': databaseFileNames.push_back( optarg ); break;
+      case 'w': databaseOutput      = optarg; break;
+      case 'i': incrementalDirectory = optarg; break;
+      case 't': timingsFileName     = optarg; break;
+      case 'H': symbolOrderFileName = optarg; break;
+      case 'F': diffFileName        = optarg; break;
+      case 'q': sqlFileName         = optarg; break;
+      case 'C': counters            = optarg; break;
+      case 'l': serviceSocket       = optarg; break;
+      case 'r': minimalFileName     = optarg; break;
+      case 'B': batchSymbols        = ::atoi( optarg );
+                if ( batchSymbols < 1 )
+                  throw OptionError( "batch symbols -B must be 1 or more" );
+                break;
+      case 'M': groupsFileName      = optarg; break;
+      case 'P': snapshotSeconds     = ::atoi( optarg );
+                if ( snapshotSeconds < 1 )
+                  throw OptionError( "snapshot seconds -P must be 1 or more" );
+                break;
       default: /* '?' */
         throw OptionError( "unknown option" );
     }
+
+    // Keep the options to pass to each group.
+    if ( opt != 'M' ) {
+      commonArguments.push_back( std::string( "-" ) + static_cast<char>( opt ) );
+      if ( ::strchr( covoarOptions, opt )[ 1 ] == ':' ) {
+        commonArguments.push_back( optarg );
+      }
+    }
+  }
+
+  optionsGuard.unlock();
+
+  /*
+   * Analyze the groups given in a file instead of the executables.
+   */
+  if ( !groupsFileName.empty() ) {
+    if ( !singleExecutable.empty() || optind != argc ) {
+      throw OptionError( "executables are given in the groups -M" );
+    }
+
+    if ( !serviceSocket.empty() ) {
+      throw OptionError( "service -l cannot be used with the groups -M" );
+    }
+
+    rld::tasks::set_jobs( jobCount );
+
+    return covoarGroups( argv[ 0 ], commonArguments, groupsFileName, verbose );
+  }
+
+  rld::tasks::set_jobs( jobCount );
+
+  if ( snapshotSeconds != 0 && databaseOutput.empty() ) {
+    throw OptionError( "snapshots -P need the coverage database -w" );
+  }
+
+  // A coverage stream may be a FIFO or a connection to the target.
+  coverageFormat = Coverage::CoverageFormatToEnum( format );
+
+  bool streaming = coverageFormat == Coverage::COVERAGE_FORMAT_RTEMS_STREAM;
+
+  if ( !timingsFileName.empty() ) {
+    timings.reset( new Coverage::Timings );
+  }
+
+  /*
+   * Compare two coverage databases.
+   */
+  if ( !diffFileName.empty() ) {
+    if (
+      databaseFileNames.size() != 2 ||
+      !singleExecutable.empty() ||
+      optind != argc
+    ) {
+      throw OptionError( "diff -F needs two databases -m and no executables" );
+    }
+
+    Coverage::CoverageDatabase before;
+    Coverage::CoverageDatabase after;
+
+    rld::tasks::parallel_for( 2, jobCount, [&]( size_t d ) {
+      ( d == 0 ? before : after ).load( databaseFileNames[ d ] );
+    } );
+
+    uint64_t uncovered;
+
+    {
+      Coverage::Timings::Scope timing( timings.get(), "CoverageDatabase::diff" );
+      uncovered = before.diff( after, diffFileName );
+    }
+
+    if ( verbose ) {
+      std::cerr << "Wrote coverage diff " << diffFileName << " ("
+                << uncovered << " bytes newly uncovered)" << std::endl;
+    }
+
+    if ( timings ) {
+      timings->write( timingsFileName );
+    }
+
+    return 0;
+  }
+
+  /*
+   * Load the coverage databases to merge.
+   */
+  if ( verbose ) {
+    for ( const auto& dname : databaseFileNames ) {
+      std::cerr << "Loading coverage database " << dname << std::endl;
+    }
+  }
+
+  database.reduce( databaseFileNames, jobCount );
+
+  /*
+   * Without executables only merge the databases.
+   */
+  if (
+    !databaseFileNames.empty() &&
+    singleExecutable.empty() &&
+    optind == argc
+  ) {
+    if ( databaseOutput.empty() ) {
+      throw OptionError( "coverage database -w" );
+    }
+
+    if ( verbose ) {
+      std::cerr << "Writing coverage database " << databaseOutput
+                << " (" << database.size() << " symbols)" << std::endl;
+    }
+
+    database.write( databaseOutput );
+
+    return 0;
   }
 
   /*
@@ -259,6 +620,67 @@ int covoar( int argc, char** argv )
     throw OptionError( "explanations -E" );
   }
 
+  /*
+   * Check the objdump cache directory exists.
+   */
+  if (
+    !cacheDirectory.empty() &&
+    !rld::path::check_directory( cacheDirectory )
+  ) {
+    throw rld::error(
+      "Cache directory not found: " + cacheDirectory,
+      "covoar"
+    );
+  }
+
+  /*
+   * The symbol order, gcov reports, incremental databases and SQL export
+   * need all the symbols at once.
+   */
+  if (
+    batchSymbols != 0 &&
+    (
+      !symbolOrderFileName.empty() ||
+      !gcnosFileName.empty() ||
+      !incrementalDirectory.empty() ||
+      !sqlFileName.empty()
+    )
+  ) {
+    throw OptionError(
+      "batch symbols -B cannot be used with -H, -g, -i or -q"
+    );
+  }
+
+  /*
+   * The service keeps one batch of symbols loaded and adds the coverage
+   * sent to it to the unified coverage maps.
+   */
+  if (
+    !serviceSocket.empty() &&
+    (
+      batchSymbols != 0 ||
+      !incrementalDirectory.empty() ||
+      snapshotSeconds != 0
+    )
+  ) {
+    throw OptionError( "service -l cannot be used with -B, -i or -P" );
+  }
+
+  /*
+   * The minimal executables need the coverage of each executable read
+   * from its own coverage file.
+   */
+  if (
+    !minimalFileName.empty() &&
+    (
+      !singleExecutable.empty() ||
+      !serviceSocket.empty() ||
+      !incrementalDirectory.empty()
+    )
+  ) {
+    throw OptionError( "minimal -r cannot be used with -1, -l or -i" );
+  }
+
   /*
    * Check for project name.
    */
@@ -266,6 +688,35 @@ int covoar( int argc, char** argv )
     throw OptionError( "project name -p" );
   }
 
+  /*
+   * The execution counts are only kept if an output needs them. The HTML
+   * branch report shows the counts of the branches.
+   */
+  Coverage::AddressInfos::CounterWidth counterWidth;
+
+  if ( counters == "auto" ) {
+    bool needCounts =
+      !jsonReports ||
+      profile ||
+      !symbolOrderFileName.empty() ||
+      !gcnosFileName.empty() ||
+      !databaseOutput.empty() ||
+      !incrementalDirectory.empty() ||
+      !sqlFileName.empty();
+
+    counterWidth = needCounts ?
+      Coverage::AddressInfos::COUNTERS_32 :
+      Coverage::AddressInfos::COUNTERS_NONE;
+  } else if ( counters == "none" ) {
+    counterWidth = Coverage::AddressInfos::COUNTERS_NONE;
+  } else if ( counters == "8" ) {
+    counterWidth = Coverage::AddressInfos::COUNTERS_8;
+  } else if ( counters == "32" ) {
+    counterWidth = Coverage::AddressInfos::COUNTERS_32;
+  } else {
+    throw OptionError( "counters -C must be auto, none, 8 or 32" );
+  }
+
   //
   // Find the top of the BSP's build tree and if we have found the top
   // check the executable is under the same path and BSP.
@@ -319,12 +770,23 @@ int covoar( int argc, char** argv )
   std::shared_ptr<Target::TargetBase>
     targetInfo( Target::TargetFactory( buildTarget ) );
 
-  Coverage::ObjdumpProcessor objdumpProcessor( symbolsToAnalyze, targetInfo );
+  std::unique_ptr<Coverage::ObjdumpCache> objdumpCache;
+
+  if ( !cacheDirectory.empty() ) {
+    objdumpCache.reset(
+      new Coverage::ObjdumpCache( cacheDirectory, targetInfo->getObjdump() )
+    );
+  }
 
   //
   // Read symbol configuration file and load needed symbols.
   //
-  symbolsToAnalyze.load( symbolSet, buildTarget, buildBSP, verbose );
+  {
+    Coverage::Timings::Scope timing( timings.get(), "DesiredSymbols::load" );
+    symbolSets.load(
+      symbolSet, buildTarget, buildBSP, verbose, cacheDirectory
+    );
+  }
 
   // If a single executable was specified, process the remaining
   // arguments as coverage file names.
@@ -336,7 +798,7 @@ int covoar( int argc, char** argv )
     } else {
       for ( int i = optind; i < argc; i++ ) {
         // Ensure that the coverage file is readable.
-        if ( !FileIsReadable( argv[i] ) ) {
+        if ( !streaming && !CoverageIsReadable( argv[i] ) ) {
           std::cerr << "warning: Unable to read coverage file: " << argv[i]
                     << std::endl;
         } else {
@@ -344,26 +806,14 @@ int covoar( int argc, char** argv )
         }
       }
 
-      // If there was at least one coverage file, create the
-      // executable information.
-      if ( !coverageFileNames.empty() ) {
-        if ( !dynamicLibrary.empty() ) {
-          executableInfo = new Coverage::ExecutableInfo(
-            singleExecutable.c_str(),
-            dynamicLibrary,
-            verbose,
-            symbolsToAnalyze
-          );
-        } else {
-          executableInfo = new Coverage::ExecutableInfo(
-            singleExecutable.c_str(),
-            "",
-            verbose,
-            symbolsToAnalyze
-          );
-        }
-
-        executablesToAnalyze.push_back( executableInfo );
+      // If there was at least one coverage file or a coverage database,
+      // load the executable. The coverage files are processed once it is
+      // loaded.
+      if ( !coverageFileNames.empty() || !databaseFileNames.empty() ) {
+        ExecutableJob job;
+        job.executableName = singleExecutable;
+        job.libraryName = dynamicLibrary;
+        allJobs.push_back( std::move( job ) );
       }
     }
   } else {
@@ -378,17 +828,23 @@ int covoar( int argc, char** argv )
         coverageFileName = argv[i];
         coverageFileName.append( "." + coverageExtension );
 
-        if ( !FileIsReadable( coverageFileName.c_str() ) ) {
-          std::cerr << "warning: Unable to read coverage file: "
-                    << coverageFileName << std::endl;
+        if ( !streaming && !CoverageIsReadable( coverageFileName ) ) {
+          // The coverage of the executable may be in a database.
+          if ( !databaseFileNames.empty() ) {
+            ExecutableJob job;
+            job.executableName = argv[i];
+            job.libraryName = dynamicLibrary;
+            allJobs.push_back( std::move( job ) );
+          } else {
+            std::cerr << "warning: Unable to read coverage file: "
+                      << coverageFileName << std::endl;
+          }
         } else {
-          executableInfo = new Coverage::ExecutableInfo(
-            argv[i],
-            "",
-            verbose,
-            symbolsToAnalyze
-          );
-          executablesToAnalyze.push_back( executableInfo );
+          ExecutableJob job;
+          job.executableName = argv[i];
+          job.libraryName = dynamicLibrary;
+          job.coverageFileName = coverageFileName;
+          allJobs.push_back( std::move( job ) );
           coverageFileNames.push_back( coverageFileName );
         }
       }
@@ -396,190 +852,775 @@ int covoar( int argc, char** argv )
   }
 
   // Ensure that there is at least one executable to process.
-  if ( executablesToAnalyze.empty() ) {
+  if ( allJobs.empty() ) {
     throw rld::error( "No information to analyze", "covoar" );
   }
 
-  // The executablesToAnalyze and coverageFileNames containers need
-  // to be the name size of some of the code below breaks. Lets
-  // check and make sure.
-  if ( executablesToAnalyze.size() != coverageFileNames.size() ) {
-    throw rld::error(
-      "executables and coverage name size mismatch",
-      "covoar"
-    );
-  }
-
-  if ( verbose ) {
-    std::cerr << "Analyzing " << symbolsToAnalyze.allSymbols().size()
-              << " symbols" << std::endl;
-  }
-
   // Create explanations.
   if ( !explanations.empty() ) {
     allExplanations.load( explanations.c_str() );
   }
 
   // Create coverage map reader.
-  coverageFormat = Coverage::CoverageFormatToEnum( format );
   coverageReader = Coverage::CreateCoverageReader( coverageFormat );
   if ( !coverageReader ) {
     throw rld::error( "Unable to create coverage file reader", "covoar" );
   }
 
   coverageReader->targetInfo_m = targetInfo;
+  coverageReader->jobs_m = jobCount;
+  coverageReader->timings_m = timings.get();
 
-  // Prepare each executable for analysis.
-  for ( auto& exe : executablesToAnalyze ) {
-    if ( verbose ) {
-      std::cerr << "Extracting information from: " << exe->getFileName()
-                << std::endl;
-    }
+  // The phases timed for each coverage file.
+  const std::string readPhase = "CoverageReader" + format + "::processFile";
+  const std::string mergePhase = "DesiredSymbols::mergeCoverageMaps";
 
-    // If a dynamic library was specified, determine the load address.
-    if ( !dynamicLibrary.empty() ) {
-      exe->setLoadAddress( objdumpProcessor.determineLoadAddress( exe ) );
+  //
+  // Group the symbol sets into the batches analyzed one after the other.
+  // Without a limit all the sets are one batch. A set with more symbols
+  // than the limit is a batch of its own.
+  //
+  std::vector<std::vector<std::string>> batches;
+  size_t                                batchSize = 0;
+  uint32_t                              lastRangeId = 0;
+
+  for ( const auto& setName : symbolSets.getSetNames() ) {
+    size_t setSize = symbolSets.getSymbolsForSet( setName ).size();
+
+    if (
+      batches.empty() ||
+      (
+        batchSymbols != 0 &&
+        batchSize + setSize > static_cast<size_t>( batchSymbols )
+      )
+    ) {
+      batches.emplace_back();
+      batchSize = 0;
     }
 
-    // Load the objdump for the symbols in this executable.
-    objdumpProcessor.load( exe, objdumpFile, err, verbose );
+    batches.back().push_back( setName );
+    batchSize += setSize;
   }
 
   //
-  // Analyze the coverage data.
+  // Write the unified coverage of this run and the merged databases and
+  // the explanations that were not found.
   //
+  auto writeResults = [&]( Coverage::Explanations& theExplanations ) {
+    if ( !databaseOutput.empty() ) {
+      if ( verbose ) {
+        std::cerr << "Writing coverage database " << databaseOutput
+                  << std::endl;
+      }
 
-  // Process each executable/coverage file pair.
-  Executables::iterator eitr = executablesToAnalyze.begin();
-  for ( const auto& cname : coverageFileNames ) {
-    Coverage::ExecutableInfo* exe = *eitr;
-    if ( verbose ) {
-      std::cerr << "Processing coverage file " << cname
-                << " for executable " << exe->getFileName()
-                << std::endl;
+      database.setBranchInfoAvailable( branchInfoAvailable );
+      database.write( databaseOutput );
     }
 
-    // Process its coverage file.
-    coverageReader->processFile( cname.c_str(), exe );
-
-    // Merge each symbols coverage map into a unified coverage map.
-    exe->mergeCoverage();
+    if ( !explanations.empty() ) {
+      std::string notFound;
 
-    // DEBUG Print ExecutableInfo content
-    //exe->dumpExecutableInfo();
+      notFound = outputDirectory + "/ExplanationsNotFound.txt";
+      if ( verbose ) {
+        std::cerr << "Writing Not Found Report (" << notFound << ')'
+                  << std::endl;
+      }
 
-    if ( singleExecutable.empty() ) {
-      eitr++;
+      theExplanations.writeNotFound( notFound.c_str() );
     }
-  }
+  };
 
-  // Do necessary preprocessing of uncovered ranges and branches
-  if ( verbose ) {
-    std::cerr << "Preprocess uncovered ranges and branches" << std::endl;
+  std::unique_ptr<Coverage::CoverageMinimizer> minimizer;
+
+  if ( !minimalFileName.empty() ) {
+    minimizer.reset( new Coverage::CoverageMinimizer );
   }
 
-  symbolsToAnalyze.preprocess( symbolsToAnalyze );
+  for ( const auto& batch : batches ) {
+    Coverage::DesiredSymbols symbolsToAnalyze;
+    ExecutableJobs           jobs( allJobs );
+
+    symbolsToAnalyze.setCounterWidth( counterWidth );
+
+    if ( batches.size() > 1 && verbose ) {
+      std::cerr << "Analyzing the symbol sets:";
+      for ( const auto& setName : batch ) {
+        std::cerr << ' ' << setName;
+      }
+      std::cerr << std::endl;
+    }
+
+    symbolsToAnalyze.select( symbolSets, batch );
+
+    Coverage::ObjdumpProcessor objdumpProcessor( symbolsToAnalyze, targetInfo );
+
+    if ( objdumpCache ) {
+      objdumpProcessor.setCache( objdumpCache.get() );
+    }
+
+    objdumpProcessor.setTimings( timings.get() );
+
+    if ( useDecoder ) {
+      if ( targetInfo->hasInstructionDecoder() ) {
+        objdumpProcessor.setUseDecoder( true );
+      } else {
+        std::cerr << "WARNING: no instruction decoder for " << buildTarget
+                  << ", using objdump" << std::endl;
+      }
+    }
 
-  //
-  // Generate Gcov reports
-  //
-  if ( !gcnosFileName.empty() ) {
     if ( verbose ) {
-      std::cerr << "Generating Gcov reports..." << std::endl;
+      std::cerr << "Analyzing " << symbolsToAnalyze.allSymbols().size()
+                << " symbols" << std::endl;
     }
 
-    gcnosFile.open( gcnosFileName );
+    //
+    // Load each executable, generate and process its objdump and, if
+    // there is one coverage file per executable, process the coverage
+    // file. The executables are independent and are loaded on the worker
+    // threads. Each executable's symbols are added to the desired symbols in
+    // the order given on the command line as soon as it and all before it
+    // are loaded.
+    //
+    //
+    // Write the coverage database with the coverage streamed into an
+    // executable so far while the stream is read. The snapshot is the
+    // database of the batches before and the databases merged plus the
+    // executable's coverage. It is renamed into place so a reader never
+    // sees a partial database.
+    //
+    auto snapshot = [&]( Coverage::ExecutableInfo* exe ) {
+      std::lock_guard<std::mutex> guard( snapshotLock );
+      Coverage::CoverageDatabase  live( database );
+      Coverage::CoverageDatabase  current;
+      std::string                 temporary =
+        databaseOutput + '.' + std::to_string( ::getpid() );
+
+      current.addBuild( Coverage::ObjdumpCache::getKey( exe->getFileName() ) );
+      current.update( symbolsToAnalyze, exe );
+      live.merge( current );
+      live.write( temporary );
+
+      if ( ::rename( temporary.c_str(), databaseOutput.c_str() ) != 0 ) {
+        throw rld::error( "Unable to rename " + temporary, "covoar" );
+      }
+
+      if ( timings ) {
+        timings->count( "coverage snapshots" );
+      }
+    };
+
+    if ( snapshotSeconds != 0 ) {
+      coverageReader->snapshot_m = snapshot;
+      coverageReader->snapshotSeconds_m = snapshotSeconds;
+    }
+
+    std::mutex         jobLock;
+    size_t             nextJob = 0;
+    size_t             nextToAdd = 0;
+    std::exception_ptr jobError;
+
+    auto loader = [&]() {
+      rld::process::tempfile err( ".err", false, !debug );
+
+      std::unique_ptr<Coverage::CoverageReaderBase>
+        reader( Coverage::CreateCoverageReader( coverageFormat ) );
+      reader->targetInfo_m = targetInfo;
+      reader->timings_m = timings.get();
+
+      if ( snapshotSeconds != 0 ) {
+        reader->snapshot_m = snapshot;
+        reader->snapshotSeconds_m = snapshotSeconds;
+      }
+
+      while ( true ) {
+        size_t j;
+
+        {
+          std::lock_guard<std::mutex> guard( jobLock );
+          if ( jobError || nextJob >= jobs.size() ) {
+            break;
+          }
+          j = nextJob++;
+        }
+
+        try {
+          ExecutableJob& job = jobs[j];
+
+          if ( verbose ) {
+            std::cerr << "Extracting information from: " << job.executableName
+                      << std::endl;
+          }
+
+          {
+            Coverage::Timings::Scope timing( timings.get(), "ExecutableInfo" );
+            job.executableInfo = new Coverage::ExecutableInfo(
+              job.executableName.c_str(),
+              job.libraryName,
+              verbose,
+              symbolsToAnalyze
+            );
+          }
+
+          // If a dynamic library was specified, determine the load address.
+          if ( !dynamicLibrary.empty() ) {
+            job.executableInfo->setLoadAddress(
+              objdumpProcessor.determineLoadAddress( job.executableInfo )
+            );
+          }
+
+          // Load the objdump for the symbols in this executable.
+          objdumpProcessor.loadSymbols(
+            job.executableInfo,
+            err,
+            verbose,
+            job.symbols
+          );
+
+          // Reuse the coverage of the executable and coverage file if they
+          // have not changed since the last incremental run.
+          if ( !job.coverageFileName.empty() && !incrementalDirectory.empty() ) {
+            Coverage::Timings::Scope timing(
+              timings.get(), "CoverageDatabase::incremental"
+            );
+
+            job.buildKey = Coverage::ObjdumpCache::getKey( job.executableName );
+
+            std::string key =
+              job.buildKey + '-' +
+              CoverageHash( job.coverageFileName );
+
+            rld::path::path_join(
+              incrementalDirectory, key + ".covdb", job.incrementalFileName
+            );
+
+            if ( FileIsReadable( job.incrementalFileName ) ) {
+              try {
+                job.reusedCoverage.load( job.incrementalFileName );
+                job.reused = true;
+              } catch ( rld::error& re ) {
+                std::cerr << "warning: ignoring " << job.incrementalFileName
+                          << ": " << re.what << std::endl;
+              }
+            }
+          }
+
+          // Process its coverage file.
+          if ( job.reused ) {
+            if ( verbose ) {
+              std::cerr << "Reusing the coverage of " << job.coverageFileName
+                        << " for executable " << job.executableName
+                        << std::endl;
+            }
+          } else if ( !job.coverageFileName.empty() ) {
+            if ( verbose ) {
+              std::cerr << "Processing coverage file " << job.coverageFileName
+                        << " for executable " << job.executableName
+                        << std::endl;
+            }
+
+            Coverage::Timings::Scope timing( timings.get(), readPhase );
+            reader->processFile( job.coverageFileName, job.executableInfo );
+          }
+
+          std::lock_guard<std::mutex> guard( jobLock );
 
-    if ( !gcnosFile ) {
-      std::cerr << "Unable to open " << gcnosFileName << std::endl;
+          job.loaded = true;
+
+          while ( nextToAdd < jobs.size() && jobs[nextToAdd].loaded ) {
+            objdumpProcessor.addSymbols(
+              jobs[nextToAdd].executableInfo,
+              jobs[nextToAdd].symbols,
+              verbose
+            );
+            ++nextToAdd;
+          }
+        } catch ( ... ) {
+          std::lock_guard<std::mutex> guard( jobLock );
+          if ( !jobError ) {
+            jobError = std::current_exception();
+          }
+        }
+      }
+
+      //Leave tempfiles around if debug flag (-d) is enabled.
+      if ( debug ) {
+        err.keep();
+      }
+
+      std::lock_guard<std::mutex> guard( jobLock );
+      if ( reader->getBranchInfoAvailable() ) {
+        branchInfoAvailable = true;
+      }
+    };
+
+    size_t workers = std::min( jobs.size(), static_cast<size_t>( jobCount ) );
+
+    if ( workers <= 1 ) {
+      loader();
     } else {
-      while ( gcnosFile >> inputBuffer ) {
-        Gcov::GcovData gcovFile( symbolsToAnalyze );
-        //gcovFile = new Gcov::GcovData( symbolsToAnalyze );
-        gcnoFileName = inputBuffer;
+      rld::tasks::group loaders;
+
+      for ( size_t w = 1; w < workers; ++w ) {
+        loaders.run( loader );
+      }
+
+      loaders.execute( loader );
+      loaders.wait();
+    }
+
+    if ( jobError ) {
+      std::rethrow_exception( jobError );
+    }
+
+    for ( auto& job : jobs ) {
+      executablesToAnalyze.push_back( job.executableInfo );
+    }
+
+    //
+    // Analyze the coverage data.
+    //
+
+    // Process each coverage file for a single executable.
+    if ( !singleExecutable.empty() ) {
+      Coverage::ExecutableInfo* exe = executablesToAnalyze.front();
 
+      for ( const auto& cname : coverageFileNames ) {
         if ( verbose ) {
-          std::cerr << "Processing file: " << gcnoFileName << std::endl;
+          std::cerr << "Processing coverage file " << cname
+                    << " for executable " << exe->getFileName()
+                    << std::endl;
         }
 
-        if ( gcovFile.readGcnoFile( gcnoFileName ) ) {
-          // Those need to be in this order
-          gcovFile.processCounters();
-          gcovFile.writeReportFile();
-          gcovFile.writeGcdaFile();
-          gcovFile.writeGcovFile();
+        // Process its coverage file.
+        {
+          Coverage::Timings::Scope timing( timings.get(), readPhase );
+          coverageReader->processFile( cname.c_str(), exe );
         }
+
+        // Merge each symbols coverage map into a unified coverage map.
+        Coverage::Timings::Scope timing( timings.get(), mergePhase );
+        symbolsToAnalyze.mergeCoverageMaps( { exe }, jobCount );
+      }
+
+      if ( coverageReader->getBranchInfoAvailable() ) {
+        branchInfoAvailable = true;
+      }
+    } else {
+      std::vector<Coverage::ExecutableInfo*> executables(
+        executablesToAnalyze.begin(),
+        executablesToAnalyze.end()
+      );
+
+      // Merge each symbols coverage map into a unified coverage map.
+      {
+        Coverage::Timings::Scope timing( timings.get(), mergePhase );
+        symbolsToAnalyze.mergeCoverageMaps( executables, jobCount );
       }
 
-      gcnosFile.close();
+      // Add the coverage of each executable of this batch to select the
+      // minimal executables from.
+      if ( minimizer ) {
+        Coverage::Timings::Scope timing(
+          timings.get(), "CoverageMinimizer::add"
+        );
+        minimizer->add( symbolsToAnalyze, executables, jobCount );
+      }
+
+      // Merge the reused coverage and save the coverage processed for
+      // the next incremental run.
+      if ( !incrementalDirectory.empty() ) {
+        Coverage::Timings::Scope timing(
+          timings.get(), "CoverageDatabase::incremental"
+        );
+
+        std::vector<ExecutableJob*> processed;
+
+        for ( auto& job : jobs ) {
+          if ( job.reused ) {
+            job.reusedCoverage.mergeInto( symbolsToAnalyze );
+            if ( job.reusedCoverage.getBranchInfoAvailable() ) {
+              branchInfoAvailable = true;
+            }
+          } else if ( !job.incrementalFileName.empty() ) {
+            processed.push_back( &job );
+          }
+        }
+
+        rld::tasks::parallel_for(
+          processed.size(),
+          jobCount,
+          [&]( size_t p ) {
+            ExecutableJob&             job = *processed[ p ];
+            Coverage::CoverageDatabase coverage;
+            std::string                temporary =
+              job.incrementalFileName + '.' + std::to_string( ::getpid() );
+
+            if ( verbose ) {
+              std::cerr << "Writing coverage database "
+                        << job.incrementalFileName << std::endl;
+            }
+
+            coverage.addBuild( job.buildKey );
+            coverage.update( symbolsToAnalyze, job.executableInfo );
+            coverage.setBranchInfoAvailable( branchInfoAvailable );
+            coverage.write( temporary );
+
+            if (
+              ::rename( temporary.c_str(), job.incrementalFileName.c_str() ) != 0
+            ) {
+              throw rld::error( "Unable to rename " + temporary, "covoar" );
+            }
+          }
+        );
+      }
     }
-  }
 
-  // Determine the uncovered ranges and branches.
-  if ( verbose ) {
-    std::cerr << "Computing uncovered ranges and branches" << std::endl;
-  }
+    // Merge the coverage databases into the unified coverage maps.
+    if ( !databaseFileNames.empty() ) {
+      Coverage::Timings::Scope timing(
+        timings.get(), "CoverageDatabase::mergeInto"
+      );
+      database.mergeInto( symbolsToAnalyze );
 
-  symbolsToAnalyze.computeUncovered( verbose );
+      if ( database.getBranchInfoAvailable() ) {
+        branchInfoAvailable = true;
+      }
+    }
 
-  // Calculate remainder of statistics.
-  if ( verbose ) {
-    std::cerr << "Calculate statistics" << std::endl;
-  }
+    // Keep the unified coverage of this batch to write with the merged
+    // databases.
+    if ( !databaseOutput.empty() ) {
+      for ( const auto& exe : executablesToAnalyze ) {
+        database.addBuild( Coverage::ObjdumpCache::getKey( exe->getFileName() ) );
+      }
+
+      database.update( symbolsToAnalyze );
+    }
 
-  symbolsToAnalyze.calculateStatistics();
+    //
+    // Analyze the unified coverage and report it. The service analyzes it
+    // again for each report requested.
+    //
+    auto analyze = [&]( Coverage::Explanations& theExplanations ) {
+      // Do necessary preprocessing of uncovered ranges and branches
+      if ( verbose ) {
+        std::cerr << "Preprocess uncovered ranges and branches" << std::endl;
+      }
 
-  // Look up the source lines for any uncovered ranges and branches.
-  if ( verbose ) {
-    std::cerr << "Looking up source lines for uncovered ranges and branches"
-              << std::endl;
-  }
+      {
+        Coverage::Timings::Scope timing(
+          timings.get(), "DesiredSymbols::preprocess"
+        );
+        symbolsToAnalyze.preprocess( symbolsToAnalyze );
+      }
 
-  symbolsToAnalyze.findSourceForUncovered( verbose, symbolsToAnalyze );
+      //
+      // Generate Gcov reports
+      //
+      if ( !gcnosFileName.empty() ) {
+        if ( verbose ) {
+          std::cerr << "Generating Gcov reports..." << std::endl;
+        }
 
-  //
-  // Report the coverage data.
-  //
-  if ( verbose ) {
-    std::cerr << "Generate Reports" << std::endl;
-  }
+        gcnosFile.open( gcnosFileName );
 
-  for ( const auto& setName : symbolsToAnalyze.getSetNames() ) {
-    branchInfoAvailable = coverageReader->getBranchInfoAvailable();
+        if ( !gcnosFile ) {
+          std::cerr << "Unable to open " << gcnosFileName << std::endl;
+        } else {
+          std::vector<std::string> gcnoFileNames;
 
-    Coverage::GenerateReports(
-      setName,
-      allExplanations,
-      verbose,
-      projectName,
-      outputDirectory,
-      symbolsToAnalyze,
-      branchInfoAvailable
-    );
+          while ( gcnosFile >> inputBuffer ) {
+            gcnoFileNames.push_back( inputBuffer );
+          }
+
+          // Each notes file is processed on its own and only reads the
+          // symbols to analyze.
+          std::mutex gcnoLock;
+
+          rld::tasks::parallel_for(
+            gcnoFileNames.size(),
+            jobCount,
+            [&]( size_t g ) {
+              Gcov::GcovData gcovFile( symbolsToAnalyze );
+              const std::string& gcnoFileName = gcnoFileNames[ g ];
+
+              if ( verbose ) {
+                std::lock_guard<std::mutex> guard( gcnoLock );
+                std::cerr << "Processing file: " << gcnoFileName << std::endl;
+              }
+
+              if ( gcovFile.readGcnoFile( gcnoFileName ) ) {
+                // Those need to be in this order
+                gcovFile.processCounters();
+                gcovFile.writeReportFile();
+                gcovFile.writeGcdaFile();
+                gcovFile.writeGcovFile();
+              }
+            }
+          );
+
+          gcnosFile.close();
+        }
+      }
+
+      // Determine the uncovered ranges and branches.
+      if ( verbose ) {
+        std::cerr << "Computing uncovered ranges and branches" << std::endl;
+      }
+
+      {
+        Coverage::Timings::Scope timing(
+          timings.get(), "DesiredSymbols::computeUncovered"
+        );
+        symbolsToAnalyze.computeUncovered( verbose, lastRangeId, jobCount );
+      }
+
+      // Calculate remainder of statistics.
+      if ( verbose ) {
+        std::cerr << "Calculate statistics" << std::endl;
+      }
+
+      {
+        Coverage::Timings::Scope timing(
+          timings.get(), "DesiredSymbols::calculateStatistics"
+        );
+        symbolsToAnalyze.calculateStatistics( jobCount );
+      }
+
+      // Write the symbol order for the linker.
+      if ( !symbolOrderFileName.empty() ) {
+        if ( verbose ) {
+          std::cerr << "Writing symbol order (" << symbolOrderFileName << ')'
+                    << std::endl;
+        }
+
+        Coverage::Timings::Scope timing(
+          timings.get(), "DesiredSymbols::writeSymbolOrder"
+        );
+        symbolsToAnalyze.writeSymbolOrder( symbolOrderFileName );
+      }
+
+      // Look up the source lines for any uncovered ranges and branches.
+      if ( verbose ) {
+        std::cerr << "Looking up source lines for uncovered ranges and branches"
+                  << std::endl;
+      }
+
+      {
+        Coverage::Timings::Scope timing(
+          timings.get(), "DesiredSymbols::findSourceForUncovered"
+        );
+        symbolsToAnalyze.findSourceForUncovered( verbose, symbolsToAnalyze );
+      }
+
+      //
+      // Report the coverage data.
+      //
+      if ( verbose ) {
+        std::cerr << "Generate Reports" << std::endl;
+      }
+
+      {
+        Coverage::Timings::Scope timing( timings.get(), "GenerateReports" );
+
+        Coverage::GenerateReports(
+          symbolsToAnalyze.getSetNames(),
+          theExplanations,
+          verbose,
+          projectName,
+          outputDirectory,
+          symbolsToAnalyze,
+          branchInfoAvailable,
+          jobCount,
+          timings.get(),
+          profile,
+          jsonReports
+        );
+      }
+
+      // Export the results for the dashboards.
+      if ( !sqlFileName.empty() ) {
+        if ( verbose ) {
+          std::cerr << "Writing SQL export " << sqlFileName << std::endl;
+        }
+
+        Coverage::Timings::Scope timing( timings.get(), "WriteSqlExport" );
+
+        Coverage::WriteSqlExport(
+          sqlFileName,
+          symbolsToAnalyze.getSetNames(),
+          symbolsToAnalyze,
+          projectName,
+          branchInfoAvailable,
+          time( NULL )
+        );
+      }
+    };
+
+    analyze( allExplanations );
+
+    //
+    // Serve the requests with the executables and the unified coverage
+    // maps of the batch kept loaded. The coverage of each file sent is
+    // read into the maps of its executable, which are cleared before, and
+    // merged into the unified coverage maps and the database.
+    //
+    if ( !serviceSocket.empty() ) {
+      Coverage::CoverageService service( serviceSocket );
+
+      writeResults( allExplanations );
+
+      service.addCommand(
+        "coverage",
+        "[EXECUTABLE] COVERAGE_FILE",
+        [&]( const std::vector<std::string>& arguments ) {
+          Coverage::ExecutableInfo* exe = nullptr;
+
+          if ( arguments.size() == 1 && executablesToAnalyze.size() == 1 ) {
+            exe = executablesToAnalyze.front();
+          } else if ( arguments.size() == 2 ) {
+            for ( const auto& e : executablesToAnalyze ) {
+              if (
+                e->getFileName() == arguments[ 0 ] ||
+                rld::path::basename( e->getFileName() ) == arguments[ 0 ] ||
+                rld::path::path_abs( e->getFileName() ) ==
+                  rld::path::path_abs( arguments[ 0 ] )
+              ) {
+                exe = e;
+                break;
+              }
+            }
+
+            if ( exe == nullptr ) {
+              throw rld::error( "Executable not loaded: " + arguments[ 0 ],
+                                "coverage" );
+            }
+          } else {
+            throw rld::error(
+              "expected [EXECUTABLE] COVERAGE_FILE", "coverage"
+            );
+          }
+
+          const std::string& cname = arguments.back();
+
+          if ( !streaming && !CoverageIsReadable( cname ) ) {
+            throw rld::error( "Unable to read coverage file: " + cname,
+                              "coverage" );
+          }
+
+          exe->clearCoverage();
+
+          if ( verbose ) {
+            std::cerr << "Processing coverage file " << cname
+                      << " for executable " << exe->getFileName()
+                      << std::endl;
+          }
+
+          {
+            Coverage::Timings::Scope timing( timings.get(), readPhase );
+            coverageReader->processFile( cname, exe );
+          }
+
+          if ( coverageReader->getBranchInfoAvailable() ) {
+            branchInfoAvailable = true;
+          }
+
+          {
+            Coverage::Timings::Scope timing( timings.get(), mergePhase );
+            symbolsToAnalyze.mergeCoverageMaps( { exe }, jobCount );
+          }
+
+          if ( !databaseOutput.empty() ) {
+            Coverage::CoverageDatabase current;
+
+            current.addBuild(
+              Coverage::ObjdumpCache::getKey( exe->getFileName() )
+            );
+            current.update( symbolsToAnalyze, exe );
+            database.merge( current );
+          }
+
+          if ( timings ) {
+            timings->count( "service coverage files" );
+          }
+
+          return std::string();
+        }
+      );
+
+      service.addCommand(
+        "report",
+        "",
+        [&]( const std::vector<std::string>& ) {
+          // The explanations are loaded again to find the ones not used by
+          // this report.
+          Coverage::Explanations requestExplanations;
+
+          if ( !explanations.empty() ) {
+            requestExplanations.load( explanations );
+          }
+
+          symbolsToAnalyze.clearAnalysis();
+          lastRangeId = 0;
+
+          analyze( requestExplanations );
+          writeResults( requestExplanations );
+
+          if ( timings ) {
+            timings->count( "service reports" );
+          }
+
+          return std::string();
+        }
+      );
+
+      service.run( verbose );
+    }
+
+    // Release the batch's executables before the next batch.
+    for ( auto& exe : executablesToAnalyze ) {
+      delete exe;
+    }
+    executablesToAnalyze.clear();
   }
 
-  // Write explanations that were not found.
-  if ( !explanations.empty() ) {
-    std::string notFound;
+  // The service wrote the results of each report.
+  if ( serviceSocket.empty() ) {
+    writeResults( allExplanations );
+  }
+
+  if ( minimizer ) {
+    {
+      Coverage::Timings::Scope timing(
+        timings.get(), "CoverageMinimizer::minimize"
+      );
+      minimizer->minimize( jobCount );
+    }
 
-    notFound = outputDirectory + "/ExplanationsNotFound.txt";
     if ( verbose ) {
-      std::cerr << "Writing Not Found Report (" << notFound<< ')' << std::endl;
+      std::cerr << "Writing minimal executables " << minimalFileName << " ("
+                << minimizer->getSelected() << " of " << allJobs.size()
+                << ')' << std::endl;
     }
 
-    allExplanations.writeNotFound( notFound.c_str() );
+    minimizer->write( minimalFileName );
+
+    if ( timings ) {
+      timings->count( "minimal executables", minimizer->getSelected() );
+    }
   }
 
   //Leave tempfiles around if debug flag (-d) is enabled.
   if ( debug ) {
-    objdumpFile.override( "objdump_file" );
-    objdumpFile.keep();
-    err.override( "objdump_exec_log" );
-    err.keep();
     syms.override( "symbols_list" );
     syms.keep();
   }
 
+  if ( timings ) {
+    timings->write( timingsFileName );
+  }
+
   return 0;
 }
 
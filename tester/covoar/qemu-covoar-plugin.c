@@ -0,0 +1,236 @@
+/*! @file qemu-covoar-plugin.c
+ *  @brief QEMU TCG Coverage Plugin
+ *
+ *  This file contains a QEMU TCG plugin that streams the executed
+ *  translation blocks to covoar. The stream is specified in
+ *  qemu-plugin-stream.h. A block's record is sent when the next block
+ *  executed on the same processor is known so the direction it left the
+ *  block is known.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <qemu-plugin.h>
+
+#include "qemu-plugin-stream.h"
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+/*
+ * A translated block. It is the callback data of its exec callback.
+ */
+struct block {
+  uint64_t pc;
+  uint32_t size;
+};
+
+/*
+ * The size of the write buffer.
+ */
+#define BUFFER_SIZE (64 * 1024)
+
+static pthread_mutex_t      lock = PTHREAD_MUTEX_INITIALIZER;
+static int                  out = -1;
+static uint8_t              buffer[BUFFER_SIZE];
+static size_t               level;
+static const struct block** last;
+static unsigned int         vcpus;
+
+static void put_word( uint8_t* p, uint32_t value )
+{
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+static void flush( void )
+{
+  size_t done = 0;
+
+  while ( out >= 0 && done < level ) {
+    ssize_t w = write( out, buffer + done, level - done );
+    if ( w < 0 ) {
+      if ( errno == EINTR )
+        continue;
+      fprintf( stderr, "qemu-covoar: write: %s\n", strerror( errno ) );
+      close( out );
+      out = -1;
+      break;
+    }
+    done += w;
+  }
+  level = 0;
+}
+
+static void put_record( const struct block* b, uint8_t direction )
+{
+  uint8_t* p;
+
+  if ( ( level + sizeof( struct qemu_plugin_stream_record ) ) > BUFFER_SIZE )
+    flush();
+
+  p = buffer + level;
+  memset( p, 0, sizeof( struct qemu_plugin_stream_record ) );
+  put_word( p, b->pc );
+  put_word( p + 4, b->pc >> 32 );
+  put_word( p + 8, b->size );
+  p[12] = direction;
+
+  level += sizeof( struct qemu_plugin_stream_record );
+}
+
+static void vcpu_tb_exec( unsigned int vcpu_index, void* data )
+{
+  const struct block* b = data;
+
+  pthread_mutex_lock( &lock );
+
+  if ( vcpu_index >= vcpus ) {
+    unsigned int         count = vcpu_index + 1;
+    const struct block** l = realloc( last, count * sizeof( *last ) );
+    if ( l == NULL ) {
+      pthread_mutex_unlock( &lock );
+      return;
+    }
+    memset( l + vcpus, 0, ( count - vcpus ) * sizeof( *last ) );
+    last = l;
+    vcpus = count;
+  }
+
+  if ( last[vcpu_index] != NULL ) {
+    const struct block* prev = last[vcpu_index];
+    put_record(
+      prev,
+      ( prev->pc + prev->size ) == b->pc ?
+        QEMU_PLUGIN_STREAM_FALL_THROUGH : QEMU_PLUGIN_STREAM_JUMP
+    );
+  }
+
+  last[vcpu_index] = b;
+
+  pthread_mutex_unlock( &lock );
+}
+
+static void vcpu_tb_trans( qemu_plugin_id_t id, struct qemu_plugin_tb* tb )
+{
+  size_t                     insns = qemu_plugin_tb_n_insns( tb );
+  struct qemu_plugin_insn*   insn;
+  struct block*              b;
+
+  if ( insns == 0 )
+    return;
+
+  b = malloc( sizeof( *b ) );
+  if ( b == NULL )
+    return;
+
+  insn = qemu_plugin_tb_get_insn( tb, insns - 1 );
+
+  b->pc = qemu_plugin_tb_vaddr( tb );
+  b->size = qemu_plugin_insn_vaddr( insn ) + qemu_plugin_insn_size( insn ) -
+    b->pc;
+
+  qemu_plugin_register_vcpu_tb_exec_cb(
+    tb, vcpu_tb_exec, QEMU_PLUGIN_CB_NO_REGS, b
+  );
+}
+
+static void plugin_exit( qemu_plugin_id_t id, void* p )
+{
+  unsigned int v;
+
+  pthread_mutex_lock( &lock );
+
+  for ( v = 0; v < vcpus; ++v ) {
+    if ( last[v] != NULL )
+      put_record( last[v], QEMU_PLUGIN_STREAM_END );
+    last[v] = NULL;
+  }
+
+  flush();
+
+  if ( out >= 0 )
+    close( out );
+  out = -1;
+
+  pthread_mutex_unlock( &lock );
+}
+
+static int open_socket( const char* path )
+{
+  struct sockaddr_un addr;
+  int                fd;
+
+  if ( strlen( path ) >= sizeof( addr.sun_path ) ) {
+    fprintf( stderr, "qemu-covoar: socket path too long: %s\n", path );
+    return -1;
+  }
+
+  memset( &addr, 0, sizeof( addr ) );
+  addr.sun_family = AF_UNIX;
+  strncpy( addr.sun_path, path, sizeof( addr.sun_path ) - 1 );
+
+  fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( fd < 0 ) {
+    fprintf( stderr, "qemu-covoar: socket: %s\n", strerror( errno ) );
+    return -1;
+  }
+
+  if ( connect( fd, (struct sockaddr*) &addr, sizeof( addr ) ) < 0 ) {
+    fprintf( stderr, "qemu-covoar: connect: %s: %s\n",
+             path, strerror( errno ) );
+    close( fd );
+    return -1;
+  }
+
+  return fd;
+}
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(
+  qemu_plugin_id_t       id,
+  const qemu_info_t*     info,
+  int                    argc,
+  char**                 argv
+)
+{
+  int i;
+
+  for ( i = 0; i < argc; ++i ) {
+    if ( strncmp( argv[i], "socket=", 7 ) == 0 ) {
+      out = open_socket( argv[i] + 7 );
+    } else if ( strncmp( argv[i], "file=", 5 ) == 0 ) {
+      out = open( argv[i] + 5, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if ( out < 0 )
+        fprintf( stderr, "qemu-covoar: open: %s: %s\n",
+                 argv[i] + 5, strerror( errno ) );
+    } else {
+      fprintf( stderr, "qemu-covoar: invalid option: %s\n", argv[i] );
+      return -1;
+    }
+  }
+
+  if ( out < 0 ) {
+    fprintf( stderr, "qemu-covoar: no socket or file\n" );
+    return -1;
+  }
+
+  memcpy( buffer, QEMU_PLUGIN_STREAM_MAGIC, 8 );
+  put_word( buffer + 8, QEMU_PLUGIN_STREAM_VERSION );
+  put_word( buffer + 12, sizeof( struct qemu_plugin_stream_record ) );
+  level = sizeof( struct qemu_plugin_stream_header );
+
+  qemu_plugin_register_vcpu_tb_trans_cb( id, vcpu_tb_trans );
+  qemu_plugin_register_atexit_cb( id, plugin_exit, NULL );
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+/*! @file qemu-plugin-stream.h
+ *  @brief QEMU Coverage Plugin Stream Specification
+ *
+ *  This file contains the specification of the stream of coverage
+ *  records the covoar QEMU TCG plugin sends to covoar. It is shared by
+ *  the plugin and the reader and is C.
+ *
+ *  The stream is a header followed by records. All fields are little
+ *  endian. The plugin sends a record for each translation block (TB)
+ *  executed once the TB executed after it on the same processor is known.
+ *  The record holds the direction the processor left the TB:
+ *
+ *    - fall through: the next TB starts at the end of the TB, the branch
+ *      ending the TB was not taken.
+ *    - jump: the next TB starts elsewhere, the branch ending the TB was
+ *      taken.
+ *    - end: the processor stopped, the direction is not known.
+ *
+ *  The reader maps the directions to the target's QEMU taken and not
+ *  taken trace bits so the coverage is the same as a trace converted
+ *  from a QEMU log.
+ *
+ *  The plugin is loaded with:
+ *
+ *    -plugin libqemu-covoar.so,socket=PATH   connect to covoar at PATH
+ *    -plugin libqemu-covoar.so,file=PATH     write a file or FIFO at PATH
+ *
+ *  covoar reads the stream with the QEMUPlugin coverage format. A
+ *  coverage file that is a regular file or a FIFO is read as it is
+ *  written, otherwise covoar listens on a UNIX socket at the path and
+ *  reads the stream of the plugin that connects to it.
+ */
+
+#ifndef __QEMU_PLUGIN_STREAM_H__
+#define __QEMU_PLUGIN_STREAM_H__
+
+#include <stdint.h>
+
+/*
+ * The stream header.
+ */
+#define QEMU_PLUGIN_STREAM_MAGIC   "#COVSTRM"
+#define QEMU_PLUGIN_STREAM_VERSION 1
+
+struct qemu_plugin_stream_header {
+  char     magic[8];
+  uint32_t version;
+  uint32_t record_size;
+};
+
+/*
+ * The directions a processor leaves a TB.
+ */
+#define QEMU_PLUGIN_STREAM_END          0
+#define QEMU_PLUGIN_STREAM_FALL_THROUGH 1
+#define QEMU_PLUGIN_STREAM_JUMP         2
+
+/*
+ * A record of an executed TB.
+ */
+struct qemu_plugin_stream_record {
+  uint64_t pc;
+  uint32_t size;
+  uint8_t  direction;
+  uint8_t  _pad[3];
+};
+
+#endif
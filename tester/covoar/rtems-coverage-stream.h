@@ -0,0 +1,47 @@
+/*! @file rtems-coverage-stream.h
+ *  @brief RTEMS Coverage Stream Specification
+ *
+ *  This file contains the specification of the stream of coverage deltas
+ *  a target running RTEMS sends to covoar while a test runs. It is C so
+ *  it can be shared with the target code sending the stream.
+ *
+ *  The stream is a header followed by deltas. All fields are little
+ *  endian. A delta is the start address and length of a range of the
+ *  target's coverage map followed by a byte for each address of the
+ *  range. The address was executed if its byte is not zero. A target
+ *  sends the ranges of its coverage map that changed since the last
+ *  delta, an address sent more than once counts as executed once.
+ *
+ *  covoar reads the stream with the RTEMSStream coverage format. A
+ *  coverage file that is a regular file or a FIFO is read as it is
+ *  written, a coverage file of the form HOST:PORT connects to the target
+ *  as rtems-record does and reads the stream until the target closes
+ *  the connection.
+ */
+
+#ifndef __RTEMS_COVERAGE_STREAM_H__
+#define __RTEMS_COVERAGE_STREAM_H__
+
+#include <stdint.h>
+
+/*
+ * The stream header.
+ */
+#define RTEMS_COVERAGE_STREAM_MAGIC   "#COVRTMS"
+#define RTEMS_COVERAGE_STREAM_VERSION 1
+
+struct rtems_coverage_stream_header {
+  char     magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+/*
+ * The header of a delta. The length bytes of the range follow it.
+ */
+struct rtems_coverage_stream_delta {
+  uint32_t start;
+  uint32_t length;
+};
+
+#endif
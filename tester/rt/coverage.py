@@ -226,10 +226,12 @@ class report_gen_html:
     def add_covoar_css(self):
         table_js_path = path.join(self.covoar_src_path, 'table.js')
         covoar_css_path = path.join(self.covoar_src_path, 'covoar.css')
+        report_js_path = path.join(self.covoar_src_path, 'covoar-report.js')
         coverage_directory = path.join(self.build_dir,
                                     self.bsp + '-coverage')
         path.copy_tree(covoar_css_path, coverage_directory)
         path.copy_tree(table_js_path, coverage_directory)
+        path.copy_tree(report_js_path, coverage_directory)
 
     def add_dir_name(self):
         for symbol_set in self.symbol_sets:
@@ -33,14 +33,20 @@
 
 #include <sys/types.h>
 
+#include <array>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <csignal>
+#include <deque>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
-#include <list>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -66,10 +72,16 @@ class FileDescriptor {
 
   void Open(const char* file);
 
-  void Connect(const char* host, uint16_t port);
+  // Connects to the host.  A receive buffer size of zero keeps the default
+  // socket receive buffer.
+  void Connect(const char* host, uint16_t port, size_t receive_buffer_size);
 
   ssize_t Read(void* buf, size_t n) { return (*reader_)(fd_, buf, n); }
 
+  int fd() const { return fd_; }
+
+  void Shutdown();
+
   void Destroy();
 
  private:
@@ -114,7 +126,12 @@ class Filter {
 
   virtual ~Filter() = default;
 
-  virtual bool Run(void** buf, size_t* n) = 0;
+  // Decodes the input into the output buffer.  On entry, *in_n is the size
+  // of the input and *out_n the size of the output buffer.  On return, *in_n
+  // is the count of input bytes consumed and *out_n the count of output bytes
+  // produced.  A filter may hold back input or output, it is processed by
+  // subsequent calls, possibly with an empty input.
+  virtual bool Run(const void* in, size_t* in_n, void* out, size_t* out_n) = 0;
 };
 
 class Base64Filter : public Filter {
@@ -127,7 +144,7 @@ class Base64Filter : public Filter {
 
   virtual ~Base64Filter() = default;
 
-  virtual bool Run(void** buf, size_t* n);
+  virtual bool Run(const void* in, size_t* in_n, void* out, size_t* out_n);
 
  private:
   int digits_ = 0;
@@ -148,14 +165,365 @@ class ZlibFilter : public Filter {
 
   virtual ~ZlibFilter();
 
-  virtual bool Run(void** buf, size_t* n);
+  virtual bool Run(const void* in, size_t* in_n, void* out, size_t* out_n);
 
  private:
   z_stream stream_;
-  std::vector<Bytef> buffer_;
 };
 #endif
 
+// A lock-free ring of data blocks for one producer and one consumer thread.
+// A block of size zero marks the end of the data.
+class BlockRing {
+ public:
+  struct Block {
+    std::vector<uint8_t> data;
+    size_t size = 0;
+  };
+
+  BlockRing(size_t count, size_t block_size);
+
+  BlockRing(const BlockRing&) = delete;
+
+  BlockRing& operator=(const BlockRing&) = delete;
+
+  // Returns the next free block or nullptr if the ring is full.
+  Block* Free();
+
+  // Waits for a free block, returns nullptr if the ring was cancelled.
+  Block* WaitFree();
+
+  void Push();
+
+  // Returns the next filled block or nullptr if the ring is empty.
+  Block* Front();
+
+  // Waits for a filled block, returns nullptr if the ring was cancelled.
+  Block* WaitFront();
+
+  void Pop();
+
+  // Copies the data into as many blocks as necessary.
+  bool Write(const void* buf, size_t n);
+
+  // Pushes the end of data block.
+  void Close();
+
+  void Cancel() { cancel_.store(true, std::memory_order_relaxed); }
+
+  bool cancelled() const { return cancel_.load(std::memory_order_relaxed); }
+
+  // Returns the count of filled blocks, it may be called by any thread.
+  size_t size() const {
+    return head_.value.load(std::memory_order_acquire) -
+           tail_.value.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return blocks_.size(); }
+
+  static void Wait(int* spins);
+
+ private:
+  // Keeps the producer and consumer indices in separate cache lines
+  struct Index {
+    std::atomic<size_t> value{0};
+    char pad[64 - sizeof(std::atomic<size_t>)];
+  };
+
+  std::vector<Block> blocks_;
+  Index head_;
+  Index tail_;
+  std::atomic<bool> cancel_{false};
+};
+
+// Describes a chunk of a recording file
+struct RecordingChunk {
+  // The chunk of the items before the first item with a time
+  static const uint32_t kPrologue = 0x1;
+
+  // The chunk is compressed with zlib
+  static const uint32_t kCompressed = 0x2;
+
+  uint64_t offset;
+  uint64_t bt_begin;
+  uint64_t bt_end;
+  uint32_t cpu_mask;
+  uint32_t flags;
+  uint32_t data_size;
+};
+
+struct RecordingItem {
+  uint64_t bt;
+  uint32_t cpu;
+  rtems_record_event event;
+  uint64_t data;
+};
+
+// Writes decoded record items to a compact, chunked host file.  The file
+// starts with a header and continues with chunks of items.  Each chunk header
+// carries the time range and processor set of the chunk, so that a file of an
+// interrupted capture can still be scanned.  The file ends with an index of
+// the chunks.  The items of a chunk are encoded with variable-length integers
+// and the time of an item is the difference to the previous item of the same
+// processor.  Chunks are compressed with zlib if available.
+class RecordingWriter {
+ public:
+  RecordingWriter() = default;
+
+  RecordingWriter(const RecordingWriter&) = delete;
+
+  RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+  ~RecordingWriter();
+
+  void Open(const char* file);
+
+  void Write(uint64_t bt,
+             uint32_t cpu,
+             rtems_record_event event,
+             uint64_t data,
+             size_t data_size);
+
+  // Writes the pending chunk and the index.
+  void Close();
+
+ private:
+  FILE* file_ = nullptr;
+  uint64_t offset_ = 0;
+  bool prologue_ = true;
+  std::vector<uint8_t> chunk_;
+  std::vector<uint8_t> compressed_;
+  uint32_t count_ = 0;
+  uint32_t data_size_ = 0;
+  uint64_t bt_begin_ = 0;
+  uint64_t bt_end_ = 0;
+  uint32_t cpu_mask_ = 0;
+  uint64_t last_bt_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
+  std::vector<RecordingChunk> index_;
+
+  void WriteChunk();
+
+  void WriteBytes(const void* buf, size_t n);
+};
+
+// Reads the chunks of a file written by RecordingWriter.  The chunks are
+// compressed independently, so that the stored data of the chunks may be
+// read in order and decoded by several threads at once.
+class RecordingReader {
+ public:
+  // The stored data of a chunk
+  struct Stored {
+    uint32_t flags = 0;
+    uint32_t raw_size = 0;
+    uint32_t count = 0;
+    std::vector<uint8_t> data;
+  };
+
+  RecordingReader() = default;
+
+  RecordingReader(const RecordingReader&) = delete;
+
+  RecordingReader& operator=(const RecordingReader&) = delete;
+
+  ~RecordingReader();
+
+  // Opens the file and loads its index.  Without an index, the chunk headers
+  // are scanned.
+  void Open(const char* file);
+
+  const std::vector<RecordingChunk>& chunks() const { return chunks_; }
+
+  void Decode(const RecordingChunk& chunk, std::vector<RecordingItem>* items) {
+    Read(chunk, &stored_);
+    Decode(stored_, &raw_, items);
+  }
+
+  void Read(const RecordingChunk& chunk, Stored* stored);
+
+  // Decodes the stored data of a chunk with the raw buffer for the inflated
+  // data.  It may be called by several threads at once.
+  void Decode(const Stored& stored,
+              std::vector<uint8_t>* raw,
+              std::vector<RecordingItem>* items) const;
+
+ private:
+  FILE* file_ = nullptr;
+  std::string name_;
+  std::vector<RecordingChunk> chunks_;
+  Stored stored_;
+  std::vector<uint8_t> raw_;
+
+  bool ReadIndex();
+
+  void ScanChunks();
+
+  bool ReadChunkHeader(uint64_t offset,
+                       RecordingChunk* chunk,
+                       uint32_t* raw_size,
+                       uint32_t* stored_size,
+                       uint32_t* count);
+
+  [[noreturn]] void Invalid() const;
+};
+
+// Merges the items of the processors into one stream ordered by time.  The
+// items of each processor arrive in time order, the merger keeps a queue for
+// each processor and a min-heap of the queue heads.  An item without a time
+// is ordered by the time of the previous item of its processor.  The oldest
+// item is passed to the handler once each processor which delivered items has
+// a queued item, or once it is older than the newest item by at least the
+// latency.  An item which arrives after newer items were passed on is passed
+// on in arrival order.
+class ItemMerger {
+ public:
+  ItemMerger(rtems_record_client_handler handler, void* arg, uint64_t latency)
+      : handler_(handler), arg_(arg), latency_(latency) {}
+
+  ItemMerger(const ItemMerger&) = delete;
+
+  ItemMerger& operator=(const ItemMerger&) = delete;
+
+  rtems_record_client_status Push(uint64_t bt,
+                                  uint32_t cpu,
+                                  rtems_record_event event,
+                                  uint64_t data);
+
+  // Passes all queued items to the handler.
+  rtems_record_client_status Drain();
+
+  // Returns the count of queued items.
+  size_t size() const { return size_; }
+
+ private:
+  struct Head {
+    uint64_t ns;
+    uint32_t cpu;
+  };
+
+  struct Queued {
+    uint64_t ns;
+    RecordingItem item;
+  };
+
+  rtems_record_client_handler handler_;
+  void* arg_;
+  uint64_t latency_;
+  uint64_t newest_ns_ = 0;
+  size_t size_ = 0;
+  size_t active_ = 0;
+  std::deque<Queued> queues_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
+  uint64_t last_ns_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  bool seen_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  std::vector<Head> heap_;
+
+  static bool Later(const Head& a, const Head& b) {
+    return a.ns > b.ns || (a.ns == b.ns && a.cpu > b.cpu);
+  }
+
+  void PushHead(uint32_t cpu);
+
+  rtems_record_client_status Pop();
+};
+
+// Keeps the most recent items of each processor in a ring of fixed size and
+// passes them to the handler only when a trigger fired.  A trigger is one of
+// the trigger events or a call to Trigger().  The items of the rings are then
+// passed to the handler in time order, followed by the items up to the time
+// span after the trigger, and the items are kept in the rings again.  The
+// items before the first item with a time are passed on at once.  The thread
+// name items dropped from a ring are retained, so that the handler knows the
+// thread names of the items passed on.
+class FlightRecorder {
+ public:
+  FlightRecorder(rtems_record_client_handler handler,
+                 void* arg,
+                 size_t size,
+                 uint64_t after_ns);
+
+  FlightRecorder(const FlightRecorder&) = delete;
+
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  void SetTriggers(const std::vector<rtems_record_event>& events);
+
+  // Fires a trigger with the next item, it may be called by a signal handler.
+  void Trigger() { trigger_ = 1; }
+
+  rtems_record_client_status Push(uint64_t bt,
+                                  uint32_t cpu,
+                                  rtems_record_event event,
+                                  uint64_t data);
+
+  // Returns the count of triggers fired.
+  uint64_t triggers() const { return triggers_; }
+
+ private:
+  struct Item {
+    uint64_t bt;
+    uint64_t data;
+    rtems_record_event event;
+  };
+
+  struct Ring {
+    std::vector<Item> items;
+    size_t head = 0;
+    size_t count = 0;
+    std::vector<Item> retained;
+  };
+
+  rtems_record_client_handler handler_;
+  void* arg_;
+  size_t capacity_;
+  uint64_t after_ns_;
+  uint64_t end_ns_ = 0;
+  volatile sig_atomic_t trigger_ = 0;
+  uint64_t triggers_ = 0;
+  bool is_trigger_[RTEMS_RECORD_LAST + 1] = {};
+  Ring rings_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
+  uint64_t last_ns_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+
+  void Keep(uint32_t cpu, const Item& item);
+
+  rtems_record_client_status Dump();
+};
+
+// The saved state of a client, so that the decoding of its input can resume
+// from the state.  The values are stored in the byte order and layout of the
+// host, a checkpoint is restored by the program which saved it.
+class Checkpoint {
+ public:
+  Checkpoint() = default;
+
+  Checkpoint(const Checkpoint&) = delete;
+
+  Checkpoint& operator=(const Checkpoint&) = delete;
+
+  void Write(const void* data, size_t n);
+
+  template <typename T>
+  void Write(const T& value) {
+    Write(&value, sizeof(value));
+  }
+
+  // Reads the next n bytes, throws an exception if there are less.
+  void Read(void* data, size_t n);
+
+  template <typename T>
+  void Read(T* value) {
+    Read(value, sizeof(*value));
+  }
+
+  // Saves the checkpoint to a temporary file and renames it to the file, so
+  // that the file is a complete checkpoint at any time.
+  void Save(const char* file) const;
+
+  void Load(const char* file);
+
+ private:
+  std::vector<uint8_t> data_;
+  size_t position_ = 0;
+};
+
 class Client {
  public:
   Client() = default;
@@ -166,18 +534,84 @@ class Client {
 
   void Open(const char* file) { input_.Open(file); }
 
-  void Connect(const char* host, uint16_t port) { input_.Connect(host, port); }
+  void Connect(const char* host, uint16_t port) {
+    input_.Connect(host, port, receive_buffer_size_);
+  }
 
   void Run();
 
+  // Receives the inputs of all clients in this thread and decodes the data
+  // of each input with its client.  The clients are not pipelined.
+  static void RunAll(const std::vector<Client*>& clients);
+
   void RequestStop() { stop_ = 1; }
 
-  void AddFilter(Filter* filter) { filters_.push_back(filter); }
+  void AddFilter(Filter* filter) {
+    filters_.push_back(filter);
+    filter_buffers_.push_back(std::vector<uint8_t>(kFilterBufferSize));
+  }
 
-  void Destroy();
+  virtual void Destroy();
 
   void set_limit(uint64_t limit) { limit_ = limit; }
 
+  void set_pipelined(bool pipelined) { pipelined_ = pipelined; }
+
+  // Requests a socket receive buffer of the size in bytes for Connect(), so
+  // that a fast stream is not throttled while the decoder is busy.  The
+  // system may limit the size.
+  void set_receive_buffer_size(size_t size) { receive_buffer_size_ = size; }
+
+  // Reports the receive and decode rates, the hold back items, the
+  // overflows, and the backlogs to stderr every interval milliseconds.
+  void set_statistics_interval(uint64_t interval);
+
+  // Writes the decoded items also to the recording file.
+  void Record(const char* file);
+
+  // Decodes the items of the recording file which are in the time window
+  // from begin_ns to end_ns.  The items before the first item with a time are
+  // always decoded.  If the client is pipelined, the chunks of the file are
+  // inflated and decoded by worker threads in parallel.
+  void Replay(const char* file, uint64_t begin_ns, uint64_t end_ns);
+
+  // Passes the items of all processors to the handler in time order.  An
+  // item is held back at most latency nanoseconds of trace time for the items
+  // of other processors.
+  void Merge(uint64_t latency);
+
+  // Keeps the most recent items of size bytes for each processor in memory
+  // and passes them to the handler only when one of the trigger events or
+  // Trigger() fired, see FlightRecorder.
+  void FlightRecord(size_t size,
+                    uint64_t after_ns,
+                    const std::vector<rtems_record_event>& triggers);
+
+  // Fires a trigger of the flight recorder, it may be called by a signal
+  // handler.
+  void Trigger() {
+    if (flight_recorder_) {
+      flight_recorder_->Trigger();
+    }
+  }
+
+  // Passes only the events to the handlers, the other events are dropped by
+  // the decoder.  The recording and the statistics see only these events.
+  void SelectEvents(const std::vector<rtems_record_event>& events);
+
+  // Saves a checkpoint to the file after each interval bytes of input and
+  // when the input ends or the client stops, so that the decoding of an
+  // input file can be resumed.  The input must not be filtered, pipelined,
+  // merged, flight recorded, or recorded.
+  void set_checkpoint(const char* file, uint64_t interval) {
+    checkpoint_file_ = file;
+    checkpoint_interval_ = interval;
+  }
+
+  // Restores the state of the checkpoint file and continues the input file
+  // opened by Open() at the input offset of the checkpoint.
+  void Resume(const char* file);
+
  protected:
   void Initialize(rtems_record_client_handler handler) {
     rtems_record_client_init(&base_, handler, this);
@@ -185,14 +619,456 @@ class Client {
 
   size_t data_size() const { return base_.data_size; };
 
+  // Returns the count of blocks waiting for the output writers.
+  virtual size_t WriterBacklog() const { return 0; }
+
+  // Saves and restores the state of the handler for a checkpoint.  A client
+  // which supports checkpoints overrides both.
+  virtual void SaveState(Checkpoint* checkpoint);
+
+  virtual void RestoreState(Checkpoint* checkpoint);
+
  private:
+  static const size_t kFilterBufferSize = 65536;
+
+  static const size_t kDefaultReceiveBufferSize = 4 * 1024 * 1024;
+
+  // The size of the input reads if the input is not pipelined
+  static const size_t kReadBufferSize = 1024 * 1024;
+
   rtems_record_client_context base_;
-  std::list<Filter*> filters_;
+  std::vector<Filter*> filters_;
+  std::vector<std::vector<uint8_t> > filter_buffers_;
   FileDescriptor input_;
   sig_atomic_t stop_ = 0;
   uint64_t limit_ = 0;
+  bool pipelined_ = false;
+  size_t receive_buffer_size_ = kDefaultReceiveBufferSize;
+  std::vector<uint8_t> read_buffer_;
+  std::unique_ptr<RecordingWriter> recording_;
+  rtems_record_client_handler recorded_handler_ = nullptr;
+  std::unique_ptr<ItemMerger> merger_;
+  std::unique_ptr<FlightRecorder> flight_recorder_;
+  std::atomic<uint64_t> bytes_received_{0};
+  uint64_t items_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  uint64_t overflows_ = 0;
+  uint64_t lost_items_ = 0;
+  rtems_record_client_handler counted_handler_ = nullptr;
+  std::chrono::steady_clock::duration statistics_interval_{};
+  std::chrono::steady_clock::time_point statistics_begin_;
+  std::chrono::steady_clock::time_point statistics_last_;
+  uint64_t last_bytes_received_ = 0;
+  uint64_t last_items_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  const BlockRing* received_ring_ = nullptr;
+  const BlockRing* filtered_ring_ = nullptr;
+  std::string checkpoint_file_;
+  uint64_t checkpoint_interval_ = 0;
+  uint64_t input_offset_ = 0;
+
+  static rtems_record_client_status RecordItem(uint64_t bt,
+                                               uint32_t cpu,
+                                               rtems_record_event event,
+                                               uint64_t data,
+                                               void* arg);
+
+  static rtems_record_client_status FlightRecordItem(uint64_t bt,
+                                                     uint32_t cpu,
+                                                     rtems_record_event event,
+                                                     uint64_t data,
+                                                     void* arg);
+
+  static rtems_record_client_status MergeItem(uint64_t bt,
+                                              uint32_t cpu,
+                                              rtems_record_event event,
+                                              uint64_t data,
+                                              void* arg);
+
+  static rtems_record_client_status CountItem(uint64_t bt,
+                                             uint32_t cpu,
+                                             rtems_record_event event,
+                                             uint64_t data,
+                                             void* arg);
+
+  void Decode(const void* buf, size_t n);
+
+  void SaveCheckpoint();
+
+  void StartStatistics();
+
+  void ReportStatistics(bool last);
+
+  void PollStatistics() {
+    if (statistics_interval_.count() != 0 &&
+        std::chrono::steady_clock::now() - statistics_last_ >=
+            statistics_interval_) {
+      ReportStatistics(false);
+    }
+  }
+
+  void Flush();
+
+  bool Feed(size_t stage, const void* buf, size_t n, BlockRing* output);
+
+  void RunPipelined();
+
+  void Receive(BlockRing* received);
+
+  void RunFilters(BlockRing* received, BlockRing* filtered);
+
+  void ReplayPipelined(RecordingReader* reader,
+                       const std::vector<const RecordingChunk*>& chunks,
+                       uint64_t begin_ns,
+                       uint64_t end_ns);
+
+  bool ReplayItems(const RecordingChunk& chunk,
+                   const std::vector<RecordingItem>& items,
+                   uint64_t begin_ns,
+                   uint64_t end_ns);
+};
+
+// Tracks the thread names by the full object identifier, so that the threads
+// of all nodes of a multiprocessing configuration are distinct.  Only the
+// threads with a name take memory.  The names are interned and a thread
+// refers to its name by index, the index zero is the empty name.  The name of
+// a thread is assembled from the THREAD_NAME items of the processor which
+// produced the preceding THREAD_CREATE or THREAD_ID item, it is interned when
+// it changed.
+class ThreadNames {
+ public:
+  static const size_t kNameSize = 16;
+
+  ThreadNames();
+
+  ThreadNames(const ThreadNames&) = delete;
+
+  ThreadNames& operator=(const ThreadNames&) = delete;
+
+  // Starts a new name for the thread on the processor.
+  void Reset(uint32_t cpu, uint32_t id);
+
+  // Appends the characters of a name item of the processor.
+  void Add(uint32_t cpu, uint64_t data, size_t data_size);
+
+  void Save(Checkpoint* checkpoint) const;
+
+  void Restore(Checkpoint* checkpoint);
+
+  // Returns the name of the thread, the name has kNameSize bytes padded with
+  // zero bytes.
+  const uint8_t* Get(uint32_t id) const {
+    auto it = name_of_thread_.find(id);
+    size_t index = it != name_of_thread_.end() ? it->second : 0;
+    return names_[index].data();
+  }
+
+ private:
+  typedef std::array<uint8_t, kNameSize> Name;
+
+  struct Pending {
+    uint32_t id = 0;
+    size_t size = 0;
+    Name name = {};
+  };
+
+  Pending pending_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
+  std::unordered_map<uint32_t, uint32_t> name_of_thread_;
+  std::vector<Name> names_;
+  std::map<Name, uint32_t> index_of_name_;
+
+  void Intern(const Pending& pending);
+};
+
+// A histogram of values with a fixed count of buckets.  Each power of two
+// range of values is split into 2^kSubBucketBits buckets, so a value is
+// counted in a bucket at most 1/16 of the value wide.
+class Histogram {
+ public:
+  static const int kSubBucketBits = 4;
+
+  Histogram() = default;
+
+  void Add(uint64_t value);
+
+  void Reset();
+
+  // Returns the upper bound of the bucket holding the value at the
+  // percentile, at most the maximum value.
+  uint64_t Percentile(double percentile) const;
+
+  uint64_t count() const { return count_; }
+
+  uint64_t min() const { return count_ != 0 ? min_ : 0; }
+
+  uint64_t max() const { return max_; }
+
+  uint64_t mean() const { return count_ != 0 ? sum_ / count_ : 0; }
+
+ private:
+  static const size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+  static const size_t kBucketCount =
+      (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+  uint64_t buckets_[kBucketCount] = {};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+
+  static size_t BucketOfValue(uint64_t value);
+
+  static uint64_t UpperBoundOfBucket(size_t bucket);
+};
+
+// Computes summaries of the items online instead of writing them: the
+// processor time of each thread from the thread switches, the latency of the
+// interrupt handlers, and the event rate of each processor.  The summary is
+// printed to stdout at intervals of trace time and at the end.
+class SummaryClient : public Client {
+ public:
+  static const size_t kThreadAPICount = 3;
+  static const size_t kInterruptVectorCount = 1024;
+  static const size_t kInterruptNestLevels = 32;
+
+  SummaryClient();
+
+  // Prints the summary every interval nanoseconds of trace time, zero prints
+  // it only at the end.
+  void set_interval(uint64_t interval) { interval_ = interval; }
+
+  virtual void Destroy();
+
+ private:
+  struct PerCPUContext {
+    uint64_t events = 0;
+    uint64_t interval_events = 0;
+    uint64_t last_ns = 0;
+    uint32_t thread_id = 0;
+    uint64_t thread_begin = 0;
+    uint64_t interrupt_begin[kInterruptNestLevels] = {};
+    size_t interrupt_level = 0;
+  };
+
+  struct ThreadSummary {
+    uint64_t time = 0;
+    uint64_t switches = 0;
+  };
+
+  struct VectorSummary {
+    uint64_t count = 0;
+    uint64_t time = 0;
+    uint64_t max = 0;
+  };
+
+  PerCPUContext per_cpu_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
+  std::map<uint32_t, ThreadSummary> threads_;
+  ThreadNames thread_names_;
+  VectorSummary vectors_[kInterruptVectorCount];
+  VectorSummary other_vectors_;
+  Histogram interrupt_latency_;
+  uint64_t interval_ = 0;
+  uint64_t interval_begin_ = 0;
+  uint64_t last_ns_ = 0;
+  size_t cpu_count_ = 0;
+
+  static rtems_record_client_status HandlerCaller(uint64_t bt,
+                                                  uint32_t cpu,
+                                                  rtems_record_event event,
+                                                  uint64_t data,
+                                                  void* arg) {
+    SummaryClient& self = *static_cast<SummaryClient*>(arg);
+    return self.Handler(bt, cpu, event, data);
+  }
+
+  rtems_record_client_status Handler(uint64_t bt,
+                                     uint32_t cpu,
+                                     rtems_record_event event,
+                                     uint64_t data);
+
+  ThreadSummary* GetThread(uint32_t id);
+
+  void SwitchIn(PerCPUContext* pcpu, uint64_t ns, uint32_t id);
+
+  void InterruptExit(PerCPUContext* pcpu, uint64_t ns, uint64_t vector);
+
+  void Print(uint64_t ns, bool last);
+};
+
+// Prints the items to stdout, use Merge() to print the items of all
+// processors in time order.  Each line has the time in seconds, the processor
+// index, the event name, and the event data in hexadecimal.
+class TextClient : public Client {
+ public:
+  TextClient();
+
+  virtual void Destroy();
+
+ private:
+  static const size_t kOutputBufferSize = 1024 * 1024;
+
+  // The maximum size of a line
+  static const size_t kMaximumLineSize = 128;
+
+  std::vector<char> output_;
+  size_t output_size_ = 0;
+  std::vector<std::string> event_names_;
+
+  static rtems_record_client_status HandlerCaller(uint64_t bt,
+                                                  uint32_t cpu,
+                                                  rtems_record_event event,
+                                                  uint64_t data,
+                                                  void* arg) {
+    TextClient& self = *static_cast<TextClient*>(arg);
+    return self.Handler(bt, cpu, event, data);
+  }
+
+  rtems_record_client_status Handler(uint64_t bt,
+                                     uint32_t cpu,
+                                     rtems_record_event event,
+                                     uint64_t data);
 
   void Flush();
 };
 
+// Writes the items as a Perfetto protobuf trace.  The thread switches of each
+// processor go into ftrace event bundles in the compact scheduler format with
+// interned thread names and delta encoded times.  The interrupts are slices
+// and the other events are instants on a track of each processor.  Each
+// processor has a packet sequence of its own with interned event names and an
+// incremental clock, so that the packets carry only the time delta.
+class PerfettoClient : public Client {
+ public:
+  // The count of thread switches of a processor in one event bundle
+  static const size_t kBundleSwitches = 4096;
+
+  PerfettoClient();
+
+  // Opens the output file.
+  void OpenOutput(const char* file);
+
+  virtual void Destroy();
+
+ private:
+  struct PerCPUContext {
+    bool started = false;
+    uint64_t last_ns = 0;
+    uint64_t switch_out_ns = 0;
+    int64_t switch_out_state = 0;
+    std::vector<uint8_t> interned;
+    std::vector<uint64_t> switch_timestamp;
+    std::vector<uint64_t> switch_prev_state;
+    std::vector<uint64_t> switch_next_pid;
+    std::vector<uint64_t> switch_next_prio;
+    std::vector<uint64_t> switch_next_comm_index;
+    uint64_t switch_last_ns = 0;
+    std::map<std::string, uint32_t> comms;
+    std::vector<std::string> comm_table;
+  };
+
+  FILE* file_ = nullptr;
+  std::string file_name_;
+  PerCPUContext per_cpu_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
+  ThreadNames thread_names_;
+  std::vector<uint8_t> packet_;
+  std::vector<uint8_t> message_;
+  std::vector<uint8_t> nested_;
+
+  static rtems_record_client_status HandlerCaller(uint64_t bt,
+                                                  uint32_t cpu,
+                                                  rtems_record_event event,
+                                                  uint64_t data,
+                                                  void* arg) {
+    PerfettoClient& self = *static_cast<PerfettoClient*>(arg);
+    return self.Handler(bt, cpu, event, data);
+  }
+
+  rtems_record_client_status Handler(uint64_t bt,
+                                     uint32_t cpu,
+                                     rtems_record_event event,
+                                     uint64_t data);
+
+  std::string ThreadName(uint32_t cpu, uint32_t id) const;
+
+  void StartSequence(uint32_t cpu, uint64_t ns);
+
+  void WriteTrackEvent(uint32_t cpu,
+                       uint64_t ns,
+                       uint64_t type,
+                       uint64_t name_iid,
+                       uint64_t annotation_iid,
+                       uint64_t value);
+
+  void AddSwitch(uint32_t cpu, uint64_t ns, uint32_t id);
+
+  void WriteBundle(uint32_t cpu);
+
+  void WritePacket();
+};
+
+// Generates a synthetic record stream and measures the throughput of the
+// stages which process it, so that the decoder and the writers can be compared
+// before and after a change with the same input.  The stream is generated in
+// chunks of items of one processor, as a record server sends them, with
+// occasional overflows of the ring buffers if requested.  Each stage is
+// reported as a line of comma-separated values on stdout with the best time of
+// the runs.
+class Benchmark {
+ public:
+  enum class Mix { kMixed, kSwitch, kInterrupt, kUser, kCode };
+
+  struct Config {
+    size_t cpu_count = 4;
+    uint64_t items = 10000000;
+    bool is_64_bit = true;
+    bool is_big_endian = false;
+    Mix mix = Mix::kMixed;
+
+    // The chunks of a processor between two overflows, zero for no overflows
+    uint64_t overflow_interval = 0;
+
+    uint32_t seed = 1;
+    int runs = 3;
+  };
+
+  // The capacity of the generated ring buffers in items
+  static const uint32_t kPerCPUCount = 4096;
+
+  // Parses comma-separated KEY=VALUE settings into the configuration.
+  // Returns false for an invalid setting.
+  static bool ParseConfig(const char* settings, Config* config);
+
+  explicit Benchmark(const Config& config);
+
+  Benchmark(const Benchmark&) = delete;
+
+  Benchmark& operator=(const Benchmark&) = delete;
+
+  const std::vector<uint8_t>& stream() const { return stream_; }
+
+  // Writes the stream to the file, so that a client can read it.
+  void WriteStream(const char* file) const;
+
+  void PrintHeader() const;
+
+  // Measures rtems_record_client_run() with a handler which only counts the
+  // items.
+  void RunDecoder();
+
+  // Measures the filters on the stream encoded for each of them.
+  void RunFilters();
+
+  // Reports a stage which processed the stream of the bytes in the time.
+  void Report(const char* stage, size_t bytes, double seconds) const;
+
+ private:
+  Config config_;
+  std::vector<uint8_t> stream_;
+  uint64_t decoded_items_ = 0;
+
+  void Generate();
+
+  void RunFilter(const char* stage,
+                 Filter* (*create)(),
+                 const std::vector<uint8_t>& input);
+};
+
 #endif  // RTEMS_TOOLS_TRACE_RECORD_CLIENT_H_
@@ -0,0 +1,552 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+namespace {
+
+// The counter frequency of the generated items
+const uint32_t kFrequency = 100000000;
+
+const uint32_t kTimeMask = (UINT32_C(1) << RTEMS_RECORD_TIME_BITS) - 1;
+
+// The maximum count of event items in a chunk, so that a chunk and the one
+// before it fit into the ring buffer
+const uint32_t kChunkItems = Benchmark::kPerCPUCount / 4;
+
+// The chunks of a processor between two uptime items, as a clock tick would
+// produce them
+const uint64_t kUptimeInterval = 16;
+
+// The size of the input passed to the decoder and the filters in one call,
+// as a client reads it
+const size_t kInputBlockSize = 1024 * 1024;
+
+const size_t kFilterBufferSize = 65536;
+
+const uint32_t kThreadCount = 64;
+
+struct PerCPU {
+  uint64_t counter = kFrequency;
+  uint32_t head = 0;
+  uint64_t chunks = 0;
+  bool needs_uptime = true;
+  uint32_t thread_id = 0;
+};
+
+class StreamWriter {
+ public:
+  StreamWriter(std::vector<uint8_t>* stream, bool is_64_bit, bool is_big_endian)
+      : stream_(stream),
+        data_size_(is_64_bit ? 8 : 4),
+        is_big_endian_(is_big_endian) {}
+
+  void Word(uint32_t value) { Store(value, 4); }
+
+  void Item(uint32_t time, rtems_record_event event, uint64_t data) {
+    Store(RTEMS_RECORD_TIME_EVENT(time & kTimeMask, event), 4);
+    Store(data, data_size_);
+    ++items_;
+  }
+
+  // Adds an item at the time of the processor after some counter ticks.
+  void Item(PerCPU* pcpu,
+            std::mt19937* rng,
+            rtems_record_event event,
+            uint64_t data) {
+    pcpu->counter += 10 + (*rng)() % 90;
+    Item(static_cast<uint32_t>(pcpu->counter), event, data);
+  }
+
+  uint64_t items() const { return items_; }
+
+ private:
+  std::vector<uint8_t>* stream_;
+  size_t data_size_;
+  bool is_big_endian_;
+  uint64_t items_ = 0;
+
+  void Store(uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      size_t shift = is_big_endian_ ? size - 1 - i : i;
+      stream_->push_back(static_cast<uint8_t>(value >> (8 * shift)));
+    }
+  }
+};
+
+void AddUptime(StreamWriter* out, PerCPU* pcpu) {
+  uint64_t seconds = pcpu->counter / kFrequency;
+  uint64_t fraction = ((pcpu->counter % kFrequency) << 32) / kFrequency;
+  uint64_t bt = (seconds << 32) | fraction;
+  uint32_t time = static_cast<uint32_t>(pcpu->counter);
+
+  out->Item(time, RTEMS_RECORD_UPTIME_LOW, static_cast<uint32_t>(bt));
+  out->Item(time, RTEMS_RECORD_UPTIME_HIGH, bt >> 32);
+}
+
+void AddEvent(StreamWriter* out,
+              PerCPU* pcpu,
+              uint32_t cpu,
+              Benchmark::Mix mix,
+              std::mt19937* rng) {
+  if (mix == Benchmark::Mix::kMixed) {
+    switch ((*rng)() % 8) {
+      case 0:
+      case 1:
+        mix = Benchmark::Mix::kSwitch;
+        break;
+      case 2:
+      case 3:
+        mix = Benchmark::Mix::kCode;
+        break;
+      case 4:
+        mix = Benchmark::Mix::kInterrupt;
+        break;
+      default:
+        mix = Benchmark::Mix::kUser;
+        break;
+    }
+  }
+
+  switch (mix) {
+    case Benchmark::Mix::kSwitch: {
+      uint32_t next = (*rng)() % (kThreadCount + 1) == 0
+                          ? 0x09010001 + cpu
+                          : 0x0a010001 + (*rng)() % kThreadCount;
+
+      if ((*rng)() % 8 == 0) {
+        out->Item(pcpu, rng, RTEMS_RECORD_THREAD_ID, next);
+        out->Item(pcpu, rng, RTEMS_RECORD_THREAD_NAME,
+                  UINT64_C(0x4b534154) | (uint64_t('0' + next % 10) << 32));
+        out->Item(pcpu, rng, RTEMS_RECORD_THREAD_NAME, 0);
+      }
+
+      out->Item(pcpu, rng, RTEMS_RECORD_THREAD_SWITCH_OUT, pcpu->thread_id);
+      out->Item(pcpu, rng, RTEMS_RECORD_THREAD_STACK_CURRENT,
+                1024 + (*rng)() % 4096);
+      out->Item(pcpu, rng, RTEMS_RECORD_THREAD_SWITCH_IN, next);
+      pcpu->thread_id = next;
+      break;
+    }
+    case Benchmark::Mix::kInterrupt: {
+      uint32_t vector = (*rng)() % 32;
+      out->Item(pcpu, rng, RTEMS_RECORD_INTERRUPT_ENTRY, vector);
+      out->Item(pcpu, rng, RTEMS_RECORD_INTERRUPT_EXIT, vector);
+      break;
+    }
+    case Benchmark::Mix::kCode: {
+      uint32_t address = 0x100000 + 4 * ((*rng)() % 4096);
+      out->Item(pcpu, rng, RTEMS_RECORD_FUNCTION_ENTRY, address);
+      out->Item(pcpu, rng, RTEMS_RECORD_FUNCTION_EXIT, address);
+      break;
+    }
+    default:
+      out->Item(pcpu, rng,
+                static_cast<rtems_record_event>(RTEMS_RECORD_USER_0 +
+                                                (*rng)() % 4),
+                (*rng)());
+      break;
+  }
+}
+
+rtems_record_client_status CountItem(uint64_t,
+                                     uint32_t,
+                                     rtems_record_event,
+                                     uint64_t,
+                                     void* arg) {
+  ++*static_cast<uint64_t*>(arg);
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
+
+void EncodeBase64(const std::vector<uint8_t>& in, std::vector<uint8_t>* out) {
+  static const char digits[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t line = 0;
+
+  out->clear();
+  out->reserve((in.size() + 2) / 3 * 4 + in.size() / 57 + 1);
+
+  for (size_t i = 0; i < in.size(); i += 3) {
+    uint32_t value = uint32_t(in[i]) << 16;
+    size_t n = std::min(in.size() - i, static_cast<size_t>(3));
+
+    if (n > 1) {
+      value |= uint32_t(in[i + 1]) << 8;
+    }
+
+    if (n > 2) {
+      value |= in[i + 2];
+    }
+
+    out->push_back(digits[(value >> 18) & 0x3f]);
+    out->push_back(digits[(value >> 12) & 0x3f]);
+    out->push_back(n > 1 ? digits[(value >> 6) & 0x3f] : '=');
+    out->push_back(n > 2 ? digits[value & 0x3f] : '=');
+
+    // Break the lines as a target console would
+    if (++line == 19) {
+      out->push_back('\n');
+      line = 0;
+    }
+  }
+}
+
+Filter* CreateBase64Filter() {
+  return new Base64Filter();
+}
+
+#ifdef HAVE_ZLIB_H
+Filter* CreateZlibFilter() {
+  return new ZlibFilter();
+}
+#endif
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin)
+      .count();
+}
+
+const char* MixName(Benchmark::Mix mix) {
+  switch (mix) {
+    case Benchmark::Mix::kSwitch:
+      return "switch";
+    case Benchmark::Mix::kInterrupt:
+      return "interrupt";
+    case Benchmark::Mix::kUser:
+      return "user";
+    case Benchmark::Mix::kCode:
+      return "code";
+    default:
+      return "mixed";
+  }
+}
+
+bool ParseNumber(const std::string& value, uint64_t* number) {
+  char* end;
+
+  if (value.empty()) {
+    return false;
+  }
+
+  *number = std::strtoull(value.c_str(), &end, 0);
+  return *end == '\0';
+}
+
+}  // namespace
+
+bool Benchmark::ParseConfig(const char* settings, Config* config) {
+  std::string list(settings);
+  size_t begin = 0;
+
+  while (begin <= list.size()) {
+    size_t end = list.find(',', begin);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+
+    std::string setting = list.substr(begin, end - begin);
+    begin = end + 1;
+
+    if (setting.empty()) {
+      continue;
+    }
+
+    size_t equal = setting.find('=');
+    if (equal == std::string::npos) {
+      return false;
+    }
+
+    std::string key = setting.substr(0, equal);
+    std::string value = setting.substr(equal + 1);
+    uint64_t number = 0;
+
+    if (key == "format") {
+      if (value == "le32" || value == "le64" || value == "be32" ||
+          value == "be64") {
+        config->is_big_endian = value[0] == 'b';
+        config->is_64_bit = value[2] == '6';
+      } else {
+        return false;
+      }
+    } else if (key == "mix") {
+      if (value == "mixed") {
+        config->mix = Mix::kMixed;
+      } else if (value == "switch") {
+        config->mix = Mix::kSwitch;
+      } else if (value == "interrupt") {
+        config->mix = Mix::kInterrupt;
+      } else if (value == "user") {
+        config->mix = Mix::kUser;
+      } else if (value == "code") {
+        config->mix = Mix::kCode;
+      } else {
+        return false;
+      }
+    } else if (!ParseNumber(value, &number)) {
+      return false;
+    } else if (key == "cpus") {
+      if (number == 0 || number > RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT) {
+        return false;
+      }
+
+      config->cpu_count = static_cast<size_t>(number);
+    } else if (key == "items") {
+      config->items = number;
+    } else if (key == "overflow") {
+      config->overflow_interval = number;
+    } else if (key == "seed") {
+      config->seed = static_cast<uint32_t>(number);
+    } else if (key == "runs") {
+      if (number == 0 || number > INT_MAX) {
+        return false;
+      }
+
+      config->runs = static_cast<int>(number);
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+Benchmark::Benchmark(const Config& config) : config_(config) {
+  Generate();
+}
+
+void Benchmark::Generate() {
+  StreamWriter out(&stream_, config_.is_64_bit, config_.is_big_endian);
+  std::vector<PerCPU> per_cpu(config_.cpu_count);
+  std::mt19937 rng(config_.seed);
+
+  stream_.reserve(config_.items * (config_.is_64_bit ? 12 : 8));
+
+  // The format and magic words are in the byte order of the items
+  if (config_.is_64_bit) {
+    out.Word(config_.is_big_endian ? RTEMS_RECORD_FORMAT_BE_64
+                                   : RTEMS_RECORD_FORMAT_LE_64);
+  } else {
+    out.Word(config_.is_big_endian ? RTEMS_RECORD_FORMAT_BE_32
+                                   : RTEMS_RECORD_FORMAT_LE_32);
+  }
+
+  out.Word(RTEMS_RECORD_MAGIC);
+  out.Item(0, RTEMS_RECORD_VERSION, RTEMS_RECORD_THE_VERSION);
+  out.Item(0, RTEMS_RECORD_PROCESSOR_MAXIMUM, config_.cpu_count - 1);
+  out.Item(0, RTEMS_RECORD_PER_CPU_COUNT, kPerCPUCount);
+  out.Item(0, RTEMS_RECORD_FREQUENCY, kFrequency);
+
+  for (uint32_t cpu = 0; cpu < config_.cpu_count; ++cpu) {
+    per_cpu[cpu].thread_id = 0x09010001 + cpu;
+  }
+
+  while (out.items() < config_.items) {
+    uint32_t cpu = rng() % config_.cpu_count;
+    PerCPU& pcpu = per_cpu[cpu];
+    uint32_t tail = pcpu.head;
+    bool overflow = false;
+
+    ++pcpu.chunks;
+
+    // The items of a full ring buffer were overwritten before they were sent
+    if (config_.overflow_interval != 0 &&
+        pcpu.chunks % config_.overflow_interval == 0) {
+      tail += kPerCPUCount;
+      overflow = true;
+    }
+
+    out.Item(0, RTEMS_RECORD_PROCESSOR, cpu);
+    out.Item(0, RTEMS_RECORD_PER_CPU_TAIL, tail);
+
+    uint64_t begin = out.items();
+
+    // After an overflow, the decoder needs the uptime of the held back items
+    if (pcpu.needs_uptime || pcpu.chunks % kUptimeInterval == 0) {
+      AddUptime(&out, &pcpu);
+      pcpu.needs_uptime = false;
+    }
+
+    uint32_t n = 1 + rng() % kChunkItems;
+
+    while (out.items() - begin < n) {
+      AddEvent(&out, &pcpu, cpu, config_.mix, &rng);
+    }
+
+    pcpu.head = tail + static_cast<uint32_t>(out.items() - begin);
+    pcpu.needs_uptime = overflow;
+    out.Item(0, RTEMS_RECORD_PER_CPU_HEAD, pcpu.head);
+  }
+}
+
+void Benchmark::WriteStream(const char* file) const {
+  FILE* f = std::fopen(file, "wb");
+
+  if (f == nullptr) {
+    throw ErrnoException(std::string("cannot open file '") + file + "'");
+  }
+
+  size_t written = std::fwrite(stream_.data(), 1, stream_.size(), f);
+
+  if (std::fclose(f) != 0 || written != stream_.size()) {
+    throw ErrnoException(std::string("cannot write file '") + file + "'");
+  }
+}
+
+void Benchmark::PrintHeader() const {
+  std::printf(
+      "stage,format,cpus,mix,overflow,items,bytes,seconds,items_per_second,"
+      "bytes_per_second\n");
+}
+
+void Benchmark::Report(const char* stage, size_t bytes, double seconds) const {
+  double rate = seconds > 0 ? decoded_items_ / seconds : 0;
+  double byte_rate = seconds > 0 ? bytes / seconds : 0;
+
+  std::printf("%s,%s%s,%zu,%s,%" PRIu64 ",%" PRIu64 ",%zu,%.6f,%.0f,%.0f\n",
+              stage, config_.is_big_endian ? "be" : "le",
+              config_.is_64_bit ? "64" : "32", config_.cpu_count,
+              MixName(config_.mix), config_.overflow_interval, decoded_items_,
+              bytes, seconds, rate, byte_rate);
+  std::fflush(stdout);
+}
+
+void Benchmark::RunDecoder() {
+  double best = std::numeric_limits<double>::max();
+
+  for (int run = 0; run < config_.runs; ++run) {
+    rtems_record_client_context ctx;
+    uint64_t count = 0;
+
+    rtems_record_client_init(&ctx, CountItem, &count);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t offset = 0; offset < stream_.size();
+         offset += kInputBlockSize) {
+      size_t n = std::min(stream_.size() - offset, kInputBlockSize);
+      rtems_record_client_status status =
+          rtems_record_client_run(&ctx, &stream_[offset], n);
+
+      if (status != RTEMS_RECORD_CLIENT_SUCCESS) {
+        rtems_record_client_destroy(&ctx);
+        throw std::runtime_error("the decoder failed with status " +
+                                 std::to_string(status));
+      }
+    }
+
+    rtems_record_client_destroy(&ctx);
+    best = std::min(best, Seconds(begin));
+    decoded_items_ = count;
+  }
+
+  Report("decode", stream_.size(), best);
+}
+
+void Benchmark::RunFilter(const char* stage,
+                          Filter* (*create)(),
+                          const std::vector<uint8_t>& input) {
+  std::vector<uint8_t> buffer(kFilterBufferSize);
+  double best = std::numeric_limits<double>::max();
+
+  for (int run = 0; run < config_.runs; ++run) {
+    std::unique_ptr<Filter> filter((*create)());
+    size_t produced = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t offset = 0; offset <= input.size();
+         offset += kInputBlockSize) {
+      const uint8_t* in = input.data() + offset;
+      size_t n = std::min(input.size() - offset, kInputBlockSize);
+
+      // Run the filter until it makes no progress, as the client does
+      while (true) {
+        size_t in_n = n;
+        size_t out_n = buffer.size();
+
+        if (!filter->Run(in, &in_n, buffer.data(), &out_n)) {
+          throw std::runtime_error(std::string("the ") + stage +
+                                   " filter failed");
+        }
+
+        in += in_n;
+        n -= in_n;
+        produced += out_n;
+
+        if (out_n == 0 && in_n == 0) {
+          break;
+        }
+      }
+    }
+
+    best = std::min(best, Seconds(begin));
+
+    if (produced != stream_.size()) {
+      throw std::runtime_error(std::string("the ") + stage +
+                               " filter produced " + std::to_string(produced) +
+                               " of " + std::to_string(stream_.size()) +
+                               " bytes");
+    }
+  }
+
+  Report(stage, input.size(), best);
+}
+
+void Benchmark::RunFilters() {
+  std::vector<uint8_t> encoded;
+
+  EncodeBase64(stream_, &encoded);
+  RunFilter("base64", CreateBase64Filter, encoded);
+
+#ifdef HAVE_ZLIB_H
+  uLongf size = compressBound(stream_.size());
+
+  encoded.resize(size);
+
+  if (compress2(encoded.data(), &size, stream_.data(), stream_.size(),
+                Z_DEFAULT_COMPRESSION) != Z_OK) {
+    throw std::runtime_error("cannot compress the stream");
+  }
+
+  encoded.resize(size);
+  RunFilter("zlib", CreateZlibFilter, encoded);
+#endif
+}
@@ -37,6 +37,7 @@
 #else
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #endif
@@ -46,7 +47,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
 #include <cstring>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <thread>
 
 #include <ini.h>
 
@@ -74,7 +82,9 @@ void FileDescriptor::Open(const char* file) {
   reader_ = ReadFile;
 }
 
-void FileDescriptor::Connect(const char* host, uint16_t port) {
+void FileDescriptor::Connect(const char* host,
+                             uint16_t port,
+                             size_t receive_buffer_size) {
   assert(fd_ == -1);
 
   fd_ = ::socket(PF_INET, SOCK_STREAM, 0);
@@ -82,6 +92,16 @@ void FileDescriptor::Connect(const char* host, uint16_t port) {
     throw ErrnoException("cannot open socket");
   }
 
+  // The size must be set before the connect to take part in the window
+  // scaling negotiation.  It is only a request, so errors are ignored.
+  if (receive_buffer_size != 0) {
+    int size = static_cast<int>(
+        std::min(receive_buffer_size, static_cast<size_t>(INT_MAX)));
+    // This cast is necessary for Windows
+    (void)::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF,
+                       reinterpret_cast<const char*>(&size), sizeof(size));
+  }
+
   struct sockaddr_in in_addr;
   std::memset(&in_addr, 0, sizeof(in_addr));
   in_addr.sin_family = AF_INET;
@@ -97,6 +117,17 @@ void FileDescriptor::Connect(const char* host, uint16_t port) {
   reader_ = ReadSocket;
 }
 
+void FileDescriptor::Shutdown() {
+  // Wake up a receiver blocked on the socket
+  if (reader_ == ReadSocket) {
+#ifdef _WIN32
+    ::shutdown(fd_, SD_RECEIVE);
+#else
+    ::shutdown(fd_, SHUT_RD);
+#endif
+  }
+}
+
 void FileDescriptor::Destroy() {
   if (fd_ != -1) {
     int rv = ::close(fd_);
@@ -106,6 +137,166 @@ void FileDescriptor::Destroy() {
   }
 }
 
+BlockRing::BlockRing(size_t count, size_t block_size) : blocks_(count) {
+  for (auto& block : blocks_) {
+    block.data.resize(block_size);
+  }
+}
+
+BlockRing::Block* BlockRing::Free() {
+  size_t head = head_.value.load(std::memory_order_relaxed);
+  size_t tail = tail_.value.load(std::memory_order_acquire);
+  if (head - tail == blocks_.size()) {
+    return nullptr;
+  }
+
+  return &blocks_[head % blocks_.size()];
+}
+
+BlockRing::Block* BlockRing::WaitFree() {
+  int spins = 0;
+  while (!cancelled()) {
+    Block* block = Free();
+    if (block != nullptr) {
+      return block;
+    }
+
+    Wait(&spins);
+  }
+
+  return nullptr;
+}
+
+void BlockRing::Push() {
+  head_.value.store(head_.value.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+}
+
+BlockRing::Block* BlockRing::Front() {
+  size_t tail = tail_.value.load(std::memory_order_relaxed);
+  size_t head = head_.value.load(std::memory_order_acquire);
+  if (head == tail) {
+    return nullptr;
+  }
+
+  return &blocks_[tail % blocks_.size()];
+}
+
+BlockRing::Block* BlockRing::WaitFront() {
+  int spins = 0;
+  while (!cancelled()) {
+    Block* block = Front();
+    if (block != nullptr) {
+      return block;
+    }
+
+    Wait(&spins);
+  }
+
+  return nullptr;
+}
+
+void BlockRing::Pop() {
+  tail_.value.store(tail_.value.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+}
+
+bool BlockRing::Write(const void* buf, size_t n) {
+  const uint8_t* p = static_cast<const uint8_t*>(buf);
+  while (n > 0) {
+    Block* block = WaitFree();
+    if (block == nullptr) {
+      return false;
+    }
+
+    size_t m = std::min(n, block->data.size());
+    std::memcpy(block->data.data(), p, m);
+    block->size = m;
+    Push();
+    p += m;
+    n -= m;
+  }
+
+  return true;
+}
+
+void BlockRing::Close() {
+  Block* block = WaitFree();
+  if (block != nullptr) {
+    block->size = 0;
+    Push();
+  }
+}
+
+void BlockRing::Wait(int* spins) {
+  // Spin briefly, then back off so that an idle stream does not burn a core
+  if (*spins < 64) {
+    ++*spins;
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+}
+
+static const char kCheckpointMagic[8] = {'R', 'T', 'R', 'C', 'K', 'P', '0',
+                                         '1'};
+
+// Bounds the size of a decoder state read from a checkpoint
+static const size_t kMaximumDecoderStateSize = 1 << 30;
+
+void Checkpoint::Write(const void* data, size_t n) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  data_.insert(data_.end(), p, p + n);
+}
+
+void Checkpoint::Read(void* data, size_t n) {
+  if (n > data_.size() - position_) {
+    throw std::runtime_error("truncated checkpoint");
+  }
+
+  std::memcpy(data, data_.data() + position_, n);
+  position_ += n;
+}
+
+void Checkpoint::Save(const char* file) const {
+  std::string temp = std::string(file) + ".tmp";
+  FILE* f = std::fopen(temp.c_str(), "wb");
+  if (f == nullptr) {
+    throw ErrnoException("cannot open checkpoint file '" + temp + "'");
+  }
+
+  bool ok = std::fwrite(data_.data(), 1, data_.size(), f) == data_.size();
+  ok = std::fclose(f) == 0 && ok;
+  if (!ok || std::rename(temp.c_str(), file) != 0) {
+    throw ErrnoException(std::string("cannot save checkpoint file '") + file +
+                         "'");
+  }
+}
+
+void Checkpoint::Load(const char* file) {
+  FILE* f = std::fopen(file, "rb");
+  if (f == nullptr) {
+    throw ErrnoException(std::string("cannot open checkpoint file '") + file +
+                         "'");
+  }
+
+  data_.clear();
+  position_ = 0;
+
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+    data_.insert(data_.end(), buf, buf + n);
+  }
+
+  bool ok = std::ferror(f) == 0;
+  std::fclose(f);
+  if (!ok) {
+    throw ErrnoException(std::string("cannot read checkpoint file '") + file +
+                         "'");
+  }
+}
+
 const std::string ConfigFile::kNoError;
 
 void ConfigFile::AddParser(const char* section, Parser parser, void* arg) {
@@ -145,55 +336,732 @@ int ConfigFile::INIHandler(void* user,
 }
 
 void Client::Flush() {
+  Feed(0, nullptr, 0, nullptr);
+}
+
+bool Client::Feed(size_t stage, const void* buf, size_t n, BlockRing* output) {
+  if (stage == filters_.size()) {
+    if (output != nullptr) {
+      return output->Write(buf, n);
+    }
+
+    Decode(buf, n);
+    return true;
+  }
+
+  // Run the filter until it makes no progress, each output is passed down
+  // the chain before the buffer of this stage is reused
+  Filter* filter = filters_[stage];
+  std::vector<uint8_t>& buffer = filter_buffers_[stage];
+  const uint8_t* in = static_cast<const uint8_t*>(buf);
   while (true) {
-    void* p = nullptr;
-    size_t n = 0;
-    for (auto filter : filters_) {
-      if (!filter->Run(&p, &n)) {
-        break;
+    size_t in_n = n;
+    size_t out_n = buffer.size();
+    if (!filter->Run(in, &in_n, buffer.data(), &out_n)) {
+      return false;
+    }
+
+    in += in_n;
+    n -= in_n;
+
+    if (out_n > 0) {
+      if (!Feed(stage + 1, buffer.data(), out_n, output)) {
+        return false;
       }
+    } else if (in_n == 0) {
+      return true;
     }
+  }
+}
 
-    if (n > 0) {
-      rtems_record_client_run(&base_, p, n);
-    } else {
-      break;
+void Client::Decode(const void* buf, size_t n) {
+  rtems_record_client_run(&base_, buf, n);
+  PollStatistics();
+}
+
+void Client::set_statistics_interval(uint64_t interval) {
+  statistics_interval_ = std::chrono::milliseconds(interval);
+
+  if (interval != 0 && counted_handler_ == nullptr) {
+    counted_handler_ = base_.handler;
+    rtems_record_client_set_handler(&base_, CountItem);
+  }
+}
+
+rtems_record_client_status Client::CountItem(uint64_t bt,
+                                             uint32_t cpu,
+                                             rtems_record_event event,
+                                             uint64_t data,
+                                             void* arg) {
+  Client* self = static_cast<Client*>(arg);
+
+  if (cpu < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT) {
+    ++self->items_[cpu];
+  }
+
+  if (event == RTEMS_RECORD_PER_CPU_OVERFLOW) {
+    ++self->overflows_;
+    self->lost_items_ += data;
+  }
+
+  return (*self->counted_handler_)(bt, cpu, event, data, arg);
+}
+
+void Client::StartStatistics() {
+  statistics_begin_ = std::chrono::steady_clock::now();
+  statistics_last_ = statistics_begin_;
+}
+
+void Client::ReportStatistics(bool last) {
+  if (statistics_interval_.count() == 0) {
+    return;
+  }
+
+  // The periodic reports show the rates since the previous report, the last
+  // report shows the totals and the rates of the whole run
+  auto now = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(
+                       now - (last ? statistics_begin_ : statistics_last_))
+                       .count();
+  if (seconds <= 0) {
+    seconds = 1e-9;
+  }
+
+  uint64_t bytes = bytes_received_.load(std::memory_order_relaxed);
+  uint64_t received = last ? bytes : bytes - last_bytes_received_;
+  // A replay has no header with the processor count
+  uint32_t cpu_count = RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT;
+  while (cpu_count > base_.cpu_count && items_[cpu_count - 1] == 0) {
+    --cpu_count;
+  }
+
+  uint64_t decoded = 0;
+  size_t held_back = 0;
+
+  for (uint32_t i = 0; i < cpu_count; ++i) {
+    decoded += last ? items_[i] : items_[i] - last_items_[i];
+
+    if (base_.per_cpu[i].hold_back) {
+      held_back += base_.per_cpu[i].item_index;
     }
   }
+
+  std::cerr << std::fixed << std::setprecision(1) << "statistics:";
+
+  if (last) {
+    std::cerr << " " << bytes << " bytes received, " << decoded
+              << " items decoded in " << std::setprecision(3) << seconds
+              << std::setprecision(1) << " s,";
+  }
+
+  std::cerr << " " << received / seconds / 1024 << " KiB/s received, "
+            << decoded / seconds << " items/s decoded";
+
+  for (uint32_t i = 0; i < cpu_count; ++i) {
+    uint64_t items = last ? items_[i] : items_[i] - last_items_[i];
+    std::cerr << (i == 0 ? " (" : ", ") << "cpu " << i << ": "
+              << items / seconds;
+  }
+
+  std::cerr << (cpu_count > 0 ? ")" : "") << ", " << held_back
+            << " items held back, " << overflows_ << " overflows with "
+            << lost_items_ << " lost items";
+
+  if (received_ring_ != nullptr) {
+    std::cerr << ", received ring " << received_ring_->size() << "/"
+              << received_ring_->capacity();
+  }
+
+  if (filtered_ring_ != nullptr) {
+    std::cerr << ", filtered ring " << filtered_ring_->size() << "/"
+              << filtered_ring_->capacity();
+  }
+
+  std::cerr << ", writer backlog " << WriterBacklog() << " blocks"
+            << std::defaultfloat << std::endl;
+
+  statistics_last_ = now;
+  last_bytes_received_ = bytes;
+  std::memcpy(last_items_, items_, sizeof(last_items_));
 }
 
 void Client::Run() {
+  // The checkpoints contain only the decoder and handler states, so the
+  // input must reach the decoder unchanged and in the order read
+  uint64_t next_checkpoint = UINT64_MAX;
+
+  if (!checkpoint_file_.empty()) {
+    if (pipelined_ || !filters_.empty() || merger_ || flight_recorder_ ||
+        recording_) {
+      throw std::runtime_error(
+          "checkpoints require an input without pipelining, filters, merger, "
+          "flight recorder, and recording");
+    }
+
+    SaveCheckpoint();
+    next_checkpoint = input_offset_ + checkpoint_interval_;
+  }
+
+  StartStatistics();
+
+  if (pipelined_) {
+    RunPipelined();
+    ReportStatistics(true);
+    return;
+  }
+
   uint64_t todo = UINT64_MAX;
 
   if (limit_ != 0) {
     todo = limit_;
   }
 
+  // A large buffer gets all data queued by the socket in one call, the
+  // decoder consumes it in place
+  read_buffer_.resize(kReadBufferSize);
+
   while (stop_ == 0 && todo > 0) {
-    long buf[8192];
-    size_t m = std::min(static_cast<uint64_t>(sizeof(buf)), todo);
-    ssize_t n = input_.Read(buf, m);
+    size_t m = std::min(static_cast<uint64_t>(read_buffer_.size()), todo);
+    ssize_t n = input_.Read(read_buffer_.data(), m);
     if (n <= 0) {
       break;
     }
 
-    void* p = &buf[0];
-    size_t k = static_cast<size_t>(n);
-    for (auto filter : filters_) {
-      if (!filter->Run(&p, &k)) {
-        std::cerr << "error: input filter failure" << std::endl;
-        return;
-      }
+    bytes_received_.fetch_add(static_cast<uint64_t>(n),
+                              std::memory_order_relaxed);
+
+    if (!Feed(0, read_buffer_.data(), static_cast<size_t>(n), nullptr)) {
+      std::cerr << "error: input filter failure" << std::endl;
+      return;
     }
 
-    rtems_record_client_run(&base_, p, k);
     todo -= static_cast<size_t>(n);
+    input_offset_ += static_cast<uint64_t>(n);
+
+    if (input_offset_ >= next_checkpoint) {
+      SaveCheckpoint();
+      next_checkpoint = input_offset_ + checkpoint_interval_;
+    }
   }
 
   Flush();
+
+  if (!checkpoint_file_.empty()) {
+    SaveCheckpoint();
+  }
+
+  ReportStatistics(true);
+}
+
+void Client::SaveCheckpoint() {
+  Checkpoint checkpoint;
+  checkpoint.Write(kCheckpointMagic);
+  checkpoint.Write(input_offset_);
+
+  std::vector<uint8_t> state(rtems_record_client_state_size(&base_));
+  rtems_record_client_save_state(&base_, state.data());
+  checkpoint.Write(state.size());
+  checkpoint.Write(state.data(), state.size());
+
+  SaveState(&checkpoint);
+  checkpoint.Save(checkpoint_file_.c_str());
+}
+
+void Client::Resume(const char* file) {
+  Checkpoint checkpoint;
+  checkpoint.Load(file);
+
+  char magic[sizeof(kCheckpointMagic)];
+  checkpoint.Read(&magic);
+  if (std::memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0) {
+    throw std::runtime_error(std::string("invalid checkpoint file '") + file +
+                             "'");
+  }
+
+  checkpoint.Read(&input_offset_);
+
+  size_t n;
+  checkpoint.Read(&n);
+  if (n > kMaximumDecoderStateSize) {
+    throw std::runtime_error(std::string("invalid checkpoint file '") + file +
+                             "'");
+  }
+
+  std::vector<uint8_t> state(n);
+  checkpoint.Read(state.data(), n);
+  if (rtems_record_client_restore_state(&base_, state.data(), n) !=
+      RTEMS_RECORD_CLIENT_SUCCESS) {
+    throw std::runtime_error(
+        std::string("invalid decoder state in checkpoint file '") + file +
+        "'");
+  }
+
+  RestoreState(&checkpoint);
+
+  if (::lseek(input_.fd(), static_cast<off_t>(input_offset_), SEEK_SET) < 0) {
+    throw ErrnoException("cannot seek to the checkpoint in the input");
+  }
+}
+
+void Client::SaveState(Checkpoint*) {
+  throw std::runtime_error("the client does not support checkpoints");
+}
+
+void Client::RestoreState(Checkpoint*) {
+  throw std::runtime_error("the client does not support checkpoints");
+}
+
+#ifdef _WIN32
+static int poll(struct pollfd* fds, size_t n, int timeout) {
+  return WSAPoll(fds, static_cast<ULONG>(n), timeout);
+}
+#endif
+
+void Client::RunAll(const std::vector<Client*>& clients) {
+  // Wake up from time to time to notice stop requests and report statistics
+  static const int kPollTimeout = 100;
+
+  std::vector<struct pollfd> fds(clients.size());
+  std::vector<uint64_t> todo(clients.size());
+  size_t active = clients.size();
+
+  for (size_t i = 0; i < clients.size(); ++i) {
+    Client* self = clients[i];
+    self->StartStatistics();
+    fds[i].fd = self->input_.fd();
+    fds[i].events = POLLIN;
+    todo[i] = self->limit_ != 0 ? self->limit_ : UINT64_MAX;
+  }
+
+  while (active > 0) {
+    if (poll(fds.data(), fds.size(), kPollTimeout) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw ErrnoException("cannot poll the inputs");
+    }
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+      Client* self = clients[i];
+      if (fds[i].fd < 0) {
+        continue;
+      }
+
+      bool done = self->stop_ != 0;
+
+      if (!done && (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+        std::vector<uint8_t>& buf = self->read_buffer_;
+        buf.resize(kReadBufferSize);
+        size_t m = std::min(static_cast<uint64_t>(buf.size()), todo[i]);
+        ssize_t n = self->input_.Read(buf.data(), m);
+        if (n <= 0) {
+          done = true;
+        } else {
+          self->bytes_received_.fetch_add(static_cast<uint64_t>(n),
+                                          std::memory_order_relaxed);
+
+          if (!self->Feed(0, buf.data(), static_cast<size_t>(n), nullptr)) {
+            std::cerr << "error: input filter failure" << std::endl;
+            done = true;
+          }
+
+          todo[i] -= static_cast<size_t>(n);
+          done = done || todo[i] == 0;
+        }
+      } else {
+        self->PollStatistics();
+      }
+
+      if (done) {
+        fds[i].fd = -1;
+        --active;
+      }
+    }
+  }
+
+  for (auto self : clients) {
+    self->Flush();
+    self->ReportStatistics(true);
+  }
+}
+
+static const size_t kRingBlocks = 64;
+
+static const size_t kRingBlockSize = 65536;
+
+void Client::Receive(BlockRing* received) {
+  uint64_t todo = UINT64_MAX;
+
+  if (limit_ != 0) {
+    todo = limit_;
+  }
+
+  while (stop_ == 0 && todo > 0) {
+    BlockRing::Block* block = received->WaitFree();
+    if (block == nullptr) {
+      return;
+    }
+
+    size_t m = std::min(static_cast<uint64_t>(block->data.size()), todo);
+    ssize_t n = input_.Read(block->data.data(), m);
+    if (n <= 0) {
+      break;
+    }
+
+    bytes_received_.fetch_add(static_cast<uint64_t>(n),
+                              std::memory_order_relaxed);
+    block->size = static_cast<size_t>(n);
+    received->Push();
+    todo -= static_cast<size_t>(n);
+  }
+
+  received->Close();
+}
+
+void Client::RunFilters(BlockRing* received, BlockRing* filtered) {
+  while (true) {
+    BlockRing::Block* block = received->WaitFront();
+    if (block == nullptr) {
+      return;
+    }
+
+    if (block->size == 0) {
+      break;
+    }
+
+    if (!Feed(0, block->data.data(), block->size, filtered)) {
+      if (!filtered->cancelled()) {
+        std::cerr << "error: input filter failure" << std::endl;
+        received->Cancel();
+        filtered->Cancel();
+      }
+
+      return;
+    }
+
+    received->Pop();
+  }
+
+  Feed(0, nullptr, 0, filtered);
+  filtered->Close();
+}
+
+void Client::RunPipelined() {
+  // The stages are the receiver, the input filters, and the record decoding
+  // with the output of the handler.  The decoding stays on this thread since
+  // the record client and the handler are stateful and process the items in
+  // order.
+  BlockRing received(kRingBlocks, kRingBlockSize);
+  BlockRing filtered(kRingBlocks, kRingBlockSize);
+  BlockRing* decode = &received;
+  std::thread receiver(&Client::Receive, this, &received);
+  std::thread filter;
+
+  if (!filters_.empty()) {
+    decode = &filtered;
+    filter = std::thread(&Client::RunFilters, this, &received, &filtered);
+    filtered_ring_ = &filtered;
+  }
+
+  // A full received ring shows that the host does not keep up with the
+  // target, an empty one that the host waits for the target
+  received_ring_ = &received;
+
+  bool done = false;
+  int spins = 0;
+  while (stop_ == 0) {
+    BlockRing::Block* block = decode->Front();
+    if (block == nullptr) {
+      if (decode->cancelled()) {
+        break;
+      }
+
+      PollStatistics();
+      BlockRing::Wait(&spins);
+      continue;
+    }
+
+    spins = 0;
+
+    if (block->size == 0) {
+      done = true;
+      break;
+    }
+
+    Decode(block->data.data(), block->size);
+    decode->Pop();
+  }
+
+  received.Cancel();
+  filtered.Cancel();
+
+  if (!done) {
+    input_.Shutdown();
+  }
+
+  receiver.join();
+
+  if (filter.joinable()) {
+    filter.join();
+  }
+
+  received_ring_ = nullptr;
+  filtered_ring_ = nullptr;
+
+  if (stop_ != 0 && !done) {
+    Flush();
+  }
+}
+
+void Client::Record(const char* file) {
+  recording_.reset(new RecordingWriter());
+  recording_->Open(file);
+  recorded_handler_ = base_.handler;
+  rtems_record_client_set_handler(&base_, RecordItem);
+}
+
+rtems_record_client_status Client::RecordItem(uint64_t bt,
+                                              uint32_t cpu,
+                                              rtems_record_event event,
+                                              uint64_t data,
+                                              void* arg) {
+  Client* self = static_cast<Client*>(arg);
+  self->recording_->Write(bt, cpu, event, data, self->base_.data_size);
+  return (*self->recorded_handler_)(bt, cpu, event, data, arg);
+}
+
+void Client::Replay(const char* file, uint64_t begin_ns, uint64_t end_ns) {
+  RecordingReader reader;
+  reader.Open(file);
+  StartStatistics();
+
+  std::vector<const RecordingChunk*> chunks;
+  for (const auto& chunk : reader.chunks()) {
+    bool prologue = (chunk.flags & RecordingChunk::kPrologue) != 0;
+    if (prologue ||
+        (rtems_record_client_bintime_to_nanoseconds(chunk.bt_end) >= begin_ns &&
+         rtems_record_client_bintime_to_nanoseconds(chunk.bt_begin) <=
+             end_ns)) {
+      chunks.push_back(&chunk);
+    }
+  }
+
+  if (pipelined_) {
+    ReplayPipelined(&reader, chunks, begin_ns, end_ns);
+  } else {
+    std::vector<RecordingItem> items;
+    for (const auto* chunk : chunks) {
+      if (stop_ != 0) {
+        break;
+      }
+
+      reader.Decode(*chunk, &items);
+      if (!ReplayItems(*chunk, items, begin_ns, end_ns)) {
+        break;
+      }
+    }
+  }
+
+  ReportStatistics(true);
+}
+
+void Client::ReplayPipelined(RecordingReader* reader,
+                             const std::vector<const RecordingChunk*>& chunks,
+                             uint64_t begin_ns,
+                             uint64_t end_ns) {
+  // The workers read the stored data of the chunks one at a time and inflate
+  // and decode the chunks at once.  This thread passes the items to the
+  // handler in the order of the chunks.  A worker takes a chunk only if its
+  // items fit into the window of slots.
+  struct Slot {
+    std::vector<RecordingItem> items;
+    std::exception_ptr error;
+    bool ready = false;
+  };
+
+  size_t worker_count = std::thread::hardware_concurrency();
+  if (worker_count > 1) {
+    --worker_count;
+  } else {
+    worker_count = 1;
+  }
+
+  size_t window = 2 * worker_count;
+  std::vector<Slot> slots(window);
+  std::mutex mutex;
+  std::mutex read_mutex;
+  std::condition_variable changed;
+  size_t next = 0;
+  size_t passed = 0;
+  bool cancel = false;
+
+  auto work = [&]() {
+    RecordingReader::Stored stored;
+    std::vector<uint8_t> raw;
+    std::vector<RecordingItem> items;
+
+    while (true) {
+      size_t i;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] {
+          return cancel || next == chunks.size() || next < passed + window;
+        });
+
+        if (cancel || next == chunks.size()) {
+          return;
+        }
+
+        i = next;
+        ++next;
+      }
+
+      std::exception_ptr error;
+      try {
+        {
+          std::lock_guard<std::mutex> lock(read_mutex);
+          reader->Read(*chunks[i], &stored);
+        }
+
+        reader->Decode(stored, &raw, &items);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot& slot = slots[i % window];
+        slot.items.swap(items);
+        slot.error = error;
+        slot.ready = true;
+      }
+
+      changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t w = 0; w < worker_count; ++w) {
+    workers.emplace_back(work);
+  }
+
+  std::vector<RecordingItem> items;
+  std::exception_ptr error;
+  for (size_t i = 0; i < chunks.size() && stop_ == 0; ++i) {
+    Slot& slot = slots[i % window];
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&slot] { return slot.ready; });
+      slot.ready = false;
+      items.swap(slot.items);
+      error = slot.error;
+      ++passed;
+    }
+
+    changed.notify_all();
+
+    if (error || !ReplayItems(*chunks[i], items, begin_ns, end_ns)) {
+      break;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancel = true;
+  }
+
+  changed.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+bool Client::ReplayItems(const RecordingChunk& chunk,
+                         const std::vector<RecordingItem>& items,
+                         uint64_t begin_ns,
+                         uint64_t end_ns) {
+  base_.data_size = chunk.data_size;
+  PollStatistics();
+
+  bool prologue = (chunk.flags & RecordingChunk::kPrologue) != 0;
+  for (const auto& item : items) {
+    if (!rtems_record_client_is_event_enabled(&base_, item.event)) {
+      continue;
+    }
+
+    if (!prologue) {
+      uint64_t ns = rtems_record_client_bintime_to_nanoseconds(item.bt);
+      if (ns < begin_ns || ns > end_ns) {
+        continue;
+      }
+    }
+
+    if ((*base_.handler)(item.bt, item.cpu, item.event, item.data,
+                         base_.handler_arg) != RTEMS_RECORD_CLIENT_SUCCESS) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Client::Merge(uint64_t latency) {
+  merger_.reset(new ItemMerger(base_.handler, this, latency));
+  rtems_record_client_set_handler(&base_, MergeItem);
+}
+
+rtems_record_client_status Client::MergeItem(uint64_t bt,
+                                             uint32_t cpu,
+                                             rtems_record_event event,
+                                             uint64_t data,
+                                             void* arg) {
+  Client* self = static_cast<Client*>(arg);
+  return self->merger_->Push(bt, cpu, event, data);
+}
+
+void Client::FlightRecord(size_t size,
+                          uint64_t after_ns,
+                          const std::vector<rtems_record_event>& triggers) {
+  flight_recorder_.reset(
+      new FlightRecorder(base_.handler, this, size, after_ns));
+  flight_recorder_->SetTriggers(triggers);
+  rtems_record_client_set_handler(&base_, FlightRecordItem);
+}
+
+rtems_record_client_status Client::FlightRecordItem(uint64_t bt,
+                                                    uint32_t cpu,
+                                                    rtems_record_event event,
+                                                    uint64_t data,
+                                                    void* arg) {
+  Client* self = static_cast<Client*>(arg);
+  return self->flight_recorder_->Push(bt, cpu, event, data);
+}
+
+void Client::SelectEvents(const std::vector<rtems_record_event>& events) {
+  rtems_record_client_set_all_events(&base_, false);
+
+  for (auto event : events) {
+    rtems_record_client_enable_event(&base_, event);
+  }
 }
 
 void Client::Destroy() {
   input_.Destroy();
   rtems_record_client_destroy(&base_);
+
+  if (merger_) {
+    merger_->Drain();
+  }
+
+  if (recording_) {
+    recording_->Close();
+  }
 }
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <cstdio>
+
+namespace {
+
+// The two digit decimal numbers from 00 to 99
+const char kDecimalDigitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+
+const char kHexDigits[] = "0123456789abcdef";
+
+// Writes the decimal digits of the value, at least width digits padded with
+// zeros.  Returns the end of the digits.
+char* PutDecimal(char* p, uint32_t value, int width) {
+  char digits[10];
+  int n = 0;
+
+  while (value >= 100) {
+    uint32_t pair = (value % 100) * 2;
+    value /= 100;
+    digits[n] = kDecimalDigitPairs[pair + 1];
+    digits[n + 1] = kDecimalDigitPairs[pair];
+    n += 2;
+  }
+
+  if (value >= 10) {
+    digits[n] = kDecimalDigitPairs[value * 2 + 1];
+    digits[n + 1] = kDecimalDigitPairs[value * 2];
+    n += 2;
+  } else {
+    digits[n] = static_cast<char>('0' + value);
+    ++n;
+  }
+
+  while (n < width) {
+    digits[n] = '0';
+    ++n;
+  }
+
+  while (n > 0) {
+    --n;
+    *p = digits[n];
+    ++p;
+  }
+
+  return p;
+}
+
+// Writes the hexadecimal digits of the value without leading zeros.  Returns
+// the end of the digits.
+char* PutHex(char* p, uint64_t value) {
+  int shift = 60;
+  while (shift > 0 && (value >> shift) == 0) {
+    shift -= 4;
+  }
+
+  for (; shift >= 0; shift -= 4) {
+    *p = kHexDigits[(value >> shift) & 0xf];
+    ++p;
+  }
+
+  return p;
+}
+
+}  // namespace
+
+TextClient::TextClient() : output_(kOutputBufferSize) {
+  Initialize(TextClient::HandlerCaller);
+
+  // Look up the event names once
+  event_names_.resize(RTEMS_RECORD_LAST + 1);
+  for (int i = 0; i <= RTEMS_RECORD_LAST; ++i) {
+    event_names_[i] =
+        rtems_record_event_text(static_cast<rtems_record_event>(i));
+  }
+}
+
+rtems_record_client_status TextClient::Handler(uint64_t bt,
+                                               uint32_t cpu,
+                                               rtems_record_event event,
+                                               uint64_t data) {
+  const std::string& name = event_names_[event];
+  if (output_.size() - output_size_ < kMaximumLineSize + name.size()) {
+    Flush();
+  }
+
+  uint32_t seconds;
+  uint32_t nanoseconds;
+  rtems_record_client_bintime_to_seconds_and_nanoseconds(bt, &seconds,
+                                                         &nanoseconds);
+
+  // The line is "seconds.nanoseconds:cpu:event:data" with the data in
+  // hexadecimal
+  char* p = &output_[output_size_];
+  p = PutDecimal(p, seconds, 1);
+  *p = '.';
+  p = PutDecimal(p + 1, nanoseconds, 9);
+  *p = ':';
+  p = PutDecimal(p + 1, cpu, 1);
+  *p = ':';
+  std::memcpy(p + 1, name.data(), name.size());
+  p += 1 + name.size();
+  *p = ':';
+  p = PutHex(p + 1, data);
+  *p = '\n';
+  output_size_ = static_cast<size_t>(p + 1 - output_.data());
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
+
+void TextClient::Flush() {
+  std::fwrite(output_.data(), 1, output_size_, stdout);
+  output_size_ = 0;
+}
+
+void TextClient::Destroy() {
+  Client::Destroy();
+  Flush();
+  std::fflush(stdout);
+}
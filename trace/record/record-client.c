@@ -88,6 +88,10 @@ static rtems_record_client_status call_handler(
   uint64_t                           data
 )
 {
+  if ( !rtems_record_client_is_event_enabled( ctx, event ) ) {
+    return RTEMS_RECORD_CLIENT_SUCCESS;
+  }
+
   return ( *ctx->handler )(
     bt,
     ctx->cpu,
@@ -439,6 +443,32 @@ static rtems_record_client_status consume_32(
     size_t m;
     char *pos;
 
+    if ( ctx->todo == sizeof( ctx->item.format_32 ) ) {
+      /* Decode the complete items directly from the input buffer */
+      while ( n >= sizeof( ctx->item.format_32 ) ) {
+        rtems_record_client_status status;
+        rtems_record_item_32 item;
+
+        memcpy( &item, buf, sizeof( item ) );
+        n -= sizeof( item );
+        buf = (const char *) buf + sizeof( item );
+
+        status = visit(
+          ctx,
+          item.event,
+          item.data
+        );
+
+        if ( status != RTEMS_RECORD_CLIENT_SUCCESS ) {
+          return status;
+        }
+      }
+
+      if ( n == 0 ) {
+        break;
+      }
+    }
+
     m = ctx->todo < n ? ctx->todo : n;
     pos = ctx->pos;
     pos = memcpy( pos, buf, m );
@@ -479,6 +509,32 @@ static rtems_record_client_status consume_64(
     size_t m;
     char *pos;
 
+    if ( ctx->todo == sizeof( ctx->item.format_64 ) ) {
+      /* Decode the complete items directly from the input buffer */
+      while ( n >= sizeof( ctx->item.format_64 ) ) {
+        rtems_record_client_status status;
+        rtems_record_item_64 item;
+
+        memcpy( &item, buf, sizeof( item ) );
+        n -= sizeof( item );
+        buf = (const char *) buf + sizeof( item );
+
+        status = visit(
+          ctx,
+          item.event,
+          item.data
+        );
+
+        if ( status != RTEMS_RECORD_CLIENT_SUCCESS ) {
+          return status;
+        }
+      }
+
+      if ( n == 0 ) {
+        break;
+      }
+    }
+
     m = ctx->todo < n ? ctx->todo : n;
     pos = ctx->pos;
     pos = memcpy( pos, buf, m );
@@ -519,6 +575,32 @@ static rtems_record_client_status consume_swap_32(
     size_t m;
     char *pos;
 
+    if ( ctx->todo == sizeof( ctx->item.format_32 ) ) {
+      /* Decode the complete items directly from the input buffer */
+      while ( n >= sizeof( ctx->item.format_32 ) ) {
+        rtems_record_client_status status;
+        rtems_record_item_32 item;
+
+        memcpy( &item, buf, sizeof( item ) );
+        n -= sizeof( item );
+        buf = (const char *) buf + sizeof( item );
+
+        status = visit(
+          ctx,
+          __builtin_bswap32( item.event ),
+          __builtin_bswap32( item.data )
+        );
+
+        if ( status != RTEMS_RECORD_CLIENT_SUCCESS ) {
+          return status;
+        }
+      }
+
+      if ( n == 0 ) {
+        break;
+      }
+    }
+
     m = ctx->todo < n ? ctx->todo : n;
     pos = ctx->pos;
     pos = memcpy( pos, buf, m );
@@ -559,6 +641,32 @@ static rtems_record_client_status consume_swap_64(
     size_t m;
     char *pos;
 
+    if ( ctx->todo == sizeof( ctx->item.format_64 ) ) {
+      /* Decode the complete items directly from the input buffer */
+      while ( n >= sizeof( ctx->item.format_64 ) ) {
+        rtems_record_client_status status;
+        rtems_record_item_64 item;
+
+        memcpy( &item, buf, sizeof( item ) );
+        n -= sizeof( item );
+        buf = (const char *) buf + sizeof( item );
+
+        status = visit(
+          ctx,
+          __builtin_bswap32( item.event ),
+          __builtin_bswap64( item.data )
+        );
+
+        if ( status != RTEMS_RECORD_CLIENT_SUCCESS ) {
+          return status;
+        }
+      }
+
+      if ( n == 0 ) {
+        break;
+      }
+    }
+
     m = ctx->todo < n ? ctx->todo : n;
     pos = ctx->pos;
     pos = memcpy( pos, buf, m );
@@ -696,6 +804,7 @@ void rtems_record_client_init(
   ctx->to_bt_scaler = UINT64_C( 1 ) << 31;
   ctx->handler = handler;
   ctx->handler_arg = arg;
+  rtems_record_client_set_all_events( ctx, true );
   ctx->todo = sizeof( ctx->header );
   ctx->pos = &ctx->header;
   ctx->consume = consume_init;
@@ -728,3 +837,182 @@ void rtems_record_client_destroy(
 
   free( ctx->per_cpu[ 0 ].items );
 }
+
+/*
+ * The consume handlers of the saved state.  The index of a handler is saved
+ * instead of its address.
+ */
+static rtems_record_client_status ( * const consume_handlers[] )(
+  rtems_record_client_context *,
+  const void *,
+  size_t
+) = {
+  consume_init,
+  consume_32,
+  consume_64,
+  consume_swap_32,
+  consume_swap_64,
+  consume_error
+};
+
+#define CONSUME_HANDLER_COUNT \
+  ( sizeof( consume_handlers ) / sizeof( consume_handlers[ 0 ] ) )
+
+typedef struct {
+  uint32_t consume;
+  uint32_t pos;
+  uint32_t size;
+  uint32_t cpu_count;
+} saved_state;
+
+size_t rtems_record_client_state_size(
+  const rtems_record_client_context *ctx
+)
+{
+  size_t   size;
+  uint32_t cpu;
+
+  size = sizeof( saved_state ) + sizeof( *ctx );
+
+  for ( cpu = 0; cpu < ctx->cpu_count; ++cpu ) {
+    size += ctx->per_cpu[ cpu ].item_index * sizeof( rtems_record_item_64 );
+  }
+
+  return size;
+}
+
+void rtems_record_client_save_state(
+  const rtems_record_client_context *ctx,
+  void                              *buf
+)
+{
+  saved_state saved;
+  char       *out;
+  uint32_t    consume;
+  uint32_t    cpu;
+
+  for ( consume = 0; consume < CONSUME_HANDLER_COUNT; ++consume ) {
+    if ( consume_handlers[ consume ] == ctx->consume ) {
+      break;
+    }
+  }
+
+  saved.consume = consume;
+  saved.pos = (uint32_t) ( (const char *) ctx->pos - (const char *) ctx );
+  saved.size = (uint32_t) sizeof( *ctx );
+  saved.cpu_count = ctx->cpu_count;
+
+  out = buf;
+  memcpy( out, &saved, sizeof( saved ) );
+  out += sizeof( saved );
+  memcpy( out, ctx, sizeof( *ctx ) );
+  out += sizeof( *ctx );
+
+  for ( cpu = 0; cpu < ctx->cpu_count; ++cpu ) {
+    const rtems_record_client_per_cpu *per_cpu;
+    size_t                             n;
+
+    per_cpu = &ctx->per_cpu[ cpu ];
+    n = per_cpu->item_index * sizeof( rtems_record_item_64 );
+
+    if ( n > 0 ) {
+      memcpy( out, per_cpu->items, n );
+      out += n;
+    }
+  }
+}
+
+rtems_record_client_status rtems_record_client_restore_state(
+  rtems_record_client_context *ctx,
+  const void                  *buf,
+  size_t                       n
+)
+{
+  saved_state                 saved;
+  rtems_record_client_context restored;
+  const char                 *in;
+  size_t                      size;
+  rtems_record_item_64       *items;
+  uint32_t                    cpu;
+
+  if ( n < sizeof( saved ) + sizeof( restored ) ) {
+    return RTEMS_RECORD_CLIENT_ERROR_INVALID_STATE;
+  }
+
+  in = buf;
+  memcpy( &saved, in, sizeof( saved ) );
+  in += sizeof( saved );
+  memcpy( &restored, in, sizeof( restored ) );
+  in += sizeof( restored );
+
+  if (
+    saved.consume >= CONSUME_HANDLER_COUNT ||
+    saved.size != sizeof( restored ) ||
+    saved.cpu_count != restored.cpu_count ||
+    restored.cpu_count > RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT ||
+    saved.pos > sizeof( restored ) ||
+    restored.todo > sizeof( restored ) - saved.pos
+  ) {
+    return RTEMS_RECORD_CLIENT_ERROR_INVALID_STATE;
+  }
+
+  size = sizeof( saved ) + sizeof( restored );
+
+  for ( cpu = 0; cpu < restored.cpu_count; ++cpu ) {
+    size_t per_cpu_items;
+
+    per_cpu_items = restored.count != 0 ? restored.count + 1 : 0;
+
+    if ( restored.per_cpu[ cpu ].item_index > per_cpu_items ) {
+      return RTEMS_RECORD_CLIENT_ERROR_INVALID_STATE;
+    }
+
+    size += restored.per_cpu[ cpu ].item_index * sizeof( *items );
+  }
+
+  if ( n != size ) {
+    return RTEMS_RECORD_CLIENT_ERROR_INVALID_STATE;
+  }
+
+  items = NULL;
+
+  if ( restored.count != 0 ) {
+    size_t per_cpu_items;
+
+    per_cpu_items = restored.count + 1;
+    items = malloc( per_cpu_items * restored.cpu_count * sizeof( *items ) );
+
+    if ( items == NULL ) {
+      return RTEMS_RECORD_CLIENT_ERROR_NO_MEMORY;
+    }
+  }
+
+  for ( cpu = 0; cpu < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT; ++cpu ) {
+    restored.per_cpu[ cpu ].items = NULL;
+  }
+
+  for ( cpu = 0; cpu < restored.cpu_count && items != NULL; ++cpu ) {
+    rtems_record_client_per_cpu *per_cpu;
+    size_t                       m;
+
+    per_cpu = &restored.per_cpu[ cpu ];
+    per_cpu->items = items + cpu * ( restored.count + 1 );
+    m = per_cpu->item_index * sizeof( *items );
+
+    if ( m > 0 ) {
+      memcpy( per_cpu->items, in, m );
+      in += m;
+    }
+  }
+
+  restored.consume = consume_handlers[ saved.consume ];
+  restored.pos = (char *) ctx + saved.pos;
+  restored.handler = ctx->handler;
+  restored.handler_arg = ctx->handler_arg;
+  memcpy( restored.event_mask, ctx->event_mask, sizeof( restored.event_mask ) );
+
+  free( ctx->per_cpu[ 0 ].items );
+  *ctx = restored;
+
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
@@ -24,11 +24,104 @@
 
 #include "client.h"
 
+#include <cstdint>
 #include <cstring>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_BASE64_SSSE3 1
+#endif
+
 static const char base64[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
 
+namespace {
+
+// Maps a character to its digit value, 0xff for characters which are not
+// base64 digits.  The pad character maps to 64.
+struct DecodeTable {
+  DecodeTable() {
+    std::memset(values, 0xff, sizeof(values));
+    for (int i = 0; base64[i] != '\0'; ++i) {
+      values[static_cast<unsigned char>(base64[i])] = static_cast<uint8_t>(i);
+    }
+  }
+
+  uint8_t values[256];
+};
+
+}  // namespace
+
+static const DecodeTable kDecodeTable;
+
+// Decodes four digits without padding into three bytes.  Everything else is
+// left to DecodeChar().
+static bool DecodeQuad(const char* in, char* out) {
+  const uint8_t* values = kDecodeTable.values;
+  unsigned a = values[static_cast<unsigned char>(in[0])];
+  unsigned b = values[static_cast<unsigned char>(in[1])];
+  unsigned c = values[static_cast<unsigned char>(in[2])];
+  unsigned d = values[static_cast<unsigned char>(in[3])];
+
+  if (((a | b | c | d) & 0xc0) != 0) {
+    return false;
+  }
+
+  out[0] = static_cast<char>((a << 2) | (b >> 4));
+  out[1] = static_cast<char>((b << 4) | (c >> 2));
+  out[2] = static_cast<char>((c << 6) | d);
+  return true;
+}
+
+#ifdef HAVE_BASE64_SSSE3
+static bool HaveSSSE3() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+}
+
+static const bool kHaveSSSE3 = HaveSSSE3();
+
+// Decodes sixteen digits without padding into twelve bytes.  This stores
+// sixteen bytes to the output.
+// See Wojciech Mula, "Base64 decoding with SIMD instructions".
+__attribute__((target("ssse3"))) static bool DecodeBlock(const char* in,
+                                                         char* out) {
+  const __m128i lut_lo =
+      _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                    0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i lut_hi =
+      _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll =
+      _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+  __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+  __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+  __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+  __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+
+  // Whitespace, the pad character and invalid characters take the slow path
+  if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                                       _mm_setzero_si128())) != 0) {
+    return false;
+  }
+
+  __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+  __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+  str = _mm_add_epi8(str, roll);
+
+  // Pack the 6-bit digits into 24-bit groups
+  str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+  str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+  str = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+                                            13, 12, -1, -1, -1, -1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), str);
+  return true;
+}
+#endif
+
 bool Base64Filter::DecodeChar(int c, char **target) {
   char* s;
 
@@ -76,17 +169,41 @@ bool Base64Filter::DecodeChar(int c, char **target) {
   return true;
 }
 
-bool Base64Filter::Run(void** buf, size_t* n) {
-  char* begin = static_cast<char*>(*buf);
+bool Base64Filter::Run(const void* in_buf,
+                       size_t* in_n,
+                       void* out_buf,
+                       size_t* out_n) {
+  const char* begin = static_cast<const char*>(in_buf);
   const char* in = begin;
-  const char* end = in + *n;
+  const char* end = in + *in_n;
+  char* out = static_cast<char*>(out_buf);
+  char* target = out;
+  char* limit = out + *out_n;
 
-  if (begin == end) {
-    return digits_ == 0;
-  }
+  // Each character may complete a quad of up to three bytes
+  while (in != end && limit - target >= 3) {
+    if (digits_ == 0 && !seen_end_) {
+      // Decode the bulk of the input without the per character state
+#ifdef HAVE_BASE64_SSSE3
+      if (kHaveSSSE3) {
+        while (end - in >= 16 && limit - target >= 16 &&
+               DecodeBlock(in, target)) {
+          in += 16;
+          target += 12;
+        }
+      }
+#endif
+
+      while (end - in >= 4 && limit - target >= 3 && DecodeQuad(in, target)) {
+        in += 4;
+        target += 3;
+      }
+
+      if (in == end || limit - target < 3) {
+        break;
+      }
+    }
 
-  char* target = begin;
-  while (in != end) {
     int c = *in;
     ++in;
     if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
@@ -98,6 +215,7 @@ bool Base64Filter::Run(void** buf, size_t* n) {
     };
   }
 
-  *n = static_cast<size_t>(target - begin);
+  *in_n = static_cast<size_t>(in - begin);
+  *out_n = static_cast<size_t>(target - out);
   return true;
 }
@@ -33,7 +33,7 @@
 
 #include "client.h"
 
-ZlibFilter::ZlibFilter() : buffer_(65536)
+ZlibFilter::ZlibFilter()
 {
   stream_.next_in   = nullptr;
   stream_.avail_in  = 0;
@@ -56,35 +56,26 @@ ZlibFilter::~ZlibFilter()
   inflateEnd(&stream_);
 }
 
-bool ZlibFilter::Run(void** buf, size_t* n) {
-  stream_.next_in = static_cast<unsigned char*>(*buf);
-  stream_.avail_in = *n;
-  stream_.next_out = &buffer_[0];
-  size_t avail_out = 0;
-  size_t buffer_size = buffer_.size();
-  size_t chunk_size = buffer_size;
-  stream_.avail_out = buffer_size;
+bool ZlibFilter::Run(const void* in, size_t* in_n, void* out, size_t* out_n) {
+  stream_.next_in = static_cast<Bytef*>(const_cast<void*>(in));
+  stream_.avail_in = *in_n;
+  stream_.next_out = static_cast<Bytef*>(out);
+  stream_.avail_out = *out_n;
 
-  while (true) {
-    int err = inflate(&stream_, Z_NO_FLUSH);
-    if (err != Z_OK && err != Z_STREAM_END) {
-      return false;
-    }
-
-    if (stream_.avail_in > 0) {
-      chunk_size = buffer_size;
-      buffer_size *= 2;
-      buffer_.resize(buffer_size);
-      stream_.next_out = reinterpret_cast<Bytef*>(&buffer_[chunk_size]);
-      stream_.avail_out = chunk_size;
-      avail_out += chunk_size;
-      continue;
-    }
+  // Z_BUF_ERROR just indicates that no progress was possible
+  int err = inflate(&stream_, Z_NO_FLUSH);
+  if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+    return false;
+  }
 
-    *buf = &buffer_[0];
-    *n = avail_out + chunk_size - stream_.avail_out;
-    return true;
+  // The input may be a sequence of independently compressed members
+  if (err == Z_STREAM_END) {
+    inflateReset(&stream_);
   }
+
+  *in_n -= stream_.avail_in;
+  *out_n -= stream_.avail_out;
+  return true;
 }
 
 #endif  // HAVE_ZLIB_H
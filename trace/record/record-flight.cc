@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <algorithm>
+
+FlightRecorder::FlightRecorder(rtems_record_client_handler handler,
+                               void* arg,
+                               size_t size,
+                               uint64_t after_ns)
+    : handler_(handler),
+      arg_(arg),
+      capacity_(std::max(size / sizeof(Item), static_cast<size_t>(1))),
+      after_ns_(after_ns) {}
+
+void FlightRecorder::SetTriggers(
+    const std::vector<rtems_record_event>& events) {
+  for (auto event : events) {
+    is_trigger_[event] = true;
+  }
+}
+
+void FlightRecorder::Keep(uint32_t cpu, const Item& item) {
+  Ring& ring = rings_[cpu];
+  if (ring.items.empty()) {
+    // Allocate the ring only for the processors which produce items
+    ring.items.resize(capacity_);
+  }
+
+  if (ring.count == capacity_) {
+    const Item& oldest = ring.items[ring.head];
+    switch (oldest.event) {
+      case RTEMS_RECORD_THREAD_CREATE:
+      case RTEMS_RECORD_THREAD_ID:
+      case RTEMS_RECORD_THREAD_NAME:
+        if (ring.retained.size() == capacity_) {
+          // Bound the memory if threads are created all the time
+          ring.retained.erase(ring.retained.begin(),
+                              ring.retained.begin() + capacity_ / 2);
+        }
+
+        ring.retained.push_back(oldest);
+        break;
+      default:
+        break;
+    }
+
+    ring.items[ring.head] = item;
+    ring.head = (ring.head + 1) % capacity_;
+  } else {
+    ring.items[(ring.head + ring.count) % capacity_] = item;
+    ++ring.count;
+  }
+}
+
+rtems_record_client_status FlightRecorder::Dump() {
+  // The retained items and then the ring items of a processor are in time
+  // order, so pass the oldest next item of all processors.  An item without
+  // a time goes with the previous item of its processor.
+  size_t next[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  uint64_t last_bt[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  rtems_record_client_status status = RTEMS_RECORD_CLIENT_SUCCESS;
+
+  while (status == RTEMS_RECORD_CLIENT_SUCCESS) {
+    uint32_t oldest_cpu = RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT;
+    const Item* oldest = nullptr;
+    uint64_t oldest_bt = 0;
+
+    for (uint32_t cpu = 0; cpu < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT; ++cpu) {
+      const Ring& ring = rings_[cpu];
+      size_t i = next[cpu];
+      const Item* item;
+      if (i < ring.retained.size()) {
+        item = &ring.retained[i];
+      } else if (i - ring.retained.size() < ring.count) {
+        item = &ring.items[(ring.head + i - ring.retained.size()) % capacity_];
+      } else {
+        continue;
+      }
+
+      uint64_t bt = item->bt != 0 ? item->bt : last_bt[cpu];
+      if (oldest == nullptr || bt < oldest_bt) {
+        oldest_cpu = cpu;
+        oldest = item;
+        oldest_bt = bt;
+      }
+    }
+
+    if (oldest == nullptr) {
+      break;
+    }
+
+    last_bt[oldest_cpu] = oldest_bt;
+    ++next[oldest_cpu];
+    status = (*handler_)(oldest->bt, oldest_cpu, oldest->event, oldest->data,
+                         arg_);
+  }
+
+  for (auto& ring : rings_) {
+    ring.head = 0;
+    ring.count = 0;
+    ring.retained.clear();
+  }
+
+  return status;
+}
+
+rtems_record_client_status FlightRecorder::Push(uint64_t bt,
+                                                uint32_t cpu,
+                                                rtems_record_event event,
+                                                uint64_t data) {
+  if (cpu >= RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT) {
+    return RTEMS_RECORD_CLIENT_SUCCESS;
+  }
+
+  // Pass the items before the first item with a time, they describe the
+  // system and the record format
+  if (bt == 0 && last_ns_[cpu] == 0) {
+    return (*handler_)(bt, cpu, event, data, arg_);
+  }
+
+  // An item without a time goes with the previous item of its processor
+  uint64_t ns = last_ns_[cpu];
+  if (bt != 0) {
+    ns = rtems_record_client_bintime_to_nanoseconds(bt);
+    last_ns_[cpu] = ns;
+  }
+
+  bool trigger = is_trigger_[event] || trigger_ != 0;
+  if (trigger) {
+    trigger_ = 0;
+    ++triggers_;
+    end_ns_ = ns + after_ns_;
+  } else if (triggers_ != 0 && ns <= end_ns_) {
+    return (*handler_)(bt, cpu, event, data, arg_);
+  }
+
+  Item item;
+  item.bt = bt;
+  item.data = data;
+  item.event = event;
+  Keep(cpu, item);
+
+  if (!trigger) {
+    return RTEMS_RECORD_CLIENT_SUCCESS;
+  }
+
+  return Dump();
+}
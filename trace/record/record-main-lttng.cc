@@ -32,20 +32,33 @@
 
 #include "client.h"
 
+#include <fcntl.h>
 #include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cinttypes>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #ifdef HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
+#include <llvm/DebugInfo/DWARF/DWARFContext.h>
 #include <llvm/DebugInfo/Symbolize/Symbolize.h>
+#include <llvm/Object/Binary.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
 #include <llvm/Support/Path.h>
 #endif
 
@@ -54,12 +67,20 @@
 #define TASK_IDLE 0x0402
 #define UUID_SIZE 16
 #define THREAD_NAME_SIZE 16
-#define THREAD_API_COUNT 3
-#define THREAD_ID_COUNT 0x10000
 #define BITS_PER_CHAR 8
 #define COMPACT_HEADER_ID 31
-
-static const uint8_t kEmptyThreadName[THREAD_NAME_SIZE] = "";
+#define CTF_INDEX_MAGIC 0xC1F1DCC1
+#define CTF_INDEX_MAJOR 1
+#define CTF_INDEX_MINOR 1
+#define DEFAULT_PACKET_SIZE (1024 * 1024)
+
+#define DEFAULT_MERGE_LATENCY 10000000
+#define DEFAULT_AFTER_TRIGGER 1000
+#define DEFAULT_CHECKPOINT_INTERVAL (64 * 1024 * 1024)
+#define DEFAULT_BENCHMARK_DIRECTORY "rtems-record-benchmark"
+#define STREAM_BUFFER_SIZE (2 * 1024 * 1024)
+#define WORK_RING_BLOCKS 16
+#define WORK_RING_BLOCK_SIZE 65536
 
 static const uint8_t kUUID[] = {0x6a, 0x77, 0x15, 0xd0, 0xb5, 0x02, 0x4c, 0x65,
                                 0x86, 0x78, 0x67, 0x77, 0xac, 0x7f, 0x75, 0x5a};
@@ -71,6 +92,16 @@ struct ClientItem {
   uint64_t data;
 };
 
+/*
+ * An item handed over to the writer thread of a processor.  The thread name
+ * of thread switch events is resolved by the decoding thread since the thread
+ * names are shared by all processors.
+ */
+struct WorkItem {
+  ClientItem item;
+  uint8_t comm[THREAD_NAME_SIZE];
+};
+
 struct PacketHeader {
   uint32_t ctf_magic;
   uint8_t uuid[UUID_SIZE];
@@ -91,6 +122,28 @@ struct PacketContext {
 
 static const size_t kPacketContextBits = sizeof(PacketContext) * BITS_PER_CHAR;
 
+/*
+ * The LTTng packet index file format.  All values are big-endian.
+ */
+struct PacketIndexFileHeader {
+  uint32_t magic;
+  uint32_t index_major;
+  uint32_t index_minor;
+  uint32_t packet_index_len;
+} __attribute__((__packed__));
+
+struct PacketIndex {
+  uint64_t offset;
+  uint64_t packet_size;
+  uint64_t content_size;
+  uint64_t timestamp_begin;
+  uint64_t timestamp_end;
+  uint64_t events_discarded;
+  uint64_t stream_id;
+  uint64_t stream_instance_id;
+  uint64_t packet_seq_num;
+} __attribute__((__packed__));
+
 struct EventHeaderCompact {
   uint8_t id;
   uint32_t event_id;
@@ -138,17 +191,96 @@ static const size_t kEventIRQHandlerExitBits =
     sizeof(EventIRQHandlerExit) * BITS_PER_CHAR;
 
 struct PerCPUContext {
-  FILE* event_stream;
+  PacketContext packet_context;
+  int event_stream;
+  uint64_t event_stream_offset;
+  std::vector<uint8_t> event_buffer;
+  FILE* index_stream;
   uint64_t timestamp_begin;
   uint64_t timestamp_end;
+  uint64_t packet_timestamp_begin;
+  uint64_t packet_seq_num;
+  uint64_t packet_offset;
   uint64_t size_in_bits;
-  uint32_t thread_id;
-  uint64_t thread_ns;
-  size_t thread_name_index;
   EventRecordItem record_item;
   EventSchedSwitch sched_switch;
   EventIRQHandlerEntry irq_handler_entry;
   EventIRQHandlerExit irq_handler_exit;
+  std::map<uint64_t, const std::vector<char>*> code_cache;
+  std::unique_ptr<BlockRing> work_ring;
+  BlockRing::Block* work_block;
+  std::thread worker;
+  std::exception_ptr worker_error;
+};
+
+/*
+ * Resolves the code addresses of an executable to the function, file, and
+ * line.  It may be shared by clients and used by their writer threads.
+ */
+class AddressResolver {
+ public:
+  AddressResolver() = default;
+
+  AddressResolver(const AddressResolver&) = delete;
+
+  AddressResolver& operator=(const AddressResolver&) = delete;
+
+  /*
+   * Opens the executable.  If address_table is true, then the codes of all
+   * line table rows are resolved in advance.
+   */
+  void Open(const char* elf_file, bool address_table);
+
+  /*
+   * Returns the code of the address from the address table, nullptr if it is
+   * not covered by the table.  The table is not changed after Open().
+   */
+  const std::vector<char>* LookUpAddressTable(uint64_t address) const;
+
+  /*
+   * Returns the code of the address, it is resolved on demand.  The elements
+   * are never removed, so the references stay valid.
+   */
+  const std::vector<char>& Resolve(uint64_t address);
+
+ private:
+#ifdef HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
+  llvm::symbolize::LLVMSymbolizer symbolizer_;
+#endif
+
+  std::string elf_file_;
+
+  bool resolve_address_ = false;
+
+  typedef std::map<uint64_t, std::vector<char>> AddressToLineMap;
+
+  AddressToLineMap address_to_line_;
+
+  std::mutex address_to_line_mutex_;
+
+  /*
+   * @brief The code of the line table rows of the executable sorted by
+   * address.
+   *
+   * An entry covers the addresses up to the next entry.  Entries with
+   * kNoCode cover addresses outside of the line tables.
+   */
+  struct AddressTableEntry {
+    uint64_t address;
+    uint32_t code;
+  };
+
+  static const uint32_t kNoCode = UINT32_MAX;
+
+  std::vector<AddressTableEntry> address_table_;
+
+  std::vector<std::vector<char>> address_codes_;
+
+  AddressToLineMap::iterator AddAddressAsHexNumber(uint64_t address);
+
+  AddressToLineMap::iterator ResolveAddress(uint64_t address);
+
+  void BuildAddressTable();
 };
 
 class LTTNGClient : public Client {
@@ -161,37 +293,73 @@ class LTTNGClient : public Client {
 
   void OpenExecutable(const char* elf_file);
 
-  void Destroy() {
+  void set_packet_size(size_t packet_size) { packet_size_ = packet_size; }
+
+  void set_index(bool index) { index_ = index; }
+
+  void set_threads(bool threads) { threads_ = threads; }
+
+  void set_address_table(bool address_table) {
+    address_table_enabled_ = address_table;
+  }
+
+  // Uses the executable opened by another client.
+  void set_resolver(std::shared_ptr<AddressResolver> resolver) {
+    resolver_ = resolver;
+  }
+
+  std::shared_ptr<AddressResolver> resolver() const { return resolver_; }
+
+  // Writes the trace files to the directory, it is created if necessary.
+  void set_directory(const std::string& directory) { directory_ = directory; }
+
+  void set_live_interval(uint64_t live_interval) {
+    live_interval_ = live_interval;
+  }
+
+  virtual void Destroy() {
     Client::Destroy();
+    StopWorkers();
     CloseStreamFiles();
   }
 
+ protected:
+  virtual size_t WriterBacklog() const;
+
+  virtual void SaveState(Checkpoint* checkpoint);
+
+  virtual void RestoreState(Checkpoint* checkpoint);
+
  private:
   PerCPUContext per_cpu_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT];
 
   /*
-   * @brief Thread names indexed by API and object index.
-   *
-   * The API indices are 0 for Internal API, 1 for Classic API and 2 for
-   * POSIX API.
+   * @brief Thread names by object identifier.
    */
-  uint8_t thread_names_[THREAD_API_COUNT][THREAD_ID_COUNT][THREAD_NAME_SIZE];
-
-  PacketContext pkt_ctx_;
+  ThreadNames thread_names_;
 
   size_t cpu_count_ = 0;
 
-#ifdef HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
-  llvm::symbolize::LLVMSymbolizer symbolizer_;
-#endif
+  size_t packet_size_ = DEFAULT_PACKET_SIZE;
 
-  std::string elf_file_;
+  bool index_ = false;
 
-  bool resolve_address_ = false;
+  bool threads_ = false;
 
-  typedef std::map<uint64_t, std::vector<char>> AddressToLineMap;
+  /*
+   * @brief The time span in nanoseconds after which a new packet is started
+   * for live output, zero if the output is not live.
+   *
+   * A live stream is written only in complete packets, so that it can be a
+   * FIFO or a file which is read while it grows.
+   */
+  uint64_t live_interval_ = 0;
 
-  AddressToLineMap address_to_line_;
+  std::string directory_;
+
+  bool address_table_enabled_ = false;
+
+  std::shared_ptr<AddressResolver> resolver_;
 
   std::vector<std::string> event_to_name_;
 
@@ -213,42 +381,78 @@ class LTTNGClient : public Client {
                       size_t api_index,
                       uint8_t* dst) const;
 
+  const std::vector<char>& GetCode(PerCPUContext* pcpu, const ClientItem& item);
+
   void WriteRecordItem(PerCPUContext* pcpu, const ClientItem& item);
 
-  void WriteSchedSwitch(PerCPUContext* pcpu, const ClientItem& item);
+  void WriteSchedSwitch(PerCPUContext* pcpu,
+                        const ClientItem& item,
+                        const uint8_t* next_comm);
 
   void WriteIRQHandlerEntry(PerCPUContext* pcpu, const ClientItem& item);
 
   void WriteIRQHandlerExit(PerCPUContext* pcpu, const ClientItem& item);
 
-  void ResetThreadName(PerCPUContext* pcpu, const ClientItem& item);
+  void PrintItem(const ClientItem& item);
+
+  void SubmitItem(PerCPUContext* pcpu,
+                  const ClientItem& item,
+                  const uint8_t* comm);
 
-  void AddThreadName(PerCPUContext* pcpu, const ClientItem& item);
+  void WriteItem(PerCPUContext* pcpu,
+                 const ClientItem& item,
+                 const uint8_t* comm);
 
-  void PrintItem(const ClientItem& item);
+  void StartWorkers();
+
+  void StopWorkers();
+
+  void RunWorker(PerCPUContext* pcpu);
 
   static std::string EventNameParser(void* arg,
                                      const char* name,
                                      const char* value);
 
-  void OpenStreamFiles(uint64_t data);
+  std::string GetPath(const std::string& name) const {
+    return directory_.empty() ? name : directory_ + "/" + name;
+  }
+
+  /*
+   * Opens the stream files of the processors.  If resume is true, then the
+   * files of a checkpoint are opened to continue them.
+   */
+  void OpenStreamFiles(uint64_t data, bool resume = false);
 
   void CloseStreamFiles();
 
-  AddressToLineMap::iterator AddAddressAsHexNumber(const ClientItem& item);
+  void ReservePacket(PerCPUContext* pcpu, const ClientItem& item, size_t bits);
+
+  void Append(PerCPUContext* pcpu, const void* data, size_t size);
+
+  void Flush(PerCPUContext* pcpu);
+
+  void WriteAt(PerCPUContext* pcpu,
+               uint64_t offset,
+               const void* data,
+               size_t size);
+
+  void OpenPacket(PerCPUContext* pcpu, uint64_t timestamp_begin);
+
+  void ClosePacket(PerCPUContext* pcpu, size_t cpu, uint64_t timestamp_end);
 
-  AddressToLineMap::iterator ResolveAddress(const ClientItem& item);
 };
 
-LTTNGClient::LTTNGClient() : event_to_name_(RTEMS_RECORD_LAST + 1) {
+LTTNGClient::LTTNGClient()
+    : resolver_(std::make_shared<AddressResolver>()),
+      event_to_name_(RTEMS_RECORD_LAST + 1) {
   Initialize(LTTNGClient::HandlerCaller);
 
-  std::memset(&pkt_ctx_, 0, sizeof(pkt_ctx_));
-  std::memcpy(pkt_ctx_.header.uuid, kUUID, sizeof(pkt_ctx_.header.uuid));
-  pkt_ctx_.header.ctf_magic = CTF_MAGIC;
-
   for (size_t i = 0; i < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT; ++i) {
     PerCPUContext& pcpu = per_cpu_[i];
+    PacketContext& pkt_ctx = pcpu.packet_context;
+    std::memset(&pkt_ctx, 0, sizeof(pkt_ctx));
+    std::memcpy(pkt_ctx.header.uuid, kUUID, sizeof(pkt_ctx.header.uuid));
+    pkt_ctx.header.ctf_magic = CTF_MAGIC;
     pcpu.sched_switch.header.id = COMPACT_HEADER_ID;
     pcpu.sched_switch.header.event_id = 1024;
     pcpu.irq_handler_entry.header.id = COMPACT_HEADER_ID;
@@ -270,10 +474,6 @@ static uint32_t GetAPIIndexOfID(uint32_t id) {
   return ((id >> 24) & 0x7) - 1;
 }
 
-static uint32_t GetObjIndexOfID(uint32_t id) {
-  return id & (THREAD_ID_COUNT - 1);
-}
-
 static bool IsIdleTaskByAPIIndex(uint32_t api_index) {
   return api_index == 0;
 }
@@ -288,21 +488,13 @@ static const uint8_t kCPUPostfix[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT][2] = {
     {'3', '0'},  {'3', '1'}};
 
 void LTTNGClient::OpenExecutable(const char* elf_file) {
-  elf_file_ = elf_file;
-  resolve_address_ = true;
+  resolver_->Open(elf_file, address_table_enabled_);
 }
 
 void LTTNGClient::CopyThreadName(const ClientItem& item,
                                  size_t api_index,
                                  uint8_t* dst) const {
-  const uint8_t* name;
-
-  if (api_index < THREAD_API_COUNT) {
-    name = thread_names_[api_index][GetObjIndexOfID(item.data)];
-  } else {
-    name = kEmptyThreadName;
-  }
-
+  const uint8_t* name = thread_names_.Get(static_cast<uint32_t>(item.data));
   std::memcpy(dst, name, THREAD_NAME_SIZE);
 
   if (IsIdleTaskByAPIIndex(api_index)) {
@@ -332,48 +524,260 @@ static bool IsCodeEvent(rtems_record_event event) {
   }
 }
 
-LTTNGClient::AddressToLineMap::iterator LTTNGClient::AddAddressAsHexNumber(
-    const ClientItem& item) {
+void AddressResolver::Open(const char* elf_file, bool address_table) {
+  elf_file_ = elf_file;
+  resolve_address_ = true;
+
+  if (address_table) {
+    BuildAddressTable();
+  }
+}
+
+AddressResolver::AddressToLineMap::iterator
+AddressResolver::AddAddressAsHexNumber(uint64_t address) {
   char hex[19];
-  int n = std::snprintf(hex, sizeof(hex), "0x%" PRIx64, item.data);
+  int n = std::snprintf(hex, sizeof(hex), "0x%" PRIx64, address);
   assert(static_cast<size_t>(n) < sizeof(hex));
   std::vector<char> code(hex, hex + n + 1);
-  return address_to_line_.emplace(item.data, std::move(code)).first;
+  return address_to_line_.emplace(address, std::move(code)).first;
+}
+
+#ifdef HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
+static bool SymbolizeCode(llvm::symbolize::LLVMSymbolizer* symbolizer,
+                          const std::string& elf_file,
+                          uint64_t address,
+                          std::vector<char>* code) {
+  auto res_or_err = symbolizer->symbolizeCode(
+      elf_file,
+#if LLVM_VERSION_MAJOR >= 9
+      {address, llvm::object::SectionedAddress::UndefSection});
+#else
+      address);
+#endif
+
+  if (!res_or_err) {
+    llvm::consumeError(res_or_err.takeError());
+    return false;
+  }
+
+  auto info = res_or_err.get();
+  std::string fn = info.FunctionName;
+  std::string str;
+
+  if (fn != "<invalid>") {
+    str += fn;
+    str += " at ";
+  }
+
+  str += llvm::sys::path::filename(info.FileName);
+  str += ":";
+  str += std::to_string(info.Line);
+  code->assign(str.begin(), str.end());
+  code->push_back('\0');
+  return true;
 }
+#endif
 
-LTTNGClient::AddressToLineMap::iterator LTTNGClient::ResolveAddress(
-    const ClientItem& item) {
+AddressResolver::AddressToLineMap::iterator AddressResolver::ResolveAddress(
+    uint64_t address) {
 #ifdef HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
   if (resolve_address_) {
-    auto res_or_err = symbolizer_.symbolizeCode(
-        elf_file_,
+    std::vector<char> code;
+    if (SymbolizeCode(&symbolizer_, elf_file_, address, &code)) {
+      return address_to_line_.emplace(address, std::move(code)).first;
+    }
+  }
+#endif
+
+  return AddAddressAsHexNumber(address);
+}
+
+void AddressResolver::BuildAddressTable() {
+#ifdef HAVE_LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
+  auto binary_or_err = llvm::object::createBinary(elf_file_);
+  if (!binary_or_err) {
+    llvm::consumeError(binary_or_err.takeError());
+    throw std::runtime_error("cannot open ELF file '" + elf_file_ + "'");
+  }
+
+  auto* object =
+      llvm::dyn_cast<llvm::object::ObjectFile>(binary_or_err->getBinary());
+  if (object == nullptr) {
+    throw std::runtime_error("invalid ELF file '" + elf_file_ + "'");
+  }
+
+  /*
+   * The symbolizer takes the file and line from the line table row, the
+   * function name from the symbol table or the function debug information
+   * covering the address.  Split the table at all these boundaries, so that
+   * the code of an entry is the code of all addresses it covers.
+   */
+  enum { kRowStart, kSequenceEnd, kBoundary };
+  std::vector<std::pair<uint64_t, int>> points;
+  std::unique_ptr<llvm::DWARFContext> dwarf =
+      llvm::DWARFContext::create(*object);
+  for (const auto& cu : dwarf->compile_units()) {
+    const llvm::DWARFDebugLine::LineTable* table =
+        dwarf->getLineTableForUnit(cu.get());
+    if (table != nullptr) {
+      for (const auto& row : table->Rows) {
 #if LLVM_VERSION_MAJOR >= 9
-        {item.data, llvm::object::SectionedAddress::UndefSection});
+        uint64_t address = row.Address.Address;
 #else
-        item.data);
+        uint64_t address = row.Address;
 #endif
+        points.emplace_back(address, row.EndSequence ? kSequenceEnd : kRowStart);
+      }
+    }
+
+    for (const auto& entry : cu->dies()) {
+      llvm::DWARFDie die(cu.get(), &entry);
+      if (die.getTag() != llvm::dwarf::DW_TAG_subprogram &&
+          die.getTag() != llvm::dwarf::DW_TAG_inlined_subroutine) {
+        continue;
+      }
+
+      auto ranges_or_err = die.getAddressRanges();
+      if (!ranges_or_err) {
+        llvm::consumeError(ranges_or_err.takeError());
+        continue;
+      }
+
+      for (const auto& range : ranges_or_err.get()) {
+        points.emplace_back(range.LowPC, kBoundary);
+        points.emplace_back(range.HighPC, kBoundary);
+      }
+    }
+  }
+
+  for (const auto& symbol : llvm::object::computeSymbolSizes(*object)) {
+    auto address_or_err = symbol.first.getAddress();
+    if (!address_or_err) {
+      llvm::consumeError(address_or_err.takeError());
+      continue;
+    }
+
+    points.emplace_back(address_or_err.get(), kBoundary);
+    points.emplace_back(address_or_err.get() + symbol.second, kBoundary);
+  }
+
+  // A row start wins over the end of another sequence at the same address
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end(),
+                           [](const std::pair<uint64_t, int>& a,
+                              const std::pair<uint64_t, int>& b) {
+                             return a.first == b.first;
+                           }),
+               points.end());
+
+  // A boundary is covered by the line tables if the preceding row is
+  std::vector<std::pair<uint64_t, bool>> rows;
+  bool covered = false;
+  for (const auto& point : points) {
+    if (point.second != kBoundary) {
+      covered = point.second == kRowStart;
+    }
 
-    if (res_or_err) {
-      auto info = res_or_err.get();
-      std::string fn = info.FunctionName;
-      std::string str;
+    rows.emplace_back(point.first, covered);
+  }
+
+  /*
+   * Resolve the rows in parallel.  The symbolizer is not thread-safe, so each
+   * thread uses its own.
+   */
+  std::vector<std::vector<char>> codes(rows.size());
+  size_t jobs = std::max(1U, std::thread::hardware_concurrency());
+  const char* env_jobs = std::getenv("RTEMS_TOOLS_JOBS");
+  if (env_jobs != nullptr && std::atoi(env_jobs) > 0) {
+    jobs = std::atoi(env_jobs);
+  }
+  jobs = std::min(jobs, rows.size() / 4096 + 1);
+  size_t per_job = (rows.size() + jobs - 1) / jobs;
+  std::vector<std::thread> threads;
+  for (size_t j = 0; j < jobs; ++j) {
+    size_t begin = std::min(rows.size(), j * per_job);
+    size_t end = std::min(rows.size(), begin + per_job);
+    threads.emplace_back([this, &rows, &codes, begin, end] {
+      llvm::symbolize::LLVMSymbolizer symbolizer;
+      for (size_t i = begin; i < end; ++i) {
+        if (rows[i].second) {
+          SymbolizeCode(&symbolizer, elf_file_, rows[i].first, &codes[i]);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-      if (fn != "<invalid>") {
-        str += fn;
-        str += " at ";
+  // Share the codes and merge adjacent rows with the same code
+  std::map<std::vector<char>, uint32_t> code_indices;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    uint32_t code = kNoCode;
+    if (!codes[i].empty()) {
+      auto it = code_indices.emplace(std::move(codes[i]),
+                                     static_cast<uint32_t>(code_indices.size()));
+      code = it.first->second;
+      if (it.second) {
+        address_codes_.push_back(it.first->first);
       }
+    }
 
-      str += llvm::sys::path::filename(info.FileName);
-      str += ":";
-      str += std::to_string(info.Line);
-      std::vector<char> code(str.begin(), str.end());
-      code.push_back('\0');
-      return address_to_line_.emplace(item.data, std::move(code)).first;
+    if (address_table_.empty() || address_table_.back().code != code) {
+      address_table_.push_back({rows[i].first, code});
     }
   }
 #endif
+}
+
+const std::vector<char>* AddressResolver::LookUpAddressTable(
+    uint64_t address) const {
+  auto it = std::upper_bound(
+      address_table_.begin(), address_table_.end(), address,
+      [](uint64_t a, const AddressTableEntry& e) { return a < e.address; });
+  if (it == address_table_.begin()) {
+    return nullptr;
+  }
+
+  --it;
+  if (it->code == kNoCode) {
+    return nullptr;
+  }
+
+  return &address_codes_[it->code];
+}
+
+const std::vector<char>& AddressResolver::Resolve(uint64_t address) {
+  std::lock_guard<std::mutex> lock(address_to_line_mutex_);
+  auto it = address_to_line_.find(address);
+  if (it == address_to_line_.end()) {
+    it = ResolveAddress(address);
+  }
+
+  return it->second;
+}
+
+const std::vector<char>& LTTNGClient::GetCode(PerCPUContext* pcpu,
+                                              const ClientItem& item) {
+  const std::vector<char>* code = resolver_->LookUpAddressTable(item.data);
+  if (code != nullptr) {
+    return *code;
+  }
+
+  /*
+   * The writer threads share the address to line map.  Look up the code in
+   * the cache of the processor first to avoid the lock in the common case.
+   * The map elements are never removed, so the cached pointers stay valid.
+   */
+  auto cached = pcpu->code_cache.find(item.data);
+  if (cached != pcpu->code_cache.end()) {
+    return *cached->second;
+  }
 
-  return AddAddressAsHexNumber(item);
+  const std::vector<char>& resolved = resolver_->Resolve(item.data);
+  pcpu->code_cache.emplace(item.data, &resolved);
+  return resolved;
 }
 
 void LTTNGClient::WriteRecordItem(PerCPUContext* pcpu, const ClientItem& item) {
@@ -383,17 +787,15 @@ void LTTNGClient::WriteRecordItem(PerCPUContext* pcpu, const ClientItem& item) {
     header.event_id = item.event;
     header.ns = item.ns;
 
-    auto it = address_to_line_.find(item.data);
-    if (it == address_to_line_.end()) {
-      it = ResolveAddress(item);
-    }
-
-    pcpu->size_in_bits += (sizeof(header) + it->second.size()) * BITS_PER_CHAR;
+    const std::vector<char>& code = GetCode(pcpu, item);
+    size_t bits = (sizeof(header) + code.size()) * BITS_PER_CHAR;
+    ReservePacket(pcpu, item, bits);
+    pcpu->size_in_bits += bits;
 
-    std::fwrite(&header, sizeof(header), 1, pcpu->event_stream);
-    std::fwrite(&(*it->second.begin()), it->second.size(), 1,
-                pcpu->event_stream);
+    Append(pcpu, &header, sizeof(header));
+    Append(pcpu, code.data(), code.size());
   } else {
+    ReservePacket(pcpu, item, kEventRecordItemBits);
     pcpu->size_in_bits += kEventRecordItemBits;
 
     EventRecordItem& ri = pcpu->record_item;
@@ -401,12 +803,14 @@ void LTTNGClient::WriteRecordItem(PerCPUContext* pcpu, const ClientItem& item) {
     ri.header.event_id = item.event;
     ri.data = item.data;
 
-    std::fwrite(&ri, sizeof(ri), 1, pcpu->event_stream);
+    Append(pcpu, &ri, sizeof(ri));
   }
 }
 
 void LTTNGClient::WriteSchedSwitch(PerCPUContext* pcpu,
-                                   const ClientItem& item) {
+                                   const ClientItem& item,
+                                   const uint8_t* next_comm) {
+  ReservePacket(pcpu, item, kEventSchedSwitchBits);
   pcpu->size_in_bits += kEventSchedSwitchBits;
 
   EventSchedSwitch& ss = pcpu->sched_switch;
@@ -415,75 +819,104 @@ void LTTNGClient::WriteSchedSwitch(PerCPUContext* pcpu,
   uint32_t api_index = GetAPIIndexOfID(item.data);
   ss.next_tid = IsIdleTaskByAPIIndex(api_index) ? 0 : item.data;
 
-  CopyThreadName(item, api_index, ss.next_comm);
-  std::fwrite(&ss, sizeof(ss), 1, pcpu->event_stream);
+  std::memcpy(ss.next_comm, next_comm, THREAD_NAME_SIZE);
+  Append(pcpu, &ss, sizeof(ss));
 }
 
 void LTTNGClient::WriteIRQHandlerEntry(PerCPUContext* pcpu,
                                        const ClientItem& item) {
+  ReservePacket(pcpu, item, kEventIRQHandlerEntryBits);
   pcpu->size_in_bits += kEventIRQHandlerEntryBits;
 
   EventIRQHandlerEntry& ih = pcpu->irq_handler_entry;
   ih.header.ns = item.ns;
   ih.irq = static_cast<int32_t>(item.data);
-  std::fwrite(&ih, sizeof(ih), 1, pcpu->event_stream);
+  Append(pcpu, &ih, sizeof(ih));
 }
 
 void LTTNGClient::WriteIRQHandlerExit(PerCPUContext* pcpu,
                                       const ClientItem& item) {
+  ReservePacket(pcpu, item, kEventIRQHandlerExitBits);
   pcpu->size_in_bits += kEventIRQHandlerExitBits;
 
   EventIRQHandlerExit& ih = pcpu->irq_handler_exit;
   ih.header.ns = item.ns;
   ih.irq = static_cast<int32_t>(item.data);
-  std::fwrite(&ih, sizeof(ih), 1, pcpu->event_stream);
+  Append(pcpu, &ih, sizeof(ih));
 }
 
-void LTTNGClient::ResetThreadName(PerCPUContext* pcpu, const ClientItem& item) {
-  pcpu->thread_id = item.data;
-  pcpu->thread_ns = item.ns;
-  pcpu->thread_name_index = 0;
+void LTTNGClient::PrintItem(const ClientItem& item) {
+  PerCPUContext& pcpu = per_cpu_[item.cpu];
+  uint8_t comm[THREAD_NAME_SIZE];
 
-  uint32_t api_index = GetAPIIndexOfID(pcpu->thread_id);
-  if (api_index >= THREAD_API_COUNT) {
-    return;
+  switch (item.event) {
+    case RTEMS_RECORD_THREAD_SWITCH_OUT:
+    case RTEMS_RECORD_THREAD_SWITCH_IN:
+      CopyThreadName(item, GetAPIIndexOfID(item.data), comm);
+      break;
+    case RTEMS_RECORD_THREAD_CREATE:
+    case RTEMS_RECORD_THREAD_ID:
+      thread_names_.Reset(item.cpu, static_cast<uint32_t>(item.data));
+      break;
+    case RTEMS_RECORD_THREAD_NAME:
+      thread_names_.Add(item.cpu, item.data, data_size());
+      break;
+    case RTEMS_RECORD_PROCESSOR_MAXIMUM:
+      OpenStreamFiles(item.data);
+      break;
+    default:
+      break;
   }
 
-  uint32_t obj_index = GetObjIndexOfID(pcpu->thread_id);
-  std::memset(&thread_names_[api_index][obj_index][0], 0, THREAD_NAME_SIZE);
-}
+  SubmitItem(&pcpu, item, comm);
 
-void LTTNGClient::AddThreadName(PerCPUContext* pcpu, const ClientItem& item) {
-  if (pcpu->thread_name_index >= THREAD_NAME_SIZE) {
-    return;
+  if (item.event == RTEMS_RECORD_PROCESSOR_MAXIMUM && threads_) {
+    StartWorkers();
   }
+}
 
-  uint32_t api_index = GetAPIIndexOfID(pcpu->thread_id);
-  if (api_index >= THREAD_API_COUNT) {
+void LTTNGClient::SubmitItem(PerCPUContext* pcpu,
+                             const ClientItem& item,
+                             const uint8_t* comm) {
+  if (!pcpu->worker.joinable()) {
+    WriteItem(pcpu, item, comm);
     return;
   }
 
-  uint32_t obj_index = GetObjIndexOfID(pcpu->thread_id);
-  uint64_t name = item.data;
-  size_t i;
-  for (i = pcpu->thread_name_index; i < pcpu->thread_name_index + data_size();
-       ++i) {
-    thread_names_[api_index][obj_index][i] = static_cast<uint8_t>(name);
-    name >>= BITS_PER_CHAR;
+  BlockRing::Block* block = pcpu->work_block;
+  if (block == nullptr) {
+    // The ring is only cancelled if the writer thread failed
+    block = pcpu->work_ring->WaitFree();
+    if (block == nullptr) {
+      return;
+    }
+
+    block->size = 0;
+    pcpu->work_block = block;
   }
 
-  pcpu->thread_name_index = i;
+  WorkItem work;
+  work.item = item;
+  std::memcpy(work.comm, comm, THREAD_NAME_SIZE);
+  std::memcpy(&block->data[block->size], &work, sizeof(work));
+  block->size += sizeof(work);
+
+  if (block->data.size() - block->size < sizeof(work)) {
+    pcpu->work_ring->Push();
+    pcpu->work_block = nullptr;
+  }
 }
 
-void LTTNGClient::PrintItem(const ClientItem& item) {
-  PerCPUContext& pcpu = per_cpu_[item.cpu];
-  if (pcpu.timestamp_begin == 0) {
-    pcpu.timestamp_begin = item.ns;
+void LTTNGClient::WriteItem(PerCPUContext* pcpu,
+                            const ClientItem& item,
+                            const uint8_t* comm) {
+  if (pcpu->timestamp_begin == 0) {
+    pcpu->timestamp_begin = item.ns;
   }
 
-  pcpu.timestamp_end = item.ns;
+  pcpu->timestamp_end = item.ns;
 
-  EventSchedSwitch& ss = pcpu.sched_switch;
+  EventSchedSwitch& ss = pcpu->sched_switch;
   switch (item.event) {
     case RTEMS_RECORD_THREAD_SWITCH_OUT: {
       uint32_t api_index = GetAPIIndexOfID(item.data);
@@ -497,70 +930,140 @@ void LTTNGClient::PrintItem(const ClientItem& item) {
         ss.prev_state = TASK_RUNNING;
       }
 
-      CopyThreadName(item, api_index, ss.prev_comm);
+      std::memcpy(ss.prev_comm, comm, THREAD_NAME_SIZE);
       break;
     }
     case RTEMS_RECORD_THREAD_SWITCH_IN:
       if (item.ns == ss.header.ns) {
-        WriteSchedSwitch(&pcpu, item);
+        WriteSchedSwitch(pcpu, item, comm);
       }
       break;
     case RTEMS_RECORD_THREAD_CREATE:
     case RTEMS_RECORD_THREAD_ID:
-      ResetThreadName(&pcpu, item);
+    case RTEMS_RECORD_THREAD_NAME:
+    case RTEMS_RECORD_PROCESSOR_MAXIMUM:
       break;
     case RTEMS_RECORD_INTERRUPT_ENTRY:
-      WriteIRQHandlerEntry(&pcpu, item);
+      WriteIRQHandlerEntry(pcpu, item);
       break;
     case RTEMS_RECORD_INTERRUPT_EXIT:
-      WriteIRQHandlerExit(&pcpu, item);
-      break;
-    case RTEMS_RECORD_THREAD_NAME:
-      AddThreadName(&pcpu, item);
-      break;
-    case RTEMS_RECORD_PROCESSOR_MAXIMUM:
-      OpenStreamFiles(item.data);
+      WriteIRQHandlerExit(pcpu, item);
       break;
     default:
       if (item.ns != 0) {
-        WriteRecordItem(&pcpu, item);
+        WriteRecordItem(pcpu, item);
       }
       break;
   }
 }
 
-rtems_record_client_status LTTNGClient::Handler(uint64_t bt,
-                                                uint32_t cpu,
-                                                rtems_record_event event,
-                                                uint64_t data) {
-  ClientItem item;
-
-  item.ns = rtems_record_client_bintime_to_nanoseconds(bt);
-  item.cpu = cpu;
-  item.event = event;
-  item.data = data;
-
-  PrintItem(item);
-
-  return RTEMS_RECORD_CLIENT_SUCCESS;
+void LTTNGClient::StartWorkers() {
+  /*
+   * The items are decoded and the thread names are tracked by this thread.
+   * The events of each processor are written to its stream by a thread of
+   * its own.
+   */
+  for (size_t i = 0; i < cpu_count_; ++i) {
+    PerCPUContext* pcpu = &per_cpu_[i];
+    pcpu->work_ring.reset(
+        new BlockRing(WORK_RING_BLOCKS, WORK_RING_BLOCK_SIZE));
+    pcpu->work_block = nullptr;
+    pcpu->worker = std::thread(&LTTNGClient::RunWorker, this, pcpu);
+  }
 }
 
-std::string LTTNGClient::EventNameParser(void* arg,
-                                         const char* name,
-                                         const char* value) {
-  LTTNGClient* self = static_cast<LTTNGClient*>(arg);
-  errno = 0;
-  char* end;
-  long event = std::strtol(name, &end, 0);
-  if (errno == 0 && *end == '\0' && event >= 0 && event <= RTEMS_RECORD_LAST) {
-    self->event_to_name_[event] = value;
-    return ConfigFile::kNoError;
+size_t LTTNGClient::WriterBacklog() const {
+  size_t backlog = 0;
+
+  for (size_t i = 0; i < cpu_count_; ++i) {
+    const BlockRing* ring = per_cpu_[i].work_ring.get();
+    if (ring != nullptr) {
+      backlog += ring->size();
+    }
   }
 
-  return std::string("invalid event: ") + name;
+  return backlog;
 }
 
-void LTTNGClient::ParseConfigFile(const char* config_file) {
+void LTTNGClient::StopWorkers() {
+  for (size_t i = 0; i < cpu_count_; ++i) {
+    PerCPUContext* pcpu = &per_cpu_[i];
+    if (!pcpu->worker.joinable()) {
+      continue;
+    }
+
+    if (pcpu->work_block != nullptr) {
+      pcpu->work_ring->Push();
+      pcpu->work_block = nullptr;
+    }
+
+    pcpu->work_ring->Close();
+    pcpu->worker.join();
+  }
+
+  for (size_t i = 0; i < cpu_count_; ++i) {
+    if (per_cpu_[i].worker_error) {
+      std::rethrow_exception(per_cpu_[i].worker_error);
+    }
+  }
+}
+
+void LTTNGClient::RunWorker(PerCPUContext* pcpu) {
+  BlockRing* ring = pcpu->work_ring.get();
+
+  try {
+    while (true) {
+      BlockRing::Block* block = ring->WaitFront();
+      if (block == nullptr || block->size == 0) {
+        break;
+      }
+
+      for (size_t offset = 0; offset < block->size; offset += sizeof(WorkItem)) {
+        WorkItem work;
+        std::memcpy(&work, &block->data[offset], sizeof(work));
+        WriteItem(pcpu, work.item, work.comm);
+      }
+
+      ring->Pop();
+    }
+  } catch (...) {
+    pcpu->worker_error = std::current_exception();
+    ring->Cancel();
+  }
+}
+
+rtems_record_client_status LTTNGClient::Handler(uint64_t bt,
+                                                uint32_t cpu,
+                                                rtems_record_event event,
+                                                uint64_t data) {
+  ClientItem item;
+
+  item.ns = rtems_record_client_bintime_to_nanoseconds(bt);
+  item.cpu = cpu;
+  item.event = event;
+  item.data = data;
+
+  PrintItem(item);
+
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
+
+std::string LTTNGClient::EventNameParser(void* arg,
+                                         const char* name,
+                                         const char* value) {
+  LTTNGClient* self = static_cast<LTTNGClient*>(arg);
+  errno = 0;
+  char* end;
+  long event = std::strtol(name, &end, 0);
+  if (errno == 0 && *end == '\0' && event >= 0 && event <= RTEMS_RECORD_LAST) {
+    self->event_to_name_[event] = value;
+    return ConfigFile::kNoError;
+  }
+
+  return std::string("invalid event: ") + name;
+}
+
+void LTTNGClient::ParseConfigFile(const char* config_file) {
   if (config_file != nullptr) {
     ConfigFile file;
     file.AddParser("EventNames", EventNameParser, this);
@@ -568,37 +1071,315 @@ void LTTNGClient::ParseConfigFile(const char* config_file) {
   }
 }
 
-void LTTNGClient::OpenStreamFiles(uint64_t data) {
+static void StoreBigEndian(uint32_t value, void* dst) {
+  uint8_t* bytes = static_cast<uint8_t*>(dst);
+
+  for (int i = 3; i >= 0; --i) {
+    bytes[i] = static_cast<uint8_t>(value);
+    value >>= BITS_PER_CHAR;
+  }
+}
+
+static void StoreBigEndian(uint64_t value, void* dst) {
+  uint8_t* bytes = static_cast<uint8_t*>(dst);
+
+  for (int i = 7; i >= 0; --i) {
+    bytes[i] = static_cast<uint8_t>(value);
+    value >>= BITS_PER_CHAR;
+  }
+}
+
+void LTTNGClient::OpenStreamFiles(uint64_t data, bool resume) {
   // Assertions are ensured by C record client
   assert(cpu_count_ == 0 && data < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT);
   cpu_count_ = static_cast<size_t>(data) + 1;
 
+  if (index_ && mkdir(GetPath("index").c_str(), 0777) != 0 &&
+      errno != EEXIST) {
+    throw ErrnoException("cannot create directory '" + GetPath("index") + "'");
+  }
+
   for (size_t i = 0; i < cpu_count_; ++i) {
-    std::string filename("stream_");
+    PerCPUContext* pcpu = &per_cpu_[i];
+    std::string filename(GetPath("stream_"));
     filename += std::to_string(i);
-    FILE* f = std::fopen(filename.c_str(), "wb");
-    if (f == NULL) {
+    int oflag = O_WRONLY | O_CREAT | (resume ? 0 : O_TRUNC);
+#ifdef _WIN32
+    oflag |= O_BINARY;
+#endif
+    int fd = ::open(filename.c_str(), oflag, 0666);
+    if (fd < 0) {
       throw ErrnoException("cannot create file '" + filename + "'");
     }
-    per_cpu_[i].event_stream = f;
-    std::fwrite(&pkt_ctx_, sizeof(pkt_ctx_), 1, f);
+    pcpu->event_stream = fd;
+    pcpu->event_stream_offset = 0;
+    pcpu->event_buffer.reserve(STREAM_BUFFER_SIZE);
+    pcpu->index_stream = NULL;
+
+    if (index_) {
+      std::string index_filename(GetPath("index/stream_") + std::to_string(i) +
+                                 ".idx");
+      FILE* f = std::fopen(index_filename.c_str(), resume ? "r+b" : "wb");
+      if (f == NULL) {
+        throw ErrnoException("cannot create file '" + index_filename + "'");
+      }
+      pcpu->index_stream = f;
+
+      if (resume) {
+        continue;
+      }
+
+      PacketIndexFileHeader header;
+      StoreBigEndian(static_cast<uint32_t>(CTF_INDEX_MAGIC), &header.magic);
+      StoreBigEndian(static_cast<uint32_t>(CTF_INDEX_MAJOR),
+                     &header.index_major);
+      StoreBigEndian(static_cast<uint32_t>(CTF_INDEX_MINOR),
+                     &header.index_minor);
+      StoreBigEndian(static_cast<uint32_t>(sizeof(PacketIndex)),
+                     &header.packet_index_len);
+      std::fwrite(&header, sizeof(header), 1, f);
+    }
+
+    if (!resume) {
+      OpenPacket(pcpu, 0);
+    }
   }
 }
 
 void LTTNGClient::CloseStreamFiles() {
   for (size_t i = 0; i < cpu_count_; ++i) {
     PerCPUContext* pcpu = &per_cpu_[i];
-    std::fseek(pcpu->event_stream, 0, SEEK_SET);
+    ClosePacket(pcpu, i, pcpu->timestamp_end);
+    Flush(pcpu);
+    ::close(pcpu->event_stream);
+
+    if (pcpu->index_stream != NULL) {
+      std::fclose(pcpu->index_stream);
+    }
+  }
+}
+
+void LTTNGClient::SaveState(Checkpoint* checkpoint) {
+  checkpoint->Write(cpu_count_);
+  thread_names_.Save(checkpoint);
+
+  for (size_t i = 0; i < cpu_count_; ++i) {
+    PerCPUContext* pcpu = &per_cpu_[i];
+    uint64_t index_offset = 0;
 
-    pkt_ctx_.header.stream_instance_id = i;
-    pkt_ctx_.timestamp_begin = pcpu->timestamp_begin;
-    pkt_ctx_.timestamp_end = pcpu->timestamp_end;
-    pkt_ctx_.content_size = pcpu->size_in_bits + kPacketContextBits;
-    pkt_ctx_.packet_size = pkt_ctx_.content_size;
-    pkt_ctx_.cpu_id = i;
+    // The index up to the saved offset must survive the end of the program
+    if (pcpu->index_stream != NULL) {
+      if (std::fflush(pcpu->index_stream) != 0) {
+        throw ErrnoException("cannot write index stream");
+      }
 
-    std::fwrite(&pkt_ctx_, sizeof(pkt_ctx_), 1, pcpu->event_stream);
-    std::fclose(pcpu->event_stream);
+      index_offset = static_cast<uint64_t>(std::ftell(pcpu->index_stream));
+    }
+
+    checkpoint->Write(pcpu->packet_context);
+    checkpoint->Write(pcpu->event_stream_offset);
+    checkpoint->Write(pcpu->event_buffer.size());
+    checkpoint->Write(pcpu->event_buffer.data(), pcpu->event_buffer.size());
+    checkpoint->Write(index_offset);
+    checkpoint->Write(pcpu->timestamp_begin);
+    checkpoint->Write(pcpu->timestamp_end);
+    checkpoint->Write(pcpu->packet_timestamp_begin);
+    checkpoint->Write(pcpu->packet_seq_num);
+    checkpoint->Write(pcpu->packet_offset);
+    checkpoint->Write(pcpu->size_in_bits);
+    checkpoint->Write(pcpu->record_item);
+    checkpoint->Write(pcpu->sched_switch);
+    checkpoint->Write(pcpu->irq_handler_entry);
+    checkpoint->Write(pcpu->irq_handler_exit);
+  }
+}
+
+void LTTNGClient::RestoreState(Checkpoint* checkpoint) {
+  size_t cpu_count;
+  checkpoint->Read(&cpu_count);
+  if (cpu_count > RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT) {
+    throw std::runtime_error("invalid processor count in checkpoint");
+  }
+
+  thread_names_.Restore(checkpoint);
+
+  if (cpu_count == 0) {
+    return;
+  }
+
+  // The stream files are cut at the saved offsets, data written after the
+  // checkpoint is written again
+  OpenStreamFiles(cpu_count - 1, true);
+
+  for (size_t i = 0; i < cpu_count_; ++i) {
+    PerCPUContext* pcpu = &per_cpu_[i];
+    uint64_t index_offset;
+    size_t size;
+
+    checkpoint->Read(&pcpu->packet_context);
+    checkpoint->Read(&pcpu->event_stream_offset);
+    checkpoint->Read(&size);
+    pcpu->event_buffer.resize(size);
+    checkpoint->Read(pcpu->event_buffer.data(), size);
+    checkpoint->Read(&index_offset);
+    checkpoint->Read(&pcpu->timestamp_begin);
+    checkpoint->Read(&pcpu->timestamp_end);
+    checkpoint->Read(&pcpu->packet_timestamp_begin);
+    checkpoint->Read(&pcpu->packet_seq_num);
+    checkpoint->Read(&pcpu->packet_offset);
+    checkpoint->Read(&pcpu->size_in_bits);
+    checkpoint->Read(&pcpu->record_item);
+    checkpoint->Read(&pcpu->sched_switch);
+    checkpoint->Read(&pcpu->irq_handler_entry);
+    checkpoint->Read(&pcpu->irq_handler_exit);
+
+    off_t offset = static_cast<off_t>(pcpu->event_stream_offset);
+    if (::ftruncate(pcpu->event_stream, offset) != 0 ||
+        ::lseek(pcpu->event_stream, offset, SEEK_SET) < 0) {
+      throw ErrnoException("cannot restore event stream");
+    }
+
+    if (pcpu->index_stream != NULL) {
+      offset = static_cast<off_t>(index_offset);
+      if (::ftruncate(fileno(pcpu->index_stream), offset) != 0 ||
+          std::fseek(pcpu->index_stream, static_cast<long>(offset),
+                     SEEK_SET) != 0) {
+        throw ErrnoException("cannot restore index stream");
+      }
+    }
+  }
+}
+
+void LTTNGClient::ReservePacket(PerCPUContext* pcpu,
+                                const ClientItem& item,
+                                size_t bits) {
+  /*
+   * Start a new packet if the event does not fit into the current packet or
+   * the packet spans the live interval.  A packet contains at least one
+   * event.
+   */
+  if (pcpu->size_in_bits == 0) {
+    return;
+  }
+
+  uint64_t timestamp_begin = pcpu->packet_seq_num == 0
+                                 ? pcpu->timestamp_begin
+                                 : pcpu->packet_timestamp_begin;
+  if ((packet_size_ != 0 && kPacketContextBits + pcpu->size_in_bits + bits >
+                                packet_size_ * BITS_PER_CHAR) ||
+      (live_interval_ != 0 && item.ns - timestamp_begin >= live_interval_)) {
+    ClosePacket(pcpu, item.cpu, item.ns);
+    OpenPacket(pcpu, item.ns);
+  }
+}
+
+void LTTNGClient::Append(PerCPUContext* pcpu, const void* data, size_t size) {
+  std::vector<uint8_t>& buffer = pcpu->event_buffer;
+
+  // A live stream is flushed only after a packet is closed
+  if (live_interval_ == 0 && buffer.size() + size > STREAM_BUFFER_SIZE) {
+    Flush(pcpu);
+  }
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void LTTNGClient::Flush(PerCPUContext* pcpu) {
+  std::vector<uint8_t>& buffer = pcpu->event_buffer;
+  const uint8_t* data = buffer.data();
+  size_t size = buffer.size();
+
+  while (size > 0) {
+    ssize_t n = ::write(pcpu->event_stream, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw ErrnoException("cannot write event stream");
+    }
+
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+
+  pcpu->event_stream_offset += buffer.size();
+  buffer.clear();
+}
+
+void LTTNGClient::WriteAt(PerCPUContext* pcpu,
+                          uint64_t offset,
+                          const void* data,
+                          size_t size) {
+  /*
+   * Data which is still in the buffer is updated in place, otherwise the
+   * file is updated.
+   */
+  if (offset >= pcpu->event_stream_offset) {
+    std::memcpy(&pcpu->event_buffer[offset - pcpu->event_stream_offset], data,
+                size);
+    return;
+  }
+
+  if (::lseek(pcpu->event_stream, static_cast<off_t>(offset), SEEK_SET) < 0 ||
+      ::write(pcpu->event_stream, data, size) != static_cast<ssize_t>(size) ||
+      ::lseek(pcpu->event_stream,
+              static_cast<off_t>(pcpu->event_stream_offset), SEEK_SET) < 0) {
+    throw ErrnoException("cannot write event stream");
+  }
+}
+
+void LTTNGClient::OpenPacket(PerCPUContext* pcpu, uint64_t timestamp_begin) {
+  PacketContext& pkt_ctx = pcpu->packet_context;
+  pcpu->packet_offset = pcpu->event_stream_offset + pcpu->event_buffer.size();
+  pcpu->packet_timestamp_begin = timestamp_begin;
+  pcpu->size_in_bits = 0;
+  Append(pcpu, &pkt_ctx, sizeof(pkt_ctx));
+}
+
+void LTTNGClient::ClosePacket(PerCPUContext* pcpu,
+                              size_t cpu,
+                              uint64_t timestamp_end) {
+  PacketContext& pkt_ctx = pcpu->packet_context;
+  pkt_ctx.header.stream_instance_id = cpu;
+  if (pcpu->packet_seq_num == 0) {
+    pkt_ctx.timestamp_begin = pcpu->timestamp_begin;
+  } else {
+    pkt_ctx.timestamp_begin = pcpu->packet_timestamp_begin;
+  }
+  pkt_ctx.timestamp_end = timestamp_end;
+  pkt_ctx.content_size = pcpu->size_in_bits + kPacketContextBits;
+  pkt_ctx.packet_size = pkt_ctx.content_size;
+  pkt_ctx.packet_seq_num = pcpu->packet_seq_num;
+  pkt_ctx.cpu_id = cpu;
+
+  WriteAt(pcpu, pcpu->packet_offset, &pkt_ctx, sizeof(pkt_ctx));
+
+  if (pcpu->index_stream != NULL) {
+    PacketIndex index;
+    StoreBigEndian(pcpu->packet_offset, &index.offset);
+    StoreBigEndian(pkt_ctx.packet_size, &index.packet_size);
+    StoreBigEndian(pkt_ctx.content_size, &index.content_size);
+    StoreBigEndian(pkt_ctx.timestamp_begin, &index.timestamp_begin);
+    StoreBigEndian(pkt_ctx.timestamp_end, &index.timestamp_end);
+    StoreBigEndian(pkt_ctx.events_discarded, &index.events_discarded);
+    StoreBigEndian(static_cast<uint64_t>(pkt_ctx.header.stream_id),
+                   &index.stream_id);
+    StoreBigEndian(pkt_ctx.header.stream_instance_id,
+                   &index.stream_instance_id);
+    StoreBigEndian(pkt_ctx.packet_seq_num, &index.packet_seq_num);
+    std::fwrite(&index, sizeof(index), 1, pcpu->index_stream);
+  }
+
+  ++pcpu->packet_seq_num;
+
+  if (live_interval_ != 0) {
+    Flush(pcpu);
+
+    if (pcpu->index_stream != NULL) {
+      std::fflush(pcpu->index_stream);
+    }
   }
 }
 
@@ -728,9 +1509,14 @@ static const char kMetadata[] =
     "};\n";
 
 void LTTNGClient::GenerateMetadata() {
-  FILE* f = std::fopen("metadata", "w");
+  if (!directory_.empty() && mkdir(directory_.c_str(), 0777) != 0 &&
+      errno != EEXIST) {
+    throw ErrnoException("cannot create directory '" + directory_ + "'");
+  }
+
+  FILE* f = std::fopen(GetPath("metadata").c_str(), "w");
   if (f == NULL) {
-    throw ErrnoException("cannot create file 'metadata'");
+    throw ErrnoException("cannot create file '" + GetPath("metadata") + "'");
   }
 
   std::fwrite(kMetadata, sizeof(kMetadata) - 1, 1, f);
@@ -768,17 +1554,53 @@ void LTTNGClient::GenerateMetadata() {
 
 static LTTNGClient client;
 
+static SummaryClient summary_client;
+
+static TextClient text_client;
+
+static PerfettoClient perfetto_client;
+
+static Client* active_client = &client;
+
+static std::vector<Client*> running_clients;
+
 static void SignalHandler(int s) {
-  client.RequestStop();
+  for (auto running : running_clients) {
+    running->RequestStop();
+  }
+
   std::signal(s, SIG_DFL);
 }
 
+#ifdef SIGUSR1
+static void TriggerHandler(int s) {
+  for (auto running : running_clients) {
+    running->Trigger();
+  }
+
+  std::signal(s, TriggerHandler);
+}
+#endif
+
 static const struct option kLongOpts[] = {
     {"elf", 1, NULL, 'e'},      {"help", 0, NULL, 'h'},
     {"host", 1, NULL, 'H'},     {"port", 1, NULL, 'p'},
     {"limit", 1, NULL, 'l'},    {"base64", 0, NULL, 'b'},
     {"zlib", 0, NULL, 'z'},     {"config", 1, NULL, 'c'},
-    {"defaults", 0, NULL, 'd'}, {NULL, 0, NULL, 0}};
+    {"defaults", 0, NULL, 'd'}, {"packet-size", 1, NULL, 's'},
+    {"index", 0, NULL, 'i'},    {"pipeline", 0, NULL, 'P'},
+    {"threads", 0, NULL, 't'},  {"address-table", 0, NULL, 'a'},
+    {"live", 1, NULL, 'L'},     {"record", 1, NULL, 'r'},
+    {"replay", 0, NULL, 'R'},   {"begin", 1, NULL, 'B'},
+    {"end", 1, NULL, 'E'},      {"statistics", 1, NULL, 'S'},
+    {"summary", 1, NULL, 'm'},  {"text", 0, NULL, 'x'},
+    {"merge", 1, NULL, 'M'},    {"events", 1, NULL, 'f'},
+    {"perfetto", 1, NULL, 'O'}, {"connect", 1, NULL, 'C'},
+    {"flight-recorder", 1, NULL, 'F'}, {"trigger", 1, NULL, 'T'},
+    {"after-trigger", 1, NULL, 'A'}, {"checkpoint", 1, NULL, 'k'},
+    {"checkpoint-interval", 1, NULL, 'K'}, {"resume", 0, NULL, 'u'},
+    {"benchmark", 1, NULL, 'w'},
+    {NULL, 0, NULL, 0}};
 
 static void Usage(char** argv) {
   std::cout << argv[0] << " [OPTION]... [INPUT-FILE]" << std::endl
@@ -805,9 +1627,225 @@ static void Usage(char** argv) {
             << "  -d, --defaults             print default values for "
                "configuration file"
             << std::endl
+            << "  -s, --packet-size=SIZE     the maximum size in bytes of a "
+               "packet, 0 for one packet per stream (default "
+            << DEFAULT_PACKET_SIZE << ")" << std::endl
+            << "  -i, --index                write the packet index files"
+            << std::endl
+            << "  -P, --pipeline             receive, filter, and decode the "
+               "input in separate threads,"
+            << std::endl
+            << "                             decode the chunks of a recording "
+               "file in parallel"
+            << std::endl
+            << "  -t, --threads              write the stream of each "
+               "processor in a separate thread"
+            << std::endl
+            << "  -a, --address-table        resolve the code addresses of "
+               "the ELF file in advance"
+            << std::endl
+            << "  -L, --live=INTERVAL        write complete packets of at "
+               "most INTERVAL"
+            << std::endl
+            << "                             milliseconds of trace time, "
+               "e.g. to FIFOs"
+            << std::endl
+            << "  -r, --record=RECORDING     write the decoded items also to "
+               "a recording file"
+            << std::endl
+            << "  -R, --replay               the input file is a recording "
+               "file"
+            << std::endl
+            << "  -B, --begin=NS             replay the items from this time "
+               "in nanoseconds"
+            << std::endl
+            << "  -E, --end=NS               replay the items up to this time "
+               "in nanoseconds"
+            << std::endl
+            << "  -S, --statistics=INTERVAL  print the throughput, overflows, "
+               "and backlogs"
+            << std::endl
+            << "                             every INTERVAL milliseconds "
+               "to stderr"
+            << std::endl
+            << "  -m, --summary=INTERVAL     print the event rates, thread "
+               "times, and interrupt"
+            << std::endl
+            << "                             latencies every INTERVAL "
+               "milliseconds of trace time"
+            << std::endl
+            << "                             to stdout instead of writing "
+               "the LTTng trace, 0 for"
+            << std::endl
+            << "                             a summary at the end only"
+            << std::endl
+            << "  -x, --text                 print the items in time order "
+               "to stdout instead of"
+            << std::endl
+            << "                             writing the LTTng trace"
+            << std::endl
+            << "  -M, --merge=NS             hold the items back at most NS "
+               "nanoseconds of trace"
+            << std::endl
+            << "                             time to merge the processors in "
+               "time order (default"
+            << std::endl
+            << "                             " << DEFAULT_MERGE_LATENCY
+            << " for the text output)" << std::endl
+            << "  -f, --events=EVENTS        pass only the comma-separated "
+               "event names or numbers"
+            << std::endl
+            << "                             to the output" << std::endl
+            << "  -O, --perfetto=FILE        write a Perfetto trace file "
+               "instead of the LTTng trace"
+            << std::endl
+            << "  -C, --connect=HOST:PORT[,DIRECTORY]" << std::endl
+            << "                             receive from this record server "
+               "and write its LTTng"
+            << std::endl
+            << "                             trace to the directory (default "
+               "HOST-PORT), may be"
+            << std::endl
+            << "                             given more than once, the ELF "
+               "file is shared"
+            << std::endl
+            << "  -F, --flight-recorder=SIZE keep the last SIZE bytes of items "
+               "of each processor"
+            << std::endl
+            << "                             in memory and pass them to the "
+               "output only when a"
+            << std::endl
+            << "                             trigger event or SIGUSR1 arrives"
+            << std::endl
+            << "  -T, --trigger=EVENTS       the comma-separated trigger event "
+               "names or numbers"
+            << std::endl
+            << "  -A, --after-trigger=INTERVAL" << std::endl
+            << "                             pass the items of INTERVAL "
+               "milliseconds of trace time"
+            << std::endl
+            << "                             after a trigger to the output "
+               "(default "
+            << DEFAULT_AFTER_TRIGGER << ")" << std::endl
+            << "  -k, --checkpoint=FILE      save the state of the conversion "
+               "of the input file"
+            << std::endl
+            << "                             to FILE from time to time"
+            << std::endl
+            << "  -K, --checkpoint-interval=BYTES" << std::endl
+            << "                             save a checkpoint after each "
+               "BYTES of input"
+            << std::endl
+            << "                             (default "
+            << DEFAULT_CHECKPOINT_INTERVAL << ")" << std::endl
+            << "  -u, --resume               resume the conversion from the "
+               "checkpoint file"
+            << std::endl
+            << "  -w, --benchmark=SETTINGS   measure the decoder, the filters, "
+               "and the LTTng output"
+            << std::endl
+            << "                             with a generated stream and "
+               "print the rates as"
+            << std::endl
+            << "                             comma-separated values, the "
+               "trace is written to"
+            << std::endl
+            << "                             " << DEFAULT_BENCHMARK_DIRECTORY
+            << ", SETTINGS are comma-separated" << std::endl
+            << "                             cpus=N, items=N, "
+               "format=le32|le64|be32|be64," << std::endl
+            << "                             "
+               "mix=mixed|switch|interrupt|user|code," << std::endl
+            << "                             overflow=CHUNKS, seed=N, and "
+               "runs=N" << std::endl
             << "  INPUT-FILE                 the input file" << std::endl;
 }
 
+struct Target {
+  std::string host;
+  uint16_t port;
+  std::string directory;
+};
+
+static bool ParseTarget(const char* arg, std::vector<Target>* targets) {
+  std::string value(arg);
+  Target target;
+
+  size_t comma = value.find(',');
+  if (comma != std::string::npos) {
+    target.directory = value.substr(comma + 1);
+    value.erase(comma);
+  }
+
+  size_t colon = value.rfind(':');
+  if (colon == std::string::npos || colon == 0) {
+    return false;
+  }
+
+  target.host = value.substr(0, colon);
+  std::string port = value.substr(colon + 1);
+  char* end;
+  unsigned long number = strtoul(port.c_str(), &end, 0);
+  if (port.empty() || *end != '\0' || number > UINT16_MAX) {
+    return false;
+  }
+
+  target.port = static_cast<uint16_t>(number);
+
+  if (target.directory.empty()) {
+    target.directory = target.host + "-" + port;
+  }
+
+  targets->push_back(target);
+  return true;
+}
+
+static bool ParseEvents(const char* list,
+                        std::vector<rtems_record_event>* events) {
+  std::string names(list);
+  size_t begin = 0;
+
+  while (begin <= names.size()) {
+    size_t end = names.find(',', begin);
+    if (end == std::string::npos) {
+      end = names.size();
+    }
+
+    std::string name = names.substr(begin, end - begin);
+    begin = end + 1;
+
+    if (name.empty()) {
+      continue;
+    }
+
+    char* number_end;
+    unsigned long number = strtoul(name.c_str(), &number_end, 0);
+    if (*number_end == '\0') {
+      if (number > RTEMS_RECORD_LAST) {
+        return false;
+      }
+
+      events->push_back(static_cast<rtems_record_event>(number));
+      continue;
+    }
+
+    int i;
+    for (i = 0; i <= RTEMS_RECORD_LAST; ++i) {
+      rtems_record_event event = static_cast<rtems_record_event>(i);
+      if (name == rtems_record_event_text(event)) {
+        events->push_back(event);
+        break;
+      }
+    }
+
+    if (i > RTEMS_RECORD_LAST) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 static void PrintDefaults() {
   std::cout << "[EventNames]" << std::endl;
 
@@ -826,11 +1864,45 @@ int main(int argc, char** argv) {
   const char* elf_file = nullptr;
   const char* input_file = nullptr;
   const char* config_file = nullptr;
+  size_t packet_size = DEFAULT_PACKET_SIZE;
+  uint64_t live_interval = 0;
+  const char* recording_file = nullptr;
+  bool is_replay = false;
+  uint64_t begin_ns = 0;
+  uint64_t end_ns = UINT64_MAX;
+  uint64_t statistics_interval = 0;
+  uint64_t limit = 0;
+  bool is_pipelined = false;
+  bool is_summary = false;
+  uint64_t summary_interval = 0;
+  bool is_text = false;
+  bool is_merged = false;
+  uint64_t merge_latency = DEFAULT_MERGE_LATENCY;
+  const char* event_list = nullptr;
+  const char* perfetto_file = nullptr;
+  std::vector<rtems_record_event> events;
+  size_t flight_recorder_size = 0;
+  const char* trigger_list = nullptr;
+  std::vector<rtems_record_event> triggers;
+  uint64_t after_trigger = DEFAULT_AFTER_TRIGGER;
+  bool is_index = false;
+  bool is_threads = false;
+  bool is_address_table = false;
+  const char* checkpoint_file = nullptr;
+  uint64_t checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+  bool is_resume = false;
+  const char* benchmark_settings = nullptr;
+  Benchmark::Config benchmark_config;
+  std::unique_ptr<Benchmark> benchmark;
+  std::string benchmark_input;
+  std::vector<Target> targets;
+  std::vector<std::unique_ptr<LTTNGClient>> target_clients;
   int opt;
   int longindex;
 
-  while ((opt = getopt_long(argc, argv, "hH:p:l:bze:c:d", &kLongOpts[0],
-                            &longindex)) != -1) {
+  while ((opt = getopt_long(argc, argv,
+                            "hH:p:l:bze:c:ds:iPtaL:r:RB:E:S:m:xM:f:O:C:F:T:A:k:K:uw:",
+                            &kLongOpts[0], &longindex)) != -1) {
     switch (opt) {
       case 'h':
         Usage(argv);
@@ -842,7 +1914,7 @@ int main(int argc, char** argv) {
         port = (uint16_t)strtoul(optarg, NULL, 0);
         break;
       case 'l':
-        client.set_limit(strtoull(optarg, NULL, 0));
+        limit = strtoull(optarg, NULL, 0);
         break;
       case 'b':
         is_base64_encoded = true;
@@ -859,6 +1931,83 @@ int main(int argc, char** argv) {
       case 'd':
         PrintDefaults();
         return 0;
+      case 's':
+        packet_size = strtoull(optarg, NULL, 0);
+        break;
+      case 'i':
+        is_index = true;
+        break;
+      case 'P':
+        is_pipelined = true;
+        break;
+      case 't':
+        is_threads = true;
+        break;
+      case 'a':
+        is_address_table = true;
+        break;
+      case 'L':
+        live_interval = strtoull(optarg, NULL, 0);
+        break;
+      case 'r':
+        recording_file = optarg;
+        break;
+      case 'R':
+        is_replay = true;
+        break;
+      case 'B':
+        begin_ns = strtoull(optarg, NULL, 0);
+        break;
+      case 'E':
+        end_ns = strtoull(optarg, NULL, 0);
+        break;
+      case 'S':
+        statistics_interval = strtoull(optarg, NULL, 0);
+        break;
+      case 'm':
+        is_summary = true;
+        summary_interval = strtoull(optarg, NULL, 0);
+        break;
+      case 'x':
+        is_text = true;
+        break;
+      case 'M':
+        is_merged = true;
+        merge_latency = strtoull(optarg, NULL, 0);
+        break;
+      case 'f':
+        event_list = optarg;
+        break;
+      case 'O':
+        perfetto_file = optarg;
+        break;
+      case 'C':
+        if (!ParseTarget(optarg, &targets)) {
+          std::cerr << argv[0] << ": invalid target: " << optarg << std::endl;
+          return 1;
+        }
+        break;
+      case 'F':
+        flight_recorder_size = strtoull(optarg, NULL, 0);
+        break;
+      case 'T':
+        trigger_list = optarg;
+        break;
+      case 'A':
+        after_trigger = strtoull(optarg, NULL, 0);
+        break;
+      case 'k':
+        checkpoint_file = optarg;
+        break;
+      case 'K':
+        checkpoint_interval = strtoull(optarg, NULL, 0);
+        break;
+      case 'u':
+        is_resume = true;
+        break;
+      case 'w':
+        benchmark_settings = optarg;
+        break;
       default:
         return 1;
     }
@@ -878,33 +2027,273 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  if (live_interval != 0 && packet_size == 0) {
+    std::cerr << argv[0] << ": live output needs a packet size" << std::endl;
+    return 1;
+  }
+
+  if (is_replay && input_file == nullptr) {
+    std::cerr << argv[0] << ": replay needs an input file" << std::endl;
+    return 1;
+  }
+
+  if (event_list != nullptr && !ParseEvents(event_list, &events)) {
+    std::cerr << argv[0] << ": invalid events: " << event_list << std::endl;
+    return 1;
+  }
+
+  if (trigger_list != nullptr && !ParseEvents(trigger_list, &triggers)) {
+    std::cerr << argv[0] << ": invalid trigger events: " << trigger_list
+              << std::endl;
+    return 1;
+  }
+
+  if (is_summary + is_text + (perfetto_file != nullptr) > 1) {
+    std::cerr << argv[0] << ": summary, text, and Perfetto output are exclusive"
+              << std::endl;
+    return 1;
+  }
+
+  if (is_resume && checkpoint_file == nullptr) {
+    std::cerr << argv[0] << ": resume needs a checkpoint file" << std::endl;
+    return 1;
+  }
+
+  // The checkpoints contain the state of the decoder and the LTTng output of
+  // an input file read in one thread
+  if (checkpoint_file != nullptr &&
+      (input_file == nullptr || is_replay || !targets.empty() ||
+       is_base64_encoded || is_zlib_compressed || is_pipelined ||
+       is_threads || is_merged || flight_recorder_size != 0 ||
+       recording_file != nullptr || is_summary || is_text ||
+       perfetto_file != nullptr || checkpoint_interval == 0)) {
+    std::cerr << argv[0]
+              << ": checkpoints need the LTTng output of a plain input file "
+                 "without pipelining, threads, merger, flight recorder, or "
+                 "recording"
+              << std::endl;
+    return 1;
+  }
+
+  if (benchmark_settings != nullptr &&
+      !Benchmark::ParseConfig(benchmark_settings, &benchmark_config)) {
+    std::cerr << argv[0] << ": invalid benchmark settings: "
+              << benchmark_settings << std::endl;
+    return 1;
+  }
+
+  if (benchmark_settings != nullptr &&
+      (input_file != nullptr || is_replay || !targets.empty() ||
+       is_base64_encoded || is_zlib_compressed || recording_file != nullptr ||
+       is_summary || is_text || perfetto_file != nullptr ||
+       checkpoint_file != nullptr)) {
+    std::cerr << argv[0]
+              << ": the benchmark needs the LTTng output without an input "
+                 "file, filters, recording, or checkpoints"
+              << std::endl;
+    return 1;
+  }
+
+  if (!targets.empty() &&
+      (input_file != nullptr || is_replay || recording_file != nullptr ||
+       is_summary || is_text || perfetto_file != nullptr)) {
+    std::cerr << argv[0]
+              << ": multiple targets need the LTTng output without an input "
+                 "file or recording"
+              << std::endl;
+    return 1;
+  }
+
+  if (!targets.empty()) {
+    try {
+      std::vector<Client*> clients;
+      for (const auto& target : targets) {
+        LTTNGClient* target_client = new LTTNGClient();
+        target_clients.emplace_back(target_client);
+        clients.push_back(target_client);
+
+        target_client->set_packet_size(packet_size);
+        target_client->set_live_interval(live_interval * 1000000);
+        target_client->set_index(is_index);
+        target_client->set_threads(is_threads);
+        target_client->set_address_table(is_address_table);
+        target_client->set_directory(target.directory);
+        target_client->set_limit(limit);
+
+        if (event_list != nullptr) {
+          target_client->SelectEvents(events);
+        }
+
+        if (is_merged) {
+          target_client->Merge(merge_latency);
+        }
+
+        if (flight_recorder_size != 0) {
+          target_client->FlightRecord(flight_recorder_size,
+                                      after_trigger * 1000000, triggers);
+        }
+
+        if (is_base64_encoded) {
+          target_client->AddFilter(new Base64Filter());
+        }
+
+        if (is_zlib_compressed) {
+#ifdef HAVE_ZLIB_H
+          target_client->AddFilter(new ZlibFilter());
+#endif
+        }
+
+        target_client->ParseConfigFile(config_file);
+        target_client->GenerateMetadata();
+
+        // The executable is loaded once and shared by all clients
+        if (elf_file != nullptr) {
+          if (target_client == target_clients.front().get()) {
+            target_client->OpenExecutable(elf_file);
+          } else {
+            target_client->set_resolver(target_clients.front()->resolver());
+          }
+        }
+
+        target_client->set_statistics_interval(statistics_interval);
+        target_client->Connect(target.host.c_str(), target.port);
+      }
+
+      running_clients = clients;
+      std::signal(SIGINT, SignalHandler);
+#ifdef SIGUSR1
+      std::signal(SIGUSR1, TriggerHandler);
+#endif
+      Client::RunAll(clients);
+
+      for (auto target_client : clients) {
+        target_client->Destroy();
+      }
+    } catch (std::exception& e) {
+      std::cerr << argv[0] << ": " << e.what() << std::endl;
+      return 1;
+    }
+
+    return 0;
+  }
+
+  if (is_summary) {
+    summary_client.set_interval(summary_interval * 1000000);
+    active_client = &summary_client;
+  } else if (is_text) {
+    is_merged = true;
+    active_client = &text_client;
+  } else if (perfetto_file != nullptr) {
+    active_client = &perfetto_client;
+  } else {
+    client.set_packet_size(packet_size);
+    client.set_live_interval(live_interval * 1000000);
+    client.set_index(is_index);
+    client.set_threads(is_threads);
+    client.set_address_table(is_address_table);
+
+    if (benchmark_settings != nullptr) {
+      client.set_directory(DEFAULT_BENCHMARK_DIRECTORY);
+    }
+  }
+
+  active_client->set_limit(limit);
+  active_client->set_pipelined(is_pipelined);
+
+  if (event_list != nullptr) {
+    active_client->SelectEvents(events);
+  }
+
+  if (is_merged) {
+    active_client->Merge(merge_latency);
+  }
+
+  if (flight_recorder_size != 0) {
+    active_client->FlightRecord(flight_recorder_size, after_trigger * 1000000,
+                                triggers);
+  }
+
   try {
+    if (benchmark_settings != nullptr) {
+      benchmark.reset(new Benchmark(benchmark_config));
+      benchmark->PrintHeader();
+      benchmark->RunDecoder();
+      benchmark->RunFilters();
+    }
+
     if (is_base64_encoded) {
-      client.AddFilter(new Base64Filter());
+      active_client->AddFilter(new Base64Filter());
     }
 
     if (is_zlib_compressed) {
 #ifdef HAVE_ZLIB_H
-      client.AddFilter(new ZlibFilter());
+      active_client->AddFilter(new ZlibFilter());
 #endif
     }
 
-    client.ParseConfigFile(config_file);
-    client.GenerateMetadata();
+    if (active_client == &perfetto_client) {
+      perfetto_client.OpenOutput(perfetto_file);
+    }
+
+    if (active_client == &client) {
+      client.ParseConfigFile(config_file);
+      client.GenerateMetadata();
 
-    if (elf_file != nullptr) {
-      client.OpenExecutable(elf_file);
+      if (elf_file != nullptr) {
+        client.OpenExecutable(elf_file);
+      }
+
+      // The stream is read from a file as a capture would be
+      if (benchmark) {
+        benchmark_input = std::string(DEFAULT_BENCHMARK_DIRECTORY) + "/input";
+        benchmark->WriteStream(benchmark_input.c_str());
+        input_file = benchmark_input.c_str();
+      }
     }
 
-    if (input_file != nullptr) {
-      client.Open(input_file);
-    } else {
-      client.Connect(host, port);
+    if (recording_file != nullptr) {
+      active_client->Record(recording_file);
     }
 
+    active_client->set_statistics_interval(statistics_interval);
+
+    running_clients.push_back(active_client);
     std::signal(SIGINT, SignalHandler);
-    client.Run();
-    client.Destroy();
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, TriggerHandler);
+#endif
+
+    auto begin = std::chrono::steady_clock::now();
+
+    if (is_replay) {
+      active_client->Replay(input_file, begin_ns, end_ns);
+    } else {
+      if (input_file != nullptr) {
+        active_client->Open(input_file);
+
+        if (is_resume) {
+          active_client->Resume(checkpoint_file);
+        }
+
+        if (checkpoint_file != nullptr) {
+          active_client->set_checkpoint(checkpoint_file, checkpoint_interval);
+        }
+      } else {
+        active_client->Connect(host, port);
+      }
+
+      active_client->Run();
+    }
+
+    active_client->Destroy();
+
+    if (benchmark) {
+      benchmark->Report(
+          "lttng", benchmark->stream().size(),
+          std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                        begin)
+              .count());
+    }
   } catch (std::exception& e) {
     std::cerr << argv[0] << ": " << e.what() << std::endl;
     return 1;
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <algorithm>
+
+void ItemMerger::PushHead(uint32_t cpu) {
+  Head head;
+  head.ns = queues_[cpu].front().ns;
+  head.cpu = cpu;
+  heap_.push_back(head);
+  std::push_heap(heap_.begin(), heap_.end(), Later);
+}
+
+rtems_record_client_status ItemMerger::Pop() {
+  std::pop_heap(heap_.begin(), heap_.end(), Later);
+  uint32_t cpu = heap_.back().cpu;
+  heap_.pop_back();
+
+  std::deque<Queued>& queue = queues_[cpu];
+  RecordingItem item = queue.front().item;
+  queue.pop_front();
+  --size_;
+
+  if (!queue.empty()) {
+    PushHead(cpu);
+  }
+
+  return (*handler_)(item.bt, item.cpu, item.event, item.data, arg_);
+}
+
+rtems_record_client_status ItemMerger::Push(uint64_t bt,
+                                            uint32_t cpu,
+                                            rtems_record_event event,
+                                            uint64_t data) {
+  if (cpu >= RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT) {
+    return (*handler_)(bt, cpu, event, data, arg_);
+  }
+
+  if (!seen_[cpu]) {
+    seen_[cpu] = true;
+    ++active_;
+  }
+
+  uint64_t ns = last_ns_[cpu];
+  if (bt != 0) {
+    ns = rtems_record_client_bintime_to_nanoseconds(bt);
+    last_ns_[cpu] = ns;
+
+    if (ns > newest_ns_) {
+      newest_ns_ = ns;
+    }
+  }
+
+  std::deque<Queued>& queue = queues_[cpu];
+  Queued queued;
+  queued.ns = ns;
+  queued.item.bt = bt;
+  queued.item.cpu = cpu;
+  queued.item.event = event;
+  queued.item.data = data;
+  queue.push_back(queued);
+  ++size_;
+
+  if (queue.size() == 1) {
+    PushHead(cpu);
+  }
+
+  // The oldest queued item is the oldest item yet to come if each processor
+  // has a queued item, otherwise wait for the latency
+  while (!heap_.empty()) {
+    const Head& head = heap_.front();
+    if (heap_.size() < active_ && newest_ns_ - head.ns < latency_) {
+      break;
+    }
+
+    rtems_record_client_status status = Pop();
+    if (status != RTEMS_RECORD_CLIENT_SUCCESS) {
+      return status;
+    }
+  }
+
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
+
+rtems_record_client_status ItemMerger::Drain() {
+  while (!heap_.empty()) {
+    rtems_record_client_status status = Pop();
+    if (status != RTEMS_RECORD_CLIENT_SUCCESS) {
+      return status;
+    }
+  }
+
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
@@ -0,0 +1,476 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <cctype>
+
+namespace {
+
+// The wire types and field numbers of the Perfetto trace protos
+const uint32_t kWireVarint = 0;
+const uint32_t kWireBytes = 2;
+
+const uint32_t kTracePacket = 1;
+
+const uint32_t kPacketFtraceEvents = 1;
+const uint32_t kPacketClockSnapshot = 6;
+const uint32_t kPacketTimestamp = 8;
+const uint32_t kPacketSequenceID = 10;
+const uint32_t kPacketTrackEvent = 11;
+const uint32_t kPacketInternedData = 12;
+const uint32_t kPacketSequenceFlags = 13;
+const uint32_t kPacketDefaults = 59;
+const uint32_t kPacketTrackDescriptor = 60;
+
+const uint64_t kSeqIncrementalStateCleared = 1;
+const uint64_t kSeqNeedsIncrementalState = 2;
+
+const uint32_t kClockSnapshotClocks = 1;
+const uint32_t kClockID = 1;
+const uint32_t kClockTimestamp = 2;
+const uint32_t kClockIsIncremental = 3;
+
+const uint64_t kBuiltinClockBoottime = 6;
+const uint64_t kIncrementalClock = 64;
+
+const uint32_t kDefaultsTrackEventDefaults = 11;
+const uint32_t kDefaultsTimestampClockID = 58;
+const uint32_t kTrackEventDefaultsTrackUUID = 11;
+
+const uint32_t kTrackDescriptorUUID = 1;
+const uint32_t kTrackDescriptorName = 2;
+
+const uint32_t kTrackEventDebugAnnotations = 4;
+const uint32_t kTrackEventType = 9;
+const uint32_t kTrackEventNameIID = 10;
+
+const uint64_t kTypeSliceBegin = 1;
+const uint64_t kTypeSliceEnd = 2;
+const uint64_t kTypeInstant = 3;
+
+const uint32_t kDebugAnnotationNameIID = 1;
+const uint32_t kDebugAnnotationUIntValue = 3;
+
+const uint32_t kInternedEventNames = 2;
+const uint32_t kInternedDebugAnnotationNames = 3;
+const uint32_t kInternedIID = 1;
+const uint32_t kInternedName = 2;
+
+const uint32_t kBundleCPU = 1;
+const uint32_t kBundleCompactSched = 4;
+
+const uint32_t kCompactSwitchTimestamp = 1;
+const uint32_t kCompactSwitchPrevState = 2;
+const uint32_t kCompactSwitchNextPID = 3;
+const uint32_t kCompactSwitchNextPrio = 4;
+const uint32_t kCompactInternTable = 5;
+const uint32_t kCompactSwitchNextCommIndex = 6;
+
+// The event name of a record event is interned with the event plus one
+const uint64_t kIRQNameIID = RTEMS_RECORD_LAST + 2;
+const size_t kNameIIDCount = kIRQNameIID + 1;
+
+const uint64_t kDataAnnotationIID = 1;
+const uint64_t kVectorAnnotationIID = 2;
+
+const uint64_t kTrackUUIDBase = UINT64_C(0x7274656d73000000);
+
+const int64_t kTaskRunning = 0x0000;
+const int64_t kTaskIdle = 0x0402;
+
+uint32_t GetAPIIndexOfID(uint32_t id) {
+  return ((id >> 24) & 0x7) - 1;
+}
+
+bool IsIdleTaskByAPIIndex(uint32_t api_index) {
+  return api_index == 0;
+}
+
+uint32_t SchedSequenceID(uint32_t cpu) {
+  return cpu + 1;
+}
+
+uint32_t ItemSequenceID(uint32_t cpu) {
+  return RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT + cpu + 1;
+}
+
+void PutVarint(std::vector<uint8_t>* buf, uint64_t value) {
+  while (value >= 0x80) {
+    buf->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+
+  buf->push_back(static_cast<uint8_t>(value));
+}
+
+void PutUInt(std::vector<uint8_t>* buf, uint32_t field, uint64_t value) {
+  PutVarint(buf, (field << 3) | kWireVarint);
+  PutVarint(buf, value);
+}
+
+void PutBytes(std::vector<uint8_t>* buf,
+              uint32_t field,
+              const void* data,
+              size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  PutVarint(buf, (field << 3) | kWireBytes);
+  PutVarint(buf, size);
+  buf->insert(buf->end(), bytes, bytes + size);
+}
+
+void PutString(std::vector<uint8_t>* buf,
+               uint32_t field,
+               const std::string& value) {
+  PutBytes(buf, field, value.data(), value.size());
+}
+
+void PutMessage(std::vector<uint8_t>* buf,
+                uint32_t field,
+                const std::vector<uint8_t>& message) {
+  PutBytes(buf, field, message.data(), message.size());
+}
+
+void PutPacked(std::vector<uint8_t>* buf,
+               uint32_t field,
+               const std::vector<uint64_t>& values,
+               std::vector<uint8_t>* scratch) {
+  scratch->clear();
+  for (auto value : values) {
+    PutVarint(scratch, value);
+  }
+
+  PutMessage(buf, field, *scratch);
+}
+
+void PutInternedName(std::vector<uint8_t>* buf,
+                     uint32_t field,
+                     uint64_t iid,
+                     const char* name) {
+  std::vector<uint8_t> entry;
+  PutUInt(&entry, kInternedIID, iid);
+  PutString(&entry, kInternedName, name);
+  PutMessage(buf, field, entry);
+}
+
+}  // namespace
+
+PerfettoClient::PerfettoClient() {
+  Initialize(PerfettoClient::HandlerCaller);
+
+  for (auto& pcpu : per_cpu_) {
+    pcpu.interned.resize(kNameIIDCount);
+  }
+}
+
+void PerfettoClient::OpenOutput(const char* file) {
+  file_name_ = file;
+  file_ = std::fopen(file, "wb");
+  if (file_ == nullptr) {
+    throw ErrnoException(std::string("cannot create file '") + file + "'");
+  }
+}
+
+void PerfettoClient::WritePacket() {
+  message_.clear();
+  PutVarint(&message_, (kTracePacket << 3) | kWireBytes);
+  PutVarint(&message_, packet_.size());
+
+  if (std::fwrite(message_.data(), message_.size(), 1, file_) != 1 ||
+      std::fwrite(packet_.data(), packet_.size(), 1, file_) != 1) {
+    throw ErrnoException("cannot write file '" + file_name_ + "'");
+  }
+
+  packet_.clear();
+}
+
+void PerfettoClient::StartSequence(uint32_t cpu, uint64_t ns) {
+  PerCPUContext* pcpu = &per_cpu_[cpu];
+  uint64_t uuid = kTrackUUIDBase + cpu;
+
+  // The incremental clock starts at the time of the first item
+  packet_.clear();
+  PutUInt(&packet_, kPacketSequenceID, ItemSequenceID(cpu));
+  PutUInt(&packet_, kPacketSequenceFlags, kSeqIncrementalStateCleared);
+
+  message_.clear();
+  nested_.clear();
+  PutUInt(&nested_, kClockID, kIncrementalClock);
+  PutUInt(&nested_, kClockTimestamp, ns);
+  PutUInt(&nested_, kClockIsIncremental, 1);
+  PutMessage(&message_, kClockSnapshotClocks, nested_);
+  nested_.clear();
+  PutUInt(&nested_, kClockID, kBuiltinClockBoottime);
+  PutUInt(&nested_, kClockTimestamp, ns);
+  PutMessage(&message_, kClockSnapshotClocks, nested_);
+  PutMessage(&packet_, kPacketClockSnapshot, message_);
+
+  message_.clear();
+  nested_.clear();
+  PutUInt(&nested_, kTrackEventDefaultsTrackUUID, uuid);
+  PutMessage(&message_, kDefaultsTrackEventDefaults, nested_);
+  PutUInt(&message_, kDefaultsTimestampClockID, kIncrementalClock);
+  PutMessage(&packet_, kPacketDefaults, message_);
+
+  message_.clear();
+  PutInternedName(&message_, kInternedDebugAnnotationNames, kDataAnnotationIID,
+                  "data");
+  PutInternedName(&message_, kInternedDebugAnnotationNames,
+                  kVectorAnnotationIID, "vector");
+  PutMessage(&packet_, kPacketInternedData, message_);
+  WritePacket();
+
+  PutUInt(&packet_, kPacketSequenceID, ItemSequenceID(cpu));
+  PutUInt(&packet_, kPacketSequenceFlags, kSeqNeedsIncrementalState);
+  message_.clear();
+  PutUInt(&message_, kTrackDescriptorUUID, uuid);
+  PutString(&message_, kTrackDescriptorName, "CPU " + std::to_string(cpu));
+  PutMessage(&packet_, kPacketTrackDescriptor, message_);
+  WritePacket();
+
+  pcpu->started = true;
+  pcpu->last_ns = ns;
+}
+
+void PerfettoClient::WriteTrackEvent(uint32_t cpu,
+                                     uint64_t ns,
+                                     uint64_t type,
+                                     uint64_t name_iid,
+                                     uint64_t annotation_iid,
+                                     uint64_t value) {
+  PerCPUContext* pcpu = &per_cpu_[cpu];
+
+  if (!pcpu->started) {
+    StartSequence(cpu, ns);
+  }
+
+  // The incremental clock cannot go backwards
+  uint64_t delta = 0;
+  if (ns > pcpu->last_ns) {
+    delta = ns - pcpu->last_ns;
+    pcpu->last_ns = ns;
+  }
+
+  PutUInt(&packet_, kPacketTimestamp, delta);
+  PutUInt(&packet_, kPacketSequenceID, ItemSequenceID(cpu));
+  PutUInt(&packet_, kPacketSequenceFlags, kSeqNeedsIncrementalState);
+
+  if (name_iid != 0 && pcpu->interned[name_iid] == 0) {
+    const char* name = "irq";
+    if (name_iid != kIRQNameIID) {
+      name = rtems_record_event_text(
+          static_cast<rtems_record_event>(name_iid - 1));
+    }
+
+    message_.clear();
+    PutInternedName(&message_, kInternedEventNames, name_iid, name);
+    PutMessage(&packet_, kPacketInternedData, message_);
+    pcpu->interned[name_iid] = 1;
+  }
+
+  message_.clear();
+  PutUInt(&message_, kTrackEventType, type);
+
+  if (name_iid != 0) {
+    PutUInt(&message_, kTrackEventNameIID, name_iid);
+  }
+
+  if (annotation_iid != 0) {
+    nested_.clear();
+    PutUInt(&nested_, kDebugAnnotationNameIID, annotation_iid);
+    PutUInt(&nested_, kDebugAnnotationUIntValue, value);
+    PutMessage(&message_, kTrackEventDebugAnnotations, nested_);
+  }
+
+  PutMessage(&packet_, kPacketTrackEvent, message_);
+  WritePacket();
+}
+
+std::string PerfettoClient::ThreadName(uint32_t cpu, uint32_t id) const {
+  uint32_t api_index = GetAPIIndexOfID(id);
+  char name[ThreadNames::kNameSize + 1] = {};
+  std::memcpy(name, thread_names_.Get(id), ThreadNames::kNameSize);
+
+  for (size_t i = 0; name[i] != '\0'; ++i) {
+    if (!std::isprint(static_cast<unsigned char>(name[i]))) {
+      name[i] = '?';
+    }
+  }
+
+  std::string comm(name);
+
+  if (IsIdleTaskByAPIIndex(api_index)) {
+    // Mimic the Linux idle threads bound to a processor like the LTTng client
+    comm = comm.substr(0, 4) + "/" + std::to_string(cpu);
+  }
+
+  return comm;
+}
+
+void PerfettoClient::AddSwitch(uint32_t cpu, uint64_t ns, uint32_t id) {
+  PerCPUContext* pcpu = &per_cpu_[cpu];
+  uint32_t api_index = GetAPIIndexOfID(id);
+  std::string comm = ThreadName(cpu, id);
+
+  auto it = pcpu->comms.find(comm);
+  uint32_t comm_index;
+  if (it != pcpu->comms.end()) {
+    comm_index = it->second;
+  } else {
+    comm_index = static_cast<uint32_t>(pcpu->comm_table.size());
+    pcpu->comms.emplace(comm, comm_index);
+    pcpu->comm_table.push_back(comm);
+  }
+
+  // The first time of a bundle is absolute, the others are deltas
+  uint64_t delta = ns >= pcpu->switch_last_ns ? ns - pcpu->switch_last_ns : 0;
+  pcpu->switch_last_ns += delta;
+
+  pcpu->switch_timestamp.push_back(delta);
+  pcpu->switch_prev_state.push_back(
+      static_cast<uint64_t>(pcpu->switch_out_state));
+  pcpu->switch_next_pid.push_back(IsIdleTaskByAPIIndex(api_index) ? 0 : id);
+  pcpu->switch_next_prio.push_back(0);
+  pcpu->switch_next_comm_index.push_back(comm_index);
+
+  if (pcpu->switch_timestamp.size() >= kBundleSwitches) {
+    WriteBundle(cpu);
+  }
+}
+
+void PerfettoClient::WriteBundle(uint32_t cpu) {
+  PerCPUContext* pcpu = &per_cpu_[cpu];
+
+  if (pcpu->switch_timestamp.empty()) {
+    return;
+  }
+
+  std::vector<uint8_t> compact;
+  for (const auto& comm : pcpu->comm_table) {
+    PutString(&compact, kCompactInternTable, comm);
+  }
+
+  PutPacked(&compact, kCompactSwitchTimestamp, pcpu->switch_timestamp,
+            &nested_);
+  PutPacked(&compact, kCompactSwitchPrevState, pcpu->switch_prev_state,
+            &nested_);
+  PutPacked(&compact, kCompactSwitchNextPID, pcpu->switch_next_pid, &nested_);
+  PutPacked(&compact, kCompactSwitchNextPrio, pcpu->switch_next_prio,
+            &nested_);
+  PutPacked(&compact, kCompactSwitchNextCommIndex,
+            pcpu->switch_next_comm_index, &nested_);
+
+  std::vector<uint8_t> bundle;
+  PutUInt(&bundle, kBundleCPU, cpu);
+  PutMessage(&bundle, kBundleCompactSched, compact);
+
+  PutUInt(&packet_, kPacketSequenceID, SchedSequenceID(cpu));
+  PutMessage(&packet_, kPacketFtraceEvents, bundle);
+  WritePacket();
+
+  pcpu->switch_timestamp.clear();
+  pcpu->switch_prev_state.clear();
+  pcpu->switch_next_pid.clear();
+  pcpu->switch_next_prio.clear();
+  pcpu->switch_next_comm_index.clear();
+  pcpu->switch_last_ns = 0;
+  pcpu->comms.clear();
+  pcpu->comm_table.clear();
+}
+
+rtems_record_client_status PerfettoClient::Handler(uint64_t bt,
+                                                   uint32_t cpu,
+                                                   rtems_record_event event,
+                                                   uint64_t data) {
+  uint64_t ns = rtems_record_client_bintime_to_nanoseconds(bt);
+  PerCPUContext* pcpu = &per_cpu_[cpu];
+
+  switch (event) {
+    case RTEMS_RECORD_THREAD_SWITCH_OUT:
+      pcpu->switch_out_ns = ns;
+      pcpu->switch_out_state =
+          IsIdleTaskByAPIIndex(GetAPIIndexOfID(static_cast<uint32_t>(data)))
+              ? kTaskIdle
+              : kTaskRunning;
+      break;
+    case RTEMS_RECORD_THREAD_SWITCH_IN:
+      if (ns == pcpu->switch_out_ns) {
+        AddSwitch(cpu, ns, static_cast<uint32_t>(data));
+      }
+      break;
+    case RTEMS_RECORD_THREAD_CREATE:
+    case RTEMS_RECORD_THREAD_ID:
+      thread_names_.Reset(cpu, static_cast<uint32_t>(data));
+      break;
+    case RTEMS_RECORD_THREAD_NAME:
+      thread_names_.Add(cpu, data, data_size());
+      break;
+    case RTEMS_RECORD_INTERRUPT_ENTRY:
+      if (ns != 0) {
+        WriteTrackEvent(cpu, ns, kTypeSliceBegin, kIRQNameIID,
+                        kVectorAnnotationIID, data);
+      }
+      break;
+    case RTEMS_RECORD_INTERRUPT_EXIT:
+      if (ns != 0) {
+        WriteTrackEvent(cpu, ns, kTypeSliceEnd, 0, 0, 0);
+      }
+      break;
+    case RTEMS_RECORD_PROCESSOR_MAXIMUM:
+      break;
+    default:
+      if (ns != 0) {
+        WriteTrackEvent(cpu, ns, kTypeInstant, event + 1, kDataAnnotationIID,
+                        data);
+      }
+      break;
+  }
+
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
+
+void PerfettoClient::Destroy() {
+  Client::Destroy();
+
+  if (file_ == nullptr) {
+    return;
+  }
+
+  for (uint32_t cpu = 0; cpu < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT; ++cpu) {
+    WriteBundle(cpu);
+  }
+
+  int status = std::fclose(file_);
+  file_ = nullptr;
+  if (status != 0) {
+    throw ErrnoException("cannot write file '" + file_name_ + "'");
+  }
+}
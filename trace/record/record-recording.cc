@@ -0,0 +1,469 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2024 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <algorithm>
+#include <cassert>
+
+static const char kFileMagic[8] = {'R', 'T', 'E', 'M', 'S', 'R', 'E', 'C'};
+
+static const uint32_t kFileVersion = 1;
+
+static const size_t kFileHeaderSize = 16;
+
+static const uint32_t kChunkMagic = 0x4b484352;  // "RCHK"
+
+static const size_t kChunkHeaderSize = 48;
+
+static const uint32_t kIndexMagic = 0x58444952;  // "RIDX"
+
+static const size_t kIndexEntrySize = 40;
+
+static const size_t kTrailerSize = 16;
+
+// Closes the chunk once its encoded items exceed this size
+static const size_t kChunkSize = 256 * 1024;
+
+// The maximum size of an encoded item
+static const size_t kMaximumItemSize = 30;
+
+static void Put32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<uint8_t>(v >> (8 * i));
+  }
+}
+
+static void Put64(uint8_t* p, uint64_t v) {
+  Put32(p, static_cast<uint32_t>(v));
+  Put32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+static uint32_t Get32(const uint8_t* p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; ++i) {
+    v |= static_cast<uint32_t>(p[i]) << (8 * i);
+  }
+  return v;
+}
+
+static uint64_t Get64(const uint8_t* p) {
+  return Get32(p) | (static_cast<uint64_t>(Get32(p + 4)) << 32);
+}
+
+static uint8_t* PutVarint(uint8_t* p, uint64_t v) {
+  while (v >= 0x80) {
+    *p = static_cast<uint8_t>(v | 0x80);
+    ++p;
+    v >>= 7;
+  }
+
+  *p = static_cast<uint8_t>(v);
+  return p + 1;
+}
+
+static bool GetVarint(const uint8_t** p, const uint8_t* end, uint64_t* v) {
+  uint64_t r = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (*p == end) {
+      return false;
+    }
+
+    uint8_t b = **p;
+    ++*p;
+    r |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      *v = r;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static int Seek(FILE* file, uint64_t offset, int whence) {
+#ifdef _WIN32
+  return ::_fseeki64(file, static_cast<__int64>(offset), whence);
+#else
+  return ::fseeko(file, static_cast<off_t>(offset), whence);
+#endif
+}
+
+static uint64_t Tell(FILE* file) {
+#ifdef _WIN32
+  return static_cast<uint64_t>(::_ftelli64(file));
+#else
+  return static_cast<uint64_t>(::ftello(file));
+#endif
+}
+
+RecordingWriter::~RecordingWriter() {
+  if (file_ != nullptr) {
+    ::fclose(file_);
+  }
+}
+
+void RecordingWriter::Open(const char* file) {
+  assert(file_ == nullptr);
+
+  file_ = ::fopen(file, "wb");
+  if (file_ == nullptr) {
+    throw ErrnoException(std::string("cannot open recording file '") + file +
+                         "'");
+  }
+
+  uint8_t header[kFileHeaderSize];
+  std::memcpy(header, kFileMagic, sizeof(kFileMagic));
+  Put32(&header[8], kFileVersion);
+  Put32(&header[12], 0);
+  WriteBytes(header, sizeof(header));
+  chunk_.reserve(kChunkSize + kMaximumItemSize);
+}
+
+void RecordingWriter::Write(uint64_t bt,
+                            uint32_t cpu,
+                            rtems_record_event event,
+                            uint64_t data,
+                            size_t data_size) {
+  // The items before the first item with a time go into a chunk of their own,
+  // so that a replay of a time window can start with them
+  if (prologue_ && bt != 0) {
+    WriteChunk();
+    prologue_ = false;
+  }
+
+  if (count_ == 0) {
+    bt_begin_ = bt;
+    bt_end_ = bt;
+    cpu_mask_ = 0;
+    data_size_ = static_cast<uint32_t>(data_size);
+    std::fill(&last_bt_[0], &last_bt_[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT],
+              0);
+  } else {
+    bt_begin_ = std::min(bt_begin_, bt);
+    bt_end_ = std::max(bt_end_, bt);
+  }
+
+  // The time of a processor usually increases, encode the signed difference
+  uint64_t delta = bt - last_bt_[cpu];
+  uint64_t zigzag = (delta << 1) ^ (0 - (delta >> 63));
+  last_bt_[cpu] = bt;
+  cpu_mask_ |= UINT32_C(1) << cpu;
+  ++count_;
+
+  size_t size = chunk_.size();
+  chunk_.resize(size + kMaximumItemSize);
+  uint8_t* p = &chunk_[size];
+  p = PutVarint(p, (static_cast<uint64_t>(event) << 5) | cpu);
+  p = PutVarint(p, zigzag);
+  p = PutVarint(p, data);
+  chunk_.resize(static_cast<size_t>(p - chunk_.data()));
+
+  if (chunk_.size() >= kChunkSize) {
+    WriteChunk();
+  }
+}
+
+void RecordingWriter::Close() {
+  if (file_ == nullptr) {
+    return;
+  }
+
+  WriteChunk();
+
+  uint64_t index_offset = offset_;
+  for (const auto& chunk : index_) {
+    uint8_t entry[kIndexEntrySize];
+    Put64(&entry[0], chunk.offset);
+    Put64(&entry[8], chunk.bt_begin);
+    Put64(&entry[16], chunk.bt_end);
+    Put32(&entry[24], chunk.cpu_mask);
+    Put32(&entry[28], chunk.flags);
+    Put32(&entry[32], chunk.data_size);
+    Put32(&entry[36], 0);
+    WriteBytes(entry, sizeof(entry));
+  }
+
+  uint8_t trailer[kTrailerSize];
+  Put64(&trailer[0], index_offset);
+  Put32(&trailer[8], static_cast<uint32_t>(index_.size()));
+  Put32(&trailer[12], kIndexMagic);
+  WriteBytes(trailer, sizeof(trailer));
+
+  int rv = ::fclose(file_);
+  file_ = nullptr;
+  if (rv != 0) {
+    throw ErrnoException("cannot close recording file");
+  }
+}
+
+void RecordingWriter::WriteChunk() {
+  if (count_ == 0) {
+    return;
+  }
+
+  RecordingChunk chunk;
+  chunk.offset = offset_;
+  chunk.bt_begin = bt_begin_;
+  chunk.bt_end = bt_end_;
+  chunk.cpu_mask = cpu_mask_;
+  chunk.flags = prologue_ ? RecordingChunk::kPrologue : 0;
+  chunk.data_size = data_size_;
+
+  const uint8_t* stored = chunk_.data();
+  size_t stored_size = chunk_.size();
+#ifdef HAVE_ZLIB_H
+  uLongf compressed_size = compressBound(static_cast<uLong>(chunk_.size()));
+  compressed_.resize(compressed_size);
+  if (compress2(compressed_.data(), &compressed_size, chunk_.data(),
+                static_cast<uLong>(chunk_.size()), Z_BEST_SPEED) == Z_OK &&
+      compressed_size < chunk_.size()) {
+    chunk.flags |= RecordingChunk::kCompressed;
+    stored = compressed_.data();
+    stored_size = compressed_size;
+  }
+#endif
+
+  uint8_t header[kChunkHeaderSize];
+  Put32(&header[0], kChunkMagic);
+  Put32(&header[4], chunk.flags);
+  Put32(&header[8], static_cast<uint32_t>(chunk_.size()));
+  Put32(&header[12], static_cast<uint32_t>(stored_size));
+  Put32(&header[16], count_);
+  Put32(&header[20], chunk.data_size);
+  Put32(&header[24], chunk.cpu_mask);
+  Put32(&header[28], 0);
+  Put64(&header[32], chunk.bt_begin);
+  Put64(&header[40], chunk.bt_end);
+  WriteBytes(header, sizeof(header));
+  WriteBytes(stored, stored_size);
+
+  index_.push_back(chunk);
+  chunk_.clear();
+  count_ = 0;
+}
+
+void RecordingWriter::WriteBytes(const void* buf, size_t n) {
+  if (::fwrite(buf, 1, n, file_) != n) {
+    throw ErrnoException("cannot write recording file");
+  }
+
+  offset_ += n;
+}
+
+RecordingReader::~RecordingReader() {
+  if (file_ != nullptr) {
+    ::fclose(file_);
+  }
+}
+
+void RecordingReader::Open(const char* file) {
+  assert(file_ == nullptr);
+
+  name_ = file;
+  file_ = ::fopen(file, "rb");
+  if (file_ == nullptr) {
+    throw ErrnoException(std::string("cannot open recording file '") + file +
+                         "'");
+  }
+
+  uint8_t header[kFileHeaderSize];
+  if (::fread(header, 1, sizeof(header), file_) != sizeof(header) ||
+      std::memcmp(header, kFileMagic, sizeof(kFileMagic)) != 0) {
+    Invalid();
+  }
+
+  if (Get32(&header[8]) != kFileVersion) {
+    throw std::runtime_error("unsupported version of recording file '" +
+                             name_ + "'");
+  }
+
+  if (!ReadIndex()) {
+    ScanChunks();
+  }
+}
+
+void RecordingReader::Read(const RecordingChunk& chunk, Stored* stored) {
+  RecordingChunk header;
+  uint32_t stored_size;
+  if (!ReadChunkHeader(chunk.offset, &header, &stored->raw_size, &stored_size,
+                       &stored->count)) {
+    Invalid();
+  }
+
+  stored->flags = header.flags;
+  stored->data.resize(stored_size);
+  if (::fread(stored->data.data(), 1, stored_size, file_) != stored_size) {
+    Invalid();
+  }
+}
+
+void RecordingReader::Decode(const Stored& stored,
+                             std::vector<uint8_t>* raw,
+                             std::vector<RecordingItem>* items) const {
+  const uint8_t* p = stored.data.data();
+  const uint8_t* end = p + stored.data.size();
+  if ((stored.flags & RecordingChunk::kCompressed) != 0) {
+#ifdef HAVE_ZLIB_H
+    raw->resize(stored.raw_size);
+    uLongf size = stored.raw_size;
+    if (uncompress(raw->data(), &size, stored.data.data(),
+                   stored.data.size()) != Z_OK ||
+        size != stored.raw_size) {
+      Invalid();
+    }
+
+    p = raw->data();
+    end = p + stored.raw_size;
+#else
+    throw std::runtime_error("recording file '" + name_ +
+                             "' needs zlib support");
+#endif
+  }
+
+  uint64_t last_bt[RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT] = {};
+  items->clear();
+  items->reserve(stored.count);
+  for (uint32_t i = 0; i < stored.count; ++i) {
+    uint64_t event_cpu;
+    uint64_t zigzag;
+    uint64_t data;
+    if (!GetVarint(&p, end, &event_cpu) || !GetVarint(&p, end, &zigzag) ||
+        !GetVarint(&p, end, &data) || (event_cpu >> 5) > RTEMS_RECORD_LAST) {
+      Invalid();
+    }
+
+    RecordingItem item;
+    item.cpu = static_cast<uint32_t>(event_cpu & 0x1f);
+    item.event = static_cast<rtems_record_event>(event_cpu >> 5);
+    item.bt = last_bt[item.cpu] + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+    item.data = data;
+    last_bt[item.cpu] = item.bt;
+    items->push_back(item);
+  }
+}
+
+bool RecordingReader::ReadIndex() {
+  uint8_t trailer[kTrailerSize];
+  if (Seek(file_, 0, SEEK_END) != 0) {
+    return false;
+  }
+
+  uint64_t size = Tell(file_);
+  if (size < kFileHeaderSize + kTrailerSize ||
+      Seek(file_, size - kTrailerSize, SEEK_SET) != 0 ||
+      ::fread(trailer, 1, sizeof(trailer), file_) != sizeof(trailer) ||
+      Get32(&trailer[12]) != kIndexMagic) {
+    return false;
+  }
+
+  uint64_t index_offset = Get64(&trailer[0]);
+  uint32_t count = Get32(&trailer[8]);
+  if (index_offset + static_cast<uint64_t>(count) * kIndexEntrySize !=
+          size - kTrailerSize ||
+      Seek(file_, index_offset, SEEK_SET) != 0) {
+    return false;
+  }
+
+  chunks_.clear();
+  chunks_.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint8_t entry[kIndexEntrySize];
+    if (::fread(entry, 1, sizeof(entry), file_) != sizeof(entry)) {
+      return false;
+    }
+
+    RecordingChunk chunk;
+    chunk.offset = Get64(&entry[0]);
+    chunk.bt_begin = Get64(&entry[8]);
+    chunk.bt_end = Get64(&entry[16]);
+    chunk.cpu_mask = Get32(&entry[24]);
+    chunk.flags = Get32(&entry[28]);
+    chunk.data_size = Get32(&entry[32]);
+    chunks_.push_back(chunk);
+  }
+
+  return true;
+}
+
+void RecordingReader::ScanChunks() {
+  std::cerr << "warning: recording file '" << name_
+            << "' has no index, scan the chunks" << std::endl;
+
+  chunks_.clear();
+  uint64_t offset = kFileHeaderSize;
+  while (true) {
+    RecordingChunk chunk;
+    uint32_t raw_size;
+    uint32_t stored_size;
+    uint32_t count;
+    if (!ReadChunkHeader(offset, &chunk, &raw_size, &stored_size, &count)) {
+      break;
+    }
+
+    // Ignore a chunk cut short by the end of the capture
+    uint64_t next = offset + kChunkHeaderSize + stored_size;
+    if (Seek(file_, next - 1, SEEK_SET) != 0 || ::fgetc(file_) == EOF) {
+      break;
+    }
+
+    chunks_.push_back(chunk);
+    offset = next;
+  }
+}
+
+bool RecordingReader::ReadChunkHeader(uint64_t offset,
+                                      RecordingChunk* chunk,
+                                      uint32_t* raw_size,
+                                      uint32_t* stored_size,
+                                      uint32_t* count) {
+  uint8_t header[kChunkHeaderSize];
+  if (Seek(file_, offset, SEEK_SET) != 0 ||
+      ::fread(header, 1, sizeof(header), file_) != sizeof(header) ||
+      Get32(&header[0]) != kChunkMagic) {
+    return false;
+  }
+
+  chunk->offset = offset;
+  chunk->flags = Get32(&header[4]);
+  *raw_size = Get32(&header[8]);
+  *stored_size = Get32(&header[12]);
+  *count = Get32(&header[16]);
+  chunk->data_size = Get32(&header[20]);
+  chunk->cpu_mask = Get32(&header[24]);
+  chunk->bt_begin = Get64(&header[32]);
+  chunk->bt_end = Get64(&header[40]);
+  return true;
+}
+
+void RecordingReader::Invalid() const {
+  throw std::runtime_error("invalid recording file '" + name_ + "'");
+}
@@ -0,0 +1,322 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+uint32_t GetAPIIndexOfID(uint32_t id) {
+  return ((id >> 24) & 0x7) - 1;
+}
+
+int MostSignificantBit(uint64_t value) {
+  int bit = 0;
+
+  while (value >>= 1) {
+    ++bit;
+  }
+
+  return bit;
+}
+
+void PrintTime(const char* prefix, uint64_t ns) {
+  std::printf("%s%" PRIu64 ".%09" PRIu64, prefix, ns / 1000000000,
+              ns % 1000000000);
+}
+
+}  // namespace
+
+size_t Histogram::BucketOfValue(uint64_t value) {
+  if (value < kSubBucketCount) {
+    return static_cast<size_t>(value);
+  }
+
+  int msb = MostSignificantBit(value);
+  int shift = msb - kSubBucketBits;
+  size_t sub_bucket =
+      static_cast<size_t>(value >> shift) & (kSubBucketCount - 1);
+  return static_cast<size_t>(shift + 1) * kSubBucketCount + sub_bucket;
+}
+
+uint64_t Histogram::UpperBoundOfBucket(size_t bucket) {
+  if (bucket < kSubBucketCount) {
+    return bucket;
+  }
+
+  int shift = static_cast<int>(bucket / kSubBucketCount) - 1;
+  uint64_t sub_bucket = bucket % kSubBucketCount;
+  uint64_t low = (kSubBucketCount + sub_bucket) << shift;
+  return low + ((uint64_t(1) << shift) - 1);
+}
+
+void Histogram::Add(uint64_t value) {
+  ++buckets_[BucketOfValue(value)];
+  ++count_;
+  sum_ += value;
+
+  if (value < min_) {
+    min_ = value;
+  }
+
+  if (value > max_) {
+    max_ = value;
+  }
+}
+
+void Histogram::Reset() {
+  std::memset(buckets_, 0, sizeof(buckets_));
+  count_ = 0;
+  sum_ = 0;
+  min_ = UINT64_MAX;
+  max_ = 0;
+}
+
+uint64_t Histogram::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+
+  uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count_ + 0.5);
+  if (rank == 0) {
+    rank = 1;
+  }
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      uint64_t bound = UpperBoundOfBucket(i);
+      return bound < max_ ? bound : max_;
+    }
+  }
+
+  return max_;
+}
+
+SummaryClient::SummaryClient() {
+  Initialize(SummaryClient::HandlerCaller);
+}
+
+SummaryClient::ThreadSummary* SummaryClient::GetThread(uint32_t id) {
+  uint32_t api_index = GetAPIIndexOfID(id);
+  if (api_index >= kThreadAPICount) {
+    return nullptr;
+  }
+
+  return &threads_[id];
+}
+
+void SummaryClient::SwitchIn(PerCPUContext* pcpu, uint64_t ns, uint32_t id) {
+  ThreadSummary* thread = GetThread(pcpu->thread_id);
+  if (thread != nullptr && pcpu->thread_begin != 0) {
+    thread->time += ns - pcpu->thread_begin;
+  }
+
+  pcpu->thread_id = id;
+  pcpu->thread_begin = ns;
+
+  thread = GetThread(id);
+  if (thread != nullptr) {
+    ++thread->switches;
+  }
+}
+
+void SummaryClient::InterruptExit(PerCPUContext* pcpu,
+                                  uint64_t ns,
+                                  uint64_t vector) {
+  if (pcpu->interrupt_level == 0) {
+    return;
+  }
+
+  --pcpu->interrupt_level;
+  if (pcpu->interrupt_level >= kInterruptNestLevels) {
+    return;
+  }
+
+  uint64_t latency = ns - pcpu->interrupt_begin[pcpu->interrupt_level];
+  interrupt_latency_.Add(latency);
+
+  VectorSummary* summary =
+      vector < kInterruptVectorCount ? &vectors_[vector] : &other_vectors_;
+  ++summary->count;
+  summary->time += latency;
+  if (latency > summary->max) {
+    summary->max = latency;
+  }
+}
+
+rtems_record_client_status SummaryClient::Handler(uint64_t bt,
+                                                  uint32_t cpu,
+                                                  rtems_record_event event,
+                                                  uint64_t data) {
+  uint64_t ns = rtems_record_client_bintime_to_nanoseconds(bt);
+  PerCPUContext* pcpu = &per_cpu_[cpu];
+
+  ++pcpu->events;
+  ++pcpu->interval_events;
+
+  if (ns != 0) {
+    pcpu->last_ns = ns;
+
+    if (interval_begin_ == 0) {
+      interval_begin_ = ns;
+    }
+
+    if (ns > last_ns_) {
+      last_ns_ = ns;
+    }
+  }
+
+  switch (event) {
+    case RTEMS_RECORD_THREAD_SWITCH_IN:
+      SwitchIn(pcpu, ns, static_cast<uint32_t>(data));
+      break;
+    case RTEMS_RECORD_THREAD_CREATE:
+    case RTEMS_RECORD_THREAD_ID:
+      thread_names_.Reset(cpu, static_cast<uint32_t>(data));
+      break;
+    case RTEMS_RECORD_THREAD_NAME:
+      thread_names_.Add(cpu, data, data_size());
+      break;
+    case RTEMS_RECORD_INTERRUPT_ENTRY:
+      if (pcpu->interrupt_level < kInterruptNestLevels) {
+        pcpu->interrupt_begin[pcpu->interrupt_level] = ns;
+      }
+      ++pcpu->interrupt_level;
+      break;
+    case RTEMS_RECORD_INTERRUPT_EXIT:
+      InterruptExit(pcpu, ns, data);
+      break;
+    case RTEMS_RECORD_PROCESSOR_MAXIMUM:
+      cpu_count_ = static_cast<size_t>(data) + 1;
+      break;
+    default:
+      break;
+  }
+
+  if (interval_ != 0 && interval_begin_ != 0 &&
+      last_ns_ - interval_begin_ >= interval_) {
+    Print(last_ns_, false);
+  }
+
+  return RTEMS_RECORD_CLIENT_SUCCESS;
+}
+
+void SummaryClient::Print(uint64_t ns, bool last) {
+  uint64_t span = ns - interval_begin_;
+  size_t cpu_count = cpu_count_ != 0 ? cpu_count_ : 1;
+
+  PrintTime(last ? "*** summary at end, " : "*** summary at ", ns);
+  std::printf(" s\n");
+
+  for (size_t i = 0; i < cpu_count && i < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT;
+       ++i) {
+    PerCPUContext* pcpu = &per_cpu_[i];
+    uint64_t rate =
+        span != 0 ? pcpu->interval_events * UINT64_C(1000000000) / span : 0;
+    std::printf("cpu %zu: events %" PRIu64 ", interval events %" PRIu64
+                ", rate %" PRIu64 "/s\n",
+                i, pcpu->events, pcpu->interval_events, rate);
+    pcpu->interval_events = 0;
+  }
+
+  // The time of the running threads is counted up to now
+  for (size_t i = 0; i < RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT; ++i) {
+    PerCPUContext* pcpu = &per_cpu_[i];
+    ThreadSummary* thread = GetThread(pcpu->thread_id);
+    if (thread != nullptr && pcpu->thread_begin != 0 &&
+        ns > pcpu->thread_begin) {
+      thread->time += ns - pcpu->thread_begin;
+      pcpu->thread_begin = ns;
+    }
+  }
+
+  for (const auto& entry : threads_) {
+    const ThreadSummary& thread = entry.second;
+    if (thread.switches == 0) {
+      continue;
+    }
+
+    char name[ThreadNames::kNameSize + 1];
+    std::memcpy(name, thread_names_.Get(entry.first), ThreadNames::kNameSize);
+    name[ThreadNames::kNameSize] = '\0';
+
+    for (size_t i = 0; name[i] != '\0'; ++i) {
+      if (!std::isprint(static_cast<unsigned char>(name[i]))) {
+        name[i] = '?';
+      }
+    }
+
+    std::printf("thread 0x%08" PRIx32 " %-16s: switches %" PRIu64, entry.first,
+                name, thread.switches);
+    PrintTime(", time ", thread.time);
+    std::printf(" s\n");
+  }
+
+  const Histogram& h = interrupt_latency_;
+  std::printf("interrupts: count %" PRIu64 ", min %" PRIu64 " ns, mean %" PRIu64
+              " ns, p50 %" PRIu64 " ns, p90 %" PRIu64 " ns, p99 %" PRIu64
+              " ns, p99.9 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+              h.count(), h.min(), h.mean(), h.Percentile(50.0),
+              h.Percentile(90.0), h.Percentile(99.0), h.Percentile(99.9),
+              h.max());
+
+  for (size_t v = 0; v <= kInterruptVectorCount; ++v) {
+    const VectorSummary& vector =
+        v < kInterruptVectorCount ? vectors_[v] : other_vectors_;
+    if (vector.count == 0) {
+      continue;
+    }
+
+    if (v < kInterruptVectorCount) {
+      std::printf("vector %zu", v);
+    } else {
+      std::printf("vector >= %zu", kInterruptVectorCount);
+    }
+
+    std::printf(": count %" PRIu64 ", mean %" PRIu64 " ns, max %" PRIu64
+                " ns\n",
+                vector.count, vector.time / vector.count, vector.max);
+  }
+
+  std::fflush(stdout);
+  interval_begin_ = ns;
+}
+
+void SummaryClient::Destroy() {
+  Client::Destroy();
+  Print(last_ns_, true);
+}
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Copyright (C) 2026 embedded brains GmbH (http://www.embedded-brains.de)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "client.h"
+
+ThreadNames::ThreadNames() : names_(1) {
+  index_of_name_.emplace(names_[0], 0);
+}
+
+void ThreadNames::Reset(uint32_t cpu, uint32_t id) {
+  Pending& pending = pending_[cpu];
+  pending.id = id;
+  pending.size = 0;
+  pending.name.fill(0);
+  name_of_thread_.erase(id);
+}
+
+void ThreadNames::Add(uint32_t cpu, uint64_t data, size_t data_size) {
+  Pending& pending = pending_[cpu];
+  size_t end = pending.size + data_size;
+  if (end > kNameSize) {
+    end = kNameSize;
+  }
+
+  bool changed = false;
+  for (size_t i = pending.size; i < end; ++i) {
+    uint8_t c = static_cast<uint8_t>(data);
+    changed = changed || c != 0;
+    pending.name[i] = c;
+    data >>= 8;
+  }
+
+  pending.size = end;
+
+  if (changed) {
+    Intern(pending);
+  }
+}
+
+void ThreadNames::Intern(const Pending& pending) {
+  auto it = index_of_name_.find(pending.name);
+  uint32_t index;
+  if (it != index_of_name_.end()) {
+    index = it->second;
+  } else {
+    index = static_cast<uint32_t>(names_.size());
+    names_.push_back(pending.name);
+    index_of_name_.emplace(pending.name, index);
+  }
+
+  name_of_thread_[pending.id] = index;
+}
+
+void ThreadNames::Save(Checkpoint* checkpoint) const {
+  checkpoint->Write(pending_);
+  checkpoint->Write(names_.size());
+  checkpoint->Write(names_.data(), names_.size() * sizeof(Name));
+  checkpoint->Write(name_of_thread_.size());
+  for (const auto& thread : name_of_thread_) {
+    checkpoint->Write(thread);
+  }
+}
+
+void ThreadNames::Restore(Checkpoint* checkpoint) {
+  size_t n;
+
+  checkpoint->Read(&pending_);
+  checkpoint->Read(&n);
+  if (n == 0 || n > UINT32_MAX) {
+    throw std::runtime_error("invalid thread names in checkpoint");
+  }
+
+  names_.resize(n);
+  checkpoint->Read(names_.data(), n * sizeof(Name));
+  index_of_name_.clear();
+  for (size_t i = 0; i < n; ++i) {
+    index_of_name_.emplace(names_[i], static_cast<uint32_t>(i));
+  }
+
+  checkpoint->Read(&n);
+  name_of_thread_.clear();
+  for (size_t i = 0; i < n; ++i) {
+    std::pair<uint32_t, uint32_t> thread;
+    checkpoint->Read(&thread);
+    if (thread.second >= names_.size()) {
+      throw std::runtime_error("invalid thread names in checkpoint");
+    }
+
+    name_of_thread_.insert(thread);
+  }
+}
@@ -37,6 +37,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,9 @@ extern "C" {
 
 #define RTEMS_RECORD_CLIENT_MAXIMUM_CPU_COUNT 32
 
+#define RTEMS_RECORD_CLIENT_EVENT_MASK_WORDS \
+  ( ( ( 1U << RTEMS_RECORD_EVENT_BITS ) + 31U ) / 32U )
+
 typedef enum {
   RTEMS_RECORD_CLIENT_SUCCESS,
   RTEMS_RECORD_CLIENT_ERROR_INVALID_MAGIC,
@@ -61,7 +65,8 @@ typedef enum {
   RTEMS_RECORD_CLIENT_ERROR_DOUBLE_PER_CPU_COUNT,
   RTEMS_RECORD_CLIENT_ERROR_NO_CPU_MAX,
   RTEMS_RECORD_CLIENT_ERROR_NO_MEMORY,
-  RTEMS_RECORD_CLIENT_ERROR_PER_CPU_ITEMS_OVERFLOW
+  RTEMS_RECORD_CLIENT_ERROR_PER_CPU_ITEMS_OVERFLOW,
+  RTEMS_RECORD_CLIENT_ERROR_INVALID_STATE
 } rtems_record_client_status;
 
 typedef rtems_record_client_status ( *rtems_record_client_handler )(
@@ -155,6 +160,15 @@ typedef struct rtems_record_client_context {
   );
   rtems_record_client_handler handler;
   void *handler_arg;
+
+  /**
+   * @brief The events passed to the handler.
+   *
+   * Bit ( event % 32 ) of word ( event / 32 ) is set, if the event is passed
+   * to the handler.  The other events are dropped after the uptime and ring
+   * buffer bookkeeping.
+   */
+  uint32_t event_mask[ RTEMS_RECORD_CLIENT_EVENT_MASK_WORDS ];
   size_t data_size;
   uint32_t header[ 2 ];
   rtems_record_client_status status;
@@ -164,7 +178,7 @@ typedef struct rtems_record_client_context {
  * @brief Initializes a record client.
  *
  * The record client consumes a record item stream produces by the record
- * server.
+ * server.  All events are passed to the handler.
  *
  * @param ctx The record client context to initialize.
  * @param handler The handler is invoked for each received record item.
@@ -201,6 +215,56 @@ void rtems_record_client_destroy(
   rtems_record_client_context *ctx
 );
 
+/**
+ * @brief Returns the size of the decoder state of the record client.
+ *
+ * @param ctx The record client context.
+ *
+ * @return The size in bytes of the state saved by
+ *   rtems_record_client_save_state().
+ */
+size_t rtems_record_client_state_size(
+  const rtems_record_client_context *ctx
+);
+
+/**
+ * @brief Saves the decoder state of the record client.
+ *
+ * The state includes the uptime and ring buffer bookkeeping, the hold back
+ * items, and a partially consumed item.  It may be restored by the same
+ * program to continue the decoding of the stream after the consumed data.
+ *
+ * @param ctx The record client context.
+ * @param buf The buffer of rtems_record_client_state_size() bytes for the
+ *   state.
+ */
+void rtems_record_client_save_state(
+  const rtems_record_client_context *ctx,
+  void                              *buf
+);
+
+/**
+ * @brief Restores the decoder state of the record client.
+ *
+ * The record client context must be initialized and must not have consumed
+ * data.  The handler, the handler argument, and the events passed to the
+ * handler are kept.
+ *
+ * @param ctx The record client context.
+ * @param buf The state saved by rtems_record_client_save_state().
+ * @param n The size of the state.
+ *
+ * @retval RTEMS_RECORD_CLIENT_SUCCESS Successful operation.
+ * @retval RTEMS_RECORD_CLIENT_ERROR_INVALID_STATE The state is invalid.
+ * @retval RTEMS_RECORD_CLIENT_ERROR_NO_MEMORY There is not enough memory for
+ *   the hold back items.
+ */
+rtems_record_client_status rtems_record_client_restore_state(
+  rtems_record_client_context *ctx,
+  const void                  *buf,
+  size_t                       n
+);
+
 static inline void rtems_record_client_set_handler(
   rtems_record_client_context *ctx,
   rtems_record_client_handler  handler
@@ -209,6 +273,58 @@ static inline void rtems_record_client_set_handler(
   ctx->handler = handler;
 }
 
+/**
+ * @brief Passes the event to the handler.
+ *
+ * @param ctx The record client context.
+ * @param event The event to enable.
+ */
+static inline void rtems_record_client_enable_event(
+  rtems_record_client_context *ctx,
+  rtems_record_event           event
+)
+{
+  ctx->event_mask[ event / 32U ] |= UINT32_C( 1 ) << ( event % 32U );
+}
+
+/**
+ * @brief Drops the event before the handler.
+ *
+ * The uptime and ring buffer bookkeeping is not affected.
+ *
+ * @param ctx The record client context.
+ * @param event The event to disable.
+ */
+static inline void rtems_record_client_disable_event(
+  rtems_record_client_context *ctx,
+  rtems_record_event           event
+)
+{
+  ctx->event_mask[ event / 32U ] &= ~( UINT32_C( 1 ) << ( event % 32U ) );
+}
+
+/**
+ * @brief Passes all events to the handler or drops all events.
+ *
+ * @param ctx The record client context.
+ * @param enable If true, then enable all events, otherwise disable all events.
+ */
+static inline void rtems_record_client_set_all_events(
+  rtems_record_client_context *ctx,
+  bool                         enable
+)
+{
+  memset( ctx->event_mask, enable ? 0xff : 0, sizeof( ctx->event_mask ) );
+}
+
+static inline bool rtems_record_client_is_event_enabled(
+  const rtems_record_client_context *ctx,
+  rtems_record_event                 event
+)
+{
+  return ( ctx->event_mask[ event / 32U ] >> ( event % 32U ) & 1U ) != 0;
+}
+
 static inline uint64_t rtems_record_client_bintime_to_nanoseconds(
   uint64_t bt
 )
@@ -0,0 +1,379 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Decode a memory dump of the __rtld_trg object written by the trace linker's
+ * trace ring generator, see linkers/rtld-trace-ring.ini for the format.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <getopt.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define RTLD_TRG_MAGIC 0x52544752
+#define RTLD_TRG_VERSION 1
+#define RTLD_TRG_HEADER_WORDS 4
+#define RTLD_TRG_REC_OVERHEAD 2
+#define RTLD_TRG_ENTRY 1
+#define RTLD_TRG_EXIT 2
+#define RTLD_TRG_PAD 3
+
+class RingDump {
+ public:
+  void LoadNames(const char* file);
+
+  void Load(const char* file);
+
+  void Decode(uint32_t only_cpu, bool deltas) const;
+
+ private:
+  struct Record {
+    uint32_t index;
+    uint32_t kind;
+    uint32_t words;
+  };
+
+  std::vector<std::string> names_;
+  std::vector<uint8_t> data_;
+  bool swap_ = false;
+  uint32_t cpus_ = 0;
+  uint32_t words_ = 0;
+
+  uint32_t Word(size_t offset) const;
+
+  const uint8_t* Ring(uint32_t cpu) const {
+    return &data_[(RTLD_TRG_HEADER_WORDS + cpu * (words_ + 1)) *
+                  sizeof(uint32_t)];
+  }
+
+  uint32_t In(uint32_t cpu) const {
+    return Word((Ring(cpu) - &data_[0]) / sizeof(uint32_t));
+  }
+
+  uint32_t RingWord(uint32_t cpu, uint32_t word) const {
+    return Word((Ring(cpu) - &data_[0]) / sizeof(uint32_t) + 1 + word);
+  }
+
+  bool ValidRecord(uint32_t header, uint32_t pos, Record& rec) const;
+
+  bool Chain(uint32_t cpu, uint32_t begin, uint32_t end) const;
+
+  void DecodeRange(uint32_t cpu,
+                   uint32_t begin,
+                   uint32_t end,
+                   bool deltas,
+                   uint64_t& last) const;
+};
+
+void RingDump::LoadNames(const char* file) {
+  std::ifstream in(file);
+  if (!in.is_open()) {
+    throw std::runtime_error("cannot open names file '" + std::string(file) +
+                             "'");
+  }
+
+  // The trace linker writes the names in a wrapper as a commented index
+  // and a quoted name. A file of a name per line is also accepted.
+  std::regex wrapper("^\\s*/\\*\\s*([0-9]+)\\s*\\*/\\s*\"([^\"]*)\",?\\s*$");
+  std::string line;
+  std::vector<std::string> plain;
+  bool is_wrapper = false;
+
+  while (std::getline(in, line)) {
+    std::smatch m;
+    if (std::regex_match(line, m, wrapper)) {
+      size_t index = std::stoul(m[1]);
+      if (index >= names_.size()) {
+        names_.resize(index + 1);
+      }
+      names_[index] = m[2];
+      is_wrapper = true;
+    } else if (!line.empty()) {
+      plain.push_back(line);
+    }
+  }
+
+  if (!is_wrapper) {
+    names_ = plain;
+  }
+}
+
+void RingDump::Load(const char* file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("cannot open dump file '" + std::string(file) +
+                             "'");
+  }
+
+  data_.assign(std::istreambuf_iterator<char>(in),
+               std::istreambuf_iterator<char>());
+
+  if (data_.size() < RTLD_TRG_HEADER_WORDS * sizeof(uint32_t)) {
+    throw std::runtime_error("dump file too short");
+  }
+
+  uint32_t magic;
+  std::memcpy(&magic, &data_[0], sizeof(magic));
+  if (magic != RTLD_TRG_MAGIC) {
+    swap_ = true;
+    if (Word(0) != RTLD_TRG_MAGIC) {
+      throw std::runtime_error("invalid trace ring magic");
+    }
+  }
+
+  if (Word(1) != RTLD_TRG_VERSION) {
+    throw std::runtime_error("unsupported trace ring version");
+  }
+
+  cpus_ = Word(2);
+  words_ = Word(3);
+
+  if (words_ == 0 || (words_ & (words_ - 1)) != 0) {
+    throw std::runtime_error("invalid trace ring size");
+  }
+
+  uint64_t size = (RTLD_TRG_HEADER_WORDS +
+                   static_cast<uint64_t>(cpus_) * (words_ + 1)) *
+                  sizeof(uint32_t);
+  if (data_.size() < size) {
+    throw std::runtime_error("dump file does not contain all rings");
+  }
+}
+
+uint32_t RingDump::Word(size_t offset) const {
+  uint32_t value;
+  std::memcpy(&value, &data_[offset * sizeof(value)], sizeof(value));
+  if (swap_) {
+    value = ((value >> 24) & 0xff) | ((value >> 8) & 0xff00) |
+            ((value << 8) & 0xff0000) | ((value << 24) & 0xff000000);
+  }
+  return value;
+}
+
+bool RingDump::ValidRecord(uint32_t header, uint32_t pos, Record& rec) const {
+  rec.index = header & 0xffff;
+  rec.words = (header >> 16) & 0xfff;
+  rec.kind = header >> 28;
+
+  if (rec.words == 0 || pos + rec.words > words_) {
+    return false;
+  }
+
+  switch (rec.kind) {
+    case RTLD_TRG_ENTRY:
+    case RTLD_TRG_EXIT:
+      if (rec.words < RTLD_TRG_REC_OVERHEAD) {
+        return false;
+      }
+      return names_.empty() || rec.index < names_.size();
+    case RTLD_TRG_PAD:
+      return rec.index == 0 && pos + rec.words == words_;
+    default:
+      return false;
+  }
+}
+
+bool RingDump::Chain(uint32_t cpu, uint32_t begin, uint32_t end) const {
+  Record rec;
+  while (begin < end) {
+    if (!ValidRecord(RingWord(cpu, begin), begin, rec)) {
+      return false;
+    }
+    begin += rec.words;
+  }
+  return begin == end;
+}
+
+void RingDump::DecodeRange(uint32_t cpu,
+                           uint32_t begin,
+                           uint32_t end,
+                           bool deltas,
+                           uint64_t& last) const {
+  Record rec;
+  while (begin < end) {
+    if (!ValidRecord(RingWord(cpu, begin), begin, rec)) {
+      std::cerr << "cpu " << cpu << ": invalid record at word " << begin
+                << std::endl;
+      return;
+    }
+
+    if (rec.kind != RTLD_TRG_PAD) {
+      uint32_t timestamp = RingWord(cpu, begin + 1);
+      char buf[64];
+
+      uint32_t value = timestamp;
+      if (deltas) {
+        value = last == UINT64_MAX ? 0 : timestamp - static_cast<uint32_t>(last);
+      }
+      last = timestamp;
+
+      std::snprintf(buf, sizeof(buf), "%" PRIu32 ":%10" PRIu32, cpu, value);
+
+      std::cout << buf << (rec.kind == RTLD_TRG_ENTRY ? " > " : " < ");
+      if (rec.index < names_.size()) {
+        std::cout << names_[rec.index];
+      } else {
+        std::cout << '#' << rec.index;
+      }
+
+      const uint8_t* data =
+          Ring(cpu) + (begin + 1 + RTLD_TRG_REC_OVERHEAD) * sizeof(uint32_t);
+      size_t size = (rec.words - RTLD_TRG_REC_OVERHEAD) * sizeof(uint32_t);
+      if (size != 0) {
+        std::cout << ' ';
+        for (size_t i = 0; i < size; ++i) {
+          std::snprintf(buf, sizeof(buf), "%02x", data[i]);
+          std::cout << buf;
+        }
+      }
+      std::cout << std::endl;
+    }
+
+    begin += rec.words;
+  }
+}
+
+void RingDump::Decode(uint32_t only_cpu, bool deltas) const {
+  for (uint32_t cpu = 0; cpu < cpus_; ++cpu) {
+    if (only_cpu != UINT32_MAX && cpu != only_cpu) {
+      continue;
+    }
+
+    uint32_t in = In(cpu);
+    uint64_t last = UINT64_MAX;
+
+    if (in <= words_) {
+      DecodeRange(cpu, 0, in, deltas, last);
+      continue;
+    }
+
+    /*
+     * The ring has wrapped. The current lap starts at word 0 and ends at the
+     * in position. The tail of the previous lap is from the first position
+     * after the in position with a chain of valid records that ends at the
+     * end of the ring.
+     */
+    uint32_t pos = in & (words_ - 1);
+    if (pos != 0) {
+      for (uint32_t begin = pos; begin < words_; ++begin) {
+        if (Chain(cpu, begin, words_)) {
+          DecodeRange(cpu, begin, words_, deltas, last);
+          break;
+        }
+      }
+      DecodeRange(cpu, 0, pos, deltas, last);
+    } else {
+      DecodeRange(cpu, 0, words_, deltas, last);
+    }
+  }
+}
+
+static const struct option kLongOpts[] = {{"help", 0, NULL, 'h'},
+                                          {"names", 1, NULL, 'n'},
+                                          {"cpu", 1, NULL, 'c'},
+                                          {"deltas", 0, NULL, 'd'},
+                                          {NULL, 0, NULL, 0}};
+
+static void Usage(char** argv) {
+  std::cout << argv[0] << " [OPTION]... DUMP-FILE" << std::endl
+            << std::endl
+            << "Mandatory arguments to long options are mandatory for short "
+               "options too."
+            << std::endl
+            << "  -h, --help                 print this help text" << std::endl
+            << "  -n, --names=FILE           the kept wrapper C file or a "
+               "file of a name per line"
+            << std::endl
+            << "  -c, --cpu=CPU              only decode the ring of this "
+               "processor"
+            << std::endl
+            << "  -d, --deltas               print the timestamp deltas"
+            << std::endl
+            << "  DUMP-FILE                  a memory dump of __rtld_trg"
+            << std::endl;
+}
+
+int main(int argc, char** argv) {
+  const char* names_file = nullptr;
+  uint32_t only_cpu = UINT32_MAX;
+  bool deltas = false;
+  int opt;
+  int longindex;
+
+  while ((opt = getopt_long(argc, argv, "hn:c:d", &kLongOpts[0],
+                            &longindex)) != -1) {
+    switch (opt) {
+      case 'h':
+        Usage(argv);
+        return 0;
+      case 'n':
+        names_file = optarg;
+        break;
+      case 'c':
+        only_cpu = static_cast<uint32_t>(strtoul(optarg, NULL, 0));
+        break;
+      case 'd':
+        deltas = true;
+        break;
+      default:
+        return 1;
+    }
+  }
+
+  if (optind != argc - 1) {
+    std::cerr << argv[0] << ": no dump file" << std::endl;
+    return 1;
+  }
+
+  try {
+    RingDump dump;
+
+    if (names_file != nullptr) {
+      dump.LoadNames(names_file);
+    }
+
+    dump.Load(argv[optind]);
+    dump.Decode(only_cpu, deltas);
+  } catch (std::exception& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}